@@ -65,3 +65,38 @@ project (_AMD_SAMPLE_NAME)
       flags { "LinkTimeOptimization", "Symbols", "FatalWarnings", "Unicode", "WinMain" }
       targetsuffix ("_Release" .. _AMD_VS_SUFFIX)
       optimize "On"
+
+-- The headless tools and benchmarks, a console app apart from the sample, built from
+-- the sample's modules without its window and device code
+project (_AMD_SAMPLE_NAME .. "Tools")
+   kind "ConsoleApp"
+   language "C++"
+   location "../build"
+   filename (_AMD_SAMPLE_NAME .. "Tools" .. _AMD_VS_SUFFIX)
+   targetdir "../bin"
+   objdir "../build/%{_AMD_SAMPLE_DIR_LAYOUT}/Tools"
+   warnings "Extra"
+   floatingpoint "Fast"
+
+   -- Specify WindowsTargetPlatformVersion here for VS2015
+   windowstarget (_AMD_WIN_SDK_VERSION)
+
+   -- Copy DLLs to the local bin directory
+   postbuildcommands { amdSamplePostbuildCommands() }
+   postbuildmessage "Copying dependencies..."
+
+   files { "../src/**.h", "../src/**.cpp", "../tools/**.h", "../tools/**.cpp" }
+   removefiles { "../src/SilhouetteTessellation11.cpp" }
+   includedirs { "../src" }
+   links { "AMD_SDK_Minimal", "DXUT", "DXUTOpt", "d3dcompiler", "dxguid", "winmm", "comctl32", "Usp10", "Shlwapi" }
+
+   filter "configurations:Debug"
+      defines { "WIN32", "_DEBUG", "DEBUG", "PROFILE", "_CONSOLE", "_WIN32_WINNT=0x0601" }
+      flags { "Symbols", "FatalWarnings", "Unicode" }
+      targetsuffix ("_Debug" .. _AMD_VS_SUFFIX)
+
+   filter "configurations:Release"
+      defines { "WIN32", "NDEBUG", "PROFILE", "_CONSOLE", "_WIN32_WINNT=0x0601" }
+      flags { "LinkTimeOptimization", "Symbols", "FatalWarnings", "Unicode" }
+      targetsuffix ("_Release" .. _AMD_VS_SUFFIX)
+      optimize "On"
@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+//--------------------------------------------------------------------------------------
+// File: CPUTessellation.cpp
+//
+// CPU reference of the whole tessellation of a patch.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "CPUTessellation.h"
+#include "DomainEvaluator.h"
+
+using namespace DirectX;
+
+//--------------------------------------------------------------------------------------
+// Evaluates the vertex of every domain point of the tessellation
+//--------------------------------------------------------------------------------------
+void EvaluatePatchVertices( CPU_TESS_TECHNIQUE Technique, const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints,
+                            const TRI_TESSELLATION* pTessellation, PN_VERTEX* pVertices )
+{
+    assert( NULL != pCorners );
+    assert( NULL != pTessellation );
+    assert( NULL != pVertices );
+
+    UINT uNumPoints = (UINT)pTessellation->DomainPoints.size();
+    if( 0 == uNumPoints )
+    {
+        return;
+    }
+
+    if( CPU_TESS_PN_TRIANGLES == Technique )
+    {
+        assert( NULL != pControlPoints );
+
+        // The evaluator writes packed arrays, spread them into the vertices afterwards
+        XMFLOAT3 f3Positions[256], f3Normals[256];
+        if( uNumPoints <= ARRAYSIZE( f3Positions ) )
+        {
+            EvaluatePNTessellationForwardDifference( pCorners, pControlPoints, pTessellation, f3Positions, f3Normals );
+            for( UINT i = 0; i < uNumPoints; i++ )
+            {
+                pVertices[i].f3Position = f3Positions[i];
+                pVertices[i].f3Normal = f3Normals[i];
+            }
+        }
+        else
+        {
+            std::vector<XMFLOAT3> Positions( uNumPoints ), Normals( uNumPoints );
+            EvaluatePNTessellationForwardDifference( pCorners, pControlPoints, pTessellation, &Positions[0], &Normals[0] );
+            for( UINT i = 0; i < uNumPoints; i++ )
+            {
+                pVertices[i].f3Position = Positions[i];
+                pVertices[i].f3Normal = Normals[i];
+            }
+        }
+    }
+    else
+    {
+        for( UINT i = 0; i < uNumPoints; i++ )
+        {
+            const XMFLOAT3& f3Point = pTessellation->DomainPoints[i];
+            EvaluatePhongTriangle( pCorners, f3Point.x, f3Point.y, f3Point.z, &pVertices[i].f3Position, &pVertices[i].f3Normal );
+        }
+    }
+
+    // Linearly interpolate the texture coords
+    XMVECTOR vTexCoord0 = XMLoadFloat2( &pCorners[0].f2TexCoord );
+    XMVECTOR vTexCoord1 = XMLoadFloat2( &pCorners[1].f2TexCoord );
+    XMVECTOR vTexCoord2 = XMLoadFloat2( &pCorners[2].f2TexCoord );
+    for( UINT i = 0; i < uNumPoints; i++ )
+    {
+        const XMFLOAT3& f3Point = pTessellation->DomainPoints[i];
+        XMVECTOR vTexCoord = XMVectorScale( vTexCoord0, f3Point.z );
+        vTexCoord = XMVectorMultiplyAdd( vTexCoord1, XMVectorReplicate( f3Point.x ), vTexCoord );
+        vTexCoord = XMVectorMultiplyAdd( vTexCoord2, XMVectorReplicate( f3Point.y ), vTexCoord );
+        XMStoreFloat2( &pVertices[i].f2TexCoord, vTexCoord );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,52 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+//--------------------------------------------------------------------------------------
+// File: CPUTessellation.h
+//
+// CPU reference of the whole tessellation of a patch: the domain points of the tri
+// tessellator evaluated by the PN-Triangles or Phong domain shader.
+//--------------------------------------------------------------------------------------
+#ifndef CPU_TESSELLATION_H
+#define CPU_TESSELLATION_H
+
+#include "PNTriangles.h"
+#include "TriTessellator.h"
+
+// Techniques of DS_PNTriangles
+enum CPU_TESS_TECHNIQUE
+{
+    CPU_TESS_PN_TRIANGLES,
+    CPU_TESS_PHONG,
+};
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates the vertex of every domain point of the tessellation, as DS_PNTriangles does:
+// position, normalized normal and linearly interpolated texture coords. pControlPoints is
+// only used by CPU_TESS_PN_TRIANGLES and may be NULL for CPU_TESS_PHONG.
+//--------------------------------------------------------------------------------------
+void EvaluatePatchVertices( CPU_TESS_TECHNIQUE Technique, const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints,
+                            const TRI_TESSELLATION* pTessellation, PN_VERTEX* pVertices );
+
+#endif
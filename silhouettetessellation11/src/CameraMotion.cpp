@@ -0,0 +1,206 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: CameraMotion.cpp
+//
+// Camera motion for the motion adaptive tess factors, and recorded camera paths.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "CameraMotion.h"
+
+using namespace DirectX;
+
+
+//--------------------------------------------------------------------------------------
+// Sum of the squares of the elements, to compare motions
+//--------------------------------------------------------------------------------------
+static float GetMatrixLengthSq( CXMMATRIX mMatrix )
+{
+    float fLengthSq = 0.0f;
+    for( UINT i = 0; i < 4; i++ )
+    {
+        fLengthSq += XMVectorGetX( XMVector4LengthSq( mMatrix.r[i] ) );
+    }
+
+    return fLengthSq;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Loads a camera path, one frame per line
+//--------------------------------------------------------------------------------------
+HRESULT LoadCameraPath( const WCHAR* pszFileName, std::vector<CAMERA_PATH_FRAME>* pPath )
+{
+    assert( NULL != pszFileName );
+    assert( NULL != pPath );
+
+    pPath->clear();
+
+    FILE* pInput = NULL;
+    if( 0 != _wfopen_s( &pInput, pszFileName, L"r" ) || NULL == pInput )
+    {
+        return E_FAIL;
+    }
+
+    char szLine[256];
+    while( NULL != fgets( szLine, sizeof( szLine ), pInput ) )
+    {
+        CAMERA_PATH_FRAME Frame;
+        if( 7 == sscanf_s( szLine, "%f %f %f %f %f %f %f", &Frame.fSeconds, &Frame.f3Eye.x, &Frame.f3Eye.y, &Frame.f3Eye.z,
+                           &Frame.f3LookAt.x, &Frame.f3LookAt.y, &Frame.f3LookAt.z ) )
+        {
+            pPath->push_back( Frame );
+        }
+    }
+    fclose( pInput );
+
+    return pPath->empty() ? E_FAIL : S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Saves a camera path, one frame per line
+//--------------------------------------------------------------------------------------
+HRESULT SaveCameraPath( const WCHAR* pszFileName, const std::vector<CAMERA_PATH_FRAME>& Path )
+{
+    assert( NULL != pszFileName );
+
+    FILE* pOutput = NULL;
+    if( 0 != _wfopen_s( &pOutput, pszFileName, L"w" ) || NULL == pOutput )
+    {
+        return E_FAIL;
+    }
+
+    for( UINT i = 0; i < (UINT)Path.size(); i++ )
+    {
+        const CAMERA_PATH_FRAME& Frame = Path[i];
+        fprintf( pOutput, "%g %g %g %g %g %g %g\n", Frame.fSeconds, Frame.f3Eye.x, Frame.f3Eye.y, Frame.f3Eye.z,
+                 Frame.f3LookAt.x, Frame.f3LookAt.y, Frame.f3LookAt.z );
+    }
+    fclose( pOutput );
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CCameraMotion::CCameraMotion()
+{
+    Reset();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CCameraMotion::~CCameraMotion()
+{
+}
+
+
+//--------------------------------------------------------------------------------------
+// Forgets the motion
+//--------------------------------------------------------------------------------------
+void CCameraMotion::Reset()
+{
+    XMStoreFloat4x4( &m_f4x4ViewProjection, XMMatrixIdentity() );
+    ZeroMemory( &m_f4x4Motion, sizeof( m_f4x4Motion ) );
+    m_bHaveViewProjection = false;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Adds the view * projection of a frame. The motion of the frame replaces the released
+// one if it is larger, so speeding up is followed at once and slowing down smoothly.
+//--------------------------------------------------------------------------------------
+void CCameraMotion::Update( CXMMATRIX mViewProjection, float fElapsedSeconds )
+{
+    if( !m_bHaveViewProjection || fElapsedSeconds <= 0.0f )
+    {
+        XMStoreFloat4x4( &m_f4x4ViewProjection, mViewProjection );
+        ZeroMemory( &m_f4x4Motion, sizeof( m_f4x4Motion ) );
+        m_bHaveViewProjection = true;
+        return;
+    }
+
+    XMMATRIX mLast = XMLoadFloat4x4( &m_f4x4ViewProjection );
+    XMMATRIX mReleased = XMLoadFloat4x4( &m_f4x4Motion );
+    float fFrameScale = TESS_MOTION_REFERENCE_SECONDS / fElapsedSeconds;
+    float fRelease = expf( -fElapsedSeconds / TESS_MOTION_RELEASE_SECONDS );
+
+    XMMATRIX mFrame;
+    for( UINT i = 0; i < 4; i++ )
+    {
+        mFrame.r[i] = XMVectorScale( XMVectorSubtract( mLast.r[i], mViewProjection.r[i] ), fFrameScale );
+        mReleased.r[i] = XMVectorScale( mReleased.r[i], fRelease );
+    }
+
+    XMStoreFloat4x4( &m_f4x4Motion, ( GetMatrixLengthSq( mFrame ) >= GetMatrixLengthSq( mReleased ) ) ? mFrame : mReleased );
+    XMStoreFloat4x4( &m_f4x4ViewProjection, mViewProjection );
+}
+
+
+//--------------------------------------------------------------------------------------
+// The current view * projection plus the released motion
+//--------------------------------------------------------------------------------------
+XMMATRIX CCameraMotion::GetPreviousViewProjection() const
+{
+    XMMATRIX mCurrent = XMLoadFloat4x4( &m_f4x4ViewProjection );
+    XMMATRIX mMotion = XMLoadFloat4x4( &m_f4x4Motion );
+
+    XMMATRIX mPrevious;
+    for( UINT i = 0; i < 4; i++ )
+    {
+        mPrevious.r[i] = XMVectorAdd( mCurrent.r[i], mMotion.r[i] );
+    }
+
+    return mPrevious;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Screen distance in pixels a world space point moved
+//--------------------------------------------------------------------------------------
+float CCameraMotion::GetScreenVelocity( FXMVECTOR vPosition, float fScreenWidth, float fScreenHeight ) const
+{
+    XMVECTOR vPoint = XMVectorSetW( vPosition, 1.0f );
+    XMFLOAT4 f4Current, f4Previous;
+    XMStoreFloat4( &f4Current, XMVector4Transform( vPoint, XMLoadFloat4x4( &m_f4x4ViewProjection ) ) );
+    XMStoreFloat4( &f4Previous, XMVector4Transform( vPoint, GetPreviousViewProjection() ) );
+    if( f4Current.w <= 0.0f || f4Previous.w <= 0.0f )
+    {
+        return 0.0f;
+    }
+
+    float fDeltaX = ( f4Current.x / f4Current.w - f4Previous.x / f4Previous.w ) * 0.5f * fScreenWidth;
+    float fDeltaY = ( f4Current.y / f4Current.w - f4Previous.y / f4Previous.w ) * 0.5f * fScreenHeight;
+
+    return sqrtf( fDeltaX * fDeltaX + fDeltaY * fDeltaY );
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: CameraMotion.h
+//
+// Camera motion for the motion adaptive tess factors (MOTION_ADAPT). The hull shader
+// projects each edge midpoint with the current and a previous view * projection, and
+// scales the factors down with the screen distance between the two, as fast moving
+// silhouettes are blurred by the eye anyway.
+//
+// The previous matrix follows the camera with a release: it is the last frame's as soon
+// as the camera moves faster than before, and slides to the current one over about
+// TESS_MOTION_RELEASE_SECONDS when it slows down or stops, so the factors come back
+// smoothly rather than popping. The motion is normalized to TESS_MOTION_REFERENCE_SECONDS
+// so the thresholds don't depend on the frame rate.
+//
+// Camera paths are recorded by the sample (R) to text files with a frame per line, for
+// measuring the savings offline:
+//
+//      seconds eye.x eye.y eye.z lookat.x lookat.y lookat.z
+//--------------------------------------------------------------------------------------
+#ifndef CAMERA_MOTION_H
+#define CAMERA_MOTION_H
+
+#include <vector>
+
+// Frame time the motion thresholds are given for (pixels per 60Hz frame)
+static const float TESS_MOTION_REFERENCE_SECONDS    = 1.0f / 60.0f;
+
+// Time constant of the release of the motion when the camera slows down
+static const float TESS_MOTION_RELEASE_SECONDS      = 0.25f;
+
+// A frame of a recorded camera path
+struct CAMERA_PATH_FRAME
+{
+    float               fSeconds;   // From the start of the recording
+    DirectX::XMFLOAT3   f3Eye;
+    DirectX::XMFLOAT3   f3LookAt;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Loads and saves camera paths
+//--------------------------------------------------------------------------------------
+HRESULT LoadCameraPath( const WCHAR* pszFileName, std::vector<CAMERA_PATH_FRAME>* pPath );
+HRESULT SaveCameraPath( const WCHAR* pszFileName, const std::vector<CAMERA_PATH_FRAME>& Path );
+
+
+//--------------------------------------------------------------------------------------
+// Tracks the view * projection the motion is measured against
+//--------------------------------------------------------------------------------------
+class CCameraMotion
+{
+public:
+
+    CCameraMotion();
+    ~CCameraMotion();
+
+    // Forgets the motion, e.g. after a jump of the camera
+    void Reset();
+
+    // Adds the view * projection of a frame rendered fElapsedSeconds after the last
+    void Update( DirectX::CXMMATRIX mViewProjection, float fElapsedSeconds );
+
+    // The current view * projection plus the released motion
+    DirectX::XMMATRIX GetPreviousViewProjection() const;
+
+    // Screen distance in pixels a world space point moved, 0 if behind the eye
+    float GetScreenVelocity( DirectX::FXMVECTOR vPosition, float fScreenWidth, float fScreenHeight ) const;
+
+private:
+
+    DirectX::XMFLOAT4X4     m_f4x4ViewProjection;   // Of the last frame
+    DirectX::XMFLOAT4X4     m_f4x4Motion;           // Previous - current, per reference frame
+    bool                    m_bHaveViewProjection;
+};
+
+#endif
@@ -0,0 +1,670 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ClusterDAG.cpp
+//
+// Cluster level of detail DAG
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "ClusterDAG.h"
+#include "MeshSimplify.h"
+#include "PatchOrder.h"
+#include <algorithm>
+#include <float.h>
+
+using namespace DirectX;
+
+// Sidecar header
+static const UINT CLUSTER_FILE_MAGIC = 0x444f4c43;  // "CLOD"
+static const UINT CLUSTER_FILE_VERSION = 1;
+
+struct CLUSTER_FILE_HEADER
+{
+    UINT    uMagic;
+    UINT    uVersion;
+    UINT    uNumVertices;
+    UINT    uNumIndices;
+    UINT    uNumClusters;
+    UINT    uNumLevels;
+    UINT    uNumInputTriangles;
+};
+
+// Maps positions in the bounds of the mesh to Morton keys
+struct CLUSTER_QUANTIZE
+{
+    XMFLOAT3    f3Min;
+    float       fScale;
+};
+
+// The clusters of a group, in the member list of the level
+struct CLUSTER_GROUP
+{
+    UINT    uFirstMember;
+    UINT    uNumMembers;
+};
+
+// A group after simplification: its triangles in Morton order, if it simplified enough
+struct CLUSTER_GROUP_RESULT
+{
+    std::vector<UINT>   Indices;
+    float               fError;
+    bool                bSimplified;
+};
+
+struct CLUSTER_BUILD_CONTEXT
+{
+    const std::vector<PN_VERTEX>*       pVertices;
+    const std::vector<XMFLOAT3>*        pPositions;
+    const std::vector<UINT>*            pIndices;
+    const std::vector<CLUSTER>*         pClusters;
+    const std::vector<UINT>*            pMembers;
+    const std::vector<CLUSTER_GROUP>*   pGroups;
+    std::vector<CLUSTER_GROUP_RESULT>*  pResults;
+    CLUSTER_QUANTIZE                    Quantize;
+};
+
+struct CLUSTER_SELECT_CONTEXT
+{
+    CClusterDAG*    pDAG;
+    const PM_VIEW*  pView;
+    bool            bCull;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Returns the Morton key of a point
+//--------------------------------------------------------------------------------------
+static UINT64 GetMortonKey( FXMVECTOR vPoint, const CLUSTER_QUANTIZE* pQuantize )
+{
+    XMFLOAT3 f3Cell;
+    XMStoreFloat3( &f3Cell, XMVectorScale( XMVectorSubtract( vPoint, XMLoadFloat3( &pQuantize->f3Min ) ), pQuantize->fScale ) );
+    const float fMaxCell = (float)( ( 1 << PATCH_ORDER_BITS ) - 1 );
+    UINT uCoords[3] =
+    {
+        (UINT)std::max( std::min( f3Cell.x, fMaxCell ), 0.0f ),
+        (UINT)std::max( std::min( f3Cell.y, fMaxCell ), 0.0f ),
+        (UINT)std::max( std::min( f3Cell.z, fMaxCell ), 0.0f ),
+    };
+    return GetCurveKey( PATCH_ORDER_MORTON, uCoords, 3 );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Sorts triangles along the Morton curve of their centroids
+//--------------------------------------------------------------------------------------
+static void SortTriangles( const PN_VERTEX* pVertices, const CLUSTER_QUANTIZE* pQuantize, std::vector<UINT>* pIndices )
+{
+    UINT uNumTriangles = (UINT)pIndices->size() / 3;
+    std::vector< std::pair<UINT64, UINT> > Keys( uNumTriangles );
+    for( UINT t = 0; t < uNumTriangles; t++ )
+    {
+        const UINT* pTri = &( *pIndices )[t * 3];
+        XMVECTOR vCentroid = XMVectorScale( XMVectorAdd( XMVectorAdd( XMLoadFloat3( &pVertices[pTri[0]].f3Position ),
+                                                                      XMLoadFloat3( &pVertices[pTri[1]].f3Position ) ),
+                                                         XMLoadFloat3( &pVertices[pTri[2]].f3Position ) ), 1.0f / 3.0f );
+        Keys[t] = std::make_pair( GetMortonKey( vCentroid, pQuantize ), t );
+    }
+    std::sort( Keys.begin(), Keys.end() );
+
+    std::vector<UINT> Sorted( pIndices->size() );
+    for( UINT t = 0; t < uNumTriangles; t++ )
+    {
+        memcpy( &Sorted[t * 3], &( *pIndices )[Keys[t].second * 3], 3 * sizeof( UINT ) );
+    }
+    pIndices->swap( Sorted );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns a sphere around triangles: the center of their box, out to the farthest corner
+//--------------------------------------------------------------------------------------
+static XMFLOAT4 GetTrianglesSphere( const PN_VERTEX* pVertices, const UINT* pIndices, UINT uNumIndices )
+{
+    XMVECTOR vMin = XMVectorReplicate( FLT_MAX );
+    XMVECTOR vMax = XMVectorReplicate( -FLT_MAX );
+    for( UINT i = 0; i < uNumIndices; i++ )
+    {
+        XMVECTOR vPosition = XMLoadFloat3( &pVertices[pIndices[i]].f3Position );
+        vMin = XMVectorMin( vMin, vPosition );
+        vMax = XMVectorMax( vMax, vPosition );
+    }
+    XMVECTOR vCenter = XMVectorScale( XMVectorAdd( vMin, vMax ), 0.5f );
+    float fRadiusSq = 0.0f;
+    for( UINT i = 0; i < uNumIndices; i++ )
+    {
+        fRadiusSq = std::max( fRadiusSq, XMVectorGetX( XMVector3LengthSq( XMVectorSubtract( XMLoadFloat3( &pVertices[pIndices[i]].f3Position ), vCenter ) ) ) );
+    }
+    XMFLOAT4 f4Sphere;
+    XMStoreFloat4( &f4Sphere, XMVectorSetW( vCenter, sqrtf( fRadiusSq ) ) );
+    return f4Sphere;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns true if an error bounded by a sphere is under the threshold on screen. The
+// sphere's nearest point to the eye is taken, so a sphere holding another never passes
+// where the other fails.
+//--------------------------------------------------------------------------------------
+static bool IsFineEnough( float fError, const XMFLOAT4& f4Sphere, const PM_VIEW* pView )
+{
+    if( 0.0f == fError )
+    {
+        return true;
+    }
+    if( FLT_MAX == fError )
+    {
+        return false;
+    }
+    float fDistance = XMVectorGetX( XMVector3Length( XMVectorSubtract( XMLoadFloat4( &f4Sphere ), XMLoadFloat3( &pView->f3Eye ) ) ) ) - f4Sphere.w;
+    return fDistance > 0.0f && fError * pView->fPixelsPerUnit <= pView->fPixelError * fDistance;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Replaces the extension of an sdkmesh file name by CLUSTER_DAG_FILE_EXTENSION
+//--------------------------------------------------------------------------------------
+void GetClusterDAGFileName( const WCHAR* pszMeshFileName, WCHAR* pszFileName, UINT uMaxChars )
+{
+    wcscpy_s( pszFileName, uMaxChars, pszMeshFileName );
+    WCHAR* pszExtension = wcsrchr( pszFileName, L'.' );
+    if( NULL != pszExtension )
+    {
+        *pszExtension = 0;
+    }
+    wcscat_s( pszFileName, uMaxChars, CLUSTER_DAG_FILE_EXTENSION );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CClusterDAG::CClusterDAG() :
+    m_uNumLevels( 0 ),
+    m_uNumInputTriangles( 0 ),
+    m_pVB( NULL ),
+    m_pIB( NULL )
+{
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CClusterDAG::~CClusterDAG()
+{
+    DestroyBuffers();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Simplifies the triangles of one group on its own vertices
+//--------------------------------------------------------------------------------------
+void CClusterDAG::SimplifyGroupTask( void* pContext, UINT uTask, UINT uWorker )
+{
+    UNREFERENCED_PARAMETER( uWorker );
+
+    const CLUSTER_BUILD_CONTEXT* pBuild = (const CLUSTER_BUILD_CONTEXT*)pContext;
+    const CLUSTER_GROUP& Group = ( *pBuild->pGroups )[uTask];
+    CLUSTER_GROUP_RESULT& Result = ( *pBuild->pResults )[uTask];
+    Result.bSimplified = false;
+    Result.fError = 0.0f;
+    Result.Indices.clear();
+
+    std::vector<UINT> Indices;
+    for( UINT m = 0; m < Group.uNumMembers; m++ )
+    {
+        const CLUSTER& Member = ( *pBuild->pClusters )[( *pBuild->pMembers )[Group.uFirstMember + m]];
+        const UINT* pFirst = &( *pBuild->pIndices )[Member.uFirstIndex];
+        Indices.insert( Indices.end(), pFirst, pFirst + Member.uNumTriangles * 3 );
+    }
+    UINT uNumTriangles = (UINT)Indices.size() / 3;
+
+    // The edges on the outside of the group are used once and keep their vertices
+    float fError = 0.0f;
+    if( FAILED( SimplifyTriangles( &( *pBuild->pPositions )[0], uNumTriangles / 2, &Indices, &fError ) ) ||
+        Indices.empty() || (float)( Indices.size() / 3 ) > CLUSTER_MIN_REDUCTION * (float)uNumTriangles )
+    {
+        return;
+    }
+
+    SortTriangles( &( *pBuild->pVertices )[0], &pBuild->Quantize, &Indices );
+    Result.Indices.swap( Indices );
+    Result.fError = fError;
+    Result.bSimplified = true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Builds the clusters of the input triangles and simplifies them level by level
+//--------------------------------------------------------------------------------------
+HRESULT CClusterDAG::Build( const MESH_DATA* pMeshData, CNumaTaskPool* pPool )
+{
+    assert( NULL != pMeshData );
+
+    DestroyBuffers();
+    m_Vertices.clear();
+    m_Indices.clear();
+    m_Clusters.clear();
+    m_uNumLevels = 0;
+    m_uNumInputTriangles = 0;
+
+    if( pMeshData->Vertices.empty() || pMeshData->Indices.size() < 3 )
+    {
+        return E_INVALIDARG;
+    }
+
+    std::vector<UINT> Triangles;
+    WeldPositions( pMeshData, &m_Vertices, &Triangles );
+    if( Triangles.empty() )
+    {
+        m_Vertices.clear();
+        return E_INVALIDARG;
+    }
+    m_uNumInputTriangles = (UINT)Triangles.size() / 3;
+
+    std::vector<XMFLOAT3> Positions( m_Vertices.size() );
+    XMVECTOR vMin = XMVectorReplicate( FLT_MAX );
+    XMVECTOR vMax = XMVectorReplicate( -FLT_MAX );
+    for( UINT v = 0; v < (UINT)m_Vertices.size(); v++ )
+    {
+        vMin = XMVectorMin( vMin, XMLoadFloat3( &m_Vertices[v].f3Position ) );
+        vMax = XMVectorMax( vMax, XMLoadFloat3( &m_Vertices[v].f3Position ) );
+        Positions[v] = m_Vertices[v].f3Position;
+    }
+    XMFLOAT3 f3Extent;
+    XMStoreFloat3( &f3Extent, XMVectorSubtract( vMax, vMin ) );
+    float fMaxExtent = std::max( std::max( f3Extent.x, f3Extent.y ), f3Extent.z );
+    CLUSTER_QUANTIZE Quantize;
+    XMStoreFloat3( &Quantize.f3Min, vMin );
+    Quantize.fScale = ( fMaxExtent > 0.0f ) ? (float)( 1 << PATCH_ORDER_BITS ) / fMaxExtent : 0.0f;
+
+    // Level 0 in runs of the Morton curve
+    SortTriangles( &m_Vertices[0], &Quantize, &Triangles );
+    m_Indices.swap( Triangles );
+    std::vector<UINT> Roots;
+    for( UINT uFirst = 0; uFirst < (UINT)m_Indices.size(); uFirst += CLUSTER_MAX_TRIANGLES * 3 )
+    {
+        CLUSTER Cluster;
+        Cluster.uFirstIndex = uFirst;
+        Cluster.uNumTriangles = std::min( CLUSTER_MAX_TRIANGLES, ( (UINT)m_Indices.size() - uFirst ) / 3 );
+        Cluster.uLevel = 0;
+        Cluster.fError = 0.0f;
+        Cluster.f4Sphere = GetTrianglesSphere( &m_Vertices[0], &m_Indices[uFirst], Cluster.uNumTriangles * 3 );
+        Cluster.fParentError = FLT_MAX;
+        Cluster.f4ParentSphere = Cluster.f4Sphere;
+        Roots.push_back( (UINT)m_Clusters.size() );
+        m_Clusters.push_back( Cluster );
+    }
+    m_uNumLevels = 1;
+
+    // Each pass groups the clusters not merged yet along the Morton curve of their centers.
+    // A group that does not simplify enough leaves its clusters to be grouped again.
+    std::vector<UINT> Members;
+    std::vector<CLUSTER_GROUP> Groups;
+    std::vector<CLUSTER_GROUP_RESULT> Results;
+    std::vector< std::pair<UINT64, UINT> > Keys;
+    for( UINT uPass = 1; uPass < CLUSTER_MAX_LEVELS && Roots.size() > 1; uPass++ )
+    {
+        Keys.resize( Roots.size() );
+        for( UINT i = 0; i < (UINT)Roots.size(); i++ )
+        {
+            Keys[i] = std::make_pair( GetMortonKey( XMLoadFloat4( &m_Clusters[Roots[i]].f4Sphere ), &Quantize ), Roots[i] );
+        }
+        std::sort( Keys.begin(), Keys.end() );
+        Members.resize( Keys.size() );
+        Groups.clear();
+        for( UINT i = 0; i < (UINT)Keys.size(); i++ )
+        {
+            Members[i] = Keys[i].second;
+            if( 0 == i % CLUSTER_GROUP_SIZE )
+            {
+                CLUSTER_GROUP Group = { i, std::min( CLUSTER_GROUP_SIZE, (UINT)Keys.size() - i ) };
+                Groups.push_back( Group );
+            }
+        }
+
+        Results.resize( Groups.size() );
+        CLUSTER_BUILD_CONTEXT Context = { &m_Vertices, &Positions, &m_Indices, &m_Clusters, &Members, &Groups, &Results, Quantize };
+        if( NULL != pPool && Groups.size() > 1 )
+        {
+            pPool->Run( SimplifyGroupTask, &Context, (UINT)Groups.size(), NULL, true );
+        }
+        else
+        {
+            for( UINT g = 0; g < (UINT)Groups.size(); g++ )
+            {
+                SimplifyGroupTask( &Context, g, 0 );
+            }
+        }
+
+        // In group order, so the DAG does not depend on the workers
+        std::vector<UINT> NextRoots;
+        bool bSimplified = false;
+        for( UINT g = 0; g < (UINT)Groups.size(); g++ )
+        {
+            const CLUSTER_GROUP& Group = Groups[g];
+            CLUSTER_GROUP_RESULT& Result = Results[g];
+            if( !Result.bSimplified )
+            {
+                NextRoots.insert( NextRoots.end(), Members.begin() + Group.uFirstMember, Members.begin() + Group.uFirstMember + Group.uNumMembers );
+                continue;
+            }
+            bSimplified = true;
+
+            // The group's error adds the simplification to the largest error of its
+            // members, its sphere holds theirs
+            XMVECTOR vGroupMin = XMVectorReplicate( FLT_MAX );
+            XMVECTOR vGroupMax = XMVectorReplicate( -FLT_MAX );
+            float fMemberError = 0.0f;
+            UINT uLevel = 0;
+            for( UINT m = 0; m < Group.uNumMembers; m++ )
+            {
+                const CLUSTER& Member = m_Clusters[Members[Group.uFirstMember + m]];
+                XMVECTOR vCenter = XMLoadFloat4( &Member.f4Sphere );
+                XMVECTOR vRadius = XMVectorReplicate( Member.f4Sphere.w );
+                vGroupMin = XMVectorMin( vGroupMin, XMVectorSubtract( vCenter, vRadius ) );
+                vGroupMax = XMVectorMax( vGroupMax, XMVectorAdd( vCenter, vRadius ) );
+                fMemberError = std::max( fMemberError, Member.fError );
+                uLevel = std::max( uLevel, Member.uLevel + 1 );
+            }
+            XMVECTOR vGroupCenter = XMVectorScale( XMVectorAdd( vGroupMin, vGroupMax ), 0.5f );
+            float fRadius = 0.0f;
+            for( UINT m = 0; m < Group.uNumMembers; m++ )
+            {
+                const CLUSTER& Member = m_Clusters[Members[Group.uFirstMember + m]];
+                fRadius = std::max( fRadius, XMVectorGetX( XMVector3Length( XMVectorSubtract( XMLoadFloat4( &Member.f4Sphere ), vGroupCenter ) ) ) + Member.f4Sphere.w );
+            }
+            XMFLOAT4 f4GroupSphere;
+            XMStoreFloat4( &f4GroupSphere, XMVectorSetW( vGroupCenter, fRadius ) );
+            float fGroupError = fMemberError + Result.fError;
+
+            for( UINT m = 0; m < Group.uNumMembers; m++ )
+            {
+                CLUSTER& Member = m_Clusters[Members[Group.uFirstMember + m]];
+                Member.fParentError = fGroupError;
+                Member.f4ParentSphere = f4GroupSphere;
+            }
+
+            UINT uBase = (UINT)m_Indices.size();
+            m_Indices.insert( m_Indices.end(), Result.Indices.begin(), Result.Indices.end() );
+            for( UINT uFirst = 0; uFirst < (UINT)Result.Indices.size(); uFirst += CLUSTER_MAX_TRIANGLES * 3 )
+            {
+                CLUSTER Cluster;
+                Cluster.uFirstIndex = uBase + uFirst;
+                Cluster.uNumTriangles = std::min( CLUSTER_MAX_TRIANGLES, ( (UINT)Result.Indices.size() - uFirst ) / 3 );
+                Cluster.uLevel = uLevel;
+                Cluster.fError = fGroupError;
+                Cluster.f4Sphere = f4GroupSphere;
+                Cluster.fParentError = FLT_MAX;
+                Cluster.f4ParentSphere = f4GroupSphere;
+                NextRoots.push_back( (UINT)m_Clusters.size() );
+                m_Clusters.push_back( Cluster );
+            }
+            m_uNumLevels = std::max( m_uNumLevels, uLevel + 1 );
+            std::vector<UINT>().swap( Result.Indices );
+        }
+
+        if( !bSimplified )
+        {
+            break;
+        }
+        Roots.swap( NextRoots );
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Writes the DAG to a sidecar file
+//--------------------------------------------------------------------------------------
+HRESULT CClusterDAG::Save( const WCHAR* pszFileName ) const
+{
+    assert( NULL != pszFileName );
+
+    if( !IsBuilt() )
+    {
+        return E_FAIL;
+    }
+
+    FILE* pOutput = NULL;
+    if( 0 != _wfopen_s( &pOutput, pszFileName, L"wb" ) || NULL == pOutput )
+    {
+        return E_ACCESSDENIED;
+    }
+
+    CLUSTER_FILE_HEADER Header = { CLUSTER_FILE_MAGIC, CLUSTER_FILE_VERSION, (UINT)m_Vertices.size(), (UINT)m_Indices.size(),
+                                   (UINT)m_Clusters.size(), m_uNumLevels, m_uNumInputTriangles };
+    bool bWritten = ( 1 == fwrite( &Header, sizeof( Header ), 1, pOutput ) ) &&
+                    ( m_Vertices.size() == fwrite( &m_Vertices[0], sizeof( PN_VERTEX ), m_Vertices.size(), pOutput ) ) &&
+                    ( m_Indices.size() == fwrite( &m_Indices[0], sizeof( UINT ), m_Indices.size(), pOutput ) ) &&
+                    ( m_Clusters.size() == fwrite( &m_Clusters[0], sizeof( CLUSTER ), m_Clusters.size(), pOutput ) );
+    fclose( pOutput );
+
+    return bWritten ? S_OK : E_FAIL;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reads the DAG from a sidecar file, checking the references
+//--------------------------------------------------------------------------------------
+HRESULT CClusterDAG::Load( const WCHAR* pszFileName )
+{
+    assert( NULL != pszFileName );
+
+    DestroyBuffers();
+    m_Vertices.clear();
+    m_Indices.clear();
+    m_Clusters.clear();
+
+    FILE* pInput = NULL;
+    if( 0 != _wfopen_s( &pInput, pszFileName, L"rb" ) || NULL == pInput )
+    {
+        return E_FAIL;
+    }
+
+    CLUSTER_FILE_HEADER Header;
+    bool bRead = ( 1 == fread( &Header, sizeof( Header ), 1, pInput ) ) && CLUSTER_FILE_MAGIC == Header.uMagic &&
+                 CLUSTER_FILE_VERSION == Header.uVersion && 0 != Header.uNumVertices && 0 != Header.uNumIndices &&
+                 0 == Header.uNumIndices % 3 && 0 != Header.uNumClusters;
+    if( bRead )
+    {
+        m_Vertices.resize( Header.uNumVertices );
+        m_Indices.resize( Header.uNumIndices );
+        m_Clusters.resize( Header.uNumClusters );
+        bRead = ( m_Vertices.size() == fread( &m_Vertices[0], sizeof( PN_VERTEX ), m_Vertices.size(), pInput ) ) &&
+                ( m_Indices.size() == fread( &m_Indices[0], sizeof( UINT ), m_Indices.size(), pInput ) ) &&
+                ( m_Clusters.size() == fread( &m_Clusters[0], sizeof( CLUSTER ), m_Clusters.size(), pInput ) );
+    }
+    fclose( pInput );
+
+    for( UINT i = 0; i < (UINT)m_Indices.size() && bRead; i++ )
+    {
+        bRead = m_Indices[i] < Header.uNumVertices;
+    }
+    for( UINT c = 0; c < (UINT)m_Clusters.size() && bRead; c++ )
+    {
+        const CLUSTER& Cluster = m_Clusters[c];
+        bRead = Cluster.uNumTriangles <= CLUSTER_MAX_TRIANGLES && Cluster.uFirstIndex <= Header.uNumIndices &&
+                Cluster.uNumTriangles * 3 <= Header.uNumIndices - Cluster.uFirstIndex && Cluster.uLevel < Header.uNumLevels;
+    }
+    if( !bRead )
+    {
+        m_Vertices.clear();
+        m_Indices.clear();
+        m_Clusters.clear();
+        return E_FAIL;
+    }
+
+    m_uNumLevels = Header.uNumLevels;
+    m_uNumInputTriangles = Header.uNumInputTriangles;
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Picks the clusters of a range that are fine enough while their parent group is not
+//--------------------------------------------------------------------------------------
+void CClusterDAG::SelectCutRange( const PM_VIEW* pView, bool bCull, UINT uFirst, UINT uCount, std::vector<UINT>* pClusters, UINT* puNumCulled ) const
+{
+    pClusters->clear();
+    *puNumCulled = 0;
+    for( UINT c = uFirst; c < uFirst + uCount; c++ )
+    {
+        const CLUSTER& Cluster = m_Clusters[c];
+        if( !IsFineEnough( Cluster.fError, Cluster.f4Sphere, pView ) || IsFineEnough( Cluster.fParentError, Cluster.f4ParentSphere, pView ) )
+        {
+            continue;
+        }
+
+        if( bCull )
+        {
+            XMVECTOR vCenter = XMVectorSetW( XMLoadFloat4( &Cluster.f4Sphere ), 1.0f );
+            bool bOutside = false;
+            for( UINT p = 0; p < 6 && !bOutside; p++ )
+            {
+                bOutside = XMVectorGetX( XMVector4Dot( XMLoadFloat4( &pView->f4FrustumPlanes[p] ), vCenter ) ) < -Cluster.f4Sphere.w;
+            }
+            if( bOutside )
+            {
+                ( *puNumCulled )++;
+                continue;
+            }
+        }
+        pClusters->push_back( c );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Selects the cut of one task's clusters
+//--------------------------------------------------------------------------------------
+void CClusterDAG::SelectCutTask( void* pContext, UINT uTask, UINT uWorker )
+{
+    UNREFERENCED_PARAMETER( uWorker );
+
+    const CLUSTER_SELECT_CONTEXT* pSelect = (const CLUSTER_SELECT_CONTEXT*)pContext;
+    CClusterDAG* pDAG = pSelect->pDAG;
+    UINT uFirst = uTask * CLUSTER_SELECT_TASK_CLUSTERS;
+    pDAG->SelectCutRange( pSelect->pView, pSelect->bCull, uFirst, std::min( CLUSTER_SELECT_TASK_CLUSTERS, (UINT)pDAG->m_Clusters.size() - uFirst ),
+                          &pDAG->m_TaskClusters[uTask], &pDAG->m_TaskCulled[uTask] );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Selects the cut of the DAG for a view
+//--------------------------------------------------------------------------------------
+void CClusterDAG::SelectCut( const PM_VIEW* pView, bool bCull, CNumaTaskPool* pPool, std::vector<UINT>* pClusters, CLUSTER_CUT_STATS* pStats )
+{
+    assert( NULL != pView && NULL != pClusters );
+
+    UINT uNumClusters = (UINT)m_Clusters.size();
+    UINT uNumTasks = ( uNumClusters + CLUSTER_SELECT_TASK_CLUSTERS - 1 ) / CLUSTER_SELECT_TASK_CLUSTERS;
+    UINT uNumCulled = 0;
+    if( NULL != pPool && uNumTasks > 1 )
+    {
+        m_TaskClusters.resize( uNumTasks );
+        m_TaskCulled.resize( uNumTasks );
+        CLUSTER_SELECT_CONTEXT Context = { this, pView, bCull };
+        pPool->Run( SelectCutTask, &Context, uNumTasks, NULL, true );
+
+        pClusters->clear();
+        for( UINT uTask = 0; uTask < uNumTasks; uTask++ )
+        {
+            pClusters->insert( pClusters->end(), m_TaskClusters[uTask].begin(), m_TaskClusters[uTask].end() );
+            uNumCulled += m_TaskCulled[uTask];
+        }
+    }
+    else
+    {
+        SelectCutRange( pView, bCull, 0, uNumClusters, pClusters, &uNumCulled );
+    }
+
+    if( NULL != pStats )
+    {
+        pStats->uNumClusters = (UINT)pClusters->size();
+        pStats->uNumTriangles = 0;
+        for( UINT i = 0; i < (UINT)pClusters->size(); i++ )
+        {
+            pStats->uNumTriangles += m_Clusters[( *pClusters )[i]].uNumTriangles;
+        }
+        pStats->uNumCulled = uNumCulled;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Creates the vertex buffer and the index buffer of every level
+//--------------------------------------------------------------------------------------
+HRESULT CClusterDAG::CreateBuffers( ID3D11Device* pd3dDevice )
+{
+    HRESULT hr = S_OK;
+
+    assert( NULL != pd3dDevice );
+
+    DestroyBuffers();
+    if( !IsBuilt() )
+    {
+        return E_FAIL;
+    }
+
+    D3D11_BUFFER_DESC Desc;
+    Desc.Usage = D3D11_USAGE_IMMUTABLE;
+    Desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    Desc.CPUAccessFlags = 0;
+    Desc.MiscFlags = 0;
+    Desc.StructureByteStride = 0;
+    Desc.ByteWidth = (UINT)m_Vertices.size() * sizeof( PN_VERTEX );
+    D3D11_SUBRESOURCE_DATA InitData;
+    ZeroMemory( &InitData, sizeof( InitData ) );
+    InitData.pSysMem = &m_Vertices[0];
+    V_RETURN( pd3dDevice->CreateBuffer( &Desc, &InitData, &m_pVB ) );
+
+    Desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+    Desc.ByteWidth = (UINT)m_Indices.size() * sizeof( UINT );
+    InitData.pSysMem = &m_Indices[0];
+    hr = pd3dDevice->CreateBuffer( &Desc, &InitData, &m_pIB );
+    if( FAILED( hr ) )
+    {
+        DestroyBuffers();
+        return hr;
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Releases the buffers
+//--------------------------------------------------------------------------------------
+void CClusterDAG::DestroyBuffers()
+{
+    SAFE_RELEASE( m_pVB );
+    SAFE_RELEASE( m_pIB );
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,162 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ClusterDAG.h
+//
+// Cluster level of detail for very dense meshes. The triangles are cut into clusters of
+// up to CLUSTER_MAX_TRIANGLES along a Morton curve of their centroids. Groups of
+// CLUSTER_GROUP_SIZE neighbouring clusters are then merged, simplified to half with the
+// vertices of their outer edges locked (see MeshSimplify.h) and cut into new clusters,
+// level after level. A cluster thus has the group it was simplified from as its children
+// and the group it was merged into as its parent, and the clusters form a DAG.
+//
+// Every cluster made from one group stores the error and the sphere of that group, and
+// every cluster merged into one group stores those of the parent group. The errors and
+// spheres grow up the DAG, so drawing a cluster iff its own error is under the
+// threshold on screen and its parent's is not picks exactly one side of every group
+// boundary: the cut is watertight without neighbours looking at each other, and each
+// cluster is tested on its own, in parallel.
+//
+// Collapses move vertices onto their neighbours, so every level indexes the vertices of
+// the welded input mesh.
+//--------------------------------------------------------------------------------------
+#ifndef CLUSTER_DAG_H
+#define CLUSTER_DAG_H
+
+#include "MeshData.h"
+#include "NumaTaskPool.h"
+#include "ProgressiveMesh.h"
+
+// Triangles of a cluster at most
+static const UINT CLUSTER_MAX_TRIANGLES = 128;
+
+// Uniform tess factor of the PN-Triangles surface the DAG is built from, standing in for
+// a dense mesh
+static const float CLUSTER_SOURCE_TESS_FACTOR = 16.0f;
+
+// Clusters merged into a group and simplified together
+static const UINT CLUSTER_GROUP_SIZE = 4;
+
+// A group simplified to more than this share of its triangles is left as it is
+static const float CLUSTER_MIN_REDUCTION = 0.85f;
+
+// Levels built at most
+static const UINT CLUSTER_MAX_LEVELS = 24;
+
+// Clusters tested per worker task by the cut selection
+static const UINT CLUSTER_SELECT_TASK_CLUSTERS = 4096;
+
+// Default screen error, in pixels
+static const float CLUSTER_PIXEL_ERROR = 1.0f;
+
+// Sidecar the DAG of <mesh>.sdkmesh is stored in
+#define CLUSTER_DAG_FILE_EXTENSION L".clusterlod"
+
+// A cluster: its triangles and the bounds of the group it was simplified from and of the
+// group it was merged into. The spheres bound the triangles of the group, and a sphere of
+// a parent holds those of its children.
+struct CLUSTER
+{
+    UINT                uFirstIndex;
+    UINT                uNumTriangles;
+    UINT                uLevel;             // 0 for the input triangles
+    float               fError;             // Distance to the input mesh, 0 at level 0
+    DirectX::XMFLOAT4   f4Sphere;
+    float               fParentError;       // FLT_MAX if never merged
+    DirectX::XMFLOAT4   f4ParentSphere;
+};
+
+struct CLUSTER_CUT_STATS
+{
+    UINT    uNumClusters;       // Drawn
+    UINT    uNumTriangles;
+    UINT    uNumCulled;         // In the cut but outside the frustum
+};
+
+
+//--------------------------------------------------------------------------------------
+// Replaces the extension of an sdkmesh file name by CLUSTER_DAG_FILE_EXTENSION
+//--------------------------------------------------------------------------------------
+void GetClusterDAGFileName( const WCHAR* pszMeshFileName, WCHAR* pszFileName, UINT uMaxChars );
+
+
+//--------------------------------------------------------------------------------------
+// Cluster DAG of a mesh and its vertex and index buffers
+//--------------------------------------------------------------------------------------
+class CClusterDAG
+{
+public:
+
+    CClusterDAG();
+    ~CClusterDAG();
+
+    // Welds the vertices by position, as the progressive mesh does, and builds the levels
+    // until no group simplifies further. The groups of a level are simplified over the
+    // workers of pPool, which may be NULL, and the result does not depend on it.
+    HRESULT Build( const MESH_DATA* pMeshData, CNumaTaskPool* pPool );
+
+    HRESULT Save( const WCHAR* pszFileName ) const;
+    HRESULT Load( const WCHAR* pszFileName );
+
+    bool IsBuilt() const { return !m_Clusters.empty(); }
+    UINT GetNumVertices() const { return (UINT)m_Vertices.size(); }
+    UINT GetNumLevels() const { return m_uNumLevels; }
+    UINT GetNumInputTriangles() const { return m_uNumInputTriangles; }
+    UINT GetNumTriangles() const { return (UINT)m_Indices.size() / 3; }
+    const std::vector<PN_VERTEX>& GetVertices() const { return m_Vertices; }
+    const std::vector<UINT>& GetIndices() const { return m_Indices; }
+    const std::vector<CLUSTER>& GetClusters() const { return m_Clusters; }
+
+    // Fills pClusters with the clusters of the cut for the view, in order. With bCull the
+    // clusters outside the frustum are left out. The clusters are split into tasks of
+    // CLUSTER_SELECT_TASK_CLUSTERS over the workers of pPool, which may be NULL. pStats
+    // may be NULL.
+    void SelectCut( const PM_VIEW* pView, bool bCull, CNumaTaskPool* pPool, std::vector<UINT>* pClusters, CLUSTER_CUT_STATS* pStats );
+
+    // Immutable buffers of the vertices and of the triangles of every level
+    HRESULT CreateBuffers( ID3D11Device* pd3dDevice );
+    void DestroyBuffers();
+    ID3D11Buffer* GetVB() const { return m_pVB; }
+    ID3D11Buffer* GetIB() const { return m_pIB; }
+
+private:
+
+    static void SimplifyGroupTask( void* pContext, UINT uTask, UINT uWorker );
+    static void SelectCutTask( void* pContext, UINT uTask, UINT uWorker );
+    void SelectCutRange( const PM_VIEW* pView, bool bCull, UINT uFirst, UINT uCount, std::vector<UINT>* pClusters, UINT* puNumCulled ) const;
+
+    std::vector<PN_VERTEX>  m_Vertices;
+    std::vector<UINT>       m_Indices;              // Of every cluster, level by level
+    std::vector<CLUSTER>    m_Clusters;
+    UINT                    m_uNumLevels;
+    UINT                    m_uNumInputTriangles;
+
+    // Per task output of the cut selection
+    std::vector< std::vector<UINT> >    m_TaskClusters;
+    std::vector<UINT>                   m_TaskCulled;
+
+    ID3D11Buffer*           m_pVB;
+    ID3D11Buffer*           m_pIB;
+};
+
+#endif
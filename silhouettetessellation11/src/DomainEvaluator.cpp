@@ -0,0 +1,313 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+//--------------------------------------------------------------------------------------
+// File: DomainEvaluator.cpp
+//
+// CPU evaluation of a PN-Triangles patch over a tessellation.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "DomainEvaluator.h"
+
+using namespace DirectX;
+
+// The control points of a patch, loaded once per patch
+struct PN_PATCH_VECTORS
+{
+    XMVECTOR vB003, vB030, vB300;
+    XMVECTOR vB210, vB120, vB021, vB012, vB102, vB201, vB111;
+    XMVECTOR vN002, vN020, vN200;
+    XMVECTOR vN110, vN011, vN101;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Loads the corners and control points of a patch
+//--------------------------------------------------------------------------------------
+static void LoadPatchVectors( const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints, PN_PATCH_VECTORS* pPatch )
+{
+    pPatch->vB003 = XMLoadFloat3( &pCorners[0].f3Position );
+    pPatch->vB030 = XMLoadFloat3( &pCorners[1].f3Position );
+    pPatch->vB300 = XMLoadFloat3( &pCorners[2].f3Position );
+    pPatch->vB210 = XMLoadFloat3( &pControlPoints->f3B210 );
+    pPatch->vB120 = XMLoadFloat3( &pControlPoints->f3B120 );
+    pPatch->vB021 = XMLoadFloat3( &pControlPoints->f3B021 );
+    pPatch->vB012 = XMLoadFloat3( &pControlPoints->f3B012 );
+    pPatch->vB102 = XMLoadFloat3( &pControlPoints->f3B102 );
+    pPatch->vB201 = XMLoadFloat3( &pControlPoints->f3B201 );
+    pPatch->vB111 = XMLoadFloat3( &pControlPoints->f3B111 );
+    pPatch->vN002 = XMLoadFloat3( &pCorners[0].f3Normal );
+    pPatch->vN020 = XMLoadFloat3( &pCorners[1].f3Normal );
+    pPatch->vN200 = XMLoadFloat3( &pCorners[2].f3Normal );
+    pPatch->vN110 = XMLoadFloat3( &pControlPoints->f3N110 );
+    pPatch->vN011 = XMLoadFloat3( &pControlPoints->f3N011 );
+    pPatch->vN101 = XMLoadFloat3( &pControlPoints->f3N101 );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates the cubic position and the unnormalized quadratic normal at a domain point,
+// with the same weights as EvaluatePNTriangle
+//--------------------------------------------------------------------------------------
+static void EvaluateDirect( const PN_PATCH_VECTORS& Patch, const XMFLOAT3& f3DomainPoint, XMVECTOR* pvPosition, XMVECTOR* pvNormal )
+{
+    float fU = f3DomainPoint.x;
+    float fV = f3DomainPoint.y;
+    float fW = f3DomainPoint.z;
+    float fUU = fU * fU;
+    float fVV = fV * fV;
+    float fWW = fW * fW;
+    float fUU3 = fUU * 3.0f;
+    float fVV3 = fVV * 3.0f;
+    float fWW3 = fWW * 3.0f;
+
+    XMVECTOR vPosition = XMVectorScale( Patch.vB003, fWW * fW );
+    vPosition = XMVectorMultiplyAdd( Patch.vB030, XMVectorReplicate( fUU * fU ), vPosition );
+    vPosition = XMVectorMultiplyAdd( Patch.vB300, XMVectorReplicate( fVV * fV ), vPosition );
+    vPosition = XMVectorMultiplyAdd( Patch.vB210, XMVectorReplicate( fWW3 * fU ), vPosition );
+    vPosition = XMVectorMultiplyAdd( Patch.vB120, XMVectorReplicate( fW * fUU3 ), vPosition );
+    vPosition = XMVectorMultiplyAdd( Patch.vB201, XMVectorReplicate( fWW3 * fV ), vPosition );
+    vPosition = XMVectorMultiplyAdd( Patch.vB021, XMVectorReplicate( fUU3 * fV ), vPosition );
+    vPosition = XMVectorMultiplyAdd( Patch.vB102, XMVectorReplicate( fW * fVV3 ), vPosition );
+    vPosition = XMVectorMultiplyAdd( Patch.vB012, XMVectorReplicate( fU * fVV3 ), vPosition );
+    *pvPosition = XMVectorMultiplyAdd( Patch.vB111, XMVectorReplicate( 6.0f * fW * fU * fV ), vPosition );
+
+    XMVECTOR vNormal = XMVectorScale( Patch.vN002, fWW );
+    vNormal = XMVectorMultiplyAdd( Patch.vN020, XMVectorReplicate( fUU ), vNormal );
+    vNormal = XMVectorMultiplyAdd( Patch.vN200, XMVectorReplicate( fVV ), vNormal );
+    vNormal = XMVectorMultiplyAdd( Patch.vN110, XMVectorReplicate( fW * fU ), vNormal );
+    vNormal = XMVectorMultiplyAdd( Patch.vN011, XMVectorReplicate( fU * fV ), vNormal );
+    *pvNormal = XMVectorMultiplyAdd( Patch.vN101, XMVectorReplicate( fW * fV ), vNormal );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Stores an evaluated point, normalizing the normal as DS_PNTriangles does
+//--------------------------------------------------------------------------------------
+static void StorePoint( UINT uPoint, FXMVECTOR vPosition, FXMVECTOR vNormal, XMFLOAT3* pPositions, XMFLOAT3* pNormals )
+{
+    if( NULL != pPositions )
+    {
+        XMStoreFloat3( &pPositions[uPoint], vPosition );
+    }
+    if( NULL != pNormals )
+    {
+        XMStoreFloat3( &pNormals[uPoint], XMVector3Normalize( vNormal ) );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates the patch at every domain point directly
+//--------------------------------------------------------------------------------------
+void EvaluatePNTessellation( const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints,
+                             const TRI_TESSELLATION* pTessellation,
+                             XMFLOAT3* pPositions, XMFLOAT3* pNormals )
+{
+    assert( NULL != pCorners );
+    assert( NULL != pControlPoints );
+    assert( NULL != pTessellation );
+
+    PN_PATCH_VECTORS Patch;
+    LoadPatchVectors( pCorners, pControlPoints, &Patch );
+
+    for( UINT uPoint = 0; uPoint < (UINT)pTessellation->DomainPoints.size(); uPoint++ )
+    {
+        XMVECTOR vPosition, vNormal;
+        EvaluateDirect( Patch, pTessellation->DomainPoints[uPoint], &vPosition, &vNormal );
+        StorePoint( uPoint, vPosition, vNormal, pPositions, pNormals );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// One de Casteljau step of the cubic, in the order B003, B030, B300, B210, B120, B201,
+// B021, B102, B012, B111, with the barycentric coords (or direction) f3X given as
+// (U, V, W). Gives the quadratic in the order W^2, U^2, V^2, WU, WV, UV.
+//--------------------------------------------------------------------------------------
+static void CubicDeCasteljauStep( const XMVECTOR* pvCubic, const XMFLOAT3& f3X, XMVECTOR* pvQuadratic )
+{
+    XMVECTOR vU = XMVectorReplicate( f3X.x );
+    XMVECTOR vV = XMVectorReplicate( f3X.y );
+    XMVECTOR vW = XMVectorReplicate( f3X.z );
+
+    pvQuadratic[0] = XMVectorMultiplyAdd( vW, pvCubic[0], XMVectorMultiplyAdd( vU, pvCubic[3], XMVectorMultiply( vV, pvCubic[5] ) ) );
+    pvQuadratic[1] = XMVectorMultiplyAdd( vW, pvCubic[4], XMVectorMultiplyAdd( vU, pvCubic[1], XMVectorMultiply( vV, pvCubic[6] ) ) );
+    pvQuadratic[2] = XMVectorMultiplyAdd( vW, pvCubic[7], XMVectorMultiplyAdd( vU, pvCubic[8], XMVectorMultiply( vV, pvCubic[2] ) ) );
+    pvQuadratic[3] = XMVectorMultiplyAdd( vW, pvCubic[3], XMVectorMultiplyAdd( vU, pvCubic[4], XMVectorMultiply( vV, pvCubic[9] ) ) );
+    pvQuadratic[4] = XMVectorMultiplyAdd( vW, pvCubic[5], XMVectorMultiplyAdd( vU, pvCubic[9], XMVectorMultiply( vV, pvCubic[7] ) ) );
+    pvQuadratic[5] = XMVectorMultiplyAdd( vW, pvCubic[9], XMVectorMultiplyAdd( vU, pvCubic[6], XMVectorMultiply( vV, pvCubic[8] ) ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// One de Casteljau step of a quadratic, in the order above. Gives the linear in the order
+// W, U, V.
+//--------------------------------------------------------------------------------------
+static void QuadraticDeCasteljauStep( const XMVECTOR* pvQuadratic, const XMFLOAT3& f3X, XMVECTOR* pvLinear )
+{
+    XMVECTOR vU = XMVectorReplicate( f3X.x );
+    XMVECTOR vV = XMVectorReplicate( f3X.y );
+    XMVECTOR vW = XMVectorReplicate( f3X.z );
+
+    pvLinear[0] = XMVectorMultiplyAdd( vW, pvQuadratic[0], XMVectorMultiplyAdd( vU, pvQuadratic[3], XMVectorMultiply( vV, pvQuadratic[4] ) ) );
+    pvLinear[1] = XMVectorMultiplyAdd( vW, pvQuadratic[3], XMVectorMultiplyAdd( vU, pvQuadratic[1], XMVectorMultiply( vV, pvQuadratic[5] ) ) );
+    pvLinear[2] = XMVectorMultiplyAdd( vW, pvQuadratic[4], XMVectorMultiplyAdd( vU, pvQuadratic[5], XMVectorMultiply( vV, pvQuadratic[2] ) ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Last de Casteljau step, from the linear in the order above
+//--------------------------------------------------------------------------------------
+static XMVECTOR LinearDeCasteljauStep( const XMVECTOR* pvLinear, const XMFLOAT3& f3X )
+{
+    return XMVectorMultiplyAdd( XMVectorReplicate( f3X.z ), pvLinear[0],
+           XMVectorMultiplyAdd( XMVectorReplicate( f3X.x ), pvLinear[1], XMVectorMultiply( XMVectorReplicate( f3X.y ), pvLinear[2] ) ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates the patch at every domain point, with forward differences along the rows.
+//
+// Along a row X(i) = S + i * D, so P(X(i)) = a0 + a1 i + a2 i^2 + a3 i^3 where, with F the
+// blossom of the cubic, a0 = F(S,S,S), a1 = 3F(S,S,D), a2 = 3F(S,D,D) and a3 = F(D,D,D).
+// Taking the coefficients from the blossom rather than differencing evaluated points
+// avoids the cancellation that would otherwise be amplified along the row. Positions are
+// accumulated relative to corner 0 for the same reason.
+//--------------------------------------------------------------------------------------
+void EvaluatePNTessellationForwardDifference( const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints,
+                                              const TRI_TESSELLATION* pTessellation,
+                                              XMFLOAT3* pPositions, XMFLOAT3* pNormals )
+{
+    assert( NULL != pCorners );
+    assert( NULL != pControlPoints );
+    assert( NULL != pTessellation );
+
+    PN_PATCH_VECTORS Patch;
+    LoadPatchVectors( pCorners, pControlPoints, &Patch );
+
+    const XMFLOAT3* pDomainPoints = pTessellation->DomainPoints.empty() ? NULL : &pTessellation->DomainPoints[0];
+
+    // The transition ring is irregular, evaluate it directly
+    for( UINT uPoint = 0; uPoint < pTessellation->uNumTransitionPoints; uPoint++ )
+    {
+        XMVECTOR vPosition, vNormal;
+        EvaluateDirect( Patch, pDomainPoints[uPoint], &vPosition, &vNormal );
+        StorePoint( uPoint, vPosition, vNormal, pPositions, pNormals );
+    }
+
+    // Bernstein coefficients of the position relative to corner 0, and of the normal
+    XMVECTOR vOrigin = Patch.vB003;
+    XMVECTOR vCubic[10] =
+    {
+        XMVectorZero(),
+        XMVectorSubtract( Patch.vB030, vOrigin ),
+        XMVectorSubtract( Patch.vB300, vOrigin ),
+        XMVectorSubtract( Patch.vB210, vOrigin ),
+        XMVectorSubtract( Patch.vB120, vOrigin ),
+        XMVectorSubtract( Patch.vB201, vOrigin ),
+        XMVectorSubtract( Patch.vB021, vOrigin ),
+        XMVectorSubtract( Patch.vB102, vOrigin ),
+        XMVectorSubtract( Patch.vB012, vOrigin ),
+        XMVectorSubtract( Patch.vB111, vOrigin ),
+    };
+    XMVECTOR vQuadraticNormal[6] =
+    {
+        Patch.vN002,
+        Patch.vN020,
+        Patch.vN200,
+        XMVectorScale( Patch.vN110, 0.5f ),
+        XMVectorScale( Patch.vN101, 0.5f ),
+        XMVectorScale( Patch.vN011, 0.5f ),
+    };
+
+    for( UINT uRow = 0; uRow < (UINT)pTessellation->Rows.size(); uRow++ )
+    {
+        const TESS_ROW& Row = pTessellation->Rows[uRow];
+        const XMFLOAT3& f3Step = Row.f3Step;
+        UINT uRowEnd = Row.uFirstPoint + Row.uNumPoints;
+
+        if( Row.uNumPoints < FORWARD_DIFFERENCE_MIN_ROW_POINTS )
+        {
+            for( UINT uPoint = Row.uFirstPoint; uPoint < uRowEnd; uPoint++ )
+            {
+                XMVECTOR vPosition, vNormal;
+                EvaluateDirect( Patch, pDomainPoints[uPoint], &vPosition, &vNormal );
+                StorePoint( uPoint, vPosition, vNormal, pPositions, pNormals );
+            }
+            continue;
+        }
+
+        for( UINT uSeed = Row.uFirstPoint; uSeed < uRowEnd; uSeed += FORWARD_DIFFERENCE_RESEED_INTERVAL )
+        {
+            UINT uEnd = std::min( uRowEnd, uSeed + FORWARD_DIFFERENCE_RESEED_INTERVAL );
+            const XMFLOAT3& f3Start = pDomainPoints[uSeed];
+
+            // Position polynomial from the blossom
+            XMVECTOR vQS[6], vQD[6], vLSS[3], vLSD[3], vLDD[3];
+            CubicDeCasteljauStep( vCubic, f3Start, vQS );
+            CubicDeCasteljauStep( vCubic, f3Step, vQD );
+            QuadraticDeCasteljauStep( vQS, f3Start, vLSS );
+            QuadraticDeCasteljauStep( vQS, f3Step, vLSD );
+            QuadraticDeCasteljauStep( vQD, f3Step, vLDD );
+            XMVECTOR vA0 = LinearDeCasteljauStep( vLSS, f3Start );
+            XMVECTOR vA1 = XMVectorScale( LinearDeCasteljauStep( vLSS, f3Step ), 3.0f );
+            XMVECTOR vA2 = XMVectorScale( LinearDeCasteljauStep( vLSD, f3Step ), 3.0f );
+            XMVECTOR vA3 = LinearDeCasteljauStep( vLDD, f3Step );
+
+            // Normal polynomial b0 + b1 i + b2 i^2
+            XMVECTOR vNS[3], vND[3];
+            QuadraticDeCasteljauStep( vQuadraticNormal, f3Start, vNS );
+            QuadraticDeCasteljauStep( vQuadraticNormal, f3Step, vND );
+            XMVECTOR vB0 = LinearDeCasteljauStep( vNS, f3Start );
+            XMVECTOR vB1 = XMVectorScale( LinearDeCasteljauStep( vNS, f3Step ), 2.0f );
+            XMVECTOR vB2 = LinearDeCasteljauStep( vND, f3Step );
+
+            // Forward differences at the start of the row
+            XMVECTOR vPosition = vA0;
+            XMVECTOR vPositionDelta1 = XMVectorAdd( XMVectorAdd( vA1, vA2 ), vA3 );
+            XMVECTOR vPositionDelta3 = XMVectorScale( vA3, 6.0f );
+            XMVECTOR vPositionDelta2 = XMVectorAdd( XMVectorScale( vA2, 2.0f ), vPositionDelta3 );
+            XMVECTOR vNormal = vB0;
+            XMVECTOR vNormalDelta1 = XMVectorAdd( vB1, vB2 );
+            XMVECTOR vNormalDelta2 = XMVectorScale( vB2, 2.0f );
+
+            for( UINT uPoint = uSeed; uPoint < uEnd; uPoint++ )
+            {
+                StorePoint( uPoint, XMVectorAdd( vPosition, vOrigin ), vNormal, pPositions, pNormals );
+
+                vPosition = XMVectorAdd( vPosition, vPositionDelta1 );
+                vPositionDelta1 = XMVectorAdd( vPositionDelta1, vPositionDelta2 );
+                vPositionDelta2 = XMVectorAdd( vPositionDelta2, vPositionDelta3 );
+
+                vNormal = XMVectorAdd( vNormal, vNormalDelta1 );
+                vNormalDelta1 = XMVectorAdd( vNormalDelta1, vNormalDelta2 );
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+//--------------------------------------------------------------------------------------
+// File: DomainEvaluator.h
+//
+// CPU evaluation of a PN-Triangles patch at every domain point of a tessellation, either
+// directly as DS_PNTriangles does, or with forward differences along the rows of the
+// inner rings, where the barycentric coords step linearly. Along a row the position is a
+// cubic and the unnormalized normal a quadratic of the step, so once their coefficients
+// are set up at the start of a row every point costs a few adds.
+//--------------------------------------------------------------------------------------
+#ifndef DOMAIN_EVALUATOR_H
+#define DOMAIN_EVALUATOR_H
+
+#include "PNTriangles.h"
+#include "TriTessellator.h"
+
+// Forward differences restart from freshly computed coefficients after this many points
+// of a row, which bounds the drift of the accumulated float error
+static const UINT FORWARD_DIFFERENCE_RESEED_INTERVAL = 16;
+
+// Shorter rows are evaluated directly, setting up the differences costs more than it saves
+static const UINT FORWARD_DIFFERENCE_MIN_ROW_POINTS = 4;
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates the patch at every domain point directly. pPositions and pNormals hold one
+// entry per domain point, and either may be NULL.
+//--------------------------------------------------------------------------------------
+void EvaluatePNTessellation( const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints,
+                             const TRI_TESSELLATION* pTessellation,
+                             DirectX::XMFLOAT3* pPositions, DirectX::XMFLOAT3* pNormals );
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates the patch at every domain point, with forward differences along the rows and
+// direct evaluation on the outer transition ring and the short rows
+//--------------------------------------------------------------------------------------
+void EvaluatePNTessellationForwardDifference( const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints,
+                                              const TRI_TESSELLATION* pTessellation,
+                                              DirectX::XMFLOAT3* pPositions, DirectX::XMFLOAT3* pNormals );
+
+#endif
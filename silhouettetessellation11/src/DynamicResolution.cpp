@@ -0,0 +1,247 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: DynamicResolution.cpp
+//
+// Frame time driven controller of the render resolution and tessellation resolution term.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "DynamicResolution.h"
+#include <algorithm>
+
+// Most render scale steps taken at once, when the frame time is far over the budget
+static const float MAX_RENDER_SCALE_STEPS = 4.0f;
+
+
+//--------------------------------------------------------------------------------------
+// Fills the settings the sample uses for a target frame time
+//--------------------------------------------------------------------------------------
+void InitDynamicResolutionSettings( float fTargetMs, DYNAMIC_RESOLUTION_SETTINGS* pSettings )
+{
+    assert( NULL != pSettings );
+
+    pSettings->fTargetMs = fTargetMs;
+    pSettings->fUpperBand = 1.0f;
+    pSettings->fLowerBand = 0.8f;
+    pSettings->uFramesToDecrease = 4;
+    pSettings->uFramesToIncrease = 60;
+    pSettings->uCooldownFrames = 4;
+    pSettings->fFilterWeight = 0.25f;
+    pSettings->fMinRenderScale = 0.5f;
+    pSettings->fRenderScaleStep = 0.05f;
+    pSettings->fMinTessScale = 0.25f;
+    pSettings->fTessScaleStep = 0.25f;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the name of a state for reports
+//--------------------------------------------------------------------------------------
+const WCHAR* GetDynamicResolutionStateName( DYNAMIC_RESOLUTION_STATE State )
+{
+    switch( State )
+    {
+    case DYNAMIC_RESOLUTION_STABLE:         return L"stable";
+    case DYNAMIC_RESOLUTION_OVER_BUDGET:    return L"over budget";
+    case DYNAMIC_RESOLUTION_UNDER_BUDGET:   return L"under budget";
+    case DYNAMIC_RESOLUTION_COOLDOWN:       return L"cooldown";
+    }
+
+    return L"unknown";
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CDynamicResolutionController::CDynamicResolutionController() :
+    m_bTessScaleEnabled( true )
+{
+    InitDynamicResolutionSettings( 1000.0f / 60.0f, &m_Settings );
+    Reset();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CDynamicResolutionController::~CDynamicResolutionController()
+{
+}
+
+
+//--------------------------------------------------------------------------------------
+// Back to full quality with new settings
+//--------------------------------------------------------------------------------------
+void CDynamicResolutionController::Init( const DYNAMIC_RESOLUTION_SETTINGS* pSettings )
+{
+    assert( NULL != pSettings );
+
+    m_Settings = *pSettings;
+    Reset();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Back to full quality
+//--------------------------------------------------------------------------------------
+void CDynamicResolutionController::Reset()
+{
+    m_State = DYNAMIC_RESOLUTION_STABLE;
+    m_fRenderScale = 1.0f;
+    m_fTessScale = 1.0f;
+    m_fFilteredMs = 0.0f;
+    m_bHaveFilteredMs = false;
+    m_uNumOverBudget = 0;
+    m_uNumUnderBudget = 0;
+    m_uCooldown = 0;
+    m_uNumChanges = 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Whether the tess factors have a resolution term to scale
+//--------------------------------------------------------------------------------------
+void CDynamicResolutionController::SetTessScaleEnabled( bool bEnabled )
+{
+    m_bTessScaleEnabled = bEnabled;
+    if( !bEnabled )
+    {
+        m_fTessScale = 1.0f;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Adds the time of a frame. Returns true if the scales changed.
+//--------------------------------------------------------------------------------------
+bool CDynamicResolutionController::Update( float fFrameMs )
+{
+    // The frames after a change were measured with the old scales
+    if( m_uCooldown > 0 )
+    {
+        m_uCooldown--;
+        m_State = DYNAMIC_RESOLUTION_COOLDOWN;
+        return false;
+    }
+
+    if( m_bHaveFilteredMs )
+    {
+        m_fFilteredMs += ( fFrameMs - m_fFilteredMs ) * m_Settings.fFilterWeight;
+    }
+    else
+    {
+        m_fFilteredMs = fFrameMs;
+        m_bHaveFilteredMs = true;
+    }
+
+    bool bChanged = false;
+    if( m_fFilteredMs > m_Settings.fTargetMs * m_Settings.fUpperBand )
+    {
+        m_State = DYNAMIC_RESOLUTION_OVER_BUDGET;
+        m_uNumUnderBudget = 0;
+        if( ++m_uNumOverBudget >= m_Settings.uFramesToDecrease )
+        {
+            bChanged = Decrease();
+        }
+    }
+    else if( m_fFilteredMs < m_Settings.fTargetMs * m_Settings.fLowerBand )
+    {
+        m_State = DYNAMIC_RESOLUTION_UNDER_BUDGET;
+        m_uNumOverBudget = 0;
+        if( ++m_uNumUnderBudget >= m_Settings.uFramesToIncrease )
+        {
+            bChanged = Increase();
+        }
+    }
+    else
+    {
+        m_State = DYNAMIC_RESOLUTION_STABLE;
+        m_uNumOverBudget = 0;
+        m_uNumUnderBudget = 0;
+    }
+
+    if( bChanged )
+    {
+        m_State = DYNAMIC_RESOLUTION_COOLDOWN;
+        m_uNumOverBudget = 0;
+        m_uNumUnderBudget = 0;
+        m_uCooldown = m_Settings.uCooldownFrames;
+        m_bHaveFilteredMs = false;
+        m_uNumChanges++;
+    }
+
+    return bChanged;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Lowers the tessellation, then the resolution. Returns false at the minimums.
+//--------------------------------------------------------------------------------------
+bool CDynamicResolutionController::Decrease()
+{
+    if( m_bTessScaleEnabled && m_fTessScale > m_Settings.fMinTessScale )
+    {
+        m_fTessScale = std::max( m_fTessScale - m_Settings.fTessScaleStep, m_Settings.fMinTessScale );
+        return true;
+    }
+
+    if( m_fRenderScale > m_Settings.fMinRenderScale )
+    {
+        // Pixel cost goes with the square of the scale, so aim for the target in one change
+        // when far over it, a step at a time near it
+        float fScale = m_fRenderScale * sqrtf( m_Settings.fTargetMs / m_fFilteredMs );
+        fScale = std::max( fScale, m_fRenderScale - MAX_RENDER_SCALE_STEPS * m_Settings.fRenderScaleStep );
+        fScale = std::min( fScale, m_fRenderScale - m_Settings.fRenderScaleStep );
+        m_fRenderScale = std::max( fScale, m_Settings.fMinRenderScale );
+        return true;
+    }
+
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Raises the resolution, then the tessellation. Returns false at full quality.
+//--------------------------------------------------------------------------------------
+bool CDynamicResolutionController::Increase()
+{
+    if( m_fRenderScale < 1.0f )
+    {
+        m_fRenderScale = std::min( m_fRenderScale + m_Settings.fRenderScaleStep, 1.0f );
+        return true;
+    }
+
+    if( m_fTessScale < 1.0f )
+    {
+        m_fTessScale = std::min( m_fTessScale + m_Settings.fTessScaleStep, 1.0f );
+        return true;
+    }
+
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,127 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: DynamicResolution.h
+//
+// Frame time driven controller of the render resolution and of the resolution term of
+// the tessellation (RES_ADAPT), holding the scene to a target GPU time. Quality is lowered
+// when the filtered frame time stays over the budget for a few frames, and raised only
+// after it has stayed well under it for many, so a frame time near the target or single
+// spikes don't make it flip back and forth. After each change the frames still measuring
+// the old settings are skipped.
+//
+// Tessellation is lowered first and resolution after it, and resolution is raised first
+// and tessellation after it, as the resolution term of the factors already drops with
+// the pixels rendered. Without RES_ADAPT the tess scale has no effect, so only the
+// resolution changes.
+//--------------------------------------------------------------------------------------
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+struct DYNAMIC_RESOLUTION_SETTINGS
+{
+    float   fTargetMs;
+    float   fUpperBand;         // Over the budget above fTargetMs * fUpperBand
+    float   fLowerBand;         // Under the budget below fTargetMs * fLowerBand
+    UINT    uFramesToDecrease;  // Consecutive frames over the budget before lowering quality
+    UINT    uFramesToIncrease;  // Consecutive frames under the budget before raising it
+    UINT    uCooldownFrames;    // Frames skipped after a change, while the GPU timer catches up
+    float   fFilterWeight;      // Weight of a new frame time in the filtered time
+    float   fMinRenderScale;    // Of the back buffer width and height
+    float   fRenderScaleStep;
+    float   fMinTessScale;      // Of the resolution term of the tess factors
+    float   fTessScaleStep;
+};
+
+enum DYNAMIC_RESOLUTION_STATE
+{
+    DYNAMIC_RESOLUTION_STABLE,
+    DYNAMIC_RESOLUTION_OVER_BUDGET,
+    DYNAMIC_RESOLUTION_UNDER_BUDGET,
+    DYNAMIC_RESOLUTION_COOLDOWN,
+};
+
+
+//--------------------------------------------------------------------------------------
+// Fills the settings the sample uses for a target frame time
+//--------------------------------------------------------------------------------------
+void InitDynamicResolutionSettings( float fTargetMs, DYNAMIC_RESOLUTION_SETTINGS* pSettings );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the name of a state for reports
+//--------------------------------------------------------------------------------------
+const WCHAR* GetDynamicResolutionStateName( DYNAMIC_RESOLUTION_STATE State );
+
+
+//--------------------------------------------------------------------------------------
+// The controller, fed one frame time per frame. It has no device dependency so it can be
+// driven by synthetic frame times.
+//--------------------------------------------------------------------------------------
+class CDynamicResolutionController
+{
+public:
+
+    CDynamicResolutionController();
+    ~CDynamicResolutionController();
+
+    // Back to full quality with new settings
+    void Init( const DYNAMIC_RESOLUTION_SETTINGS* pSettings );
+    void Reset();
+
+    // Keeps the state, e.g. when the target changes from the UI
+    void SetTargetMs( float fTargetMs ) { m_Settings.fTargetMs = fTargetMs; }
+
+    // Whether the tess factors have a resolution term to scale, disabling puts the tess
+    // scale back to 1
+    void SetTessScaleEnabled( bool bEnabled );
+    const DYNAMIC_RESOLUTION_SETTINGS* GetSettings() const { return &m_Settings; }
+
+    // Adds the time of a frame. Returns true if the scales changed.
+    bool Update( float fFrameMs );
+
+    float GetRenderScale() const { return m_fRenderScale; }
+    float GetTessScale() const { return m_fTessScale; }
+    float GetFilteredMs() const { return m_fFilteredMs; }
+    DYNAMIC_RESOLUTION_STATE GetState() const { return m_State; }
+    UINT GetNumChanges() const { return m_uNumChanges; }
+
+private:
+
+    bool Decrease();
+    bool Increase();
+
+    DYNAMIC_RESOLUTION_SETTINGS     m_Settings;
+    DYNAMIC_RESOLUTION_STATE        m_State;
+    float                           m_fRenderScale;
+    float                           m_fTessScale;
+    bool                            m_bTessScaleEnabled;
+    float                           m_fFilteredMs;
+    bool                            m_bHaveFilteredMs;
+    UINT                            m_uNumOverBudget;
+    UINT                            m_uNumUnderBudget;
+    UINT                            m_uCooldown;
+    UINT                            m_uNumChanges;
+};
+
+#endif
@@ -0,0 +1,348 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: InstanceSet.cpp
+//
+// Copies of one mesh, culled and binned by tess factor tier on the CPU.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "InstanceSet.h"
+#include "TessPath.h"
+#include <algorithm>
+#include <float.h>
+#include <immintrin.h>
+
+using namespace DirectX;
+
+// Lanes the sphere arrays are padded to, for AVX
+static const UINT INSTANCE_LANES = 8;
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CInstanceSet::CInstanceSet() :
+    m_f3BoxCenter( 0.0f, 0.0f, 0.0f ),
+    m_f3BoxExtents( 0.0f, 0.0f, 0.0f ),
+    m_SIMD( OCCLUSION_SIMD_SCALAR ),
+    m_uNumThresholds( 0 )
+{
+    ZeroMemory( m_fPlanes, sizeof( m_fPlanes ) );
+    ZeroMemory( m_fDepth, sizeof( m_fDepth ) );
+    ZeroMemory( m_fThresholds, sizeof( m_fThresholds ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Removes the instances and sets the bounds of the mesh
+//--------------------------------------------------------------------------------------
+void CInstanceSet::Init( FXMVECTOR vBoxCenter, FXMVECTOR vBoxExtents )
+{
+    XMStoreFloat3( &m_f3BoxCenter, vBoxCenter );
+    XMStoreFloat3( &m_f3BoxExtents, vBoxExtents );
+
+    m_fCenterX.clear();
+    m_fCenterY.clear();
+    m_fCenterZ.clear();
+    m_fRadius.clear();
+    m_WorldMatrices.clear();
+    m_InstanceBins.clear();
+    m_BinnedInstances.clear();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Adds an instance, growing the sphere arrays by a whole number of lanes
+//--------------------------------------------------------------------------------------
+void CInstanceSet::AddInstance( CXMMATRIX mWorld )
+{
+    UINT uInstance = GetNumInstances();
+    if( uInstance == (UINT)m_fRadius.size() )
+    {
+        // Padding spheres with a radius no plane test passes
+        m_fCenterX.resize( uInstance + INSTANCE_LANES, 0.0f );
+        m_fCenterY.resize( uInstance + INSTANCE_LANES, 0.0f );
+        m_fCenterZ.resize( uInstance + INSTANCE_LANES, 0.0f );
+        m_fRadius.resize( uInstance + INSTANCE_LANES, -FLT_MAX );
+    }
+
+    XMVECTOR vCenter;
+    float fRadius;
+    GetWorldBoundingSphere( XMLoadFloat3( &m_f3BoxCenter ), XMLoadFloat3( &m_f3BoxExtents ), mWorld, &vCenter, &fRadius );
+    m_fCenterX[uInstance] = XMVectorGetX( vCenter );
+    m_fCenterY[uInstance] = XMVectorGetY( vCenter );
+    m_fCenterZ[uInstance] = XMVectorGetZ( vCenter );
+    m_fRadius[uInstance] = fRadius;
+
+    XMFLOAT4X4 f4x4World;
+    XMStoreFloat4x4( &f4x4World, mWorld );
+    m_WorldMatrices.push_back( f4x4World );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Culls the instances to the frustum and bins the visible ones by projected diameter
+//--------------------------------------------------------------------------------------
+void CInstanceSet::CullAndBin( CXMMATRIX mView, CXMMATRIX mProj, float fScreenHeight, float fEyeSeparation,
+                               const INSTANCE_BIN_SETTINGS* pSettings, INSTANCE_BINS* pBins )
+{
+    assert( NULL != pSettings );
+    assert( NULL != pBins );
+    assert( pSettings->uNumTessTiers > 0 && pSettings->uNumTessTiers < INSTANCE_MAX_BINS );
+    assert( fEyeSeparation >= 0.0f );
+
+    // The planes of the frustum from the columns of the view projection matrix: left,
+    // right, bottom, top, near (z >= 0) and far, normalized so the distance to them
+    // compares to the radius
+    static const UINT uPlaneColumns[6] = { 0, 0, 1, 1, 2, 2 };
+    static const float fPlaneSigns[6] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+    static const float fPlaneW[6] = { 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f };
+    XMFLOAT4X4 f4x4ViewProj;
+    XMStoreFloat4x4( &f4x4ViewProj, XMMatrixMultiply( mView, mProj ) );
+    XMFLOAT4X4 f4x4View;
+    XMStoreFloat4x4( &f4x4View, mView );
+    for( UINT uPlane = 0; uPlane < 6; uPlane++ )
+    {
+        float fPlane[4];
+        for( UINT uRow = 0; uRow < 4; uRow++ )
+        {
+            fPlane[uRow] = fPlaneW[uPlane] * f4x4ViewProj.m[uRow][3] + fPlaneSigns[uPlane] * f4x4ViewProj.m[uRow][uPlaneColumns[uPlane]];
+        }
+        XMVECTOR vPlane = XMPlaneNormalize( XMVectorSet( fPlane[0], fPlane[1], fPlane[2], fPlane[3] ) );
+        m_fPlanes[uPlane][0] = XMVectorGetX( vPlane );
+        m_fPlanes[uPlane][1] = XMVectorGetY( vPlane );
+        m_fPlanes[uPlane][2] = XMVectorGetZ( vPlane );
+        m_fPlanes[uPlane][3] = XMVectorGetW( vPlane );
+
+        // An eye frustum spans x in [-w/2, w/2] of the center one at a view depth where
+        // that spans [-w, w], shifted by half the separation, so the center planes pushed
+        // out along the view x axis by that much hold both eyes. The top, bottom, near and
+        // far planes have no x in view space, so they stay.
+        float fRightDot = m_fPlanes[uPlane][0] * f4x4View._11 + m_fPlanes[uPlane][1] * f4x4View._21 + m_fPlanes[uPlane][2] * f4x4View._31;
+        m_fPlanes[uPlane][3] += 0.5f * fEyeSeparation * fabsf( fRightDot );
+    }
+
+    // View depth, the third column of the view matrix
+    m_fDepth[0] = f4x4View._13;
+    m_fDepth[1] = f4x4View._23;
+    m_fDepth[2] = f4x4View._33;
+    m_fDepth[3] = f4x4View._43;
+
+    // The diameter of a sphere is fRadius * fScale / fDepth pixels, so an instance passes
+    // threshold b with fRadius >= m_fThresholds[b] * fDepth. The last threshold is the
+    // min diameter.
+    float fScale = XMVectorGetY( mProj.r[1] ) * fScreenHeight;
+    float fFullDiameter = std::max( pSettings->fFullDiameter, pSettings->fMinDiameter );
+    m_uNumThresholds = pSettings->uNumTessTiers;
+    for( UINT uBin = 0; uBin < m_uNumThresholds; uBin++ )
+    {
+        float fDiameter = ( uBin + 1 < m_uNumThresholds ) ? std::max( ldexpf( fFullDiameter, -(int)uBin ), pSettings->fMinDiameter )
+                                                         : pSettings->fMinDiameter;
+        m_fThresholds[uBin] = fDiameter / fScale;
+    }
+
+    // Bin of each instance
+    UINT uNumLanes = (UINT)m_fRadius.size();
+    m_InstanceBins.resize( uNumLanes );
+    switch( m_SIMD )
+    {
+    case OCCLUSION_SIMD_AVX:
+        CullAndBinAVX( 0, uNumLanes, m_InstanceBins.empty() ? NULL : &m_InstanceBins[0] );
+        break;
+    case OCCLUSION_SIMD_SSE:
+        CullAndBinSSE( 0, uNumLanes, m_InstanceBins.empty() ? NULL : &m_InstanceBins[0] );
+        break;
+    default:
+        CullAndBinScalar( 0, uNumLanes, m_InstanceBins.empty() ? NULL : &m_InstanceBins[0] );
+        break;
+    }
+
+    // Counting sort of the visible instances into their bins, keeping the instance order
+    // within a bin. Slot 0 counts the culled instances and writes them all to one spare
+    // element past the visible ones, so neither pass branches on the visibility.
+    UINT uCounts[INSTANCE_MAX_BINS + 1] = { 0 };
+    for( UINT uInstance = 0; uInstance < GetNumInstances(); uInstance++ )
+    {
+        uCounts[m_InstanceBins[uInstance] + 1]++;
+    }
+
+    ZeroMemory( pBins, sizeof( INSTANCE_BINS ) );
+    pBins->uNumBins = m_uNumThresholds + 1;
+    UINT uNext[INSTANCE_MAX_BINS + 1];
+    UINT uSteps[INSTANCE_MAX_BINS + 1];
+    for( UINT uBin = 0; uBin < pBins->uNumBins; uBin++ )
+    {
+        pBins->uFirst[uBin] = pBins->uNumVisible;
+        pBins->uCount[uBin] = uCounts[uBin + 1];
+        pBins->fTessFactor[uBin] = ( uBin < m_uNumThresholds ) ? std::max( ldexpf( pSettings->fMaxTessFactor, -(int)uBin ), 1.0f ) : 0.0f;
+        uNext[uBin + 1] = pBins->uNumVisible;
+        uSteps[uBin + 1] = 1;
+        pBins->uNumVisible += pBins->uCount[uBin];
+    }
+    uNext[0] = pBins->uNumVisible;
+    uSteps[0] = 0;
+
+    m_BinnedInstances.resize( pBins->uNumVisible + 1 );
+    for( UINT uInstance = 0; uInstance < GetNumInstances(); uInstance++ )
+    {
+        int iSlot = m_InstanceBins[uInstance] + 1;
+        m_BinnedInstances[uNext[iSlot]] = uInstance;
+        uNext[iSlot] += uSteps[iSlot];
+    }
+    m_BinnedInstances.resize( pBins->uNumVisible );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Writes the world matrices of the binned instances
+//--------------------------------------------------------------------------------------
+void CInstanceSet::WriteWorldMatrices( XMFLOAT4X4* pDest ) const
+{
+    assert( NULL != pDest || m_BinnedInstances.empty() );
+
+    for( UINT i = 0; i < (UINT)m_BinnedInstances.size(); i++ )
+    {
+        pDest[i] = m_WorldMatrices[m_BinnedInstances[i]];
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Culls and bins one instance at a time. The SIMD paths do the same operations in the
+// same order, so they bin the same.
+//--------------------------------------------------------------------------------------
+void CInstanceSet::CullAndBinScalar( UINT uFirst, UINT uCount, int* piBins ) const
+{
+    for( UINT i = uFirst; i < uFirst + uCount; i++ )
+    {
+        float fX = m_fCenterX[i], fY = m_fCenterY[i], fZ = m_fCenterZ[i], fRadius = m_fRadius[i];
+
+        bool bVisible = true;
+        for( UINT uPlane = 0; uPlane < 6; uPlane++ )
+        {
+            const float* pfPlane = m_fPlanes[uPlane];
+            float fDistance = pfPlane[0] * fX + pfPlane[1] * fY + pfPlane[2] * fZ + pfPlane[3] + fRadius;
+            bVisible = bVisible && ( fDistance >= 0.0f );
+        }
+
+        float fDepth = m_fDepth[0] * fX + m_fDepth[1] * fY + m_fDepth[2] * fZ + m_fDepth[3];
+        int iBin = 0;
+        for( UINT uThreshold = 0; uThreshold < m_uNumThresholds; uThreshold++ )
+        {
+            iBin += ( fRadius < m_fThresholds[uThreshold] * fDepth ) ? 1 : 0;
+        }
+
+        piBins[i - uFirst] = bVisible ? iBin : -1;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Culls and bins 4 instances at a time
+//--------------------------------------------------------------------------------------
+void CInstanceSet::CullAndBinSSE( UINT uFirst, UINT uCount, int* piBins ) const
+{
+    assert( 0 == uCount % 4 );
+
+    __m128 vZero = _mm_setzero_ps();
+    __m128 vOne = _mm_set1_ps( 1.0f );
+    __m128 vCulled = _mm_set1_ps( -1.0f );
+
+    for( UINT i = uFirst; i < uFirst + uCount; i += 4 )
+    {
+        __m128 vX = _mm_loadu_ps( &m_fCenterX[i] );
+        __m128 vY = _mm_loadu_ps( &m_fCenterY[i] );
+        __m128 vZ = _mm_loadu_ps( &m_fCenterZ[i] );
+        __m128 vRadius = _mm_loadu_ps( &m_fRadius[i] );
+
+        __m128 vVisible = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+        for( UINT uPlane = 0; uPlane < 6; uPlane++ )
+        {
+            const float* pfPlane = m_fPlanes[uPlane];
+            __m128 vDistance = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( pfPlane[0] ), vX ), _mm_mul_ps( _mm_set1_ps( pfPlane[1] ), vY ) );
+            vDistance = _mm_add_ps( vDistance, _mm_mul_ps( _mm_set1_ps( pfPlane[2] ), vZ ) );
+            vDistance = _mm_add_ps( _mm_add_ps( vDistance, _mm_set1_ps( pfPlane[3] ) ), vRadius );
+            vVisible = _mm_and_ps( vVisible, _mm_cmpge_ps( vDistance, vZero ) );
+        }
+
+        __m128 vDepth = _mm_add_ps( _mm_mul_ps( _mm_set1_ps( m_fDepth[0] ), vX ), _mm_mul_ps( _mm_set1_ps( m_fDepth[1] ), vY ) );
+        vDepth = _mm_add_ps( _mm_add_ps( vDepth, _mm_mul_ps( _mm_set1_ps( m_fDepth[2] ), vZ ) ), _mm_set1_ps( m_fDepth[3] ) );
+        __m128 vBin = vZero;
+        for( UINT uThreshold = 0; uThreshold < m_uNumThresholds; uThreshold++ )
+        {
+            __m128 vLess = _mm_cmplt_ps( vRadius, _mm_mul_ps( _mm_set1_ps( m_fThresholds[uThreshold] ), vDepth ) );
+            vBin = _mm_add_ps( vBin, _mm_and_ps( vLess, vOne ) );
+        }
+
+        vBin = _mm_or_ps( _mm_and_ps( vVisible, vBin ), _mm_andnot_ps( vVisible, vCulled ) );
+        _mm_storeu_si128( (__m128i*)&piBins[i - uFirst], _mm_cvttps_epi32( vBin ) );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Culls and bins 8 instances at a time
+//--------------------------------------------------------------------------------------
+void CInstanceSet::CullAndBinAVX( UINT uFirst, UINT uCount, int* piBins ) const
+{
+    assert( 0 == uCount % 8 );
+
+    __m256 vZero = _mm256_setzero_ps();
+    __m256 vOne = _mm256_set1_ps( 1.0f );
+    __m256 vCulled = _mm256_set1_ps( -1.0f );
+
+    for( UINT i = uFirst; i < uFirst + uCount; i += 8 )
+    {
+        __m256 vX = _mm256_loadu_ps( &m_fCenterX[i] );
+        __m256 vY = _mm256_loadu_ps( &m_fCenterY[i] );
+        __m256 vZ = _mm256_loadu_ps( &m_fCenterZ[i] );
+        __m256 vRadius = _mm256_loadu_ps( &m_fRadius[i] );
+
+        __m256 vVisible = _mm256_cmp_ps( vZero, vZero, _CMP_EQ_OQ );
+        for( UINT uPlane = 0; uPlane < 6; uPlane++ )
+        {
+            const float* pfPlane = m_fPlanes[uPlane];
+            __m256 vDistance = _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( pfPlane[0] ), vX ), _mm256_mul_ps( _mm256_set1_ps( pfPlane[1] ), vY ) );
+            vDistance = _mm256_add_ps( vDistance, _mm256_mul_ps( _mm256_set1_ps( pfPlane[2] ), vZ ) );
+            vDistance = _mm256_add_ps( _mm256_add_ps( vDistance, _mm256_set1_ps( pfPlane[3] ) ), vRadius );
+            vVisible = _mm256_and_ps( vVisible, _mm256_cmp_ps( vDistance, vZero, _CMP_GE_OQ ) );
+        }
+
+        __m256 vDepth = _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( m_fDepth[0] ), vX ), _mm256_mul_ps( _mm256_set1_ps( m_fDepth[1] ), vY ) );
+        vDepth = _mm256_add_ps( _mm256_add_ps( vDepth, _mm256_mul_ps( _mm256_set1_ps( m_fDepth[2] ), vZ ) ), _mm256_set1_ps( m_fDepth[3] ) );
+        __m256 vBin = vZero;
+        for( UINT uThreshold = 0; uThreshold < m_uNumThresholds; uThreshold++ )
+        {
+            __m256 vLess = _mm256_cmp_ps( vRadius, _mm256_mul_ps( _mm256_set1_ps( m_fThresholds[uThreshold] ), vDepth ), _CMP_LT_OQ );
+            vBin = _mm256_add_ps( vBin, _mm256_and_ps( vLess, vOne ) );
+        }
+
+        vBin = _mm256_blendv_ps( vCulled, vBin, vVisible );
+        _mm256_storeu_si256( (__m256i*)&piBins[i - uFirst], _mm256_cvttps_epi32( vBin ) );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: InstanceSet.h
+//
+// Copies of one mesh drawn with one instanced draw per bin of instances. The bounding
+// spheres of the instances are kept as a structure of arrays, so the frustum test and the
+// tess factor tier of 4 or 8 instances are computed at once with SSE or AVX. The visible
+// instances are binned by the projected diameter of their sphere, and their world
+// matrices are written bin after bin, for the vertex shaders (INSTANCED) to read from
+// the first instance of the bin on.
+//--------------------------------------------------------------------------------------
+#ifndef INSTANCE_SET_H
+#define INSTANCE_SET_H
+
+#include "OcclusionBuffer.h"
+#include <vector>
+
+// Bins of the tess factor tiers, and the bin drawn without tessellation after them
+static const UINT INSTANCE_MAX_BINS = 8;
+
+// Diameter in pixels at and above which an instance is drawn with the full tess factor.
+// Each next tier halves the diameter and the tess factor.
+static const float INSTANCE_FULL_DIAMETER = 512.0f;
+
+// Default tiers of tessellated instances
+static const UINT INSTANCE_NUM_TESS_TIERS = 3;
+
+// Instances per side of the instance grid of the sample, and the spacing of the grid in
+// diagonals of the mesh bounds
+static const UINT INSTANCE_GRID_SIZE = 65;
+static const float INSTANCE_GRID_SPACING = 1.5f;
+
+struct INSTANCE_BIN_SETTINGS
+{
+    float   fFullDiameter;      // In pixels, see INSTANCE_FULL_DIAMETER
+    float   fMinDiameter;       // In pixels, below which instances are drawn without tessellation
+    UINT    uNumTessTiers;      // Bins of tessellated instances, at most INSTANCE_MAX_BINS - 1
+    float   fMaxTessFactor;     // Tess factor of the first tier
+};
+
+// The visible instances of each bin are uFirst[b] to uFirst[b] + uCount[b] - 1 in the
+// binned order. The last bin holds the instances drawn without tessellation.
+struct INSTANCE_BINS
+{
+    UINT    uNumBins;
+    UINT    uNumVisible;
+    UINT    uFirst[INSTANCE_MAX_BINS];
+    UINT    uCount[INSTANCE_MAX_BINS];
+    float   fTessFactor[INSTANCE_MAX_BINS];     // 0 for the bin without tessellation
+};
+
+
+//--------------------------------------------------------------------------------------
+// Instances of one mesh, with the bounding sphere of the mesh moved by each world matrix
+//--------------------------------------------------------------------------------------
+class CInstanceSet
+{
+public:
+
+    CInstanceSet();
+
+    // Removes the instances and sets the bounding box of the mesh, in object space
+    void Init( DirectX::FXMVECTOR vBoxCenter, DirectX::FXMVECTOR vBoxExtents );
+
+    void AddInstance( DirectX::CXMMATRIX mWorld );
+    UINT GetNumInstances() const { return (UINT)m_WorldMatrices.size(); }
+
+    void SetSIMD( OCCLUSION_SIMD SIMD ) { m_SIMD = SIMD; }
+    OCCLUSION_SIMD GetSIMD() const { return m_SIMD; }
+
+    // Culls the instances to the frustum of mView * mProj and bins the visible ones by
+    // the diameter in pixels of their sphere, from its view depth and a perspective
+    // projection, so it is exact on the view axis only. Every code path bins the same.
+    // With a stereo pair fEyeSeparation apart on the view x axis, each eye seeing half
+    // the width, the side planes move out by half of it so the frustum holds both eyes.
+    void CullAndBin( DirectX::CXMMATRIX mView, DirectX::CXMMATRIX mProj, float fScreenHeight, float fEyeSeparation,
+                     const INSTANCE_BIN_SETTINGS* pSettings, INSTANCE_BINS* pBins );
+
+    // The instances of the last CullAndBin, bin after bin
+    const UINT* GetBinnedInstances() const { return m_BinnedInstances.empty() ? NULL : &m_BinnedInstances[0]; }
+
+    // Writes the world matrices of the binned instances, pDest holds uNumVisible of them
+    void WriteWorldMatrices( DirectX::XMFLOAT4X4* pDest ) const;
+
+private:
+
+    // Returns the frustum test and bin of the instances from uFirst on, a whole number of
+    // lanes, in piBins, -1 for culled instances
+    void CullAndBinScalar( UINT uFirst, UINT uCount, int* piBins ) const;
+    void CullAndBinSSE( UINT uFirst, UINT uCount, int* piBins ) const;
+    void CullAndBinAVX( UINT uFirst, UINT uCount, int* piBins ) const;
+
+    DirectX::XMFLOAT3                   m_f3BoxCenter;
+    DirectX::XMFLOAT3                   m_f3BoxExtents;
+    OCCLUSION_SIMD                      m_SIMD;
+
+    // Spheres, padded to a multiple of 8 with ones no plane passes
+    std::vector<float>                  m_fCenterX;
+    std::vector<float>                  m_fCenterY;
+    std::vector<float>                  m_fCenterZ;
+    std::vector<float>                  m_fRadius;
+    std::vector<DirectX::XMFLOAT4X4>    m_WorldMatrices;
+
+    // Of the current CullAndBin: the planes (x, y, z and w of each), the view depth row
+    // and the diameter thresholds scaled by the projection, per lane
+    float                               m_fPlanes[6][4];
+    float                               m_fDepth[4];
+    float                               m_fThresholds[INSTANCE_MAX_BINS - 1];
+    UINT                                m_uNumThresholds;
+
+    std::vector<int>                    m_InstanceBins;
+    std::vector<UINT>                   m_BinnedInstances;
+};
+
+#endif
@@ -0,0 +1,352 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: MeshBake.cpp
+//
+// Bakes uniformly tessellated meshes.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "MeshBake.h"
+#include "VertexCache.h"
+#include <float.h>
+#include <map>
+
+using namespace DirectX;
+
+// Corner of the patch each side of the outer ring starts from. The sides run A->B, B->C
+// and C->A, where A (U == 1) is corner 1, B (V == 1) corner 2 and C (W == 1) corner 0.
+static const UINT SIDE_START_CORNER[3] = { 1, 2, 0 };
+
+// Vertices of a mesh of the baked data, and its subsets
+struct MESH_BAKE_RANGE
+{
+    UINT uMesh;
+    UINT uFirstVertex;
+    UINT uFirstSubset;
+    UINT uNumSubsets;
+};
+
+// Orders vertices by mesh, then by their bytes, so equal vertices of a mesh are adjacent
+struct MESH_BAKE_VERTEX_LESS
+{
+    const PN_VERTEX*    pVertices;
+    const UINT*         pVertexMeshes;
+
+    bool operator()( UINT uA, UINT uB ) const
+    {
+        if( pVertexMeshes[uA] != pVertexMeshes[uB] )
+        {
+            return pVertexMeshes[uA] < pVertexMeshes[uB];
+        }
+        return memcmp( &pVertices[uA], &pVertices[uB], sizeof( PN_VERTEX ) ) < 0;
+    }
+};
+
+
+//--------------------------------------------------------------------------------------
+// Maps every vertex to the first of the vertices of its mesh it is identical to, so
+// patches that share a corner by value also share its tessellated edges
+//--------------------------------------------------------------------------------------
+static void GetCanonicalVertices( const MESH_DATA* pSource, std::vector<UINT>* pCanonical )
+{
+    UINT uNumVertices = (UINT)pSource->Vertices.size();
+
+    std::vector<UINT> VertexMeshes( uNumVertices, UINT_MAX );
+    for( UINT s = 0; s < pSource->Subsets.size(); s++ )
+    {
+        const MESH_DATA_SUBSET& Subset = pSource->Subsets[s];
+        for( UINT i = Subset.uIndexStart; i < Subset.uIndexStart + Subset.uIndexCount; i++ )
+        {
+            VertexMeshes[pSource->Indices[i]] = Subset.uMesh;
+        }
+    }
+
+    std::vector<UINT> Order( uNumVertices );
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        Order[v] = v;
+    }
+
+    MESH_BAKE_VERTEX_LESS Less;
+    Less.pVertices = &pSource->Vertices[0];
+    Less.pVertexMeshes = &VertexMeshes[0];
+    std::stable_sort( Order.begin(), Order.end(), Less );
+
+    pCanonical->resize( uNumVertices );
+    for( UINT i = 0; i < uNumVertices; i++ )
+    {
+        bool bSameAsPrevious = ( i > 0 ) && !Less( Order[i - 1], Order[i] );
+        (*pCanonical)[Order[i]] = bSameAsPrevious ? (*pCanonical)[Order[i - 1]] : Order[i];
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the ACMR of all the subsets together
+//--------------------------------------------------------------------------------------
+static float ComputeMeshDataACMR( const MESH_DATA* pMeshData )
+{
+    double dMisses = 0.0;
+    UINT uNumTris = 0;
+    for( UINT s = 0; s < pMeshData->Subsets.size(); s++ )
+    {
+        const MESH_DATA_SUBSET& Subset = pMeshData->Subsets[s];
+        UINT uSubsetTris = Subset.uIndexCount / 3;
+        if( uSubsetTris > 0 )
+        {
+            dMisses += ComputeACMR( &pMeshData->Indices[Subset.uIndexStart], Subset.uIndexCount, VERTEX_CACHE_MEASURE_SIZE ) * (double)uSubsetTris;
+            uNumTris += uSubsetTris;
+        }
+    }
+
+    return ( uNumTris > 0 ) ? (float)( dMisses / (double)uNumTris ) : 0.0f;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Optimizes the triangle order of each subset of a mesh for the vertex cache, then the
+// order of the mesh's vertices for fetching
+//--------------------------------------------------------------------------------------
+static void OptimizeBakedMesh( const MESH_BAKE_RANGE& Range, UINT uNumVertices, MESH_DATA* pBaked )
+{
+    if( 0 == Range.uNumSubsets )
+    {
+        return;
+    }
+
+    // The subsets of a mesh are consecutive, so are their indices
+    UINT uIndexStart = pBaked->Subsets[Range.uFirstSubset].uIndexStart;
+    UINT uIndexEnd = uIndexStart;
+    for( UINT s = Range.uFirstSubset; s < Range.uFirstSubset + Range.uNumSubsets; s++ )
+    {
+        const MESH_DATA_SUBSET& Subset = pBaked->Subsets[s];
+        assert( Subset.uIndexStart == uIndexEnd );
+        uIndexEnd += Subset.uIndexCount;
+    }
+
+    UINT* pIndices = &pBaked->Indices[uIndexStart];
+    UINT uNumIndices = uIndexEnd - uIndexStart;
+    for( UINT i = 0; i < uNumIndices; i++ )
+    {
+        pIndices[i] -= Range.uFirstVertex;
+    }
+
+    for( UINT s = Range.uFirstSubset; s < Range.uFirstSubset + Range.uNumSubsets; s++ )
+    {
+        const MESH_DATA_SUBSET& Subset = pBaked->Subsets[s];
+        OptimizeVertexCache( &pBaked->Indices[Subset.uIndexStart], Subset.uIndexCount, uNumVertices );
+    }
+
+    std::vector<UINT> Remap( uNumVertices );
+    UINT uNumUsed = OptimizeVertexFetch( pIndices, uNumIndices, uNumVertices, &Remap[0] );
+    assert( uNumUsed == uNumVertices );
+    (void)uNumUsed;
+
+    std::vector<PN_VERTEX> Vertices( pBaked->Vertices.begin() + Range.uFirstVertex,
+                                     pBaked->Vertices.begin() + Range.uFirstVertex + uNumVertices );
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        pBaked->Vertices[Range.uFirstVertex + Remap[v]] = Vertices[v];
+    }
+
+    for( UINT i = 0; i < uNumIndices; i++ )
+    {
+        pIndices[i] += Range.uFirstVertex;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Tessellates every triangle of pSource at a uniform factor into pBaked
+//--------------------------------------------------------------------------------------
+HRESULT BakeTessellatedMeshData( const MESH_DATA* pSource, CPU_TESS_TECHNIQUE Technique, float fTessFactor,
+                                 MESH_DATA* pBaked, MESH_BAKE_STATS* pStats )
+{
+    assert( NULL != pSource );
+    assert( NULL != pBaked );
+
+    pBaked->Vertices.clear();
+    pBaked->Indices.clear();
+    pBaked->Subsets.clear();
+
+    if( !( fTessFactor >= TESS_MIN_FACTOR ) || pSource->Vertices.empty() )
+    {
+        return E_INVALIDARG;
+    }
+
+    // All the patches share the same pattern, with the same number of segments per side
+    float fEdgeFactors[3] = { fTessFactor, fTessFactor, fTessFactor };
+    TRI_TESSELLATION Pattern;
+    TessellateTri( fEdgeFactors, fTessFactor, &Pattern );
+
+    UINT uNumPoints = (UINT)Pattern.DomainPoints.size();
+    UINT uNumSideSegments = Pattern.uNumTransitionPoints / 3;
+    std::vector<PN_VERTEX> PatchVertices( uNumPoints );
+    std::vector<UINT> PointVertices( uNumPoints );
+
+    std::vector<UINT> Canonical;
+    GetCanonicalVertices( pSource, &Canonical );
+
+    // Baked vertex of each source corner, and the first baked vertex of the points inside
+    // each edge, stored in order from the lower canonical corner
+    std::vector<UINT> CornerVertices( pSource->Vertices.size(), UINT_MAX );
+    std::map<UINT64, UINT> EdgeVertices;
+
+    std::vector<MESH_BAKE_RANGE> Ranges;
+    UINT uNumPatches = 0;
+
+    for( UINT s = 0; s < pSource->Subsets.size(); s++ )
+    {
+        const MESH_DATA_SUBSET& Subset = pSource->Subsets[s];
+
+        // Each mesh gets its own range of vertices
+        if( Ranges.empty() || Ranges.back().uMesh != Subset.uMesh )
+        {
+            for( UINT r = 0; r < Ranges.size(); r++ )
+            {
+                if( Ranges[r].uMesh == Subset.uMesh )
+                {
+                    return E_INVALIDARG;
+                }
+            }
+
+            MESH_BAKE_RANGE Range = { Subset.uMesh, (UINT)pBaked->Vertices.size(), s, 0 };
+            Ranges.push_back( Range );
+        }
+        Ranges.back().uNumSubsets++;
+
+        MESH_DATA_SUBSET BakedSubset = Subset;
+        BakedSubset.uIndexStart = (UINT)pBaked->Indices.size();
+
+        for( UINT t = 0; t < Subset.uIndexCount / 3; t++ )
+        {
+            const UINT* pTri = &pSource->Indices[Subset.uIndexStart + t * 3];
+            PN_VERTEX Corners[3] = { pSource->Vertices[pTri[0]], pSource->Vertices[pTri[1]], pSource->Vertices[pTri[2]] };
+            UINT uCanonical[3] = { Canonical[pTri[0]], Canonical[pTri[1]], Canonical[pTri[2]] };
+
+            PN_CONTROL_POINTS ControlPoints;
+            if( CPU_TESS_PN_TRIANGLES == Technique )
+            {
+                ComputePNControlPoints( Corners, &ControlPoints );
+            }
+            EvaluatePatchVertices( Technique, Corners, &ControlPoints, &Pattern, &PatchVertices[0] );
+            uNumPatches++;
+
+            // Points of the outer ring are shared with the neighbours
+            bool bOwnsSide[3] = { false, false, false };
+            for( UINT i = 0; i < Pattern.uNumTransitionPoints; i++ )
+            {
+                UINT uSide = i / uNumSideSegments;
+                UINT uStep = i % uNumSideSegments;
+                UINT uStart = uCanonical[SIDE_START_CORNER[uSide]];
+                UINT uEnd = uCanonical[SIDE_START_CORNER[( uSide + 1 ) % 3]];
+
+                UINT* puVertex = NULL;
+                if( 0 == uStep )
+                {
+                    puVertex = &CornerVertices[uStart];
+                    if( UINT_MAX == *puVertex )
+                    {
+                        *puVertex = (UINT)pBaked->Vertices.size();
+                        pBaked->Vertices.push_back( PatchVertices[i] );
+                    }
+                    PointVertices[i] = *puVertex;
+                    continue;
+                }
+
+                if( uStart == uEnd )
+                {
+                    // Degenerate edge, nothing to share
+                    PointVertices[i] = (UINT)pBaked->Vertices.size();
+                    pBaked->Vertices.push_back( PatchVertices[i] );
+                    continue;
+                }
+
+                // Partitioning is symmetric, so step k from one end is step n - k from the other
+                UINT64 uKey = ( (UINT64)std::min( uStart, uEnd ) << 32 ) | std::max( uStart, uEnd );
+                UINT uStepFromLower = ( uStart < uEnd ) ? uStep : uNumSideSegments - uStep;
+                if( 1 == uStep && EdgeVertices.find( uKey ) == EdgeVertices.end() )
+                {
+                    EdgeVertices[uKey] = (UINT)pBaked->Vertices.size();
+                    pBaked->Vertices.resize( pBaked->Vertices.size() + uNumSideSegments - 1 );
+                    bOwnsSide[uSide] = true;
+                }
+
+                PointVertices[i] = EdgeVertices[uKey] + uStepFromLower - 1;
+                if( bOwnsSide[uSide] )
+                {
+                    pBaked->Vertices[PointVertices[i]] = PatchVertices[i];
+                }
+            }
+
+            // Inner points belong to the patch
+            for( UINT i = Pattern.uNumTransitionPoints; i < uNumPoints; i++ )
+            {
+                PointVertices[i] = (UINT)pBaked->Vertices.size();
+                pBaked->Vertices.push_back( PatchVertices[i] );
+            }
+
+            for( UINT i = 0; i < Pattern.Indices.size(); i++ )
+            {
+                pBaked->Indices.push_back( PointVertices[Pattern.Indices[i]] );
+            }
+        }
+
+        BakedSubset.uIndexCount = (UINT)pBaked->Indices.size() - BakedSubset.uIndexStart;
+        pBaked->Subsets.push_back( BakedSubset );
+    }
+
+    float fACMRBefore = ComputeMeshDataACMR( pBaked );
+
+    for( UINT r = 0; r < Ranges.size(); r++ )
+    {
+        UINT uRangeEnd = ( r + 1 < Ranges.size() ) ? Ranges[r + 1].uFirstVertex : (UINT)pBaked->Vertices.size();
+        OptimizeBakedMesh( Ranges[r], uRangeEnd - Ranges[r].uFirstVertex, pBaked );
+    }
+
+    XMVECTOR vMin = XMVectorReplicate( FLT_MAX );
+    XMVECTOR vMax = XMVectorReplicate( -FLT_MAX );
+    for( UINT v = 0; v < pBaked->Vertices.size(); v++ )
+    {
+        XMVECTOR vPosition = XMLoadFloat3( &pBaked->Vertices[v].f3Position );
+        vMin = XMVectorMin( vMin, vPosition );
+        vMax = XMVectorMax( vMax, vPosition );
+    }
+    XMStoreFloat3( &pBaked->f3BoundsMin, vMin );
+    XMStoreFloat3( &pBaked->f3BoundsMax, vMax );
+
+    if( NULL != pStats )
+    {
+        pStats->uNumPatches = uNumPatches;
+        pStats->uNumEvaluatedVertices = uNumPatches * uNumPoints;
+        pStats->fACMRBeforeOptimize = fACMRBefore;
+        pStats->fACMRAfterOptimize = ComputeMeshDataACMR( pBaked );
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
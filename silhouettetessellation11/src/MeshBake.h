@@ -0,0 +1,56 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: MeshBake.h
+//
+// Bakes PN-Triangles or Phong tessellation at a uniform factor into a plain triangle
+// mesh, for targets that render without hull and domain shaders. The patches are
+// evaluated by the CPU references, welded along their shared edges and reordered for the
+// post transform vertex cache.
+//--------------------------------------------------------------------------------------
+#ifndef MESH_BAKE_H
+#define MESH_BAKE_H
+
+#include "MeshData.h"
+#include "CPUTessellation.h"
+
+struct MESH_BAKE_STATS
+{
+    UINT    uNumPatches;
+    UINT    uNumEvaluatedVertices;  // Before welding, every patch evaluates all its points
+    float   fACMRBeforeOptimize;    // For VERTEX_CACHE_MEASURE_SIZE entries
+    float   fACMRAfterOptimize;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Tessellates every triangle of pSource with all its factors set to fTessFactor, and
+// writes the result to pBaked with the same subsets. Patches share the vertices of
+// their common corners and edges where the source triangles share vertices (equal
+// position, normal and texture coords within a mesh), so the result is as watertight as
+// the hardware tessellated mesh. pStats may be NULL.
+//--------------------------------------------------------------------------------------
+HRESULT BakeTessellatedMeshData( const MESH_DATA* pSource, CPU_TESS_TECHNIQUE Technique, float fTessFactor,
+                                 MESH_DATA* pBaked, MESH_BAKE_STATS* pStats );
+
+#endif
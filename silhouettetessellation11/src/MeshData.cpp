@@ -0,0 +1,150 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: MeshData.cpp
+//
+// CPU side copy of the triangle lists stored in an sdkmesh.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "..\\..\\DXUT\\Optional\\SDKmesh.h"
+#include "MeshData.h"
+#include <float.h>
+
+using namespace DirectX;
+
+//--------------------------------------------------------------------------------------
+// Copies the triangle list subsets of all the meshes in the sdkmesh into pMeshData
+//--------------------------------------------------------------------------------------
+HRESULT ExtractMeshData( CDXUTSDKMesh* pDXUTMesh, MESH_DATA* pMeshData )
+{
+    assert( NULL != pDXUTMesh );
+    assert( NULL != pMeshData );
+
+    pMeshData->Vertices.clear();
+    pMeshData->Indices.clear();
+    pMeshData->Subsets.clear();
+
+    XMVECTOR vMin = XMVectorReplicate( FLT_MAX );
+    XMVECTOR vMax = XMVectorReplicate( -FLT_MAX );
+
+    for( UINT uMesh = 0; uMesh < pDXUTMesh->GetNumMeshes(); uMesh++ )
+    {
+        SDKMESH_MESH* pMesh = pDXUTMesh->GetMesh( uMesh );
+
+        // Only the first stream is consumed by the input layout
+        UINT uStride = pDXUTMesh->GetVertexStride( uMesh, 0 );
+        if( uStride < VERTEX_MIN_STRIDE )
+        {
+            return E_INVALIDARG;
+        }
+
+        const BYTE* pVertices = pDXUTMesh->GetRawVerticesAt( pMesh->VertexBuffers[0] );
+        const BYTE* pIndices = pDXUTMesh->GetRawIndicesAt( pMesh->IndexBuffer );
+        UINT uNumVertices = (UINT)pDXUTMesh->GetNumVertices( uMesh, 0 );
+        bool b32BitIndices = ( pDXUTMesh->GetIndexType( uMesh ) == IT_32BIT );
+        UINT uBaseVertex = (UINT)pMeshData->Vertices.size();
+
+        pMeshData->Vertices.resize( uBaseVertex + uNumVertices );
+        for( UINT i = 0; i < uNumVertices; i++ )
+        {
+            const BYTE* pVertex = pVertices + (size_t)i * uStride;
+            PN_VERTEX& Vertex = pMeshData->Vertices[uBaseVertex + i];
+
+            memcpy( &Vertex.f3Position, pVertex + VERTEX_POSITION_OFFSET, sizeof( XMFLOAT3 ) );
+            memcpy( &Vertex.f3Normal, pVertex + VERTEX_NORMAL_OFFSET, sizeof( XMFLOAT3 ) );
+            memcpy( &Vertex.f2TexCoord, pVertex + VERTEX_TEXCOORD_OFFSET, sizeof( XMFLOAT2 ) );
+
+            // The tessellation VS normalizes the normals, so the references do too
+            XMStoreFloat3( &Vertex.f3Normal, XMVector3Normalize( XMLoadFloat3( &Vertex.f3Normal ) ) );
+
+            XMVECTOR vPosition = XMLoadFloat3( &Vertex.f3Position );
+            vMin = XMVectorMin( vMin, vPosition );
+            vMax = XMVectorMax( vMax, vPosition );
+        }
+
+        for( UINT uSubset = 0; uSubset < pMesh->NumSubsets; uSubset++ )
+        {
+            SDKMESH_SUBSET* pSubset = pDXUTMesh->GetSubset( uMesh, uSubset );
+            if( pSubset->PrimitiveType != PT_TRIANGLE_LIST )
+            {
+                continue;
+            }
+
+            MESH_DATA_SUBSET Subset;
+            Subset.uMesh = uMesh;
+            Subset.uSubset = uSubset;
+            Subset.uMaterialID = pSubset->MaterialID;
+            Subset.uIndexStart = (UINT)pMeshData->Indices.size();
+            Subset.uIndexCount = (UINT)pSubset->IndexCount;
+
+            UINT uVertexStart = uBaseVertex + (UINT)pSubset->VertexStart;
+            for( UINT64 i = pSubset->IndexStart; i < pSubset->IndexStart + pSubset->IndexCount; i++ )
+            {
+                UINT uIndex = b32BitIndices ? ( (const UINT*)pIndices )[i] : ( (const WORD*)pIndices )[i];
+                pMeshData->Indices.push_back( uVertexStart + uIndex );
+            }
+
+            pMeshData->Subsets.push_back( Subset );
+        }
+    }
+
+    XMStoreFloat3( &pMeshData->f3BoundsMin, vMin );
+    XMStoreFloat3( &pMeshData->f3BoundsMax, vMax );
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Loads an sdkmesh from the media directory without a device and extracts its data
+//--------------------------------------------------------------------------------------
+HRESULT LoadMeshData( const WCHAR* pszMediaFileName, MESH_DATA* pMeshData )
+{
+    HRESULT hr = S_OK;
+
+    // No GPU resources are created when the device is NULL
+    CDXUTSDKMesh Mesh;
+    V_RETURN( Mesh.Create( NULL, pszMediaFileName ) );
+
+    hr = ExtractMeshData( &Mesh, pMeshData );
+
+    Mesh.Destroy();
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the length of the diagonal of the mesh bounds
+//--------------------------------------------------------------------------------------
+float GetMeshDataBoundsDiagonal( const MESH_DATA* pMeshData )
+{
+    XMVECTOR vExtent = XMVectorSubtract( XMLoadFloat3( &pMeshData->f3BoundsMax ), XMLoadFloat3( &pMeshData->f3BoundsMin ) );
+
+    return XMVectorGetX( XMVector3Length( vExtent ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,82 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: MeshData.h
+//
+// CPU side copy of the triangle lists stored in an sdkmesh, used by the CPU references
+// and headless tools. The sdkmesh can be loaded without a device.
+//--------------------------------------------------------------------------------------
+#ifndef MESH_DATA_H
+#define MESH_DATA_H
+
+#include "PNTriangles.h"
+#include <vector>
+
+class CDXUTSDKMesh;
+
+// Layout of the first vertex stream, as the input layout used by the sample reads it:
+// POSITION (float3), NORMAL (float3), TEXCOORD (float2)
+static const UINT VERTEX_POSITION_OFFSET    = 0;
+static const UINT VERTEX_NORMAL_OFFSET      = 12;
+static const UINT VERTEX_TEXCOORD_OFFSET    = 24;
+static const UINT VERTEX_MIN_STRIDE         = 32;
+
+// A subset of the mesh data, indices are relative to the start of MESH_DATA::Vertices
+struct MESH_DATA_SUBSET
+{
+    UINT uMesh;             // Index of the sdkmesh mesh the subset came from
+    UINT uSubset;           // Index of the subset within that mesh
+    UINT uMaterialID;       // sdkmesh material
+    UINT uIndexStart;
+    UINT uIndexCount;
+};
+
+struct MESH_DATA
+{
+    std::vector<PN_VERTEX>          Vertices;
+    std::vector<UINT>               Indices;    // Triangle list
+    std::vector<MESH_DATA_SUBSET>   Subsets;
+    DirectX::XMFLOAT3               f3BoundsMin;
+    DirectX::XMFLOAT3               f3BoundsMax;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Copies the triangle list subsets of all the meshes in the sdkmesh into pMeshData.
+// Vertices are read using the POSITION, NORMAL, TEXCOORD layout the sample renders with.
+//--------------------------------------------------------------------------------------
+HRESULT ExtractMeshData( CDXUTSDKMesh* pDXUTMesh, MESH_DATA* pMeshData );
+
+
+//--------------------------------------------------------------------------------------
+// Loads an sdkmesh from the media directory without a device and extracts its data
+//--------------------------------------------------------------------------------------
+HRESULT LoadMeshData( const WCHAR* pszMediaFileName, MESH_DATA* pMeshData );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the length of the diagonal of the mesh bounds
+//--------------------------------------------------------------------------------------
+float GetMeshDataBoundsDiagonal( const MESH_DATA* pMeshData );
+
+#endif
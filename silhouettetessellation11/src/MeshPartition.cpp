@@ -0,0 +1,245 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: MeshPartition.cpp
+//
+// Partitions of mesh data placed on the NUMA nodes of a task pool.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "MeshPartition.h"
+
+using namespace DirectX;
+
+// Partition arrays start on their own cache line, so no line is written by two nodes
+static const SIZE_T MESH_PARTITION_ALIGNMENT = 64;
+
+
+//--------------------------------------------------------------------------------------
+// Rounds up to the partition alignment
+//--------------------------------------------------------------------------------------
+static SIZE_T AlignPartitionBytes( SIZE_T uBytes )
+{
+    return ( uBytes + MESH_PARTITION_ALIGNMENT - 1 ) & ~( MESH_PARTITION_ALIGNMENT - 1 );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CMeshPartitions::CMeshPartitions() :
+    m_pMeshData( NULL )
+{
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CMeshPartitions::~CMeshPartitions()
+{
+    Destroy();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Partitions the mesh data and copies it to the memory of the partition nodes
+//--------------------------------------------------------------------------------------
+HRESULT CMeshPartitions::Create( const MESH_DATA* pMeshData, UINT uMaxTrianglesPerPartition, CNumaTaskPool* pPool,
+                                 MESH_PARTITION_PLACEMENT Placement )
+{
+    assert( NULL != pMeshData );
+    assert( NULL != pPool );
+    assert( uMaxTrianglesPerPartition > 0 );
+
+    Destroy();
+
+    // Split the subsets and give each partition its own vertices, in order of first use
+    std::vector<UINT> LastPartition( pMeshData->Vertices.size(), UINT_MAX );
+    std::vector<UINT> LocalVertex( pMeshData->Vertices.size() );
+
+    for( UINT uSubset = 0; uSubset < (UINT)pMeshData->Subsets.size(); uSubset++ )
+    {
+        const MESH_DATA_SUBSET* pSubset = &pMeshData->Subsets[uSubset];
+        UINT uNumTriangles = pSubset->uIndexCount / 3;
+
+        for( UINT uFirst = 0; uFirst < uNumTriangles; uFirst += uMaxTrianglesPerPartition )
+        {
+            UINT uPartition = (UINT)m_Partitions.size();
+            UINT uCount = std::min( uMaxTrianglesPerPartition, uNumTriangles - uFirst );
+
+            MESH_PARTITION Partition;
+            ZeroMemory( &Partition, sizeof( Partition ) );
+            Partition.uSubset = uSubset;
+            Partition.uFirstTriangle = uFirst;
+            Partition.uNumIndices = uCount * 3;
+
+            m_FirstSourceVertex.push_back( (UINT)m_SourceVertices.size() );
+            m_FirstSourceIndex.push_back( (UINT)m_SourceIndices.size() );
+
+            const UINT* pIndices = &pMeshData->Indices[pSubset->uIndexStart + uFirst * 3];
+            for( UINT i = 0; i < Partition.uNumIndices; i++ )
+            {
+                UINT uVertex = pIndices[i];
+                if( LastPartition[uVertex] != uPartition )
+                {
+                    LastPartition[uVertex] = uPartition;
+                    LocalVertex[uVertex] = Partition.uNumVertices++;
+                    m_SourceVertices.push_back( uVertex );
+                }
+                m_SourceIndices.push_back( LocalVertex[uVertex] );
+            }
+
+            m_Partitions.push_back( Partition );
+        }
+    }
+
+    // Deal contiguous runs of about equal size to the nodes, by the middle of each partition
+    UINT uNumNodes = ( MESH_PARTITION_NODE_LOCAL == Placement ) ? pPool->GetNumNodes() : 1;
+    std::vector<SIZE_T> PartitionBytes( m_Partitions.size() );
+    SIZE_T uTotalBytes = 0;
+    for( UINT uPartition = 0; uPartition < (UINT)m_Partitions.size(); uPartition++ )
+    {
+        const MESH_PARTITION* pPartition = &m_Partitions[uPartition];
+        PartitionBytes[uPartition] = AlignPartitionBytes( pPartition->uNumVertices * sizeof( PN_VERTEX ) ) +
+                                     AlignPartitionBytes( pPartition->uNumIndices * sizeof( UINT ) );
+        uTotalBytes += PartitionBytes[uPartition];
+    }
+
+    m_NodeBytes.resize( uNumNodes, 0 );
+    m_PartitionNodes.resize( m_Partitions.size() );
+    std::vector<SIZE_T> PartitionOffsets( m_Partitions.size() );
+    SIZE_T uRunningBytes = 0;
+    for( UINT uPartition = 0; uPartition < (UINT)m_Partitions.size(); uPartition++ )
+    {
+        double fMiddle = (double)uRunningBytes + 0.5 * (double)PartitionBytes[uPartition];
+        UINT uNode = std::min( (UINT)( fMiddle * uNumNodes / (double)uTotalBytes ), uNumNodes - 1 );
+        uRunningBytes += PartitionBytes[uPartition];
+
+        m_Partitions[uPartition].uNode = uNode;
+        m_PartitionNodes[uPartition] = uNode;
+        PartitionOffsets[uPartition] = m_NodeBytes[uNode];
+        m_NodeBytes[uNode] += PartitionBytes[uPartition];
+    }
+
+    m_NodeMemory.resize( uNumNodes, NULL );
+    for( UINT uNode = 0; uNode < uNumNodes; uNode++ )
+    {
+        if( 0 == m_NodeBytes[uNode] )
+        {
+            continue;
+        }
+
+        m_NodeMemory[uNode] = AllocateNumaMemory( m_NodeBytes[uNode], pPool->GetNode( uNode )->uNode );
+        if( NULL == m_NodeMemory[uNode] )
+        {
+            Destroy();
+            return E_OUTOFMEMORY;
+        }
+    }
+
+    for( UINT uPartition = 0; uPartition < (UINT)m_Partitions.size(); uPartition++ )
+    {
+        MESH_PARTITION* pPartition = &m_Partitions[uPartition];
+        BYTE* pMemory = (BYTE*)m_NodeMemory[pPartition->uNode] + PartitionOffsets[uPartition];
+        pPartition->pVertices = (PN_VERTEX*)pMemory;
+        pPartition->pIndices = (UINT*)( pMemory + AlignPartitionBytes( pPartition->uNumVertices * sizeof( PN_VERTEX ) ) );
+    }
+
+    // First touch
+    m_pMeshData = pMeshData;
+    if( MESH_PARTITION_NODE_LOCAL == Placement )
+    {
+        pPool->Run( CopyPartitionTask, this, (UINT)m_Partitions.size(), &m_PartitionNodes[0], false );
+    }
+    else
+    {
+        for( UINT uPartition = 0; uPartition < (UINT)m_Partitions.size(); uPartition++ )
+        {
+            CopyPartitionTask( this, uPartition, 0 );
+        }
+    }
+
+    m_pMeshData = NULL;
+    std::vector<UINT>().swap( m_SourceVertices );
+    std::vector<UINT>().swap( m_SourceIndices );
+    std::vector<UINT>().swap( m_FirstSourceVertex );
+    std::vector<UINT>().swap( m_FirstSourceIndex );
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Frees the partitions
+//--------------------------------------------------------------------------------------
+void CMeshPartitions::Destroy()
+{
+    for( UINT uNode = 0; uNode < (UINT)m_NodeMemory.size(); uNode++ )
+    {
+        FreeNumaMemory( m_NodeMemory[uNode] );
+    }
+
+    m_Partitions.clear();
+    m_PartitionNodes.clear();
+    m_NodeMemory.clear();
+    m_NodeBytes.clear();
+    m_SourceVertices.clear();
+    m_SourceIndices.clear();
+    m_FirstSourceVertex.clear();
+    m_FirstSourceIndex.clear();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Copies the vertices and indices of a partition, and computes its bounds
+//--------------------------------------------------------------------------------------
+void CMeshPartitions::CopyPartitionTask( void* pContext, UINT uTask, UINT uWorker )
+{
+    UNREFERENCED_PARAMETER( uWorker );
+
+    CMeshPartitions* pThis = (CMeshPartitions*)pContext;
+    MESH_PARTITION* pPartition = &pThis->m_Partitions[uTask];
+
+    const UINT* puSourceVertices = &pThis->m_SourceVertices[pThis->m_FirstSourceVertex[uTask]];
+    XMVECTOR vMin = XMVectorReplicate( FLT_MAX );
+    XMVECTOR vMax = XMVectorReplicate( -FLT_MAX );
+    for( UINT i = 0; i < pPartition->uNumVertices; i++ )
+    {
+        const PN_VERTEX* pSource = &pThis->m_pMeshData->Vertices[puSourceVertices[i]];
+        pPartition->pVertices[i] = *pSource;
+
+        XMVECTOR vPosition = XMLoadFloat3( &pSource->f3Position );
+        vMin = XMVectorMin( vMin, vPosition );
+        vMax = XMVectorMax( vMax, vPosition );
+    }
+
+    memcpy( pPartition->pIndices, &pThis->m_SourceIndices[pThis->m_FirstSourceIndex[uTask]], pPartition->uNumIndices * sizeof( UINT ) );
+
+    XMStoreFloat3( &pPartition->f3BoundsMin, vMin );
+    XMStoreFloat3( &pPartition->f3BoundsMax, vMax );
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
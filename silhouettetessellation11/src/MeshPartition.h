@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: MeshPartition.h
+//
+// Splits mesh data into partitions of consecutive triangles of a subset, each with its own
+// compact vertex and index arrays, and places the partitions on the NUMA nodes of a task
+// pool. Partitions are dealt to the nodes in contiguous runs of about equal size, and the
+// arrays of a node are copied by the node's workers so that first touch puts the pages in
+// the node's memory. Tasks over the partitions should then run with the partition nodes.
+//--------------------------------------------------------------------------------------
+#ifndef MESH_PARTITION_H
+#define MESH_PARTITION_H
+
+#include "MeshData.h"
+#include "NumaTaskPool.h"
+
+// A run of triangles of one subset. Indices are relative to pVertices.
+struct MESH_PARTITION
+{
+    UINT                uSubset;        // Index in MESH_DATA::Subsets
+    UINT                uFirstTriangle; // Within the subset
+    UINT                uNode;          // Index of the node in the task pool
+    PN_VERTEX*          pVertices;
+    UINT                uNumVertices;
+    UINT*               pIndices;
+    UINT                uNumIndices;
+    DirectX::XMFLOAT3   f3BoundsMin;
+    DirectX::XMFLOAT3   f3BoundsMax;
+};
+
+// Where the partitions are placed
+enum MESH_PARTITION_PLACEMENT
+{
+    MESH_PARTITION_SINGLE_NODE,     // All on the first node, copied by the calling thread
+    MESH_PARTITION_NODE_LOCAL,      // Spread over the nodes, copied by each node's workers
+};
+
+
+//--------------------------------------------------------------------------------------
+// Partitions of a mesh, in node local memory
+//--------------------------------------------------------------------------------------
+class CMeshPartitions
+{
+public:
+
+    CMeshPartitions();
+    ~CMeshPartitions();
+
+    HRESULT Create( const MESH_DATA* pMeshData, UINT uMaxTrianglesPerPartition, CNumaTaskPool* pPool,
+                    MESH_PARTITION_PLACEMENT Placement );
+    void Destroy();
+
+    UINT GetNumPartitions() const { return (UINT)m_Partitions.size(); }
+    const MESH_PARTITION* GetPartition( UINT uPartition ) const { return &m_Partitions[uPartition]; }
+
+    // Node of each partition, as CNumaTaskPool::Run takes them
+    const UINT* GetPartitionNodes() const { return m_PartitionNodes.empty() ? NULL : &m_PartitionNodes[0]; }
+
+    UINT GetNumNodes() const { return (UINT)m_NodeBytes.size(); }
+    SIZE_T GetNodeBytes( UINT uNode ) const { return m_NodeBytes[uNode]; }
+
+private:
+
+    static void CopyPartitionTask( void* pContext, UINT uTask, UINT uWorker );
+
+    std::vector<MESH_PARTITION> m_Partitions;
+    std::vector<UINT>           m_PartitionNodes;
+    std::vector<void*>          m_NodeMemory;
+    std::vector<SIZE_T>         m_NodeBytes;
+
+    // Source of each partition while copying
+    const MESH_DATA*            m_pMeshData;
+    std::vector<UINT>           m_SourceVertices;   // Mesh vertex of each partition vertex
+    std::vector<UINT>           m_SourceIndices;    // Partition relative indices
+    std::vector<UINT>           m_FirstSourceVertex;
+    std::vector<UINT>           m_FirstSourceIndex;
+};
+
+#endif
@@ -0,0 +1,962 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: MeshSimplify.cpp
+//
+// Mesh simplification by half edge collapses
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "MeshSimplify.h"
+#include "Quadric.h"
+#include "PatchOrder.h"
+#include "VertexCache.h"
+#include <algorithm>
+#include <queue>
+#include <map>
+#include <float.h>
+
+using namespace DirectX;
+
+// Orders vertices by position
+struct SIMPLIFY_POSITION_LESS
+{
+    const PN_VERTEX*    pVertices;
+
+    bool operator()( UINT uA, UINT uB ) const
+    {
+        const XMFLOAT3& f3A = pVertices[uA].f3Position;
+        const XMFLOAT3& f3B = pVertices[uB].f3Position;
+        if( f3A.x != f3B.x )
+        {
+            return f3A.x < f3B.x;
+        }
+        if( f3A.y != f3B.y )
+        {
+            return f3A.y < f3B.y;
+        }
+        return f3A.z < f3B.z;
+    }
+};
+
+// Orders vertices by all their attributes
+struct SIMPLIFY_VERTEX_LESS
+{
+    const PN_VERTEX*    pVertices;
+
+    bool operator()( UINT uA, UINT uB ) const
+    {
+        return memcmp( &pVertices[uA], &pVertices[uB], sizeof( PN_VERTEX ) ) < 0;
+    }
+};
+
+// A half edge collapse in the queue, cheapest first. It is stale once either vertex
+// changed since it was queued.
+struct SIMPLIFY_COLLAPSE
+{
+    float   fCost;
+    UINT    uFrom;
+    UINT    uTo;
+    UINT    uFromStamp;
+    UINT    uToStamp;
+
+    bool operator<( const SIMPLIFY_COLLAPSE& Other ) const
+    {
+        return fCost > Other.fCost;
+    }
+};
+
+// An edge of a triangle, by the vertices and by the corners of its ends
+struct SIMPLIFY_EDGE
+{
+    UINT64  uVertices;
+    UINT64  uCorners;
+    UINT    uTriangle;
+
+    bool operator<( const SIMPLIFY_EDGE& Other ) const
+    {
+        return ( uVertices != Other.uVertices ) ? uVertices < Other.uVertices : uCorners < Other.uCorners;
+    }
+};
+
+// A run of a subset's triangles, simplified by one task
+struct SIMPLIFY_RUN
+{
+    UINT                uFirstIndex;
+    UINT                uNumIndices;
+    std::vector<UINT>   Indices;        // Simplified, of the positions
+    std::vector<UINT>   Corners;        // Simplified, of the vertices
+    float               fError;
+};
+
+// A subset, simplified from its runs
+struct SIMPLIFY_SUBSET
+{
+    UINT                    uNumSourceTriangles;
+    UINT                    uFirstRun;
+    UINT                    uNumRuns;
+    std::vector<PN_VERTEX>  Vertices;   // Its own
+    std::vector<UINT>       Indices;
+    std::vector<UINT>       Corners;
+    float                   fError;
+};
+
+struct SIMPLIFY_CONTEXT
+{
+    const std::vector<PN_VERTEX>*   pVertices;      // Welded by all attributes
+    const std::vector<XMFLOAT3>*    pPositions;     // Welded by position
+    const std::vector<UINT>*        pIndices;       // Of the positions
+    const std::vector<UINT>*        pCorners;       // Of the vertices
+    std::vector<SIMPLIFY_RUN>*      pRuns;
+    std::vector<SIMPLIFY_SUBSET>*   pSubsets;
+    float                           fRatio;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Welds the vertices by position
+//--------------------------------------------------------------------------------------
+void WeldPositions( const MESH_DATA* pMeshData, std::vector<PN_VERTEX>* pVertices, std::vector<UINT>* pIndices )
+{
+    assert( NULL != pMeshData && NULL != pVertices && NULL != pIndices );
+
+    pVertices->clear();
+    pIndices->clear();
+    UINT uNumSourceVertices = (UINT)pMeshData->Vertices.size();
+    if( 0 == uNumSourceVertices )
+    {
+        return;
+    }
+
+    std::vector<UINT> Order( uNumSourceVertices );
+    for( UINT v = 0; v < uNumSourceVertices; v++ )
+    {
+        Order[v] = v;
+    }
+    SIMPLIFY_POSITION_LESS PositionLess = { &pMeshData->Vertices[0] };
+    std::sort( Order.begin(), Order.end(), PositionLess );
+    std::vector<UINT> Welded( uNumSourceVertices );
+    std::vector<XMFLOAT3> NormalSums;
+    for( UINT i = 0; i < uNumSourceVertices; i++ )
+    {
+        const PN_VERTEX& Vertex = pMeshData->Vertices[Order[i]];
+        if( 0 == i || PositionLess( Order[i - 1], Order[i] ) )
+        {
+            pVertices->push_back( Vertex );
+            NormalSums.push_back( XMFLOAT3( 0.0f, 0.0f, 0.0f ) );
+        }
+        UINT uWelded = (UINT)pVertices->size() - 1;
+        Welded[Order[i]] = uWelded;
+        XMStoreFloat3( &NormalSums[uWelded], XMVectorAdd( XMLoadFloat3( &NormalSums[uWelded] ), XMLoadFloat3( &Vertex.f3Normal ) ) );
+    }
+    for( UINT v = 0; v < (UINT)pVertices->size(); v++ )
+    {
+        XMVECTOR vSum = XMLoadFloat3( &NormalSums[v] );
+        if( XMVectorGetX( XMVector3LengthSq( vSum ) ) > 0.0f )
+        {
+            XMStoreFloat3( &( *pVertices )[v].f3Normal, XMVector3Normalize( vSum ) );
+        }
+    }
+
+    for( UINT uIndex = 0; uIndex + 2 < (UINT)pMeshData->Indices.size(); uIndex += 3 )
+    {
+        UINT uTri[3] = { Welded[pMeshData->Indices[uIndex]], Welded[pMeshData->Indices[uIndex + 1]], Welded[pMeshData->Indices[uIndex + 2]] };
+        if( uTri[0] != uTri[1] && uTri[1] != uTri[2] && uTri[2] != uTri[0] )
+        {
+            pIndices->insert( pIndices->end(), uTri, uTri + 3 );
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the squared distance of a point to a triangle, from its closest point as in
+// Ericson, Real-Time Collision Detection 5.1.5
+//--------------------------------------------------------------------------------------
+float GetPointTriangleDistanceSq( FXMVECTOR vPoint, FXMVECTOR vA, FXMVECTOR vB, GXMVECTOR vC )
+{
+    XMVECTOR vAB = XMVectorSubtract( vB, vA );
+    XMVECTOR vAC = XMVectorSubtract( vC, vA );
+    XMVECTOR vAP = XMVectorSubtract( vPoint, vA );
+    float fD1 = XMVectorGetX( XMVector3Dot( vAB, vAP ) );
+    float fD2 = XMVectorGetX( XMVector3Dot( vAC, vAP ) );
+    XMVECTOR vClosest;
+    if( fD1 <= 0.0f && fD2 <= 0.0f )
+    {
+        vClosest = vA;
+    }
+    else
+    {
+        XMVECTOR vBP = XMVectorSubtract( vPoint, vB );
+        float fD3 = XMVectorGetX( XMVector3Dot( vAB, vBP ) );
+        float fD4 = XMVectorGetX( XMVector3Dot( vAC, vBP ) );
+        XMVECTOR vCP = XMVectorSubtract( vPoint, vC );
+        float fD5 = XMVectorGetX( XMVector3Dot( vAB, vCP ) );
+        float fD6 = XMVectorGetX( XMVector3Dot( vAC, vCP ) );
+        float fVC = fD1 * fD4 - fD3 * fD2;
+        float fVB = fD5 * fD2 - fD1 * fD6;
+        float fVA = fD3 * fD6 - fD5 * fD4;
+        if( fD3 >= 0.0f && fD4 <= fD3 )
+        {
+            vClosest = vB;
+        }
+        else if( fD6 >= 0.0f && fD5 <= fD6 )
+        {
+            vClosest = vC;
+        }
+        else if( fVC <= 0.0f && fD1 >= 0.0f && fD3 <= 0.0f )
+        {
+            vClosest = XMVectorAdd( vA, XMVectorScale( vAB, fD1 / ( fD1 - fD3 ) ) );
+        }
+        else if( fVB <= 0.0f && fD2 >= 0.0f && fD6 <= 0.0f )
+        {
+            vClosest = XMVectorAdd( vA, XMVectorScale( vAC, fD2 / ( fD2 - fD6 ) ) );
+        }
+        else if( fVA <= 0.0f && ( fD4 - fD3 ) >= 0.0f && ( fD5 - fD6 ) >= 0.0f )
+        {
+            vClosest = XMVectorAdd( vB, XMVectorScale( XMVectorSubtract( vC, vB ), ( fD4 - fD3 ) / ( ( fD4 - fD3 ) + ( fD5 - fD6 ) ) ) );
+        }
+        else
+        {
+            float fDenominator = 1.0f / ( fVA + fVB + fVC );
+            vClosest = XMVectorAdd( vA, XMVectorAdd( XMVectorScale( vAB, fVB * fDenominator ), XMVectorScale( vAC, fVC * fDenominator ) ) );
+        }
+    }
+    return XMVectorGetX( XMVector3LengthSq( XMVectorSubtract( vPoint, vClosest ) ) );
+}
+
+
+
+
+//--------------------------------------------------------------------------------------
+// Returns the unnormalized normal of a triangle, from the cross product of its edges
+//--------------------------------------------------------------------------------------
+static XMVECTOR GetTriangleCross( const XMFLOAT3& f3P0, const XMFLOAT3& f3P1, const XMFLOAT3& f3P2 )
+{
+    XMVECTOR vP0 = XMLoadFloat3( &f3P0 );
+    return XMVector3Cross( XMVectorSubtract( XMLoadFloat3( &f3P1 ), vP0 ), XMVectorSubtract( XMLoadFloat3( &f3P2 ), vP0 ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Simplifies a mesh by half edge collapses in quadric error order
+//--------------------------------------------------------------------------------------
+HRESULT SimplifyMesh( const XMFLOAT3* pPositions, UINT uNumVertices, const BYTE* pbLocked, UINT uTargetTriangles,
+                      std::vector<UINT>* pIndices, float* pfError, std::vector<UINT>* pCorners )
+{
+    assert( NULL != pIndices && NULL != pfError );
+
+    *pfError = 0.0f;
+    if( NULL == pPositions || 0 == uNumVertices || ( NULL != pCorners && pCorners->size() != pIndices->size() ) )
+    {
+        return E_INVALIDARG;
+    }
+
+    // Triangles without the degenerate ones, and the corners of each, or the vertices
+    // themselves without corners
+    std::vector<UINT> Triangles, Corners;
+    Triangles.reserve( pIndices->size() );
+    Corners.reserve( pIndices->size() );
+    for( UINT uIndex = 0; uIndex + 2 < (UINT)pIndices->size(); uIndex += 3 )
+    {
+        const UINT* pTri = &( *pIndices )[uIndex];
+        if( pTri[0] >= uNumVertices || pTri[1] >= uNumVertices || pTri[2] >= uNumVertices )
+        {
+            return E_INVALIDARG;
+        }
+        if( pTri[0] != pTri[1] && pTri[1] != pTri[2] && pTri[2] != pTri[0] )
+        {
+            Triangles.insert( Triangles.end(), pTri, pTri + 3 );
+            const UINT* pCorner = ( NULL != pCorners ) ? &( *pCorners )[uIndex] : pTri;
+            Corners.insert( Corners.end(), pCorner, pCorner + 3 );
+        }
+    }
+    UINT uNumTriangles = (UINT)Triangles.size() / 3;
+
+    // Triangles around each vertex and the quadrics of their planes
+    std::vector< std::vector<UINT> > VertexTriangles( uNumVertices );
+    std::vector<QUADRIC> Quadrics( uNumVertices );
+    ZeroMemory( &Quadrics[0], uNumVertices * sizeof( QUADRIC ) );
+    std::vector<SIMPLIFY_EDGE> Edges;
+    Edges.reserve( uNumTriangles * 3 );
+    for( UINT t = 0; t < uNumTriangles; t++ )
+    {
+        const UINT* pTri = &Triangles[t * 3];
+        const UINT* pCorner = &Corners[t * 3];
+        QUADRIC Quadric;
+        InitTriangleQuadric( XMLoadFloat3( &pPositions[pTri[0]] ), XMLoadFloat3( &pPositions[pTri[1]] ),
+                             XMLoadFloat3( &pPositions[pTri[2]] ), &Quadric );
+        for( UINT c = 0; c < 3; c++ )
+        {
+            UINT uVertex = pTri[c], uNext = pTri[( c + 1 ) % 3];
+            UINT uCorner = pCorner[c], uNextCorner = pCorner[( c + 1 ) % 3];
+            VertexTriangles[uVertex].push_back( t );
+            AddQuadric( &Quadrics[uVertex], &Quadric );
+            SIMPLIFY_EDGE Edge = { ( (UINT64)std::min( uVertex, uNext ) << 32 ) | std::max( uVertex, uNext ),
+                                   ( (UINT64)std::min( uCorner, uNextCorner ) << 32 ) | std::max( uCorner, uNextCorner ), t };
+            Edges.push_back( Edge );
+        }
+    }
+
+    // Vertices on edges not shared by exactly two triangles stay where they are, so the
+    // open edges keep their shape. Edges whose two triangles have different corners are
+    // seams, which keep their shape by the planes through them.
+    std::vector<BYTE> bFixed( uNumVertices, 0 );
+    if( NULL != pbLocked )
+    {
+        memcpy( &bFixed[0], pbLocked, uNumVertices );
+    }
+    std::sort( Edges.begin(), Edges.end() );
+    for( UINT i = 0; i < (UINT)Edges.size(); )
+    {
+        UINT j = i + 1;
+        while( j < (UINT)Edges.size() && Edges[j].uVertices == Edges[i].uVertices )
+        {
+            j++;
+        }
+        UINT uA = (UINT)( Edges[i].uVertices >> 32 ), uB = (UINT)( Edges[i].uVertices & 0xffffffff );
+        if( 2 != j - i )
+        {
+            bFixed[uA] = 1;
+            bFixed[uB] = 1;
+        }
+        else if( Edges[i].uCorners != Edges[i + 1].uCorners )
+        {
+            for( UINT k = i; k < j; k++ )
+            {
+                const UINT* pTri = &Triangles[Edges[k].uTriangle * 3];
+                XMVECTOR vCross = GetTriangleCross( pPositions[pTri[0]], pPositions[pTri[1]], pPositions[pTri[2]] );
+                QUADRIC Quadric;
+                InitBoundaryQuadric( XMLoadFloat3( &pPositions[uA] ), XMLoadFloat3( &pPositions[uB] ), XMVector3Normalize( vCross ), &Quadric );
+                AddQuadric( &Quadrics[uA], &Quadric );
+                AddQuadric( &Quadrics[uB], &Quadric );
+            }
+        }
+        i = j;
+    }
+    std::vector<SIMPLIFY_EDGE>().swap( Edges );
+
+    // The input vertices each vertex stands for
+    std::vector< std::vector<UINT> > Regions( uNumVertices );
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        Regions[v].push_back( v );
+    }
+    std::vector<UINT> Stamps( uNumVertices, 0 );
+    std::vector<BYTE> bCollapsed( uNumVertices, 0 );
+    std::vector<BYTE> bRemoved( uNumTriangles, 0 );
+    std::vector<UINT> FromNeighbours, ToNeighbours;
+    std::vector< std::pair<UINT, UINT> > CornerMoves;
+    std::priority_queue<SIMPLIFY_COLLAPSE> Queue;
+    UINT uNumLive = uNumTriangles;
+    float fMaxDistanceSq = 0.0f;
+    for( UINT uPass = 0; uPass < SIMPLIFY_MAX_PASSES && uNumLive > uTargetTriangles; uPass++ )
+    {
+        // Both directions of every remaining edge, from the vertices free to move
+        UINT uNumLiveBefore = uNumLive;
+        for( UINT t = 0; t < uNumTriangles; t++ )
+        {
+            if( 0 != bRemoved[t] )
+            {
+                continue;
+            }
+            for( UINT c = 0; c < 3; c++ )
+            {
+                UINT uA = Triangles[t * 3 + c], uB = Triangles[t * 3 + ( c + 1 ) % 3];
+                QUADRIC Sum = Quadrics[uA];
+                AddQuadric( &Sum, &Quadrics[uB] );
+                if( 0 == bFixed[uA] )
+                {
+                    SIMPLIFY_COLLAPSE AToB = { (float)EvaluateQuadric( &Sum, pPositions[uB] ), uA, uB, Stamps[uA], Stamps[uB] };
+                    Queue.push( AToB );
+                }
+                if( 0 == bFixed[uB] )
+                {
+                    SIMPLIFY_COLLAPSE BToA = { (float)EvaluateQuadric( &Sum, pPositions[uA] ), uB, uA, Stamps[uB], Stamps[uA] };
+                    Queue.push( BToA );
+                }
+            }
+        }
+
+        while( !Queue.empty() && uNumLive > uTargetTriangles )
+        {
+            SIMPLIFY_COLLAPSE Collapse = Queue.top();
+            Queue.pop();
+            UINT uFrom = Collapse.uFrom, uTo = Collapse.uTo;
+            if( Collapse.uFromStamp != Stamps[uFrom] || Collapse.uToStamp != Stamps[uTo] ||
+                0 != bCollapsed[uFrom] || 0 != bCollapsed[uTo] )
+            {
+                continue;
+            }
+
+            // The triangles on the edge go, the others around the vertex move with it. The
+            // neighbours both ends share must be the third corners of the edge's triangles,
+            // or the collapse pinches the surface.
+            UINT uNumShared = 0;
+            FromNeighbours.clear();
+            ToNeighbours.clear();
+            for( UINT i = 0; i < (UINT)VertexTriangles[uFrom].size(); i++ )
+            {
+                const UINT* pTri = &Triangles[VertexTriangles[uFrom][i] * 3];
+                uNumShared += ( pTri[0] == uTo || pTri[1] == uTo || pTri[2] == uTo ) ? 1 : 0;
+                FromNeighbours.insert( FromNeighbours.end(), pTri, pTri + 3 );
+            }
+            for( UINT i = 0; i < (UINT)VertexTriangles[uTo].size(); i++ )
+            {
+                const UINT* pTri = &Triangles[VertexTriangles[uTo][i] * 3];
+                ToNeighbours.insert( ToNeighbours.end(), pTri, pTri + 3 );
+            }
+            std::sort( FromNeighbours.begin(), FromNeighbours.end() );
+            FromNeighbours.erase( std::unique( FromNeighbours.begin(), FromNeighbours.end() ), FromNeighbours.end() );
+            std::sort( ToNeighbours.begin(), ToNeighbours.end() );
+            ToNeighbours.erase( std::unique( ToNeighbours.begin(), ToNeighbours.end() ), ToNeighbours.end() );
+            UINT uNumCommon = 0;
+            for( UINT i = 0, j = 0; i < (UINT)FromNeighbours.size() && j < (UINT)ToNeighbours.size(); )
+            {
+                if( FromNeighbours[i] < ToNeighbours[j] )
+                {
+                    i++;
+                }
+                else if( ToNeighbours[j] < FromNeighbours[i] )
+                {
+                    j++;
+                }
+                else
+                {
+                    uNumCommon += ( FromNeighbours[i] != uFrom && FromNeighbours[i] != uTo ) ? 1 : 0;
+                    i++;
+                    j++;
+                }
+            }
+            if( 0 == uNumShared || uNumCommon != uNumShared )
+            {
+                continue;
+            }
+
+            // No triangle may turn over
+            bool bFlips = false;
+            for( UINT i = 0; i < (UINT)VertexTriangles[uFrom].size() && !bFlips; i++ )
+            {
+                const UINT* pTri = &Triangles[VertexTriangles[uFrom][i] * 3];
+                if( pTri[0] == uTo || pTri[1] == uTo || pTri[2] == uTo )
+                {
+                    continue;
+                }
+                XMFLOAT3 f3Moved[3];
+                for( UINT c = 0; c < 3; c++ )
+                {
+                    f3Moved[c] = pPositions[( pTri[c] == uFrom ) ? uTo : pTri[c]];
+                }
+                XMVECTOR vBefore = GetTriangleCross( pPositions[pTri[0]], pPositions[pTri[1]], pPositions[pTri[2]] );
+                XMVECTOR vAfter = GetTriangleCross( f3Moved[0], f3Moved[1], f3Moved[2] );
+                float fLengths = XMVectorGetX( XMVector3Length( vBefore ) ) * XMVectorGetX( XMVector3Length( vAfter ) );
+                bFlips = !( XMVectorGetX( XMVector3Dot( vBefore, vAfter ) ) > SIMPLIFY_MIN_FLIP_COSINE * fLengths );
+            }
+            if( bFlips )
+            {
+                continue;
+            }
+
+            // Each corner of the vertex goes to the corner of the other end on the same side
+            // of the seams, found in the triangles on the edge. A corner with none, or with
+            // two, would tear its seam, so seam vertices only move along their seam.
+            CornerMoves.clear();
+            bool bTears = false;
+            for( UINT i = 0; i < (UINT)VertexTriangles[uFrom].size() && !bTears; i++ )
+            {
+                UINT t = VertexTriangles[uFrom][i];
+                const UINT* pTri = &Triangles[t * 3];
+                UINT cFrom = ( pTri[0] == uFrom ) ? 0 : ( ( pTri[1] == uFrom ) ? 1 : 2 );
+                UINT cTo = ( pTri[0] == uTo ) ? 0 : ( ( pTri[1] == uTo ) ? 1 : ( ( pTri[2] == uTo ) ? 2 : 3 ) );
+                if( cTo < 3 )
+                {
+                    for( UINT m = 0; m < (UINT)CornerMoves.size() && !bTears; m++ )
+                    {
+                        bTears = CornerMoves[m].first == Corners[t * 3 + cFrom] && CornerMoves[m].second != Corners[t * 3 + cTo];
+                    }
+                    CornerMoves.push_back( std::make_pair( Corners[t * 3 + cFrom], Corners[t * 3 + cTo] ) );
+                }
+            }
+            for( UINT i = 0; i < (UINT)VertexTriangles[uFrom].size() && !bTears; i++ )
+            {
+                UINT t = VertexTriangles[uFrom][i];
+                const UINT* pTri = &Triangles[t * 3];
+                UINT cFrom = ( pTri[0] == uFrom ) ? 0 : ( ( pTri[1] == uFrom ) ? 1 : 2 );
+                bool bMoves = false;
+                for( UINT m = 0; m < (UINT)CornerMoves.size() && !bMoves; m++ )
+                {
+                    bMoves = CornerMoves[m].first == Corners[t * 3 + cFrom];
+                }
+                bTears = !bMoves;
+            }
+            if( bTears )
+            {
+                continue;
+            }
+
+            bCollapsed[uFrom] = 1;
+            for( UINT i = 0; i < (UINT)VertexTriangles[uFrom].size(); i++ )
+            {
+                UINT t = VertexTriangles[uFrom][i];
+                UINT* pTri = &Triangles[t * 3];
+                if( pTri[0] == uTo || pTri[1] == uTo || pTri[2] == uTo )
+                {
+                    bRemoved[t] = 1;
+                    uNumLive--;
+                    for( UINT c = 0; c < 3; c++ )
+                    {
+                        if( pTri[c] != uFrom )
+                        {
+                            std::vector<UINT>& Around = VertexTriangles[pTri[c]];
+                            Around.erase( std::find( Around.begin(), Around.end(), t ) );
+                        }
+                    }
+                }
+                else
+                {
+                    for( UINT c = 0; c < 3; c++ )
+                    {
+                        if( pTri[c] == uFrom )
+                        {
+                            pTri[c] = uTo;
+                            for( UINT m = 0; m < (UINT)CornerMoves.size(); m++ )
+                            {
+                                if( CornerMoves[m].first == Corners[t * 3 + c] )
+                                {
+                                    Corners[t * 3 + c] = CornerMoves[m].second;
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                    VertexTriangles[uTo].push_back( t );
+                }
+            }
+            std::vector<UINT>().swap( VertexTriangles[uFrom] );
+
+            // The error is the distance of the input vertices the region stands for to the
+            // triangles around the vertex it went to
+            for( UINT i = 0; i < (UINT)Regions[uFrom].size(); i++ )
+            {
+                XMVECTOR vPoint = XMLoadFloat3( &pPositions[Regions[uFrom][i]] );
+                float fDistanceSq = XMVectorGetX( XMVector3LengthSq( XMVectorSubtract( vPoint, XMLoadFloat3( &pPositions[uTo] ) ) ) );
+                for( UINT j = 0; j < (UINT)VertexTriangles[uTo].size() && fDistanceSq > fMaxDistanceSq; j++ )
+                {
+                    const UINT* pTri = &Triangles[VertexTriangles[uTo][j] * 3];
+                    fDistanceSq = std::min( fDistanceSq, GetPointTriangleDistanceSq( vPoint, XMLoadFloat3( &pPositions[pTri[0]] ),
+                                                                                    XMLoadFloat3( &pPositions[pTri[1]] ),
+                                                                                    XMLoadFloat3( &pPositions[pTri[2]] ) ) );
+                }
+                fMaxDistanceSq = std::max( fMaxDistanceSq, fDistanceSq );
+            }
+            Regions[uTo].insert( Regions[uTo].end(), Regions[uFrom].begin(), Regions[uFrom].end() );
+            std::vector<UINT>().swap( Regions[uFrom] );
+
+            AddQuadric( &Quadrics[uTo], &Quadrics[uFrom] );
+            Stamps[uTo]++;
+
+            // Requeue the edges of the merged vertex
+            for( UINT i = 0; i < (UINT)VertexTriangles[uTo].size(); i++ )
+            {
+                const UINT* pTri = &Triangles[VertexTriangles[uTo][i] * 3];
+                for( UINT c = 0; c < 3; c++ )
+                {
+                    UINT uOther = pTri[c];
+                    if( uOther == uTo )
+                    {
+                        continue;
+                    }
+                    QUADRIC Sum = Quadrics[uTo];
+                    AddQuadric( &Sum, &Quadrics[uOther] );
+                    if( 0 == bFixed[uTo] )
+                    {
+                        SIMPLIFY_COLLAPSE ToOther = { (float)EvaluateQuadric( &Sum, pPositions[uOther] ), uTo, uOther, Stamps[uTo], Stamps[uOther] };
+                        Queue.push( ToOther );
+                    }
+                    if( 0 == bFixed[uOther] )
+                    {
+                        SIMPLIFY_COLLAPSE OtherTo = { (float)EvaluateQuadric( &Sum, pPositions[uTo] ), uOther, uTo, Stamps[uOther], Stamps[uTo] };
+                        Queue.push( OtherTo );
+                    }
+                }
+            }
+        }
+
+        std::priority_queue<SIMPLIFY_COLLAPSE>().swap( Queue );
+        if( uNumLive == uNumLiveBefore )
+        {
+            break;
+        }
+    }
+
+    pIndices->clear();
+    pIndices->reserve( uNumLive * 3 );
+    if( NULL != pCorners )
+    {
+        pCorners->clear();
+        pCorners->reserve( uNumLive * 3 );
+    }
+    for( UINT t = 0; t < uNumTriangles; t++ )
+    {
+        if( 0 == bRemoved[t] )
+        {
+            pIndices->insert( pIndices->end(), &Triangles[t * 3], &Triangles[t * 3] + 3 );
+            if( NULL != pCorners )
+            {
+                pCorners->insert( pCorners->end(), &Corners[t * 3], &Corners[t * 3] + 3 );
+            }
+        }
+    }
+    *pfError = sqrtf( fMaxDistanceSq );
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Simplifies triangles on their own vertices
+//--------------------------------------------------------------------------------------
+HRESULT SimplifyTriangles( const XMFLOAT3* pPositions, UINT uTargetTriangles, std::vector<UINT>* pIndices, float* pfError,
+                           std::vector<UINT>* pCorners )
+{
+    assert( NULL != pPositions && NULL != pIndices && NULL != pfError );
+
+    *pfError = 0.0f;
+    if( pIndices->empty() )
+    {
+        return S_OK;
+    }
+
+    std::vector<UINT> Vertices( *pIndices );
+    std::sort( Vertices.begin(), Vertices.end() );
+    Vertices.erase( std::unique( Vertices.begin(), Vertices.end() ), Vertices.end() );
+    std::vector<XMFLOAT3> Positions( Vertices.size() );
+    for( UINT v = 0; v < (UINT)Vertices.size(); v++ )
+    {
+        Positions[v] = pPositions[Vertices[v]];
+    }
+    for( UINT i = 0; i < (UINT)pIndices->size(); i++ )
+    {
+        ( *pIndices )[i] = (UINT)( std::lower_bound( Vertices.begin(), Vertices.end(), ( *pIndices )[i] ) - Vertices.begin() );
+    }
+
+    HRESULT hr = SimplifyMesh( &Positions[0], (UINT)Positions.size(), NULL, uTargetTriangles, pIndices, pfError, pCorners );
+    for( UINT i = 0; i < (UINT)pIndices->size(); i++ )
+    {
+        ( *pIndices )[i] = Vertices[( *pIndices )[i]];
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Simplifies one run of a subset
+//--------------------------------------------------------------------------------------
+static void SimplifyRunTask( void* pContext, UINT uTask, UINT uWorker )
+{
+    UNREFERENCED_PARAMETER( uWorker );
+
+    SIMPLIFY_CONTEXT* pSimplify = (SIMPLIFY_CONTEXT*)pContext;
+    SIMPLIFY_RUN& Run = ( *pSimplify->pRuns )[uTask];
+    Run.Indices.assign( pSimplify->pIndices->begin() + Run.uFirstIndex, pSimplify->pIndices->begin() + Run.uFirstIndex + Run.uNumIndices );
+    Run.Corners.assign( pSimplify->pCorners->begin() + Run.uFirstIndex, pSimplify->pCorners->begin() + Run.uFirstIndex + Run.uNumIndices );
+    UINT uTarget = std::max( (UINT)( std::max( pSimplify->fRatio, SIMPLIFY_RUN_MIN_RATIO ) * ( Run.uNumIndices / 3 ) ), 1u );
+    SimplifyTriangles( &( *pSimplify->pPositions )[0], uTarget, &Run.Indices, &Run.fError, &Run.Corners );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Simplifies the runs of a subset together, and gives the subset its own vertices in
+// the order the vertex cache fetches them
+//--------------------------------------------------------------------------------------
+static void SimplifySubsetTask( void* pContext, UINT uTask, UINT uWorker )
+{
+    UNREFERENCED_PARAMETER( uWorker );
+
+    SIMPLIFY_CONTEXT* pSimplify = (SIMPLIFY_CONTEXT*)pContext;
+    SIMPLIFY_SUBSET& Subset = ( *pSimplify->pSubsets )[uTask];
+    Subset.Indices.clear();
+    Subset.Corners.clear();
+    Subset.Vertices.clear();
+    float fRunError = 0.0f;
+    for( UINT r = Subset.uFirstRun; r < Subset.uFirstRun + Subset.uNumRuns; r++ )
+    {
+        SIMPLIFY_RUN& Run = ( *pSimplify->pRuns )[r];
+        Subset.Indices.insert( Subset.Indices.end(), Run.Indices.begin(), Run.Indices.end() );
+        Subset.Corners.insert( Subset.Corners.end(), Run.Corners.begin(), Run.Corners.end() );
+        fRunError = std::max( fRunError, Run.fError );
+        std::vector<UINT>().swap( Run.Indices );
+        std::vector<UINT>().swap( Run.Corners );
+    }
+    Subset.fError = fRunError;
+    if( Subset.uNumRuns > 1 )
+    {
+        float fError = 0.0f;
+        UINT uTarget = std::max( (UINT)( pSimplify->fRatio * Subset.uNumSourceTriangles ), 1u );
+        SimplifyTriangles( &( *pSimplify->pPositions )[0], uTarget, &Subset.Indices, &fError, &Subset.Corners );
+        Subset.fError += fError;
+    }
+    if( Subset.Corners.empty() )
+    {
+        return;
+    }
+
+    // The triangles are drawn with the vertices at their corners
+    Subset.Indices.swap( Subset.Corners );
+    std::vector<UINT>().swap( Subset.Corners );
+    std::vector<UINT> Vertices( Subset.Indices );
+    std::sort( Vertices.begin(), Vertices.end() );
+    Vertices.erase( std::unique( Vertices.begin(), Vertices.end() ), Vertices.end() );
+    for( UINT i = 0; i < (UINT)Subset.Indices.size(); i++ )
+    {
+        Subset.Indices[i] = (UINT)( std::lower_bound( Vertices.begin(), Vertices.end(), Subset.Indices[i] ) - Vertices.begin() );
+    }
+    UINT uNumVertices = (UINT)Vertices.size();
+    OptimizeVertexCache( &Subset.Indices[0], (UINT)Subset.Indices.size(), uNumVertices );
+    std::vector<UINT> Remap( uNumVertices );
+    OptimizeVertexFetch( &Subset.Indices[0], (UINT)Subset.Indices.size(), uNumVertices, &Remap[0] );
+    Subset.Vertices.resize( uNumVertices );
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        Subset.Vertices[Remap[v]] = ( *pSimplify->pVertices )[Vertices[v]];
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the key of a cell of the weld grid. Cells 2^21 apart share a key, which only
+// costs distance tests.
+//--------------------------------------------------------------------------------------
+static UINT64 GetWeldCellKey( int iX, int iY, int iZ )
+{
+    return ( (UINT64)( iX & 0x1FFFFF ) << 42 ) | ( (UINT64)( iY & 0x1FFFFF ) << 21 ) | (UINT64)( iZ & 0x1FFFFF );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the welded position within the tolerance of a position, searching the cells of
+// the weld grid around its own, or UINT_MAX if there is none
+//--------------------------------------------------------------------------------------
+static UINT FindWeldedPosition( const XMFLOAT3& f3Position, const int iCell[3], float fToleranceSq,
+                                const std::map<UINT64, UINT>& FirstInCell, const std::vector<UINT>& NextInCell,
+                                const std::vector<XMFLOAT3>& Positions )
+{
+    XMVECTOR vPosition = XMLoadFloat3( &f3Position );
+    for( int iZ = iCell[2] - 1; iZ <= iCell[2] + 1; iZ++ )
+    {
+        for( int iY = iCell[1] - 1; iY <= iCell[1] + 1; iY++ )
+        {
+            for( int iX = iCell[0] - 1; iX <= iCell[0] + 1; iX++ )
+            {
+                std::map<UINT64, UINT>::const_iterator it = FirstInCell.find( GetWeldCellKey( iX, iY, iZ ) );
+                if( it == FirstInCell.end() )
+                {
+                    continue;
+                }
+
+                for( UINT p = it->second; UINT_MAX != p; p = NextInCell[p] )
+                {
+                    if( XMVectorGetX( XMVector3LengthSq( XMVectorSubtract( XMLoadFloat3( &Positions[p] ), vPosition ) ) ) <= fToleranceSq )
+                    {
+                        return p;
+                    }
+                }
+            }
+        }
+    }
+
+    return UINT_MAX;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Welds the positions within the tolerance, searched on a grid of cells the size of the
+// tolerance so positions either side of a cell boundary are joined
+//--------------------------------------------------------------------------------------
+void WeldPositionsWithinTolerance( const MESH_DATA* pMeshData, float fTolerance, std::vector<UINT>* pWelded,
+                                   std::vector<XMFLOAT3>* pPositions )
+{
+    assert( NULL != pMeshData && NULL != pWelded && NULL != pPositions );
+    assert( fTolerance > 0.0f );
+
+    UINT uNumVertices = (UINT)pMeshData->Vertices.size();
+    pWelded->resize( uNumVertices );
+    pPositions->clear();
+
+    std::map<UINT64, UINT> FirstInCell;
+    std::vector<UINT> NextInCell;
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        const XMFLOAT3& f3Position = pMeshData->Vertices[v].f3Position;
+        int iCell[3] = { (int)floorf( f3Position.x / fTolerance ), (int)floorf( f3Position.y / fTolerance ), (int)floorf( f3Position.z / fTolerance ) };
+        UINT uWelded = FindWeldedPosition( f3Position, iCell, fTolerance * fTolerance, FirstInCell, NextInCell, *pPositions );
+        if( UINT_MAX == uWelded )
+        {
+            uWelded = (UINT)pPositions->size();
+            pPositions->push_back( f3Position );
+
+            UINT64 uKey = GetWeldCellKey( iCell[0], iCell[1], iCell[2] );
+            std::map<UINT64, UINT>::iterator it = FirstInCell.find( uKey );
+            NextInCell.push_back( ( it != FirstInCell.end() ) ? it->second : UINT_MAX );
+            FirstInCell[uKey] = uWelded;
+        }
+        ( *pWelded )[v] = uWelded;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Simplifies the subsets of a mesh
+//--------------------------------------------------------------------------------------
+HRESULT SimplifyMeshData( const MESH_DATA* pSource, float fRatio, CNumaTaskPool* pPool, MESH_DATA* pSimplified,
+                          MESH_SIMPLIFY_STATS* pStats )
+{
+    assert( NULL != pSource && NULL != pSimplified );
+
+    pSimplified->Vertices.clear();
+    pSimplified->Indices.clear();
+    pSimplified->Subsets.clear();
+    if( pSource->Vertices.empty() || !( fRatio > 0.0f && fRatio <= 1.0f ) )
+    {
+        return E_INVALIDARG;
+    }
+
+    // Runs of the Morton order are compact, so few of their edges are open
+    MESH_DATA Ordered = *pSource;
+    ReorderPatches( &Ordered, PATCH_ORDER_MORTON, 0.0f, 0 );
+
+    // The triangles are simplified on the vertices welded by position, so the surface is
+    // closed across the seams, with the vertices welded by all attributes at the corners
+    UINT uNumSourceVertices = (UINT)Ordered.Vertices.size();
+    std::vector<UINT> Order( uNumSourceVertices );
+    for( UINT v = 0; v < uNumSourceVertices; v++ )
+    {
+        Order[v] = v;
+    }
+    SIMPLIFY_VERTEX_LESS VertexLess = { &Ordered.Vertices[0] };
+    std::sort( Order.begin(), Order.end(), VertexLess );
+    std::vector<UINT> Welded( uNumSourceVertices );
+    std::vector<PN_VERTEX> Vertices;
+    for( UINT i = 0; i < uNumSourceVertices; i++ )
+    {
+        if( 0 == i || VertexLess( Order[i - 1], Order[i] ) )
+        {
+            Vertices.push_back( Ordered.Vertices[Order[i]] );
+        }
+        Welded[Order[i]] = (UINT)Vertices.size() - 1;
+    }
+
+    // Positions within SIMPLIFY_WELD_TOLERANCE are welded, joining the copies of a vertex
+    // along a seam that differ in the last bits
+    float fTolerance = std::max( SIMPLIFY_WELD_TOLERANCE * GetMeshDataBoundsDiagonal( pSource ), FLT_MIN );
+    std::vector<UINT> WeldedPositions;
+    std::vector<XMFLOAT3> Positions;
+    WeldPositionsWithinTolerance( &Ordered, fTolerance, &WeldedPositions, &Positions );
+    std::vector<UINT> Corners( Ordered.Indices.size() );
+    for( UINT i = 0; i < (UINT)Ordered.Indices.size(); i++ )
+    {
+        Corners[i] = Welded[Ordered.Indices[i]];
+        Ordered.Indices[i] = WeldedPositions[Ordered.Indices[i]];
+    }
+
+    std::vector<SIMPLIFY_SUBSET> Subsets( Ordered.Subsets.size() );
+    std::vector<SIMPLIFY_RUN> Runs;
+    for( UINT s = 0; s < (UINT)Ordered.Subsets.size(); s++ )
+    {
+        const MESH_DATA_SUBSET& Source = Ordered.Subsets[s];
+        Subsets[s].uNumSourceTriangles = Source.uIndexCount / 3;
+        Subsets[s].uFirstRun = (UINT)Runs.size();
+        for( UINT uTriangle = 0; uTriangle < Subsets[s].uNumSourceTriangles; uTriangle += SIMPLIFY_TASK_TRIANGLES )
+        {
+            SIMPLIFY_RUN Run;
+            Run.uFirstIndex = Source.uIndexStart + uTriangle * 3;
+            Run.uNumIndices = std::min( SIMPLIFY_TASK_TRIANGLES, Subsets[s].uNumSourceTriangles - uTriangle ) * 3;
+            Run.fError = 0.0f;
+            Runs.push_back( Run );
+        }
+        Subsets[s].uNumRuns = (UINT)Runs.size() - Subsets[s].uFirstRun;
+    }
+
+    SIMPLIFY_CONTEXT Context = { &Vertices, &Positions, &Ordered.Indices, &Corners, &Runs, &Subsets, fRatio };
+    if( NULL != pPool && Runs.size() > 1 )
+    {
+        pPool->Run( SimplifyRunTask, &Context, (UINT)Runs.size(), NULL, true );
+        pPool->Run( SimplifySubsetTask, &Context, (UINT)Subsets.size(), NULL, true );
+    }
+    else
+    {
+        for( UINT r = 0; r < (UINT)Runs.size(); r++ )
+        {
+            SimplifyRunTask( &Context, r, 0 );
+        }
+        for( UINT s = 0; s < (UINT)Subsets.size(); s++ )
+        {
+            SimplifySubsetTask( &Context, s, 0 );
+        }
+    }
+
+    // In subset order, so the vertices of each sdkmesh mesh stay contiguous
+    float fError = 0.0f;
+    XMVECTOR vMin = XMVectorReplicate( FLT_MAX );
+    XMVECTOR vMax = XMVectorReplicate( -FLT_MAX );
+    for( UINT s = 0; s < (UINT)Subsets.size(); s++ )
+    {
+        const SIMPLIFY_SUBSET& Subset = Subsets[s];
+        MESH_DATA_SUBSET Simplified = Ordered.Subsets[s];
+        Simplified.uIndexStart = (UINT)pSimplified->Indices.size();
+        Simplified.uIndexCount = (UINT)Subset.Indices.size();
+        pSimplified->Subsets.push_back( Simplified );
+
+        UINT uBase = (UINT)pSimplified->Vertices.size();
+        for( UINT i = 0; i < (UINT)Subset.Indices.size(); i++ )
+        {
+            pSimplified->Indices.push_back( uBase + Subset.Indices[i] );
+        }
+        for( UINT v = 0; v < (UINT)Subset.Vertices.size(); v++ )
+        {
+            vMin = XMVectorMin( vMin, XMLoadFloat3( &Subset.Vertices[v].f3Position ) );
+            vMax = XMVectorMax( vMax, XMLoadFloat3( &Subset.Vertices[v].f3Position ) );
+        }
+        pSimplified->Vertices.insert( pSimplified->Vertices.end(), Subset.Vertices.begin(), Subset.Vertices.end() );
+        fError = std::max( fError, Subset.fError );
+    }
+    if( pSimplified->Vertices.empty() )
+    {
+        vMin = vMax = XMVectorZero();
+    }
+    XMStoreFloat3( &pSimplified->f3BoundsMin, vMin );
+    XMStoreFloat3( &pSimplified->f3BoundsMax, vMax );
+
+    if( NULL != pStats )
+    {
+        pStats->uNumTasks = (UINT)Runs.size();
+        pStats->fError = fError;
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: MeshSimplify.h
+//
+// Simplification of indexed triangle meshes by half edge collapses in quadric error order
+// (see Quadric.h). A collapse moves a vertex onto a neighbour, so no vertex is created or
+// moved, and the vertices on open or non-manifold edges are locked. A part of a mesh cut
+// along its edges is thus simplified on its own and still joins the rest of the mesh.
+//
+// SimplifyMeshData builds coarse base meshes from the subsets of an sdkmesh. The triangles
+// are collapsed on their positions, with the vertex of all attributes at each corner
+// following the collapses. A vertex on a UV seam or a normal crease only moves along it,
+// onto the next vertex of the seam on both sides, so seams stay closed, and each subset
+// is simplified on its own, so the edges between subsets stay. The vertices kept keep
+// their normals, the ones the PN-Triangles surface is rebuilt from.
+//--------------------------------------------------------------------------------------
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+#include "MeshData.h"
+#include "NumaTaskPool.h"
+
+// A collapse may turn the normal of a triangle around it by at most the angle of this cosine
+static const float SIMPLIFY_MIN_FLIP_COSINE = 0.2f;
+
+// Passes over the remaining edges once the queue runs dry, retrying the collapses a
+// neighbouring collapse had blocked
+static const UINT SIMPLIFY_MAX_PASSES = 4;
+
+// Distance, relative to the bounds diagonal, within which positions are welded into one
+// vertex of the surface the triangles are collapsed on
+static const float SIMPLIFY_WELD_TOLERANCE = 1.0e-4f;
+
+// Triangles of a subset simplified per worker task, in runs of its Morton order, before
+// a last pass over the whole subset removes what the runs had to keep along their ends
+static const UINT SIMPLIFY_TASK_TRIANGLES = 8192;
+
+// Share of its triangles a run keeps at least. Collapses chosen within a run cannot see
+// the cheaper ones past its ends, so the last pass is left the coarsest ones.
+static const float SIMPLIFY_RUN_MIN_RATIO = 0.25f;
+
+struct MESH_SIMPLIFY_STATS
+{
+    UINT    uNumTasks;              // Runs of the first pass
+    float   fError;                 // Sum of the largest errors of both passes
+};
+
+
+//--------------------------------------------------------------------------------------
+// Welds the vertices of a mesh by position, with the mean normal and the texture coords of
+// the first one, and returns its triangles of welded vertices without the degenerate ones
+//--------------------------------------------------------------------------------------
+void WeldPositions( const MESH_DATA* pMeshData, std::vector<PN_VERTEX>* pVertices, std::vector<UINT>* pIndices );
+
+
+//--------------------------------------------------------------------------------------
+// Welds the position of each vertex of a mesh, in order, into the first position welded
+// before it within fTolerance, or adds it to pPositions. pWelded receives the welded
+// position of each vertex.
+//--------------------------------------------------------------------------------------
+void WeldPositionsWithinTolerance( const MESH_DATA* pMeshData, float fTolerance, std::vector<UINT>* pWelded,
+                                   std::vector<DirectX::XMFLOAT3>* pPositions );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the squared distance of a point to a triangle
+//--------------------------------------------------------------------------------------
+float GetPointTriangleDistanceSq( DirectX::FXMVECTOR vPoint, DirectX::FXMVECTOR vA, DirectX::FXMVECTOR vB, DirectX::GXMVECTOR vC );
+
+
+//--------------------------------------------------------------------------------------
+// Collapses the edges of the triangles in pIndices, cheapest first, until at most
+// uTargetTriangles remain or no collapse is allowed, and removes the degenerate triangles.
+// pbLocked, which may be NULL, locks more vertices. pfError receives the largest distance
+// of a collapsed vertex to the triangles around the vertex it went to. pCorners, which may
+// be NULL, holds a vertex of any other numbering for each index, the same for the corners
+// of a vertex that are not split by a seam; it is collapsed along and kept in step with
+// pIndices.
+//--------------------------------------------------------------------------------------
+HRESULT SimplifyMesh( const DirectX::XMFLOAT3* pPositions, UINT uNumVertices, const BYTE* pbLocked, UINT uTargetTriangles,
+                      std::vector<UINT>* pIndices, float* pfError, std::vector<UINT>* pCorners = NULL );
+
+
+//--------------------------------------------------------------------------------------
+// SimplifyMesh on the vertices the triangles use only, for a few triangles of a large
+// mesh. The indices stay those of pPositions, and pCorners, which may be NULL, those of
+// its own numbering.
+//--------------------------------------------------------------------------------------
+HRESULT SimplifyTriangles( const DirectX::XMFLOAT3* pPositions, UINT uTargetTriangles, std::vector<UINT>* pIndices, float* pfError,
+                           std::vector<UINT>* pCorners = NULL );
+
+
+//--------------------------------------------------------------------------------------
+// Simplifies each subset of pSource to fRatio (0 to 1] of its triangles, over the workers
+// of pPool, which may be NULL, into pSimplified with the same subsets in the same order.
+// The vertices of each subset are its own, reordered for the vertex cache, so the data
+// can be written back with WriteSDKMesh. pStats may be NULL.
+//--------------------------------------------------------------------------------------
+HRESULT SimplifyMeshData( const MESH_DATA* pSource, float fRatio, CNumaTaskPool* pPool, MESH_DATA* pSimplified,
+                          MESH_SIMPLIFY_STATS* pStats );
+
+#endif
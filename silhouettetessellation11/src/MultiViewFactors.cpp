@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: MultiViewFactors.cpp
+//
+// CPU reference of the multi-view tess factors, and the stereo views of the sample.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "MultiViewFactors.h"
+
+using namespace DirectX;
+
+
+//--------------------------------------------------------------------------------------
+// Returns the MULTI_VIEW permutation of a HullShaderHash
+//--------------------------------------------------------------------------------------
+DWORD GetMultiViewTessFlags( DWORD dwFlags )
+{
+    return ( dwFlags & ~( FOVEA_ADAPT | MOTION_ADAPT ) ) | MULTI_VIEW;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates a patch for several views, sharing the view independent work
+//--------------------------------------------------------------------------------------
+void EvaluateMultiViewPatch( const PN_VERTEX* pCorners, DWORD dwFlags, const TESS_FACTOR_CONSTANTS* pViews, UINT uNumViews,
+                             MULTI_VIEW_PATCH* pPatch )
+{
+    assert( NULL != pCorners );
+    assert( NULL != pViews );
+    assert( NULL != pPatch );
+    assert( uNumViews <= TESS_MAX_VIEWS );
+
+    ZeroMemory( pPatch, sizeof( *pPatch ) );
+    dwFlags = GetMultiViewTessFlags( dwFlags );
+
+    // Once per patch
+    if( dwFlags & PNTRI )
+    {
+        ComputePNControlPoints( pCorners, &pPatch->ControlPoints );
+    }
+    TESS_PATCH_SETUP Setup;
+    SetupTessPatch( pCorners, &Setup );
+
+    // Once per view
+    for( UINT uView = 0; uView < uNumViews; uView++ )
+    {
+        PATCH_TESS_FACTORS* pViewFactors = &pPatch->ViewFactors[uView];
+        if( !GetViewTessFactors( &Setup, dwFlags, &pViews[uView], pViewFactors ) )
+        {
+            continue;
+        }
+
+        pPatch->uViewMask |= 1 << uView;
+        for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+        {
+            pPatch->Factors.fEdge[uEdge] = std::max( pPatch->Factors.fEdge[uEdge], pViewFactors->fEdge[uEdge] );
+        }
+    }
+
+    // Culled if it is culled in every view
+    if( 0 != pPatch->uViewMask )
+    {
+        pPatch->Factors.fInside = ( pPatch->Factors.fEdge[0] + pPatch->Factors.fEdge[1] + pPatch->Factors.fEdge[2] ) / 3.0f;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the views of the left and right eyes
+//--------------------------------------------------------------------------------------
+void GetStereoViews( CXMMATRIX mView, float fEyeSeparation, XMMATRIX* pmLeftView, XMMATRIX* pmRightView )
+{
+    assert( NULL != pmLeftView );
+    assert( NULL != pmRightView );
+
+    // Moving an eye right moves the view space left
+    *pmLeftView = XMMatrixMultiply( mView, XMMatrixTranslation( 0.5f * fEyeSeparation, 0.0f, 0.0f ) );
+    *pmRightView = XMMatrixMultiply( mView, XMMatrixTranslation( -0.5f * fEyeSeparation, 0.0f, 0.0f ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the projection of an eye rendered to half the width of the viewport
+//--------------------------------------------------------------------------------------
+XMMATRIX GetStereoProjection( CXMMATRIX mProj )
+{
+    // Halving the aspect ratio doubles the x scale
+    return XMMatrixMultiply( mProj, XMMatrixScaling( 2.0f, 1.0f, 1.0f ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: MultiViewFactors.h
+//
+// Multi-view tess factors (MULTI_VIEW), for rendering the tessellated mesh into several
+// views at once: the eyes of a stereo pair, the faces of a cube shadow map or the cascades
+// of a directional shadow map. Drawing each view on its own repeats the whole of
+// HS_PNTrianglesConstant per view, though only the culling and the adaptive terms depend
+// on the view. The MULTI_VIEW hull shader sets up the edge normals and the control points
+// of a patch once, evaluates the culling and factors of up to TESS_MAX_VIEWS views and
+// outputs
+//
+//      - the largest factors of the views the patch is visible in, as the tessellator
+//        runs once for all of them
+//      - the mask of the views the patch is visible in, which GS_MultiView copies the
+//        tessellated triangles to (SV_ViewportArrayIndex)
+//
+// The foveated and motion terms follow a single eye and camera, and are left out of
+// the permutation (GetMultiViewTessFlags).
+//--------------------------------------------------------------------------------------
+#ifndef MULTI_VIEW_FACTORS_H
+#define MULTI_VIEW_FACTORS_H
+
+#include "TessFactors.h"
+
+// Views of a MULTI_VIEW pass, as MULTI_VIEW_MAX_VIEWS in SilhouetteTessellation11.hlsl
+static const UINT TESS_MAX_VIEWS = 8;
+
+// A patch evaluated for several views
+struct MULTI_VIEW_PATCH
+{
+    PN_CONTROL_POINTS   ControlPoints;                  // View independent, set up once if PNTRI
+    PATCH_TESS_FACTORS  ViewFactors[TESS_MAX_VIEWS];    // All 0 in the views the patch is culled in
+    PATCH_TESS_FACTORS  Factors;                        // As output by the MULTI_VIEW hull shader
+    UINT                uViewMask;                      // Bit v is set if the patch is visible in view v
+};
+
+
+//--------------------------------------------------------------------------------------
+// Returns the MULTI_VIEW permutation of a HullShaderHash, without the terms that are
+// not evaluated per view
+//--------------------------------------------------------------------------------------
+DWORD GetMultiViewTessFlags( DWORD dwFlags );
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates a patch with world space corners for uNumViews views as the MULTI_VIEW hull
+// shader does with the dwFlags permutation (after GetMultiViewTessFlags)
+//--------------------------------------------------------------------------------------
+void EvaluateMultiViewPatch( const PN_VERTEX* pCorners, DWORD dwFlags, const TESS_FACTOR_CONSTANTS* pViews, UINT uNumViews,
+                             MULTI_VIEW_PATCH* pPatch );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the views of the left and right eyes, fEyeSeparation apart along the x axis
+// of mView and looking parallel to it
+//--------------------------------------------------------------------------------------
+void GetStereoViews( DirectX::CXMMATRIX mView, float fEyeSeparation, DirectX::XMMATRIX* pmLeftView, DirectX::XMMATRIX* pmRightView );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the projection of an eye rendered to half the width of the viewport of mProj,
+// with the same vertical field of view
+//--------------------------------------------------------------------------------------
+DirectX::XMMATRIX GetStereoProjection( DirectX::CXMMATRIX mProj );
+
+#endif
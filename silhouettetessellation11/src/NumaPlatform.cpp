@@ -0,0 +1,382 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: NumaPlatform.cpp
+//
+// The OS calls behind CNumaTaskPool.
+//--------------------------------------------------------------------------------------
+#ifdef _WIN32
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "NumaPlatform.h"
+#else
+#include "NumaPlatform.h"
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+//--------------------------------------------------------------------------------------
+// Events
+//--------------------------------------------------------------------------------------
+bool CreateNumaEvent( NUMA_EVENT* pEvent )
+{
+    pEvent->hEvent = CreateEvent( NULL, FALSE, FALSE, NULL );
+    return NULL != pEvent->hEvent;
+}
+
+void DestroyNumaEvent( NUMA_EVENT* pEvent )
+{
+    if( NULL != pEvent->hEvent )
+    {
+        CloseHandle( pEvent->hEvent );
+        pEvent->hEvent = NULL;
+    }
+}
+
+void SetNumaEvent( NUMA_EVENT* pEvent )
+{
+    SetEvent( pEvent->hEvent );
+}
+
+void WaitNumaEvent( NUMA_EVENT* pEvent )
+{
+    WaitForSingleObject( pEvent->hEvent, INFINITE );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Threads
+//--------------------------------------------------------------------------------------
+static DWORD WINAPI NumaThreadProc( LPVOID pParam )
+{
+    NUMA_THREAD* pThread = (NUMA_THREAD*)pParam;
+    pThread->pfnThread( pThread->pParam );
+
+    return 0;
+}
+
+bool CreateNumaThread( NUMA_THREAD* pThread, LPNUMATHREAD pfnThread, void* pParam )
+{
+    pThread->pfnThread = pfnThread;
+    pThread->pParam = pParam;
+    pThread->hThread = CreateThread( NULL, 0, NumaThreadProc, pThread, 0, NULL );
+
+    return NULL != pThread->hThread;
+}
+
+void JoinNumaThread( NUMA_THREAD* pThread )
+{
+    WaitForSingleObject( pThread->hThread, INFINITE );
+    CloseHandle( pThread->hThread );
+    pThread->hThread = NULL;
+}
+
+void SetNumaThreadAffinity( const NUMA_AFFINITY* pAffinity )
+{
+    if( 0 != pAffinity->Mask )
+    {
+        SetThreadGroupAffinity( GetCurrentThread(), pAffinity, NULL );
+    }
+}
+
+LONG NumaInterlockedIncrement( volatile LONG* plValue )
+{
+    return InterlockedIncrement( plValue );
+}
+
+LONG NumaInterlockedDecrement( volatile LONG* plValue )
+{
+    return InterlockedDecrement( plValue );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Nodes
+//--------------------------------------------------------------------------------------
+bool GetNumaHighestNode( UINT* puHighestNode )
+{
+    ULONG uHighestNode = 0;
+    if( !GetNumaHighestNodeNumber( &uHighestNode ) )
+    {
+        return false;
+    }
+
+    *puHighestNode = (UINT)uHighestNode;
+    return true;
+}
+
+bool GetNumaNodeAffinity( UINT uNode, NUMA_AFFINITY* pAffinity )
+{
+    ZeroMemory( pAffinity, sizeof( *pAffinity ) );
+    return FALSE != GetNumaNodeProcessorMaskEx( (USHORT)uNode, pAffinity );
+}
+
+bool GetProcessNumaAffinity( NUMA_AFFINITY* pAffinity )
+{
+    ZeroMemory( pAffinity, sizeof( *pAffinity ) );
+
+    DWORD_PTR ProcessMask = 0, SystemMask = 0;
+    if( !GetProcessAffinityMask( GetCurrentProcess(), &ProcessMask, &SystemMask ) )
+    {
+        return false;
+    }
+
+    pAffinity->Mask = (KAFFINITY)ProcessMask;
+    return true;
+}
+
+UINT CountNumaProcessors( const NUMA_AFFINITY* pAffinity )
+{
+    UINT uCount = 0;
+    for( KAFFINITY Mask = pAffinity->Mask; 0 != Mask; Mask &= Mask - 1 )
+    {
+        uCount++;
+    }
+
+    return uCount;
+}
+
+UINT GetNumProcessors()
+{
+    SYSTEM_INFO SystemInfo;
+    GetSystemInfo( &SystemInfo );
+
+    return (UINT)SystemInfo.dwNumberOfProcessors;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Memory
+//--------------------------------------------------------------------------------------
+void* AllocateNumaPages( SIZE_T uBytes, USHORT uNode )
+{
+    void* pMemory = VirtualAllocExNuma( GetCurrentProcess(), NULL, uBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, uNode );
+    if( NULL == pMemory )
+    {
+        pMemory = VirtualAlloc( NULL, uBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+    }
+
+    return pMemory;
+}
+
+void FreeNumaPages( void* pMemory )
+{
+    VirtualFree( pMemory, 0, MEM_RELEASE );
+}
+
+#else
+
+//--------------------------------------------------------------------------------------
+// Events
+//--------------------------------------------------------------------------------------
+bool CreateNumaEvent( NUMA_EVENT* pEvent )
+{
+    pEvent->bSignaled = false;
+    if( 0 != pthread_mutex_init( &pEvent->Mutex, NULL ) )
+    {
+        return false;
+    }
+    if( 0 != pthread_cond_init( &pEvent->Cond, NULL ) )
+    {
+        pthread_mutex_destroy( &pEvent->Mutex );
+        return false;
+    }
+
+    return true;
+}
+
+void DestroyNumaEvent( NUMA_EVENT* pEvent )
+{
+    pthread_cond_destroy( &pEvent->Cond );
+    pthread_mutex_destroy( &pEvent->Mutex );
+}
+
+void SetNumaEvent( NUMA_EVENT* pEvent )
+{
+    pthread_mutex_lock( &pEvent->Mutex );
+    pEvent->bSignaled = true;
+    pthread_cond_signal( &pEvent->Cond );
+    pthread_mutex_unlock( &pEvent->Mutex );
+}
+
+void WaitNumaEvent( NUMA_EVENT* pEvent )
+{
+    pthread_mutex_lock( &pEvent->Mutex );
+    while( !pEvent->bSignaled )
+    {
+        pthread_cond_wait( &pEvent->Cond, &pEvent->Mutex );
+    }
+    pEvent->bSignaled = false;
+    pthread_mutex_unlock( &pEvent->Mutex );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Threads
+//--------------------------------------------------------------------------------------
+static void* NumaThreadProc( void* pParam )
+{
+    NUMA_THREAD* pThread = (NUMA_THREAD*)pParam;
+    pThread->pfnThread( pThread->pParam );
+
+    return NULL;
+}
+
+bool CreateNumaThread( NUMA_THREAD* pThread, LPNUMATHREAD pfnThread, void* pParam )
+{
+    pThread->pfnThread = pfnThread;
+    pThread->pParam = pParam;
+
+    return 0 == pthread_create( &pThread->Thread, NULL, NumaThreadProc, pThread );
+}
+
+void JoinNumaThread( NUMA_THREAD* pThread )
+{
+    pthread_join( pThread->Thread, NULL );
+}
+
+void SetNumaThreadAffinity( const NUMA_AFFINITY* pAffinity )
+{
+    if( 0 != CPU_COUNT( pAffinity ) )
+    {
+        sched_setaffinity( 0, sizeof( *pAffinity ), pAffinity );
+    }
+}
+
+LONG NumaInterlockedIncrement( volatile LONG* plValue )
+{
+    return __sync_add_and_fetch( plValue, 1 );
+}
+
+LONG NumaInterlockedDecrement( volatile LONG* plValue )
+{
+    return __sync_sub_and_fetch( plValue, 1 );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Nodes, from sysfs. Lists look like "0-7,16-23".
+//--------------------------------------------------------------------------------------
+static bool ReadSysfsList( const char* pszPath, NUMA_AFFINITY* pList, UINT* puHighest )
+{
+    CPU_ZERO( pList );
+    *puHighest = 0;
+
+    FILE* pFile = fopen( pszPath, "r" );
+    if( NULL == pFile )
+    {
+        return false;
+    }
+
+    unsigned int uFirst, uLast;
+    int iCount;
+    while( ( iCount = fscanf( pFile, "%u-%u", &uFirst, &uLast ) ) >= 1 )
+    {
+        if( 1 == iCount )
+        {
+            uLast = uFirst;
+        }
+        for( UINT u = uFirst; u <= uLast && u < CPU_SETSIZE; u++ )
+        {
+            CPU_SET( u, pList );
+        }
+        *puHighest = std::max( *puHighest, (UINT)uLast );
+
+        if( ',' != fgetc( pFile ) )
+        {
+            break;
+        }
+    }
+
+    fclose( pFile );
+    return true;
+}
+
+bool GetNumaHighestNode( UINT* puHighestNode )
+{
+    NUMA_AFFINITY Nodes;
+    return ReadSysfsList( "/sys/devices/system/node/possible", &Nodes, puHighestNode ) && 0 != CPU_COUNT( &Nodes );
+}
+
+bool GetNumaNodeAffinity( UINT uNode, NUMA_AFFINITY* pAffinity )
+{
+    char szPath[64];
+    snprintf( szPath, sizeof( szPath ), "/sys/devices/system/node/node%u/cpulist", uNode );
+
+    UINT uHighest;
+    return ReadSysfsList( szPath, pAffinity, &uHighest );
+}
+
+bool GetProcessNumaAffinity( NUMA_AFFINITY* pAffinity )
+{
+    CPU_ZERO( pAffinity );
+    return 0 == sched_getaffinity( 0, sizeof( *pAffinity ), pAffinity );
+}
+
+UINT CountNumaProcessors( const NUMA_AFFINITY* pAffinity )
+{
+    return (UINT)CPU_COUNT( pAffinity );
+}
+
+UINT GetNumProcessors()
+{
+    long lCount = sysconf( _SC_NPROCESSORS_ONLN );
+    return ( lCount > 0 ) ? (UINT)lCount : 1;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Memory. The pages go to the node of the thread that touches them first, so the
+// workers of a node initialize its memory. The size lives in a header page for munmap.
+//--------------------------------------------------------------------------------------
+void* AllocateNumaPages( SIZE_T uBytes, USHORT uNode )
+{
+    (void)uNode;
+
+    SIZE_T uPageSize = (SIZE_T)sysconf( _SC_PAGESIZE );
+    SIZE_T uTotalBytes = uBytes + uPageSize;
+    void* pPages = mmap( NULL, uTotalBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if( MAP_FAILED == pPages )
+    {
+        return NULL;
+    }
+
+    *(SIZE_T*)pPages = uTotalBytes;
+    return (char*)pPages + uPageSize;
+}
+
+void FreeNumaPages( void* pMemory )
+{
+    SIZE_T uPageSize = (SIZE_T)sysconf( _SC_PAGESIZE );
+    void* pPages = (char*)pMemory - uPageSize;
+    munmap( pPages, *(SIZE_T*)pPages );
+}
+
+#endif
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: NumaPlatform.h
+//
+// The OS calls behind CNumaTaskPool: NUMA nodes, node local memory, pinned threads and
+// events. Windows uses the Win32 NUMA functions. Linux reads the nodes from sysfs, pins
+// with sched_setaffinity and relies on first touch to place the memory, so it needs
+// neither libnuma nor a NUMA aware kernel configuration.
+//--------------------------------------------------------------------------------------
+#ifndef NUMA_PLATFORM_H
+#define NUMA_PLATFORM_H
+
+#ifdef _WIN32
+
+// Windows types come from DXUT.h, included first like everywhere else
+typedef GROUP_AFFINITY  NUMA_AFFINITY;
+
+#else
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+typedef unsigned int    UINT;
+typedef unsigned short  USHORT;
+typedef int32_t         LONG;
+typedef size_t          SIZE_T;
+typedef int32_t         HRESULT;
+
+#ifndef S_OK
+#define S_OK            ((HRESULT)0)
+#define E_FAIL          ((HRESULT)0x80004005L)
+#define ZeroMemory( p, n ) memset( ( p ), 0, ( n ) )
+#endif
+
+typedef cpu_set_t       NUMA_AFFINITY;
+
+#endif
+
+
+//--------------------------------------------------------------------------------------
+// Auto reset event
+//--------------------------------------------------------------------------------------
+struct NUMA_EVENT
+{
+#ifdef _WIN32
+    HANDLE          hEvent;
+#else
+    pthread_mutex_t Mutex;
+    pthread_cond_t  Cond;
+    bool            bSignaled;
+#endif
+};
+
+bool CreateNumaEvent( NUMA_EVENT* pEvent );
+void DestroyNumaEvent( NUMA_EVENT* pEvent );
+void SetNumaEvent( NUMA_EVENT* pEvent );
+void WaitNumaEvent( NUMA_EVENT* pEvent );
+
+
+//--------------------------------------------------------------------------------------
+// Thread, the structure must stay in place until JoinNumaThread returns
+//--------------------------------------------------------------------------------------
+typedef void (*LPNUMATHREAD)( void* pParam );
+
+struct NUMA_THREAD
+{
+#ifdef _WIN32
+    HANDLE          hThread;
+#else
+    pthread_t       Thread;
+#endif
+    LPNUMATHREAD    pfnThread;
+    void*           pParam;
+};
+
+bool CreateNumaThread( NUMA_THREAD* pThread, LPNUMATHREAD pfnThread, void* pParam );
+void JoinNumaThread( NUMA_THREAD* pThread );
+
+// Pins the calling thread, does nothing for an affinity without processors
+void SetNumaThreadAffinity( const NUMA_AFFINITY* pAffinity );
+
+// Returns the new value
+LONG NumaInterlockedIncrement( volatile LONG* plValue );
+LONG NumaInterlockedDecrement( volatile LONG* plValue );
+
+
+//--------------------------------------------------------------------------------------
+// Nodes
+//--------------------------------------------------------------------------------------
+
+// Returns false without NUMA information
+bool GetNumaHighestNode( UINT* puHighestNode );
+
+// Returns false if the node does not exist, the affinity may have no processors
+bool GetNumaNodeAffinity( UINT uNode, NUMA_AFFINITY* pAffinity );
+
+// The processors the process may run on, returns false if unknown
+bool GetProcessNumaAffinity( NUMA_AFFINITY* pAffinity );
+
+UINT CountNumaProcessors( const NUMA_AFFINITY* pAffinity );
+UINT GetNumProcessors();
+
+
+//--------------------------------------------------------------------------------------
+// Committed, page aligned memory preferring a node, NULL on failure
+//--------------------------------------------------------------------------------------
+void* AllocateNumaPages( SIZE_T uBytes, USHORT uNode );
+void FreeNumaPages( void* pMemory );
+
+#endif
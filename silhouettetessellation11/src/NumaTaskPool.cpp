@@ -0,0 +1,392 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: NumaTaskPool.cpp
+//
+// Worker threads pinned to the processors of each NUMA node, and node local memory.
+//--------------------------------------------------------------------------------------
+#ifdef _WIN32
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#endif
+#include "NumaTaskPool.h"
+
+
+//--------------------------------------------------------------------------------------
+// Returns the nodes that have processors, at least one
+//--------------------------------------------------------------------------------------
+void GetNumaNodes( std::vector<NUMA_NODE_INFO>* pNodes )
+{
+    assert( NULL != pNodes );
+
+    pNodes->clear();
+
+    UINT uHighestNode = 0;
+    if( GetNumaHighestNode( &uHighestNode ) )
+    {
+        for( UINT uNode = 0; uNode <= uHighestNode; uNode++ )
+        {
+            NUMA_NODE_INFO Node;
+            ZeroMemory( &Node, sizeof( Node ) );
+            Node.uNode = (USHORT)uNode;
+
+            // Nodes without processors (memory only) have nothing to run the tasks
+            if( GetNumaNodeAffinity( uNode, &Node.Affinity ) )
+            {
+                Node.uNumProcessors = CountNumaProcessors( &Node.Affinity );
+                if( 0 != Node.uNumProcessors )
+                {
+                    pNodes->push_back( Node );
+                }
+            }
+        }
+    }
+
+    // No NUMA information, run as a single node on the processors of the process
+    if( pNodes->empty() )
+    {
+        NUMA_NODE_INFO Node;
+        ZeroMemory( &Node, sizeof( Node ) );
+
+        if( GetProcessNumaAffinity( &Node.Affinity ) && 0 != CountNumaProcessors( &Node.Affinity ) )
+        {
+            Node.uNumProcessors = CountNumaProcessors( &Node.Affinity );
+        }
+        else
+        {
+            // Leave the workers unpinned
+            ZeroMemory( &Node.Affinity, sizeof( Node.Affinity ) );
+            Node.uNumProcessors = std::max( GetNumProcessors(), 1u );
+        }
+
+        pNodes->push_back( Node );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Allocates committed memory preferring the given node, falls back to any node
+//--------------------------------------------------------------------------------------
+void* AllocateNumaMemory( SIZE_T uBytes, USHORT uNode )
+{
+    return AllocateNumaPages( uBytes, uNode );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Frees memory from AllocateNumaMemory
+//--------------------------------------------------------------------------------------
+void FreeNumaMemory( void* pMemory )
+{
+    if( NULL != pMemory )
+    {
+        FreeNumaPages( pMemory );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CNumaTaskPool::CNumaTaskPool() :
+    m_bDoneEvent( false ),
+    m_lBusyWorkers( 0 ),
+    m_bQuit( false ),
+    m_pfnTask( NULL ),
+    m_pContext( NULL ),
+    m_puTaskNodes( NULL ),
+    m_bStealRemote( false )
+{
+    ZeroMemory( &m_Stats, sizeof( m_Stats ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CNumaTaskPool::~CNumaTaskPool()
+{
+    Destroy();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Starts the workers
+//--------------------------------------------------------------------------------------
+HRESULT CNumaTaskPool::Create( UINT uMaxNodes, UINT uMaxWorkersPerNode )
+{
+    Destroy();
+
+    GetNumaNodes( &m_Nodes );
+    if( 0 != uMaxNodes && m_Nodes.size() > uMaxNodes )
+    {
+        m_Nodes.resize( uMaxNodes );
+    }
+
+    m_bDoneEvent = CreateNumaEvent( &m_DoneEvent );
+    if( !m_bDoneEvent )
+    {
+        return E_FAIL;
+    }
+
+    m_bQuit = false;
+    for( UINT uNode = 0; uNode < (UINT)m_Nodes.size(); uNode++ )
+    {
+        UINT uNumWorkers = m_Nodes[uNode].uNumProcessors;
+        if( 0 != uMaxWorkersPerNode )
+        {
+            uNumWorkers = std::min( uNumWorkers, uMaxWorkersPerNode );
+        }
+
+        for( UINT i = 0; i < uNumWorkers; i++ )
+        {
+            WORKER* pWorker = new WORKER;
+            pWorker->pPool = this;
+            pWorker->uIndex = (UINT)m_Workers.size();
+            pWorker->uNode = uNode;
+            pWorker->lNextTask = 0;
+            pWorker->uNumLocal = 0;
+            pWorker->uNumStolenLocal = 0;
+            pWorker->uNumRemote = 0;
+            if( !CreateNumaEvent( &pWorker->StartEvent ) )
+            {
+                delete pWorker;
+                Destroy();
+                return E_FAIL;
+            }
+            if( !CreateNumaThread( &pWorker->Thread, WorkerThread, pWorker ) )
+            {
+                DestroyNumaEvent( &pWorker->StartEvent );
+                delete pWorker;
+                Destroy();
+                return E_FAIL;
+            }
+
+            m_Workers.push_back( pWorker );
+        }
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Stops the workers
+//--------------------------------------------------------------------------------------
+void CNumaTaskPool::Destroy()
+{
+    m_bQuit = true;
+    for( UINT i = 0; i < (UINT)m_Workers.size(); i++ )
+    {
+        SetNumaEvent( &m_Workers[i]->StartEvent );
+    }
+
+    for( UINT i = 0; i < (UINT)m_Workers.size(); i++ )
+    {
+        JoinNumaThread( &m_Workers[i]->Thread );
+        DestroyNumaEvent( &m_Workers[i]->StartEvent );
+        delete m_Workers[i];
+    }
+    m_Workers.clear();
+
+    if( m_bDoneEvent )
+    {
+        DestroyNumaEvent( &m_DoneEvent );
+        m_bDoneEvent = false;
+    }
+
+    m_Nodes.clear();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Runs the tasks and returns when all are done
+//--------------------------------------------------------------------------------------
+void CNumaTaskPool::Run( LPNUMATASK pfnTask, void* pContext, UINT uNumTasks, const UINT* puTaskNodes, bool bStealRemote )
+{
+    assert( NULL != pfnTask );
+    assert( !m_Workers.empty() );
+
+    ZeroMemory( &m_Stats, sizeof( m_Stats ) );
+    if( 0 == uNumTasks )
+    {
+        return;
+    }
+
+    // Deal the tasks of each node round robin to the node's workers
+    std::vector<UINT> NodeFirstWorker( m_Nodes.size() + 1, 0 );
+    for( UINT i = 0; i < (UINT)m_Workers.size(); i++ )
+    {
+        m_Workers[i]->Tasks.clear();
+        m_Workers[i]->lNextTask = 0;
+        m_Workers[i]->uNumLocal = 0;
+        m_Workers[i]->uNumStolenLocal = 0;
+        m_Workers[i]->uNumRemote = 0;
+        NodeFirstWorker[m_Workers[i]->uNode + 1] = i + 1;
+    }
+
+    std::vector<UINT> NodeNextWorker( NodeFirstWorker.begin(), NodeFirstWorker.end() - 1 );
+    for( UINT uTask = 0; uTask < uNumTasks; uTask++ )
+    {
+        UINT uWorker;
+        if( NULL != puTaskNodes )
+        {
+            UINT uNode = puTaskNodes[uTask];
+            assert( uNode < (UINT)m_Nodes.size() );
+
+            uWorker = NodeNextWorker[uNode];
+            NodeNextWorker[uNode] = ( uWorker + 1 < NodeFirstWorker[uNode + 1] ) ? uWorker + 1 : NodeFirstWorker[uNode];
+        }
+        else
+        {
+            uWorker = uTask % (UINT)m_Workers.size();
+        }
+
+        m_Workers[uWorker]->Tasks.push_back( uTask );
+    }
+
+    m_pfnTask = pfnTask;
+    m_pContext = pContext;
+    m_puTaskNodes = puTaskNodes;
+    m_bStealRemote = bStealRemote || ( NULL == puTaskNodes );
+
+    m_lBusyWorkers = (LONG)m_Workers.size();
+    for( UINT i = 0; i < (UINT)m_Workers.size(); i++ )
+    {
+        SetNumaEvent( &m_Workers[i]->StartEvent );
+    }
+    WaitNumaEvent( &m_DoneEvent );
+
+    for( UINT i = 0; i < (UINT)m_Workers.size(); i++ )
+    {
+        m_Stats.uNumLocal += m_Workers[i]->uNumLocal;
+        m_Stats.uNumStolenLocal += m_Workers[i]->uNumStolenLocal;
+        m_Stats.uNumRemote += m_Workers[i]->uNumRemote;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Pins the worker to its node and runs its share of each Run
+//--------------------------------------------------------------------------------------
+void CNumaTaskPool::WorkerThread( void* pParam )
+{
+    WORKER* pWorker = (WORKER*)pParam;
+    CNumaTaskPool* pPool = pWorker->pPool;
+
+    // Unpinned if the node has no processors (no NUMA information) or pinning fails
+    SetNumaThreadAffinity( &pPool->m_Nodes[pWorker->uNode].Affinity );
+
+    for( ;; )
+    {
+        WaitNumaEvent( &pWorker->StartEvent );
+        if( pPool->m_bQuit )
+        {
+            break;
+        }
+
+        pPool->RunWorker( pWorker );
+
+        if( 0 == NumaInterlockedDecrement( &pPool->m_lBusyWorkers ) )
+        {
+            SetNumaEvent( &pPool->m_DoneEvent );
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Runs the worker's own tasks, then steals from its node, then from the other nodes
+//--------------------------------------------------------------------------------------
+void CNumaTaskPool::RunWorker( WORKER* pWorker )
+{
+    UINT uNumWorkers = (UINT)m_Workers.size();
+    UINT uTask;
+
+    while( ClaimTask( pWorker, &uTask ) )
+    {
+        m_pfnTask( m_pContext, uTask, pWorker->uIndex );
+        pWorker->uNumLocal++;
+    }
+
+    for( UINT uPass = 0; uPass < 2; uPass++ )
+    {
+        bool bLocal = ( 0 == uPass );
+        if( !bLocal && !m_bStealRemote )
+        {
+            break;
+        }
+
+        // Start after this worker so the thieves spread over the victims
+        for( UINT i = 1; i < uNumWorkers; i++ )
+        {
+            WORKER* pVictim = m_Workers[( pWorker->uIndex + i ) % uNumWorkers];
+            if( ( pVictim->uNode == pWorker->uNode ) != bLocal )
+            {
+                continue;
+            }
+
+            while( ClaimTask( pVictim, &uTask ) )
+            {
+                m_pfnTask( m_pContext, uTask, pWorker->uIndex );
+
+                // Without task nodes all the tasks count as local
+                if( bLocal || NULL == m_puTaskNodes || m_puTaskNodes[uTask] == pWorker->uNode )
+                {
+                    pWorker->uNumLocal++;
+                    pWorker->uNumStolenLocal++;
+                }
+                else
+                {
+                    pWorker->uNumRemote++;
+                }
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Claims the next task queued to a worker, returns false if none are left
+//--------------------------------------------------------------------------------------
+bool CNumaTaskPool::ClaimTask( WORKER* pVictim, UINT* puTask )
+{
+    UINT uNumTasks = (UINT)pVictim->Tasks.size();
+    if( (UINT)pVictim->lNextTask >= uNumTasks )
+    {
+        return false;
+    }
+
+    UINT uNext = (UINT)( NumaInterlockedIncrement( &pVictim->lNextTask ) - 1 );
+    if( uNext >= uNumTasks )
+    {
+        return false;
+    }
+
+    *puTask = pVictim->Tasks[uNext];
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: NumaTaskPool.h
+//
+// Worker threads pinned to the processors of each NUMA node, and node local memory.
+// Tasks carry the node their data lives on. A worker runs the tasks queued to it first,
+// then steals from the other workers of its node, and only then from other nodes. On
+// machines with a single node (or when the NUMA functions fail) everything runs as one
+// node with a worker per processor. The OS calls are in NumaPlatform.
+//--------------------------------------------------------------------------------------
+#ifndef NUMA_TASK_POOL_H
+#define NUMA_TASK_POOL_H
+
+#include "NumaPlatform.h"
+#include <vector>
+
+// A node with processors
+struct NUMA_NODE_INFO
+{
+    USHORT          uNode;
+    NUMA_AFFINITY   Affinity;
+    UINT            uNumProcessors;
+};
+
+// Where the tasks of the last Run went
+struct NUMA_TASK_STATS
+{
+    UINT    uNumLocal;          // Run by a worker of the task's node
+    UINT    uNumStolenLocal;    // Of those, taken from another worker of the node
+    UINT    uNumRemote;         // Run by a worker of another node
+};
+
+// A task, run once on some worker
+typedef void (*LPNUMATASK)( void* pContext, UINT uTask, UINT uWorker );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the nodes that have processors, at least one
+//--------------------------------------------------------------------------------------
+void GetNumaNodes( std::vector<NUMA_NODE_INFO>* pNodes );
+
+
+//--------------------------------------------------------------------------------------
+// Allocates committed memory preferring the given node, falls back to any node. Pages
+// are placed when first touched, so the memory should be initialized by a thread running
+// on the node. Free with FreeNumaMemory.
+//--------------------------------------------------------------------------------------
+void* AllocateNumaMemory( SIZE_T uBytes, USHORT uNode );
+void FreeNumaMemory( void* pMemory );
+
+
+//--------------------------------------------------------------------------------------
+// Pinned worker threads with node local work stealing
+//--------------------------------------------------------------------------------------
+class CNumaTaskPool
+{
+public:
+
+    CNumaTaskPool();
+    ~CNumaTaskPool();
+
+    // Starts workers on the first uMaxNodes nodes (0 for all), with up to
+    // uMaxWorkersPerNode (0 for one per processor) on each
+    HRESULT Create( UINT uMaxNodes, UINT uMaxWorkersPerNode );
+    void Destroy();
+
+    UINT GetNumNodes() const { return (UINT)m_Nodes.size(); }
+    const NUMA_NODE_INFO* GetNode( UINT uNode ) const { return &m_Nodes[uNode]; }
+    UINT GetNumWorkers() const { return (UINT)m_Workers.size(); }
+
+    // Runs uNumTasks tasks and returns when all are done. puTaskNodes gives the index (in
+    // this pool) of the node of each task, NULL spreads them over all the workers. Without
+    // bStealRemote tasks only run on their node.
+    void Run( LPNUMATASK pfnTask, void* pContext, UINT uNumTasks, const UINT* puTaskNodes, bool bStealRemote );
+
+    void GetStats( NUMA_TASK_STATS* pStats ) const { *pStats = m_Stats; }
+
+private:
+
+    struct WORKER
+    {
+        CNumaTaskPool*      pPool;
+        UINT                uIndex;
+        UINT                uNode;          // Index in m_Nodes
+        NUMA_THREAD         Thread;
+        NUMA_EVENT          StartEvent;
+        std::vector<UINT>   Tasks;          // Queued for this frame
+        volatile LONG       lNextTask;      // Claimed by the worker and by thieves
+        UINT                uNumLocal;
+        UINT                uNumStolenLocal;
+        UINT                uNumRemote;
+    };
+
+    static void WorkerThread( void* pParam );
+    void RunWorker( WORKER* pWorker );
+    bool ClaimTask( WORKER* pVictim, UINT* puTask );
+
+    std::vector<NUMA_NODE_INFO> m_Nodes;
+    std::vector<WORKER*>        m_Workers;
+    NUMA_EVENT                  m_DoneEvent;
+    bool                        m_bDoneEvent;
+    volatile LONG               m_lBusyWorkers;
+    bool                        m_bQuit;
+
+    // The current Run
+    LPNUMATASK                  m_pfnTask;
+    void*                       m_pContext;
+    const UINT*                 m_puTaskNodes;
+    bool                        m_bStealRemote;
+
+    NUMA_TASK_STATS             m_Stats;
+};
+
+#endif
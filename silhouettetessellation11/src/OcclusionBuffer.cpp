@@ -0,0 +1,586 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: OcclusionBuffer.cpp
+//
+// Low resolution software depth buffer for occlusion culling of patch clusters.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "OcclusionBuffer.h"
+#include <intrin.h>
+#include <immintrin.h>
+
+using namespace DirectX;
+
+// Triangles with a vertex closer than this (clip space w) are not rasterized, and boxes
+// with a corner closer are visible
+static const float OCCLUSION_MIN_W = 1.0e-5f;
+
+// Boxes are moved this much closer before the depth test, against rounding
+static const float OCCLUSION_DEPTH_EPSILON = 1.0e-6f;
+
+// Alignment of the depth rows, for AVX loads and stores
+static const UINT OCCLUSION_ALIGNMENT = 32;
+
+
+//--------------------------------------------------------------------------------------
+// Returns the fastest code path the processor and OS support
+//--------------------------------------------------------------------------------------
+OCCLUSION_SIMD GetBestOcclusionSIMD()
+{
+    int iInfo[4];
+    __cpuid( iInfo, 0 );
+    if( iInfo[0] < 1 )
+    {
+        return OCCLUSION_SIMD_SCALAR;
+    }
+
+    __cpuid( iInfo, 1 );
+    bool bSSE2 = 0 != ( iInfo[3] & ( 1 << 26 ) );
+    bool bOSXSAVE = 0 != ( iInfo[2] & ( 1 << 27 ) );
+    bool bAVX = 0 != ( iInfo[2] & ( 1 << 28 ) );
+
+    // The OS must save the YMM registers
+    if( bAVX && bOSXSAVE && 6 == ( _xgetbv( 0 ) & 6 ) )
+    {
+        return OCCLUSION_SIMD_AVX;
+    }
+
+    return bSSE2 ? OCCLUSION_SIMD_SSE : OCCLUSION_SIMD_SCALAR;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+COcclusionBuffer::COcclusionBuffer() :
+    m_uWidth( 0 ),
+    m_uHeight( 0 ),
+    m_uPitch( 0 ),
+    m_uNumBinsX( 0 ),
+    m_uNumBinsY( 0 ),
+    m_pfDepth( NULL ),
+    m_pfTileDepth( NULL ),
+    m_SIMD( OCCLUSION_SIMD_SCALAR )
+{
+    XMStoreFloat4x4( &m_mViewProj, XMMatrixIdentity() );
+    ZeroMemory( &m_Stats, sizeof( m_Stats ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+COcclusionBuffer::~COcclusionBuffer()
+{
+    Destroy();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Allocates the depth buffer and its tiles
+//--------------------------------------------------------------------------------------
+HRESULT COcclusionBuffer::Create( UINT uWidth, UINT uHeight )
+{
+    assert( uWidth > 0 && uHeight > 0 );
+
+    Destroy();
+
+    m_uWidth = ( uWidth + OCCLUSION_TILE_SIZE - 1 ) & ~( OCCLUSION_TILE_SIZE - 1 );
+    m_uHeight = ( uHeight + OCCLUSION_TILE_SIZE - 1 ) & ~( OCCLUSION_TILE_SIZE - 1 );
+    m_uNumBinsX = ( m_uWidth + OCCLUSION_BIN_SIZE - 1 ) / OCCLUSION_BIN_SIZE;
+    m_uNumBinsY = ( m_uHeight + OCCLUSION_BIN_SIZE - 1 ) / OCCLUSION_BIN_SIZE;
+
+    // Whole bins per row, so no cache line is shared by two bins
+    m_uPitch = m_uNumBinsX * OCCLUSION_BIN_SIZE;
+
+    m_pfDepth = (float*)_aligned_malloc( m_uPitch * m_uHeight * sizeof( float ), OCCLUSION_ALIGNMENT );
+    m_pfTileDepth = (float*)_aligned_malloc( ( m_uWidth / OCCLUSION_TILE_SIZE ) * ( m_uHeight / OCCLUSION_TILE_SIZE ) * sizeof( float ),
+                                             OCCLUSION_ALIGNMENT );
+    if( NULL == m_pfDepth || NULL == m_pfTileDepth )
+    {
+        Destroy();
+        return E_OUTOFMEMORY;
+    }
+
+    for( UINT i = 0; i < m_uPitch * m_uHeight; i++ )
+    {
+        m_pfDepth[i] = 1.0f;
+    }
+    for( UINT i = 0; i < ( m_uWidth / OCCLUSION_TILE_SIZE ) * ( m_uHeight / OCCLUSION_TILE_SIZE ); i++ )
+    {
+        m_pfTileDepth[i] = 1.0f;
+    }
+
+    m_Bins.resize( m_uNumBinsX * m_uNumBinsY );
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Frees the buffer
+//--------------------------------------------------------------------------------------
+void COcclusionBuffer::Destroy()
+{
+    if( NULL != m_pfDepth )
+    {
+        _aligned_free( m_pfDepth );
+        m_pfDepth = NULL;
+    }
+    if( NULL != m_pfTileDepth )
+    {
+        _aligned_free( m_pfTileDepth );
+        m_pfTileDepth = NULL;
+    }
+
+    m_Triangles.clear();
+    m_Bins.clear();
+    m_uWidth = m_uHeight = m_uPitch = 0;
+    m_uNumBinsX = m_uNumBinsY = 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Starts a frame of occluders
+//--------------------------------------------------------------------------------------
+void COcclusionBuffer::Begin( CXMMATRIX mViewProj )
+{
+    XMStoreFloat4x4( &m_mViewProj, mViewProj );
+
+    m_Triangles.clear();
+    for( UINT uBin = 0; uBin < (UINT)m_Bins.size(); uBin++ )
+    {
+        m_Bins[uBin].clear();
+    }
+
+    ZeroMemory( &m_Stats, sizeof( m_Stats ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Transforms, sets up and bins an indexed triangle list
+//--------------------------------------------------------------------------------------
+void COcclusionBuffer::AddOccluder( const XMFLOAT3* pPositions, UINT uStride, const UINT* pIndices, UINT uNumTriangles )
+{
+    assert( NULL != pPositions );
+    assert( NULL != pIndices );
+
+    XMMATRIX mViewProj = XMLoadFloat4x4( &m_mViewProj );
+    float fHalfWidth = 0.5f * (float)m_uWidth;
+    float fHalfHeight = 0.5f * (float)m_uHeight;
+
+    m_Stats.uNumTriangles += uNumTriangles;
+
+    for( UINT uTriangle = 0; uTriangle < uNumTriangles; uTriangle++ )
+    {
+        float fX[3], fY[3], fZ[3];
+        bool bClipped = false;
+        for( UINT c = 0; c < 3; c++ )
+        {
+            const XMFLOAT3* pPosition = (const XMFLOAT3*)( (const BYTE*)pPositions + pIndices[uTriangle * 3 + c] * uStride );
+            XMFLOAT4 f4Clip;
+            XMStoreFloat4( &f4Clip, XMVector3Transform( XMLoadFloat3( pPosition ), mViewProj ) );
+
+            // Not clipped to the near plane, dropping the triangle only makes the buffer
+            // hide less
+            if( !( f4Clip.w > OCCLUSION_MIN_W ) )
+            {
+                bClipped = true;
+                break;
+            }
+
+            float fInvW = 1.0f / f4Clip.w;
+            fX[c] = ( f4Clip.x * fInvW + 1.0f ) * fHalfWidth;
+            fY[c] = ( 1.0f - f4Clip.y * fInvW ) * fHalfHeight;
+            fZ[c] = f4Clip.z * fInvW;
+        }
+        if( bClipped )
+        {
+            continue;
+        }
+
+        // Clockwise on screen is front facing, back faces are hidden by front faces
+        float fArea = ( fX[1] - fX[0] ) * ( fY[2] - fY[0] ) - ( fX[2] - fX[0] ) * ( fY[1] - fY[0] );
+        if( !( fArea > 0.0f ) )
+        {
+            continue;
+        }
+
+        // Pixels with their center within the bounds, clamped before converting as vertices
+        // near the camera can be far off screen
+        float fMinX = std::max( std::min( std::min( fX[0], fX[1] ), fX[2] ), -1.0f );
+        float fMinY = std::max( std::min( std::min( fY[0], fY[1] ), fY[2] ), -1.0f );
+        float fMaxX = std::min( std::max( std::max( fX[0], fX[1] ), fX[2] ), (float)m_uWidth + 1.0f );
+        float fMaxY = std::min( std::max( std::max( fY[0], fY[1] ), fY[2] ), (float)m_uHeight + 1.0f );
+
+        TRIANGLE Triangle;
+        Triangle.iMinX = std::max( (int)ceilf( fMinX - 0.5f ), 0 );
+        Triangle.iMinY = std::max( (int)ceilf( fMinY - 0.5f ), 0 );
+        Triangle.iMaxX = std::min( (int)floorf( fMaxX - 0.5f ), (int)m_uWidth - 1 );
+        Triangle.iMaxY = std::min( (int)floorf( fMaxY - 0.5f ), (int)m_uHeight - 1 );
+        if( Triangle.iMinX > Triangle.iMaxX || Triangle.iMinY > Triangle.iMaxY )
+        {
+            continue;
+        }
+
+        // Edge functions tested at the pixel centers
+        for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+        {
+            UINT a = uEdge;
+            UINT b = ( uEdge + 1 ) % 3;
+            float fA = fY[a] - fY[b];
+            float fB = fX[b] - fX[a];
+            Triangle.fA[uEdge] = fA;
+            Triangle.fB[uEdge] = fB;
+            Triangle.fC[uEdge] = -( fA * fX[a] + fB * fY[a] );
+        }
+
+        // Depth at the farthest corner of the pixel, no farther than the farthest vertex
+        float fZx = ( ( fZ[1] - fZ[0] ) * ( fY[2] - fY[0] ) - ( fZ[2] - fZ[0] ) * ( fY[1] - fY[0] ) ) / fArea;
+        float fZy = ( ( fX[1] - fX[0] ) * ( fZ[2] - fZ[0] ) - ( fX[2] - fX[0] ) * ( fZ[1] - fZ[0] ) ) / fArea;
+        Triangle.fZx = fZx;
+        Triangle.fZy = fZy;
+        Triangle.fZ0 = fZ[0] - fZx * fX[0] - fZy * fY[0] + 0.5f * ( fabsf( fZx ) + fabsf( fZy ) );
+        Triangle.fMaxZ = std::max( std::max( fZ[0], fZ[1] ), fZ[2] );
+
+        UINT uIndex = (UINT)m_Triangles.size();
+        m_Triangles.push_back( Triangle );
+        m_Stats.uNumRasterized++;
+
+        for( UINT uBinY = (UINT)Triangle.iMinY / OCCLUSION_BIN_SIZE; uBinY <= (UINT)Triangle.iMaxY / OCCLUSION_BIN_SIZE; uBinY++ )
+        {
+            for( UINT uBinX = (UINT)Triangle.iMinX / OCCLUSION_BIN_SIZE; uBinX <= (UINT)Triangle.iMaxX / OCCLUSION_BIN_SIZE; uBinX++ )
+            {
+                m_Bins[uBinY * m_uNumBinsX + uBinX].push_back( uIndex );
+                m_Stats.uNumBinnedTriangles++;
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Clears and rasterizes the bins
+//--------------------------------------------------------------------------------------
+void COcclusionBuffer::Rasterize( CNumaTaskPool* pPool )
+{
+    if( NULL != pPool )
+    {
+        pPool->Run( RasterizeBinTask, this, (UINT)m_Bins.size(), NULL, true );
+    }
+    else
+    {
+        for( UINT uBin = 0; uBin < (UINT)m_Bins.size(); uBin++ )
+        {
+            RasterizeBin( uBin );
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Rasterizes a bin on a worker
+//--------------------------------------------------------------------------------------
+void COcclusionBuffer::RasterizeBinTask( void* pContext, UINT uTask, UINT uWorker )
+{
+    UNREFERENCED_PARAMETER( uWorker );
+
+    ( (COcclusionBuffer*)pContext )->RasterizeBin( uTask );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Clears a bin, rasterizes its triangles and updates its tiles
+//--------------------------------------------------------------------------------------
+void COcclusionBuffer::RasterizeBin( UINT uBin )
+{
+    int iBinMinX = (int)( ( uBin % m_uNumBinsX ) * OCCLUSION_BIN_SIZE );
+    int iBinMinY = (int)( ( uBin / m_uNumBinsX ) * OCCLUSION_BIN_SIZE );
+    int iBinMaxX = std::min( iBinMinX + (int)OCCLUSION_BIN_SIZE, (int)m_uWidth ) - 1;
+    int iBinMaxY = std::min( iBinMinY + (int)OCCLUSION_BIN_SIZE, (int)m_uHeight ) - 1;
+
+    for( int y = iBinMinY; y <= iBinMaxY; y++ )
+    {
+        float* pfRow = m_pfDepth + y * m_uPitch;
+        for( int x = iBinMinX; x <= iBinMaxX; x++ )
+        {
+            pfRow[x] = 1.0f;
+        }
+    }
+
+    const std::vector<UINT>& Bin = m_Bins[uBin];
+    for( UINT i = 0; i < (UINT)Bin.size(); i++ )
+    {
+        const TRIANGLE* pTriangle = &m_Triangles[Bin[i]];
+        int iMinX = std::max( pTriangle->iMinX, iBinMinX );
+        int iMinY = std::max( pTriangle->iMinY, iBinMinY );
+        int iMaxX = std::min( pTriangle->iMaxX, iBinMaxX );
+        int iMaxY = std::min( pTriangle->iMaxY, iBinMaxY );
+
+        switch( m_SIMD )
+        {
+        case OCCLUSION_SIMD_AVX:
+            // Narrow triangles would mostly waste 8 wide steps
+            if( ( iMaxX | 3 ) - ( iMinX & ~3 ) < 8 )
+            {
+                RasterizeTriangleSSE( pTriangle, iMinX, iMinY, iMaxX, iMaxY );
+            }
+            else
+            {
+                RasterizeTriangleAVX( pTriangle, iMinX, iMinY, iMaxX, iMaxY );
+            }
+            break;
+        case OCCLUSION_SIMD_SSE:
+            RasterizeTriangleSSE( pTriangle, iMinX, iMinY, iMaxX, iMaxY );
+            break;
+        default:
+            RasterizeTriangleScalar( pTriangle, iMinX, iMinY, iMaxX, iMaxY );
+            break;
+        }
+    }
+
+    // Farthest depth of each tile, the bin is whole tiles
+    UINT uNumTilesX = m_uWidth / OCCLUSION_TILE_SIZE;
+    for( int iTileY = iBinMinY; iTileY <= iBinMaxY; iTileY += (int)OCCLUSION_TILE_SIZE )
+    {
+        for( int iTileX = iBinMinX; iTileX <= iBinMaxX; iTileX += (int)OCCLUSION_TILE_SIZE )
+        {
+            __m128 vMax = _mm_setzero_ps();
+            for( UINT y = 0; y < OCCLUSION_TILE_SIZE; y++ )
+            {
+                const float* pfRow = m_pfDepth + ( iTileY + y ) * m_uPitch + iTileX;
+                vMax = _mm_max_ps( vMax, _mm_max_ps( _mm_load_ps( pfRow ), _mm_load_ps( pfRow + 4 ) ) );
+            }
+            vMax = _mm_max_ps( vMax, _mm_shuffle_ps( vMax, vMax, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+            vMax = _mm_max_ps( vMax, _mm_shuffle_ps( vMax, vMax, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+            _mm_store_ss( &m_pfTileDepth[( iTileY / (int)OCCLUSION_TILE_SIZE ) * uNumTilesX + iTileX / (int)OCCLUSION_TILE_SIZE], vMax );
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Rasterizes a triangle within the given pixels, one pixel at a time. The SIMD versions
+// evaluate the same expressions in the same order, so all paths write the same depths.
+//--------------------------------------------------------------------------------------
+void COcclusionBuffer::RasterizeTriangleScalar( const TRIANGLE* pTriangle, int iMinX, int iMinY, int iMaxX, int iMaxY )
+{
+    for( int y = iMinY; y <= iMaxY; y++ )
+    {
+        float fY = (float)y + 0.5f;
+        float* pfRow = m_pfDepth + y * m_uPitch;
+
+        for( int x = iMinX; x <= iMaxX; x++ )
+        {
+            float fX = (float)x + 0.5f;
+            float fE0 = ( pTriangle->fA[0] * fX + pTriangle->fB[0] * fY ) + pTriangle->fC[0];
+            float fE1 = ( pTriangle->fA[1] * fX + pTriangle->fB[1] * fY ) + pTriangle->fC[1];
+            float fE2 = ( pTriangle->fA[2] * fX + pTriangle->fB[2] * fY ) + pTriangle->fC[2];
+            if( fE0 >= 0.0f && fE1 >= 0.0f && fE2 >= 0.0f )
+            {
+                float fZ = std::min( ( pTriangle->fZx * fX + pTriangle->fZy * fY ) + pTriangle->fZ0, pTriangle->fMaxZ );
+                pfRow[x] = std::min( pfRow[x], fZ );
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Rasterizes a triangle within the given pixels, 4 pixels at a time
+//--------------------------------------------------------------------------------------
+void COcclusionBuffer::RasterizeTriangleSSE( const TRIANGLE* pTriangle, int iMinX, int iMinY, int iMaxX, int iMaxY )
+{
+    __m128 vA0 = _mm_set1_ps( pTriangle->fA[0] ), vB0 = _mm_set1_ps( pTriangle->fB[0] ), vC0 = _mm_set1_ps( pTriangle->fC[0] );
+    __m128 vA1 = _mm_set1_ps( pTriangle->fA[1] ), vB1 = _mm_set1_ps( pTriangle->fB[1] ), vC1 = _mm_set1_ps( pTriangle->fC[1] );
+    __m128 vA2 = _mm_set1_ps( pTriangle->fA[2] ), vB2 = _mm_set1_ps( pTriangle->fB[2] ), vC2 = _mm_set1_ps( pTriangle->fC[2] );
+    __m128 vZx = _mm_set1_ps( pTriangle->fZx ), vZy = _mm_set1_ps( pTriangle->fZy ), vZ0 = _mm_set1_ps( pTriangle->fZ0 );
+    __m128 vMaxZ = _mm_set1_ps( pTriangle->fMaxZ );
+    __m128 vZero = _mm_setzero_ps();
+    __m128 vLanes = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+
+    // Lanes outside the pixels are masked, as the scalar version never reaches them
+    __m128 vMinX = _mm_set1_ps( (float)iMinX );
+    __m128 vMaxX = _mm_set1_ps( (float)iMaxX + 1.0f );
+
+    for( int y = iMinY; y <= iMaxY; y++ )
+    {
+        __m128 vY = _mm_set1_ps( (float)y + 0.5f );
+        __m128 vB0Y = _mm_mul_ps( vB0, vY ), vB1Y = _mm_mul_ps( vB1, vY ), vB2Y = _mm_mul_ps( vB2, vY );
+        __m128 vZyY = _mm_mul_ps( vZy, vY );
+        float* pfRow = m_pfDepth + y * m_uPitch;
+
+        for( int x = iMinX & ~3; x <= iMaxX; x += 4 )
+        {
+            __m128 vX = _mm_add_ps( _mm_set1_ps( (float)x ), vLanes );
+            __m128 vE0 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vA0, vX ), vB0Y ), vC0 );
+            __m128 vE1 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vA1, vX ), vB1Y ), vC1 );
+            __m128 vE2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vA2, vX ), vB2Y ), vC2 );
+
+            __m128 vInside = _mm_and_ps( _mm_and_ps( _mm_cmpge_ps( vE0, vZero ), _mm_cmpge_ps( vE1, vZero ) ), _mm_cmpge_ps( vE2, vZero ) );
+            vInside = _mm_and_ps( vInside, _mm_and_ps( _mm_cmpgt_ps( vX, vMinX ), _mm_cmplt_ps( vX, vMaxX ) ) );
+            if( 0 == _mm_movemask_ps( vInside ) )
+            {
+                continue;
+            }
+
+            __m128 vZ = _mm_min_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( vZx, vX ), vZyY ), vZ0 ), vMaxZ );
+            __m128 vDepth = _mm_load_ps( pfRow + x );
+            vZ = _mm_min_ps( vDepth, vZ );
+            _mm_store_ps( pfRow + x, _mm_or_ps( _mm_and_ps( vInside, vZ ), _mm_andnot_ps( vInside, vDepth ) ) );
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Rasterizes a triangle within the given pixels, 8 pixels at a time
+//--------------------------------------------------------------------------------------
+void COcclusionBuffer::RasterizeTriangleAVX( const TRIANGLE* pTriangle, int iMinX, int iMinY, int iMaxX, int iMaxY )
+{
+    __m256 vA0 = _mm256_set1_ps( pTriangle->fA[0] ), vB0 = _mm256_set1_ps( pTriangle->fB[0] ), vC0 = _mm256_set1_ps( pTriangle->fC[0] );
+    __m256 vA1 = _mm256_set1_ps( pTriangle->fA[1] ), vB1 = _mm256_set1_ps( pTriangle->fB[1] ), vC1 = _mm256_set1_ps( pTriangle->fC[1] );
+    __m256 vA2 = _mm256_set1_ps( pTriangle->fA[2] ), vB2 = _mm256_set1_ps( pTriangle->fB[2] ), vC2 = _mm256_set1_ps( pTriangle->fC[2] );
+    __m256 vZx = _mm256_set1_ps( pTriangle->fZx ), vZy = _mm256_set1_ps( pTriangle->fZy ), vZ0 = _mm256_set1_ps( pTriangle->fZ0 );
+    __m256 vMaxZ = _mm256_set1_ps( pTriangle->fMaxZ );
+    __m256 vZero = _mm256_setzero_ps();
+    __m256 vLanes = _mm256_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f );
+
+    __m256 vMinX = _mm256_set1_ps( (float)iMinX );
+    __m256 vMaxX = _mm256_set1_ps( (float)iMaxX + 1.0f );
+
+    for( int y = iMinY; y <= iMaxY; y++ )
+    {
+        __m256 vY = _mm256_set1_ps( (float)y + 0.5f );
+        __m256 vB0Y = _mm256_mul_ps( vB0, vY ), vB1Y = _mm256_mul_ps( vB1, vY ), vB2Y = _mm256_mul_ps( vB2, vY );
+        __m256 vZyY = _mm256_mul_ps( vZy, vY );
+        float* pfRow = m_pfDepth + y * m_uPitch;
+
+        for( int x = iMinX & ~7; x <= iMaxX; x += 8 )
+        {
+            __m256 vX = _mm256_add_ps( _mm256_set1_ps( (float)x ), vLanes );
+            __m256 vE0 = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( vA0, vX ), vB0Y ), vC0 );
+            __m256 vE1 = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( vA1, vX ), vB1Y ), vC1 );
+            __m256 vE2 = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( vA2, vX ), vB2Y ), vC2 );
+
+            __m256 vInside = _mm256_and_ps( _mm256_and_ps( _mm256_cmp_ps( vE0, vZero, _CMP_GE_OQ ), _mm256_cmp_ps( vE1, vZero, _CMP_GE_OQ ) ),
+                                            _mm256_cmp_ps( vE2, vZero, _CMP_GE_OQ ) );
+            vInside = _mm256_and_ps( vInside, _mm256_and_ps( _mm256_cmp_ps( vX, vMinX, _CMP_GT_OQ ), _mm256_cmp_ps( vX, vMaxX, _CMP_LT_OQ ) ) );
+            if( 0 == _mm256_movemask_ps( vInside ) )
+            {
+                continue;
+            }
+
+            __m256 vZ = _mm256_min_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( vZx, vX ), vZyY ), vZ0 ), vMaxZ );
+            __m256 vDepth = _mm256_load_ps( pfRow + x );
+            _mm256_store_ps( pfRow + x, _mm256_blendv_ps( vDepth, _mm256_min_ps( vDepth, vZ ), vInside ) );
+        }
+    }
+
+    // Avoid the penalty of SSE code after AVX code
+    _mm256_zeroupper();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns false if every pixel the box touches is closer than the box
+//--------------------------------------------------------------------------------------
+bool COcclusionBuffer::IsBoxVisible( const XMFLOAT3& f3Min, const XMFLOAT3& f3Max ) const
+{
+    XMMATRIX mViewProj = XMLoadFloat4x4( &m_mViewProj );
+    float fHalfWidth = 0.5f * (float)m_uWidth;
+    float fHalfHeight = 0.5f * (float)m_uHeight;
+
+    float fMinX = FLT_MAX, fMinY = FLT_MAX, fMaxX = -FLT_MAX, fMaxY = -FLT_MAX, fMinZ = FLT_MAX;
+    for( UINT uCorner = 0; uCorner < 8; uCorner++ )
+    {
+        XMVECTOR vCorner = XMVectorSet( ( uCorner & 1 ) ? f3Max.x : f3Min.x, ( uCorner & 2 ) ? f3Max.y : f3Min.y,
+                                        ( uCorner & 4 ) ? f3Max.z : f3Min.z, 1.0f );
+        XMFLOAT4 f4Clip;
+        XMStoreFloat4( &f4Clip, XMVector4Transform( vCorner, mViewProj ) );
+
+        // Crosses the near plane
+        if( !( f4Clip.w > OCCLUSION_MIN_W ) )
+        {
+            return true;
+        }
+
+        float fInvW = 1.0f / f4Clip.w;
+        float fX = ( f4Clip.x * fInvW + 1.0f ) * fHalfWidth;
+        float fY = ( 1.0f - f4Clip.y * fInvW ) * fHalfHeight;
+        fMinX = std::min( fMinX, fX );
+        fMaxX = std::max( fMaxX, fX );
+        fMinY = std::min( fMinY, fY );
+        fMaxY = std::max( fMaxY, fY );
+        fMinZ = std::min( fMinZ, f4Clip.z * fInvW );
+    }
+
+    // Every pixel the bounds touch, off screen is not visible
+    int iMinX = std::max( (int)floorf( std::max( fMinX, -1.0f ) ), 0 );
+    int iMinY = std::max( (int)floorf( std::max( fMinY, -1.0f ) ), 0 );
+    int iMaxX = std::min( (int)ceilf( std::min( fMaxX, (float)m_uWidth + 1.0f ) ) - 1, (int)m_uWidth - 1 );
+    int iMaxY = std::min( (int)ceilf( std::min( fMaxY, (float)m_uHeight + 1.0f ) ) - 1, (int)m_uHeight - 1 );
+    if( iMinX > iMaxX || iMinY > iMaxY )
+    {
+        return false;
+    }
+
+    fMinZ -= OCCLUSION_DEPTH_EPSILON;
+
+    UINT uNumTilesX = m_uWidth / OCCLUSION_TILE_SIZE;
+    for( int iTileY = iMinY / (int)OCCLUSION_TILE_SIZE; iTileY <= iMaxY / (int)OCCLUSION_TILE_SIZE; iTileY++ )
+    {
+        for( int iTileX = iMinX / (int)OCCLUSION_TILE_SIZE; iTileX <= iMaxX / (int)OCCLUSION_TILE_SIZE; iTileX++ )
+        {
+            // The whole tile is closer
+            if( fMinZ >= m_pfTileDepth[iTileY * uNumTilesX + iTileX] )
+            {
+                continue;
+            }
+
+            int iX0 = std::max( iTileX * (int)OCCLUSION_TILE_SIZE, iMinX );
+            int iX1 = std::min( ( iTileX + 1 ) * (int)OCCLUSION_TILE_SIZE - 1, iMaxX );
+            int iY0 = std::max( iTileY * (int)OCCLUSION_TILE_SIZE, iMinY );
+            int iY1 = std::min( ( iTileY + 1 ) * (int)OCCLUSION_TILE_SIZE - 1, iMaxY );
+            for( int y = iY0; y <= iY1; y++ )
+            {
+                const float* pfRow = m_pfDepth + y * m_uPitch;
+                for( int x = iX0; x <= iX1; x++ )
+                {
+                    if( fMinZ < pfRow[x] )
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
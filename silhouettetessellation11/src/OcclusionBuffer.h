@@ -0,0 +1,146 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: OcclusionBuffer.h
+//
+// Low resolution software depth buffer for occlusion culling of patch clusters. Occluder
+// triangles are sampled at pixel centers, as the GPU does, and write the farthest depth of
+// the triangle over the pixel, so the buffer is never closer than the occluders. A tile
+// (hierarchical Z) level keeps the farthest depth of each 8x8 pixel tile so most tests
+// end at the tile level. Bounds are tested against every pixel they touch.
+//
+// Triangles are binned to 64x64 pixel bins, and the bins are rasterized in parallel by a
+// task pool with scalar, SSE or AVX code.
+//--------------------------------------------------------------------------------------
+#ifndef OCCLUSION_BUFFER_H
+#define OCCLUSION_BUFFER_H
+
+#include "NumaTaskPool.h"
+
+// Pixels per side of a hierarchical Z tile, and of a bin rasterized by one task
+static const UINT OCCLUSION_TILE_SIZE   = 8;
+static const UINT OCCLUSION_BIN_SIZE    = 64;
+
+// Code paths of the rasterizer
+enum OCCLUSION_SIMD
+{
+    OCCLUSION_SIMD_SCALAR,
+    OCCLUSION_SIMD_SSE,         // 4 pixels per step
+    OCCLUSION_SIMD_AVX,         // 8 pixels per step
+};
+
+struct OCCLUSION_STATS
+{
+    UINT    uNumTriangles;      // Passed to AddOccluder
+    UINT    uNumRasterized;     // Front facing, in front of the near plane and on screen
+    UINT    uNumBinnedTriangles;// Summed over the bins
+};
+
+
+//--------------------------------------------------------------------------------------
+// Returns the fastest code path the processor and OS support
+//--------------------------------------------------------------------------------------
+OCCLUSION_SIMD GetBestOcclusionSIMD();
+
+
+//--------------------------------------------------------------------------------------
+// Depth buffer of occluders, D3D depth (0 near, 1 far)
+//--------------------------------------------------------------------------------------
+class COcclusionBuffer
+{
+public:
+
+    COcclusionBuffer();
+    ~COcclusionBuffer();
+
+    // The size is rounded up to whole tiles
+    HRESULT Create( UINT uWidth, UINT uHeight );
+    void Destroy();
+
+    UINT GetWidth() const { return m_uWidth; }
+    UINT GetHeight() const { return m_uHeight; }
+
+    void SetSIMD( OCCLUSION_SIMD SIMD ) { m_SIMD = SIMD; }
+    OCCLUSION_SIMD GetSIMD() const { return m_SIMD; }
+
+    // Starts a frame of occluders seen through the view projection matrix
+    void Begin( DirectX::CXMMATRIX mViewProj );
+
+    // Transforms and bins an indexed triangle list. The positions are uStride bytes apart.
+    void AddOccluder( const DirectX::XMFLOAT3* pPositions, UINT uStride, const UINT* pIndices, UINT uNumTriangles );
+
+    // Clears and rasterizes the bins, with the pool if given or else on the calling thread
+    void Rasterize( CNumaTaskPool* pPool );
+
+    // Returns false if the box is hidden by the occluders. Can run on any number of
+    // threads after Rasterize.
+    bool IsBoxVisible( const DirectX::XMFLOAT3& f3Min, const DirectX::XMFLOAT3& f3Max ) const;
+
+    // Rows of GetPitch floats
+    const float* GetDepth() const { return m_pfDepth; }
+    UINT GetPitch() const { return m_uPitch; }
+
+    void GetStats( OCCLUSION_STATS* pStats ) const { *pStats = m_Stats; }
+
+private:
+
+    // Edge functions are A * x + B * y + C >= 0 inside, and depth is Zx * x + Zy * y + Z0
+    // at pixel centers, offset to the farthest corner of the pixel
+    struct TRIANGLE
+    {
+        float   fA[3];
+        float   fB[3];
+        float   fC[3];
+        float   fZx;
+        float   fZy;
+        float   fZ0;
+        float   fMaxZ;
+        int     iMinX;
+        int     iMinY;
+        int     iMaxX;  // Inclusive
+        int     iMaxY;
+    };
+
+    static void RasterizeBinTask( void* pContext, UINT uTask, UINT uWorker );
+    void RasterizeBin( UINT uBin );
+    void RasterizeTriangleScalar( const TRIANGLE* pTriangle, int iMinX, int iMinY, int iMaxX, int iMaxY );
+    void RasterizeTriangleSSE( const TRIANGLE* pTriangle, int iMinX, int iMinY, int iMaxX, int iMaxY );
+    void RasterizeTriangleAVX( const TRIANGLE* pTriangle, int iMinX, int iMinY, int iMaxX, int iMaxY );
+
+    UINT                            m_uWidth;
+    UINT                            m_uHeight;
+    UINT                            m_uPitch;       // Floats per row, whole bins
+    UINT                            m_uNumBinsX;
+    UINT                            m_uNumBinsY;
+    float*                          m_pfDepth;
+    float*                          m_pfTileDepth;  // Farthest depth of each tile
+    OCCLUSION_SIMD                  m_SIMD;
+
+    DirectX::XMFLOAT4X4             m_mViewProj;
+    std::vector<TRIANGLE>           m_Triangles;
+    std::vector< std::vector<UINT> > m_Bins;
+
+    OCCLUSION_STATS                 m_Stats;
+};
+
+#endif
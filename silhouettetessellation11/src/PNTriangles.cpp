@@ -0,0 +1,204 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: PNTriangles.cpp
+//
+// CPU reference of the PN-Triangles and Phong tessellation techniques.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "PNTriangles.h"
+
+using namespace DirectX;
+
+//--------------------------------------------------------------------------------------
+// Computes an edge control point, 1/3 of the way from corner 0 to corner 1 projected
+// onto the tangent plane of corner 0
+//--------------------------------------------------------------------------------------
+static XMVECTOR EdgeControlPoint( FXMVECTOR vB0, FXMVECTOR vB1, FXMVECTOR vN0 )
+{
+    XMVECTOR vEdge = XMVectorSubtract( vB1, vB0 );
+    XMVECTOR vPoint = XMVectorAdd( XMVectorScale( vB0, 2.0f ), vB1 );
+    vPoint = XMVectorSubtract( vPoint, XMVectorMultiply( XMVector3Dot( vEdge, vN0 ), vN0 ) );
+
+    return XMVectorScale( vPoint, 1.0f / 3.0f );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Computes a normal control point, the average of the corner normals reflected about
+// the plane perpendicular to the edge
+//--------------------------------------------------------------------------------------
+static XMVECTOR NormalControlPoint( FXMVECTOR vB0, FXMVECTOR vB1, FXMVECTOR vN0, GXMVECTOR vN1 )
+{
+    XMVECTOR vEdge = XMVectorSubtract( vB1, vB0 );
+    XMVECTOR vNormalSum = XMVectorAdd( vN0, vN1 );
+    XMVECTOR vV = XMVectorDivide( XMVectorScale( XMVector3Dot( vEdge, vNormalSum ), 2.0f ), XMVector3Dot( vEdge, vEdge ) );
+
+    return XMVector3Normalize( XMVectorSubtract( vNormalSum, XMVectorMultiply( vV, vEdge ) ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Computes the PN-Triangles control points of the patch formed by the 3 corners
+//--------------------------------------------------------------------------------------
+void ComputePNControlPoints( const PN_VERTEX* pCorners, PN_CONTROL_POINTS* pControlPoints )
+{
+    assert( NULL != pCorners );
+    assert( NULL != pControlPoints );
+
+    // Assign Positions
+    XMVECTOR vB003 = XMLoadFloat3( &pCorners[0].f3Position );
+    XMVECTOR vB030 = XMLoadFloat3( &pCorners[1].f3Position );
+    XMVECTOR vB300 = XMLoadFloat3( &pCorners[2].f3Position );
+    // And Normals
+    XMVECTOR vN002 = XMLoadFloat3( &pCorners[0].f3Normal );
+    XMVECTOR vN020 = XMLoadFloat3( &pCorners[1].f3Normal );
+    XMVECTOR vN200 = XMLoadFloat3( &pCorners[2].f3Normal );
+
+    // Edge control points
+    XMVECTOR vB210 = EdgeControlPoint( vB003, vB030, vN002 );
+    XMVECTOR vB120 = EdgeControlPoint( vB030, vB003, vN020 );
+    XMVECTOR vB021 = EdgeControlPoint( vB030, vB300, vN020 );
+    XMVECTOR vB012 = EdgeControlPoint( vB300, vB030, vN200 );
+    XMVECTOR vB102 = EdgeControlPoint( vB300, vB003, vN200 );
+    XMVECTOR vB201 = EdgeControlPoint( vB003, vB300, vN002 );
+
+    // Center control point
+    XMVECTOR vE = XMVectorAdd( XMVectorAdd( XMVectorAdd( vB210, vB120 ), XMVectorAdd( vB021, vB012 ) ), XMVectorAdd( vB102, vB201 ) );
+    vE = XMVectorScale( vE, 1.0f / 6.0f );
+    XMVECTOR vV = XMVectorScale( XMVectorAdd( XMVectorAdd( vB003, vB030 ), vB300 ), 1.0f / 3.0f );
+    XMVECTOR vB111 = XMVectorAdd( vE, XMVectorScale( XMVectorSubtract( vE, vV ), 0.5f ) );
+
+    XMStoreFloat3( &pControlPoints->f3B210, vB210 );
+    XMStoreFloat3( &pControlPoints->f3B120, vB120 );
+    XMStoreFloat3( &pControlPoints->f3B021, vB021 );
+    XMStoreFloat3( &pControlPoints->f3B012, vB012 );
+    XMStoreFloat3( &pControlPoints->f3B102, vB102 );
+    XMStoreFloat3( &pControlPoints->f3B201, vB201 );
+    XMStoreFloat3( &pControlPoints->f3B111, vB111 );
+
+    // Quadratic normal control points
+    XMStoreFloat3( &pControlPoints->f3N110, NormalControlPoint( vB003, vB030, vN002, vN020 ) );
+    XMStoreFloat3( &pControlPoints->f3N011, NormalControlPoint( vB030, vB300, vN020, vN200 ) );
+    XMStoreFloat3( &pControlPoints->f3N101, NormalControlPoint( vB300, vB003, vN200, vN002 ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates the PN-Triangles patch at the given barycentric coords
+//--------------------------------------------------------------------------------------
+void EvaluatePNTriangle( const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints,
+                         float fU, float fV, float fW,
+                         XMFLOAT3* pPosition, XMFLOAT3* pNormal )
+{
+    assert( NULL != pCorners );
+    assert( NULL != pControlPoints );
+
+    // Precompute squares and squares * 3
+    float fUU = fU * fU;
+    float fVV = fV * fV;
+    float fWW = fW * fW;
+    float fUU3 = fUU * 3.0f;
+    float fVV3 = fVV * 3.0f;
+    float fWW3 = fWW * 3.0f;
+
+    if( NULL != pPosition )
+    {
+        XMVECTOR vPosition = XMVectorScale( XMLoadFloat3( &pCorners[0].f3Position ), fWW * fW );
+        vPosition = XMVectorAdd( vPosition, XMVectorScale( XMLoadFloat3( &pCorners[1].f3Position ), fUU * fU ) );
+        vPosition = XMVectorAdd( vPosition, XMVectorScale( XMLoadFloat3( &pCorners[2].f3Position ), fVV * fV ) );
+        vPosition = XMVectorAdd( vPosition, XMVectorScale( XMLoadFloat3( &pControlPoints->f3B210 ), fWW3 * fU ) );
+        vPosition = XMVectorAdd( vPosition, XMVectorScale( XMLoadFloat3( &pControlPoints->f3B120 ), fW * fUU3 ) );
+        vPosition = XMVectorAdd( vPosition, XMVectorScale( XMLoadFloat3( &pControlPoints->f3B201 ), fWW3 * fV ) );
+        vPosition = XMVectorAdd( vPosition, XMVectorScale( XMLoadFloat3( &pControlPoints->f3B021 ), fUU3 * fV ) );
+        vPosition = XMVectorAdd( vPosition, XMVectorScale( XMLoadFloat3( &pControlPoints->f3B102 ), fW * fVV3 ) );
+        vPosition = XMVectorAdd( vPosition, XMVectorScale( XMLoadFloat3( &pControlPoints->f3B012 ), fU * fVV3 ) );
+        vPosition = XMVectorAdd( vPosition, XMVectorScale( XMLoadFloat3( &pControlPoints->f3B111 ), 6.0f * fW * fU * fV ) );
+        XMStoreFloat3( pPosition, vPosition );
+    }
+
+    if( NULL != pNormal )
+    {
+        XMVECTOR vNormal = XMVectorScale( XMLoadFloat3( &pCorners[0].f3Normal ), fWW );
+        vNormal = XMVectorAdd( vNormal, XMVectorScale( XMLoadFloat3( &pCorners[1].f3Normal ), fUU ) );
+        vNormal = XMVectorAdd( vNormal, XMVectorScale( XMLoadFloat3( &pCorners[2].f3Normal ), fVV ) );
+        vNormal = XMVectorAdd( vNormal, XMVectorScale( XMLoadFloat3( &pControlPoints->f3N110 ), fW * fU ) );
+        vNormal = XMVectorAdd( vNormal, XMVectorScale( XMLoadFloat3( &pControlPoints->f3N011 ), fU * fV ) );
+        vNormal = XMVectorAdd( vNormal, XMVectorScale( XMLoadFloat3( &pControlPoints->f3N101 ), fW * fV ) );
+        XMStoreFloat3( pNormal, XMVector3Normalize( vNormal ) );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Orthogonal projection of q onto the plane defined by p and its normal
+//--------------------------------------------------------------------------------------
+static XMVECTOR ProjectOntoTangentPlane( const PN_VERTEX& q, const PN_VERTEX& p )
+{
+    XMVECTOR vQ = XMLoadFloat3( &q.f3Position );
+    XMVECTOR vN = XMLoadFloat3( &p.f3Normal );
+    XMVECTOR vQMinusP = XMVectorSubtract( vQ, XMLoadFloat3( &p.f3Position ) );
+
+    return XMVectorSubtract( vQ, XMVectorMultiply( XMVector3Dot( vQMinusP, vN ), vN ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates the Phong tessellation patch at the given barycentric coords
+//--------------------------------------------------------------------------------------
+void EvaluatePhongTriangle( const PN_VERTEX* pCorners, float fU, float fV, float fW,
+                            XMFLOAT3* pPosition, XMFLOAT3* pNormal )
+{
+    assert( NULL != pCorners );
+
+    if( NULL != pPosition )
+    {
+        XMVECTOR vP0 = XMLoadFloat3( &pCorners[0].f3Position );
+        XMVECTOR vP1 = XMLoadFloat3( &pCorners[1].f3Position );
+        XMVECTOR vP2 = XMLoadFloat3( &pCorners[2].f3Position );
+
+        XMVECTOR vPosition = XMVectorScale( vP0, fW * fW );
+        vPosition = XMVectorAdd( vPosition, XMVectorScale( vP1, fU * fU ) );
+        vPosition = XMVectorAdd( vPosition, XMVectorScale( vP2, fV * fV ) );
+        vPosition = XMVectorAdd( vPosition, XMVectorScale( XMVectorAdd( ProjectOntoTangentPlane( pCorners[0], pCorners[1] ), ProjectOntoTangentPlane( pCorners[1], pCorners[0] ) ), fW * fU ) );
+        vPosition = XMVectorAdd( vPosition, XMVectorScale( XMVectorAdd( ProjectOntoTangentPlane( pCorners[1], pCorners[2] ), ProjectOntoTangentPlane( pCorners[2], pCorners[1] ) ), fU * fV ) );
+        vPosition = XMVectorAdd( vPosition, XMVectorScale( XMVectorAdd( ProjectOntoTangentPlane( pCorners[2], pCorners[0] ), ProjectOntoTangentPlane( pCorners[0], pCorners[2] ) ), fV * fW ) );
+
+        // Blend half way between the Phong surface and the flat triangle
+        XMVECTOR vFlat = XMVectorAdd( XMVectorAdd( XMVectorScale( vP0, fW ), XMVectorScale( vP1, fU ) ), XMVectorScale( vP2, fV ) );
+        XMStoreFloat3( pPosition, XMVectorLerp( vFlat, vPosition, 0.5f ) );
+    }
+
+    if( NULL != pNormal )
+    {
+        XMVECTOR vNormal = XMVectorScale( XMLoadFloat3( &pCorners[0].f3Normal ), fW );
+        vNormal = XMVectorAdd( vNormal, XMVectorScale( XMLoadFloat3( &pCorners[1].f3Normal ), fU ) );
+        vNormal = XMVectorAdd( vNormal, XMVectorScale( XMLoadFloat3( &pCorners[2].f3Normal ), fV ) );
+        XMStoreFloat3( pNormal, XMVector3Normalize( vNormal ) );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
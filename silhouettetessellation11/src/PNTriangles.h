@@ -0,0 +1,82 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: PNTriangles.h
+//
+// CPU reference of the PN-Triangles and Phong tessellation techniques implemented in
+// SilhouetteTessellation11.hlsl. Patch corners follow the hull shader convention:
+// B003 = corner 0, B030 = corner 1, B300 = corner 2, weighted by W, U and V respectively.
+//--------------------------------------------------------------------------------------
+#ifndef PN_TRIANGLES_H
+#define PN_TRIANGLES_H
+
+// Vertex as seen by the hull shader
+struct PN_VERTEX
+{
+    DirectX::XMFLOAT3 f3Position;
+    DirectX::XMFLOAT3 f3Normal;
+    DirectX::XMFLOAT2 f2TexCoord;
+};
+
+// Control points computed by HS_PNTrianglesConstant
+struct PN_CONTROL_POINTS
+{
+    // Geometry cubic generated control points
+    DirectX::XMFLOAT3 f3B210;
+    DirectX::XMFLOAT3 f3B120;
+    DirectX::XMFLOAT3 f3B021;
+    DirectX::XMFLOAT3 f3B012;
+    DirectX::XMFLOAT3 f3B102;
+    DirectX::XMFLOAT3 f3B201;
+    DirectX::XMFLOAT3 f3B111;
+
+    // Normal quadratic generated control points
+    DirectX::XMFLOAT3 f3N110;
+    DirectX::XMFLOAT3 f3N011;
+    DirectX::XMFLOAT3 f3N101;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Computes the PN-Triangles control points of the patch formed by the 3 corners
+//--------------------------------------------------------------------------------------
+void ComputePNControlPoints( const PN_VERTEX* pCorners, PN_CONTROL_POINTS* pControlPoints );
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates the PN-Triangles patch at the given barycentric coords, as DS_PNTriangles does.
+// The returned normal is normalized.
+//--------------------------------------------------------------------------------------
+void EvaluatePNTriangle( const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints,
+                         float fU, float fV, float fW,
+                         DirectX::XMFLOAT3* pPosition, DirectX::XMFLOAT3* pNormal );
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates the Phong tessellation patch at the given barycentric coords, as
+// DS_PNTriangles does. The returned normal is normalized.
+//--------------------------------------------------------------------------------------
+void EvaluatePhongTriangle( const PN_VERTEX* pCorners, float fU, float fV, float fW,
+                            DirectX::XMFLOAT3* pPosition, DirectX::XMFLOAT3* pNormal );
+
+#endif
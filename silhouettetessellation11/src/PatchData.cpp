@@ -0,0 +1,281 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+//--------------------------------------------------------------------------------------
+// File: PatchData.cpp
+//
+// Per-patch data baked from a PN-Triangles mesh, with incremental updates.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "PatchData.h"
+
+using namespace DirectX;
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CPatchData::CPatchData() :
+    m_uUpdate( 0 ),
+    m_fPositionEpsilonSq( 0.0f ),
+    m_fNormalEpsilonSq( 0.0f )
+{
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CPatchData::~CPatchData()
+{
+    Destroy();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Bakes all the patches of the mesh and builds the vertex to patch incidence lists
+//--------------------------------------------------------------------------------------
+HRESULT CPatchData::Create( const MESH_DATA* pMeshData, float fPositionEpsilon, float fNormalEpsilon )
+{
+    assert( NULL != pMeshData );
+
+    Destroy();
+
+    if( pMeshData->Vertices.empty() || pMeshData->Indices.size() % 3 != 0 )
+    {
+        return E_INVALIDARG;
+    }
+
+    m_Vertices = pMeshData->Vertices;
+    m_Indices = pMeshData->Indices;
+    m_fPositionEpsilonSq = fPositionEpsilon * fPositionEpsilon;
+    m_fNormalEpsilonSq = fNormalEpsilon * fNormalEpsilon;
+
+    UINT uNumVertices = (UINT)m_Vertices.size();
+    UINT uNumPatches = (UINT)m_Indices.size() / 3;
+
+    // Count the patches using each vertex, then fill the lists. A patch using the same
+    // vertex twice is listed twice, which only costs a redundant check on update.
+    m_IncidenceStart.assign( uNumVertices + 1, 0 );
+    for( UINT i = 0; i < (UINT)m_Indices.size(); i++ )
+    {
+        if( m_Indices[i] >= uNumVertices )
+        {
+            Destroy();
+            return E_INVALIDARG;
+        }
+        m_IncidenceStart[m_Indices[i] + 1]++;
+    }
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        m_IncidenceStart[v + 1] += m_IncidenceStart[v];
+    }
+
+    std::vector<UINT> Fill( m_IncidenceStart.begin(), m_IncidenceStart.end() - 1 );
+    m_IncidentPatches.resize( m_Indices.size() );
+    for( UINT i = 0; i < (UINT)m_Indices.size(); i++ )
+    {
+        m_IncidentPatches[Fill[m_Indices[i]]++] = i / 3;
+    }
+
+    m_Patches.resize( uNumPatches );
+    m_PatchUpdate.assign( uNumPatches, 0 );
+    m_uUpdate = 0;
+    for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+    {
+        BuildPatch( uPatch );
+    }
+
+    m_DirtyVertices.reserve( uNumVertices );
+    m_DirtyPatches.reserve( uNumPatches );
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Releases the data
+//--------------------------------------------------------------------------------------
+void CPatchData::Destroy()
+{
+    m_Vertices.clear();
+    m_Indices.clear();
+    m_Patches.clear();
+    m_IncidenceStart.clear();
+    m_IncidentPatches.clear();
+    m_PatchUpdate.clear();
+    m_DirtyVertices.clear();
+    m_DirtyPatches.clear();
+    m_uUpdate = 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Records the vertices that moved beyond the epsilons and rebuilds their patches
+//--------------------------------------------------------------------------------------
+UINT CPatchData::Update( const PN_VERTEX* pVertices )
+{
+    assert( NULL != pVertices );
+
+    m_DirtyVertices.clear();
+    m_DirtyPatches.clear();
+
+    // Restart the update counter before it wraps, so stale entries can't match
+    if( ++m_uUpdate == 0 )
+    {
+        m_PatchUpdate.assign( m_PatchUpdate.size(), 0 );
+        m_uUpdate = 1;
+    }
+
+    XMVECTOR vPositionEpsilonSq = XMVectorReplicate( m_fPositionEpsilonSq );
+    XMVECTOR vNormalEpsilonSq = XMVectorReplicate( m_fNormalEpsilonSq );
+
+    for( UINT v = 0; v < (UINT)m_Vertices.size(); v++ )
+    {
+        const PN_VERTEX& Vertex = pVertices[v];
+        PN_VERTEX& Baked = m_Vertices[v];
+
+        XMVECTOR vPositionDeltaSq = XMVector3LengthSq( XMVectorSubtract( XMLoadFloat3( &Vertex.f3Position ), XMLoadFloat3( &Baked.f3Position ) ) );
+        XMVECTOR vNormalDeltaSq = XMVector3LengthSq( XMVectorSubtract( XMLoadFloat3( &Vertex.f3Normal ), XMLoadFloat3( &Baked.f3Normal ) ) );
+        if( XMVector3LessOrEqual( vPositionDeltaSq, vPositionEpsilonSq ) && XMVector3LessOrEqual( vNormalDeltaSq, vNormalEpsilonSq ) )
+        {
+            continue;
+        }
+
+        // Sub epsilon motion of the other vertices keeps accumulating against their
+        // baked values until it crosses the epsilon
+        Baked = Vertex;
+        m_DirtyVertices.push_back( v );
+
+        for( UINT i = m_IncidenceStart[v]; i < m_IncidenceStart[v + 1]; i++ )
+        {
+            UINT uPatch = m_IncidentPatches[i];
+            if( m_PatchUpdate[uPatch] != m_uUpdate )
+            {
+                m_PatchUpdate[uPatch] = m_uUpdate;
+                m_DirtyPatches.push_back( uPatch );
+            }
+        }
+    }
+
+    // Patches are rebuilt once all their corners are up to date
+    for( UINT i = 0; i < (UINT)m_DirtyPatches.size(); i++ )
+    {
+        BuildPatch( m_DirtyPatches[i] );
+    }
+
+    return (UINT)m_DirtyPatches.size();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Rebuilds every patch from the deformed vertices
+//--------------------------------------------------------------------------------------
+void CPatchData::RebuildAll( const PN_VERTEX* pVertices )
+{
+    assert( NULL != pVertices );
+
+    m_DirtyVertices.clear();
+    m_DirtyPatches.clear();
+
+    if( !m_Vertices.empty() )
+    {
+        memcpy( &m_Vertices[0], pVertices, m_Vertices.size() * sizeof( PN_VERTEX ) );
+    }
+
+    for( UINT uPatch = 0; uPatch < (UINT)m_Patches.size(); uPatch++ )
+    {
+        BuildPatch( uPatch );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Computes the control points, bounds and normal cone of a patch from the baked vertices
+//--------------------------------------------------------------------------------------
+void CPatchData::BuildPatch( UINT uPatch )
+{
+    PN_VERTEX Corners[3] =
+    {
+        m_Vertices[m_Indices[uPatch * 3 + 0]],
+        m_Vertices[m_Indices[uPatch * 3 + 1]],
+        m_Vertices[m_Indices[uPatch * 3 + 2]],
+    };
+
+    PATCH_DATA& Patch = m_Patches[uPatch];
+    ComputePNControlPoints( Corners, &Patch.ControlPoints );
+    const PN_CONTROL_POINTS& CP = Patch.ControlPoints;
+
+    // The patch lies within the convex hull of its 10 geometry control points
+    const XMFLOAT3* pGeometryPoints[] =
+    {
+        &Corners[0].f3Position, &Corners[1].f3Position, &Corners[2].f3Position,
+        &CP.f3B210, &CP.f3B120, &CP.f3B021, &CP.f3B012, &CP.f3B102, &CP.f3B201, &CP.f3B111,
+    };
+
+    XMVECTOR vMin = XMLoadFloat3( pGeometryPoints[0] );
+    XMVECTOR vMax = vMin;
+    for( UINT i = 1; i < ARRAYSIZE( pGeometryPoints ); i++ )
+    {
+        XMVECTOR vPoint = XMLoadFloat3( pGeometryPoints[i] );
+        vMin = XMVectorMin( vMin, vPoint );
+        vMax = XMVectorMax( vMax, vPoint );
+    }
+    XMStoreFloat3( &Patch.f3BoundsMin, vMin );
+    XMStoreFloat3( &Patch.f3BoundsMax, vMax );
+
+    // The unnormalized quadratic normal is a positive combination of its 6 control points,
+    // so a cone of less than a hemisphere around them contains every normal of the patch
+    const XMFLOAT3* pNormalPoints[] =
+    {
+        &Corners[0].f3Normal, &Corners[1].f3Normal, &Corners[2].f3Normal,
+        &CP.f3N110, &CP.f3N011, &CP.f3N101,
+    };
+
+    XMVECTOR vAxis = XMVectorZero();
+    for( UINT i = 0; i < ARRAYSIZE( pNormalPoints ); i++ )
+    {
+        vAxis = XMVectorAdd( vAxis, XMLoadFloat3( pNormalPoints[i] ) );
+    }
+    vAxis = XMVector3Normalize( vAxis );
+
+    float fConeCosAngle = 1.0f;
+    for( UINT i = 0; i < ARRAYSIZE( pNormalPoints ); i++ )
+    {
+        fConeCosAngle = std::min( fConeCosAngle, XMVectorGetX( XMVector3Dot( vAxis, XMLoadFloat3( pNormalPoints[i] ) ) ) );
+    }
+
+    // Degenerate patches can't be bounded
+    if( XMVector3IsNaN( vAxis ) || !( fConeCosAngle > 0.0f ) )
+    {
+        fConeCosAngle = -1.0f;
+        vAxis = XMVectorSet( 0.0f, 0.0f, 1.0f, 0.0f );
+    }
+
+    XMStoreFloat3( &Patch.f3ConeAxis, vAxis );
+    Patch.fConeCosAngle = fConeCosAngle;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+//--------------------------------------------------------------------------------------
+// File: PatchData.h
+//
+// Per-patch data baked from a PN-Triangles mesh: the control points, the bounds of the
+// control net and a cone bounding the patch normals. For deforming meshes only the
+// patches touching vertices that moved further than an epsilon are rebuilt, using
+// vertex to patch incidence lists built when the data is created.
+//--------------------------------------------------------------------------------------
+#ifndef PATCH_DATA_H
+#define PATCH_DATA_H
+
+#include "MeshData.h"
+
+// Baked data of one patch
+struct PATCH_DATA
+{
+    PN_CONTROL_POINTS   ControlPoints;
+    DirectX::XMFLOAT3   f3BoundsMin;        // Bounds of the corners and the geometry control points,
+    DirectX::XMFLOAT3   f3BoundsMax;        // which contain the patch
+    DirectX::XMFLOAT3   f3ConeAxis;         // Cone containing all the normals of the patch
+    float               fConeCosAngle;      // -1 if the normals span more than a hemisphere
+};
+
+
+//--------------------------------------------------------------------------------------
+// Patch data with dirty tracking
+//--------------------------------------------------------------------------------------
+class CPatchData
+{
+public:
+
+    CPatchData();
+    ~CPatchData();
+
+    // Bakes all the patches of the mesh. A vertex is dirty once its position moved further
+    // than fPositionEpsilon, or its normal further than fNormalEpsilon, from the values
+    // the patches were last built with.
+    HRESULT Create( const MESH_DATA* pMeshData, float fPositionEpsilon, float fNormalEpsilon );
+    void Destroy();
+
+    // Takes the deformed vertices (same count and order as the mesh data) and rebuilds the
+    // patches touching dirty vertices. Returns the number of patches rebuilt.
+    UINT Update( const PN_VERTEX* pVertices );
+
+    // Takes the deformed vertices and rebuilds every patch
+    void RebuildAll( const PN_VERTEX* pVertices );
+
+    UINT GetNumPatches() const { return (UINT)m_Patches.size(); }
+    const PATCH_DATA* GetPatch( UINT uPatch ) const { return &m_Patches[uPatch]; }
+
+    // The vertices the patches were last built with
+    UINT GetNumVertices() const { return (UINT)m_Vertices.size(); }
+    const PN_VERTEX* GetVertices() const { return m_Vertices.empty() ? NULL : &m_Vertices[0]; }
+
+    // Dirty vertices and rebuilt patches of the last update
+    UINT GetNumDirtyVertices() const { return (UINT)m_DirtyVertices.size(); }
+    UINT GetNumDirtyPatches() const { return (UINT)m_DirtyPatches.size(); }
+
+private:
+
+    void BuildPatch( UINT uPatch );
+
+    std::vector<PN_VERTEX>      m_Vertices;
+    std::vector<UINT>           m_Indices;
+    std::vector<PATCH_DATA>     m_Patches;
+
+    // Patches using each vertex, m_IncidentPatches[m_IncidenceStart[v]] to
+    // m_IncidentPatches[m_IncidenceStart[v + 1] - 1]
+    std::vector<UINT>           m_IncidenceStart;
+    std::vector<UINT>           m_IncidentPatches;
+
+    // Update of the last time each patch was queued, to queue it only once per update
+    std::vector<UINT>           m_PatchUpdate;
+    UINT                        m_uUpdate;
+
+    std::vector<UINT>           m_DirtyVertices;
+    std::vector<UINT>           m_DirtyPatches;
+
+    float                       m_fPositionEpsilonSq;
+    float                       m_fNormalEpsilonSq;
+};
+
+#endif
@@ -0,0 +1,236 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: PatchOrder.cpp
+//
+// Space filling curve order of the patches within each subset.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "PatchOrder.h"
+#include "VertexCache.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+// Dimensions of a key, 3 for the centroid and 3 for the normal
+static const UINT PATCH_ORDER_MAX_DIMS = 6;
+
+
+//--------------------------------------------------------------------------------------
+// Interleaves the bits of the coords, the top bit of the first coord first
+//--------------------------------------------------------------------------------------
+static UINT64 InterleaveBits( const UINT* puCoords, UINT uNumDims )
+{
+    UINT64 uKey = 0;
+    for( int iBit = PATCH_ORDER_BITS - 1; iBit >= 0; iBit-- )
+    {
+        for( UINT i = 0; i < uNumDims; i++ )
+        {
+            uKey = ( uKey << 1 ) | ( ( puCoords[i] >> iBit ) & 1 );
+        }
+    }
+
+    return uKey;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the position along the curve. The Hilbert index is the transpose form of John
+// Skilling's "Programming the Hilbert curve" (2004), read out by interleaving its bits.
+//--------------------------------------------------------------------------------------
+UINT64 GetCurveKey( PATCH_ORDER_CURVE Curve, const UINT* puCoords, UINT uNumDims )
+{
+    assert( NULL != puCoords );
+    assert( uNumDims > 0 && uNumDims <= PATCH_ORDER_MAX_DIMS );
+
+    if( PATCH_ORDER_MORTON == Curve )
+    {
+        return InterleaveBits( puCoords, uNumDims );
+    }
+
+    UINT uX[PATCH_ORDER_MAX_DIMS];
+    for( UINT i = 0; i < uNumDims; i++ )
+    {
+        uX[i] = puCoords[i] & ( ( 1u << PATCH_ORDER_BITS ) - 1 );
+    }
+
+    // Inverse undo of the excess work
+    for( UINT uQ = 1u << ( PATCH_ORDER_BITS - 1 ); uQ > 1; uQ >>= 1 )
+    {
+        UINT uP = uQ - 1;
+        for( UINT i = 0; i < uNumDims; i++ )
+        {
+            if( 0 != ( uX[i] & uQ ) )
+            {
+                uX[0] ^= uP;
+            }
+            else
+            {
+                UINT uT = ( uX[0] ^ uX[i] ) & uP;
+                uX[0] ^= uT;
+                uX[i] ^= uT;
+            }
+        }
+    }
+
+    // Gray encode
+    for( UINT i = 1; i < uNumDims; i++ )
+    {
+        uX[i] ^= uX[i - 1];
+    }
+    UINT uT = 0;
+    for( UINT uQ = 1u << ( PATCH_ORDER_BITS - 1 ); uQ > 1; uQ >>= 1 )
+    {
+        if( 0 != ( uX[uNumDims - 1] & uQ ) )
+        {
+            uT ^= uQ - 1;
+        }
+    }
+    for( UINT i = 0; i < uNumDims; i++ )
+    {
+        uX[i] ^= uT;
+    }
+
+    return InterleaveBits( uX, uNumDims );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reorders a run of triangles for the vertex cache. The run's vertices are numbered
+// locally so the cost does not depend on the size of the mesh.
+//--------------------------------------------------------------------------------------
+static void OptimizeRunVertexCache( UINT* pIndices, UINT uNumIndices, std::vector<UINT>* pLocalVertices )
+{
+    pLocalVertices->assign( pIndices, pIndices + uNumIndices );
+    std::sort( pLocalVertices->begin(), pLocalVertices->end() );
+    pLocalVertices->erase( std::unique( pLocalVertices->begin(), pLocalVertices->end() ), pLocalVertices->end() );
+
+    for( UINT i = 0; i < uNumIndices; i++ )
+    {
+        pIndices[i] = (UINT)( std::lower_bound( pLocalVertices->begin(), pLocalVertices->end(), pIndices[i] ) - pLocalVertices->begin() );
+    }
+
+    OptimizeVertexCache( pIndices, uNumIndices, (UINT)pLocalVertices->size() );
+
+    for( UINT i = 0; i < uNumIndices; i++ )
+    {
+        pIndices[i] = ( *pLocalVertices )[pIndices[i]];
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reorders the triangles of each subset along the curve
+//--------------------------------------------------------------------------------------
+void ReorderPatches( MESH_DATA* pMeshData, PATCH_ORDER_CURVE Curve, float fNormalWeight, UINT uCacheRunTriangles )
+{
+    assert( NULL != pMeshData );
+
+    fNormalWeight = std::min( std::max( fNormalWeight, 0.0f ), 1.0f );
+    UINT uNumDims = ( fNormalWeight > 0.0f ) ? 6 : 3;
+    float fMaxCoord = (float)( ( 1u << PATCH_ORDER_BITS ) - 1 );
+
+    std::vector<XMFLOAT3> Centroids, Normals;
+    std::vector< std::pair<UINT64, UINT> > Keys;
+    std::vector<UINT> Reordered, LocalVertices;
+
+    for( UINT uSubset = 0; uSubset < (UINT)pMeshData->Subsets.size(); uSubset++ )
+    {
+        const MESH_DATA_SUBSET& Subset = pMeshData->Subsets[uSubset];
+        UINT* pIndices = &pMeshData->Indices[Subset.uIndexStart];
+        UINT uNumTriangles = Subset.uIndexCount / 3;
+        if( uNumTriangles < 2 )
+        {
+            continue;
+        }
+
+        Centroids.resize( uNumTriangles );
+        Normals.resize( uNumTriangles );
+        XMVECTOR vMin = XMVectorReplicate( FLT_MAX );
+        XMVECTOR vMax = XMVectorReplicate( -FLT_MAX );
+        for( UINT t = 0; t < uNumTriangles; t++ )
+        {
+            XMVECTOR vP0 = XMLoadFloat3( &pMeshData->Vertices[pIndices[t * 3 + 0]].f3Position );
+            XMVECTOR vP1 = XMLoadFloat3( &pMeshData->Vertices[pIndices[t * 3 + 1]].f3Position );
+            XMVECTOR vP2 = XMLoadFloat3( &pMeshData->Vertices[pIndices[t * 3 + 2]].f3Position );
+            XMVECTOR vCentroid = XMVectorScale( XMVectorAdd( XMVectorAdd( vP0, vP1 ), vP2 ), 1.0f / 3.0f );
+            XMStoreFloat3( &Centroids[t], vCentroid );
+            vMin = XMVectorMin( vMin, vCentroid );
+            vMax = XMVectorMax( vMax, vCentroid );
+
+            // Degenerate triangles get a zero normal, the middle of the normal range
+            XMVECTOR vNormal = XMVector3Cross( XMVectorSubtract( vP1, vP0 ), XMVectorSubtract( vP2, vP0 ) );
+            float fLength = XMVectorGetX( XMVector3Length( vNormal ) );
+            XMStoreFloat3( &Normals[t], ( fLength > 0.0f ) ? XMVectorScale( vNormal, 1.0f / fLength ) : XMVectorZero() );
+        }
+
+        // The same scale on every axis keeps the cells cubic
+        XMFLOAT3 f3Min, f3Extent;
+        XMStoreFloat3( &f3Min, vMin );
+        XMStoreFloat3( &f3Extent, XMVectorSubtract( vMax, vMin ) );
+        float fExtent = std::max( std::max( f3Extent.x, f3Extent.y ), f3Extent.z );
+        float fScale = ( fExtent > 0.0f ) ? fMaxCoord / fExtent : 0.0f;
+        float fNormalScale = 0.5f * fMaxCoord * fNormalWeight;
+
+        Keys.resize( uNumTriangles );
+        for( UINT t = 0; t < uNumTriangles; t++ )
+        {
+            UINT uCoords[PATCH_ORDER_MAX_DIMS];
+            uCoords[0] = (UINT)std::min( ( Centroids[t].x - f3Min.x ) * fScale + 0.5f, fMaxCoord );
+            uCoords[1] = (UINT)std::min( ( Centroids[t].y - f3Min.y ) * fScale + 0.5f, fMaxCoord );
+            uCoords[2] = (UINT)std::min( ( Centroids[t].z - f3Min.z ) * fScale + 0.5f, fMaxCoord );
+            uCoords[3] = (UINT)( ( Normals[t].x + 1.0f ) * fNormalScale + 0.5f );
+            uCoords[4] = (UINT)( ( Normals[t].y + 1.0f ) * fNormalScale + 0.5f );
+            uCoords[5] = (UINT)( ( Normals[t].z + 1.0f ) * fNormalScale + 0.5f );
+
+            Keys[t] = std::make_pair( GetCurveKey( Curve, uCoords, uNumDims ), t );
+        }
+
+        // Ties keep the authoring order
+        std::sort( Keys.begin(), Keys.end() );
+
+        Reordered.resize( uNumTriangles * 3 );
+        for( UINT t = 0; t < uNumTriangles; t++ )
+        {
+            const UINT* pTriangle = &pIndices[Keys[t].second * 3];
+            Reordered[t * 3 + 0] = pTriangle[0];
+            Reordered[t * 3 + 1] = pTriangle[1];
+            Reordered[t * 3 + 2] = pTriangle[2];
+        }
+        memcpy( pIndices, &Reordered[0], uNumTriangles * 3 * sizeof( UINT ) );
+
+        if( 0 != uCacheRunTriangles )
+        {
+            for( UINT uFirst = 0; uFirst < uNumTriangles; uFirst += uCacheRunTriangles )
+            {
+                UINT uCount = std::min( uCacheRunTriangles, uNumTriangles - uFirst );
+                OptimizeRunVertexCache( &pIndices[uFirst * 3], uCount * 3, &LocalVertices );
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: PatchOrder.h
+//
+// Reorders the triangles (patches) within each subset along a Morton or Hilbert curve of
+// their centroids, optionally with the face normal as extra dimensions, so runs of
+// consecutive patches are compact for per cluster culling and the patches that survive
+// culling fill the SIMD lanes of the CPU paths.
+//--------------------------------------------------------------------------------------
+#ifndef PATCH_ORDER_H
+#define PATCH_ORDER_H
+
+#include "MeshData.h"
+
+// Bits per dimension of the curve keys
+static const UINT PATCH_ORDER_BITS = 10;
+
+enum PATCH_ORDER_CURVE
+{
+    PATCH_ORDER_MORTON,
+    PATCH_ORDER_HILBERT,
+};
+
+
+//--------------------------------------------------------------------------------------
+// Returns the position along a Morton (Z order) or Hilbert curve of a point with
+// uNumDims coords of PATCH_ORDER_BITS bits each. uNumDims * PATCH_ORDER_BITS must fit in
+// 64 bits.
+//--------------------------------------------------------------------------------------
+UINT64 GetCurveKey( PATCH_ORDER_CURVE Curve, const UINT* puCoords, UINT uNumDims );
+
+
+//--------------------------------------------------------------------------------------
+// Reorders the triangles of each subset by the curve key of their centroid, quantized in
+// the bounds of the subset's centroids. With fNormalWeight > 0 the face normal adds 3
+// dimensions, spanning fNormalWeight times the largest extent of the centroids (at most
+// 1). With uCacheRunTriangles > 0 each run of that many triangles is then reordered for
+// the post transform vertex cache, keeping its triangles. The subset ranges, materials,
+// vertices and the winding of each triangle are unchanged.
+//--------------------------------------------------------------------------------------
+void ReorderPatches( MESH_DATA* pMeshData, PATCH_ORDER_CURVE Curve, float fNormalWeight, UINT uCacheRunTriangles );
+
+#endif
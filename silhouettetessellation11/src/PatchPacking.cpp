@@ -0,0 +1,286 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: PatchPacking.cpp
+//
+// CPU reference of the packed patch constants, see PatchPacking.hlsl.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include <DirectXPackedVector.h>
+#include "PatchPacking.h"
+#include <float.h>
+
+using namespace DirectX;
+
+//--------------------------------------------------------------------------------------
+// Returns the octahedral encoding (-1.0f -> 1.0f) of a normalized vector
+//--------------------------------------------------------------------------------------
+XMFLOAT2 OctEncode( const XMFLOAT3& f3Normal )
+{
+    float fL1Norm = fabsf( f3Normal.x ) + fabsf( f3Normal.y ) + fabsf( f3Normal.z );
+    float fX = f3Normal.x / fL1Norm;
+    float fY = f3Normal.y / fL1Norm;
+
+    if( f3Normal.z < 0.0f )
+    {
+        // Fold the lower hemisphere over the diagonals
+        float fFoldedX = ( 1.0f - fabsf( fY ) ) * ( ( fX >= 0.0f ) ? 1.0f : -1.0f );
+        float fFoldedY = ( 1.0f - fabsf( fX ) ) * ( ( fY >= 0.0f ) ? 1.0f : -1.0f );
+        fX = fFoldedX;
+        fY = fFoldedY;
+    }
+
+    return XMFLOAT2( fX, fY );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the normalized vector from an octahedral encoding
+//--------------------------------------------------------------------------------------
+XMFLOAT3 OctDecode( const XMFLOAT2& f2Encoded )
+{
+    XMFLOAT3 f3Normal( f2Encoded.x, f2Encoded.y, 1.0f - fabsf( f2Encoded.x ) - fabsf( f2Encoded.y ) );
+
+    if( f3Normal.z < 0.0f )
+    {
+        // Unfold the lower hemisphere
+        float fX = ( 1.0f - fabsf( f3Normal.y ) ) * ( ( f3Normal.x >= 0.0f ) ? 1.0f : -1.0f );
+        float fY = ( 1.0f - fabsf( f3Normal.x ) ) * ( ( f3Normal.y >= 0.0f ) ? 1.0f : -1.0f );
+        f3Normal.x = fX;
+        f3Normal.y = fY;
+    }
+
+    XMStoreFloat3( &f3Normal, XMVector3Normalize( XMLoadFloat3( &f3Normal ) ) );
+
+    return f3Normal;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Packs an offset into 3 half precision values, and a signed normalized value into the
+// remaining 16 bits
+//--------------------------------------------------------------------------------------
+static void PackHalfOffset( FXMVECTOR vOffset, float fAux, UINT* pu2Packed )
+{
+    XMFLOAT3 f3Offset;
+    XMStoreFloat3( &f3Offset, vOffset );
+
+    float fClampedAux = ( fAux < -1.0f ) ? -1.0f : ( ( fAux > 1.0f ) ? 1.0f : fAux );
+    UINT uAux = (UINT)(int)floorf( fClampedAux * 32767.0f + 0.5f ) & 0xffff;
+
+    pu2Packed[0] = (UINT)PackedVector::XMConvertFloatToHalf( f3Offset.x ) | ( (UINT)PackedVector::XMConvertFloatToHalf( f3Offset.y ) << 16 );
+    pu2Packed[1] = (UINT)PackedVector::XMConvertFloatToHalf( f3Offset.z ) | ( uAux << 16 );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the offset stored by PackHalfOffset
+//--------------------------------------------------------------------------------------
+static XMVECTOR UnpackHalfOffset( const UINT* pu2Packed )
+{
+    return XMVectorSet( PackedVector::XMConvertHalfToFloat( (PackedVector::HALF)( pu2Packed[0] & 0xffff ) ),
+                        PackedVector::XMConvertHalfToFloat( (PackedVector::HALF)( pu2Packed[0] >> 16 ) ),
+                        PackedVector::XMConvertHalfToFloat( (PackedVector::HALF)( pu2Packed[1] & 0xffff ) ),
+                        0.0f );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the signed normalized value (-1.0f -> 1.0f) stored by PackHalfOffset
+//--------------------------------------------------------------------------------------
+static float UnpackHalfOffsetAux( const UINT* pu2Packed )
+{
+    float fAux = (float)(short)( pu2Packed[1] >> 16 ) / 32767.0f;
+
+    return ( fAux < -1.0f ) ? -1.0f : fAux;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Packs the control points as HS_PNTrianglesConstant does with PACKED_CP
+//--------------------------------------------------------------------------------------
+void PackPNControlPoints( const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints,
+                          PACKED_PN_CONTROL_POINTS* pPacked )
+{
+    assert( NULL != pCorners );
+    assert( NULL != pControlPoints );
+    assert( NULL != pPacked );
+
+    XMVECTOR vB003 = XMLoadFloat3( &pCorners[0].f3Position );
+    XMVECTOR vB030 = XMLoadFloat3( &pCorners[1].f3Position );
+    XMVECTOR vB300 = XMLoadFloat3( &pCorners[2].f3Position );
+    XMVECTOR vV = XMVectorScale( XMVectorAdd( XMVectorAdd( vB003, vB030 ), vB300 ), 1.0f / 3.0f );
+
+    XMFLOAT2 f2N110 = OctEncode( pControlPoints->f3N110 );
+    XMFLOAT2 f2N011 = OctEncode( pControlPoints->f3N011 );
+    XMFLOAT2 f2N101 = OctEncode( pControlPoints->f3N101 );
+
+    // Store each control point relative to the corner it was derived from
+    PackHalfOffset( XMVectorSubtract( XMLoadFloat3( &pControlPoints->f3B210 ), vB003 ), f2N110.x, pPacked->u2B210 );
+    PackHalfOffset( XMVectorSubtract( XMLoadFloat3( &pControlPoints->f3B120 ), vB030 ), f2N110.y, pPacked->u2B120 );
+    PackHalfOffset( XMVectorSubtract( XMLoadFloat3( &pControlPoints->f3B021 ), vB030 ), f2N011.x, pPacked->u2B021 );
+    PackHalfOffset( XMVectorSubtract( XMLoadFloat3( &pControlPoints->f3B012 ), vB300 ), f2N011.y, pPacked->u2B012 );
+    PackHalfOffset( XMVectorSubtract( XMLoadFloat3( &pControlPoints->f3B102 ), vB300 ), f2N101.x, pPacked->u2B102 );
+    PackHalfOffset( XMVectorSubtract( XMLoadFloat3( &pControlPoints->f3B201 ), vB003 ), f2N101.y, pPacked->u2B201 );
+    PackHalfOffset( XMVectorSubtract( XMLoadFloat3( &pControlPoints->f3B111 ), vV ), 0.0f, pPacked->u2B111 );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Unpacks the control points as DS_PNTriangles does with PACKED_CP
+//--------------------------------------------------------------------------------------
+void UnpackPNControlPoints( const PN_VERTEX* pCorners, const PACKED_PN_CONTROL_POINTS* pPacked,
+                            PN_CONTROL_POINTS* pControlPoints )
+{
+    assert( NULL != pCorners );
+    assert( NULL != pPacked );
+    assert( NULL != pControlPoints );
+
+    XMVECTOR vB003 = XMLoadFloat3( &pCorners[0].f3Position );
+    XMVECTOR vB030 = XMLoadFloat3( &pCorners[1].f3Position );
+    XMVECTOR vB300 = XMLoadFloat3( &pCorners[2].f3Position );
+    XMVECTOR vV = XMVectorScale( XMVectorAdd( XMVectorAdd( vB003, vB030 ), vB300 ), 1.0f / 3.0f );
+
+    XMStoreFloat3( &pControlPoints->f3B210, XMVectorAdd( vB003, UnpackHalfOffset( pPacked->u2B210 ) ) );
+    XMStoreFloat3( &pControlPoints->f3B120, XMVectorAdd( vB030, UnpackHalfOffset( pPacked->u2B120 ) ) );
+    XMStoreFloat3( &pControlPoints->f3B021, XMVectorAdd( vB030, UnpackHalfOffset( pPacked->u2B021 ) ) );
+    XMStoreFloat3( &pControlPoints->f3B012, XMVectorAdd( vB300, UnpackHalfOffset( pPacked->u2B012 ) ) );
+    XMStoreFloat3( &pControlPoints->f3B102, XMVectorAdd( vB300, UnpackHalfOffset( pPacked->u2B102 ) ) );
+    XMStoreFloat3( &pControlPoints->f3B201, XMVectorAdd( vB003, UnpackHalfOffset( pPacked->u2B201 ) ) );
+    XMStoreFloat3( &pControlPoints->f3B111, XMVectorAdd( vV, UnpackHalfOffset( pPacked->u2B111 ) ) );
+
+    pControlPoints->f3N110 = OctDecode( XMFLOAT2( UnpackHalfOffsetAux( pPacked->u2B210 ), UnpackHalfOffsetAux( pPacked->u2B120 ) ) );
+    pControlPoints->f3N011 = OctDecode( XMFLOAT2( UnpackHalfOffsetAux( pPacked->u2B021 ), UnpackHalfOffsetAux( pPacked->u2B012 ) ) );
+    pControlPoints->f3N101 = OctDecode( XMFLOAT2( UnpackHalfOffsetAux( pPacked->u2B102 ), UnpackHalfOffsetAux( pPacked->u2B201 ) ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns true if all the control points are finite
+//--------------------------------------------------------------------------------------
+static bool ControlPointsAreFinite( const PN_CONTROL_POINTS* pControlPoints )
+{
+    const float* pfValues = (const float*)pControlPoints;
+    for( UINT i = 0; i < sizeof( PN_CONTROL_POINTS ) / sizeof( float ); i++ )
+    {
+        if( !_finite( pfValues[i] ) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates every patch of the mesh with full precision and packed control points
+//--------------------------------------------------------------------------------------
+void MeasurePatchPackingError( const MESH_DATA* pMeshData, UINT uSegments, PATCH_PACKING_ERROR* pError )
+{
+    assert( NULL != pMeshData );
+    assert( NULL != pError );
+    assert( uSegments > 0 );
+
+    memset( pError, 0, sizeof( PATCH_PACKING_ERROR ) );
+
+    double dPositionErrorSum = 0.0;
+    double dNormalErrorSum = 0.0;
+
+    for( size_t uIndex = 0; uIndex + 2 < pMeshData->Indices.size(); uIndex += 3 )
+    {
+        PN_VERTEX Corners[3];
+        Corners[0] = pMeshData->Vertices[pMeshData->Indices[uIndex + 0]];
+        Corners[1] = pMeshData->Vertices[pMeshData->Indices[uIndex + 1]];
+        Corners[2] = pMeshData->Vertices[pMeshData->Indices[uIndex + 2]];
+
+        PN_CONTROL_POINTS ControlPoints;
+        ComputePNControlPoints( Corners, &ControlPoints );
+
+        pError->uNumPatches++;
+        if( !ControlPointsAreFinite( &ControlPoints ) )
+        {
+            pError->uNumDegeneratePatches++;
+            continue;
+        }
+
+        PACKED_PN_CONTROL_POINTS Packed;
+        PN_CONTROL_POINTS Unpacked;
+        PackPNControlPoints( Corners, &ControlPoints, &Packed );
+        UnpackPNControlPoints( Corners, &Packed, &Unpacked );
+
+        XMVECTOR vP0 = XMLoadFloat3( &Corners[0].f3Position );
+        XMVECTOR vP1 = XMLoadFloat3( &Corners[1].f3Position );
+        XMVECTOR vP2 = XMLoadFloat3( &Corners[2].f3Position );
+        XMVECTOR vLongestEdge = XMVectorMax( XMVectorMax( XMVector3Length( XMVectorSubtract( vP1, vP0 ) ),
+                                                          XMVector3Length( XMVectorSubtract( vP2, vP1 ) ) ),
+                                             XMVector3Length( XMVectorSubtract( vP0, vP2 ) ) );
+        float fLongestEdge = XMVectorGetX( vLongestEdge );
+
+        // Walk the barycentric grid, as the tessellator would for an integer factor
+        for( UINT i = 0; i <= uSegments; i++ )
+        {
+            for( UINT j = 0; j <= uSegments - i; j++ )
+            {
+                float fU = (float)i / (float)uSegments;
+                float fV = (float)j / (float)uSegments;
+                float fW = 1.0f - fU - fV;
+
+                XMFLOAT3 f3Position, f3Normal, f3PackedPosition, f3PackedNormal;
+                EvaluatePNTriangle( Corners, &ControlPoints, fU, fV, fW, &f3Position, &f3Normal );
+                EvaluatePNTriangle( Corners, &Unpacked, fU, fV, fW, &f3PackedPosition, &f3PackedNormal );
+
+                float fPositionError = XMVectorGetX( XMVector3Length( XMVectorSubtract( XMLoadFloat3( &f3Position ), XMLoadFloat3( &f3PackedPosition ) ) ) );
+
+                // acos loses too much precision near 0 degrees, use the sine as well
+                XMVECTOR vNormal = XMLoadFloat3( &f3Normal );
+                XMVECTOR vPackedNormal = XMLoadFloat3( &f3PackedNormal );
+                float fSinAngle = XMVectorGetX( XMVector3Length( XMVector3Cross( vNormal, vPackedNormal ) ) );
+                float fCosAngle = XMVectorGetX( XMVector3Dot( vNormal, vPackedNormal ) );
+                float fNormalError = XMConvertToDegrees( atan2f( fSinAngle, fCosAngle ) );
+
+                pError->fMaxPositionError = std::max( pError->fMaxPositionError, fPositionError );
+                pError->fMaxNormalErrorDegrees = std::max( pError->fMaxNormalErrorDegrees, fNormalError );
+                if( fLongestEdge > 0.0f )
+                {
+                    pError->fMaxRelativePositionError = std::max( pError->fMaxRelativePositionError, fPositionError / fLongestEdge );
+                }
+
+                dPositionErrorSum += fPositionError;
+                dNormalErrorSum += fNormalError;
+                pError->uNumSamples++;
+            }
+        }
+    }
+
+    if( pError->uNumSamples > 0 )
+    {
+        pError->fMeanPositionError = (float)( dPositionErrorSum / pError->uNumSamples );
+        pError->fMeanNormalErrorDegrees = (float)( dNormalErrorSum / pError->uNumSamples );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: PatchPacking.h
+//
+// CPU reference of the packed patch constants (PACKED_CP) in PatchPacking.hlsl, and the
+// error measurement of the packed path against the full precision path.
+//--------------------------------------------------------------------------------------
+#ifndef PATCH_PACKING_H
+#define PATCH_PACKING_H
+
+#include "MeshData.h"
+
+// Bytes of HS_ConstantOutput passed from the HS to the DS per PN-Triangles patch
+static const UINT PN_PATCH_CONSTANT_BYTES           = 136;  // 4 tess factors + 10 float3 control points
+static const UINT PACKED_PN_PATCH_CONSTANT_BYTES    = 72;   // 4 tess factors + 7 uint2 packed control points
+
+// Mirror of the PACKED_CP fields of HS_ConstantOutput. Each geometry control point is a
+// half precision offset from a corner, x | y << 16 and z | aux << 16, where aux holds one
+// 16 bit signed normalized octahedral component of a normal control point.
+struct PACKED_PN_CONTROL_POINTS
+{
+    UINT u2B210[2];     // Offset from corner 0, N110.x
+    UINT u2B120[2];     // Offset from corner 1, N110.y
+    UINT u2B021[2];     // Offset from corner 1, N011.x
+    UINT u2B012[2];     // Offset from corner 2, N011.y
+    UINT u2B102[2];     // Offset from corner 2, N101.x
+    UINT u2B201[2];     // Offset from corner 0, N101.y
+    UINT u2B111[2];     // Offset from the corner average
+};
+
+// Error of the packed path measured over a mesh
+struct PATCH_PACKING_ERROR
+{
+    UINT    uNumPatches;
+    UINT    uNumDegeneratePatches;          // Skipped, the control points are not finite
+    UINT    uNumSamples;
+    float   fMaxPositionError;              // Object space distance
+    float   fMeanPositionError;
+    float   fMaxRelativePositionError;      // Distance divided by the longest edge of the patch
+    float   fMaxNormalErrorDegrees;
+    float   fMeanNormalErrorDegrees;
+};
+
+// Bounds the packed path must stay within
+static const float PATCH_PACKING_MAX_RELATIVE_POSITION_ERROR   = 1.0f / 2048.0f;
+static const float PATCH_PACKING_MAX_NORMAL_ERROR_DEGREES       = 0.05f;
+
+
+//--------------------------------------------------------------------------------------
+// Octahedral encoding of a normalized vector, and its inverse
+//--------------------------------------------------------------------------------------
+DirectX::XMFLOAT2 OctEncode( const DirectX::XMFLOAT3& f3Normal );
+DirectX::XMFLOAT3 OctDecode( const DirectX::XMFLOAT2& f2Encoded );
+
+
+//--------------------------------------------------------------------------------------
+// Packs the control points as HS_PNTrianglesConstant does with PACKED_CP
+//--------------------------------------------------------------------------------------
+void PackPNControlPoints( const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints,
+                          PACKED_PN_CONTROL_POINTS* pPacked );
+
+
+//--------------------------------------------------------------------------------------
+// Unpacks the control points as DS_PNTriangles does with PACKED_CP
+//--------------------------------------------------------------------------------------
+void UnpackPNControlPoints( const PN_VERTEX* pCorners, const PACKED_PN_CONTROL_POINTS* pPacked,
+                            PN_CONTROL_POINTS* pControlPoints );
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates every patch of the mesh with full precision and packed control points, at the
+// barycentric coords of a uniform grid with uSegments segments per edge, and reports the
+// differences in position and normal
+//--------------------------------------------------------------------------------------
+void MeasurePatchPackingError( const MESH_DATA* pMeshData, UINT uSegments, PATCH_PACKING_ERROR* pError );
+
+#endif
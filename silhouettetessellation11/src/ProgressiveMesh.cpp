@@ -0,0 +1,1152 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ProgressiveMesh.cpp
+//
+// View dependent progressive mesh
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "ProgressiveMesh.h"
+#include "MeshSimplify.h"
+#include "Quadric.h"
+#include <algorithm>
+#include <queue>
+#include <float.h>
+
+using namespace DirectX;
+
+// Sidecar header
+static const UINT PM_FILE_MAGIC = 0x48534d50;   // "PMSH"
+static const UINT PM_FILE_VERSION = 1;
+
+struct PM_FILE_HEADER
+{
+    UINT    uMagic;
+    UINT    uVersion;
+    UINT    uNumVertices;
+    UINT    uNumCorners;
+    UINT    uNumRoots;
+    UINT    uMaxDepth;
+};
+
+// A half edge collapse in the queue, cheapest first. It is stale once either vertex
+// changed since it was queued.
+struct PM_COLLAPSE
+{
+    float   fCost;
+    UINT    uFrom;
+    UINT    uTo;
+    UINT    uFromStamp;
+    UINT    uToStamp;
+
+    bool operator<( const PM_COLLAPSE& Other ) const
+    {
+        return fCost > Other.fCost;
+    }
+};
+
+// Normal cone during the build
+struct PM_CONE
+{
+    XMFLOAT3    f3Axis;
+    float       fAngle;     // XM_PI if unbounded
+};
+
+
+//--------------------------------------------------------------------------------------
+// Returns a cone around both cones
+//--------------------------------------------------------------------------------------
+static PM_CONE MergeCones( const PM_CONE& A, const PM_CONE& B )
+{
+    if( A.fAngle >= XM_PI || B.fAngle >= XM_PI )
+    {
+        PM_CONE Unbounded = { A.f3Axis, XM_PI };
+        return Unbounded;
+    }
+
+    XMVECTOR vA = XMLoadFloat3( &A.f3Axis );
+    XMVECTOR vB = XMLoadFloat3( &B.f3Axis );
+    float fTheta = acosf( std::max( std::min( XMVectorGetX( XMVector3Dot( vA, vB ) ), 1.0f ), -1.0f ) );
+    if( fTheta + B.fAngle <= A.fAngle )
+    {
+        return A;
+    }
+    if( fTheta + A.fAngle <= B.fAngle )
+    {
+        return B;
+    }
+
+    // The cone from the far side of A to the far side of B, its axis turned from A's
+    // towards B's
+    PM_CONE Merged;
+    Merged.fAngle = 0.5f * ( fTheta + A.fAngle + B.fAngle );
+    if( Merged.fAngle >= XM_PI )
+    {
+        Merged.f3Axis = A.f3Axis;
+        Merged.fAngle = XM_PI;
+        return Merged;
+    }
+    float fTurn = Merged.fAngle - A.fAngle;
+    float fSinTheta = sinf( fTheta );
+    XMVECTOR vAxis = ( fSinTheta > 1e-6f ) ? XMVectorAdd( XMVectorScale( vA, sinf( fTheta - fTurn ) / fSinTheta ),
+                                                          XMVectorScale( vB, sinf( fTurn ) / fSinTheta ) ) : vA;
+    XMStoreFloat3( &Merged.f3Axis, XMVector3Normalize( vAxis ) );
+    return Merged;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the unnormalized normal of a triangle, from the cross product of its edges
+//--------------------------------------------------------------------------------------
+static XMVECTOR GetTriangleCross( const XMFLOAT3& f3P0, const XMFLOAT3& f3P1, const XMFLOAT3& f3P2 )
+{
+    XMVECTOR vP0 = XMLoadFloat3( &f3P0 );
+    return XMVector3Cross( XMVectorSubtract( XMLoadFloat3( &f3P1 ), vP0 ), XMVectorSubtract( XMLoadFloat3( &f3P2 ), vP0 ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Fills the view of a mesh in the space of the mesh
+//--------------------------------------------------------------------------------------
+void InitProgressiveMeshView( CXMMATRIX mWorld, CXMMATRIX mView, CXMMATRIX mProj, float fScreenHeight, float fPixelError, PM_VIEW* pView )
+{
+    assert( NULL != pView );
+
+    XMVECTOR vEye = XMMatrixInverse( NULL, mView ).r[3];
+    XMStoreFloat3( &pView->f3Eye, XMVector3TransformCoord( vEye, XMMatrixInverse( NULL, mWorld ) ) );
+
+    // The planes of the world view projection are in the space of the mesh
+    XMMATRIX mTranspose = XMMatrixTranspose( mWorld * mView * mProj );
+    XMVECTOR vPlanes[6] =
+    {
+        XMVectorAdd( mTranspose.r[3], mTranspose.r[0] ),
+        XMVectorSubtract( mTranspose.r[3], mTranspose.r[0] ),
+        XMVectorAdd( mTranspose.r[3], mTranspose.r[1] ),
+        XMVectorSubtract( mTranspose.r[3], mTranspose.r[1] ),
+        mTranspose.r[2],
+        XMVectorSubtract( mTranspose.r[3], mTranspose.r[2] ),
+    };
+    for( UINT i = 0; i < 6; i++ )
+    {
+        XMStoreFloat4( &pView->f4FrustumPlanes[i], XMPlaneNormalize( vPlanes[i] ) );
+    }
+
+    // A uniform scale of the world matrix scales the sizes and the distances alike
+    pView->fPixelsPerUnit = 0.5f * fScreenHeight * XMVectorGetY( mProj.r[1] );
+    pView->fPixelError = fPixelError;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Replaces the extension of an sdkmesh file name by PM_FILE_EXTENSION
+//--------------------------------------------------------------------------------------
+void GetProgressiveMeshFileName( const WCHAR* pszMeshFileName, WCHAR* pszFileName, UINT uMaxChars )
+{
+    wcscpy_s( pszFileName, uMaxChars, pszMeshFileName );
+    WCHAR* pszExtension = wcsrchr( pszFileName, L'.' );
+    if( NULL != pszExtension )
+    {
+        *pszExtension = 0;
+    }
+    wcscat_s( pszFileName, uMaxChars, PM_FILE_EXTENSION );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CProgressiveMesh::CProgressiveMesh() :
+    m_uNumRoots( 0 ),
+    m_uMaxDepth( 0 ),
+    m_uNumLiveTriangles( 0 ),
+    m_uNumRewritten( 0 ),
+    m_pVB( NULL ),
+    m_pIB( NULL )
+{
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CProgressiveMesh::~CProgressiveMesh()
+{
+    DestroyBuffers();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Builds the vertex hierarchy by half edge collapses in quadric error order
+//--------------------------------------------------------------------------------------
+HRESULT CProgressiveMesh::Build( const MESH_DATA* pMeshData )
+{
+    assert( NULL != pMeshData );
+
+    DestroyBuffers();
+    m_Vertices.clear();
+    m_Nodes.clear();
+    m_Corners.clear();
+    m_uNumRoots = 0;
+    m_uMaxDepth = 0;
+
+    if( pMeshData->Vertices.empty() || pMeshData->Indices.size() < 3 )
+    {
+        return E_INVALIDARG;
+    }
+
+    // Weld by position, with the mean normal, and drop the degenerate triangles
+    std::vector<UINT> Triangles;
+    WeldPositions( pMeshData, &m_Vertices, &Triangles );
+    UINT uNumVertices = (UINT)m_Vertices.size();
+    UINT uNumTriangles = (UINT)Triangles.size() / 3;
+    if( 0 == uNumTriangles )
+    {
+        m_Vertices.clear();
+        return E_INVALIDARG;
+    }
+    std::vector<UINT> SourceTriangles = Triangles;
+
+    // Triangles around each vertex, the quadrics of their planes, and the normal cones and
+    // longest edges of the detailed mesh
+    std::vector< std::vector<UINT> > VertexTriangles( uNumVertices );
+    std::vector<QUADRIC> Quadrics( uNumVertices );
+    ZeroMemory( &Quadrics[0], uNumVertices * sizeof( QUADRIC ) );
+    std::vector<PM_CONE> Cones( uNumVertices );
+    std::vector<BYTE> bHaveCone( uNumVertices, 0 );
+    std::vector<float> Radii( uNumVertices, 0.0f );
+    std::vector< std::pair<UINT64, UINT> > Edges;
+    for( UINT t = 0; t < uNumTriangles; t++ )
+    {
+        const UINT* pTri = &Triangles[t * 3];
+        XMVECTOR vCross = GetTriangleCross( m_Vertices[pTri[0]].f3Position, m_Vertices[pTri[1]].f3Position, m_Vertices[pTri[2]].f3Position );
+        QUADRIC Quadric;
+        InitTriangleQuadric( XMLoadFloat3( &m_Vertices[pTri[0]].f3Position ), XMLoadFloat3( &m_Vertices[pTri[1]].f3Position ),
+                             XMLoadFloat3( &m_Vertices[pTri[2]].f3Position ), &Quadric );
+        PM_CONE Cone = { XMFLOAT3( 0.0f, 0.0f, 1.0f ), XM_PI };
+        if( XMVectorGetX( XMVector3LengthSq( vCross ) ) > 0.0f )
+        {
+            XMStoreFloat3( &Cone.f3Axis, XMVector3Normalize( vCross ) );
+            Cone.fAngle = 0.0f;
+        }
+
+        for( UINT c = 0; c < 3; c++ )
+        {
+            UINT uVertex = pTri[c], uNext = pTri[( c + 1 ) % 3];
+            VertexTriangles[uVertex].push_back( t );
+            AddQuadric( &Quadrics[uVertex], &Quadric );
+            Cones[uVertex] = bHaveCone[uVertex] ? MergeCones( Cones[uVertex], Cone ) : Cone;
+            bHaveCone[uVertex] = 1;
+
+            float fLength = XMVectorGetX( XMVector3Length( XMVectorSubtract( XMLoadFloat3( &m_Vertices[uNext].f3Position ),
+                                                                             XMLoadFloat3( &m_Vertices[uVertex].f3Position ) ) ) );
+            Radii[uVertex] = std::max( Radii[uVertex], fLength );
+            Radii[uNext] = std::max( Radii[uNext], fLength );
+            Edges.push_back( std::make_pair( ( (UINT64)std::min( uVertex, uNext ) << 32 ) | std::max( uVertex, uNext ), t ) );
+        }
+    }
+
+    // Boundary edges, of one triangle, are held in place by the planes through them
+    std::sort( Edges.begin(), Edges.end() );
+    std::vector<BYTE> bBoundary( uNumVertices, 0 );
+    for( UINT i = 0; i < (UINT)Edges.size(); i++ )
+    {
+        bool bShared = ( i > 0 && Edges[i - 1].first == Edges[i].first ) || ( i + 1 < (UINT)Edges.size() && Edges[i + 1].first == Edges[i].first );
+        if( bShared )
+        {
+            continue;
+        }
+        UINT uA = (UINT)( Edges[i].first >> 32 ), uB = (UINT)( Edges[i].first & 0xffffffff );
+        const UINT* pTri = &Triangles[Edges[i].second * 3];
+        XMVECTOR vCross = GetTriangleCross( m_Vertices[pTri[0]].f3Position, m_Vertices[pTri[1]].f3Position, m_Vertices[pTri[2]].f3Position );
+        QUADRIC Quadric;
+        InitBoundaryQuadric( XMLoadFloat3( &m_Vertices[uA].f3Position ), XMLoadFloat3( &m_Vertices[uB].f3Position ),
+                             XMVector3Normalize( vCross ), &Quadric );
+        AddQuadric( &Quadrics[uA], &Quadric );
+        AddQuadric( &Quadrics[uB], &Quadric );
+        bBoundary[uA] = 1;
+        bBoundary[uB] = 1;
+    }
+    Edges.clear();
+
+    // Collapse in cost order
+    m_Nodes.resize( uNumVertices );
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        m_Nodes[v].uParent = UINT_MAX;
+    }
+    std::vector<UINT> Stamps( uNumVertices, 0 );
+    std::vector<BYTE> bRemoved( uNumTriangles, 0 );
+    std::vector<UINT> CollapseOrder;
+    std::vector<UINT> FromNeighbours, ToNeighbours;
+
+    // The detailed vertices each vertex stands for, and the largest error of its children
+    std::vector< std::vector<UINT> > Regions( uNumVertices );
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        Regions[v].push_back( v );
+    }
+    std::vector<float> ChildErrors( uNumVertices, 0.0f );
+    std::priority_queue<PM_COLLAPSE> Queue;
+    for( UINT uPass = 0; uPass < SIMPLIFY_MAX_PASSES; uPass++ )
+    {
+        // Both directions of every remaining edge
+        UINT uNumCollapsesBefore = (UINT)CollapseOrder.size();
+        for( UINT t = 0; t < uNumTriangles; t++ )
+        {
+            if( 0 != bRemoved[t] )
+            {
+                continue;
+            }
+            for( UINT c = 0; c < 3; c++ )
+            {
+                UINT uA = Triangles[t * 3 + c], uB = Triangles[t * 3 + ( c + 1 ) % 3];
+                QUADRIC Sum = Quadrics[uA];
+                AddQuadric( &Sum, &Quadrics[uB] );
+                PM_COLLAPSE AToB = { (float)EvaluateQuadric( &Sum, m_Vertices[uB].f3Position ), uA, uB, Stamps[uA], Stamps[uB] };
+                PM_COLLAPSE BToA = { (float)EvaluateQuadric( &Sum, m_Vertices[uA].f3Position ), uB, uA, Stamps[uB], Stamps[uA] };
+                Queue.push( AToB );
+                Queue.push( BToA );
+            }
+        }
+
+        while( !Queue.empty() )
+        {
+            PM_COLLAPSE Collapse = Queue.top();
+            Queue.pop();
+            UINT uFrom = Collapse.uFrom, uTo = Collapse.uTo;
+            if( Collapse.uFromStamp != Stamps[uFrom] || Collapse.uToStamp != Stamps[uTo] ||
+                UINT_MAX != m_Nodes[uFrom].uParent || UINT_MAX != m_Nodes[uTo].uParent )
+            {
+                continue;
+            }
+
+            // The triangles on the edge go, the others around the vertex move with it. The
+            // neighbours both ends share must be the third corners of the edge's triangles,
+            // or the collapse pinches the surface.
+            UINT uNumShared = 0;
+            FromNeighbours.clear();
+            ToNeighbours.clear();
+            for( UINT i = 0; i < (UINT)VertexTriangles[uFrom].size(); i++ )
+            {
+                const UINT* pTri = &Triangles[VertexTriangles[uFrom][i] * 3];
+                uNumShared += ( pTri[0] == uTo || pTri[1] == uTo || pTri[2] == uTo ) ? 1 : 0;
+                for( UINT c = 0; c < 3; c++ )
+                {
+                    FromNeighbours.push_back( pTri[c] );
+                }
+            }
+            for( UINT i = 0; i < (UINT)VertexTriangles[uTo].size(); i++ )
+            {
+                const UINT* pTri = &Triangles[VertexTriangles[uTo][i] * 3];
+                for( UINT c = 0; c < 3; c++ )
+                {
+                    ToNeighbours.push_back( pTri[c] );
+                }
+            }
+            std::sort( FromNeighbours.begin(), FromNeighbours.end() );
+            FromNeighbours.erase( std::unique( FromNeighbours.begin(), FromNeighbours.end() ), FromNeighbours.end() );
+            std::sort( ToNeighbours.begin(), ToNeighbours.end() );
+            ToNeighbours.erase( std::unique( ToNeighbours.begin(), ToNeighbours.end() ), ToNeighbours.end() );
+            UINT uNumCommon = 0;
+            for( UINT i = 0, j = 0; i < (UINT)FromNeighbours.size() && j < (UINT)ToNeighbours.size(); )
+            {
+                if( FromNeighbours[i] < ToNeighbours[j] )
+                {
+                    i++;
+                }
+                else if( ToNeighbours[j] < FromNeighbours[i] )
+                {
+                    j++;
+                }
+                else
+                {
+                    uNumCommon += ( FromNeighbours[i] != uFrom && FromNeighbours[i] != uTo ) ? 1 : 0;
+                    i++;
+                    j++;
+                }
+            }
+            if( 0 == uNumShared || uNumCommon != uNumShared || ( bBoundary[uFrom] && 1 != uNumShared ) )
+            {
+                continue;
+            }
+
+            // No triangle may turn over
+            bool bFlips = false;
+            for( UINT i = 0; i < (UINT)VertexTriangles[uFrom].size() && !bFlips; i++ )
+            {
+                const UINT* pTri = &Triangles[VertexTriangles[uFrom][i] * 3];
+                if( pTri[0] == uTo || pTri[1] == uTo || pTri[2] == uTo )
+                {
+                    continue;
+                }
+                XMFLOAT3 f3Moved[3];
+                for( UINT c = 0; c < 3; c++ )
+                {
+                    f3Moved[c] = m_Vertices[( pTri[c] == uFrom ) ? uTo : pTri[c]].f3Position;
+                }
+                XMVECTOR vBefore = GetTriangleCross( m_Vertices[pTri[0]].f3Position, m_Vertices[pTri[1]].f3Position, m_Vertices[pTri[2]].f3Position );
+                XMVECTOR vAfter = GetTriangleCross( f3Moved[0], f3Moved[1], f3Moved[2] );
+                float fLengths = XMVectorGetX( XMVector3Length( vBefore ) ) * XMVectorGetX( XMVector3Length( vAfter ) );
+                bFlips = !( XMVectorGetX( XMVector3Dot( vBefore, vAfter ) ) > SIMPLIFY_MIN_FLIP_COSINE * fLengths );
+            }
+            if( bFlips )
+            {
+                continue;
+            }
+
+            CollapseOrder.push_back( uFrom );
+            m_Nodes[uFrom].uParent = uTo;
+            for( UINT i = 0; i < (UINT)VertexTriangles[uFrom].size(); i++ )
+            {
+                UINT t = VertexTriangles[uFrom][i];
+                UINT* pTri = &Triangles[t * 3];
+                if( pTri[0] == uTo || pTri[1] == uTo || pTri[2] == uTo )
+                {
+                    bRemoved[t] = 1;
+                    for( UINT c = 0; c < 3; c++ )
+                    {
+                        if( pTri[c] != uFrom )
+                        {
+                            std::vector<UINT>& Around = VertexTriangles[pTri[c]];
+                            Around.erase( std::find( Around.begin(), Around.end(), t ) );
+                        }
+                    }
+                }
+                else
+                {
+                    for( UINT c = 0; c < 3; c++ )
+                    {
+                        pTri[c] = ( pTri[c] == uFrom ) ? uTo : pTri[c];
+                    }
+                    VertexTriangles[uTo].push_back( t );
+                }
+            }
+            std::vector<UINT>().swap( VertexTriangles[uFrom] );
+
+            // The error is the distance of the region to the triangles around the merged
+            // vertex, and at least that of the children, so it never shrinks up the forest
+            float fMaxDistanceSq = 0.0f;
+            for( UINT i = 0; i < (UINT)Regions[uFrom].size(); i++ )
+            {
+                XMVECTOR vPoint = XMLoadFloat3( &m_Vertices[Regions[uFrom][i]].f3Position );
+                float fDistanceSq = XMVectorGetX( XMVector3LengthSq( XMVectorSubtract( vPoint, XMLoadFloat3( &m_Vertices[uTo].f3Position ) ) ) );
+                for( UINT j = 0; j < (UINT)VertexTriangles[uTo].size(); j++ )
+                {
+                    const UINT* pTri = &Triangles[VertexTriangles[uTo][j] * 3];
+                    fDistanceSq = std::min( fDistanceSq, GetPointTriangleDistanceSq( vPoint, XMLoadFloat3( &m_Vertices[pTri[0]].f3Position ),
+                                                                                    XMLoadFloat3( &m_Vertices[pTri[1]].f3Position ),
+                                                                                    XMLoadFloat3( &m_Vertices[pTri[2]].f3Position ) ) );
+                }
+                fMaxDistanceSq = std::max( fMaxDistanceSq, fDistanceSq );
+            }
+            m_Nodes[uFrom].fError = std::max( sqrtf( fMaxDistanceSq ), ChildErrors[uFrom] );
+            ChildErrors[uTo] = std::max( ChildErrors[uTo], m_Nodes[uFrom].fError );
+            Regions[uTo].insert( Regions[uTo].end(), Regions[uFrom].begin(), Regions[uFrom].end() );
+            std::vector<UINT>().swap( Regions[uFrom] );
+
+            AddQuadric( &Quadrics[uTo], &Quadrics[uFrom] );
+            bBoundary[uTo] |= bBoundary[uFrom];
+            Stamps[uTo]++;
+
+            // Requeue the edges of the merged vertex
+            for( UINT i = 0; i < (UINT)VertexTriangles[uTo].size(); i++ )
+            {
+                const UINT* pTri = &Triangles[VertexTriangles[uTo][i] * 3];
+                for( UINT c = 0; c < 3; c++ )
+                {
+                    UINT uOther = pTri[c];
+                    if( uOther == uTo )
+                    {
+                        continue;
+                    }
+                    QUADRIC Sum = Quadrics[uTo];
+                    AddQuadric( &Sum, &Quadrics[uOther] );
+                    PM_COLLAPSE ToOther = { (float)EvaluateQuadric( &Sum, m_Vertices[uOther].f3Position ), uTo, uOther, Stamps[uTo], Stamps[uOther] };
+                    PM_COLLAPSE OtherTo = { (float)EvaluateQuadric( &Sum, m_Vertices[uTo].f3Position ), uOther, uTo, Stamps[uOther], Stamps[uTo] };
+                    Queue.push( ToOther );
+                    Queue.push( OtherTo );
+                }
+            }
+        }
+
+        if( (UINT)CollapseOrder.size() == uNumCollapsesBefore )
+        {
+            break;
+        }
+    }
+
+    // Bounds of the regions, children first: the sphere around their triangles and their
+    // normal cone, passed up to the parent
+    std::vector<UINT> Roots;
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        if( UINT_MAX == m_Nodes[v].uParent )
+        {
+            Roots.push_back( v );
+        }
+    }
+    std::vector<UINT> BoundsOrder = CollapseOrder;
+    BoundsOrder.insert( BoundsOrder.end(), Roots.begin(), Roots.end() );
+    for( UINT i = 0; i < (UINT)BoundsOrder.size(); i++ )
+    {
+        UINT uVertex = BoundsOrder[i];
+        NODE& Node = m_Nodes[uVertex];
+        Node.fRadius = Radii[uVertex];
+        XMStoreFloat3( &Node.f3ConeAxis, XMLoadFloat3( &Cones[uVertex].f3Axis ) );
+        Node.fConeCosine = ( Cones[uVertex].fAngle < XM_PI ) ? cosf( Cones[uVertex].fAngle ) : -1.0f;
+        Node.fConeSine = sqrtf( std::max( 1.0f - Node.fConeCosine * Node.fConeCosine, 0.0f ) );
+        if( UINT_MAX == Node.uParent )
+        {
+            Node.fError = ChildErrors[uVertex];
+            continue;
+        }
+
+        float fToParent = XMVectorGetX( XMVector3Length( XMVectorSubtract( XMLoadFloat3( &m_Vertices[uVertex].f3Position ),
+                                                                            XMLoadFloat3( &m_Vertices[Node.uParent].f3Position ) ) ) );
+        Radii[Node.uParent] = std::max( Radii[Node.uParent], Radii[uVertex] + fToParent );
+        Cones[Node.uParent] = MergeCones( Cones[Node.uParent], Cones[uVertex] );
+    }
+
+    // Depths, parents first
+    std::vector<UINT> Depths( uNumVertices, 0 );
+    for( UINT i = (UINT)CollapseOrder.size(); i-- > 0; )
+    {
+        UINT uVertex = CollapseOrder[i];
+        Depths[uVertex] = Depths[m_Nodes[uVertex].uParent] + 1;
+        m_uMaxDepth = std::max( m_uMaxDepth, Depths[uVertex] );
+    }
+    m_uNumRoots = (UINT)Roots.size();
+
+    m_Corners.swap( SourceTriangles );
+
+    InitRuntime();
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Writes the hierarchy to a sidecar file
+//--------------------------------------------------------------------------------------
+HRESULT CProgressiveMesh::Save( const WCHAR* pszFileName ) const
+{
+    assert( NULL != pszFileName );
+
+    if( !IsBuilt() )
+    {
+        return E_FAIL;
+    }
+
+    FILE* pOutput = NULL;
+    if( 0 != _wfopen_s( &pOutput, pszFileName, L"wb" ) || NULL == pOutput )
+    {
+        return E_ACCESSDENIED;
+    }
+
+    PM_FILE_HEADER Header = { PM_FILE_MAGIC, PM_FILE_VERSION, (UINT)m_Vertices.size(), (UINT)m_Corners.size(), m_uNumRoots, m_uMaxDepth };
+    bool bWritten = ( 1 == fwrite( &Header, sizeof( Header ), 1, pOutput ) ) &&
+                    ( m_Vertices.size() == fwrite( &m_Vertices[0], sizeof( PN_VERTEX ), m_Vertices.size(), pOutput ) ) &&
+                    ( m_Nodes.size() == fwrite( &m_Nodes[0], sizeof( NODE ), m_Nodes.size(), pOutput ) ) &&
+                    ( m_Corners.size() == fwrite( &m_Corners[0], sizeof( UINT ), m_Corners.size(), pOutput ) );
+    fclose( pOutput );
+
+    return bWritten ? S_OK : E_FAIL;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reads the hierarchy from a sidecar file, checking the references
+//--------------------------------------------------------------------------------------
+HRESULT CProgressiveMesh::Load( const WCHAR* pszFileName )
+{
+    assert( NULL != pszFileName );
+
+    DestroyBuffers();
+    m_Vertices.clear();
+    m_Nodes.clear();
+    m_Corners.clear();
+
+    FILE* pInput = NULL;
+    if( 0 != _wfopen_s( &pInput, pszFileName, L"rb" ) || NULL == pInput )
+    {
+        return E_FAIL;
+    }
+
+    PM_FILE_HEADER Header;
+    bool bRead = ( 1 == fread( &Header, sizeof( Header ), 1, pInput ) ) && PM_FILE_MAGIC == Header.uMagic &&
+                 PM_FILE_VERSION == Header.uVersion && 0 != Header.uNumVertices && 0 != Header.uNumCorners &&
+                 0 == Header.uNumCorners % 3;
+    if( bRead )
+    {
+        m_Vertices.resize( Header.uNumVertices );
+        m_Nodes.resize( Header.uNumVertices );
+        m_Corners.resize( Header.uNumCorners );
+        bRead = ( m_Vertices.size() == fread( &m_Vertices[0], sizeof( PN_VERTEX ), m_Vertices.size(), pInput ) ) &&
+                ( m_Nodes.size() == fread( &m_Nodes[0], sizeof( NODE ), m_Nodes.size(), pInput ) ) &&
+                ( m_Corners.size() == fread( &m_Corners[0], sizeof( UINT ), m_Corners.size(), pInput ) );
+    }
+    fclose( pInput );
+
+    for( UINT v = 0; v < (UINT)m_Nodes.size() && bRead; v++ )
+    {
+        bRead = ( UINT_MAX == m_Nodes[v].uParent || m_Nodes[v].uParent < Header.uNumVertices ) && v != m_Nodes[v].uParent;
+    }
+    for( UINT v = 0; v < (UINT)m_Nodes.size() && bRead; v++ )
+    {
+        // No path to a root is longer than the depth, so the parents hold no cycle
+        UINT uSteps = 0;
+        for( UINT uVertex = v; UINT_MAX != m_Nodes[uVertex].uParent && bRead; uVertex = m_Nodes[uVertex].uParent )
+        {
+            bRead = ++uSteps <= Header.uMaxDepth;
+        }
+    }
+    for( UINT i = 0; i < (UINT)m_Corners.size() && bRead; i++ )
+    {
+        bRead = m_Corners[i] < Header.uNumVertices;
+    }
+    if( !bRead )
+    {
+        m_Vertices.clear();
+        m_Nodes.clear();
+        m_Corners.clear();
+        return E_FAIL;
+    }
+
+    m_uNumRoots = Header.uNumRoots;
+    m_uMaxDepth = Header.uMaxDepth;
+    InitRuntime();
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Derives the children and the triangles around each vertex, and starts at the roots
+//--------------------------------------------------------------------------------------
+void CProgressiveMesh::InitRuntime()
+{
+    UINT uNumVertices = (UINT)m_Vertices.size();
+    UINT uNumTriangles = (UINT)m_Corners.size() / 3;
+
+    m_ChildOffsets.assign( uNumVertices + 1, 0 );
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        if( UINT_MAX != m_Nodes[v].uParent )
+        {
+            m_ChildOffsets[m_Nodes[v].uParent + 1]++;
+        }
+    }
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        m_ChildOffsets[v + 1] += m_ChildOffsets[v];
+    }
+    m_Children.resize( m_ChildOffsets[uNumVertices] );
+    std::vector<UINT> Fill( m_ChildOffsets.begin(), m_ChildOffsets.end() - 1 );
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        if( UINT_MAX != m_Nodes[v].uParent )
+        {
+            m_Children[Fill[m_Nodes[v].uParent]++] = v;
+        }
+    }
+
+    // A triangle changes when a vertex is split or collapsed only if some of its corners
+    // are in the region of the vertex and some are not, the others stay degenerate. The
+    // vertices whose region holds a corner are on the paths of the corners to their roots.
+    m_BoundaryOffsets.assign( uNumVertices + 1, 0 );
+    std::vector<UINT> Paths;
+    for( UINT uPass = 0; uPass < 2; uPass++ )
+    {
+        if( 1 == uPass )
+        {
+            for( UINT v = 0; v < uNumVertices; v++ )
+            {
+                m_BoundaryOffsets[v + 1] += m_BoundaryOffsets[v];
+            }
+            m_BoundaryTriangles.resize( m_BoundaryOffsets[uNumVertices] );
+            Fill.assign( m_BoundaryOffsets.begin(), m_BoundaryOffsets.end() - 1 );
+        }
+
+        for( UINT t = 0; t < uNumTriangles; t++ )
+        {
+            Paths.clear();
+            for( UINT c = 0; c < 3; c++ )
+            {
+                for( UINT uVertex = m_Corners[t * 3 + c]; UINT_MAX != m_Nodes[uVertex].uParent; uVertex = m_Nodes[uVertex].uParent )
+                {
+                    Paths.push_back( uVertex );
+                }
+            }
+            std::sort( Paths.begin(), Paths.end() );
+            for( UINT i = 0; i < (UINT)Paths.size(); )
+            {
+                UINT uEnd = i + 1;
+                while( uEnd < (UINT)Paths.size() && Paths[uEnd] == Paths[i] )
+                {
+                    uEnd++;
+                }
+                if( uEnd - i < 3 )
+                {
+                    if( 0 == uPass )
+                    {
+                        m_BoundaryOffsets[Paths[i] + 1]++;
+                    }
+                    else
+                    {
+                        m_BoundaryTriangles[Fill[Paths[i]]++] = t;
+                    }
+                }
+                i = uEnd;
+            }
+        }
+    }
+
+    m_bActive.assign( uNumVertices, 0 );
+    m_ActivePosition.assign( uNumVertices, UINT_MAX );
+    m_Indices.assign( m_Corners.size(), 0 );
+    m_LiveTriangles.assign( uNumTriangles, 0 );
+    m_LivePositions.assign( uNumTriangles, UINT_MAX );
+    m_bBlockDirty.assign( ( uNumTriangles + PM_BLOCK_TRIANGLES - 1 ) / PM_BLOCK_TRIANGLES, 0 );
+    m_uNumLiveTriangles = 0;
+
+    Reset();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Activates the roots only and rewrites every triangle
+//--------------------------------------------------------------------------------------
+void CProgressiveMesh::Reset()
+{
+    UINT uNumVertices = (UINT)m_Vertices.size();
+
+    m_ActiveList.clear();
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        m_bActive[v] = ( UINT_MAX == m_Nodes[v].uParent ) ? 1 : 0;
+        m_ActivePosition[v] = UINT_MAX;
+        if( 0 != m_bActive[v] )
+        {
+            m_ActivePosition[v] = (UINT)m_ActiveList.size();
+            m_ActiveList.push_back( v );
+        }
+    }
+
+    m_LivePositions.assign( m_LivePositions.size(), UINT_MAX );
+    m_uNumLiveTriangles = 0;
+    for( UINT t = 0; t < (UINT)m_Corners.size() / 3; t++ )
+    {
+        RewriteTriangle( t );
+    }
+    m_bBlockDirty.assign( m_bBlockDirty.size(), 1 );
+    m_uNumRewritten = 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns whether the region of a vertex is over the error threshold times fScale on
+// screen, and so the vertex should be active
+//--------------------------------------------------------------------------------------
+bool CProgressiveMesh::NeedsRefinement( UINT uVertex, const PM_VIEW* pView, float fScale ) const
+{
+    const NODE& Node = m_Nodes[uVertex];
+    const XMFLOAT3& f3Position = m_Vertices[uVertex].f3Position;
+
+    for( UINT i = 0; i < 6; i++ )
+    {
+        const XMFLOAT4& f4Plane = pView->f4FrustumPlanes[i];
+        if( f4Plane.x * f3Position.x + f4Plane.y * f3Position.y + f4Plane.z * f3Position.z + f4Plane.w < -Node.fRadius )
+        {
+            return false;
+        }
+    }
+
+    XMVECTOR vToEye = XMVectorSubtract( XMLoadFloat3( &pView->f3Eye ), XMLoadFloat3( &f3Position ) );
+    float fDistance = XMVectorGetX( XMVector3Length( vToEye ) );
+    if( fDistance <= Node.fRadius )
+    {
+        return true;
+    }
+
+    // Facing away entirely, facing the eye entirely, or around the silhouette, from the
+    // normal cone and the angle the sphere covers as in CSilhouetteEdgeTree::Extract
+    float fInvDistance = 1.0f / fDistance;
+    float fSineS = Node.fRadius * fInvDistance;
+    float fCosineS = sqrtf( 1.0f - fSineS * fSineS );
+    float fCosineSpread = Node.fConeCosine * fCosineS - Node.fConeSine * fSineS;
+    float fSineSpread = Node.fConeSine * fCosineS + Node.fConeCosine * fSineS;
+    float fCosine = XMVectorGetX( XMVector3Dot( XMLoadFloat3( &Node.f3ConeAxis ), vToEye ) ) * fInvDistance;
+    float fErrorScale = 1.0f;
+    if( fCosineSpread > 0.0f && fCosine < -fSineSpread )
+    {
+        return false;
+    }
+    if( fCosineSpread > 0.0f && fCosine > fSineSpread )
+    {
+        fErrorScale = 1.0f / PM_INTERIOR_ERROR_SCALE;
+    }
+
+    float fPixels = Node.fError * fErrorScale * pView->fPixelsPerUnit / ( fDistance - Node.fRadius );
+    return fPixels > pView->fPixelError * fScale;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the nearest active ancestors of the corners of a triangle
+//--------------------------------------------------------------------------------------
+void CProgressiveMesh::GetActiveCorners( UINT uTriangle, UINT* puCorners ) const
+{
+    for( UINT c = 0; c < 3; c++ )
+    {
+        puCorners[c] = m_Corners[uTriangle * 3 + c];
+        while( 0 == m_bActive[puCorners[c]] )
+        {
+            puCorners[c] = m_Nodes[puCorners[c]].uParent;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns whether collapsing an active vertex onto its parent, which is active, would
+// turn a drawn triangle over, as the offline collapses are tested
+//--------------------------------------------------------------------------------------
+bool CProgressiveMesh::CollapseFlips( UINT uVertex ) const
+{
+    UINT uParent = m_Nodes[uVertex].uParent;
+    for( UINT i = m_BoundaryOffsets[uVertex]; i < m_BoundaryOffsets[uVertex + 1]; i++ )
+    {
+        UINT uTriangle = m_BoundaryTriangles[i];
+        if( UINT_MAX == m_LivePositions[uTriangle] )
+        {
+            continue;
+        }
+
+        UINT uCorner[3], uMoved[3];
+        GetActiveCorners( uTriangle, uCorner );
+        for( UINT c = 0; c < 3; c++ )
+        {
+            uMoved[c] = ( uCorner[c] == uVertex ) ? uParent : uCorner[c];
+        }
+
+        // Unchanged, or degenerate after the collapse
+        if( ( uMoved[0] == uCorner[0] && uMoved[1] == uCorner[1] && uMoved[2] == uCorner[2] ) ||
+            uMoved[0] == uMoved[1] || uMoved[1] == uMoved[2] || uMoved[2] == uMoved[0] )
+        {
+            continue;
+        }
+
+        XMVECTOR vBefore = GetTriangleCross( m_Vertices[uCorner[0]].f3Position, m_Vertices[uCorner[1]].f3Position, m_Vertices[uCorner[2]].f3Position );
+        XMVECTOR vAfter = GetTriangleCross( m_Vertices[uMoved[0]].f3Position, m_Vertices[uMoved[1]].f3Position, m_Vertices[uMoved[2]].f3Position );
+        float fLengths = XMVectorGetX( XMVector3Length( vBefore ) ) * XMVectorGetX( XMVector3Length( vAfter ) );
+        if( !( XMVectorGetX( XMVector3Dot( vBefore, vAfter ) ) > SIMPLIFY_MIN_FLIP_COSINE * fLengths ) )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Rewrites the triangles a split or collapse of a vertex may change
+//--------------------------------------------------------------------------------------
+void CProgressiveMesh::RewriteBoundary( UINT uVertex )
+{
+    for( UINT i = m_BoundaryOffsets[uVertex]; i < m_BoundaryOffsets[uVertex + 1]; i++ )
+    {
+        RewriteTriangle( m_BoundaryTriangles[i] );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Rewrites a triangle from the nearest active ancestors of its corners, adding it to the
+// list or removing it as it comes to life or degenerates
+//--------------------------------------------------------------------------------------
+void CProgressiveMesh::RewriteTriangle( UINT uTriangle )
+{
+    UINT uCorner[3];
+    GetActiveCorners( uTriangle, uCorner );
+    bool bLive = uCorner[0] != uCorner[1] && uCorner[1] != uCorner[2] && uCorner[2] != uCorner[0];
+    UINT uPosition = m_LivePositions[uTriangle];
+    if( UINT_MAX == uPosition && !bLive )
+    {
+        return;
+    }
+
+    if( bLive )
+    {
+        if( UINT_MAX == uPosition )
+        {
+            uPosition = m_uNumLiveTriangles++;
+            m_LivePositions[uTriangle] = uPosition;
+            m_LiveTriangles[uPosition] = uTriangle;
+        }
+        else if( uCorner[0] == m_Indices[uPosition * 3] && uCorner[1] == m_Indices[uPosition * 3 + 1] && uCorner[2] == m_Indices[uPosition * 3 + 2] )
+        {
+            return;
+        }
+        memcpy( &m_Indices[uPosition * 3], uCorner, sizeof( uCorner ) );
+    }
+    else
+    {
+        // The last triangle of the list takes its place
+        UINT uLast = --m_uNumLiveTriangles;
+        UINT uLastTriangle = m_LiveTriangles[uLast];
+        m_LivePositions[uTriangle] = UINT_MAX;
+        if( uLast != uPosition )
+        {
+            memcpy( &m_Indices[uPosition * 3], &m_Indices[uLast * 3], 3 * sizeof( UINT ) );
+            m_LiveTriangles[uPosition] = uLastTriangle;
+            m_LivePositions[uLastTriangle] = uPosition;
+        }
+    }
+
+    m_bBlockDirty[uPosition / PM_BLOCK_TRIANGLES] = 1;
+    m_uNumRewritten++;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Splits the children of the front over the threshold, including those of the vertices
+// split on the way, then collapses the vertices under it whose children are all inactive,
+// unless the collapse would turn a triangle over
+//--------------------------------------------------------------------------------------
+void CProgressiveMesh::Update( const PM_VIEW* pView, PM_UPDATE_STATS* pStats )
+{
+    assert( NULL != pView );
+
+    UINT uNumSplits = 0, uNumCollapses = 0, uNumRefusedCollapses = 0, uNumVisited = 0;
+    m_uNumRewritten = 0;
+
+    for( UINT i = 0; i < (UINT)m_ActiveList.size(); i++ )
+    {
+        UINT uVertex = m_ActiveList[i];
+        for( UINT j = m_ChildOffsets[uVertex]; j < m_ChildOffsets[uVertex + 1]; j++ )
+        {
+            UINT uChild = m_Children[j];
+            uNumVisited++;
+            if( 0 != m_bActive[uChild] || !NeedsRefinement( uChild, pView, 1.0f ) )
+            {
+                continue;
+            }
+
+            m_bActive[uChild] = 1;
+            m_ActivePosition[uChild] = (UINT)m_ActiveList.size();
+            m_ActiveList.push_back( uChild );
+            RewriteBoundary( uChild );
+            uNumSplits++;
+        }
+    }
+
+    // From the end, so the vertex swapped into a removed one's place was visited
+    for( UINT i = (UINT)m_ActiveList.size(); i-- > 0; )
+    {
+        UINT uVertex = m_ActiveList[i];
+        UINT uParent = m_Nodes[uVertex].uParent;
+        if( UINT_MAX == uParent )
+        {
+            continue;
+        }
+        bool bLeafOfFront = true;
+        for( UINT j = m_ChildOffsets[uVertex]; j < m_ChildOffsets[uVertex + 1] && bLeafOfFront; j++ )
+        {
+            bLeafOfFront = ( 0 == m_bActive[m_Children[j]] );
+        }
+        uNumVisited++;
+        if( !bLeafOfFront || NeedsRefinement( uVertex, pView, 1.0f / PM_HYSTERESIS ) )
+        {
+            continue;
+        }
+        if( CollapseFlips( uVertex ) )
+        {
+            uNumRefusedCollapses++;
+            continue;
+        }
+
+        UINT uLast = m_ActiveList.back();
+        m_ActiveList[i] = uLast;
+        m_ActivePosition[uLast] = i;
+        m_ActiveList.pop_back();
+        m_ActivePosition[uVertex] = UINT_MAX;
+        m_bActive[uVertex] = 0;
+        RewriteBoundary( uVertex );
+        uNumCollapses++;
+    }
+
+    if( NULL != pStats )
+    {
+        pStats->uNumSplits = uNumSplits;
+        pStats->uNumCollapses = uNumCollapses;
+        pStats->uNumRefusedCollapses = uNumRefusedCollapses;
+        pStats->uNumVisited = uNumVisited;
+        pStats->uNumActiveVertices = (UINT)m_ActiveList.size();
+        pStats->uNumTriangles = m_uNumLiveTriangles;
+        pStats->uNumRewrittenTriangles = m_uNumRewritten;
+        pStats->uNumDirtyBlocks = (UINT)std::count( m_bBlockDirty.begin(), m_bBlockDirty.end(), (BYTE)1 );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the indices of the triangles in the list, in the order of the detailed mesh
+//--------------------------------------------------------------------------------------
+void CProgressiveMesh::GetLiveTriangles( std::vector<UINT>* pIndices ) const
+{
+    assert( NULL != pIndices );
+
+    pIndices->clear();
+    for( UINT t = 0; t < (UINT)m_LivePositions.size(); t++ )
+    {
+        if( UINT_MAX != m_LivePositions[t] )
+        {
+            pIndices->insert( pIndices->end(), &m_Indices[m_LivePositions[t] * 3], &m_Indices[m_LivePositions[t] * 3] + 3 );
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Rebuilds the triangles of the front from the active flags alone
+//--------------------------------------------------------------------------------------
+void CProgressiveMesh::GetReferenceTriangles( std::vector<UINT>* pIndices ) const
+{
+    assert( NULL != pIndices );
+
+    pIndices->clear();
+    for( UINT t = 0; t < (UINT)m_Corners.size() / 3; t++ )
+    {
+        UINT uCorner[3];
+        for( UINT c = 0; c < 3; c++ )
+        {
+            uCorner[c] = m_Corners[t * 3 + c];
+            while( 0 == m_bActive[uCorner[c]] )
+            {
+                uCorner[c] = m_Nodes[uCorner[c]].uParent;
+            }
+        }
+        if( uCorner[0] != uCorner[1] && uCorner[1] != uCorner[2] && uCorner[2] != uCorner[0] )
+        {
+            pIndices->insert( pIndices->end(), uCorner, uCorner + 3 );
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Creates the vertex buffer and the index buffer of the current front
+//--------------------------------------------------------------------------------------
+HRESULT CProgressiveMesh::CreateBuffers( ID3D11Device* pd3dDevice )
+{
+    HRESULT hr = S_OK;
+
+    assert( NULL != pd3dDevice );
+
+    DestroyBuffers();
+    if( !IsBuilt() )
+    {
+        return E_FAIL;
+    }
+
+    D3D11_BUFFER_DESC Desc;
+    Desc.Usage = D3D11_USAGE_IMMUTABLE;
+    Desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    Desc.CPUAccessFlags = 0;
+    Desc.MiscFlags = 0;
+    Desc.StructureByteStride = 0;
+    Desc.ByteWidth = (UINT)m_Vertices.size() * sizeof( PN_VERTEX );
+    D3D11_SUBRESOURCE_DATA InitData;
+    ZeroMemory( &InitData, sizeof( InitData ) );
+    InitData.pSysMem = &m_Vertices[0];
+    V_RETURN( pd3dDevice->CreateBuffer( &Desc, &InitData, &m_pVB ) );
+
+    Desc.Usage = D3D11_USAGE_DEFAULT;
+    Desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+    Desc.ByteWidth = (UINT)m_Indices.size() * sizeof( UINT );
+    InitData.pSysMem = &m_Indices[0];
+    hr = pd3dDevice->CreateBuffer( &Desc, &InitData, &m_pIB );
+    if( FAILED( hr ) )
+    {
+        DestroyBuffers();
+        return hr;
+    }
+    ClearDirtyBlocks();
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Releases the buffers
+//--------------------------------------------------------------------------------------
+void CProgressiveMesh::DestroyBuffers()
+{
+    SAFE_RELEASE( m_pVB );
+    SAFE_RELEASE( m_pIB );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Uploads each run of dirty blocks of the list, up to its end
+//--------------------------------------------------------------------------------------
+void CProgressiveMesh::UploadIndices( ID3D11DeviceContext* pd3dImmediateContext )
+{
+    assert( NULL != pd3dImmediateContext );
+
+    if( NULL == m_pIB )
+    {
+        return;
+    }
+
+    UINT uNumBlocks = (UINT)m_bBlockDirty.size();
+    for( UINT uBlock = 0; uBlock < uNumBlocks; )
+    {
+        if( 0 == m_bBlockDirty[uBlock] )
+        {
+            uBlock++;
+            continue;
+        }
+
+        UINT uEnd = uBlock;
+        while( uEnd < uNumBlocks && 0 != m_bBlockDirty[uEnd] )
+        {
+            m_bBlockDirty[uEnd++] = 0;
+        }
+        UINT uFirstIndex = uBlock * PM_BLOCK_TRIANGLES * 3;
+        UINT uEndIndex = std::min( uEnd * PM_BLOCK_TRIANGLES * 3, m_uNumLiveTriangles * 3 );
+        if( uFirstIndex >= uEndIndex )
+        {
+            break;
+        }
+        D3D11_BOX Box = { uFirstIndex * (UINT)sizeof( UINT ), 0, 0, uEndIndex * (UINT)sizeof( UINT ), 1, 1 };
+        pd3dImmediateContext->UpdateSubresource( m_pIB, 0, &Box, &m_Indices[uFirstIndex], 0, 0 );
+        uBlock = uEnd;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
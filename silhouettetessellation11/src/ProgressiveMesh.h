@@ -0,0 +1,211 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ProgressiveMesh.h
+//
+// View dependent progressive mesh, as a CPU alternative to the tessellation stages. The
+// detailed mesh, the PN-Triangles surface baked at PM_SOURCE_TESS_FACTOR, is simplified
+// offline by half edge collapses in quadric error order. Each collapse moves a vertex onto
+// a neighbour, its parent, so the vertices form a forest whose roots are the coarsest mesh.
+//
+// At runtime a vertex is active while the error of drawing its region with its parent is
+// over the threshold on screen, with the threshold scaled up away from the silhouette and
+// regions outside the frustum or facing away not refined. Only the front of the active
+// vertices and their children is visited each frame, and a vertex is split or collapsed
+// one at a time. A triangle of the detailed mesh is drawn with the nearest active ancestor
+// of each corner, unless two corners share one. The triangles drawn are kept in a compact
+// list: a split or collapse rewrites the triangles around its region, appending those that
+// come to life and moving the last into the place of those that degenerate, and only the
+// blocks of the list that changed are uploaded.
+//
+// As with the vertex collapses of Hoppe's view dependent meshes, a collapse that would
+// turn a drawn triangle around it over (see SIMPLIFY_MIN_FLIP_COSINE) is refused and the
+// vertex stays active until its neighbours change. A split is not checked, so folds remain
+// possible where a region is refined next to a much coarser one. The hysteresis and the
+// monotone errors keep the front from flickering.
+//--------------------------------------------------------------------------------------
+#ifndef PROGRESSIVE_MESH_H
+#define PROGRESSIVE_MESH_H
+
+#include "MeshData.h"
+
+// Uniform tess factor the detailed mesh is baked with
+static const float PM_SOURCE_TESS_FACTOR = 8.0f;
+
+// Default screen error at the silhouette, in pixels
+static const float PM_PIXEL_ERROR = 1.0f;
+
+// Error allowed away from the silhouette, as a multiple of the silhouette error
+static const float PM_INTERIOR_ERROR_SCALE = 4.0f;
+
+// An active vertex is only collapsed under the threshold divided by this
+static const float PM_HYSTERESIS = 1.25f;
+
+// The index buffer is uploaded in blocks of this many triangles
+static const UINT PM_BLOCK_TRIANGLES = 256;
+
+// Sidecar the progressive mesh of <mesh>.sdkmesh is stored in
+#define PM_FILE_EXTENSION L".progmesh"
+
+// The view the mesh is refined for, in the space of the mesh
+struct PM_VIEW
+{
+    DirectX::XMFLOAT3   f3Eye;
+    DirectX::XMFLOAT4   f4FrustumPlanes[6];     // Pointing inwards, normalized
+    float               fPixelsPerUnit;         // Pixels per unit of size at distance 1
+    float               fPixelError;            // At the silhouette
+};
+
+struct PM_UPDATE_STATS
+{
+    UINT    uNumSplits;
+    UINT    uNumCollapses;
+    UINT    uNumRefusedCollapses;   // Would have turned a triangle over
+    UINT    uNumVisited;            // Active vertices and children tested
+    UINT    uNumActiveVertices;
+    UINT    uNumTriangles;          // Drawn
+    UINT    uNumRewrittenTriangles; // Changed, appended or removed
+    UINT    uNumDirtyBlocks;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Fills the view of a mesh drawn with mWorld, which may only rotate, translate and scale
+// uniformly, seen through mView and mProj on a screen fScreenHeight pixels high
+//--------------------------------------------------------------------------------------
+void InitProgressiveMeshView( DirectX::CXMMATRIX mWorld, DirectX::CXMMATRIX mView, DirectX::CXMMATRIX mProj, float fScreenHeight,
+                              float fPixelError, PM_VIEW* pView );
+
+
+//--------------------------------------------------------------------------------------
+// Replaces the extension of an sdkmesh file name by PM_FILE_EXTENSION
+//--------------------------------------------------------------------------------------
+void GetProgressiveMeshFileName( const WCHAR* pszMeshFileName, WCHAR* pszFileName, UINT uMaxChars );
+
+
+//--------------------------------------------------------------------------------------
+// Vertex hierarchy of a mesh, its refinement front, and the vertex and index buffers
+//--------------------------------------------------------------------------------------
+class CProgressiveMesh
+{
+public:
+
+    CProgressiveMesh();
+    ~CProgressiveMesh();
+
+    // Welds the vertices by position, with the mean normal and the texture coords of the
+    // first one, and collapses them down to the coarsest mesh the collapses allow. The
+    // mesh is left at its coarsest.
+    HRESULT Build( const MESH_DATA* pMeshData );
+
+    HRESULT Save( const WCHAR* pszFileName ) const;
+    HRESULT Load( const WCHAR* pszFileName );
+
+    bool IsBuilt() const { return !m_Nodes.empty(); }
+    UINT GetNumVertices() const { return (UINT)m_Vertices.size(); }
+    UINT GetNumTriangles() const { return (UINT)m_Corners.size() / 3; }
+    UINT GetNumRoots() const { return m_uNumRoots; }
+    UINT GetMaxDepth() const { return m_uMaxDepth; }
+
+    // Back to the roots only
+    void Reset();
+
+    // Splits and collapses vertices until the front meets the view. pStats may be NULL.
+    void Update( const PM_VIEW* pView, PM_UPDATE_STATS* pStats );
+
+    const std::vector<PN_VERTEX>& GetVertices() const { return m_Vertices; }
+
+    // The triangles drawn, in no particular order, followed by unused space
+    const std::vector<UINT>& GetIndices() const { return m_Indices; }
+    UINT GetNumIndicesToDraw() const { return m_uNumLiveTriangles * 3; }
+
+    // The indices of the triangles drawn, in the order of the detailed mesh, from the list
+    // and rebuilt from scratch as the reference for the updates
+    void GetLiveTriangles( std::vector<UINT>* pIndices ) const;
+    void GetReferenceTriangles( std::vector<UINT>* pIndices ) const;
+
+    // A static vertex buffer and a default index buffer of room for every triangle,
+    // updated by block
+    HRESULT CreateBuffers( ID3D11Device* pd3dDevice );
+    void DestroyBuffers();
+    void UploadIndices( ID3D11DeviceContext* pd3dImmediateContext );
+
+    // For indices consumed without UploadIndices, as by the headless tools
+    void ClearDirtyBlocks() { m_bBlockDirty.assign( m_bBlockDirty.size(), 0 ); }
+    ID3D11Buffer* GetVB() const { return m_pVB; }
+    ID3D11Buffer* GetIB() const { return m_pIB; }
+
+private:
+
+    // A vertex of the hierarchy. fError is the distance of the detailed vertices of its
+    // region, itself and its descendants, to the triangles around its parent once it was
+    // collapsed, and at least the error of its children. The sphere of radius fRadius
+    // around it bounds the detailed triangles of its region, whose normals are within the
+    // cone.
+    struct NODE
+    {
+        UINT                uParent;        // UINT_MAX for the roots
+        float               fError;
+        float               fRadius;
+        DirectX::XMFLOAT3   f3ConeAxis;
+        float               fConeCosine;    // Of the half angle, -1 if unbounded
+        float               fConeSine;
+    };
+
+    void InitRuntime();
+    bool NeedsRefinement( UINT uVertex, const PM_VIEW* pView, float fScale ) const;
+    void GetActiveCorners( UINT uTriangle, UINT* puCorners ) const;
+    bool CollapseFlips( UINT uVertex ) const;
+    void RewriteBoundary( UINT uVertex );
+    void RewriteTriangle( UINT uTriangle );
+
+    // Offline
+    std::vector<PN_VERTEX>  m_Vertices;
+    std::vector<NODE>       m_Nodes;
+    std::vector<UINT>       m_Corners;              // 3 per triangle
+    UINT                    m_uNumRoots;
+    UINT                    m_uMaxDepth;
+
+    // Derived on build and load: the children of each vertex and the triangles with
+    // corners both in and out of its region, as offsets into flat arrays
+    std::vector<UINT>       m_ChildOffsets;
+    std::vector<UINT>       m_Children;
+    std::vector<UINT>       m_BoundaryOffsets;
+    std::vector<UINT>       m_BoundaryTriangles;
+
+    // Front
+    std::vector<BYTE>       m_bActive;
+    std::vector<UINT>       m_ActiveList;
+    std::vector<UINT>       m_ActivePosition;       // In m_ActiveList
+    std::vector<UINT>       m_Indices;              // 3 per triangle of the list
+    std::vector<UINT>       m_LiveTriangles;        // Triangle of each place in the list
+    std::vector<UINT>       m_LivePositions;        // Place of each triangle, UINT_MAX if degenerate
+    std::vector<BYTE>       m_bBlockDirty;
+    UINT                    m_uNumLiveTriangles;
+    UINT                    m_uNumRewritten;
+
+    ID3D11Buffer*           m_pVB;
+    ID3D11Buffer*           m_pIB;
+};
+
+#endif
@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: Quadric.cpp
+//
+// Quadric error metric
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "Quadric.h"
+
+using namespace DirectX;
+
+
+//--------------------------------------------------------------------------------------
+// Sets the quadric of a plane times a weight
+//--------------------------------------------------------------------------------------
+static void InitPlaneQuadric( double fA, double fB, double fC, double fD, double fWeight, QUADRIC* pQuadric )
+{
+    pQuadric->fA2 = fWeight * fA * fA;
+    pQuadric->fAB = fWeight * fA * fB;
+    pQuadric->fAC = fWeight * fA * fC;
+    pQuadric->fAD = fWeight * fA * fD;
+    pQuadric->fB2 = fWeight * fB * fB;
+    pQuadric->fBC = fWeight * fB * fC;
+    pQuadric->fBD = fWeight * fB * fD;
+    pQuadric->fC2 = fWeight * fC * fC;
+    pQuadric->fCD = fWeight * fC * fD;
+    pQuadric->fD2 = fWeight * fD * fD;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Sets the quadric of the plane of a triangle weighted by its area
+//--------------------------------------------------------------------------------------
+void InitTriangleQuadric( FXMVECTOR vP0, FXMVECTOR vP1, FXMVECTOR vP2, QUADRIC* pQuadric )
+{
+    assert( NULL != pQuadric );
+
+    XMVECTOR vCross = XMVector3Cross( XMVectorSubtract( vP1, vP0 ), XMVectorSubtract( vP2, vP0 ) );
+    float fLength = XMVectorGetX( XMVector3Length( vCross ) );
+    if( !( fLength > 0.0f ) )
+    {
+        ZeroMemory( pQuadric, sizeof( QUADRIC ) );
+        return;
+    }
+
+    XMVECTOR vNormal = XMVectorScale( vCross, 1.0f / fLength );
+    InitPlaneQuadric( XMVectorGetX( vNormal ), XMVectorGetY( vNormal ), XMVectorGetZ( vNormal ),
+                      -XMVectorGetX( XMVector3Dot( vNormal, vP0 ) ), 0.5 * fLength, pQuadric );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Sets the quadric of the plane through a boundary edge, perpendicular to its face
+//--------------------------------------------------------------------------------------
+void InitBoundaryQuadric( FXMVECTOR vP0, FXMVECTOR vP1, FXMVECTOR vFaceNormal, QUADRIC* pQuadric )
+{
+    assert( NULL != pQuadric );
+
+    XMVECTOR vEdge = XMVectorSubtract( vP1, vP0 );
+    XMVECTOR vNormal = XMVector3Cross( vEdge, vFaceNormal );
+    float fLength = XMVectorGetX( XMVector3Length( vNormal ) );
+    if( !( fLength > 0.0f ) )
+    {
+        ZeroMemory( pQuadric, sizeof( QUADRIC ) );
+        return;
+    }
+
+    vNormal = XMVectorScale( vNormal, 1.0f / fLength );
+    InitPlaneQuadric( XMVectorGetX( vNormal ), XMVectorGetY( vNormal ), XMVectorGetZ( vNormal ),
+                      -XMVectorGetX( XMVector3Dot( vNormal, vP0 ) ),
+                      QUADRIC_BOUNDARY_WEIGHT * XMVectorGetX( XMVector3LengthSq( vEdge ) ), pQuadric );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Adds two quadrics
+//--------------------------------------------------------------------------------------
+void AddQuadric( QUADRIC* pDest, const QUADRIC* pSource )
+{
+    assert( NULL != pDest && NULL != pSource );
+
+    pDest->fA2 += pSource->fA2;
+    pDest->fAB += pSource->fAB;
+    pDest->fAC += pSource->fAC;
+    pDest->fAD += pSource->fAD;
+    pDest->fB2 += pSource->fB2;
+    pDest->fBC += pSource->fBC;
+    pDest->fBD += pSource->fBD;
+    pDest->fC2 += pSource->fC2;
+    pDest->fCD += pSource->fCD;
+    pDest->fD2 += pSource->fD2;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates p^T Q p with p = ( x, y, z, 1 )
+//--------------------------------------------------------------------------------------
+double EvaluateQuadric( const QUADRIC* pQuadric, const XMFLOAT3& f3Position )
+{
+    assert( NULL != pQuadric );
+
+    double fX = f3Position.x, fY = f3Position.y, fZ = f3Position.z;
+    double fError = pQuadric->fA2 * fX * fX + pQuadric->fB2 * fY * fY + pQuadric->fC2 * fZ * fZ + pQuadric->fD2 +
+                    2.0 * ( pQuadric->fAB * fX * fY + pQuadric->fAC * fX * fZ + pQuadric->fBC * fY * fZ +
+                            pQuadric->fAD * fX + pQuadric->fBD * fY + pQuadric->fCD * fZ );
+
+    // Rounding can take the sum a little under 0
+    return ( fError > 0.0 ) ? fError : 0.0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
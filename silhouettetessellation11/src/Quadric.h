@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: Quadric.h
+//
+// Quadric error metric of Garland and Heckbert: the sum of the squared distances of a point
+// to a set of planes, kept as a symmetric 4x4 matrix so sets of planes merge by addition.
+// Accumulated in double, the sums of many small planes lose too much in float.
+//--------------------------------------------------------------------------------------
+#ifndef QUADRIC_H
+#define QUADRIC_H
+
+// Weight of the planes through the boundary edges, perpendicular to their face, relative
+// to the area weighted face planes
+static const double QUADRIC_BOUNDARY_WEIGHT = 100.0;
+
+// Upper triangle of the matrix of the planes ( a, b, c, d ), row by row
+struct QUADRIC
+{
+    double  fA2, fAB, fAC, fAD;
+    double  fB2, fBC, fBD;
+    double  fC2, fCD;
+    double  fD2;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Sets the quadric of the plane through p0, p1 and p2, weighted by the area of the
+// triangle. Degenerate triangles give the zero quadric.
+//--------------------------------------------------------------------------------------
+void InitTriangleQuadric( DirectX::FXMVECTOR vP0, DirectX::FXMVECTOR vP1, DirectX::FXMVECTOR vP2, QUADRIC* pQuadric );
+
+
+//--------------------------------------------------------------------------------------
+// Sets the quadric of the plane through the edge p0 p1 perpendicular to vFaceNormal,
+// weighted by the squared length of the edge times QUADRIC_BOUNDARY_WEIGHT. Keeps
+// boundaries and seams in place.
+//--------------------------------------------------------------------------------------
+void InitBoundaryQuadric( DirectX::FXMVECTOR vP0, DirectX::FXMVECTOR vP1, DirectX::FXMVECTOR vFaceNormal, QUADRIC* pQuadric );
+
+
+//--------------------------------------------------------------------------------------
+// Adds pSource to pDest
+//--------------------------------------------------------------------------------------
+void AddQuadric( QUADRIC* pDest, const QUADRIC* pSource );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the weighted sum of the squared distances of the position to the planes
+//--------------------------------------------------------------------------------------
+double EvaluateQuadric( const QUADRIC* pQuadric, const DirectX::XMFLOAT3& f3Position );
+
+#endif
@@ -0,0 +1,300 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: SDKMeshWriter.cpp
+//
+// Writes mesh data back to an sdkmesh.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "..\\..\\DXUT\\Optional\\SDKmesh.h"
+#include "SDKMeshWriter.h"
+#include <float.h>
+
+using namespace DirectX;
+
+// Layout of the vertex buffers, as read by ExtractMeshData and the sample's input layout
+static const D3DVERTEXELEMENT9 PN_VERTEX_DECL[] =
+{
+    { 0, 0,  D3DDECLTYPE_FLOAT3, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_POSITION, 0 },
+    { 0, 12, D3DDECLTYPE_FLOAT3, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_NORMAL,   0 },
+    { 0, 24, D3DDECLTYPE_FLOAT2, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 0 },
+};
+static const D3DVERTEXELEMENT9 PN_VERTEX_DECL_END = { 0xFF, 0, D3DDECLTYPE_UNUSED, 0, 0, 0 };
+
+// The vertex and index data of a mesh, as it goes in the file
+struct SDKMESH_WRITER_MESH
+{
+    UINT                uFirstVertex;   // Within MESH_DATA::Vertices
+    UINT                uNumVertices;
+    std::vector<UINT>   Subsets;        // Within MESH_DATA::Subsets
+    UINT                uNumIndices;
+    bool                b32BitIndices;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Rounds up to a multiple of 4 bytes
+//--------------------------------------------------------------------------------------
+static UINT64 AlignFileOffset( UINT64 uOffset )
+{
+    return ( uOffset + 3 ) & ~(UINT64)3;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Writes pMeshData as an sdkmesh
+//--------------------------------------------------------------------------------------
+HRESULT WriteSDKMesh( const WCHAR* pszFileName, CDXUTSDKMesh* pSourceMesh, const MESH_DATA* pMeshData )
+{
+    assert( NULL != pszFileName );
+    assert( NULL != pSourceMesh );
+    assert( NULL != pMeshData );
+
+    UINT uNumMeshes = pSourceMesh->GetNumMeshes();
+    UINT uNumSubsets = (UINT)pMeshData->Subsets.size();
+    UINT uNumFrames = pSourceMesh->GetNumFrames();
+    UINT uNumMaterials = pSourceMesh->GetNumMaterials();
+
+    // Gather the vertex range and the subsets of each mesh
+    std::vector<SDKMESH_WRITER_MESH> Meshes( uNumMeshes );
+    for( UINT uSubset = 0; uSubset < uNumSubsets; uSubset++ )
+    {
+        const MESH_DATA_SUBSET& Subset = pMeshData->Subsets[uSubset];
+        if( Subset.uMesh >= uNumMeshes || Subset.uSubset >= pSourceMesh->GetNumSubsets( Subset.uMesh ) ||
+            (UINT64)Subset.uIndexStart + Subset.uIndexCount > pMeshData->Indices.size() )
+        {
+            return E_INVALIDARG;
+        }
+        Meshes[Subset.uMesh].Subsets.push_back( uSubset );
+    }
+
+    for( UINT uMesh = 0; uMesh < uNumMeshes; uMesh++ )
+    {
+        SDKMESH_WRITER_MESH& Mesh = Meshes[uMesh];
+
+        // Every mesh needs buffers the loader can create
+        UINT uMin = UINT_MAX, uMax = 0;
+        Mesh.uNumIndices = 0;
+        for( UINT s = 0; s < Mesh.Subsets.size(); s++ )
+        {
+            const MESH_DATA_SUBSET& Subset = pMeshData->Subsets[Mesh.Subsets[s]];
+            for( UINT i = Subset.uIndexStart; i < Subset.uIndexStart + Subset.uIndexCount; i++ )
+            {
+                if( pMeshData->Indices[i] >= pMeshData->Vertices.size() )
+                {
+                    return E_INVALIDARG;
+                }
+                uMin = std::min( uMin, pMeshData->Indices[i] );
+                uMax = std::max( uMax, pMeshData->Indices[i] );
+            }
+            Mesh.uNumIndices += Subset.uIndexCount;
+        }
+        if( 0 == Mesh.uNumIndices )
+        {
+            return E_INVALIDARG;
+        }
+
+        Mesh.uFirstVertex = uMin;
+        Mesh.uNumVertices = uMax - uMin + 1;
+        Mesh.b32BitIndices = ( Mesh.uNumVertices > 0xFFFF );
+    }
+
+    // Each mesh gets the vertex range its subsets index, so the ranges of two meshes must
+    // not overlap, or one would write vertices the other indexes
+    for( UINT uMesh = 0; uMesh < uNumMeshes; uMesh++ )
+    {
+        for( UINT uOther = uMesh + 1; uOther < uNumMeshes; uOther++ )
+        {
+            if( Meshes[uMesh].uFirstVertex < Meshes[uOther].uFirstVertex + Meshes[uOther].uNumVertices &&
+                Meshes[uOther].uFirstVertex < Meshes[uMesh].uFirstVertex + Meshes[uMesh].uNumVertices )
+            {
+                return E_INVALIDARG;
+            }
+        }
+    }
+
+    // Static data, in the order the loader expects it
+    UINT64 uHeaderSize = sizeof( SDKMESH_HEADER );
+    UINT64 uVertexStreamHeadersOffset = uHeaderSize;
+    UINT64 uIndexStreamHeadersOffset = uVertexStreamHeadersOffset + uNumMeshes * sizeof( SDKMESH_VERTEX_BUFFER_HEADER );
+    UINT64 uMeshDataOffset = uIndexStreamHeadersOffset + uNumMeshes * sizeof( SDKMESH_INDEX_BUFFER_HEADER );
+    UINT64 uSubsetDataOffset = uMeshDataOffset + uNumMeshes * sizeof( SDKMESH_MESH );
+    UINT64 uFrameDataOffset = uSubsetDataOffset + uNumSubsets * sizeof( SDKMESH_SUBSET );
+    UINT64 uMaterialDataOffset = uFrameDataOffset + uNumFrames * sizeof( SDKMESH_FRAME );
+    UINT64 uSubsetListOffset = uMaterialDataOffset + uNumMaterials * sizeof( SDKMESH_MATERIAL );
+    UINT64 uBufferDataOffset = AlignFileOffset( uSubsetListOffset + uNumSubsets * sizeof( UINT ) );
+
+    // Followed by the vertex buffers, then the index buffers
+    UINT64 uFileSize = uBufferDataOffset;
+    std::vector<UINT64> VertexDataOffsets( uNumMeshes ), IndexDataOffsets( uNumMeshes );
+    for( UINT uMesh = 0; uMesh < uNumMeshes; uMesh++ )
+    {
+        VertexDataOffsets[uMesh] = uFileSize;
+        uFileSize += (UINT64)Meshes[uMesh].uNumVertices * sizeof( PN_VERTEX );
+    }
+    for( UINT uMesh = 0; uMesh < uNumMeshes; uMesh++ )
+    {
+        IndexDataOffsets[uMesh] = uFileSize;
+        uFileSize = AlignFileOffset( uFileSize + (UINT64)Meshes[uMesh].uNumIndices * ( Meshes[uMesh].b32BitIndices ? 4 : 2 ) );
+    }
+
+    std::vector<BYTE> File( (size_t)uFileSize, 0 );
+    BYTE* pFile = &File[0];
+
+    SDKMESH_HEADER* pHeader = (SDKMESH_HEADER*)pFile;
+    pHeader->Version = SDKMESH_FILE_VERSION;
+    pHeader->IsBigEndian = 0;
+    pHeader->HeaderSize = uHeaderSize;
+    pHeader->NonBufferDataSize = uBufferDataOffset - uHeaderSize;
+    pHeader->BufferDataSize = uFileSize - uBufferDataOffset;
+    pHeader->NumVertexBuffers = uNumMeshes;
+    pHeader->NumIndexBuffers = uNumMeshes;
+    pHeader->NumMeshes = uNumMeshes;
+    pHeader->NumTotalSubsets = uNumSubsets;
+    pHeader->NumFrames = uNumFrames;
+    pHeader->NumMaterials = uNumMaterials;
+    pHeader->VertexStreamHeadersOffset = uVertexStreamHeadersOffset;
+    pHeader->IndexStreamHeadersOffset = uIndexStreamHeadersOffset;
+    pHeader->MeshDataOffset = uMeshDataOffset;
+    pHeader->SubsetDataOffset = uSubsetDataOffset;
+    pHeader->FrameDataOffset = uFrameDataOffset;
+    pHeader->MaterialDataOffset = uMaterialDataOffset;
+
+    SDKMESH_VERTEX_BUFFER_HEADER* pVertexBuffers = (SDKMESH_VERTEX_BUFFER_HEADER*)( pFile + uVertexStreamHeadersOffset );
+    SDKMESH_INDEX_BUFFER_HEADER* pIndexBuffers = (SDKMESH_INDEX_BUFFER_HEADER*)( pFile + uIndexStreamHeadersOffset );
+    SDKMESH_MESH* pMeshes = (SDKMESH_MESH*)( pFile + uMeshDataOffset );
+    SDKMESH_SUBSET* pSubsets = (SDKMESH_SUBSET*)( pFile + uSubsetDataOffset );
+    SDKMESH_FRAME* pFrames = (SDKMESH_FRAME*)( pFile + uFrameDataOffset );
+    SDKMESH_MATERIAL* pMaterials = (SDKMESH_MATERIAL*)( pFile + uMaterialDataOffset );
+    UINT* pSubsetList = (UINT*)( pFile + uSubsetListOffset );
+
+    UINT uSubsetListEntry = 0;
+    for( UINT uMesh = 0; uMesh < uNumMeshes; uMesh++ )
+    {
+        const SDKMESH_WRITER_MESH& Mesh = Meshes[uMesh];
+
+        SDKMESH_VERTEX_BUFFER_HEADER& VertexBuffer = pVertexBuffers[uMesh];
+        VertexBuffer.NumVertices = Mesh.uNumVertices;
+        VertexBuffer.SizeBytes = (UINT64)Mesh.uNumVertices * sizeof( PN_VERTEX );
+        VertexBuffer.StrideBytes = sizeof( PN_VERTEX );
+        for( UINT e = 0; e < MAX_VERTEX_ELEMENTS; e++ )
+        {
+            VertexBuffer.Decl[e] = ( e < ARRAYSIZE( PN_VERTEX_DECL ) ) ? PN_VERTEX_DECL[e] : PN_VERTEX_DECL_END;
+        }
+        VertexBuffer.DataOffset = VertexDataOffsets[uMesh];
+
+        XMVECTOR vMin = XMVectorReplicate( FLT_MAX );
+        XMVECTOR vMax = XMVectorReplicate( -FLT_MAX );
+        memcpy( pFile + VertexDataOffsets[uMesh], &pMeshData->Vertices[Mesh.uFirstVertex], (size_t)VertexBuffer.SizeBytes );
+        for( UINT i = 0; i < Mesh.uNumVertices; i++ )
+        {
+            XMVECTOR vPosition = XMLoadFloat3( &pMeshData->Vertices[Mesh.uFirstVertex + i].f3Position );
+            vMin = XMVectorMin( vMin, vPosition );
+            vMax = XMVectorMax( vMax, vPosition );
+        }
+
+        SDKMESH_INDEX_BUFFER_HEADER& IndexBuffer = pIndexBuffers[uMesh];
+        IndexBuffer.NumIndices = Mesh.uNumIndices;
+        IndexBuffer.SizeBytes = (UINT64)Mesh.uNumIndices * ( Mesh.b32BitIndices ? 4 : 2 );
+        IndexBuffer.IndexType = Mesh.b32BitIndices ? IT_32BIT : IT_16BIT;
+        IndexBuffer.DataOffset = IndexDataOffsets[uMesh];
+
+        SDKMESH_MESH& OutMesh = pMeshes[uMesh];
+        memcpy( OutMesh.Name, pSourceMesh->GetMesh( uMesh )->Name, sizeof( OutMesh.Name ) );
+        OutMesh.NumVertexBuffers = 1;
+        OutMesh.VertexBuffers[0] = uMesh;
+        OutMesh.IndexBuffer = uMesh;
+        OutMesh.NumSubsets = (UINT)Mesh.Subsets.size();
+        OutMesh.NumFrameInfluences = 0;
+        XMStoreFloat3( &OutMesh.BoundingBoxCenter, XMVectorScale( XMVectorAdd( vMin, vMax ), 0.5f ) );
+        XMStoreFloat3( &OutMesh.BoundingBoxExtents, XMVectorScale( XMVectorSubtract( vMax, vMin ), 0.5f ) );
+        OutMesh.SubsetOffset = uSubsetListOffset + uSubsetListEntry * sizeof( UINT );
+        OutMesh.FrameInfluenceOffset = 0;
+
+        // Indices are relative to the mesh's vertex buffer, subsets follow each other
+        UINT uIndex = 0;
+        BYTE* pIndices = pFile + IndexDataOffsets[uMesh];
+        for( UINT s = 0; s < Mesh.Subsets.size(); s++ )
+        {
+            const MESH_DATA_SUBSET& Subset = pMeshData->Subsets[Mesh.Subsets[s]];
+
+            SDKMESH_SUBSET& OutSubset = pSubsets[Mesh.Subsets[s]];
+            memcpy( OutSubset.Name, pSourceMesh->GetSubset( uMesh, Subset.uSubset )->Name, sizeof( OutSubset.Name ) );
+            OutSubset.MaterialID = Subset.uMaterialID;
+            OutSubset.PrimitiveType = PT_TRIANGLE_LIST;
+            OutSubset.IndexStart = uIndex;
+            OutSubset.IndexCount = Subset.uIndexCount;
+            OutSubset.VertexStart = 0;
+            OutSubset.VertexCount = Mesh.uNumVertices;
+
+            for( UINT i = Subset.uIndexStart; i < Subset.uIndexStart + Subset.uIndexCount; i++, uIndex++ )
+            {
+                UINT uVertex = pMeshData->Indices[i] - Mesh.uFirstVertex;
+                if( Mesh.b32BitIndices )
+                {
+                    ( (UINT*)pIndices )[uIndex] = uVertex;
+                }
+                else
+                {
+                    ( (WORD*)pIndices )[uIndex] = (WORD)uVertex;
+                }
+            }
+
+            pSubsetList[uSubsetListEntry++] = Mesh.Subsets[s];
+        }
+    }
+
+    for( UINT uFrame = 0; uFrame < uNumFrames; uFrame++ )
+    {
+        pFrames[uFrame] = *pSourceMesh->GetFrame( uFrame );
+    }
+
+    // Runtime resources are never written
+    for( UINT uMaterial = 0; uMaterial < uNumMaterials; uMaterial++ )
+    {
+        SDKMESH_MATERIAL& Material = pMaterials[uMaterial];
+        Material = *pSourceMesh->GetMaterial( uMaterial );
+        Material.Force64_1 = 0;
+        Material.Force64_2 = 0;
+        Material.Force64_3 = 0;
+        Material.Force64_4 = 0;
+        Material.Force64_5 = 0;
+        Material.Force64_6 = 0;
+    }
+
+    FILE* pOutput = NULL;
+    if( 0 != _wfopen_s( &pOutput, pszFileName, L"wb" ) || NULL == pOutput )
+    {
+        return E_ACCESSDENIED;
+    }
+
+    size_t uWritten = fwrite( pFile, 1, File.size(), pOutput );
+    fclose( pOutput );
+
+    return ( uWritten == File.size() ) ? S_OK : E_FAIL;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,46 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: SDKMeshWriter.h
+//
+// Writes mesh data generated on the CPU back to an sdkmesh that DXUT can load.
+//--------------------------------------------------------------------------------------
+#ifndef SDKMESH_WRITER_H
+#define SDKMESH_WRITER_H
+
+#include "MeshData.h"
+
+class CDXUTSDKMesh;
+
+
+//--------------------------------------------------------------------------------------
+// Writes pMeshData as an sdkmesh with one POSITION, NORMAL, TEXCOORD vertex buffer and
+// one index buffer per mesh. The mesh names, frames and materials are copied from
+// pSourceMesh, the sdkmesh the data was extracted from, and every subset keeps the mesh,
+// name and material of the source subset it refers to. The vertices of each mesh must be
+// contiguous and not indexed by another mesh, as ExtractMeshData leaves them, otherwise
+// E_INVALIDARG is returned. 16 bit indices are used where they fit.
+//--------------------------------------------------------------------------------------
+HRESULT WriteSDKMesh( const WCHAR* pszFileName, CDXUTSDKMesh* pSourceMesh, const MESH_DATA* pMeshData );
+
+#endif
@@ -0,0 +1,470 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ShaderPermutations.cpp
+//
+// Prioritized compilation of the hull and domain shader permutations on a worker thread.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "..\\..\\AMD_SDK\\inc\\AMD_SDK.h"
+#include "ShaderPermutations.h"
+#include "TessFactors.h"
+
+using namespace DirectX;
+
+// Define of each permutation flag, in the order the shader cache passes them
+struct SHADER_PERMUTATION_DEFINE
+{
+    DWORD       dwFlag;
+    const char* pszName;
+};
+
+static const SHADER_PERMUTATION_DEFINE g_ShaderPermutationDefines[] =
+{
+    { SS_ADAPT,     "SS_ADAPT" },
+    { DIST_ADAPT,   "DIST_ADAPT" },
+    { RES_ADAPT,    "RES_ADAPT" },
+    { ORIENT_ADAPT, "ORIENT_ADAPT" },
+    { FOVEA_ADAPT,  "FOVEA_ADAPT" },
+    { MOTION_ADAPT, "MOTION_ADAPT" },
+    { BF_CULL,      "BF_CULL" },
+    { FRUST_CULL,   "FRUST_CULL" },
+    { PHONG,        "PHONG" },
+    { PNTRI,        "PNTRI" },
+    { PACKED_CP,    "PACKED_CP" },
+    { MULTI_VIEW,   "MULTI_VIEW" },
+    { DEPTH_ONLY,   "DEPTH_ONLY" },
+};
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CShaderPermutations::CShaderPermutations() :
+    m_pfnCompile( NULL ),
+    m_uSequence( 0 ),
+    m_hThread( NULL ),
+    m_hRequestEvent( NULL ),
+    m_lQuit( 0 )
+{
+    m_szSourceFile[0] = 0;
+    InitializeCriticalSection( &m_Lock );
+    ZeroMemory( &m_Stats, sizeof( m_Stats ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CShaderPermutations::~CShaderPermutations()
+{
+    Destroy();
+    DeleteCriticalSection( &m_Lock );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Starts the worker, which serves the requests made so far at once
+//--------------------------------------------------------------------------------------
+HRESULT CShaderPermutations::Create( const WCHAR* pszSourceFile, LPSHADERPERMUTATIONCOMPILE pfnCompile )
+{
+    assert( NULL != pszSourceFile );
+
+    if( NULL != m_hThread )
+    {
+        return E_FAIL;
+    }
+
+    wcscpy_s( m_szSourceFile, pszSourceFile );
+    m_pfnCompile = ( NULL != pfnCompile ) ? pfnCompile : CompileFromFile;
+
+    InterlockedExchange( &m_lQuit, 0 );
+    m_hRequestEvent = CreateEvent( NULL, FALSE, TRUE, NULL );
+    if( NULL == m_hRequestEvent )
+    {
+        Destroy();
+        return E_FAIL;
+    }
+
+    m_hThread = CreateThread( NULL, 0, WorkerThread, this, 0, NULL );
+    if( NULL == m_hThread )
+    {
+        Destroy();
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Stops the worker after the permutation it compiles, and releases the byte code
+//--------------------------------------------------------------------------------------
+void CShaderPermutations::Destroy()
+{
+    if( NULL != m_hThread )
+    {
+        InterlockedExchange( &m_lQuit, 1 );
+        SetEvent( m_hRequestEvent );
+        WaitForSingleObject( m_hThread, INFINITE );
+        CloseHandle( m_hThread );
+        m_hThread = NULL;
+    }
+
+    if( NULL != m_hRequestEvent )
+    {
+        CloseHandle( m_hRequestEvent );
+        m_hRequestEvent = NULL;
+    }
+
+    for( std::map<DWORD, PERMUTATION>::iterator it = m_Permutations.begin(); it != m_Permutations.end(); it++ )
+    {
+        SAFE_RELEASE( it->second.pHullCode );
+        SAFE_RELEASE( it->second.pDomainCode );
+    }
+    m_Permutations.clear();
+    m_Pending.clear();
+    m_uSequence = 0;
+    ZeroMemory( &m_Stats, sizeof( m_Stats ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Queues a permutation, or moves it ahead in the queue
+//--------------------------------------------------------------------------------------
+void CShaderPermutations::Request( DWORD dwFlags, SHADER_PERMUTATION_PRIORITY ePriority )
+{
+    bool bQueued = false;
+
+    EnterCriticalSection( &m_Lock );
+
+    std::map<DWORD, PERMUTATION>::iterator it = m_Permutations.find( dwFlags );
+    if( m_Permutations.end() == it )
+    {
+        PERMUTATION Permutation;
+        Permutation.eState = STATE_QUEUED;
+        Permutation.uPriority = (UINT)ePriority;
+        Permutation.uSequence = ++m_uSequence;
+        Permutation.pHullCode = NULL;
+        Permutation.pDomainCode = NULL;
+        m_Permutations[dwFlags] = Permutation;
+        bQueued = true;
+    }
+    else if( STATE_QUEUED == it->second.eState )
+    {
+        it->second.uPriority = std::min( it->second.uPriority, (UINT)ePriority );
+        it->second.uSequence = ++m_uSequence;
+    }
+
+    LeaveCriticalSection( &m_Lock );
+
+    if( bQueued && NULL != m_hRequestEvent )
+    {
+        SetEvent( m_hRequestEvent );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Creates the shaders of the permutations compiled since the last call
+//--------------------------------------------------------------------------------------
+HRESULT CShaderPermutations::CreateShaders( ID3D11Device* pDevice, HULL_SHADER_MAP* pHullShaders, DOMAIN_SHADER_MAP* pDomainShaders )
+{
+    assert( NULL != pDevice );
+    assert( NULL != pHullShaders );
+    assert( NULL != pDomainShaders );
+
+    HRESULT hr = S_OK;
+
+    // The byte code of a compiled permutation is not touched by the worker again, so it can be
+    // used after the lock is left
+    std::vector<DWORD> Pending;
+    std::vector<PERMUTATION> Permutations;
+    EnterCriticalSection( &m_Lock );
+    Pending.swap( m_Pending );
+    for( UINT i = 0; i < (UINT)Pending.size(); i++ )
+    {
+        Permutations.push_back( m_Permutations[Pending[i]] );
+    }
+    LeaveCriticalSection( &m_Lock );
+
+    // A permutation not in the maps yet is kept for a later call. One the device rejects is
+    // failed, like one that didn't compile, and the others are still created.
+    std::vector<DWORD> Unregistered, Failed;
+    for( UINT i = 0; i < (UINT)Pending.size(); i++ )
+    {
+        HULL_SHADER_MAP::iterator itHull = pHullShaders->find( Pending[i] );
+        DOMAIN_SHADER_MAP::iterator itDomain = pDomainShaders->find( Pending[i] );
+        if( pHullShaders->end() == itHull || pDomainShaders->end() == itDomain )
+        {
+            Unregistered.push_back( Pending[i] );
+            continue;
+        }
+        if( NULL != itHull->second || NULL != itDomain->second )
+        {
+            continue;
+        }
+
+        const PERMUTATION& Permutation = Permutations[i];
+        ID3D11HullShader* pHullShader = NULL;
+        ID3D11DomainShader* pDomainShader = NULL;
+        HRESULT hrCreate = pDevice->CreateHullShader( Permutation.pHullCode->GetBufferPointer(), Permutation.pHullCode->GetBufferSize(), NULL, &pHullShader );
+        if( SUCCEEDED( hrCreate ) )
+        {
+            hrCreate = pDevice->CreateDomainShader( Permutation.pDomainCode->GetBufferPointer(), Permutation.pDomainCode->GetBufferSize(), NULL, &pDomainShader );
+        }
+
+        // Both or neither, the pair is only set when the hull shader is there
+        if( FAILED( hrCreate ) )
+        {
+            SAFE_RELEASE( pHullShader );
+            SAFE_RELEASE( pDomainShader );
+            Failed.push_back( Pending[i] );
+            hr = hrCreate;
+            continue;
+        }
+
+        itHull->second = pHullShader;
+        itDomain->second = pDomainShader;
+    }
+
+    if( !Unregistered.empty() || !Failed.empty() )
+    {
+        EnterCriticalSection( &m_Lock );
+
+        m_Pending.insert( m_Pending.end(), Unregistered.begin(), Unregistered.end() );
+        for( UINT i = 0; i < (UINT)Failed.size(); i++ )
+        {
+            PERMUTATION& Permutation = m_Permutations[Failed[i]];
+            SAFE_RELEASE( Permutation.pHullCode );
+            SAFE_RELEASE( Permutation.pDomainCode );
+            Permutation.eState = STATE_FAILED;
+            m_Stats.uNumCompiled--;
+            m_Stats.uNumFailed++;
+        }
+
+        LeaveCriticalSection( &m_Lock );
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Queues all the compiled permutations for CreateShaders
+//--------------------------------------------------------------------------------------
+void CShaderPermutations::OnDestroyDevice()
+{
+    EnterCriticalSection( &m_Lock );
+
+    m_Pending.clear();
+    for( std::map<DWORD, PERMUTATION>::iterator it = m_Permutations.begin(); it != m_Permutations.end(); it++ )
+    {
+        if( STATE_COMPILED == it->second.eState )
+        {
+            m_Pending.push_back( it->first );
+        }
+    }
+
+    LeaveCriticalSection( &m_Lock );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns true if the permutation failed to compile, or its shaders to be created
+//--------------------------------------------------------------------------------------
+bool CShaderPermutations::IsFailed( DWORD dwFlags )
+{
+    EnterCriticalSection( &m_Lock );
+
+    std::map<DWORD, PERMUTATION>::const_iterator it = m_Permutations.find( dwFlags );
+    bool bFailed = ( m_Permutations.end() != it && STATE_FAILED == it->second.eState );
+
+    LeaveCriticalSection( &m_Lock );
+
+    return bFailed;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the counters, with the requests still queued
+//--------------------------------------------------------------------------------------
+void CShaderPermutations::GetStats( SHADER_PERMUTATION_STATS* pStats )
+{
+    assert( NULL != pStats );
+
+    EnterCriticalSection( &m_Lock );
+
+    *pStats = m_Stats;
+    pStats->uNumQueued = 0;
+    for( std::map<DWORD, PERMUTATION>::const_iterator it = m_Permutations.begin(); it != m_Permutations.end(); it++ )
+    {
+        if( STATE_QUEUED == it->second.eState || STATE_COMPILING == it->second.eState )
+        {
+            pStats->uNumQueued++;
+        }
+    }
+
+    LeaveCriticalSection( &m_Lock );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Serves the queue until it is empty, then waits for a request
+//--------------------------------------------------------------------------------------
+DWORD WINAPI CShaderPermutations::WorkerThread( LPVOID pParam )
+{
+    CShaderPermutations* pPermutations = (CShaderPermutations*)pParam;
+
+    for( ;; )
+    {
+        WaitForSingleObject( pPermutations->m_hRequestEvent, INFINITE );
+        if( pPermutations->IsQuitting() )
+        {
+            break;
+        }
+
+        DWORD dwFlags = 0;
+        while( !pPermutations->IsQuitting() && pPermutations->PopRequest( &dwFlags ) )
+        {
+            LARGE_INTEGER Start, End, Frequency;
+            QueryPerformanceCounter( &Start );
+
+            ID3DBlob* pHullCode = NULL;
+            ID3DBlob* pDomainCode = NULL;
+            HRESULT hr = pPermutations->m_pfnCompile( pPermutations->m_szSourceFile, dwFlags, &pHullCode, &pDomainCode );
+
+            QueryPerformanceCounter( &End );
+            QueryPerformanceFrequency( &Frequency );
+
+            EnterCriticalSection( &pPermutations->m_Lock );
+
+            PERMUTATION& Permutation = pPermutations->m_Permutations[dwFlags];
+            if( SUCCEEDED( hr ) )
+            {
+                Permutation.eState = STATE_COMPILED;
+                Permutation.pHullCode = pHullCode;
+                Permutation.pDomainCode = pDomainCode;
+                pPermutations->m_Pending.push_back( dwFlags );
+                pPermutations->m_Stats.uNumCompiled++;
+            }
+            else
+            {
+                SAFE_RELEASE( pHullCode );
+                SAFE_RELEASE( pDomainCode );
+                Permutation.eState = STATE_FAILED;
+                pPermutations->m_Stats.uNumFailed++;
+            }
+            pPermutations->m_Stats.fCompileMs += (double)( End.QuadPart - Start.QuadPart ) * 1000.0 / (double)Frequency.QuadPart;
+
+            LeaveCriticalSection( &pPermutations->m_Lock );
+        }
+    }
+
+    return 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Takes the queued permutation of the first priority, the newest request of it
+//--------------------------------------------------------------------------------------
+bool CShaderPermutations::PopRequest( DWORD* pdwFlags )
+{
+    assert( NULL != pdwFlags );
+
+    EnterCriticalSection( &m_Lock );
+
+    PERMUTATION* pBest = NULL;
+    for( std::map<DWORD, PERMUTATION>::iterator it = m_Permutations.begin(); it != m_Permutations.end(); it++ )
+    {
+        PERMUTATION* pPermutation = &it->second;
+        if( STATE_QUEUED != pPermutation->eState )
+        {
+            continue;
+        }
+
+        if( NULL == pBest || pPermutation->uPriority < pBest->uPriority ||
+            ( pPermutation->uPriority == pBest->uPriority && pPermutation->uSequence > pBest->uSequence ) )
+        {
+            pBest = pPermutation;
+            *pdwFlags = it->first;
+        }
+    }
+
+    if( NULL != pBest )
+    {
+        pBest->eState = STATE_COMPILING;
+    }
+
+    LeaveCriticalSection( &m_Lock );
+
+    return NULL != pBest;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Compiles the hull and domain shaders of a permutation
+//--------------------------------------------------------------------------------------
+HRESULT CShaderPermutations::CompileFromFile( const WCHAR* pszSourceFile, DWORD dwFlags, ID3DBlob** ppHullCode, ID3DBlob** ppDomainCode )
+{
+    assert( NULL != pszSourceFile );
+    assert( NULL != ppHullCode );
+    assert( NULL != ppDomainCode );
+
+    D3D_SHADER_MACRO Defines[ARRAYSIZE( g_ShaderPermutationDefines ) + 1];
+    UINT uNumDefines = 0;
+    for( UINT i = 0; i < ARRAYSIZE( g_ShaderPermutationDefines ); i++ )
+    {
+        if( dwFlags & g_ShaderPermutationDefines[i].dwFlag )
+        {
+            Defines[uNumDefines].Name = g_ShaderPermutationDefines[i].pszName;
+            Defines[uNumDefines].Definition = "1";
+            uNumDefines++;
+        }
+    }
+    Defines[uNumDefines].Name = NULL;
+    Defines[uNumDefines].Definition = NULL;
+
+    // The errors are written to the debug output, without a message box on the worker. The
+    // helper takes the file name as a WCHAR*.
+    WCHAR szSourceFile[MAX_PATH];
+    wcscpy_s( szSourceFile, pszSourceFile );
+    HRESULT hr = AMD::CompileShaderFromFile( szSourceFile, "HS_PNTriangles", "hs_5_0", ppHullCode, Defines );
+    if( FAILED( hr ) )
+    {
+        return hr;
+    }
+
+    hr = AMD::CompileShaderFromFile( szSourceFile, "DS_PNTriangles", "ds_5_0", ppDomainCode, Defines );
+    if( FAILED( hr ) )
+    {
+        SAFE_RELEASE( *ppHullCode );
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ShaderPermutations.h
+//
+// Compiles the hull and domain shader permutations on demand on a worker thread, rather
+// than all of them at startup. Requests are served by priority: the permutation selected
+// in the UI first, then the permutations a frame falls back from, then the prefetched
+// neighbours of the selection. Within a priority the newest request is served first. The
+// compiled byte code is kept, so the shaders are created again after a device change
+// without compiling. The shaders are created on the render thread.
+//--------------------------------------------------------------------------------------
+#ifndef SHADER_PERMUTATIONS_H
+#define SHADER_PERMUTATIONS_H
+
+#include <map>
+#include <vector>
+
+// Priorities of the requests, lower is served first
+enum SHADER_PERMUTATION_PRIORITY
+{
+    SHADER_PERMUTATION_PRIORITY_SELECTED = 0,   // The permutation selected in the UI
+    SHADER_PERMUTATION_PRIORITY_DRAWN,          // A frame fell back for the lack of it
+    SHADER_PERMUTATION_PRIORITY_PREFETCH,       // One UI change away from the selection
+};
+
+// Counters since Create
+struct SHADER_PERMUTATION_STATS
+{
+    UINT    uNumCompiled;
+    UINT    uNumQueued;
+    UINT    uNumFailed;     // To compile or to create
+    double  fCompileMs;     // Total on the worker
+};
+
+typedef std::map<DWORD, ID3D11HullShader*>      HULL_SHADER_MAP;
+typedef std::map<DWORD, ID3D11DomainShader*>    DOMAIN_SHADER_MAP;
+
+// Compiles the hull and domain shaders of a permutation on the worker, both or neither
+typedef HRESULT (*LPSHADERPERMUTATIONCOMPILE)( const WCHAR* pszSourceFile, DWORD dwFlags, ID3DBlob** ppHullCode, ID3DBlob** ppDomainCode );
+
+
+//--------------------------------------------------------------------------------------
+// Prioritized compilation of the HS_PNTriangles and DS_PNTriangles permutations, keyed by
+// their TESSELLATION_SETTING_TYPE flags
+//--------------------------------------------------------------------------------------
+class CShaderPermutations
+{
+public:
+
+    CShaderPermutations();
+    ~CShaderPermutations();
+
+    // Starts the worker, compiling from the shader source file. Requests made before are kept.
+    // The tools pass their own compile function, the default compiles HS_PNTriangles and
+    // DS_PNTriangles from the source file.
+    HRESULT Create( const WCHAR* pszSourceFile, LPSHADERPERMUTATIONCOMPILE pfnCompile = NULL );
+    void Destroy();
+
+    // Queues the permutation unless it is compiled, failed or being compiled. A queued
+    // permutation requested again is moved ahead of its priority, and raised to ePriority.
+    void Request( DWORD dwFlags, SHADER_PERMUTATION_PRIORITY ePriority );
+
+    // Creates the shaders compiled since the last call, or since OnDestroyDevice, into the
+    // maps. Only entries present and NULL in the maps are written, those not present are
+    // kept for the next call. A permutation whose shaders can't be created is failed, and
+    // the error of the last one is returned.
+    HRESULT CreateShaders( ID3D11Device* pDevice, HULL_SHADER_MAP* pHullShaders, DOMAIN_SHADER_MAP* pDomainShaders );
+
+    // The shaders were released, all the compiled permutations are created again
+    void OnDestroyDevice();
+
+    // True if the permutation failed to compile or create, it is not requested again
+    bool IsFailed( DWORD dwFlags );
+
+    void GetStats( SHADER_PERMUTATION_STATS* pStats );
+
+private:
+
+    enum STATE
+    {
+        STATE_QUEUED,
+        STATE_COMPILING,
+        STATE_COMPILED,
+        STATE_FAILED,
+    };
+
+    struct PERMUTATION
+    {
+        STATE       eState;
+        UINT        uPriority;
+        UINT        uSequence;      // Of the last request
+        ID3DBlob*   pHullCode;
+        ID3DBlob*   pDomainCode;
+    };
+
+    static DWORD WINAPI WorkerThread( LPVOID pParam );
+    bool PopRequest( DWORD* pdwFlags );
+    bool IsQuitting() { return 0 != InterlockedCompareExchange( &m_lQuit, 0, 0 ); }
+    static HRESULT CompileFromFile( const WCHAR* pszSourceFile, DWORD dwFlags, ID3DBlob** ppHullCode, ID3DBlob** ppDomainCode );
+
+    WCHAR                       m_szSourceFile[MAX_PATH];
+    LPSHADERPERMUTATIONCOMPILE  m_pfnCompile;
+
+    // Everything below is shared with the worker, under the lock
+    CRITICAL_SECTION            m_Lock;
+    std::map<DWORD, PERMUTATION> m_Permutations;
+    std::vector<DWORD>          m_Pending;      // Compiled, waiting for CreateShaders
+    UINT                        m_uSequence;
+    SHADER_PERMUTATION_STATS    m_Stats;
+
+    // Worker, woken by each request
+    HANDLE                      m_hThread;
+    HANDLE                      m_hRequestEvent;
+    volatile LONG               m_lQuit;        // Set by Destroy, read by the worker
+};
+
+#endif
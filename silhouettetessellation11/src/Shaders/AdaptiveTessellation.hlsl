@@ -162,6 +162,74 @@ float GetScreenSpaceAdaptiveScaleFactor (
 }
 
 
+//--------------------------------------------------------------------------------------
+// Returns the foveated adaptive tessellation scale factor (fPeripheryScale -> 1.0f), from
+// the screen distance of the edge midpoint to the focus point. Edges crossing the eye
+// plane keep a scale of 1.
+//--------------------------------------------------------------------------------------
+float GetFoveatedAdaptiveScaleFactor (
+                                    float3 f3EdgePosition0,     // World space position of the first patch edge control point
+                                    float3 f3EdgePosition1,     // World space position of the second patch edge control point
+                                    float4x4 f4x4ViewProjection,// View * Projection matrix
+                                    float2 f2ScreenSize,        // Screen resolution
+                                    float2 f2Focus,             // Focus point in pixels
+                                    float fInnerRadius,         // Full density within this many pixels of the focus
+                                    float fOuterRadius,         // fPeripheryScale beyond this many pixels
+                                    float fPeripheryScale       // Scale at the periphery
+                                    )
+{
+    float4 f4ProjectedPosition = mul( float4( ( f3EdgePosition0 + f3EdgePosition1 ) * 0.5f, 1.0f ), f4x4ViewProjection );
+    if( f4ProjectedPosition.w <= 0.0f )
+    {
+        return 1.0f;
+    }
+
+    float2 f2ScreenPosition = f4ProjectedPosition.xy / f4ProjectedPosition.ww;
+    f2ScreenPosition = ( f2ScreenPosition * float2( 1.0f, -1.0f ) + float2( 1.0f, 1.0f ) ) * float2( 0.5f, 0.5f ) * f2ScreenSize;
+
+    float fFalloff = smoothstep( fInnerRadius, max( fOuterRadius, fInnerRadius + 1.0f ), distance( f2ScreenPosition, f2Focus ) );
+
+    float fScale = lerp( 1.0f, fPeripheryScale, fFalloff );
+
+    return fScale;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the motion adaptive scale factor (0.0f -> 1.0f), based on the screen distance
+// the edge midpoint moved from the previous view projection. Edges crossing the eye
+// plane in either keep a scale of 1.
+//--------------------------------------------------------------------------------------
+float GetMotionAdaptiveScaleFactor (
+                                    float3 f3EdgePosition0,     // World space position of the first patch edge control point
+                                    float3 f3EdgePosition1,     // World space position of the second patch edge control point
+                                    float4x4 f4x4ViewProjection,// View * Projection matrix
+                                    float4x4 f4x4PrevViewProjection, // Previous View * Projection matrix
+                                    float2 f2ScreenSize,        // Screen resolution
+                                    float fThreshold,           // Full density below this many pixels of motion
+                                    float fFullVelocity,        // fMinScale beyond this many pixels
+                                    float fMinScale             // Scale of the fastest edges
+                                    )
+{
+    float4 f4EdgeMidPoint = float4( ( f3EdgePosition0 + f3EdgePosition1 ) * 0.5f, 1.0f );
+    float4 f4ProjectedPosition = mul( f4EdgeMidPoint, f4x4ViewProjection );
+    float4 f4PrevProjectedPosition = mul( f4EdgeMidPoint, f4x4PrevViewProjection );
+    if( f4ProjectedPosition.w <= 0.0f || f4PrevProjectedPosition.w <= 0.0f )
+    {
+        return 1.0f;
+    }
+
+    float2 f2Motion = f4ProjectedPosition.xy / f4ProjectedPosition.ww - f4PrevProjectedPosition.xy / f4PrevProjectedPosition.ww;
+    f2Motion = f2Motion * float2( 0.5f, 0.5f ) * f2ScreenSize;
+
+    float fFalloff = smoothstep( fThreshold, max( fFullVelocity, fThreshold + 1.0f ), length( f2Motion ) );
+
+    float fScale = lerp( 1.0f, fMinScale, fFalloff );
+
+    return fScale;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Returns back face culling test result (true / false)
 //--------------------------------------------------------------------------------------
@@ -0,0 +1,120 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: PatchPacking.hlsl
+//
+// These utility functions pack the PN-Triangles control points output by the hull shader
+// patch constant function into a compact form, and unpack them again in the domain shader.
+// Each geometry control point is stored as a half precision offset from a patch corner, and
+// the normal control points are octahedral encoded into the spare 16 bits of each offset.
+// The CPU reference lives in PatchPacking.cpp and must be kept in sync with this file.
+//
+// Contributed by the AMD Developer Relations Team
+//--------------------------------------------------------------------------------------
+
+
+//--------------------------------------------------------------------------------------
+// Returns the octahedral encoding (-1.0f -> 1.0f) of a normalized vector
+//--------------------------------------------------------------------------------------
+float2 OctEncode(
+                float3 f3Normal     // Normalized vector to encode
+                )
+{
+    f3Normal /= ( abs( f3Normal.x ) + abs( f3Normal.y ) + abs( f3Normal.z ) );
+
+    float2 f2Encoded = f3Normal.xy;
+
+    if( f3Normal.z < 0.0f )
+    {
+        // Fold the lower hemisphere over the diagonals
+        f2Encoded = ( 1.0f - abs( f3Normal.yx ) ) * ( ( f3Normal.xy >= 0.0f ) ? 1.0f : -1.0f );
+    }
+
+    return f2Encoded;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the normalized vector from an octahedral encoding
+//--------------------------------------------------------------------------------------
+float3 OctDecode(
+                float2 f2Encoded    // Octahedral encoded vector (-1.0f -> 1.0f)
+                )
+{
+    float3 f3Normal = float3( f2Encoded.xy, 1.0f - abs( f2Encoded.x ) - abs( f2Encoded.y ) );
+
+    if( f3Normal.z < 0.0f )
+    {
+        // Unfold the lower hemisphere
+        f3Normal.xy = ( 1.0f - abs( f3Normal.yx ) ) * ( ( f3Normal.xy >= 0.0f ) ? 1.0f : -1.0f );
+    }
+
+    return normalize( f3Normal );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Packs an offset into 3 half precision values, and a signed normalized value into the
+// remaining 16 bits
+//--------------------------------------------------------------------------------------
+uint2 PackHalfOffset(
+                    float3 f3Offset,    // Offset of the control point from its reference corner
+                    float fAux          // Signed normalized value (-1.0f -> 1.0f) stored alongside
+                    )
+{
+    uint uAux = (uint)( (int)round( clamp( fAux, -1.0f, 1.0f ) * 32767.0f ) ) & 0xffff;
+
+    uint2 u2Packed;
+    u2Packed.x = f32tof16( f3Offset.x ) | ( f32tof16( f3Offset.y ) << 16 );
+    u2Packed.y = f32tof16( f3Offset.z ) | ( uAux << 16 );
+
+    return u2Packed;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the offset stored by PackHalfOffset
+//--------------------------------------------------------------------------------------
+float3 UnpackHalfOffset(
+                        uint2 u2Packed  // Packed control point
+                        )
+{
+    return float3( f16tof32( u2Packed.x ), f16tof32( u2Packed.x >> 16 ), f16tof32( u2Packed.y ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the signed normalized value (-1.0f -> 1.0f) stored by PackHalfOffset
+//--------------------------------------------------------------------------------------
+float UnpackHalfOffsetAux(
+                        uint2 u2Packed  // Packed control point
+                        )
+{
+    // Arithmetic shift to sign extend the top 16 bits
+    return max( (float)( (int)u2Packed.y >> 16 ) / 32767.0f, -1.0f );
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
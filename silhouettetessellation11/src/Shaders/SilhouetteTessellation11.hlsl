@@ -29,6 +29,10 @@
 //--------------------------------------------------------------------------------------
 
 #include "AdaptiveTessellation.hlsl"
+#include "PatchPacking.hlsl"
+
+// Views of a MULTI_VIEW pass (TESS_MAX_VIEWS in MultiViewFactors.h)
+#define MULTI_VIEW_MAX_VIEWS 8
 
 //--------------------------------------------------------------------------------------
 // Constant buffer
@@ -54,6 +58,19 @@ cbuffer cbPNTriangles : register( b0 )
 	float       g_fGUIScreenResolutionScale;
 	float       g_fGUIViewFrustrumEpsilon;
     float4      g_f4ViewFrustumPlanes[4];   // View frustum planes ( x=left, y=right, z=top, w=bottom )
+    float4      g_f4Fovea;                  // Foveated tessellation ( xy=focus, z=inner radius, w=outer radius, in pixels )
+    float       g_fGUIFoveaPeripheryScale;
+    float2      g_f2ResolutionReference;    // Screen size the resolution adaptive scale reaches 1 at ( times g_fGUIScreenResolutionScale )
+    float4      g_f4Upscale;                // Dynamic resolution upscale ( xy=back buffer size, zw=scene size )
+    float4x4    g_f4x4PrevViewProjection;   // View * Projection matrix the camera motion is measured from
+    float4      g_f4Motion;                 // Motion adaptive tessellation ( x=threshold, y=full velocity, in pixels, z=min scale )
+    float4x4    g_f4x4MultiViewProjection[MULTI_VIEW_MAX_VIEWS];    // View * Projection matrix of each view of a MULTI_VIEW pass
+    float4      g_f4MultiViewEye[MULTI_VIEW_MAX_VIEWS];
+    float4      g_f4MultiViewVector[MULTI_VIEW_MAX_VIEWS];
+    float4      g_f4MultiViewFrustumPlanes[MULTI_VIEW_MAX_VIEWS * 4];   // 4 per view, as g_f4ViewFrustumPlanes
+    uint        g_uNumViews;
+    uint        g_uFirstInstance;           // Of the bin drawn, in g_bufInstanceWorld (INSTANCED)
+    float       g_fSilhouetteInflation;     // Distance the coarse mesh is pushed out along its normals (SILHOUETTE_CLIP)
 }
 
 // Some global lighting constants
@@ -61,10 +78,6 @@ static float4 g_f4MaterialDiffuseColor  = float4( 1.0f, 1.0f, 1.0f, 1.0f );
 static float4 g_f4LightDiffuse          = float4( 1.0f, 1.0f, 1.0f, 1.0f );
 static float4 g_f4MaterialAmbientColor  = float4( 0.2f, 0.2f, 0.2f, 1.0f );
 
-// Some global epsilons for adaptive tessellation
-static float g_fMaxScreenWidth = 2560.0f;
-static float g_fMaxScreenHeight = 1600.0f;
-
 
 //--------------------------------------------------------------------------------------
 // Buffers, Textures and Samplers
@@ -72,6 +85,14 @@ static float g_fMaxScreenHeight = 1600.0f;
 
 // Textures
 Texture2D g_txDiffuse : register( t0 );
+Texture2D g_txScene : register( t1 );  // Scene rendered at the dynamic resolution
+
+#if ( INSTANCED == 1 )
+
+// World matrices of the visible instances bin after bin, 4 rows each (see InstanceSet.h)
+Buffer<float4> g_bufInstanceWorld : register( t2 );
+
+#endif
 
 // Samplers
 SamplerState g_SamplePoint  : register( s0 );
@@ -87,6 +108,12 @@ struct VS_RenderSceneInput
     float3 f3Position   : POSITION;  
     float3 f3Normal     : NORMAL;     
     float2 f2TexCoord   : TEXCOORD;
+
+    #if ( INSTANCED == 1 )
+
+    uint   uInstanceID  : SV_InstanceID;
+
+    #endif
 };
 
 struct HS_Input
@@ -101,8 +128,30 @@ struct HS_ConstantOutput
     // Tess factor for the FF HW block
     float fTessFactor[3]    : SV_TessFactor;
     float fInsideTessFactor : SV_InsideTessFactor;
+
+	#if ( MULTI_VIEW == 1 )
+
+    // Bit v is set if the patch is visible in view v
+    uint uViewMask           : VIEW_MASK;
+
+	#endif
     
 	#if ( PNTRI == 1 )
+
+	#if ( PACKED_CP == 1 )
+
+	// Geometry cubic generated control points, as half precision offsets from the nearest
+	// patch corner (the center from the corner average). The .y component of each carries
+	// one octahedral component of the normal quadratic generated control points in its top 16 bits
+    uint2 u2B210     : POSITION3;   // N110.x
+    uint2 u2B120     : POSITION4;   // N110.y
+    uint2 u2B021     : POSITION5;   // N011.x
+    uint2 u2B012     : POSITION6;   // N011.y
+    uint2 u2B102     : POSITION7;   // N101.x
+    uint2 u2B201     : POSITION8;   // N101.y
+    uint2 u2B111     : CENTER;
+
+	#else
     
 	// Geometry cubic generated control points
     float3 f3B210    : POSITION3;
@@ -113,26 +162,51 @@ struct HS_ConstantOutput
     float3 f3B201    : POSITION8;
     float3 f3B111    : CENTER;
     
+	#if ( DEPTH_ONLY != 1 )
+
     // Normal quadratic generated control points
     float3 f3N110    : NORMAL3;      
     float3 f3N011    : NORMAL4;
     float3 f3N101    : NORMAL5;
 
 	#endif
+
+	#endif
+
+	#endif
 };
 
 struct HS_ControlPointOutput
 {
     float3 f3Position    : POSITION;
-    float3 f3Normal      : NORMAL;
+    float3 f3Normal      : NORMAL;      // Kept with DEPTH_ONLY, Phong projects onto the tangent planes
+
+	#if ( DEPTH_ONLY != 1 )
     float2 f2TexCoord    : TEXCOORD;
+	#endif
 };
 
+// DEPTH_ONLY is not combined with MULTI_VIEW, GS_MultiView copies all the outputs
 struct DS_Output
+{
+    float4 f4Position   : SV_Position;  // World space with MULTI_VIEW, projected by GS_MultiView
+
+	#if ( DEPTH_ONLY != 1 )
+    float2 f2TexCoord   : TEXCOORD0;
+    float4 f4Diffuse    : COLOR0;
+	#endif
+
+	#if ( MULTI_VIEW == 1 )
+    uint   uViewMask    : VIEW_MASK;
+	#endif
+};
+
+struct GS_MultiViewOutput
 {
     float4 f4Position   : SV_Position;
     float2 f2TexCoord   : TEXCOORD0;
     float4 f4Diffuse    : COLOR0;
+    uint   uViewport    : SV_ViewportArrayIndex;
 };
 
 struct PS_RenderSceneInput
@@ -148,6 +222,23 @@ struct PS_RenderOutput
 };
 
 
+#if ( INSTANCED == 1 )
+
+//--------------------------------------------------------------------------------------
+// Returns the world matrix of an instance of the bin drawn. SV_InstanceID does not
+// include the start instance of the draw, so the bin starts at g_uFirstInstance.
+//--------------------------------------------------------------------------------------
+float4x4 GetInstanceWorld( uint uInstanceID )
+{
+    uint uRow = ( g_uFirstInstance + uInstanceID ) * 4;
+
+    return float4x4( g_bufInstanceWorld.Load( uRow + 0 ), g_bufInstanceWorld.Load( uRow + 1 ),
+                     g_bufInstanceWorld.Load( uRow + 2 ), g_bufInstanceWorld.Load( uRow + 3 ) );
+}
+
+#endif
+
+
 //--------------------------------------------------------------------------------------
 // This vertex shader computes standard transform and lighting, with no tessellation stages following
 //--------------------------------------------------------------------------------------
@@ -156,11 +247,35 @@ PS_RenderSceneInput VS_RenderScene( VS_RenderSceneInput I )
     PS_RenderSceneInput O;
     float3 f3NormalWorldSpace;
     
+    #if ( INSTANCED == 1 )
+
+    // Transform the position by the world matrix of the instance
+    float4x4 f4x4World = GetInstanceWorld( I.uInstanceID );
+    O.f4Position = mul( mul( float4( I.f3Position, 1.0f ), f4x4World ), g_f4x4ViewProjection );
+    f3NormalWorldSpace = normalize( mul( I.f3Normal, (float3x3)f4x4World ) );
+
+    #elif ( WORLD_SPACE_VB == 1 )
+
+    // The vertex buffer is already in world space (see WorldSpaceVertices.h)
+    O.f4Position = mul( float4( I.f3Position, 1.0f ), g_f4x4ViewProjection );
+    f3NormalWorldSpace = I.f3Normal;
+
+    #elif ( SILHOUETTE_CLIP == 1 )
+
+    // Push the coarse mesh out to cover the patches, its outline is clipped to the silhouette
+    // of the detailed mesh in the stencil (see SilhouetteClip.h)
+    O.f4Position = mul( float4( I.f3Position + I.f3Normal * g_fSilhouetteInflation, 1.0f ), g_f4x4WorldViewProjection );
+    f3NormalWorldSpace = normalize( mul( I.f3Normal, (float3x3)g_f4x4World ) );
+
+    #else
+
     // Transform the position from object space to homogeneous projection space
     O.f4Position = mul( float4( I.f3Position, 1.0f ), g_f4x4WorldViewProjection );
     
     // Transform the normal from object space to world space    
     f3NormalWorldSpace = normalize( mul( I.f3Normal, (float3x3)g_f4x4World ) );
+
+    #endif
     
     // Calc diffuse color    
     O.f4Diffuse.rgb = g_f4MaterialDiffuseColor.rgb * g_f4LightDiffuse.rgb * max( 0, dot( f3NormalWorldSpace, g_f4LightDir.xyz ) ) + g_f4MaterialAmbientColor.rgb;  
@@ -180,11 +295,28 @@ HS_Input VS_RenderSceneWithTessellation( VS_RenderSceneInput I )
 {
     HS_Input O;
     
+    #if ( INSTANCED == 1 )
+
+    // The instances are placed by the translation of their world matrix too
+    float4x4 f4x4World = GetInstanceWorld( I.uInstanceID );
+    O.f3Position = mul( float4( I.f3Position, 1.0f ), f4x4World ).xyz;
+    O.f3Normal = normalize( mul( I.f3Normal, (float3x3)f4x4World ) );
+
+    #elif ( WORLD_SPACE_VB == 1 )
+
+    // The vertex buffer is already in world space, with normalized normals
+    O.f3Position = I.f3Position;
+    O.f3Normal = I.f3Normal;
+
+    #else
+
     // transforms position into world space
     O.f3Position = mul( I.f3Position, (float3x3)g_f4x4World );
     
     // transforms normals into world space
     O.f3Normal = normalize( mul( I.f3Normal, (float3x3)g_f4x4World ) );
+
+    #endif
         
     // Pass through texture coordinates
     O.f2TexCoord = I.f2TexCoord;
@@ -194,6 +326,99 @@ HS_Input VS_RenderSceneWithTessellation( VS_RenderSceneInput I )
 
 #if PHONG || PNTRI
 
+#if ( MULTI_VIEW == 1 )
+
+//--------------------------------------------------------------------------------------
+// Computes the edge tess factors of a patch for view uView of a MULTI_VIEW pass, as the
+// single view path of HS_PNTrianglesConstant does without the foveated and motion terms.
+// The edge normals are set up once for all the views. Returns false if the patch is
+// culled in the view.
+//--------------------------------------------------------------------------------------
+bool GetViewTessFactors( float3 f3Position0, float3 f3Position1, float3 f3Position2, float3 f3EdgeNormal[3], uint uView,
+                         out float3 f3TessFactor )
+{
+    f3TessFactor = g_fEdgeTessFactors;
+
+    float3 f3EdgeDot;
+    f3EdgeDot.x = dot( f3EdgeNormal[0], g_f4MultiViewVector[uView].xyz );
+    f3EdgeDot.y = dot( f3EdgeNormal[1], g_f4MultiViewVector[uView].xyz );
+    f3EdgeDot.z = dot( f3EdgeNormal[2], g_f4MultiViewVector[uView].xyz );
+
+    #if ( FRUST_CULL == 1 )
+
+        float4 f4ViewFrustumPlanes[4];
+        f4ViewFrustumPlanes[0] = g_f4MultiViewFrustumPlanes[uView * 4 + 0];
+        f4ViewFrustumPlanes[1] = g_f4MultiViewFrustumPlanes[uView * 4 + 1];
+        f4ViewFrustumPlanes[2] = g_f4MultiViewFrustumPlanes[uView * 4 + 2];
+        f4ViewFrustumPlanes[3] = g_f4MultiViewFrustumPlanes[uView * 4 + 3];
+        if ( TriangleInFrustum( f3Position0, f3Position1, f3Position2, f4ViewFrustumPlanes, g_fGUIViewFrustrumEpsilon ) == false )
+        {
+            return false;
+        }
+
+    #endif
+
+    #if ( BF_CULL == 1 )
+
+        if ( BackFaceCull( f3EdgeDot.x, f3EdgeDot.y, f3EdgeDot.z, g_fGUIBackFaceEpsilon ) == true )
+        {
+            return false;
+        }
+
+    #endif
+
+    #if ( SS_ADAPT == 1 )
+
+        float2 f2ScreenPosition0 = GetScreenSpacePosition( f3Position0, g_f4x4MultiViewProjection[uView], g_f2ScreenSize.x, g_f2ScreenSize.y );
+        float2 f2ScreenPosition1 = GetScreenSpacePosition( f3Position1, g_f4x4MultiViewProjection[uView], g_f2ScreenSize.x, g_f2ScreenSize.y );
+        float2 f2ScreenPosition2 = GetScreenSpacePosition( f3Position2, g_f4x4MultiViewProjection[uView], g_f2ScreenSize.x, g_f2ScreenSize.y );
+        f3TessFactor.x = lerp( 1.0f, f3TessFactor.x, GetScreenSpaceAdaptiveScaleFactor( f2ScreenPosition2, f2ScreenPosition0, g_fEdgeTessFactors, g_fGUIEdgeSize ) );
+        f3TessFactor.y = lerp( 1.0f, f3TessFactor.y, GetScreenSpaceAdaptiveScaleFactor( f2ScreenPosition0, f2ScreenPosition1, g_fEdgeTessFactors, g_fGUIEdgeSize ) );
+        f3TessFactor.z = lerp( 1.0f, f3TessFactor.z, GetScreenSpaceAdaptiveScaleFactor( f2ScreenPosition1, f2ScreenPosition2, g_fEdgeTessFactors, g_fGUIEdgeSize ) );
+
+    #else
+
+        #if ( DIST_ADAPT == 1 )
+
+            float3 f3Eye = g_f4MultiViewEye[uView].xyz;
+            float fRange = g_fTessRange * g_fGUIRangeScale;
+            f3TessFactor.x = lerp( 1.0f, f3TessFactor.x, GetDistanceAdaptiveScaleFactor( f3Eye, f3Position2, f3Position0, g_fMinDistance, fRange ) );
+            f3TessFactor.y = lerp( 1.0f, f3TessFactor.y, GetDistanceAdaptiveScaleFactor( f3Eye, f3Position0, f3Position1, g_fMinDistance, fRange ) );
+            f3TessFactor.z = lerp( 1.0f, f3TessFactor.z, GetDistanceAdaptiveScaleFactor( f3Eye, f3Position1, f3Position2, g_fMinDistance, fRange ) );
+
+        #endif
+
+        #if ( RES_ADAPT == 1 )
+
+            // The same for all the views
+            f3TessFactor = lerp( 1.0f, f3TessFactor, GetScreenResolutionAdaptiveScaleFactor( g_f2ScreenSize.x, g_f2ScreenSize.y, 
+                g_f2ResolutionReference.x * g_fGUIScreenResolutionScale, g_f2ResolutionReference.y * g_fGUIScreenResolutionScale ) );
+
+        #endif
+
+    #endif
+
+    #if ( ORIENT_ADAPT == 1 )
+
+        float3 f3OrientationScale;
+        f3OrientationScale.x = GetOrientationAdaptiveScaleFactor( f3EdgeDot.x, g_fGUISilhouetteEpsilon );
+        f3OrientationScale.y = GetOrientationAdaptiveScaleFactor( f3EdgeDot.y, g_fGUISilhouetteEpsilon );
+        f3OrientationScale.z = GetOrientationAdaptiveScaleFactor( f3EdgeDot.z, g_fGUISilhouetteEpsilon );
+        float3 f3OrientationTessFactor = lerp( 1.0f, g_fEdgeTessFactors, f3OrientationScale );
+
+        #if ( SS_ADAPT == 1 ) || ( DIST_ADAPT == 1 ) || ( RES_ADAPT == 1)
+            f3TessFactor = ( f3TessFactor + f3OrientationTessFactor ) / 2.0f;
+        #else
+            f3TessFactor = f3OrientationTessFactor;
+        #endif
+
+    #endif
+
+    return true;
+}
+
+#endif
+
 //--------------------------------------------------------------------------------------
 // This hull shader passes the tessellation factors through to the HW tessellator, 
 // and the 10 (geometry), 6 (normal) control points of the PN-triangular patch to the domain shader
@@ -201,6 +426,42 @@ HS_Input VS_RenderSceneWithTessellation( VS_RenderSceneInput I )
 HS_ConstantOutput HS_PNTrianglesConstant( InputPatch<HS_Input, 3> I )
 {
     HS_ConstantOutput O = (HS_ConstantOutput)0;
+
+    #if ( MULTI_VIEW == 1 )
+
+        // Set up the edge normals once, and the control points below, for the culling and
+        // factors of every view. The tessellator runs once for all the views the patch is
+        // visible in, at the largest of their factors.
+        float3 f3EdgeNormal[3];
+        f3EdgeNormal[0] = normalize( ( I[2].f3Normal + I[0].f3Normal ) * 0.5f );
+        f3EdgeNormal[1] = normalize( ( I[0].f3Normal + I[1].f3Normal ) * 0.5f );
+        f3EdgeNormal[2] = normalize( ( I[1].f3Normal + I[2].f3Normal ) * 0.5f );
+
+        float3 f3MaxTessFactor = 0.0f;
+        uint uViewMask = 0;
+        for( uint uView = 0; uView < g_uNumViews; uView++ )
+        {
+            float3 f3TessFactor;
+            if ( GetViewTessFactors( I[0].f3Position, I[1].f3Position, I[2].f3Position, f3EdgeNormal, uView, f3TessFactor ) )
+            {
+                f3MaxTessFactor = max( f3MaxTessFactor, f3TessFactor );
+                uViewMask |= 1u << uView;
+            }
+        }
+
+        if ( uViewMask == 0 )
+        {
+            // Cull the patch (all the tess factors are set to 0)
+            return O;
+        }
+
+        O.fTessFactor[0] = f3MaxTessFactor.x;
+        O.fTessFactor[1] = f3MaxTessFactor.y;
+        O.fTessFactor[2] = f3MaxTessFactor.z;
+        O.uViewMask = uViewMask;
+
+    #else
+
     float fEdgeDot[3];
     
     #if ( FRUST_CULL == 1 )
@@ -280,13 +541,13 @@ HS_ConstantOutput HS_PNTrianglesConstant( InputPatch<HS_Input, 3> I )
 
             // Use screen resolution as a global scaling factor
             // Edge 0
-            fAdaptiveScaleFactor = GetScreenResolutionAdaptiveScaleFactor( g_f2ScreenSize.x, g_f2ScreenSize.y, g_fMaxScreenWidth * g_fGUIScreenResolutionScale, g_fMaxScreenHeight * g_fGUIScreenResolutionScale );
+            fAdaptiveScaleFactor = GetScreenResolutionAdaptiveScaleFactor( g_f2ScreenSize.x, g_f2ScreenSize.y, g_f2ResolutionReference.x * g_fGUIScreenResolutionScale, g_f2ResolutionReference.y * g_fGUIScreenResolutionScale );
             O.fTessFactor[0] = lerp( 1.0f, O.fTessFactor[0], fAdaptiveScaleFactor ); 
             // Edge 1
-            fAdaptiveScaleFactor = GetScreenResolutionAdaptiveScaleFactor( g_f2ScreenSize.x, g_f2ScreenSize.y, g_fMaxScreenWidth * g_fGUIScreenResolutionScale, g_fMaxScreenHeight * g_fGUIScreenResolutionScale );
+            fAdaptiveScaleFactor = GetScreenResolutionAdaptiveScaleFactor( g_f2ScreenSize.x, g_f2ScreenSize.y, g_f2ResolutionReference.x * g_fGUIScreenResolutionScale, g_f2ResolutionReference.y * g_fGUIScreenResolutionScale );
             O.fTessFactor[1] = lerp( 1.0f, O.fTessFactor[1], fAdaptiveScaleFactor ); 
             // Edge 2
-            fAdaptiveScaleFactor = GetScreenResolutionAdaptiveScaleFactor( g_f2ScreenSize.x, g_f2ScreenSize.y, g_fMaxScreenWidth * g_fGUIScreenResolutionScale, g_fMaxScreenHeight * g_fGUIScreenResolutionScale );
+            fAdaptiveScaleFactor = GetScreenResolutionAdaptiveScaleFactor( g_f2ScreenSize.x, g_f2ScreenSize.y, g_f2ResolutionReference.x * g_fGUIScreenResolutionScale, g_f2ResolutionReference.y * g_fGUIScreenResolutionScale );
             O.fTessFactor[2] = lerp( 1.0f, O.fTessFactor[2], fAdaptiveScaleFactor ); 
 
         #endif
@@ -336,6 +597,46 @@ HS_ConstantOutput HS_PNTrianglesConstant( InputPatch<HS_Input, 3> I )
 
         #endif
                                             
+    #endif
+
+    #if ( FOVEA_ADAPT == 1 )
+
+        // Scale the factors down away from the focus point, after the other adaptive terms
+        // so it applies to any of them
+
+        // Edge 0
+        fAdaptiveScaleFactor = GetFoveatedAdaptiveScaleFactor( I[2].f3Position, I[0].f3Position, g_f4x4ViewProjection, g_f2ScreenSize, g_f4Fovea.xy, g_f4Fovea.z, g_f4Fovea.w, g_fGUIFoveaPeripheryScale );
+        O.fTessFactor[0] = lerp( 1.0f, O.fTessFactor[0], fAdaptiveScaleFactor ); 
+
+        // Edge 1
+        fAdaptiveScaleFactor = GetFoveatedAdaptiveScaleFactor( I[0].f3Position, I[1].f3Position, g_f4x4ViewProjection, g_f2ScreenSize, g_f4Fovea.xy, g_f4Fovea.z, g_f4Fovea.w, g_fGUIFoveaPeripheryScale );
+        O.fTessFactor[1] = lerp( 1.0f, O.fTessFactor[1], fAdaptiveScaleFactor ); 
+
+        // Edge 2
+        fAdaptiveScaleFactor = GetFoveatedAdaptiveScaleFactor( I[1].f3Position, I[2].f3Position, g_f4x4ViewProjection, g_f2ScreenSize, g_f4Fovea.xy, g_f4Fovea.z, g_f4Fovea.w, g_fGUIFoveaPeripheryScale );
+        O.fTessFactor[2] = lerp( 1.0f, O.fTessFactor[2], fAdaptiveScaleFactor ); 
+
+    #endif
+
+    #if ( MOTION_ADAPT == 1 )
+
+        // Scale the factors down on fast moving edges, after the other adaptive terms so it
+        // applies to any of them
+
+        // Edge 0
+        fAdaptiveScaleFactor = GetMotionAdaptiveScaleFactor( I[2].f3Position, I[0].f3Position, g_f4x4ViewProjection, g_f4x4PrevViewProjection, g_f2ScreenSize, g_f4Motion.x, g_f4Motion.y, g_f4Motion.z );
+        O.fTessFactor[0] = lerp( 1.0f, O.fTessFactor[0], fAdaptiveScaleFactor ); 
+
+        // Edge 1
+        fAdaptiveScaleFactor = GetMotionAdaptiveScaleFactor( I[0].f3Position, I[1].f3Position, g_f4x4ViewProjection, g_f4x4PrevViewProjection, g_f2ScreenSize, g_f4Motion.x, g_f4Motion.y, g_f4Motion.z );
+        O.fTessFactor[1] = lerp( 1.0f, O.fTessFactor[1], fAdaptiveScaleFactor ); 
+
+        // Edge 2
+        fAdaptiveScaleFactor = GetMotionAdaptiveScaleFactor( I[1].f3Position, I[2].f3Position, g_f4x4ViewProjection, g_f4x4PrevViewProjection, g_f2ScreenSize, g_f4Motion.x, g_f4Motion.y, g_f4Motion.z );
+        O.fTessFactor[2] = lerp( 1.0f, O.fTessFactor[2], fAdaptiveScaleFactor ); 
+
+    #endif
+
     #endif
           
 	#if ( PNTRI == 1 )
@@ -352,24 +653,60 @@ HS_ConstantOutput HS_PNTrianglesConstant( InputPatch<HS_Input, 3> I )
             
 		// Compute the cubic geometry control points
 		// Edge control points
-		O.f3B210 = ( ( 2.0f * f3B003 ) + f3B030 - ( dot( ( f3B030 - f3B003 ), f3N002 ) * f3N002 ) ) / 3.0f;
-		O.f3B120 = ( ( 2.0f * f3B030 ) + f3B003 - ( dot( ( f3B003 - f3B030 ), f3N020 ) * f3N020 ) ) / 3.0f;
-		O.f3B021 = ( ( 2.0f * f3B030 ) + f3B300 - ( dot( ( f3B300 - f3B030 ), f3N020 ) * f3N020 ) ) / 3.0f;
-		O.f3B012 = ( ( 2.0f * f3B300 ) + f3B030 - ( dot( ( f3B030 - f3B300 ), f3N200 ) * f3N200 ) ) / 3.0f;
-		O.f3B102 = ( ( 2.0f * f3B300 ) + f3B003 - ( dot( ( f3B003 - f3B300 ), f3N200 ) * f3N200 ) ) / 3.0f;
-		O.f3B201 = ( ( 2.0f * f3B003 ) + f3B300 - ( dot( ( f3B300 - f3B003 ), f3N002 ) * f3N002 ) ) / 3.0f;
+		float3 f3B210 = ( ( 2.0f * f3B003 ) + f3B030 - ( dot( ( f3B030 - f3B003 ), f3N002 ) * f3N002 ) ) / 3.0f;
+		float3 f3B120 = ( ( 2.0f * f3B030 ) + f3B003 - ( dot( ( f3B003 - f3B030 ), f3N020 ) * f3N020 ) ) / 3.0f;
+		float3 f3B021 = ( ( 2.0f * f3B030 ) + f3B300 - ( dot( ( f3B300 - f3B030 ), f3N020 ) * f3N020 ) ) / 3.0f;
+		float3 f3B012 = ( ( 2.0f * f3B300 ) + f3B030 - ( dot( ( f3B030 - f3B300 ), f3N200 ) * f3N200 ) ) / 3.0f;
+		float3 f3B102 = ( ( 2.0f * f3B300 ) + f3B003 - ( dot( ( f3B003 - f3B300 ), f3N200 ) * f3N200 ) ) / 3.0f;
+		float3 f3B201 = ( ( 2.0f * f3B003 ) + f3B300 - ( dot( ( f3B300 - f3B003 ), f3N002 ) * f3N002 ) ) / 3.0f;
 		// Center control point
-		float3 f3E = ( O.f3B210 + O.f3B120 + O.f3B021 + O.f3B012 + O.f3B102 + O.f3B201 ) / 6.0f;
+		float3 f3E = ( f3B210 + f3B120 + f3B021 + f3B012 + f3B102 + f3B201 ) / 6.0f;
 		float3 f3V = ( f3B003 + f3B030 + f3B300 ) / 3.0f;
-		O.f3B111 = f3E + ( ( f3E - f3V ) / 2.0f );
+		float3 f3B111 = f3E + ( ( f3E - f3V ) / 2.0f );
         
-		// Compute the quadratic normal control points, and rotate into world space
-		float fV12 = 2.0f * dot( f3B030 - f3B003, f3N002 + f3N020 ) / dot( f3B030 - f3B003, f3B030 - f3B003 );
-		O.f3N110 = normalize( f3N002 + f3N020 - fV12 * ( f3B030 - f3B003 ) );
-		float fV23 = 2.0f * dot( f3B300 - f3B030, f3N020 + f3N200 ) / dot( f3B300 - f3B030, f3B300 - f3B030 );
-		O.f3N011 = normalize( f3N020 + f3N200 - fV23 * ( f3B300 - f3B030 ) );
-		float fV31 = 2.0f * dot( f3B003 - f3B300, f3N200 + f3N002 ) / dot( f3B003 - f3B300, f3B003 - f3B300 );
-		O.f3N101 = normalize( f3N200 + f3N002 - fV31 * ( f3B003 - f3B300 ) );
+		// No normals are interpolated with DEPTH_ONLY, so the quadratic control points are not needed
+		#if ( DEPTH_ONLY != 1 )
+			// Compute the quadratic normal control points, and rotate into world space
+			float fV12 = 2.0f * dot( f3B030 - f3B003, f3N002 + f3N020 ) / dot( f3B030 - f3B003, f3B030 - f3B003 );
+			float3 f3N110 = normalize( f3N002 + f3N020 - fV12 * ( f3B030 - f3B003 ) );
+			float fV23 = 2.0f * dot( f3B300 - f3B030, f3N020 + f3N200 ) / dot( f3B300 - f3B030, f3B300 - f3B030 );
+			float3 f3N011 = normalize( f3N020 + f3N200 - fV23 * ( f3B300 - f3B030 ) );
+			float fV31 = 2.0f * dot( f3B003 - f3B300, f3N200 + f3N002 ) / dot( f3B003 - f3B300, f3B003 - f3B300 );
+			float3 f3N101 = normalize( f3N200 + f3N002 - fV31 * ( f3B003 - f3B300 ) );
+		#endif
+
+		#if ( PACKED_CP == 1 )
+			// Store each control point relative to the corner it was derived from
+			#if ( DEPTH_ONLY == 1 )
+				float2 f2N110 = 0.0f;
+				float2 f2N011 = 0.0f;
+				float2 f2N101 = 0.0f;
+			#else
+				float2 f2N110 = OctEncode( f3N110 );
+				float2 f2N011 = OctEncode( f3N011 );
+				float2 f2N101 = OctEncode( f3N101 );
+			#endif
+			O.u2B210 = PackHalfOffset( f3B210 - f3B003, f2N110.x );
+			O.u2B120 = PackHalfOffset( f3B120 - f3B030, f2N110.y );
+			O.u2B021 = PackHalfOffset( f3B021 - f3B030, f2N011.x );
+			O.u2B012 = PackHalfOffset( f3B012 - f3B300, f2N011.y );
+			O.u2B102 = PackHalfOffset( f3B102 - f3B300, f2N101.x );
+			O.u2B201 = PackHalfOffset( f3B201 - f3B003, f2N101.y );
+			O.u2B111 = PackHalfOffset( f3B111 - f3V, 0.0f );
+		#else
+			O.f3B210 = f3B210;
+			O.f3B120 = f3B120;
+			O.f3B021 = f3B021;
+			O.f3B012 = f3B012;
+			O.f3B102 = f3B102;
+			O.f3B201 = f3B201;
+			O.f3B111 = f3B111;
+			#if ( DEPTH_ONLY != 1 )
+				O.f3N110 = f3N110;
+				O.f3N011 = f3N011;
+				O.f3N101 = f3N101;
+			#endif
+		#endif
 	#endif
 
     // Inside tess factor is just the average of the edge factors
@@ -391,7 +728,10 @@ HS_ControlPointOutput HS_PNTriangles( InputPatch<HS_Input, 3> I, uint uCPID : SV
     // Just pass through inputs = fast pass through mode triggered
     O.f3Position = I[uCPID].f3Position;
     O.f3Normal = I[uCPID].f3Normal;
+
+    #if ( DEPTH_ONLY != 1 )
     O.f2TexCoord = I[uCPID].f2TexCoord;
+    #endif
     
     return O;
 }
@@ -426,9 +766,11 @@ DS_Output DS_PNTriangles( HS_ConstantOutput HSConstantData, const OutputPatch<HS
     float fVV = fV * fV;
     float fWW = fW * fW;
 
+	// The positions are precise, so the DEPTH_ONLY permutation of a depth pre-pass writes the
+	// same depths the colour pass tests against
 	#if ( PHONG == 1 )
 
-		float3 f3Position = I[0].f3Position * fWW + 
+		precise float3 f3Position = I[0].f3Position * fWW + 
 							I[1].f3Position * fUU +
 							I[2].f3Position * fVV +
 							fW * fU * ( PI(I[0], I[1]) + PI(I[1], I[0]) ) +
@@ -439,38 +781,73 @@ DS_Output DS_PNTriangles( HS_ConstantOutput HSConstantData, const OutputPatch<HS
 
 		f3Position = f3Position*t + (I[0].f3Position * fW + I[1].f3Position * fU + I[2].f3Position * fV)*(1-t);
 
+		#if ( DEPTH_ONLY != 1 )
 		float3 f3Normal =   I[0].f3Normal * fW +
 							I[1].f3Normal * fU +
 							I[2].f3Normal * fV;
+		#endif
 	#endif
     
 	#if ( PNTRI == 1 )
+		#if ( PACKED_CP == 1 )
+			// Rebuild the control points from the patch corners
+			float3 f3B210 = I[0].f3Position + UnpackHalfOffset( HSConstantData.u2B210 );
+			float3 f3B120 = I[1].f3Position + UnpackHalfOffset( HSConstantData.u2B120 );
+			float3 f3B021 = I[1].f3Position + UnpackHalfOffset( HSConstantData.u2B021 );
+			float3 f3B012 = I[2].f3Position + UnpackHalfOffset( HSConstantData.u2B012 );
+			float3 f3B102 = I[2].f3Position + UnpackHalfOffset( HSConstantData.u2B102 );
+			float3 f3B201 = I[0].f3Position + UnpackHalfOffset( HSConstantData.u2B201 );
+			float3 f3B111 = ( I[0].f3Position + I[1].f3Position + I[2].f3Position ) / 3.0f + UnpackHalfOffset( HSConstantData.u2B111 );
+			#if ( DEPTH_ONLY != 1 )
+			float3 f3N110 = OctDecode( float2( UnpackHalfOffsetAux( HSConstantData.u2B210 ), UnpackHalfOffsetAux( HSConstantData.u2B120 ) ) );
+			float3 f3N011 = OctDecode( float2( UnpackHalfOffsetAux( HSConstantData.u2B021 ), UnpackHalfOffsetAux( HSConstantData.u2B012 ) ) );
+			float3 f3N101 = OctDecode( float2( UnpackHalfOffsetAux( HSConstantData.u2B102 ), UnpackHalfOffsetAux( HSConstantData.u2B201 ) ) );
+			#endif
+		#else
+			float3 f3B210 = HSConstantData.f3B210;
+			float3 f3B120 = HSConstantData.f3B120;
+			float3 f3B021 = HSConstantData.f3B021;
+			float3 f3B012 = HSConstantData.f3B012;
+			float3 f3B102 = HSConstantData.f3B102;
+			float3 f3B201 = HSConstantData.f3B201;
+			float3 f3B111 = HSConstantData.f3B111;
+			#if ( DEPTH_ONLY != 1 )
+			float3 f3N110 = HSConstantData.f3N110;
+			float3 f3N011 = HSConstantData.f3N011;
+			float3 f3N101 = HSConstantData.f3N101;
+			#endif
+		#endif
+
 		// Precompute squares * 3 
 		float fUU3 = fUU * 3.0f;
 		float fVV3 = fVV * 3.0f;
 		float fWW3 = fWW * 3.0f;
 
 		// Compute position from cubic control points and barycentric coords
-		float3 f3Position = I[0].f3Position * fWW * fW +
+		precise float3 f3Position = I[0].f3Position * fWW * fW +
 							I[1].f3Position * fUU * fU +
 							I[2].f3Position * fVV * fV +
-							HSConstantData.f3B210 * fWW3 * fU +
-							HSConstantData.f3B120 * fW * fUU3 +
-							HSConstantData.f3B201 * fWW3 * fV +
-							HSConstantData.f3B021 * fUU3 * fV +
-							HSConstantData.f3B102 * fW * fVV3 +
-							HSConstantData.f3B012 * fU * fVV3 +
-							HSConstantData.f3B111 * 6.0f * fW * fU * fV;
+							f3B210 * fWW3 * fU +
+							f3B120 * fW * fUU3 +
+							f3B201 * fWW3 * fV +
+							f3B021 * fUU3 * fV +
+							f3B102 * fW * fVV3 +
+							f3B012 * fU * fVV3 +
+							f3B111 * 6.0f * fW * fU * fV;
     
+		#if ( DEPTH_ONLY != 1 )
 		// Compute normal from quadratic control points and barycentric coords
 		float3 f3Normal =   I[0].f3Normal * fWW +
 							I[1].f3Normal * fUU +
 							I[2].f3Normal * fVV +
-							HSConstantData.f3N110 * fW * fU +
-							HSConstantData.f3N011 * fU * fV +
-							HSConstantData.f3N101 * fW * fV;
+							f3N110 * fW * fU +
+							f3N011 * fU * fV +
+							f3N101 * fW * fV;
+		#endif
 	#endif
 
+    #if ( DEPTH_ONLY != 1 )
+
     // Normalize the interpolated normal    
     f3Normal = normalize( f3Normal );
 
@@ -481,14 +858,60 @@ DS_Output DS_PNTriangles( HS_ConstantOutput HSConstantData, const OutputPatch<HS
     O.f4Diffuse.rgb = g_f4MaterialDiffuseColor.rgb * g_f4LightDiffuse.rgb * max( 0, dot( f3Normal, g_f4LightDir.xyz ) ) + g_f4MaterialAmbientColor.rgb;  
     O.f4Diffuse.a = 1.0f; 
 
+    #endif
+
+    #if ( MULTI_VIEW == 1 )
+
+    // GS_MultiView projects the position into each view the patch is visible in
+    O.f4Position = float4( f3Position.xyz, 1.0 );
+    O.uViewMask = HSConstantData.uViewMask;
+
+    #else
+
     // Transform model position with view-projection matrix
-    O.f4Position = mul( float4( f3Position.xyz, 1.0 ), g_f4x4ViewProjection );
+    precise float4 f4Position = mul( float4( f3Position.xyz, 1.0 ), g_f4x4ViewProjection );
+    O.f4Position = f4Position;
+
+    #endif
         
     return O;
 }
 
 #endif
 
+#if ( MULTI_VIEW == 1 )
+
+//--------------------------------------------------------------------------------------
+// This geometry shader copies the triangles of a MULTI_VIEW domain shader to the viewport
+// of each view their patch is visible in
+//--------------------------------------------------------------------------------------
+[maxvertexcount( 3 * MULTI_VIEW_MAX_VIEWS )]
+void GS_MultiView( triangle DS_Output I[3], inout TriangleStream<GS_MultiViewOutput> Stream )
+{
+    GS_MultiViewOutput O;
+
+    for( uint uView = 0; uView < g_uNumViews; uView++ )
+    {
+        if ( ( I[0].uViewMask & ( 1u << uView ) ) == 0 )
+        {
+            continue;
+        }
+
+        [unroll]
+        for( uint uVertex = 0; uVertex < 3; uVertex++ )
+        {
+            O.f4Position = mul( I[uVertex].f4Position, g_f4x4MultiViewProjection[uView] );
+            O.f2TexCoord = I[uVertex].f2TexCoord;
+            O.f4Diffuse = I[uVertex].f4Diffuse;
+            O.uViewport = uView;
+            Stream.Append( O );
+        }
+        Stream.RestartStrip();
+    }
+}
+
+#endif
+
 //--------------------------------------------------------------------------------------
 // This shader outputs the pixel's color by passing through the lit 
 // diffuse material color & modulating with the diffuse texture
@@ -517,6 +940,35 @@ PS_RenderOutput PS_RenderScene( PS_RenderSceneInput I )
 }
 
 
+//--------------------------------------------------------------------------------------
+// Full screen triangle from SV_VertexID, used to upscale the dynamic resolution scene
+//--------------------------------------------------------------------------------------
+float4 VS_FullScreen( uint uVertexID : SV_VertexID ) : SV_POSITION
+{
+    float2 f2UV = float2( ( uVertexID << 1 ) & 2, uVertexID & 2 );
+
+    return float4( f2UV * float2( 2.0f, -2.0f ) + float2( -1.0f, 1.0f ), 0.0f, 1.0f );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Bilinear upscale of the top left g_f4Upscale.zw pixels of g_txScene to the back buffer
+//--------------------------------------------------------------------------------------
+PS_RenderOutput PS_Upscale( float4 f4Position : SV_POSITION )
+{
+    PS_RenderOutput O;
+
+    float2 f2Dims;
+    g_txScene.GetDimensions( f2Dims.x, f2Dims.y );
+
+    float2 f2Pixel = f4Position.xy / g_f4Upscale.xy * g_f4Upscale.zw;
+    f2Pixel = min( f2Pixel, g_f4Upscale.zw - 0.5f );
+
+    O.f4Color = g_txScene.SampleLevel( g_SampleLinear, f2Pixel / f2Dims, 0 );
+
+    return O;
+}
+
 //--------------------------------------------------------------------------------------
 // EOF
 //--------------------------------------------------------------------------------------
@@ -0,0 +1,582 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: SilhouetteClip.cpp
+//
+// Silhouette edges of a detailed mesh from a hierarchy of edge clusters, for clipping the
+// outline of the coarse mesh.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "SilhouetteClip.h"
+#include <algorithm>
+#include <float.h>
+
+using namespace DirectX;
+
+// Weight of the normal against the position, normalized to the bounds diagonal, when
+// clusters are split
+static const float SILHOUETTE_NORMAL_WEIGHT = 1.0f;
+
+// Margin of the cluster tests against rounding, on the sine of the spread angle
+static const float SILHOUETTE_ANGLE_EPSILON = 1.0e-4f;
+
+// Deepest hierarchy the traversal stack holds, the splits are at the median
+static const UINT SILHOUETTE_MAX_DEPTH = 64;
+
+// Orders vertices by position
+struct SILHOUETTE_POSITION_LESS
+{
+    const PN_VERTEX*    pVertices;
+
+    bool operator()( UINT uA, UINT uB ) const
+    {
+        const XMFLOAT3& f3A = pVertices[uA].f3Position;
+        const XMFLOAT3& f3B = pVertices[uB].f3Position;
+        if( f3A.x != f3B.x )
+        {
+            return f3A.x < f3B.x;
+        }
+        if( f3A.y != f3B.y )
+        {
+            return f3A.y < f3B.y;
+        }
+        return f3A.z < f3B.z;
+    }
+};
+
+// Orders edges along one axis of their split keys
+struct SILHOUETTE_KEY_LESS
+{
+    const float*    pfKeys;     // 6 per edge
+    UINT            uAxis;
+
+    bool operator()( UINT uA, UINT uB ) const
+    {
+        return pfKeys[uA * 6 + uAxis] < pfKeys[uB * 6 + uAxis];
+    }
+};
+
+
+//--------------------------------------------------------------------------------------
+// Returns the distance the coarse mesh is pushed out to cover the patches, and the
+// distance it is pushed in to be covered by them
+//--------------------------------------------------------------------------------------
+float GetMaxPatchBulge( const MESH_DATA* pMeshData, CPU_TESS_TECHNIQUE Technique, float fTessFactor, float* pfMaxInset )
+{
+    assert( NULL != pMeshData );
+
+    // Pushed out by d along the vertex normals, the triangle moves by at least d times the
+    // smallest cosine of a vertex normal to the face normal
+    static const float MIN_NORMAL_COSINE = 0.25f;
+
+    UINT uNumSteps = std::max( (UINT)ceilf( fTessFactor ), 1U );
+    float fMaxBulge = 0.0f;
+    float fMaxInset = 0.0f;
+    for( UINT uTriangle = 0; uTriangle < (UINT)pMeshData->Indices.size() / 3; uTriangle++ )
+    {
+        const UINT* pTri = &pMeshData->Indices[uTriangle * 3];
+        PN_VERTEX Corners[3] = { pMeshData->Vertices[pTri[0]], pMeshData->Vertices[pTri[1]], pMeshData->Vertices[pTri[2]] };
+        XMVECTOR vP0 = XMLoadFloat3( &Corners[0].f3Position );
+        XMVECTOR vNormal = XMVector3Cross( XMVectorSubtract( XMLoadFloat3( &Corners[1].f3Position ), vP0 ),
+                                           XMVectorSubtract( XMLoadFloat3( &Corners[2].f3Position ), vP0 ) );
+        if( XMVectorGetX( XMVector3LengthSq( vNormal ) ) <= 0.0f )
+        {
+            continue;
+        }
+        vNormal = XMVector3Normalize( vNormal );
+
+        // Measure the bulge on the side the vertex normals point to, whatever the winding
+        float fMinCosine = 1.0f;
+        float fSide = ( XMVectorGetX( XMVector3Dot( vNormal, XMLoadFloat3( &Corners[0].f3Normal ) ) ) < 0.0f ) ? -1.0f : 1.0f;
+        vNormal = XMVectorScale( vNormal, fSide );
+        for( UINT c = 0; c < 3; c++ )
+        {
+            fMinCosine = std::min( fMinCosine, XMVectorGetX( XMVector3Dot( vNormal, XMLoadFloat3( &Corners[c].f3Normal ) ) ) );
+        }
+        fMinCosine = std::max( fMinCosine, MIN_NORMAL_COSINE );
+
+        PN_CONTROL_POINTS ControlPoints;
+        if( CPU_TESS_PN_TRIANGLES == Technique )
+        {
+            ComputePNControlPoints( Corners, &ControlPoints );
+        }
+
+        for( UINT uU = 0; uU <= uNumSteps; uU++ )
+        {
+            for( UINT uV = 0; uV <= uNumSteps - uU; uV++ )
+            {
+                float fU = (float)uU / (float)uNumSteps;
+                float fV = (float)uV / (float)uNumSteps;
+                float fW = std::max( 1.0f - fU - fV, 0.0f );
+                XMFLOAT3 f3Position;
+                if( CPU_TESS_PN_TRIANGLES == Technique )
+                {
+                    EvaluatePNTriangle( Corners, &ControlPoints, fU, fV, fW, &f3Position, NULL );
+                }
+                else
+                {
+                    EvaluatePhongTriangle( Corners, fU, fV, fW, &f3Position, NULL );
+                }
+
+                // Height over the plane of the triangle
+                float fBulge = XMVectorGetX( XMVector3Dot( XMVectorSubtract( XMLoadFloat3( &f3Position ), vP0 ), vNormal ) );
+                fMaxBulge = std::max( fMaxBulge, fBulge / fMinCosine );
+                fMaxInset = std::max( fMaxInset, -fBulge / fMinCosine );
+            }
+        }
+    }
+
+    if( NULL != pfMaxInset )
+    {
+        *pfMaxInset = fMaxInset;
+    }
+
+    return fMaxBulge;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CSilhouetteEdgeTree::CSilhouetteEdgeTree() :
+    m_uNumBoundaryEdges( 0 ),
+    m_uNumNonManifoldEdges( 0 )
+{
+}
+
+
+//--------------------------------------------------------------------------------------
+// Welds the vertices by position, finds the edges and their faces and builds the hierarchy
+//--------------------------------------------------------------------------------------
+HRESULT CSilhouetteEdgeTree::Build( const MESH_DATA* pMeshData )
+{
+    assert( NULL != pMeshData );
+
+    m_Positions.clear();
+    m_FacePlanes.clear();
+    m_FaceIndices.clear();
+    m_Edges.clear();
+    m_Nodes.clear();
+    m_uNumBoundaryEdges = 0;
+    m_uNumNonManifoldEdges = 0;
+
+    UINT uNumVertices = (UINT)pMeshData->Vertices.size();
+    if( 0 == uNumVertices || pMeshData->Indices.size() < 3 )
+    {
+        return E_INVALIDARG;
+    }
+
+    // Weld the vertices that only differ by normal or texture coords
+    std::vector<UINT> Order( uNumVertices );
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        Order[v] = v;
+    }
+    SILHOUETTE_POSITION_LESS PositionLess = { &pMeshData->Vertices[0] };
+    std::sort( Order.begin(), Order.end(), PositionLess );
+    std::vector<UINT> Welded( uNumVertices );
+    for( UINT i = 0; i < uNumVertices; i++ )
+    {
+        if( 0 == i || PositionLess( Order[i - 1], Order[i] ) )
+        {
+            m_Positions.push_back( pMeshData->Vertices[Order[i]].f3Position );
+        }
+        Welded[Order[i]] = (UINT)m_Positions.size() - 1;
+    }
+
+    // Face planes, and the edges of the faces as (lower vertex, higher vertex, face) with
+    // the face winding the edge from low to high in the top bit. Degenerate faces are
+    // left out.
+    std::vector< std::pair<UINT64, UINT> > FaceEdges;
+    for( UINT uTriangle = 0; uTriangle < (UINT)pMeshData->Indices.size() / 3; uTriangle++ )
+    {
+        UINT uTri[3];
+        for( UINT c = 0; c < 3; c++ )
+        {
+            uTri[c] = Welded[pMeshData->Indices[uTriangle * 3 + c]];
+        }
+        XMVECTOR vP0 = XMLoadFloat3( &m_Positions[uTri[0]] );
+        XMVECTOR vNormal = XMVector3Cross( XMVectorSubtract( XMLoadFloat3( &m_Positions[uTri[1]] ), vP0 ),
+                                           XMVectorSubtract( XMLoadFloat3( &m_Positions[uTri[2]] ), vP0 ) );
+        if( uTri[0] == uTri[1] || uTri[1] == uTri[2] || uTri[2] == uTri[0] || XMVectorGetX( XMVector3LengthSq( vNormal ) ) <= 0.0f )
+        {
+            continue;
+        }
+
+        // Clockwise from the eye is front facing, and in left handed space the cross
+        // product of a clockwise triangle points at the eye
+        vNormal = XMVector3Normalize( vNormal );
+        UINT uFace = (UINT)m_FacePlanes.size();
+        m_FacePlanes.push_back( XMFLOAT4( XMVectorGetX( vNormal ), XMVectorGetY( vNormal ), XMVectorGetZ( vNormal ),
+                                          -XMVectorGetX( XMVector3Dot( vNormal, vP0 ) ) ) );
+        m_FaceIndices.insert( m_FaceIndices.end(), uTri, uTri + 3 );
+
+        for( UINT c = 0; c < 3; c++ )
+        {
+            UINT uStart = uTri[c], uEnd = uTri[( c + 1 ) % 3];
+            UINT64 uKey = ( (UINT64)std::min( uStart, uEnd ) << 32 ) | std::max( uStart, uEnd );
+            FaceEdges.push_back( std::make_pair( uKey, uFace | ( ( uStart < uEnd ) ? 0x80000000 : 0 ) ) );
+        }
+    }
+    std::sort( FaceEdges.begin(), FaceEdges.end() );
+
+    for( UINT i = 0; i < (UINT)FaceEdges.size(); )
+    {
+        UINT uCount = 1;
+        while( i + uCount < (UINT)FaceEdges.size() && FaceEdges[i + uCount].first == FaceEdges[i].first )
+        {
+            uCount++;
+        }
+
+        // Non-manifold edges keep their first two faces
+        UINT uLow = (UINT)( FaceEdges[i].first >> 32 ), uHigh = (UINT)( FaceEdges[i].first & 0xffffffff );
+        bool bLowToHigh = 0 != ( FaceEdges[i].second & 0x80000000 );
+        EDGE Edge;
+        Edge.uVertex[0] = bLowToHigh ? uLow : uHigh;
+        Edge.uVertex[1] = bLowToHigh ? uHigh : uLow;
+        Edge.uFace[0] = FaceEdges[i].second & 0x7fffffff;
+        Edge.uFace[1] = ( uCount > 1 ) ? ( FaceEdges[i + 1].second & 0x7fffffff ) : UINT_MAX;
+        m_Edges.push_back( Edge );
+        m_uNumBoundaryEdges += ( 1 == uCount ) ? 1 : 0;
+        m_uNumNonManifoldEdges += ( uCount > 2 ) ? 1 : 0;
+
+        i += uCount;
+    }
+    if( m_Edges.empty() )
+    {
+        return E_INVALIDARG;
+    }
+
+    // Split keys of the edges: the midpoint over the bounds diagonal, and the mean normal
+    // of the faces
+    float fDiagonal = std::max( GetMeshDataBoundsDiagonal( pMeshData ), FLT_MIN );
+    UINT uNumEdges = (UINT)m_Edges.size();
+    std::vector<float> Keys( uNumEdges * 6 );
+    for( UINT uEdge = 0; uEdge < uNumEdges; uEdge++ )
+    {
+        const EDGE& Edge = m_Edges[uEdge];
+        XMVECTOR vMid = XMVectorScale( XMVectorAdd( XMLoadFloat3( &m_Positions[Edge.uVertex[0]] ), XMLoadFloat3( &m_Positions[Edge.uVertex[1]] ) ),
+                                       0.5f / fDiagonal );
+        XMVECTOR vNormal = XMLoadFloat4( &m_FacePlanes[Edge.uFace[0]] );
+        if( UINT_MAX != Edge.uFace[1] )
+        {
+            vNormal = XMVectorAdd( vNormal, XMLoadFloat4( &m_FacePlanes[Edge.uFace[1]] ) );
+        }
+        vNormal = XMVectorScale( XMVector3Normalize( vNormal ), SILHOUETTE_NORMAL_WEIGHT );
+        XMStoreFloat3( (XMFLOAT3*)&Keys[uEdge * 6], vMid );
+        XMStoreFloat3( (XMFLOAT3*)&Keys[uEdge * 6 + 3], vNormal );
+    }
+
+    // Split the nodes at the median of the key axis they spread most along, breadth first
+    std::vector<UINT> EdgeOrder( uNumEdges );
+    for( UINT uEdge = 0; uEdge < uNumEdges; uEdge++ )
+    {
+        EdgeOrder[uEdge] = uEdge;
+    }
+    NODE Root;
+    ZeroMemory( &Root, sizeof( Root ) );
+    Root.uNumEdges = uNumEdges;
+    m_Nodes.push_back( Root );
+    for( UINT uNode = 0; uNode < (UINT)m_Nodes.size(); uNode++ )
+    {
+        UINT uFirst = m_Nodes[uNode].uFirstEdge, uCount = m_Nodes[uNode].uNumEdges;
+        if( uCount <= SILHOUETTE_LEAF_EDGES )
+        {
+            continue;
+        }
+
+        float fMin[6], fMax[6];
+        for( UINT uAxis = 0; uAxis < 6; uAxis++ )
+        {
+            fMin[uAxis] = FLT_MAX;
+            fMax[uAxis] = -FLT_MAX;
+        }
+        for( UINT i = uFirst; i < uFirst + uCount; i++ )
+        {
+            for( UINT uAxis = 0; uAxis < 6; uAxis++ )
+            {
+                fMin[uAxis] = std::min( fMin[uAxis], Keys[EdgeOrder[i] * 6 + uAxis] );
+                fMax[uAxis] = std::max( fMax[uAxis], Keys[EdgeOrder[i] * 6 + uAxis] );
+            }
+        }
+        UINT uSplitAxis = 0;
+        for( UINT uAxis = 1; uAxis < 6; uAxis++ )
+        {
+            uSplitAxis = ( fMax[uAxis] - fMin[uAxis] > fMax[uSplitAxis] - fMin[uSplitAxis] ) ? uAxis : uSplitAxis;
+        }
+
+        SILHOUETTE_KEY_LESS KeyLess = { &Keys[0], uSplitAxis };
+        UINT uHalf = uCount / 2;
+        std::nth_element( EdgeOrder.begin() + uFirst, EdgeOrder.begin() + uFirst + uHalf, EdgeOrder.begin() + uFirst + uCount, KeyLess );
+
+        NODE Child;
+        ZeroMemory( &Child, sizeof( Child ) );
+        m_Nodes[uNode].uFirstChild = (UINT)m_Nodes.size();
+        Child.uFirstEdge = uFirst;
+        Child.uNumEdges = uHalf;
+        m_Nodes.push_back( Child );
+        Child.uFirstEdge = uFirst + uHalf;
+        Child.uNumEdges = uCount - uHalf;
+        m_Nodes.push_back( Child );
+    }
+
+    std::vector<EDGE> SortedEdges( uNumEdges );
+    for( UINT i = 0; i < uNumEdges; i++ )
+    {
+        SortedEdges[i] = m_Edges[EdgeOrder[i]];
+    }
+    m_Edges.swap( SortedEdges );
+
+    // Renumber the faces in the order the edges reach them, so the faces of a leaf are
+    // close in memory
+    UINT uNumFaces = (UINT)m_FacePlanes.size();
+    std::vector<UINT> NewFace( uNumFaces, UINT_MAX );
+    std::vector<XMFLOAT4> SortedPlanes;
+    std::vector<UINT> SortedIndices;
+    SortedPlanes.reserve( uNumFaces );
+    SortedIndices.reserve( uNumFaces * 3 );
+    for( UINT uEdge = 0; uEdge < uNumEdges; uEdge++ )
+    {
+        for( UINT f = 0; f < 2 && UINT_MAX != m_Edges[uEdge].uFace[f]; f++ )
+        {
+            UINT& uFace = m_Edges[uEdge].uFace[f];
+            if( UINT_MAX == NewFace[uFace] )
+            {
+                NewFace[uFace] = (UINT)SortedPlanes.size();
+                SortedPlanes.push_back( m_FacePlanes[uFace] );
+                SortedIndices.insert( SortedIndices.end(), m_FaceIndices.begin() + uFace * 3, m_FaceIndices.begin() + uFace * 3 + 3 );
+            }
+            uFace = NewFace[uFace];
+        }
+    }
+    m_FacePlanes.swap( SortedPlanes );
+    m_FaceIndices.swap( SortedIndices );
+
+    for( UINT uNode = 0; uNode < (UINT)m_Nodes.size(); uNode++ )
+    {
+        BoundNode( &m_Nodes[uNode] );
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Bounds the faces of the edges of a node by a sphere, and their normals by a cone
+//--------------------------------------------------------------------------------------
+void CSilhouetteEdgeTree::BoundNode( NODE* pNode ) const
+{
+    XMVECTOR vMin = XMVectorReplicate( FLT_MAX );
+    XMVECTOR vMax = XMVectorReplicate( -FLT_MAX );
+    XMVECTOR vAxis = XMVectorZero();
+    pNode->uNumBoundaryEdges = 0;
+    for( UINT uEdge = pNode->uFirstEdge; uEdge < pNode->uFirstEdge + pNode->uNumEdges; uEdge++ )
+    {
+        const EDGE& Edge = m_Edges[uEdge];
+        vAxis = XMVectorAdd( vAxis, XMLoadFloat3( (const XMFLOAT3*)&m_FacePlanes[Edge.uFace[0]] ) );
+        if( UINT_MAX != Edge.uFace[1] )
+        {
+            vAxis = XMVectorAdd( vAxis, XMLoadFloat3( (const XMFLOAT3*)&m_FacePlanes[Edge.uFace[1]] ) );
+        }
+        pNode->uNumBoundaryEdges += ( UINT_MAX == Edge.uFace[1] ) ? 1 : 0;
+    }
+
+    XMVECTOR vCenter = XMVectorZero();
+    float fAxisLength = XMVectorGetX( XMVector3Length( vAxis ) );
+    vAxis = ( fAxisLength > 0.0f ) ? XMVectorScale( vAxis, 1.0f / fAxisLength ) : vAxis;
+    for( UINT uPass = 0; uPass < 2; uPass++ )
+    {
+        // The faces reach past the edges, so the sphere is around their corners
+        float fRadiusSq = 0.0f;
+        float fMinCosine = 1.0f;
+        for( UINT uEdge = pNode->uFirstEdge; uEdge < pNode->uFirstEdge + pNode->uNumEdges; uEdge++ )
+        {
+            const EDGE& Edge = m_Edges[uEdge];
+            for( UINT f = 0; f < 2 && UINT_MAX != Edge.uFace[f]; f++ )
+            {
+                const UINT* pTri = &m_FaceIndices[Edge.uFace[f] * 3];
+                for( UINT c = 0; c < 3; c++ )
+                {
+                    XMVECTOR vPosition = XMLoadFloat3( &m_Positions[pTri[c]] );
+                    if( 0 == uPass )
+                    {
+                        vMin = XMVectorMin( vMin, vPosition );
+                        vMax = XMVectorMax( vMax, vPosition );
+                    }
+                    else
+                    {
+                        fRadiusSq = std::max( fRadiusSq, XMVectorGetX( XMVector3LengthSq( XMVectorSubtract( vPosition, vCenter ) ) ) );
+                    }
+                }
+                XMVECTOR vNormal = XMLoadFloat3( (const XMFLOAT3*)&m_FacePlanes[Edge.uFace[f]] );
+                fMinCosine = std::min( fMinCosine, XMVectorGetX( XMVector3Dot( vAxis, vNormal ) ) );
+            }
+        }
+
+        if( 0 == uPass )
+        {
+            vCenter = XMVectorScale( XMVectorAdd( vMin, vMax ), 0.5f );
+        }
+        else
+        {
+            XMStoreFloat3( &pNode->f3Center, vCenter );
+            pNode->fRadius = sqrtf( fRadiusSq );
+            XMStoreFloat3( &pNode->f3ConeAxis, vAxis );
+            pNode->fConeCosine = ( fAxisLength > 0.0f ) ? std::max( std::min( fMinCosine, 1.0f ), -1.0f ) : -1.0f;
+            pNode->fConeSine = sqrtf( 1.0f - pNode->fConeCosine * pNode->fConeCosine );
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Appends the silhouette edges among a run of edges, returns how many
+//--------------------------------------------------------------------------------------
+UINT CSilhouetteEdgeTree::TestEdges( UINT uFirstEdge, UINT uNumEdges, const XMFLOAT3& f3Eye, std::vector<XMFLOAT3>* pSegments ) const
+{
+    UINT uNumSilhouetteEdges = 0;
+    for( UINT uEdge = uFirstEdge; uEdge < uFirstEdge + uNumEdges; uEdge++ )
+    {
+        const EDGE& Edge = m_Edges[uEdge];
+        const XMFLOAT4& f4Plane0 = m_FacePlanes[Edge.uFace[0]];
+        bool bFront0 = f4Plane0.x * f3Eye.x + f4Plane0.y * f3Eye.y + f4Plane0.z * f3Eye.z + f4Plane0.w > 0.0f;
+        bool bFront1 = false;
+        if( UINT_MAX != Edge.uFace[1] )
+        {
+            const XMFLOAT4& f4Plane1 = m_FacePlanes[Edge.uFace[1]];
+            bFront1 = f4Plane1.x * f3Eye.x + f4Plane1.y * f3Eye.y + f4Plane1.z * f3Eye.z + f4Plane1.w > 0.0f;
+        }
+        if( bFront0 == bFront1 )
+        {
+            continue;
+        }
+
+        // Face 1 winds the edge the other way
+        pSegments->push_back( m_Positions[Edge.uVertex[bFront0 ? 0 : 1]] );
+        pSegments->push_back( m_Positions[Edge.uVertex[bFront0 ? 1 : 0]] );
+        uNumSilhouetteEdges++;
+    }
+
+    return uNumSilhouetteEdges;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Descends the clusters whose faces may both face the eye and face away
+//--------------------------------------------------------------------------------------
+void CSilhouetteEdgeTree::Extract( FXMVECTOR vEye, std::vector<XMFLOAT3>* pSegments, SILHOUETTE_STATS* pStats ) const
+{
+    assert( NULL != pSegments );
+
+    SILHOUETTE_STATS Stats;
+    ZeroMemory( &Stats, sizeof( Stats ) );
+    if( m_Nodes.empty() )
+    {
+        if( NULL != pStats )
+        {
+            *pStats = Stats;
+        }
+        return;
+    }
+
+    XMFLOAT3 f3Eye;
+    XMStoreFloat3( &f3Eye, vEye );
+
+    UINT uStack[SILHOUETTE_MAX_DEPTH + 1];
+    UINT uStackSize = 0;
+    uStack[uStackSize++] = 0;
+    while( uStackSize > 0 )
+    {
+        const NODE& Node = m_Nodes[uStack[--uStackSize]];
+        Stats.uNumNodesVisited++;
+
+        // The directions from the faces to the eye are within the angle s of the direction
+        // from the center, and the normals within the cone angle a of the axis, so all the
+        // faces face the same way when the angle t of the axis to the eye keeps a + s clear
+        // of a right angle: cos( t ) > sin( a + s ) all front, cos( t ) < -sin( a + s ) all
+        // back, with a + s under a right angle
+        XMVECTOR vToEye = XMVectorSubtract( vEye, XMLoadFloat3( &Node.f3Center ) );
+        float fDistanceSq = XMVectorGetX( XMVector3LengthSq( vToEye ) );
+        if( fDistanceSq > Node.fRadius * Node.fRadius )
+        {
+            float fInvDistance = 1.0f / sqrtf( fDistanceSq );
+            float fSineS = Node.fRadius * fInvDistance;
+            float fCosineS = sqrtf( 1.0f - fSineS * fSineS );
+            float fCosineSpread = Node.fConeCosine * fCosineS - Node.fConeSine * fSineS;
+            float fSineSpread = Node.fConeSine * fCosineS + Node.fConeCosine * fSineS + SILHOUETTE_ANGLE_EPSILON;
+            float fCosine = XMVectorGetX( XMVector3Dot( XMLoadFloat3( &Node.f3ConeAxis ), vToEye ) ) * fInvDistance;
+            if( fCosineSpread > 0.0f && fCosine < -fSineSpread )
+            {
+                // All back facing
+                continue;
+            }
+            if( fCosineSpread > 0.0f && fCosine > fSineSpread && 0 == Node.uNumBoundaryEdges )
+            {
+                // All front facing, and no boundary to show
+                continue;
+            }
+        }
+
+        if( 0 == Node.uFirstChild )
+        {
+            Stats.uNumEdgesTested += Node.uNumEdges;
+            Stats.uNumSilhouetteEdges += TestEdges( Node.uFirstEdge, Node.uNumEdges, f3Eye, pSegments );
+        }
+        else
+        {
+            assert( uStackSize + 2 <= SILHOUETTE_MAX_DEPTH + 1 );
+            uStack[uStackSize++] = Node.uFirstChild + 1;
+            uStack[uStackSize++] = Node.uFirstChild;
+        }
+    }
+
+    if( NULL != pStats )
+    {
+        *pStats = Stats;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Tests every edge, as the reference for Extract
+//--------------------------------------------------------------------------------------
+void CSilhouetteEdgeTree::ExtractAll( FXMVECTOR vEye, std::vector<XMFLOAT3>* pSegments, SILHOUETTE_STATS* pStats ) const
+{
+    assert( NULL != pSegments );
+
+    XMFLOAT3 f3Eye;
+    XMStoreFloat3( &f3Eye, vEye );
+    UINT uNumSilhouetteEdges = TestEdges( 0, (UINT)m_Edges.size(), f3Eye, pSegments );
+
+    if( NULL != pStats )
+    {
+        pStats->uNumNodesVisited = 0;
+        pStats->uNumEdgesTested = (UINT)m_Edges.size();
+        pStats->uNumSilhouetteEdges = uNumSilhouetteEdges;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
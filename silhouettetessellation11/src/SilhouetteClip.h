@@ -0,0 +1,127 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: SilhouetteClip.h
+//
+// Silhouette clipping, a fallback for parts without hardware tessellation. The coarse mesh
+// is drawn without tessellation, pushed out along its normals so it covers the refined
+// surface, and clipped in the stencil buffer to the outline of a detailed mesh: the
+// PN-Triangles surface baked on the CPU. Each view the silhouette edges of the detailed
+// mesh are found by descending a hierarchy of edge clusters, skipping the clusters whose
+// faces all face the eye or all face away, from the normal cone and bounding sphere of
+// the faces. The edges are oriented as their front facing face winds them, so a fan of
+// triangles from any point to the edges counts the front facing layers over each pixel,
+// with two sided stencil increments and decrements.
+//--------------------------------------------------------------------------------------
+#ifndef SILHOUETTE_CLIP_H
+#define SILHOUETTE_CLIP_H
+
+#include "MeshData.h"
+#include "CPUTessellation.h"
+
+// Uniform tess factor the detailed mesh is baked with
+static const float SILHOUETTE_TESS_FACTOR = 8.0f;
+
+// Most edges in a leaf of the hierarchy
+static const UINT SILHOUETTE_LEAF_EDGES = 32;
+
+struct SILHOUETTE_STATS
+{
+    UINT    uNumNodesVisited;
+    UINT    uNumEdgesTested;
+    UINT    uNumSilhouetteEdges;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Returns how far the coarse mesh has to be pushed out along its vertex normals to cover
+// the patches of the technique, from the bulge of the patches over their triangle at the
+// domain points of fTessFactor. Approximate where the vertex normals are far from the
+// face normals. pfMaxInset, if given, receives how far it has to be pushed in to be
+// covered by the patches that curve in behind their triangle.
+//--------------------------------------------------------------------------------------
+float GetMaxPatchBulge( const MESH_DATA* pMeshData, CPU_TESS_TECHNIQUE Technique, float fTessFactor, float* pfMaxInset = NULL );
+
+
+//--------------------------------------------------------------------------------------
+// The edges of a mesh, welded by position, in a hierarchy of clusters by position and
+// normal for finding its silhouette from any eye point
+//--------------------------------------------------------------------------------------
+class CSilhouetteEdgeTree
+{
+public:
+
+    CSilhouetteEdgeTree();
+
+    HRESULT Build( const MESH_DATA* pMeshData );
+
+    UINT GetNumEdges() const { return (UINT)m_Edges.size(); }
+    UINT GetNumBoundaryEdges() const { return m_uNumBoundaryEdges; }
+    UINT GetNumNonManifoldEdges() const { return m_uNumNonManifoldEdges; }
+    UINT GetNumNodes() const { return (UINT)m_Nodes.size(); }
+
+    // Appends the silhouette edges seen from vEye, in the space of the mesh, to pSegments
+    // as pairs of positions in the order their front facing face winds them. Boundary
+    // edges are silhouette edges when their face is front facing. pStats may be NULL.
+    void Extract( DirectX::FXMVECTOR vEye, std::vector<DirectX::XMFLOAT3>* pSegments, SILHOUETTE_STATS* pStats ) const;
+
+    // The same, testing every edge
+    void ExtractAll( DirectX::FXMVECTOR vEye, std::vector<DirectX::XMFLOAT3>* pSegments, SILHOUETTE_STATS* pStats ) const;
+
+private:
+
+    // The vertices are in the order face 0 winds them, uFace[1] is UINT_MAX on the boundary
+    struct EDGE
+    {
+        UINT    uVertex[2];
+        UINT    uFace[2];
+    };
+
+    // The edges of a node are consecutive, the children of a node too. The sphere bounds
+    // the faces of the edges, and the cone their normals.
+    struct NODE
+    {
+        DirectX::XMFLOAT3   f3Center;
+        float               fRadius;
+        DirectX::XMFLOAT3   f3ConeAxis;
+        float               fConeCosine;    // Of the half angle, -1 if unbounded
+        float               fConeSine;
+        UINT                uFirstEdge;
+        UINT                uNumEdges;
+        UINT                uNumBoundaryEdges;
+        UINT                uFirstChild;    // 0 for leaves
+    };
+
+    void BoundNode( NODE* pNode ) const;
+    UINT TestEdges( UINT uFirstEdge, UINT uNumEdges, const DirectX::XMFLOAT3& f3Eye, std::vector<DirectX::XMFLOAT3>* pSegments ) const;
+
+    std::vector<DirectX::XMFLOAT3>  m_Positions;
+    std::vector<DirectX::XMFLOAT4>  m_FacePlanes;   // Front facing from e with dot( xyz, e ) + w > 0
+    std::vector<UINT>               m_FaceIndices;  // 3 per face plane
+    std::vector<EDGE>               m_Edges;
+    std::vector<NODE>               m_Nodes;
+    UINT                            m_uNumBoundaryEdges;
+    UINT                            m_uNumNonManifoldEdges;
+};
+
+#endif
@@ -42,7 +42,25 @@
 
 // Project includes
 #include "resource.h"
+#include "VisibilityStage.h"
+#include "OcclusionBuffer.h"
+#include "WorldSpaceVertices.h"
+#include "TessFactors.h"
+#include "TessPolicy.h"
+#include "DynamicResolution.h"
+#include "CameraMotion.h"
+#include "MultiViewFactors.h"
+#include "TessPath.h"
+#include "InstanceSet.h"
+#include "MeshBake.h"
+#include "SilhouetteClip.h"
+#include "ProgressiveMesh.h"
+#include "ClusterDAG.h"
+#include "ShaderPermutations.h"
 #include <map>
+#include <algorithm>
+#include <float.h>
+#include <Shlwapi.h>
 
 #pragma warning(disable: 4100)
 
@@ -73,24 +91,6 @@ typedef enum _TESSELLATION_COMBO_METHOD_TYPE
 	TESSELLATION_COMBO_PHONG_TESSELLATION = 2
 }TESSELLATION_COMBO_METHOD_TYPE;
 
-typedef enum _TESSELLATION_SETTING_TYPE
-{
-    // enables tessellation factors based on:
-    SS_ADAPT        = 1,    // an ideat primitive size
-	DIST_ADAPT      = 2,    // distance
-	RES_ADAPT       = 4,    // screen resolution
-	ORIENT_ADAPT    = 8,    // orientation with respect to the viewing vector
-
-    // culling type
-	BF_CULL         = 32,   // use back face culling
-	FRUST_CULL      = 64,   // use view frustum culling
-
-    // select tessellation technique
-	PHONG           = 128,  // use phong 
-	PNTRI           = 256,  // use PN triangles 
-}
-TESSELLATION_SETTING_TYPE;
-
 CDXUTDialogResourceManager  g_DialogResourceManager;    // Manager for shared resources of dialogs
 CFirstPersonCamera          g_Camera;    // A model viewing camera for each mesh scene
 CDXUTDirectionWidget        g_Light;                    // Dynamic Light
@@ -111,14 +111,40 @@ ID3D11SamplerState*         g_pSampleLinear = NULL;
 // Shaders
 ID3D11VertexShader*         g_pSceneVS = NULL;
 ID3D11VertexShader*         g_pSceneWithTessellationVS = NULL;
+ID3D11VertexShader*         g_pSceneWorldSpaceVS = NULL;
+ID3D11VertexShader*         g_pSceneWorldSpaceTessellationVS = NULL;
+ID3D11VertexShader*         g_pSceneInstancedVS = NULL;
+ID3D11VertexShader*         g_pSceneInstancedTessellationVS = NULL;
+ID3D11VertexShader*         g_pSceneSilhouetteClipVS = NULL;
 
 DWORD HullShaderHash = 0;
 std::map<DWORD, ID3D11HullShader*> g_HullShaders;
 std::map<DWORD, ID3D11DomainShader*> g_DomainShaders;
 
+// Optional permutation bits whose HS/DS permutations have been added to the shader cache.
+// Each multiplies the permutation count, so a family is only compiled once it is first used
+static const DWORD OPTIONAL_PERMUTATION_FLAGS = FOVEA_ADAPT | MOTION_ADAPT | MULTI_VIEW | DEPTH_ONLY;
+static DWORD g_dwCachedOptionalFlags = 0;
+
+// Set once the shader cache has created the shaders. The scene is still drawn, with the
+// permutations that are ready, while it compiles those of an optional family.
+static bool g_bSceneShadersCreated = false;
+
+// With -lazyshaders the shader cache only compiles the base shaders, and the hull and domain
+// shader permutations are compiled on demand, the selected one first. The maps still hold a
+// NULL entry for each permutation that can be compiled. The permutations compiled on demand
+// are not recompiled when the source changes. By default the shader cache compiles them all.
+static bool g_bLazyShaders = false;
+static WCHAR g_szPermutationSourceFile[MAX_PATH];   // Found where the shader cache looks
+static CShaderPermutations g_ShaderPermutations;
+static DWORD g_dwDrawnHullShaderHash = 0;   // Lags HullShaderHash until its permutation is ready
+
 ID3D11DomainShader*         g_pPNTrianglesDS	= NULL;
 ID3D11PixelShader*          g_pScenePS			= NULL;
 ID3D11PixelShader*          g_pTexturedScenePS	= NULL;
+ID3D11VertexShader*         g_pFullScreenVS     = NULL;
+ID3D11PixelShader*          g_pUpscalePS        = NULL;
+ID3D11GeometryShader*       g_pMultiViewGS      = NULL;
 
 //--------------------------------------------------------------------------------------
 // Constant buffers
@@ -150,6 +176,26 @@ struct CB_PNTRIANGLES
 	float fGUIViewFrustrumEpsilon;
 
     DirectX::XMFLOAT4 f4ViewFrustumPlanes[4]; // View frustum planes
+
+    DirectX::XMFLOAT4 f4Fovea;                // Focus point, inner and outer radius in pixels
+    float fGUIFoveaPeripheryScale;
+    float fResolutionReference[2];            // Screen size the resolution adaptive scale reaches 1 at
+    float fPadding;
+
+    DirectX::XMFLOAT4 f4Upscale;              // Back buffer width and height, scene width and height
+
+    DirectX::XMMATRIX f4x4PrevViewProjection; // View * Projection matrix the camera motion is measured from
+    DirectX::XMFLOAT4 f4Motion;               // Threshold and full velocity in pixels, min scale
+
+    // Views of a MULTI_VIEW pass
+    DirectX::XMMATRIX f4x4MultiViewProjection[TESS_MAX_VIEWS];
+    DirectX::XMFLOAT4 f4MultiViewEye[TESS_MAX_VIEWS];
+    DirectX::XMFLOAT4 f4MultiViewVector[TESS_MAX_VIEWS];
+    DirectX::XMFLOAT4 f4MultiViewFrustumPlanes[TESS_MAX_VIEWS * 4];
+    UINT uNumViews;
+    UINT uFirstInstance;                      // Of the bin drawn, in the instance world matrices
+    float fSilhouetteInflation;               // Distance the coarse mesh is pushed out along its normals
+    UINT uPadding[1];
 };
 
 // slot where to bind the constant buffers
@@ -161,6 +207,9 @@ static ID3D11Buffer*    g_pcbPNTriangles = NULL;
 // State objects
 ID3D11RasterizerState*   g_pRasterizerStateWireframe = NULL;
 ID3D11RasterizerState*   g_pRasterizerStateSolid = NULL;
+ID3D11DepthStencilState* g_pDepthStencilStateLessEqual = NULL;  // Colour pass after the depth pre-pass
+ID3D11DepthStencilState* g_pDepthStencilStateSilhouetteFans = NULL;  // Counts the front facing layers in the stencil
+ID3D11DepthStencilState* g_pDepthStencilStateSilhouetteClip = NULL;  // Draws where the stencil is not 0
 
 // User supplied data
 static bool g_bUserMesh = false;
@@ -181,12 +230,157 @@ static float g_fRangeScale = 1.0f;
 // Edge scale (for screen space adaptive tessellation)
 static unsigned int g_uEdgeSize = 16; 
 
+// Foveated adaptive tessellation: the focus point as a fraction of the screen, moved with
+// the mouse while F is held, and the radii as fractions of the screen height
+static DirectX::XMFLOAT2 g_f2FoveaFocus( 0.5f, 0.5f );
+static float g_fFoveaInnerRadius = TESS_FOVEA_INNER_RADIUS;
+static float g_fFoveaOuterRadius = TESS_FOVEA_OUTER_RADIUS;
+static float g_fFoveaPeripheryScale = TESS_FOVEA_PERIPHERY_SCALE;
+
+// Motion adaptive tessellation: the threshold is in pixels per 60Hz frame. The camera path
+// is recorded while R is toggled on, relative to the bounds of the mesh.
+static CCameraMotion g_CameraMotion;
+static float g_fMotionThreshold = TESS_MOTION_THRESHOLD;
+static float g_fMotionMinScale = TESS_MOTION_MIN_SCALE;
+static bool g_bRecordCameraPath = false;
+static float g_fCameraPathSeconds = 0.0f;
+static std::vector<CAMERA_PATH_FRAME> g_CameraPath;
+
+// Stereo: the eyes are this fraction of the distance to the look at point apart
+static const float STEREO_EYE_SEPARATION = 0.05f;
+
 // Edge scale (for screen space adaptive tessellation)
 static float g_fResolutionScale = 1.0f; 
 
 // View frustum culling epsilon
 static float g_fViewFrustumCullEpsilon = 0.5f;
 
+// Dynamic resolution: the scene is rendered to the top left of g_pSceneColor at the scale
+// the controller picks for the target GPU time, and upscaled to the back buffer
+static float g_fDynamicResolutionTargetMs = 1000.0f / 60.0f;
+static CDynamicResolutionController g_DynamicResolution;
+static ID3D11Texture2D* g_pSceneColor = NULL;
+static ID3D11RenderTargetView* g_pSceneColorRTV = NULL;
+static ID3D11ShaderResourceView* g_pSceneColorSRV = NULL;
+
+// Runs of triangles of one subset, consecutive in g_VisibilityItems
+struct VISIBILITY_ITEM_RANGE
+{
+    UINT uFirstItem;
+    UINT uNumItems;     // 0 if the subset has no runs
+};
+
+// CPU visibility of runs of triangles, computed a frame ahead on a worker thread
+static const UINT VISIBILITY_ITEM_TRIANGLES = 64;
+static CVisibilityStage g_VisibilityStage;
+static std::vector<VISIBILITY_ITEM> g_VisibilityItems;
+static std::vector< std::vector<VISIBILITY_ITEM_RANGE> > g_VisibilityItemRanges;   // [uMesh][uSubset]
+static int g_iVisibilityMeshType = -1;      // Mesh the items were built for, -1 if none
+static VISIBILITY_STATS g_VisibilityStats;
+
+// Occlusion culling of the runs in the frustum: the runs largest on screen are rasterized
+// into a software depth buffer, up to a triangle budget, and the runs behind them culled
+static const UINT OCCLUSION_BUFFER_WIDTH = 320;
+static const UINT OCCLUSION_OCCLUDER_TRIANGLES = 8192;
+static const float OCCLUSION_INSET_TESS_FACTOR = 8.0f;     // Domain points the inset is measured at
+static COcclusionBuffer g_OcclusionBuffer;
+static UINT g_uOcclusionBufferHeight = 0;  // Requested, the buffer rounds it up to whole tiles
+static std::vector<DirectX::XMFLOAT3> g_OccluderPositions;     // World space, as the item bounds
+static std::vector<UINT> g_OccluderIndices;
+static std::vector<UINT> g_VisibilityItemFirstIndex;            // Of each item in g_OccluderIndices
+static std::vector< std::pair<float, UINT> > g_OccluderCandidates;
+static std::vector<BYTE> g_OcclusionVisible;
+
+// Occlusion culling of the last frame
+struct OCCLUSION_CULL_STATS
+{
+    UINT    uNumOccluderTriangles;
+    UINT    uNumCulledItems;        // In the frustum but hidden
+    UINT    uNumCulledPatches;
+    double  fMs;
+};
+static OCCLUSION_CULL_STATS g_OcclusionCullStats;
+
+// World space copies of the vertices of each mesh, transformed again when its matrix changes
+static CWorldSpaceVertices g_WorldSpaceVertices[MESH_TYPE_MAX];
+static CNumaTaskPool g_WorldSpacePool;
+
+// Per material tessellation policies of each mesh, from the sidecar next to the sdkmesh
+static CTessPolicyTable g_TessPolicies[MESH_TYPE_MAX];
+
+// Tessellated or plain path of each mesh of the sdkmesh, by its size on screen
+static CTessPathSelector g_TessPathSelector;
+static int g_iTessPathMeshType = -1;        // Mesh the paths were chosen for, -1 if none
+
+// Copies of the mesh on a grid, culled and binned by tess factor tier on the CPU, and drawn
+// with one instanced draw per bin from the world matrices of the visible ones
+static CInstanceSet g_InstanceSet;
+static int g_iInstanceMeshType = -1;        // Mesh the grid was placed for, -1 if none
+static INSTANCE_BINS g_InstanceBins;
+static ID3D11Buffer* g_pInstanceWorldBuffer = NULL;
+static ID3D11ShaderResourceView* g_pInstanceWorldSRV = NULL;
+
+// Silhouette clipping: without tessellation the coarse mesh, pushed out along its normals
+// to cover the PN-Triangles surface, is only drawn inside the silhouette of a detailed mesh
+// baked on the CPU. The silhouette edges are found from the eye each frame, and drawn as
+// fans to the stencil (see SilhouetteClip.h).
+static CSilhouetteEdgeTree g_SilhouetteTree;
+static int g_iSilhouetteMeshType = -1;      // Mesh the tree was built for, -1 if none
+static bool g_bSilhouetteTreeBuilt = false;
+static float g_fSilhouetteInflation = 0.0f;
+static DirectX::XMFLOAT3 g_f3SilhouetteFanOrigin;
+static std::vector<DirectX::XMFLOAT3> g_SilhouetteSegments;
+static SILHOUETTE_STATS g_SilhouetteStats;
+static ID3D11Buffer* g_pSilhouetteFanVB = NULL;
+static UINT g_uSilhouetteFanVBSize = 0;     // In vertices
+
+// Progressive mesh: without tessellation the PN-Triangles surface baked on the CPU and
+// simplified into a vertex hierarchy is refined for the view each frame, and drawn in
+// place of the subsets (see ProgressiveMesh.h). It is read from <mesh>.progmesh, stored
+// by the headless progmesh tool, or built on first use.
+static CProgressiveMesh g_ProgressiveMesh[MESH_TYPE_MAX];
+static bool g_bProgressiveMeshTried[MESH_TYPE_MAX];
+static WCHAR g_szMeshFileNames[MESH_TYPE_MAX][MAX_PATH];
+static PM_UPDATE_STATS g_ProgressiveMeshStats;
+
+// Cluster LOD: without tessellation the clusters of the DAG of the PN-Triangles surface
+// that meet the screen error are selected each frame and drawn in place of the subsets
+// (see ClusterDAG.h). The DAG is read from <mesh>.clusterlod, stored by the headless
+// clusterlod tool, or built on first use.
+static CClusterDAG g_ClusterDAG[MESH_TYPE_MAX];
+static bool g_bClusterDAGTried[MESH_TYPE_MAX];
+static std::vector<UINT> g_ClusterCut;
+static CLUSTER_CUT_STATS g_ClusterCutStats;
+
+// What the passes over the tess policies of a frame draw with, set up by OnD3D11FrameRender
+struct SCENE_PASS_STATE
+{
+    CB_PNTRIANGLES*             pPNTrianglesCB;
+    const DirectX::XMMATRIX*    pWorld;
+    const DirectX::XMMATRIX*    pEyeViewProjections;    // Of the two eyes in stereo
+    const D3D11_VIEWPORT*       pEyeViewports;
+    ID3D11PixelShader*          pPS;                    // Of the colour pass
+    const BYTE*                 pVisible;               // Runs of triangles culled on the CPU, NULL if none
+    UINT                        uDiffuseSlot;
+    bool                        bTessellation;
+    bool                        bStereo;
+    bool                        bWorldSpace;
+    bool                        bInstanced;
+    bool                        bHybridPath;
+    bool                        bSilhouetteClip;
+    bool                        bDepthPrePass;
+    float                       fBoundTessFactor;       // In the constant buffer, -1 until the first pass sets it
+};
+
+// Batches of the last depth pre-pass. Those whose DEPTH_ONLY permutation is not compiled
+// yet are only drawn by the colour pass.
+struct DEPTH_PREPASS_STATS
+{
+    UINT    uNumBatches;
+    UINT    uNumLeftToColorPass;
+};
+static DEPTH_PREPASS_STATS g_DepthPrePassStats;
+
 //--------------------------------------------------------------------------------------
 // AMD helper classes defined here
 //--------------------------------------------------------------------------------------
@@ -237,8 +431,49 @@ enum
      IDC_STATIC_RENDER_SETTINGS              ,
      IDC_STATIC_VIEW_FRUSTUM_CULL_EPSILON    ,
      IDC_SLIDER_VIEW_FRUSTUM_CULL_EPSILON    ,
+     IDC_CHECKBOX_PACKED_CONTROL_POINTS      ,
+     IDC_CHECKBOX_CPU_VISIBILITY             ,
+     IDC_CHECKBOX_PIPELINED_VISIBILITY       ,
+     IDC_CHECKBOX_OCCLUSION_CULL             ,
+     IDC_CHECKBOX_WORLD_SPACE_VERTICES       ,
+     IDC_CHECKBOX_STEREO                     ,
+     IDC_CHECKBOX_DEPTH_PREPASS              ,
+     IDC_CHECKBOX_HYBRID_PATH                ,
+     IDC_CHECKBOX_INSTANCES                  ,
+     IDC_CHECKBOX_SILHOUETTE_CLIP            ,
+     IDC_CHECKBOX_PROGRESSIVE_MESH           ,
+     IDC_CHECKBOX_CLUSTER_LOD                ,
+     IDC_CHECKBOX_FOVEATED_ADAPTIVE          ,
+     IDC_STATIC_FOVEA_INNER_RADIUS           ,
+     IDC_SLIDER_FOVEA_INNER_RADIUS           ,
+     IDC_STATIC_FOVEA_OUTER_RADIUS           ,
+     IDC_SLIDER_FOVEA_OUTER_RADIUS           ,
+     IDC_STATIC_FOVEA_PERIPHERY_SCALE        ,
+     IDC_SLIDER_FOVEA_PERIPHERY_SCALE        ,
+     IDC_CHECKBOX_MOTION_ADAPTIVE            ,
+     IDC_STATIC_MOTION_THRESHOLD             ,
+     IDC_SLIDER_MOTION_THRESHOLD             ,
+     IDC_STATIC_MOTION_MIN_SCALE             ,
+     IDC_SLIDER_MOTION_MIN_SCALE             ,
+     IDC_CHECKBOX_DYNAMIC_RESOLUTION         ,
+     IDC_STATIC_DYNAMIC_RESOLUTION_TARGET    ,
+     IDC_SLIDER_DYNAMIC_RESOLUTION_TARGET    ,
+     IDC_COMBOBOX_HUD_PAGE                   ,
+     IDC_HUD_MAX
 };
 
+// The settings are split into pages so the HUD fits a 1080p window, a combo box selects
+// the page shown. Controls outside the pages are always shown.
+enum HUD_PAGE
+{
+    HUD_PAGE_NONE = 0,
+    HUD_PAGE_SHARED,
+    HUD_PAGE_RENDER,
+    HUD_PAGE_CULLING,
+    HUD_PAGE_ADAPTIVE,
+};
+static int g_iHUDControlPage[IDC_HUD_MAX];
+
 
 //--------------------------------------------------------------------------------------
 // Forward declarations 
@@ -259,17 +494,45 @@ void CALLBACK OnD3D11DestroyDevice( void* pUserContext );
 void CALLBACK OnD3D11FrameRender( ID3D11Device* pd3dDevice, ID3D11DeviceContext* pd3dImmediateContext, double fTime, float fElapsedTime, void* pUserContext );
 
 void InitApp();
+void AssignHUDPage( int iPage );
+void ShowHUDPage( int iPage );
 void RenderText();
 void RenderMesh( CDXUTSDKMesh* pDXUTMesh, UINT uMesh, 
                  D3D11_PRIMITIVE_TOPOLOGY PrimType = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED, 
                  UINT uDiffuseSlot = INVALID_SAMPLER_SLOT, UINT uNormalSlot = INVALID_SAMPLER_SLOT,
-                 UINT uSpecularSlot = INVALID_SAMPLER_SLOT );
+                 UINT uSpecularSlot = INVALID_SAMPLER_SLOT, const BYTE* pVisible = NULL,
+                 ID3D11Buffer* pStream0VB = NULL, const UINT* puMaterialPolicies = NULL, UINT uPolicy = 0,
+                 UINT uNumInstances = 1 );
+const BYTE* GetVisibility( DirectX::CXMMATRIX mWorld, DirectX::CXMMATRIX mView, DirectX::CXMMATRIX mProj, bool bOcclusion );
+const BYTE* CullOccludedItems( const BYTE* pVisible, DirectX::CXMMATRIX mView, DirectX::CXMMATRIX mProj );
+bool UpdateWorldSpaceVertices( ID3D11DeviceContext* pd3dImmediateContext, DirectX::CXMMATRIX mWorld );
+void PlaceInstanceGrid();
+bool RenderSilhouetteFans( ID3D11DeviceContext* pd3dImmediateContext, DirectX::CXMMATRIX mWorld );
+bool UpdateProgressiveMesh( ID3D11DeviceContext* pd3dImmediateContext, DirectX::CXMMATRIX mWorld, DirectX::CXMMATRIX mView,
+                            DirectX::CXMMATRIX mProj, float fScreenHeight );
+bool SelectClusterCut( DirectX::CXMMATRIX mWorld, DirectX::CXMMATRIX mView, DirectX::CXMMATRIX mProj, float fScreenHeight );
+void LoadTessPolicies( MESH_TYPE eMeshType, const WCHAR* pszMeshFileName );
+void RecordCameraPathFrame( float fElapsedTime );
+void UpdatePNTrianglesCB( ID3D11DeviceContext* pd3dImmediateContext, const CB_PNTRIANGLES* pPNTrianglesCB );
+void RenderTessPass( ID3D11DeviceContext* pd3dImmediateContext, TESS_PASS ePass, SCENE_PASS_STATE* pState );
+bool GetPolicyPassFlags( TESS_PASS ePass, const TESS_POLICY* pPolicy, const SCENE_PASS_STATE* pState, DWORD* pdwFlags, bool* pbMultiView );
+void RenderPolicyPass( ID3D11DeviceContext* pd3dImmediateContext, TESS_PASS ePass, UINT uPolicy, DWORD dwFlags, bool bMultiView,
+                       SCENE_PASS_STATE* pState );
+void SetScenePathShaders( ID3D11DeviceContext* pd3dImmediateContext, bool bTessellate, DWORD dwFlags, bool bMultiView,
+                          const SCENE_PASS_STATE* pState );
+void RenderSceneEyes( ID3D11DeviceContext* pd3dImmediateContext, UINT uPolicy, bool bTessellate, bool bMultiView, bool bSplitByPath,
+                      UINT uNumInstances, const SCENE_PASS_STATE* pState );
 bool FileExists( WCHAR* pFileName );
 void CreateHullShader();
 void NormalizePlane( DirectX::XMVECTOR* pPlaneEquation );
 void ExtractPlanesFromFrustum( DirectX::XMFLOAT4* pPlaneEquation, DirectX::XMMATRIX* pMatrix );
 HRESULT AddShadersToCache();
+void CacheHullShaders();
+void CacheOptionalPermutations();
 void SetShaderFromUI();
+bool IsPermutationReady( DWORD dwFlags );
+void RequestShaderPermutations();
+void UpdateDrawnHullShaderHash( ID3D11Device* pd3dDevice );
 //--------------------------------------------------------------------------------------
 // Entry point to the program. Initializes everything and goes into a message processing 
 // loop. Idle time is used to render the scene.
@@ -281,6 +544,42 @@ int WINAPI wWinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdL
     _CrtSetDbgFlag( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF );
 #endif
 
+    // -lazyshaders compiles the hull and domain shader permutations on demand
+    int iNumArgs = 0;
+    WCHAR** ppszArgs = CommandLineToArgvW( GetCommandLine(), &iNumArgs );
+    for( int iArg = 1; iArg < iNumArgs; iArg++ )
+    {
+        WCHAR* pszCmdLine = ppszArgs[iArg];
+        if( ( L'/' == *pszCmdLine || L'-' == *pszCmdLine ) && AMD::IsNextArg( ++pszCmdLine, (WCHAR*)L"lazyshaders" ) )
+        {
+            g_bLazyShaders = true;
+        }
+    }
+    LocalFree( ppszArgs );
+
+    // The source is found as the shader cache finds it, working directory\..\bin\..\src\Shaders.
+    // Without it every permutation would fail to compile, so the shader cache compiles them.
+    if( g_bLazyShaders )
+    {
+        WCHAR szWorkingDir[MAX_PATH], szBinDir[MAX_PATH];
+        GetCurrentDirectory( MAX_PATH, szWorkingDir );
+        PathCombine( szBinDir, szWorkingDir, L"..\\bin" );
+        PathCombine( g_szPermutationSourceFile, szBinDir, L"..\\src\\Shaders\\SilhouetteTessellation11.hlsl" );
+        if( !PathFileExists( g_szPermutationSourceFile ) )
+        {
+            WCHAR szMessage[2 * MAX_PATH];
+            swprintf_s( szMessage, L"-lazyshaders can't find %s, the shader cache compiles the permutations instead.", g_szPermutationSourceFile );
+            MessageBox( NULL, szMessage, L"SilhouetteTessellation11", MB_OK | MB_ICONWARNING );
+            g_bLazyShaders = false;
+        }
+    }
+
+    // Lazy shaders register every permutation up front, none of them is compiled by the cache
+    if( g_bLazyShaders )
+    {
+        g_dwCachedOptionalFlags = OPTIONAL_PERMUTATION_FLAGS;
+    }
+
     // DXUT will create and use the best device (either D3D9 or D3D11) 
     // that is available on the system depending on which D3D callbacks are set below
 
@@ -308,6 +607,7 @@ int WINAPI wWinMain( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdL
 
 	// Ensure the ShaderCache aborts if in a lengthy generation process
 	g_ShaderCache.Abort();
+	g_ShaderPermutations.Destroy();
 
     return DXUTGetExitCode();
 }
@@ -332,6 +632,23 @@ void InitApp()
     g_HUD.m_GUI.AddButton( IDC_CHANGEDEVICE, L"Change device (F2)", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, AMD::HUD::iElementWidth, AMD::HUD::iElementHeight, VK_F2 );
 
     iY += AMD::HUD::iGroupDelta;
+
+    // Page of settings shown
+    CDXUTComboBox *pComboPage;
+    g_HUD.m_GUI.AddComboBox( IDC_COMBOBOX_HUD_PAGE, AMD::HUD::iElementOffset, iY, AMD::HUD::iElementWidth, AMD::HUD::iElementHeight, 0, true, &pComboPage );
+    if( pComboPage )
+    {
+        pComboPage->SetDropHeight( 34 );
+        pComboPage->AddItem( L"Render Settings", NULL );
+        pComboPage->AddItem( L"Culling Techniques", NULL );
+        pComboPage->AddItem( L"Adaptive Techniques", NULL );
+        pComboPage->SetSelectedByIndex( 0 );
+    }
+    AssignHUDPage( HUD_PAGE_SHARED );
+
+    iY += AMD::HUD::iGroupDelta;
+    const int iPageY = iY;
+    int iPageEndY = iY;
   
     // Render Settings
     g_HUD.m_GUI.AddStatic( IDC_STATIC_RENDER_SETTINGS, L"-Render Settings-", AMD::HUD::iElementOffset + 5, iY, 108, 24 );
@@ -359,16 +676,28 @@ void InitApp()
         pComboTess->AddItem( L"Phong tessellation", NULL );
         pComboTess->SetSelectedByIndex( 2 );
     }
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_PACKED_CONTROL_POINTS, L"Packed Patch Constants", AMD::HUD::iElementOffset, iY += 25, 140, 24, false );
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_WORLD_SPACE_VERTICES, L"World Space Vertices", AMD::HUD::iElementOffset, iY += 25, 140, 24, false );
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_STEREO, L"Stereo (Multi-View)", AMD::HUD::iElementOffset, iY += 25, 140, 24, false );
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_DEPTH_PREPASS, L"Depth Pre-Pass", AMD::HUD::iElementOffset, iY += 25, 140, 24, false );
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_HYBRID_PATH, L"No Tess When Small", AMD::HUD::iElementOffset, iY += 25, 140, 24, false );
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_INSTANCES, L"Instance Grid", AMD::HUD::iElementOffset, iY += 25, 140, 24, false );
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_SILHOUETTE_CLIP, L"Silhouette Clipping", AMD::HUD::iElementOffset, iY += 25, 140, 24, false );
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_PROGRESSIVE_MESH, L"Progressive Mesh", AMD::HUD::iElementOffset, iY += 25, 140, 24, false );
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_CLUSTER_LOD, L"Cluster LOD", AMD::HUD::iElementOffset, iY += 25, 140, 24, false );
     WCHAR szTemp[256];
     
     // Tess factor
-	g_HUD.m_GUI.AddStatic( IDC_STATIC_TESS_FACTOR_TITLE, L"Global Tess Factor", AMD::HUD::iElementOffset + 5, iY += 50, 108, 24 );
+	g_HUD.m_GUI.AddStatic( IDC_STATIC_TESS_FACTOR_TITLE, L"Global Tess Factor", AMD::HUD::iElementOffset + 5, iY += 40, 108, 24 );
     swprintf_s( szTemp, L"%d", g_uTessFactor );
     g_HUD.m_GUI.AddStatic( IDC_STATIC_TESS_FACTOR, szTemp, AMD::HUD::iElementOffset + 140, iY += 25, 108, 24 );
     g_HUD.m_GUI.AddSlider( IDC_SLIDER_TESS_FACTOR, AMD::HUD::iElementOffset, iY, 120, 24, 1, 8, 1 + ( g_uTessFactor - 1 ) / 2, false );
+    AssignHUDPage( HUD_PAGE_RENDER );
+    iPageEndY = std::max( iPageEndY, iY );
+    iY = iPageY;
     
     // Culling Techniques
-    g_HUD.m_GUI.AddStatic( IDC_STATIC_CULLING_TECHNIQUES, L"-Culling Techniques-", AMD::HUD::iElementOffset + 5, iY += 50, 108, 24 );
+    g_HUD.m_GUI.AddStatic( IDC_STATIC_CULLING_TECHNIQUES, L"-Culling Techniques-", AMD::HUD::iElementOffset + 5, iY, 108, 24 );
     
     // Back face culling
     g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_BACK_FACE_CULL, L"Back Face Cull", AMD::HUD::iElementOffset, iY += 30, 140, 24, false );
@@ -381,9 +710,17 @@ void InitApp()
     swprintf_s( szTemp, L"%.2f", g_fViewFrustumCullEpsilon );
     g_HUD.m_GUI.AddStatic( IDC_STATIC_VIEW_FRUSTUM_CULL_EPSILON, szTemp, AMD::HUD::iElementOffset + 140, iY += 25, 108, 24 );
     g_HUD.m_GUI.AddSlider( IDC_SLIDER_VIEW_FRUSTUM_CULL_EPSILON, AMD::HUD::iElementOffset, iY, 120, 24, 0, 100, (unsigned int)( g_fViewFrustumCullEpsilon * 100.0f ), false );
+
+    // CPU visibility, drawing only the runs of triangles in the frustum
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_CPU_VISIBILITY, L"CPU Visibility", AMD::HUD::iElementOffset, iY += 30, 140, 24, false );
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_PIPELINED_VISIBILITY, L"Pipelined", AMD::HUD::iElementOffset + 20, iY += 25, 120, 24, true );
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_OCCLUSION_CULL, L"Occlusion Cull", AMD::HUD::iElementOffset + 20, iY += 25, 120, 24, false );
+    AssignHUDPage( HUD_PAGE_CULLING );
+    iPageEndY = std::max( iPageEndY, iY );
+    iY = iPageY;
         
     // Adaptive Techniques
-    g_HUD.m_GUI.AddStatic( IDC_STATIC_ADAPTIVE_TECHNIQUES, L"-Adaptive Techniques-", AMD::HUD::iElementOffset + 5, iY += 50, 108, 24 );
+    g_HUD.m_GUI.AddStatic( IDC_STATIC_ADAPTIVE_TECHNIQUES, L"-Adaptive Techniques-", AMD::HUD::iElementOffset + 5, iY, 108, 24 );
     
     // Screen space adaptive
     g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_SCREEN_SPACE_ADAPTIVE, L"Screen Space Edge Size", AMD::HUD::iElementOffset, iY += 30, 140, 24, false ); 
@@ -409,15 +746,76 @@ void InitApp()
     g_HUD.m_GUI.AddStatic( IDC_STATIC_SILHOUTTE_EPSILON, szTemp, AMD::HUD::iElementOffset + 140, iY += 25, 108, 24 );
     g_HUD.m_GUI.AddSlider( IDC_SLIDER_SILHOUTTE_EPSILON, AMD::HUD::iElementOffset, iY, 120, 24, 0, 100, (unsigned int)( g_fSilhoutteEpsilon * 100.0f ), false );
 
+    // Foveated adaptive
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_FOVEATED_ADAPTIVE, L"Foveated (F + mouse)", AMD::HUD::iElementOffset, iY += 30, 140, 24, false );
+    swprintf_s( szTemp, L"Inner %.2f", g_fFoveaInnerRadius );
+    g_HUD.m_GUI.AddStatic( IDC_STATIC_FOVEA_INNER_RADIUS, szTemp, AMD::HUD::iElementOffset + 140, iY += 25, 108, 24 );
+    g_HUD.m_GUI.AddSlider( IDC_SLIDER_FOVEA_INNER_RADIUS, AMD::HUD::iElementOffset, iY, 120, 24, 0, 100, (unsigned int)( g_fFoveaInnerRadius * 100.0f ), false );
+    swprintf_s( szTemp, L"Outer %.2f", g_fFoveaOuterRadius );
+    g_HUD.m_GUI.AddStatic( IDC_STATIC_FOVEA_OUTER_RADIUS, szTemp, AMD::HUD::iElementOffset + 140, iY += 25, 108, 24 );
+    g_HUD.m_GUI.AddSlider( IDC_SLIDER_FOVEA_OUTER_RADIUS, AMD::HUD::iElementOffset, iY, 120, 24, 0, 100, (unsigned int)( g_fFoveaOuterRadius * 100.0f ), false );
+    swprintf_s( szTemp, L"Scale %.2f", g_fFoveaPeripheryScale );
+    g_HUD.m_GUI.AddStatic( IDC_STATIC_FOVEA_PERIPHERY_SCALE, szTemp, AMD::HUD::iElementOffset + 140, iY += 25, 108, 24 );
+    g_HUD.m_GUI.AddSlider( IDC_SLIDER_FOVEA_PERIPHERY_SCALE, AMD::HUD::iElementOffset, iY, 120, 24, 0, 100, (unsigned int)( g_fFoveaPeripheryScale * 100.0f ), false );
+
+    // Motion adaptive
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_MOTION_ADAPTIVE, L"Camera Motion", AMD::HUD::iElementOffset, iY += 30, 140, 24, false );
+    swprintf_s( szTemp, L"From %.0f px", g_fMotionThreshold );
+    g_HUD.m_GUI.AddStatic( IDC_STATIC_MOTION_THRESHOLD, szTemp, AMD::HUD::iElementOffset + 140, iY += 25, 108, 24 );
+    g_HUD.m_GUI.AddSlider( IDC_SLIDER_MOTION_THRESHOLD, AMD::HUD::iElementOffset, iY, 120, 24, 0, 32, (unsigned int)( g_fMotionThreshold ), false );
+    swprintf_s( szTemp, L"Scale %.2f", g_fMotionMinScale );
+    g_HUD.m_GUI.AddStatic( IDC_STATIC_MOTION_MIN_SCALE, szTemp, AMD::HUD::iElementOffset + 140, iY += 25, 108, 24 );
+    g_HUD.m_GUI.AddSlider( IDC_SLIDER_MOTION_MIN_SCALE, AMD::HUD::iElementOffset, iY, 120, 24, 0, 100, (unsigned int)( g_fMotionMinScale * 100.0f ), false );
+
+    // Dynamic resolution, with the target GPU time in tenths of a millisecond
+    g_HUD.m_GUI.AddCheckBox( IDC_CHECKBOX_DYNAMIC_RESOLUTION, L"Dynamic Resolution", AMD::HUD::iElementOffset, iY += 30, 140, 24, false );
+    swprintf_s( szTemp, L"%.1f ms", g_fDynamicResolutionTargetMs );
+    g_HUD.m_GUI.AddStatic( IDC_STATIC_DYNAMIC_RESOLUTION_TARGET, szTemp, AMD::HUD::iElementOffset + 140, iY += 25, 108, 24 );
+    g_HUD.m_GUI.AddSlider( IDC_SLIDER_DYNAMIC_RESOLUTION_TARGET, AMD::HUD::iElementOffset, iY, 120, 24, 20, 500, (unsigned int)( g_fDynamicResolutionTargetMs * 10.0f + 0.5f ), false );
+    g_DynamicResolution.SetTargetMs( g_fDynamicResolutionTargetMs );
+    AssignHUDPage( HUD_PAGE_ADAPTIVE );
+    iPageEndY = std::max( iPageEndY, iY );
+    ShowHUDPage( HUD_PAGE_RENDER );
+
 	SetShaderFromUI();
 
-	iY += AMD::HUD::iGroupDelta;
+	iY = iPageEndY + AMD::HUD::iGroupDelta;
 
     // Add the magnify tool UI to our HUD	
     g_MagnifyTool.InitApp( &g_HUD.m_GUI, iY, true );
 }
 
 
+//--------------------------------------------------------------------------------------
+// Puts the HUD controls added since the last call on a page
+//--------------------------------------------------------------------------------------
+void AssignHUDPage( int iPage )
+{
+    for( int iID = 0; iID < IDC_HUD_MAX; iID++ )
+    {
+        if( HUD_PAGE_NONE == g_iHUDControlPage[iID] && NULL != g_HUD.m_GUI.GetControl( iID ) )
+        {
+            g_iHUDControlPage[iID] = iPage;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Shows the controls of a page of the HUD and hides the other pages
+//--------------------------------------------------------------------------------------
+void ShowHUDPage( int iPage )
+{
+    for( int iID = 0; iID < IDC_HUD_MAX; iID++ )
+    {
+        if( g_iHUDControlPage[iID] >= HUD_PAGE_RENDER )
+        {
+            g_HUD.m_GUI.GetControl( iID )->SetVisible( iPage == g_iHUDControlPage[iID] );
+        }
+    }
+}
+
+
 //--------------------------------------------------------------------------------------
 // Render the help and statistics text. This function uses the ID3DXFont interface for 
 // efficient text rendering.
@@ -435,6 +833,133 @@ void RenderText()
 	swprintf_s( wcbuf, 256, L"Effect cost in miliseconds( Total = %.3f )", fEffectTime );
 	g_pTxtHelper->DrawTextLine( wcbuf );
 
+    if( g_bLazyShaders )
+    {
+        SHADER_PERMUTATION_STATS Stats;
+        g_ShaderPermutations.GetStats( &Stats );
+        swprintf_s( wcbuf, 256, L"Shader permutations: %u of %u compiled, %u queued, %u failed, %.0f ms compiling%s",
+                    Stats.uNumCompiled, (UINT)g_HullShaders.size(), Stats.uNumQueued, Stats.uNumFailed, (float)Stats.fCompileMs,
+                    ( g_dwDrawnHullShaderHash == HullShaderHash ) ? L"" :
+                    g_ShaderPermutations.IsFailed( HullShaderHash ) ? L", selection failed" : L", selection pending" );
+        g_pTxtHelper->DrawTextLine( wcbuf );
+    }
+
+    if( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_CPU_VISIBILITY )->GetChecked() && 0 != g_VisibilityStats.uNumFrames )
+    {
+        float fFrames = (float)g_VisibilityStats.uNumFrames;
+        swprintf_s( wcbuf, 256, L"Visibility: %u / %u runs, %.1f%% predicted, %.1f%% corrected, %u stalls, %.3f ms on render thread",
+                    g_VisibilityStats.uNumVisible, g_VisibilityStage.GetNumItems(), 100.0f * g_VisibilityStats.uNumPredicted / fFrames,
+                    100.0f * g_VisibilityStats.uNumCorrected / fFrames, g_VisibilityStats.uNumStalls,
+                    (float)g_VisibilityStats.fRenderThreadMs / fFrames );
+        g_pTxtHelper->DrawTextLine( wcbuf );
+
+        if( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_OCCLUSION_CULL )->GetChecked() )
+        {
+            swprintf_s( wcbuf, 256, L"Occlusion: %u runs, %u patches culled behind %u occluder triangles, %.3f ms",
+                        g_OcclusionCullStats.uNumCulledItems, g_OcclusionCullStats.uNumCulledPatches,
+                        g_OcclusionCullStats.uNumOccluderTriangles, (float)g_OcclusionCullStats.fMs );
+            g_pTxtHelper->DrawTextLine( wcbuf );
+        }
+    }
+
+    const CWorldSpaceVertices* pWorldSpace = &g_WorldSpaceVertices[g_eMeshType];
+    if( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_WORLD_SPACE_VERTICES )->GetChecked() && pWorldSpace->IsCreated() )
+    {
+        swprintf_s( wcbuf, 256, L"World space vertices: %u, %u updates, last %.3f ms",
+                    pWorldSpace->GetNumVertices(), pWorldSpace->GetNumUpdates(), (float)pWorldSpace->GetLastUpdateMs() );
+        g_pTxtHelper->DrawTextLine( wcbuf );
+    }
+
+    const CTessPolicyTable* pPolicies = &g_TessPolicies[g_eMeshType];
+    if( pPolicies->GetNumPolicies() > 1 )
+    {
+        UINT uNumBatches = 0;
+        for( UINT uPolicy = 0; uPolicy < pPolicies->GetNumPolicies(); uPolicy++ )
+        {
+            uNumBatches += pPolicies->IsPolicyUsed( uPolicy ) ? 1 : 0;
+        }
+        swprintf_s( wcbuf, 256, L"Tessellation policies: %u batches for %u materials", uNumBatches, pPolicies->GetNumMaterials() );
+        g_pTxtHelper->DrawTextLine( wcbuf );
+    }
+
+    if( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_HYBRID_PATH )->GetChecked() )
+    {
+        const TESS_PATH_STATS* pPathStats = g_TessPathSelector.GetFrameStats();
+        swprintf_s( wcbuf, 256, L"Hybrid path: %u tessellated, %u plain (under %.0f pixels), %u switches",
+                    pPathStats->uNumTessellated, pPathStats->uNumPlain, g_TessPathSelector.GetSettings()->fMinDiameter,
+                    g_TessPathSelector.GetNumSwitches() );
+        g_pTxtHelper->DrawTextLine( wcbuf );
+    }
+
+    if( 0 != g_DepthPrePassStats.uNumBatches )
+    {
+        swprintf_s( wcbuf, 256, L"Depth pre-pass: %u of %u batches, %u left to the colour pass until their permutations compile",
+                    g_DepthPrePassStats.uNumBatches - g_DepthPrePassStats.uNumLeftToColorPass, g_DepthPrePassStats.uNumBatches,
+                    g_DepthPrePassStats.uNumLeftToColorPass );
+        g_pTxtHelper->DrawTextLine( wcbuf );
+    }
+
+    if( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_INSTANCES )->GetChecked() )
+    {
+        WCHAR szBins[64] = L"";
+        for( UINT uBin = 0; uBin < g_InstanceBins.uNumBins; uBin++ )
+        {
+            WCHAR szBin[16];
+            swprintf_s( szBin, 16, L"%s%u", ( 0 != uBin ) ? L"/" : L"", g_InstanceBins.uCount[uBin] );
+            wcscat_s( szBins, 64, szBin );
+        }
+        swprintf_s( wcbuf, 256, L"Instance grid: %u of %u visible, %s per tier (the last without tessellation)",
+                    g_InstanceBins.uNumVisible, g_InstanceSet.GetNumInstances(), szBins );
+        g_pTxtHelper->DrawTextLine( wcbuf );
+    }
+
+    if( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_SILHOUETTE_CLIP )->GetChecked() )
+    {
+        swprintf_s( wcbuf, 256, L"Silhouette clipping: %u of %u edges, %u tested, pushed out by %.3f",
+                    g_SilhouetteStats.uNumSilhouetteEdges, g_SilhouetteTree.GetNumEdges(), g_SilhouetteStats.uNumEdgesTested,
+                    g_fSilhouetteInflation );
+        g_pTxtHelper->DrawTextLine( wcbuf );
+    }
+
+    if( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_PROGRESSIVE_MESH )->GetChecked() )
+    {
+        swprintf_s( wcbuf, 256, L"Progressive mesh: %u of %u triangles, %u active vertices, %u splits, %u collapses (%u refused), %u rewritten",
+                    g_ProgressiveMeshStats.uNumTriangles, g_ProgressiveMesh[g_eMeshType].GetNumTriangles(), g_ProgressiveMeshStats.uNumActiveVertices,
+                    g_ProgressiveMeshStats.uNumSplits, g_ProgressiveMeshStats.uNumCollapses, g_ProgressiveMeshStats.uNumRefusedCollapses,
+                    g_ProgressiveMeshStats.uNumRewrittenTriangles );
+        g_pTxtHelper->DrawTextLine( wcbuf );
+    }
+
+    if( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_CLUSTER_LOD )->GetChecked() )
+    {
+        swprintf_s( wcbuf, 256, L"Cluster LOD: %u of %u clusters, %u triangles, %u culled, %u levels",
+                    g_ClusterCutStats.uNumClusters, (UINT)g_ClusterDAG[g_eMeshType].GetClusters().size(), g_ClusterCutStats.uNumTriangles,
+                    g_ClusterCutStats.uNumCulled, g_ClusterDAG[g_eMeshType].GetNumLevels() );
+        g_pTxtHelper->DrawTextLine( wcbuf );
+    }
+
+    if( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_MOTION_ADAPTIVE )->GetChecked() )
+    {
+        const DXGI_SURFACE_DESC* pBackBufferSurfaceDesc = DXUTGetDXGIBackBufferSurfaceDesc();
+        swprintf_s( wcbuf, 256, L"Camera motion: %.1f pixels per 60Hz frame at the look at point",
+                    g_CameraMotion.GetScreenVelocity( g_Camera.GetLookAtPt(), (float)pBackBufferSurfaceDesc->Width, (float)pBackBufferSurfaceDesc->Height ) );
+        g_pTxtHelper->DrawTextLine( wcbuf );
+    }
+
+    if( g_bRecordCameraPath )
+    {
+        swprintf_s( wcbuf, 256, L"Recording camera path (R): %u frames, %.1f s", (UINT)g_CameraPath.size(), g_fCameraPathSeconds );
+        g_pTxtHelper->DrawTextLine( wcbuf );
+    }
+
+    if( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_DYNAMIC_RESOLUTION )->GetChecked() )
+    {
+        swprintf_s( wcbuf, 256, L"Dynamic resolution: render scale %.2f, tess scale %.2f, %.3f ms filtered, %s, %u changes",
+                    g_DynamicResolution.GetRenderScale(), g_DynamicResolution.GetTessScale(), g_DynamicResolution.GetFilteredMs(),
+                    GetDynamicResolutionStateName( g_DynamicResolution.GetState() ), g_DynamicResolution.GetNumChanges() );
+        g_pTxtHelper->DrawTextLine( wcbuf );
+    }
+
     g_pTxtHelper->SetInsertionPos( 5, DXUTGetDXGIBackBufferSurfaceDesc()->Height - AMD::HUD::iElementDelta );
 	g_pTxtHelper->DrawTextLine( L"Toggle GUI    : F1" );
 
@@ -472,6 +997,18 @@ HRESULT CALLBACK OnD3D11CreateDevice( ID3D11Device* pd3dDevice, const DXGI_SURFA
     Desc.MiscFlags = 0;    
     Desc.ByteWidth = sizeof( CB_PNTRIANGLES );
     V_RETURN( pd3dDevice->CreateBuffer( &Desc, NULL, &g_pcbPNTriangles ) );
+
+    // World matrices of the instance grid, 4 float4 rows each
+    Desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    Desc.ByteWidth = INSTANCE_GRID_SIZE * INSTANCE_GRID_SIZE * sizeof( DirectX::XMFLOAT4X4 );
+    V_RETURN( pd3dDevice->CreateBuffer( &Desc, NULL, &g_pInstanceWorldBuffer ) );
+    D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc;
+    ZeroMemory( &SRVDesc, sizeof( SRVDesc ) );
+    SRVDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    SRVDesc.Buffer.FirstElement = 0;
+    SRVDesc.Buffer.NumElements = INSTANCE_GRID_SIZE * INSTANCE_GRID_SIZE * 4;
+    V_RETURN( pd3dDevice->CreateShaderResourceView( g_pInstanceWorldBuffer, &SRVDesc, &g_pInstanceWorldSRV ) );
 	
     // Setup the mesh params for adaptive tessellation
     g_v3AdaptiveTessParams[MESH_TYPE_MUSHROOMS].x    = 1.0f;
@@ -502,18 +1039,26 @@ HRESULT CALLBACK OnD3D11CreateDevice( ID3D11Device* pd3dDevice, const DXGI_SURFA
     V_RETURN( DXUTFindDXSDKMediaFileCch( str, MAX_PATH, L"mushrooms\\mushrooms.sdkmesh"));
     hr = g_SceneMesh[MESH_TYPE_MUSHROOMS].Create( pd3dDevice, str );
     assert( D3D_OK == hr );
+    LoadTessPolicies( MESH_TYPE_MUSHROOMS, str );
+    wcscpy_s( g_szMeshFileNames[MESH_TYPE_MUSHROOMS], MAX_PATH, str );
 	
     V_RETURN( DXUTFindDXSDKMediaFileCch( str, MAX_PATH,  L"tiger\\tiger.sdkmesh" ) );
     hr = g_SceneMesh[MESH_TYPE_TIGER].Create( pd3dDevice, str );
     assert( D3D_OK == hr );
+    LoadTessPolicies( MESH_TYPE_TIGER, str );
+    wcscpy_s( g_szMeshFileNames[MESH_TYPE_TIGER], MAX_PATH, str );
 
     V_RETURN( DXUTFindDXSDKMediaFileCch( str, MAX_PATH, L"teapot\\teapot.sdkmesh" ) );
     hr = g_SceneMesh[MESH_TYPE_TEAPOT].Create( pd3dDevice, str );
     assert( D3D_OK == hr );
+    LoadTessPolicies( MESH_TYPE_TEAPOT, str );
+    wcscpy_s( g_szMeshFileNames[MESH_TYPE_TEAPOT], MAX_PATH, str );
 
     V_RETURN( DXUTFindDXSDKMediaFileCch( str, MAX_PATH, L"icosphere\\icosphere.sdkmesh" ) );
     hr = g_SceneMesh[MESH_TYPE_ICOSPHERE].Create( pd3dDevice, str );
     assert( D3D_OK == hr );
+    LoadTessPolicies( MESH_TYPE_ICOSPHERE, str );
+    wcscpy_s( g_szMeshFileNames[MESH_TYPE_ICOSPHERE], MAX_PATH, str );
 
     // Load a user mesh and textures if present
     g_bUserMesh = false;
@@ -526,6 +1071,8 @@ HRESULT CALLBACK OnD3D11CreateDevice( ID3D11Device* pd3dDevice, const DXGI_SURFA
     {
         hr = g_SceneMesh[MESH_TYPE_USER].Create( pd3dDevice, str );
         assert( D3D_OK == hr );
+        LoadTessPolicies( MESH_TYPE_USER, str );
+        wcscpy_s( g_szMeshFileNames[MESH_TYPE_USER], MAX_PATH, str );
         g_bUserMesh = true;
 
         // add the User choice to the dropdown combo box
@@ -584,6 +1131,37 @@ HRESULT CALLBACK OnD3D11CreateDevice( ID3D11Device* pd3dDevice, const DXGI_SURFA
     RasterizerDesc.FillMode = D3D11_FILL_SOLID;
     V_RETURN( pd3dDevice->CreateRasterizerState( &RasterizerDesc, &g_pRasterizerStateSolid ) );
 
+    // Set the depth stencil state
+    D3D11_DEPTH_STENCIL_DESC DepthStencilDesc;
+    ZeroMemory( &DepthStencilDesc, sizeof( DepthStencilDesc ) );
+    DepthStencilDesc.DepthEnable = TRUE;
+    DepthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+    DepthStencilDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+    DepthStencilDesc.StencilEnable = FALSE;
+    V_RETURN( pd3dDevice->CreateDepthStencilState( &DepthStencilDesc, &g_pDepthStencilStateLessEqual ) );
+
+    // Silhouette clipping: the fans add their winding to the stencil without depth, and the
+    // coarse mesh is drawn where it is not 0
+    DepthStencilDesc.DepthEnable = FALSE;
+    DepthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    DepthStencilDesc.StencilEnable = TRUE;
+    DepthStencilDesc.StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK;
+    DepthStencilDesc.StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK;
+    DepthStencilDesc.FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+    DepthStencilDesc.FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_KEEP;
+    DepthStencilDesc.FrontFace.StencilPassOp = D3D11_STENCIL_OP_INCR;
+    DepthStencilDesc.FrontFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+    DepthStencilDesc.BackFace = DepthStencilDesc.FrontFace;
+    DepthStencilDesc.BackFace.StencilPassOp = D3D11_STENCIL_OP_DECR;
+    V_RETURN( pd3dDevice->CreateDepthStencilState( &DepthStencilDesc, &g_pDepthStencilStateSilhouetteFans ) );
+    DepthStencilDesc.DepthEnable = TRUE;
+    DepthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+    DepthStencilDesc.StencilWriteMask = 0;
+    DepthStencilDesc.FrontFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+    DepthStencilDesc.FrontFace.StencilFunc = D3D11_COMPARISON_NOT_EQUAL;
+    DepthStencilDesc.BackFace = DepthStencilDesc.FrontFace;
+    V_RETURN( pd3dDevice->CreateDepthStencilState( &DepthStencilDesc, &g_pDepthStencilStateSilhouetteClip ) );
+
 
     // Create AMD_SDK resources here
     g_HUD.OnCreateDevice( pd3dDevice );
@@ -606,6 +1184,13 @@ HRESULT CALLBACK OnD3D11CreateDevice( ID3D11Device* pd3dDevice, const DXGI_SURFA
 		// Add the applications shaders to the cache
 		AddShadersToCache();
 		g_ShaderCache.GenerateShaders( AMD::ShaderCache::CREATE_TYPE_COMPILE_CHANGES );    // Only compile shaders that have changed (development mode)
+
+		// The permutations compile alongside the shader cache, from the source it reads
+		if( g_bLazyShaders )
+		{
+			RequestShaderPermutations();
+			V( g_ShaderPermutations.Create( g_szPermutationSourceFile ) );
+		}
 		bFirstPass = false;
 	}
 
@@ -649,20 +1234,39 @@ HRESULT CALLBACK OnD3D11ResizedSwapChain( ID3D11Device* pd3dDevice, IDXGISwapCha
     g_MagnifyTool.SetScale( 5 );
     SAFE_RELEASE( pTempRTResource );
 
+    // Scene color for dynamic resolution, at the full back buffer size so any render scale fits
+    D3D11_TEXTURE2D_DESC TexDesc;
+    ZeroMemory( &TexDesc, sizeof( TexDesc ) );
+    TexDesc.Width = pBackBufferSurfaceDesc->Width;
+    TexDesc.Height = pBackBufferSurfaceDesc->Height;
+    TexDesc.MipLevels = 1;
+    TexDesc.ArraySize = 1;
+    TexDesc.Format = RTDesc.Format;
+    TexDesc.SampleDesc.Count = 1;
+    TexDesc.Usage = D3D11_USAGE_DEFAULT;
+    TexDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    V_RETURN( pd3dDevice->CreateTexture2D( &TexDesc, NULL, &g_pSceneColor ) );
+    V_RETURN( pd3dDevice->CreateRenderTargetView( g_pSceneColor, NULL, &g_pSceneColorRTV ) );
+    V_RETURN( pd3dDevice->CreateShaderResourceView( g_pSceneColor, NULL, &g_pSceneColorSRV ) );
+
     return S_OK;
 }
 
 
 //--------------------------------------------------------------------------------------
 // Helper function that allows the app to render individual meshes of an sdkmesh
-// and override the primitive topology
+// and override the primitive topology and the first vertex stream. With material
+// policies only the subsets whose material uses uPolicy are drawn. With more than one
+// instance the subsets are drawn whole, instanced.
 //--------------------------------------------------------------------------------------
 void RenderMesh( CDXUTSDKMesh* pDXUTMesh, UINT uMesh, D3D11_PRIMITIVE_TOPOLOGY PrimType, 
-                UINT uDiffuseSlot, UINT uNormalSlot, UINT uSpecularSlot )
+                UINT uDiffuseSlot, UINT uNormalSlot, UINT uSpecularSlot, const BYTE* pVisible,
+                ID3D11Buffer* pStream0VB, const UINT* puMaterialPolicies, UINT uPolicy, UINT uNumInstances )
 {
     #define MAX_D3D11_VERTEX_STREAMS D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT
 
     assert( NULL != pDXUTMesh );
+    assert( NULL == pVisible || 1 == uNumInstances );
 
 	SDKMESH_MESH* pMesh = pDXUTMesh->GetMesh( uMesh );
 
@@ -681,6 +1285,10 @@ void RenderMesh( CDXUTSDKMesh* pDXUTMesh, UINT uMesh, D3D11_PRIMITIVE_TOPOLOGY P
         Strides[i] = pDXUTMesh->GetVertexStride( uMesh, (UINT)i );
         Offsets[i] = 0;
     }
+    if( NULL != pStream0VB && pMesh->NumVertexBuffers > 0 )
+    {
+        pVB[0] = pStream0VB;
+    }
 
     ID3D11Buffer* pIB;
     pIB = pDXUTMesh->GetIB11( uMesh );
@@ -696,6 +1304,11 @@ void RenderMesh( CDXUTSDKMesh* pDXUTMesh, UINT uMesh, D3D11_PRIMITIVE_TOPOLOGY P
     {
         pSubset = pDXUTMesh->GetSubset( uMesh, uSubset );
 
+        if( NULL != puMaterialPolicies && puMaterialPolicies[pSubset->MaterialID] != uPolicy )
+        {
+            continue;
+        }
+
         if( D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED == PrimType )
         {
             PrimType = pDXUTMesh->GetPrimitiveType11( ( SDKMESH_PRIMITIVE_TYPE )pSubset->PrimitiveType );
@@ -714,16 +1327,793 @@ void RenderMesh( CDXUTSDKMesh* pDXUTMesh, UINT uMesh, D3D11_PRIMITIVE_TOPOLOGY P
             DXUTGetD3D11DeviceContext()->PSSetShaderResources( uNormalSlot, 1, &pMat->pNormalRV11 );
         }
 
-        if( uSpecularSlot != INVALID_SAMPLER_SLOT && !IsErrorResource( pMat->pSpecularRV11 ) )
-        {
-            DXUTGetD3D11DeviceContext()->PSSetShaderResources( uSpecularSlot, 1, &pMat->pSpecularRV11 );
+        if( uSpecularSlot != INVALID_SAMPLER_SLOT && !IsErrorResource( pMat->pSpecularRV11 ) )
+        {
+            DXUTGetD3D11DeviceContext()->PSSetShaderResources( uSpecularSlot, 1, &pMat->pSpecularRV11 );
+        }
+
+        UINT IndexCount = ( UINT )pSubset->IndexCount;
+        UINT IndexStart = ( UINT )pSubset->IndexStart;
+        UINT VertexStart = ( UINT )pSubset->VertexStart;
+        
+        if( uNumInstances > 1 )
+        {
+            DXUTGetD3D11DeviceContext()->DrawIndexedInstanced( IndexCount, uNumInstances, IndexStart, VertexStart, 0 );
+            continue;
+        }
+
+        if( NULL == pVisible )
+        {
+            DXUTGetD3D11DeviceContext()->DrawIndexed( IndexCount, IndexStart, VertexStart );
+            continue;
+        }
+
+        // Draw the visible runs of the subset, merging neighbours into one draw. Subsets
+        // without runs (not triangle lists) are drawn whole.
+        VISIBILITY_ITEM_RANGE Range = { 0, 0 };
+        if( uMesh < (UINT)g_VisibilityItemRanges.size() && uSubset < (UINT)g_VisibilityItemRanges[uMesh].size() )
+        {
+            Range = g_VisibilityItemRanges[uMesh][uSubset];
+        }
+
+        UINT uDrawStart = 0, uDrawCount = 0;
+        for( UINT i = Range.uFirstItem; i < Range.uFirstItem + Range.uNumItems; i++ )
+        {
+            const VISIBILITY_ITEM& Item = g_VisibilityItems[i];
+            if( 0 == pVisible[i] )
+            {
+                continue;
+            }
+
+            UINT uStart = IndexStart + Item.uFirstTriangle * 3;
+            if( 0 != uDrawCount && uDrawStart + uDrawCount != uStart )
+            {
+                DXUTGetD3D11DeviceContext()->DrawIndexed( uDrawCount, uDrawStart, VertexStart );
+                uDrawCount = 0;
+            }
+            if( 0 == uDrawCount )
+            {
+                uDrawStart = uStart;
+            }
+            uDrawCount += Item.uNumTriangles * 3;
+        }
+
+        if( 0 == Range.uNumItems )
+        {
+            DXUTGetD3D11DeviceContext()->DrawIndexed( IndexCount, IndexStart, VertexStart );
+        }
+        else if( 0 != uDrawCount )
+        {
+            DXUTGetD3D11DeviceContext()->DrawIndexed( uDrawCount, uDrawStart, VertexStart );
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the visibility of the runs of triangles of the current mesh for this frame, and
+// starts computing the next frame's. The runs in the frustum are also tested against the
+// occluders if bOcclusion. Returns NULL if everything should be drawn.
+//--------------------------------------------------------------------------------------
+const BYTE* GetVisibility( DirectX::CXMMATRIX mWorld, DirectX::CXMMATRIX mView, DirectX::CXMMATRIX mProj, bool bOcclusion )
+{
+    if( g_iVisibilityMeshType != (int)g_eMeshType )
+    {
+        g_VisibilityStage.Destroy();
+        g_VisibilityItems.clear();
+        g_VisibilityItemRanges.clear();
+        g_OccluderPositions.clear();
+        g_OccluderIndices.clear();
+        g_VisibilityItemFirstIndex.clear();
+        g_iVisibilityMeshType = (int)g_eMeshType;
+
+        MESH_DATA MeshData;
+        if( FAILED( ExtractMeshData( &g_SceneMesh[g_eMeshType], &MeshData ) ) )
+        {
+            return NULL;
+        }
+
+        BuildVisibilityItems( &MeshData, VISIBILITY_ITEM_TRIANGLES, mWorld, &g_VisibilityItems );
+        if( g_VisibilityItems.empty() || FAILED( g_VisibilityStage.Create( &g_VisibilityItems[0], (UINT)g_VisibilityItems.size() ) ) )
+        {
+            g_VisibilityItems.clear();
+            return NULL;
+        }
+
+        // The runs of a subset are consecutive, RenderMesh looks them up by subset
+        for( UINT i = 0; i < (UINT)g_VisibilityItems.size(); i++ )
+        {
+            const VISIBILITY_ITEM& Item = g_VisibilityItems[i];
+            if( Item.uMesh >= (UINT)g_VisibilityItemRanges.size() )
+            {
+                g_VisibilityItemRanges.resize( Item.uMesh + 1 );
+            }
+            std::vector<VISIBILITY_ITEM_RANGE>& Ranges = g_VisibilityItemRanges[Item.uMesh];
+            if( Item.uSubset >= (UINT)Ranges.size() )
+            {
+                VISIBILITY_ITEM_RANGE Empty = { 0, 0 };
+                Ranges.resize( Item.uSubset + 1, Empty );
+            }
+            VISIBILITY_ITEM_RANGE& Range = Ranges[Item.uSubset];
+            if( 0 == Range.uNumItems )
+            {
+                Range.uFirstItem = i;
+            }
+            assert( Range.uFirstItem + Range.uNumItems == i );
+            Range.uNumItems++;
+        }
+
+        // The occluders are the triangles of the runs, in world space with the matrix the
+        // bounds were built for. The PN-Triangles and Phong surfaces curve in behind the flat
+        // triangles in places, so the vertices are pushed in along their normals until the
+        // occluders are behind both surfaces. Items are in the order of the subsets.
+        float fPNInset = 0.0f, fPhongInset = 0.0f;
+        GetMaxPatchBulge( &MeshData, CPU_TESS_PN_TRIANGLES, OCCLUSION_INSET_TESS_FACTOR, &fPNInset );
+        GetMaxPatchBulge( &MeshData, CPU_TESS_PHONG, OCCLUSION_INSET_TESS_FACTOR, &fPhongInset );
+        float fInset = std::max( fPNInset, fPhongInset );
+
+        g_OccluderPositions.resize( MeshData.Vertices.size() );
+        for( UINT i = 0; i < (UINT)MeshData.Vertices.size(); i++ )
+        {
+            DirectX::XMVECTOR vNormal = DirectX::XMVector3Normalize( DirectX::XMLoadFloat3( &MeshData.Vertices[i].f3Normal ) );
+            DirectX::XMVECTOR vPosition = DirectX::XMVectorSubtract( DirectX::XMLoadFloat3( &MeshData.Vertices[i].f3Position ),
+                                                                     DirectX::XMVectorScale( vNormal, fInset ) );
+            DirectX::XMStoreFloat3( &g_OccluderPositions[i], DirectX::XMVector3TransformCoord( vPosition, mWorld ) );
+        }
+        g_OccluderIndices.swap( MeshData.Indices );
+
+        g_VisibilityItemFirstIndex.resize( g_VisibilityItems.size() );
+        UINT uSubset = 0;
+        for( UINT i = 0; i < (UINT)g_VisibilityItems.size(); i++ )
+        {
+            const VISIBILITY_ITEM& Item = g_VisibilityItems[i];
+            while( MeshData.Subsets[uSubset].uMesh != Item.uMesh || MeshData.Subsets[uSubset].uSubset != Item.uSubset )
+            {
+                uSubset++;
+            }
+            g_VisibilityItemFirstIndex[i] = MeshData.Subsets[uSubset].uIndexStart + Item.uFirstTriangle * 3;
+        }
+    }
+
+    if( g_VisibilityItems.empty() )
+    {
+        return NULL;
+    }
+
+    // The rows of the inverse view are the camera basis
+    DirectX::XMMATRIX mInvView = DirectX::XMMatrixInverse( NULL, mView );
+    VISIBILITY_CAMERA Camera;
+    DirectX::XMStoreFloat3( &Camera.f3Right, mInvView.r[0] );
+    DirectX::XMStoreFloat3( &Camera.f3Up, mInvView.r[1] );
+    DirectX::XMStoreFloat3( &Camera.f3Ahead, mInvView.r[2] );
+    DirectX::XMStoreFloat3( &Camera.f3Eye, mInvView.r[3] );
+    Camera.fFOV = g_Camera.GetFOV();
+    Camera.fAspect = g_Camera.GetAspect();
+
+    g_VisibilityStage.SetPipelined( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_PIPELINED_VISIBILITY )->GetChecked() );
+    const BYTE* pVisible = g_VisibilityStage.BeginFrame( &Camera );
+    g_VisibilityStage.GetStats( &g_VisibilityStats );
+
+    memset( &g_OcclusionCullStats, 0, sizeof( g_OcclusionCullStats ) );
+    if( bOcclusion && NULL != pVisible )
+    {
+        pVisible = CullOccludedItems( pVisible, mView, mProj );
+    }
+
+    return pVisible;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Rasterizes the runs largest on screen into the occlusion buffer and culls the runs in
+// the frustum that are hidden behind them. The occluders are pushed in behind the
+// tessellated surface, which stays within the bounds of each run, grown to hold it.
+// Returns the visibility of the runs, or pVisible if the buffer can't be created.
+//--------------------------------------------------------------------------------------
+const BYTE* CullOccludedItems( const BYTE* pVisible, DirectX::CXMMATRIX mView, DirectX::CXMMATRIX mProj )
+{
+    LARGE_INTEGER Start, End, Frequency;
+    QueryPerformanceCounter( &Start );
+
+    UINT uHeight = std::max( (UINT)( (float)OCCLUSION_BUFFER_WIDTH / g_Camera.GetAspect() ), OCCLUSION_TILE_SIZE );
+    if( uHeight != g_uOcclusionBufferHeight )
+    {
+        if( FAILED( g_OcclusionBuffer.Create( OCCLUSION_BUFFER_WIDTH, uHeight ) ) )
+        {
+            g_uOcclusionBufferHeight = 0;
+            return pVisible;
+        }
+        g_OcclusionBuffer.SetSIMD( GetBestOcclusionSIMD() );
+        g_uOcclusionBufferHeight = uHeight;
+    }
+
+    // Rank the runs in the frustum by size over distance
+    DirectX::XMVECTOR vEye = DirectX::XMMatrixInverse( NULL, mView ).r[3];
+    g_OccluderCandidates.clear();
+    for( UINT i = 0; i < (UINT)g_VisibilityItems.size(); i++ )
+    {
+        if( 0 == pVisible[i] )
+        {
+            continue;
+        }
+
+        const VISIBILITY_ITEM& Item = g_VisibilityItems[i];
+        DirectX::XMVECTOR vMin = DirectX::XMLoadFloat3( &Item.f3BoundsMin );
+        DirectX::XMVECTOR vMax = DirectX::XMLoadFloat3( &Item.f3BoundsMax );
+        float fSize = DirectX::XMVectorGetX( DirectX::XMVector3Length( DirectX::XMVectorSubtract( vMax, vMin ) ) );
+        DirectX::XMVECTOR vCenter = DirectX::XMVectorScale( DirectX::XMVectorAdd( vMin, vMax ), 0.5f );
+        float fDistance = DirectX::XMVectorGetX( DirectX::XMVector3Length( DirectX::XMVectorSubtract( vCenter, vEye ) ) );
+        g_OccluderCandidates.push_back( std::make_pair( -fSize / std::max( fDistance, 1.0e-6f ), i ) );
+    }
+    std::sort( g_OccluderCandidates.begin(), g_OccluderCandidates.end() );
+
+    // The workers of the world space transform are idle while the frame is culled
+    if( 0 == g_WorldSpacePool.GetNumWorkers() )
+    {
+        g_WorldSpacePool.Create( 0, 0 );
+    }
+    CNumaTaskPool* pPool = ( 0 != g_WorldSpacePool.GetNumWorkers() ) ? &g_WorldSpacePool : NULL;
+
+    g_OcclusionBuffer.Begin( DirectX::XMMatrixMultiply( mView, mProj ) );
+    for( UINT i = 0; i < (UINT)g_OccluderCandidates.size() && g_OcclusionCullStats.uNumOccluderTriangles < OCCLUSION_OCCLUDER_TRIANGLES; i++ )
+    {
+        UINT uItem = g_OccluderCandidates[i].second;
+        const VISIBILITY_ITEM& Item = g_VisibilityItems[uItem];
+        g_OcclusionBuffer.AddOccluder( &g_OccluderPositions[0], sizeof( DirectX::XMFLOAT3 ), &g_OccluderIndices[g_VisibilityItemFirstIndex[uItem]],
+                                       Item.uNumTriangles );
+        g_OcclusionCullStats.uNumOccluderTriangles += Item.uNumTriangles;
+    }
+    g_OcclusionBuffer.Rasterize( pPool );
+
+    g_OcclusionVisible.assign( pVisible, pVisible + g_VisibilityItems.size() );
+    for( UINT i = 0; i < (UINT)g_OccluderCandidates.size(); i++ )
+    {
+        UINT uItem = g_OccluderCandidates[i].second;
+        const VISIBILITY_ITEM& Item = g_VisibilityItems[uItem];
+        if( !g_OcclusionBuffer.IsBoxVisible( Item.f3BoundsMin, Item.f3BoundsMax ) )
+        {
+            g_OcclusionVisible[uItem] = 0;
+            g_OcclusionCullStats.uNumCulledItems++;
+            g_OcclusionCullStats.uNumCulledPatches += Item.uNumTriangles;
+        }
+    }
+
+    QueryPerformanceCounter( &End );
+    QueryPerformanceFrequency( &Frequency );
+    g_OcclusionCullStats.fMs = (double)( End.QuadPart - Start.QuadPart ) * 1000.0 / (double)Frequency.QuadPart;
+
+    return &g_OcclusionVisible[0];
+}
+
+
+//--------------------------------------------------------------------------------------
+// Creates the world space vertices of the current mesh on first use, and transforms them
+// again if its matrix changed. Returns false if they can't be used.
+//--------------------------------------------------------------------------------------
+bool UpdateWorldSpaceVertices( ID3D11DeviceContext* pd3dImmediateContext, DirectX::CXMMATRIX mWorld )
+{
+    CWorldSpaceVertices* pVertices = &g_WorldSpaceVertices[g_eMeshType];
+    if( !pVertices->IsCreated() )
+    {
+        if( FAILED( pVertices->Create( DXUTGetD3D11Device(), &g_SceneMesh[g_eMeshType] ) ) )
+        {
+            return false;
+        }
+    }
+
+    // The transform runs on the calling thread if the pool can't be started
+    if( 0 == g_WorldSpacePool.GetNumWorkers() )
+    {
+        g_WorldSpacePool.Create( 0, 0 );
+    }
+    CNumaTaskPool* pPool = ( 0 != g_WorldSpacePool.GetNumWorkers() ) ? &g_WorldSpacePool : NULL;
+
+    return SUCCEEDED( pVertices->Update( pd3dImmediateContext, mWorld, pPool ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Places copies of the current mesh on the instance grid, centered on the origin, turned
+// about y at random and INSTANCE_GRID_SPACING bounding sphere diameters apart
+//--------------------------------------------------------------------------------------
+void PlaceInstanceGrid()
+{
+    CDXUTSDKMesh* pSceneMesh = &g_SceneMesh[g_eMeshType];
+
+    // Bounds of all the meshes of the sdkmesh
+    DirectX::XMVECTOR vMin = DirectX::XMVectorReplicate( FLT_MAX );
+    DirectX::XMVECTOR vMax = DirectX::XMVectorReplicate( -FLT_MAX );
+    for( UINT uMesh = 0; uMesh < pSceneMesh->GetNumMeshes(); uMesh++ )
+    {
+        DirectX::XMVECTOR vMeshCenter = pSceneMesh->GetMeshBBoxCenter( uMesh );
+        DirectX::XMVECTOR vMeshExtents = pSceneMesh->GetMeshBBoxExtents( uMesh );
+        vMin = DirectX::XMVectorMin( vMin, DirectX::XMVectorSubtract( vMeshCenter, vMeshExtents ) );
+        vMax = DirectX::XMVectorMax( vMax, DirectX::XMVectorAdd( vMeshCenter, vMeshExtents ) );
+    }
+    DirectX::XMVECTOR vBoxCenter = DirectX::XMVectorScale( DirectX::XMVectorAdd( vMin, vMax ), 0.5f );
+    DirectX::XMVECTOR vBoxExtents = DirectX::XMVectorScale( DirectX::XMVectorSubtract( vMax, vMin ), 0.5f );
+
+    DirectX::XMVECTOR vCenter;
+    float fRadius;
+    GetWorldBoundingSphere( vBoxCenter, vBoxExtents, g_m4x4MeshMatrix[g_eMeshType], &vCenter, &fRadius );
+    float fSpacing = INSTANCE_GRID_SPACING * 2.0f * fRadius;
+    float fOffset = 0.5f * (float)( INSTANCE_GRID_SIZE - 1 );
+
+    g_InstanceSet.Init( vBoxCenter, vBoxExtents );
+    g_InstanceSet.SetSIMD( GetBestOcclusionSIMD() );
+    UINT uRandom = 12345;
+    for( UINT uZ = 0; uZ < INSTANCE_GRID_SIZE; uZ++ )
+    {
+        for( UINT uX = 0; uX < INSTANCE_GRID_SIZE; uX++ )
+        {
+            uRandom = uRandom * 1664525 + 1013904223;
+            float fAngle = DirectX::XM_2PI * (float)( uRandom >> 8 ) / 16777216.0f;
+            g_InstanceSet.AddInstance( g_m4x4MeshMatrix[g_eMeshType] * DirectX::XMMatrixRotationY( fAngle ) *
+                                       DirectX::XMMatrixTranslation( ( (float)uX - fOffset ) * fSpacing, 0.0f, ( (float)uZ - fOffset ) * fSpacing ) );
+        }
+    }
+
+    g_iInstanceMeshType = (int)g_eMeshType;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Builds the silhouette edge tree of the current mesh on first use, from its PN-Triangles
+// surface baked at SILHOUETTE_TESS_FACTOR, and draws the fans from the middle of the mesh
+// to the silhouette edges seen from the eye to the stencil. The constant buffer must hold
+// the matrices of the frame. Returns false if the mesh can't be clipped.
+//--------------------------------------------------------------------------------------
+bool RenderSilhouetteFans( ID3D11DeviceContext* pd3dImmediateContext, DirectX::CXMMATRIX mWorld )
+{
+    if( g_iSilhouetteMeshType != (int)g_eMeshType )
+    {
+        g_iSilhouetteMeshType = (int)g_eMeshType;
+        g_bSilhouetteTreeBuilt = false;
+
+        MESH_DATA MeshData, Detailed;
+        MESH_BAKE_STATS BakeStats;
+        if( FAILED( ExtractMeshData( &g_SceneMesh[g_eMeshType], &MeshData ) ) ||
+            FAILED( BakeTessellatedMeshData( &MeshData, CPU_TESS_PN_TRIANGLES, SILHOUETTE_TESS_FACTOR, &Detailed, &BakeStats ) ) ||
+            FAILED( g_SilhouetteTree.Build( &Detailed ) ) )
+        {
+            return false;
+        }
+
+        g_fSilhouetteInflation = GetMaxPatchBulge( &MeshData, CPU_TESS_PN_TRIANGLES, SILHOUETTE_TESS_FACTOR );
+        DirectX::XMStoreFloat3( &g_f3SilhouetteFanOrigin, DirectX::XMVectorScale( DirectX::XMVectorAdd( DirectX::XMLoadFloat3( &MeshData.f3BoundsMin ),
+                                                                                                         DirectX::XMLoadFloat3( &MeshData.f3BoundsMax ) ), 0.5f ) );
+        g_bSilhouetteTreeBuilt = true;
+    }
+    if( !g_bSilhouetteTreeBuilt )
+    {
+        return false;
+    }
+
+    // The silhouette from the eye in the space of the mesh
+    DirectX::XMVECTOR vEye = DirectX::XMVector3TransformCoord( g_Camera.GetEyePt(), DirectX::XMMatrixInverse( NULL, mWorld ) );
+    g_SilhouetteSegments.clear();
+    g_SilhouetteTree.Extract( vEye, &g_SilhouetteSegments, &g_SilhouetteStats );
+    UINT uNumVertices = (UINT)g_SilhouetteSegments.size() / 2 * 3;
+    if( 0 == uNumVertices )
+    {
+        return true;
+    }
+
+    // Grow the vertex buffer of the fans by doubling
+    if( uNumVertices > g_uSilhouetteFanVBSize )
+    {
+        UINT uSize = std::max( uNumVertices, 2 * g_uSilhouetteFanVBSize );
+        SAFE_RELEASE( g_pSilhouetteFanVB );
+        g_uSilhouetteFanVBSize = 0;
+
+        D3D11_BUFFER_DESC Desc;
+        Desc.Usage = D3D11_USAGE_DYNAMIC;
+        Desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        Desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        Desc.MiscFlags = 0;
+        Desc.StructureByteStride = 0;
+        Desc.ByteWidth = uSize * sizeof( PN_VERTEX );
+        if( FAILED( DXUTGetD3D11Device()->CreateBuffer( &Desc, NULL, &g_pSilhouetteFanVB ) ) )
+        {
+            return false;
+        }
+        g_uSilhouetteFanVBSize = uSize;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE MappedResource;
+    if( FAILED( pd3dImmediateContext->Map( g_pSilhouetteFanVB, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource ) ) )
+    {
+        return false;
+    }
+    PN_VERTEX* pVertices = (PN_VERTEX*)MappedResource.pData;
+    ZeroMemory( pVertices, uNumVertices * sizeof( PN_VERTEX ) );
+    for( UINT uSegment = 0; uSegment < uNumVertices / 3; uSegment++ )
+    {
+        pVertices[uSegment * 3 + 0].f3Position = g_f3SilhouetteFanOrigin;
+        pVertices[uSegment * 3 + 1].f3Position = g_SilhouetteSegments[uSegment * 2 + 0];
+        pVertices[uSegment * 3 + 2].f3Position = g_SilhouetteSegments[uSegment * 2 + 1];
+    }
+    pd3dImmediateContext->Unmap( g_pSilhouetteFanVB, 0 );
+
+    // Both sides of the fans, to the stencil only
+    UINT uStride = sizeof( PN_VERTEX ), uOffset = 0;
+    pd3dImmediateContext->IASetInputLayout( g_pSceneVertexLayout );
+    pd3dImmediateContext->IASetVertexBuffers( 0, 1, &g_pSilhouetteFanVB, &uStride, &uOffset );
+    pd3dImmediateContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+    pd3dImmediateContext->VSSetShader( g_pSceneVS, NULL, 0 );
+    pd3dImmediateContext->HSSetShader( NULL, NULL, 0 );
+    pd3dImmediateContext->DSSetShader( NULL, NULL, 0 );
+    pd3dImmediateContext->GSSetShader( NULL, NULL, 0 );
+    pd3dImmediateContext->PSSetShader( NULL, NULL, 0 );
+    pd3dImmediateContext->RSSetState( g_pRasterizerStateSolid );
+    pd3dImmediateContext->OMSetDepthStencilState( g_pDepthStencilStateSilhouetteFans, 0 );
+    pd3dImmediateContext->Draw( uNumVertices, 0 );
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reads the progressive mesh of the current mesh from its sidecar on first use, or builds
+// it from its PN-Triangles surface baked at PM_SOURCE_TESS_FACTOR, then refines it for the
+// view and uploads the indices that changed. Returns false if the mesh has none.
+//--------------------------------------------------------------------------------------
+bool UpdateProgressiveMesh( ID3D11DeviceContext* pd3dImmediateContext, DirectX::CXMMATRIX mWorld, DirectX::CXMMATRIX mView,
+                            DirectX::CXMMATRIX mProj, float fScreenHeight )
+{
+    CProgressiveMesh* pMesh = &g_ProgressiveMesh[g_eMeshType];
+    if( !g_bProgressiveMeshTried[g_eMeshType] )
+    {
+        g_bProgressiveMeshTried[g_eMeshType] = true;
+
+        WCHAR szFileName[MAX_PATH];
+        GetProgressiveMeshFileName( g_szMeshFileNames[g_eMeshType], szFileName, MAX_PATH );
+        if( FAILED( pMesh->Load( szFileName ) ) )
+        {
+            MESH_DATA MeshData, Detailed;
+            MESH_BAKE_STATS BakeStats;
+            if( FAILED( ExtractMeshData( &g_SceneMesh[g_eMeshType], &MeshData ) ) ||
+                FAILED( BakeTessellatedMeshData( &MeshData, CPU_TESS_PN_TRIANGLES, PM_SOURCE_TESS_FACTOR, &Detailed, &BakeStats ) ) ||
+                FAILED( pMesh->Build( &Detailed ) ) )
+            {
+                return false;
+            }
+        }
+    }
+    if( !pMesh->IsBuilt() || ( NULL == pMesh->GetVB() && FAILED( pMesh->CreateBuffers( DXUTGetD3D11Device() ) ) ) )
+    {
+        return false;
+    }
+
+    PM_VIEW View;
+    InitProgressiveMeshView( mWorld, mView, mProj, fScreenHeight, PM_PIXEL_ERROR, &View );
+    pMesh->Update( &View, &g_ProgressiveMeshStats );
+    pMesh->UploadIndices( pd3dImmediateContext );
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reads the cluster DAG of the current mesh from its sidecar on first use, or builds it
+// from its PN-Triangles surface baked at CLUSTER_SOURCE_TESS_FACTOR, then selects the
+// cut for the view over the workers. Returns false if the mesh has none.
+//--------------------------------------------------------------------------------------
+bool SelectClusterCut( DirectX::CXMMATRIX mWorld, DirectX::CXMMATRIX mView, DirectX::CXMMATRIX mProj, float fScreenHeight )
+{
+    // The selection runs on the calling thread if the pool can't be started
+    if( 0 == g_WorldSpacePool.GetNumWorkers() )
+    {
+        g_WorldSpacePool.Create( 0, 0 );
+    }
+    CNumaTaskPool* pPool = ( 0 != g_WorldSpacePool.GetNumWorkers() ) ? &g_WorldSpacePool : NULL;
+
+    CClusterDAG* pDAG = &g_ClusterDAG[g_eMeshType];
+    if( !g_bClusterDAGTried[g_eMeshType] )
+    {
+        g_bClusterDAGTried[g_eMeshType] = true;
+
+        WCHAR szFileName[MAX_PATH];
+        GetClusterDAGFileName( g_szMeshFileNames[g_eMeshType], szFileName, MAX_PATH );
+        if( FAILED( pDAG->Load( szFileName ) ) )
+        {
+            MESH_DATA MeshData, Detailed;
+            MESH_BAKE_STATS BakeStats;
+            if( FAILED( ExtractMeshData( &g_SceneMesh[g_eMeshType], &MeshData ) ) ||
+                FAILED( BakeTessellatedMeshData( &MeshData, CPU_TESS_PN_TRIANGLES, CLUSTER_SOURCE_TESS_FACTOR, &Detailed, &BakeStats ) ) ||
+                FAILED( pDAG->Build( &Detailed, pPool ) ) )
+            {
+                return false;
+            }
+        }
+    }
+    if( !pDAG->IsBuilt() || ( NULL == pDAG->GetVB() && FAILED( pDAG->CreateBuffers( DXUTGetD3D11Device() ) ) ) )
+    {
+        return false;
+    }
+
+    PM_VIEW View;
+    InitProgressiveMeshView( mWorld, mView, mProj, fScreenHeight, CLUSTER_PIXEL_ERROR, &View );
+    pDAG->SelectCut( &View, true, pPool, &g_ClusterCut, &g_ClusterCutStats );
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Loads the tessellation policies of a mesh from <mesh>.tesspolicy if there is one, the
+// mesh uses the UI settings for all its materials otherwise
+//--------------------------------------------------------------------------------------
+void LoadTessPolicies( MESH_TYPE eMeshType, const WCHAR* pszMeshFileName )
+{
+    WCHAR szPolicyFileName[MAX_PATH];
+    wcscpy_s( szPolicyFileName, MAX_PATH, pszMeshFileName );
+    WCHAR* pszExtension = wcsrchr( szPolicyFileName, L'.' );
+    if( NULL != pszExtension )
+    {
+        *pszExtension = 0;
+    }
+    wcscat_s( szPolicyFileName, MAX_PATH, L".tesspolicy" );
+
+    CTessPolicyTable* pPolicies = &g_TessPolicies[eMeshType];
+    UINT uErrorLine = 0;
+    if( FAILED( pPolicies->Load( szPolicyFileName, &uErrorLine ) ) && 0 != uErrorLine )
+    {
+        WCHAR szMessage[MAX_PATH + 64];
+        swprintf_s( szMessage, ARRAYSIZE( szMessage ), L"%s(%u): invalid tessellation policy, using the UI settings\n", szPolicyFileName, uErrorLine );
+        OutputDebugString( szMessage );
+    }
+
+    pPolicies->AssignMaterials( &g_SceneMesh[eMeshType] );
+}
+
+//--------------------------------------------------------------------------------------
+// Adds the camera of this frame to the recorded path, in mesh space relative to the center
+// of the bounds of the current mesh and in units of their diagonal, so the path can be
+// replayed on any mesh (-motion tool)
+//--------------------------------------------------------------------------------------
+void RecordCameraPathFrame( float fElapsedTime )
+{
+    CDXUTSDKMesh* pMesh = &g_SceneMesh[g_eMeshType];
+    if( 0 == pMesh->GetNumMeshes() )
+    {
+        return;
+    }
+
+    DirectX::XMVECTOR vMin = DirectX::XMVectorReplicate( FLT_MAX );
+    DirectX::XMVECTOR vMax = DirectX::XMVectorReplicate( -FLT_MAX );
+    for( UINT uMesh = 0; uMesh < pMesh->GetNumMeshes(); uMesh++ )
+    {
+        DirectX::XMVECTOR vCenter = pMesh->GetMeshBBoxCenter( uMesh );
+        DirectX::XMVECTOR vExtents = pMesh->GetMeshBBoxExtents( uMesh );
+        vMin = DirectX::XMVectorMin( vMin, DirectX::XMVectorSubtract( vCenter, vExtents ) );
+        vMax = DirectX::XMVectorMax( vMax, DirectX::XMVectorAdd( vCenter, vExtents ) );
+    }
+    DirectX::XMVECTOR vCenter = DirectX::XMVectorScale( DirectX::XMVectorAdd( vMin, vMax ), 0.5f );
+    float fDiagonal = std::max( DirectX::XMVectorGetX( DirectX::XMVector3Length( DirectX::XMVectorSubtract( vMax, vMin ) ) ), 1e-6f );
+
+    DirectX::XMMATRIX mInvWorld = DirectX::XMMatrixInverse( NULL, g_m4x4MeshMatrix[g_eMeshType] );
+    DirectX::XMVECTOR vEye = DirectX::XMVector3TransformCoord( g_Camera.GetEyePt(), mInvWorld );
+    DirectX::XMVECTOR vLookAt = DirectX::XMVector3TransformCoord( g_Camera.GetLookAtPt(), mInvWorld );
+
+    if( !g_CameraPath.empty() )
+    {
+        g_fCameraPathSeconds += fElapsedTime;
+    }
+
+    CAMERA_PATH_FRAME Frame;
+    Frame.fSeconds = g_fCameraPathSeconds;
+    DirectX::XMStoreFloat3( &Frame.f3Eye, DirectX::XMVectorScale( DirectX::XMVectorSubtract( vEye, vCenter ), 1.0f / fDiagonal ) );
+    DirectX::XMStoreFloat3( &Frame.f3LookAt, DirectX::XMVectorScale( DirectX::XMVectorSubtract( vLookAt, vCenter ), 1.0f / fDiagonal ) );
+    g_CameraPath.push_back( Frame );
+}
+
+//--------------------------------------------------------------------------------------
+// Uploads the PN-Triangles constants
+//--------------------------------------------------------------------------------------
+void UpdatePNTrianglesCB( ID3D11DeviceContext* pd3dImmediateContext, const CB_PNTRIANGLES* pPNTrianglesCB )
+{
+    D3D11_MAPPED_SUBRESOURCE MappedResource;
+    pd3dImmediateContext->Map( g_pcbPNTriangles, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource );
+    memcpy( MappedResource.pData, pPNTrianglesCB, sizeof( CB_PNTRIANGLES ) );
+    pd3dImmediateContext->Unmap( g_pcbPNTriangles, 0 );
+}
+
+//--------------------------------------------------------------------------------------
+// Draws the subsets of the used tess policies in a pass, to depth only in the pre-pass
+// and shaded in the colour pass
+//--------------------------------------------------------------------------------------
+void RenderTessPass( ID3D11DeviceContext* pd3dImmediateContext, TESS_PASS ePass, SCENE_PASS_STATE* pState )
+{
+    pd3dImmediateContext->PSSetShader( ( TESS_PASS_COLOR == ePass )?pState->pPS:NULL, NULL, 0 );
+    ID3D11DepthStencilState* pDepthStencilState = ( pState->bDepthPrePass && TESS_PASS_COLOR == ePass )?g_pDepthStencilStateLessEqual:NULL;
+    pd3dImmediateContext->OMSetDepthStencilState( pState->bSilhouetteClip?g_pDepthStencilStateSilhouetteClip:pDepthStencilState, 0 );
+
+    const CTessPolicyTable* pPolicies = &g_TessPolicies[g_eMeshType];
+    for( UINT uPolicy = 0; uPolicy < pPolicies->GetNumPolicies(); uPolicy++ )
+    {
+        if( !pPolicies->IsPolicyUsed( uPolicy ) )
+        {
+            continue;
+        }
+
+        DWORD dwFlags = 0;
+        bool bMultiView = false;
+        bool bDrawn = GetPolicyPassFlags( ePass, pPolicies->GetPolicy( uPolicy ), pState, &dwFlags, &bMultiView );
+        if( TESS_PASS_DEPTH == ePass )
+        {
+            g_DepthPrePassStats.uNumBatches++;
+            g_DepthPrePassStats.uNumLeftToColorPass += bDrawn ? 0 : 1;
+        }
+        if( bDrawn )
+        {
+            RenderPolicyPass( pd3dImmediateContext, ePass, uPolicy, dwFlags, bMultiView, pState );
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Returns the HS/DS permutation a tess policy is drawn with in a pass, 0 without
+// tessellation, and whether it draws both eyes at once. Returns false if the subsets are
+// left to the colour pass, while the permutation of the pass compiles.
+//--------------------------------------------------------------------------------------
+bool GetPolicyPassFlags( TESS_PASS ePass, const TESS_POLICY* pPolicy, const SCENE_PASS_STATE* pState, DWORD* pdwFlags, bool* pbMultiView )
+{
+    DWORD dwFlags = pState->bTessellation ? GetTessPolicyFlags( pPolicy, g_dwDrawnHullShaderHash ) : 0;
+    bool bTessellatePolicy = ( 0 != dwFlags );
+    if( bTessellatePolicy && !IsPermutationReady( dwFlags ) )
+    {
+        dwFlags = g_dwDrawnHullShaderHash;
+    }
+    // Until the MULTI_VIEW permutation is compiled the tessellated subsets are drawn
+    // once per eye, like the others
+    bool bMultiView = bTessellatePolicy && pState->bStereo && IsPermutationReady( GetMultiViewTessFlags( dwFlags ) );
+    if( bMultiView )
+    {
+        dwFlags = GetMultiViewTessFlags( dwFlags );
+    }
+
+    // The subsets of a permutation not cached, or not compiled yet, are left to the
+    // colour pass, which draws them without tessellation
+    dwFlags = GetTessPassFlags( ePass, dwFlags );
+    if( bTessellatePolicy && !IsPermutationReady( dwFlags ) )
+    {
+        if( TESS_PASS_COLOR != ePass )
+        {
+            return false;
+        }
+        dwFlags = 0;
+    }
+
+    *pdwFlags = dwFlags;
+    *pbMultiView = bMultiView;
+    return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Draws the subsets of a tess policy in a pass, with the permutation from
+// GetPolicyPassFlags. With the hybrid path the meshes too small on screen are drawn after
+// the others, with the same policy but without tessellation. With the instance grid each
+// bin is drawn with the tess factor of its tier, the last without tessellation, and
+// without tessellation all the visible instances are drawn at once.
+//--------------------------------------------------------------------------------------
+void RenderPolicyPass( ID3D11DeviceContext* pd3dImmediateContext, TESS_PASS ePass, UINT uPolicy, DWORD dwFlags, bool bMultiView,
+                       SCENE_PASS_STATE* pState )
+{
+    const TESS_POLICY* pPolicy = g_TessPolicies[g_eMeshType].GetPolicy( uPolicy );
+    CB_PNTRIANGLES* pPNTrianglesCB = pState->pPNTrianglesCB;
+    bool bTessellatePolicy = ( 0 != dwFlags );
+
+    UINT uNumPaths = ( bTessellatePolicy && pState->bHybridPath ) ? 2 : 1;
+    if( bTessellatePolicy && pState->bInstanced )
+    {
+        uNumPaths = g_InstanceBins.uNumBins;
+    }
+    for( UINT uPath = 0; uPath < uNumPaths; uPath++ )
+    {
+        bool bTessellate = bTessellatePolicy && ( 0 == uPath );
+        float fPathTessFactor = (float)g_uTessFactor;
+        UINT uFirstInstance = 0, uNumInstances = 1;
+        if( pState->bInstanced )
+        {
+            bTessellate = bTessellatePolicy && g_InstanceBins.fTessFactor[uPath] > 0.0f;
+            fPathTessFactor = bTessellate ? g_InstanceBins.fTessFactor[uPath] : fPathTessFactor;
+            uFirstInstance = bTessellatePolicy ? g_InstanceBins.uFirst[uPath] : 0;
+            uNumInstances = bTessellatePolicy ? g_InstanceBins.uCount[uPath] : g_InstanceBins.uNumVisible;
+            if( 0 == uNumInstances )
+            {
+                continue;
+            }
+        }
+
+        // Tess factors, and the first instance of the bin
+        float fTessFactor = GetTessPassFactor( ePass, GetTessPolicyFactor( pPolicy, fPathTessFactor ) );
+        if( fTessFactor != pState->fBoundTessFactor || uFirstInstance != pPNTrianglesCB->uFirstInstance )
+        {
+            pPNTrianglesCB->fEdgeTessFactors = fTessFactor;
+            pPNTrianglesCB->fInsideTessFactors = fTessFactor;
+            pPNTrianglesCB->uFirstInstance = uFirstInstance;
+            UpdatePNTrianglesCB( pd3dImmediateContext, pPNTrianglesCB );
+            pState->fBoundTessFactor = fTessFactor;
+        }
+
+        SetScenePathShaders( pd3dImmediateContext, bTessellate, dwFlags, bMultiView, pState );
+        RenderSceneEyes( pd3dImmediateContext, uPolicy, bTessellate, bTessellate && bMultiView, pState->bHybridPath && uNumPaths > 1,
+                         uNumInstances, pState );
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Sets the shaders of the scene for a path, the HS/DS permutation if tessellated
+//--------------------------------------------------------------------------------------
+void SetScenePathShaders( ID3D11DeviceContext* pd3dImmediateContext, bool bTessellate, DWORD dwFlags, bool bMultiView,
+                          const SCENE_PASS_STATE* pState )
+{
+    // VS
+    if( pState->bInstanced )
+    {
+        pd3dImmediateContext->VSSetShader( bTessellate?g_pSceneInstancedTessellationVS:g_pSceneInstancedVS, NULL, 0 );
+    }
+    else if( pState->bWorldSpace )
+    {
+        pd3dImmediateContext->VSSetShader( bTessellate?g_pSceneWorldSpaceTessellationVS:g_pSceneWorldSpaceVS, NULL, 0 );
+    }
+    else if( pState->bSilhouetteClip )
+    {
+        pd3dImmediateContext->VSSetShader( g_pSceneSilhouetteClipVS, NULL, 0 );
+    }
+    else
+    {
+        pd3dImmediateContext->VSSetShader( bTessellate?g_pSceneWithTessellationVS:g_pSceneVS, NULL, 0 );
+    }
+
+    // HS
+    pd3dImmediateContext->HSSetShader( bTessellate?g_HullShaders[dwFlags]:NULL, NULL, 0 );
+
+    // DS
+    pd3dImmediateContext->DSSetShader( bTessellate?g_DomainShaders[dwFlags]:NULL, NULL, 0 );
+
+    // GS
+    pd3dImmediateContext->GSSetShader( ( bTessellate && bMultiView )?g_pMultiViewGS:NULL, NULL, 0 );
+}
+
+//--------------------------------------------------------------------------------------
+// Draws the meshes of a tess policy once per eye if stereo and not drawn with MULTI_VIEW.
+// With bSplitByPath only those the hybrid path selects for bTessellate.
+//--------------------------------------------------------------------------------------
+void RenderSceneEyes( ID3D11DeviceContext* pd3dImmediateContext, UINT uPolicy, bool bTessellate, bool bMultiView, bool bSplitByPath,
+                      UINT uNumInstances, const SCENE_PASS_STATE* pState )
+{
+    CB_PNTRIANGLES* pPNTrianglesCB = pState->pPNTrianglesCB;
+    D3D11_PRIMITIVE_TOPOLOGY PrimitiveTopology = bTessellate ? D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST : D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+    CDXUTSDKMesh* pSceneMesh = &g_SceneMesh[g_eMeshType];
+
+    UINT uNumEyes = ( pState->bStereo && !bMultiView ) ? 2 : 1;
+    for( UINT uEye = 0; uEye < uNumEyes; uEye++ )
+    {
+        if( bMultiView )
+        {
+            pd3dImmediateContext->RSSetViewports( 2, pState->pEyeViewports );
+        }
+        else if( pState->bStereo )
+        {
+            pd3dImmediateContext->RSSetViewports( 1, &pState->pEyeViewports[uEye] );
+            pPNTrianglesCB->f4x4ViewProjection = DirectX::XMMatrixTranspose( pState->pEyeViewProjections[uEye] );
+            pPNTrianglesCB->f4x4WorldViewProjection = DirectX::XMMatrixTranspose( *pState->pWorld * pState->pEyeViewProjections[uEye] );
+            UpdatePNTrianglesCB( pd3dImmediateContext, pPNTrianglesCB );
+        }
+
+        for( UINT uMesh = 0; uMesh < pSceneMesh->GetNumMeshes(); uMesh++ )
+        {
+            if( bSplitByPath && g_TessPathSelector.IsTessellated( uMesh ) != bTessellate )
+            {
+                continue;
+            }
+
+            ID3D11Buffer* pWorldSpaceVB = pState->bWorldSpace ? g_WorldSpaceVertices[g_eMeshType].GetVB( uMesh ) : NULL;
+            RenderMesh( pSceneMesh, uMesh, PrimitiveTopology, pState->uDiffuseSlot, INVALID_SAMPLER_SLOT, INVALID_SAMPLER_SLOT, pState->pVisible,
+                        pWorldSpaceVB, g_TessPolicies[g_eMeshType].GetMaterialPolicies(), uPolicy, uNumInstances );
         }
-
-        UINT IndexCount = ( UINT )pSubset->IndexCount;
-        UINT IndexStart = ( UINT )pSubset->IndexStart;
-        UINT VertexStart = ( UINT )pSubset->VertexStart;
-        
-        DXUTGetD3D11DeviceContext()->DrawIndexed( IndexCount, IndexStart, VertexStart );
     }
 }
 
@@ -743,19 +2133,52 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pd3dDevice, ID3D11DeviceContext*
         return;
     }       
 
+    // Compile the permutations of any optional adaptive term this frame uses for the first time
+    CacheOptionalPermutations();
+
     // Clear the backbuffer and depth stencil
     float ClearColor[4] = { 0.176f, 0.196f, 0.667f, 0.0f };
     ID3D11RenderTargetView* pRTV = DXUTGetD3D11RenderTargetView();
 	ID3D11DepthStencilView* pDSV = DXUTGetD3D11DepthStencilView();
     pd3dImmediateContext->ClearRenderTargetView( pRTV, ClearColor );
-    pd3dImmediateContext->ClearDepthStencilView( pDSV, D3D11_CLEAR_DEPTH, 1.0, 0 );
+    pd3dImmediateContext->ClearDepthStencilView( pDSV, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0, 0 );
 	pd3dImmediateContext->OMSetRenderTargets( 1, (ID3D11RenderTargetView *const *)&pRTV, DXUTGetD3D11DepthStencilView() );
 
-    if( g_ShaderCache.ShadersReady() )
+    bool bShadersReady = g_ShaderCache.ShadersReady();
+    g_bSceneShadersCreated |= bShadersReady;
+    if( g_bSceneShadersCreated )
     {
+		UpdateDrawnHullShaderHash( pd3dDevice );
+
 		// Array of our samplers
 		ID3D11SamplerState* ppSamplerStates[2] = { g_pSamplePoint, g_pSampleLinear };
 
+		// With dynamic resolution feed the controller the last measured scene time, and render
+		// the scene to the top left of the scene color at its render scale
+		UINT uBackBufferWidth = DXUTGetDXGIBackBufferSurfaceDesc()->Width;
+		UINT uBackBufferHeight = DXUTGetDXGIBackBufferSurfaceDesc()->Height;
+		UINT uSceneWidth = uBackBufferWidth;
+		UINT uSceneHeight = uBackBufferHeight;
+		float fTessScale = 1.0f;
+		bool bDynamicResolution = g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_DYNAMIC_RESOLUTION )->GetChecked() && NULL != g_pSceneColorRTV;
+		if( bDynamicResolution )
+		{
+			float fEffectMs = (float)TIMER_GetTime( Gpu, L"Effect" ) * 1000.0f;
+			g_DynamicResolution.SetTessScaleEnabled( 0 != ( g_dwDrawnHullShaderHash & RES_ADAPT ) );
+			if( fEffectMs > 0.0f )
+			{
+				g_DynamicResolution.Update( fEffectMs );
+			}
+			uSceneWidth = std::max( (UINT)( uBackBufferWidth * g_DynamicResolution.GetRenderScale() + 0.5f ), 1U );
+			uSceneHeight = std::max( (UINT)( uBackBufferHeight * g_DynamicResolution.GetRenderScale() + 0.5f ), 1U );
+			fTessScale = g_DynamicResolution.GetTessScale();
+
+			pd3dImmediateContext->ClearRenderTargetView( g_pSceneColorRTV, ClearColor );
+			pd3dImmediateContext->OMSetRenderTargets( 1, &g_pSceneColorRTV, pDSV );
+			D3D11_VIEWPORT Viewport = { 0.0f, 0.0f, (float)uSceneWidth, (float)uSceneHeight, 0.0f, 1.0f };
+			pd3dImmediateContext->RSSetViewports( 1, &Viewport );
+		}
+
         TIMER_Begin( 0, L"Effect" )
 		
 		// Get the projection & view matrix from the camera class
@@ -769,14 +2192,42 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pd3dDevice, ID3D11DeviceContext*
 		DirectX::XMVECTOR v3ViewVector = DirectX::XMVectorSubtract( g_Camera.GetEyePt(), g_Camera.GetLookAtPt());
 		v3ViewVector = DirectX::XMVector3Normalize( v3ViewVector );
 
+		// Track the camera motion every frame, so it is current when enabled
+		g_CameraMotion.Update( mViewProjection, fElapsedTime );
+		if( g_bRecordCameraPath )
+		{
+			RecordCameraPathFrame( fElapsedTime );
+		}
+
 		// Calculate the plane equations of the frustum in world space
 		DirectX::XMFLOAT4 f4ViewFrustumPlanes[6];
 		ExtractPlanesFromFrustum( f4ViewFrustumPlanes, &mViewProjection );
 
-		// Setup the constant buffer for the scene vertex shader
-		D3D11_MAPPED_SUBRESOURCE MappedResource;
-		pd3dImmediateContext->Map( g_pcbPNTriangles, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource );
-		CB_PNTRIANGLES* pPNTrianglesCB = ( CB_PNTRIANGLES* )MappedResource.pData;
+		// Stereo renders the left and right eyes to the two halves of the scene. The tessellated
+		// subsets are drawn to both in one MULTI_VIEW pass, the others once per eye.
+		bool bStereo = g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_STEREO )->GetChecked();
+		DirectX::XMMATRIX mEyeViews[2];
+		DirectX::XMMATRIX mEyeViewProjections[2];
+		D3D11_VIEWPORT EyeViewports[2];
+		float fEyeSeparation = 0.0f;
+		if( bStereo )
+		{
+			float fLookAtDistance = DirectX::XMVectorGetX( DirectX::XMVector3Length( DirectX::XMVectorSubtract( g_Camera.GetEyePt(), g_Camera.GetLookAtPt() ) ) );
+			fEyeSeparation = STEREO_EYE_SEPARATION * fLookAtDistance;
+			GetStereoViews( mView, fEyeSeparation, &mEyeViews[0], &mEyeViews[1] );
+			DirectX::XMMATRIX mEyeProj = GetStereoProjection( mProj );
+			for( UINT uEye = 0; uEye < 2; uEye++ )
+			{
+				mEyeViewProjections[uEye] = mEyeViews[uEye] * mEyeProj;
+				D3D11_VIEWPORT Viewport = { (float)uEye * 0.5f * (float)uSceneWidth, 0.0f, 0.5f * (float)uSceneWidth, (float)uSceneHeight, 0.0f, 1.0f };
+				EyeViewports[uEye] = Viewport;
+			}
+		}
+
+		// Setup the constant buffer for the scene vertex shader, the tess factors are set
+		// for each policy below
+		CB_PNTRIANGLES PNTrianglesCB;
+		CB_PNTRIANGLES* pPNTrianglesCB = &PNTrianglesCB;
 		pPNTrianglesCB->f4x4World = DirectX::XMMatrixTranspose(mWorld);
 		pPNTrianglesCB->f4x4ViewProjection= DirectX::XMMatrixTranspose(mViewProjection);
 		pPNTrianglesCB->f4x4WorldViewProjection= DirectX::XMMatrixTranspose(mWorldViewProjection);
@@ -787,8 +2238,8 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pd3dDevice, ID3D11DeviceContext*
 		pPNTrianglesCB->fInsideTessFactors = (float)g_uTessFactor;
 		pPNTrianglesCB->fMinDistance = (float)g_v3AdaptiveTessParams[g_eMeshType].x;
 		pPNTrianglesCB->fTessRange   = (float)g_v3AdaptiveTessParams[g_eMeshType].y;
-		pPNTrianglesCB->fScreenSize[0] = (float)DXUTGetDXGIBackBufferSurfaceDesc()->Width;
-		pPNTrianglesCB->fScreenSize[1] = (float)DXUTGetDXGIBackBufferSurfaceDesc()->Height;
+		pPNTrianglesCB->fScreenSize[0] = (float)uSceneWidth;
+		pPNTrianglesCB->fScreenSize[1] = (float)uSceneHeight;
 		pPNTrianglesCB->fGUIBackFaceEpsilon = g_fBackFaceCullEpsilon;
 		pPNTrianglesCB->fGUISilhouetteEpsilon = ( g_fSilhoutteEpsilon > 0.99f ) ? ( 0.99f ) : ( g_fSilhoutteEpsilon );
 		pPNTrianglesCB->fGUIRangeScale = g_fRangeScale;
@@ -799,36 +2250,51 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pd3dDevice, ID3D11DeviceContext*
 		pPNTrianglesCB->f4ViewFrustumPlanes[1] = f4ViewFrustumPlanes[1]; 
 		pPNTrianglesCB->f4ViewFrustumPlanes[2] = f4ViewFrustumPlanes[2]; 
 		pPNTrianglesCB->f4ViewFrustumPlanes[3] = f4ViewFrustumPlanes[3]; 
-		pd3dImmediateContext->Unmap( g_pcbPNTriangles, 0 );
+		float fScreenHeight = pPNTrianglesCB->fScreenSize[1];
+		pPNTrianglesCB->f4Fovea = DirectX::XMFLOAT4( g_f2FoveaFocus.x * pPNTrianglesCB->fScreenSize[0], g_f2FoveaFocus.y * fScreenHeight,
+		                                             g_fFoveaInnerRadius * fScreenHeight, g_fFoveaOuterRadius * fScreenHeight );
+		pPNTrianglesCB->fGUIFoveaPeripheryScale = g_fFoveaPeripheryScale;
+		DirectX::XMFLOAT2 f2ResolutionReference = GetResolutionReference( fTessScale );
+		pPNTrianglesCB->fResolutionReference[0] = f2ResolutionReference.x;
+		pPNTrianglesCB->fResolutionReference[1] = f2ResolutionReference.y;
+		pPNTrianglesCB->f4Upscale = DirectX::XMFLOAT4( (float)uBackBufferWidth, (float)uBackBufferHeight, (float)uSceneWidth, (float)uSceneHeight );
+		pPNTrianglesCB->f4x4PrevViewProjection = DirectX::XMMatrixTranspose( g_CameraMotion.GetPreviousViewProjection() );
+		pPNTrianglesCB->f4Motion = DirectX::XMFLOAT4( g_fMotionThreshold, TESS_MOTION_FULL_VELOCITY, g_fMotionMinScale, 0.0f );
+		pPNTrianglesCB->uNumViews = 0;
+		pPNTrianglesCB->uFirstInstance = 0;
+		pPNTrianglesCB->fSilhouetteInflation = 0.0f;
+		if( bStereo )
+		{
+			pPNTrianglesCB->fScreenSize[0] = 0.5f * (float)uSceneWidth;
+			pPNTrianglesCB->uNumViews = 2;
+			for( UINT uEye = 0; uEye < 2; uEye++ )
+			{
+				pPNTrianglesCB->f4x4MultiViewProjection[uEye] = DirectX::XMMatrixTranspose( mEyeViewProjections[uEye] );
+				DirectX::XMStoreFloat4( &pPNTrianglesCB->f4MultiViewEye[uEye], DirectX::XMMatrixInverse( NULL, mEyeViews[uEye] ).r[3] );
+				DirectX::XMStoreFloat4( &pPNTrianglesCB->f4MultiViewVector[uEye], v3ViewVector );
+				DirectX::XMFLOAT4 f4EyeFrustumPlanes[6];
+				ExtractPlanesFromFrustum( f4EyeFrustumPlanes, &mEyeViewProjections[uEye] );
+				for( UINT uPlane = 0; uPlane < 4; uPlane++ )
+				{
+					pPNTrianglesCB->f4MultiViewFrustumPlanes[uEye * 4 + uPlane] = f4EyeFrustumPlanes[uPlane];
+				}
+			}
+		}
 
 		pd3dImmediateContext->VSSetConstantBuffers( g_iPNTRIANGLESCBBind, 1, &g_pcbPNTriangles );
 		pd3dImmediateContext->PSSetConstantBuffers( g_iPNTRIANGLESCBBind, 1, &g_pcbPNTriangles );
+		pd3dImmediateContext->HSSetConstantBuffers( g_iPNTRIANGLESCBBind, 1, &g_pcbPNTriangles );
+		pd3dImmediateContext->DSSetConstantBuffers( g_iPNTRIANGLESCBBind, 1, &g_pcbPNTriangles );
+		pd3dImmediateContext->GSSetConstantBuffers( g_iPNTRIANGLESCBBind, 1, &g_pcbPNTriangles );
 
 		// Based on app and GUI settings set a bunch of bools that guide the render
 		bool bTextured = g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_TEXTURED )->GetChecked() && g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_TEXTURED )->GetEnabled();
-		bool bTessellation = g_HUD.m_GUI.GetComboBox( IDC_COMBO_TESSELLATION )->GetSelectedIndex() != TESSELLATION_COMBO_NO_TESSELLATION;
-		        
-		// VS
-		pd3dImmediateContext->VSSetShader( bTessellation?g_pSceneWithTessellationVS:g_pSceneVS, NULL, 0 );
-		pd3dImmediateContext->IASetInputLayout( g_pSceneVertexLayout );
+		// The tessellation drawn is that of the UI, once its shaders are ready
+		bool bTessellation = 0 != ( g_dwDrawnHullShaderHash & ( PNTRI | PHONG ) );
+		bool bWorldSpace = g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_WORLD_SPACE_VERTICES )->GetChecked() &&
+		                   UpdateWorldSpaceVertices( pd3dImmediateContext, mWorld );
 
-		// HS
-		ID3D11HullShader* pHS = NULL;
-		if( bTessellation )
-		{
-			pd3dImmediateContext->HSSetConstantBuffers( g_iPNTRIANGLESCBBind, 1, &g_pcbPNTriangles );
-			pHS = g_HullShaders[HullShaderHash];
-		}
-		pd3dImmediateContext->HSSetShader( pHS, NULL, 0 );    
-    
-		// DS
-		ID3D11DomainShader* pDS = NULL;
-		if( bTessellation )
-		{
-			pd3dImmediateContext->DSSetConstantBuffers( g_iPNTRIANGLESCBBind, 1, &g_pcbPNTriangles );
-			pDS = g_DomainShaders[HullShaderHash];
-		}
-		pd3dImmediateContext->DSSetShader( pDS, NULL, 0 );
+		pd3dImmediateContext->IASetInputLayout( g_pSceneVertexLayout );
     
 		// GS
 		pd3dImmediateContext->GSSetShader( NULL, NULL, 0 );
@@ -857,16 +2323,207 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pd3dDevice, ID3D11DeviceContext*
 		{
 			uDiffuseSlot = INVALID_SAMPLER_SLOT;
 		}
-		// Decide which prim topology to use
-		D3D11_PRIMITIVE_TOPOLOGY PrimitiveTopology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
-		if( bTessellation )
+		// Cull the runs of triangles on the CPU if enabled
+		const BYTE* pVisible = NULL;
+		if( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_CPU_VISIBILITY )->GetChecked() )
+		{
+			// The eyes see past the edges of the occluders, so stereo is only frustum culled
+			bool bOcclusion = g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_OCCLUSION_CULL )->GetChecked() && !bStereo;
+			pVisible = GetVisibility( mWorld, mView, mProj, bOcclusion );
+		}
+
+		// With the instance grid the copies of the mesh are culled to the frustum of the camera,
+		// in stereo widened at the sides to hold both eyes, and binned by their size on
+		// screen. The world matrices of the visible ones are uploaded bin after bin. The CPU
+		// visibility and the world space vertices are of the single mesh, so they are not used.
+		bool bInstanced = g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_INSTANCES )->GetChecked() && NULL != g_pInstanceWorldSRV;
+		if( bInstanced )
+		{
+			if( g_iInstanceMeshType != (int)g_eMeshType )
+			{
+				PlaceInstanceGrid();
+			}
+
+			INSTANCE_BIN_SETTINGS BinSettings;
+			BinSettings.fFullDiameter = INSTANCE_FULL_DIAMETER;
+			BinSettings.fMinDiameter = TESS_PATH_MIN_DIAMETER;
+			BinSettings.uNumTessTiers = INSTANCE_NUM_TESS_TIERS;
+			BinSettings.fMaxTessFactor = (float)g_uTessFactor;
+			g_InstanceSet.CullAndBin( mView, mProj, (float)uSceneHeight, fEyeSeparation, &BinSettings, &g_InstanceBins );
+
+			D3D11_MAPPED_SUBRESOURCE MappedResource;
+			if( SUCCEEDED( pd3dImmediateContext->Map( g_pInstanceWorldBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource ) ) )
+			{
+				g_InstanceSet.WriteWorldMatrices( (DirectX::XMFLOAT4X4*)MappedResource.pData );
+				pd3dImmediateContext->Unmap( g_pInstanceWorldBuffer, 0 );
+			}
+			pd3dImmediateContext->VSSetShaderResources( 2, 1, &g_pInstanceWorldSRV );
+
+			pVisible = NULL;
+			bWorldSpace = false;
+		}
+
+		// Choose the path of each mesh from the size of its bounds on screen, the instances
+		// are binned instead
+		bool bHybridPath = bTessellation && g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_HYBRID_PATH )->GetChecked() && !bInstanced;
+		if( bHybridPath )
+		{
+			CDXUTSDKMesh* pSceneMesh = &g_SceneMesh[g_eMeshType];
+			if( g_iTessPathMeshType != (int)g_eMeshType || g_TessPathSelector.GetNumObjects() != pSceneMesh->GetNumMeshes() )
+			{
+				g_TessPathSelector.Reset( pSceneMesh->GetNumMeshes() );
+				g_iTessPathMeshType = (int)g_eMeshType;
+			}
+
+			g_TessPathSelector.BeginFrame();
+			for( UINT uMesh = 0; uMesh < pSceneMesh->GetNumMeshes(); uMesh++ )
+			{
+				DirectX::XMVECTOR vCenter;
+				float fRadius;
+				GetWorldBoundingSphere( pSceneMesh->GetMeshBBoxCenter( uMesh ), pSceneMesh->GetMeshBBoxExtents( uMesh ), mWorld, &vCenter, &fRadius );
+				g_TessPathSelector.Select( uMesh, GetProjectedSphereDiameter( vCenter, fRadius, mView, mProj, (float)uSceneHeight ) );
+			}
+		}
+
+		// The progressive mesh is refined for the view and drawn after the passes instead of
+		// the subsets, of the single mesh and for one eye
+		bool bProgressiveMesh = !bTessellation && g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_PROGRESSIVE_MESH )->GetChecked() && !bInstanced && !bStereo;
+		if( bProgressiveMesh )
+		{
+			bProgressiveMesh = UpdateProgressiveMesh( pd3dImmediateContext, mWorld, mView, mProj, (float)uSceneHeight );
+		}
+
+		// Likewise the cut of the cluster DAG
+		bool bClusterLOD = !bTessellation && g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_CLUSTER_LOD )->GetChecked() && !bInstanced && !bStereo &&
+		                   !bProgressiveMesh;
+		if( bClusterLOD )
+		{
+			bClusterLOD = SelectClusterCut( mWorld, mView, mProj, (float)uSceneHeight );
+		}
+
+		// Silhouette clipping draws the fans of the silhouette edges of the detailed mesh to the
+		// stencil, with the constants of the frame, and then the coarse mesh only where the
+		// stencil is not 0. The fans are of the single mesh, and drawn for one eye.
+		bool bSilhouetteClip = !bTessellation && g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_SILHOUETTE_CLIP )->GetChecked() && !bInstanced && !bStereo &&
+		                       !bProgressiveMesh && !bClusterLOD;
+		if( bSilhouetteClip )
+		{
+			UpdatePNTrianglesCB( pd3dImmediateContext, pPNTrianglesCB );
+
+			bSilhouetteClip = RenderSilhouetteFans( pd3dImmediateContext, mWorld );
+			pPNTrianglesCB->fSilhouetteInflation = bSilhouetteClip ? g_fSilhouetteInflation : 0.0f;
+			pd3dImmediateContext->PSSetShader( pPS, NULL, 0 );
+			pd3dImmediateContext->RSSetState( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_WIREFRAME )->GetChecked()?g_pRasterizerStateWireframe:g_pRasterizerStateSolid );
+			pd3dImmediateContext->OMSetDepthStencilState( NULL, 0 );
+			bWorldSpace = false;
+		}
+
+		// Render the subsets of each tessellation policy as one batch, so the shaders and
+		// the tess factors are set once per policy rather than per subset. With the depth
+		// pre-pass every policy is first drawn to depth only, with the DEPTH_ONLY domain shaders
+		// and no pixel shader, and the colour pass then only shades the visible pixels. Stereo
+		// draws the tessellated subsets with MULTI_VIEW, which has no DEPTH_ONLY permutations.
+		SCENE_PASS_STATE PassState;
+		PassState.pPNTrianglesCB = pPNTrianglesCB;
+		PassState.pWorld = &mWorld;
+		PassState.pEyeViewProjections = mEyeViewProjections;
+		PassState.pEyeViewports = EyeViewports;
+		PassState.pPS = pPS;
+		PassState.pVisible = pVisible;
+		PassState.uDiffuseSlot = uDiffuseSlot;
+		PassState.bTessellation = bTessellation;
+		PassState.bStereo = bStereo;
+		PassState.bWorldSpace = bWorldSpace;
+		PassState.bInstanced = bInstanced;
+		PassState.bHybridPath = bHybridPath;
+		PassState.bSilhouetteClip = bSilhouetteClip;
+		PassState.bDepthPrePass = g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_DEPTH_PREPASS )->GetChecked() && !bStereo && !bProgressiveMesh && !bClusterLOD;
+		PassState.fBoundTessFactor = -1.0f;
+
+		memset( &g_DepthPrePassStats, 0, sizeof( g_DepthPrePassStats ) );
+		if( !bProgressiveMesh && !bClusterLOD )
+		{
+			if( PassState.bDepthPrePass )
+			{
+				RenderTessPass( pd3dImmediateContext, TESS_PASS_DEPTH, &PassState );
+			}
+			RenderTessPass( pd3dImmediateContext, TESS_PASS_COLOR, &PassState );
+		}
+
+		// The progressive mesh, with the constants of the frame and the pixel shader of the
+		// colour pass
+		if( bProgressiveMesh )
+		{
+			UpdatePNTrianglesCB( pd3dImmediateContext, pPNTrianglesCB );
+
+			CProgressiveMesh* pMesh = &g_ProgressiveMesh[g_eMeshType];
+			ID3D11Buffer* pVB = pMesh->GetVB();
+			UINT uStride = sizeof( PN_VERTEX ), uOffset = 0;
+			pd3dImmediateContext->IASetVertexBuffers( 0, 1, &pVB, &uStride, &uOffset );
+			pd3dImmediateContext->IASetIndexBuffer( pMesh->GetIB(), DXGI_FORMAT_R32_UINT, 0 );
+			pd3dImmediateContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+			pd3dImmediateContext->VSSetShader( g_pSceneVS, NULL, 0 );
+			pd3dImmediateContext->HSSetShader( NULL, NULL, 0 );
+			pd3dImmediateContext->DSSetShader( NULL, NULL, 0 );
+			pd3dImmediateContext->DrawIndexed( pMesh->GetNumIndicesToDraw(), 0, 0 );
+		}
+
+		// The clusters of the cut, a draw per run of clusters adjacent in the index buffer
+		if( bClusterLOD )
+		{
+			UpdatePNTrianglesCB( pd3dImmediateContext, pPNTrianglesCB );
+
+			CClusterDAG* pDAG = &g_ClusterDAG[g_eMeshType];
+			const std::vector<CLUSTER>& Clusters = pDAG->GetClusters();
+			ID3D11Buffer* pVB = pDAG->GetVB();
+			UINT uStride = sizeof( PN_VERTEX ), uOffset = 0;
+			pd3dImmediateContext->IASetVertexBuffers( 0, 1, &pVB, &uStride, &uOffset );
+			pd3dImmediateContext->IASetIndexBuffer( pDAG->GetIB(), DXGI_FORMAT_R32_UINT, 0 );
+			pd3dImmediateContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+			pd3dImmediateContext->VSSetShader( g_pSceneVS, NULL, 0 );
+			pd3dImmediateContext->HSSetShader( NULL, NULL, 0 );
+			pd3dImmediateContext->DSSetShader( NULL, NULL, 0 );
+			for( UINT i = 0; i < (UINT)g_ClusterCut.size(); )
+			{
+				const CLUSTER& First = Clusters[g_ClusterCut[i]];
+				UINT uNumIndices = First.uNumTriangles * 3;
+				for( i++; i < (UINT)g_ClusterCut.size() && Clusters[g_ClusterCut[i]].uFirstIndex == First.uFirstIndex + uNumIndices; i++ )
+				{
+					uNumIndices += Clusters[g_ClusterCut[i]].uNumTriangles * 3;
+				}
+				pd3dImmediateContext->DrawIndexed( uNumIndices, First.uFirstIndex, 0 );
+			}
+		}
+		pd3dImmediateContext->OMSetDepthStencilState( NULL, 0 );
+
+		// Restore the single viewport of the scene
+		if( bStereo )
 		{
-			PrimitiveTopology = D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST;
+			pd3dImmediateContext->GSSetShader( NULL, NULL, 0 );
+			D3D11_VIEWPORT Viewport = { 0.0f, 0.0f, (float)uSceneWidth, (float)uSceneHeight, 0.0f, 1.0f };
+			pd3dImmediateContext->RSSetViewports( 1, &Viewport );
 		}
-		// Render the meshes    
-		for( int iMesh = 0; iMesh < (int)g_SceneMesh[g_eMeshType].GetNumMeshes(); iMesh++ )
+
+		// Upscale the scene to the back buffer, and restore the full viewport for the HUD
+		if( bDynamicResolution )
 		{
-			RenderMesh( &g_SceneMesh[g_eMeshType], (UINT)iMesh, PrimitiveTopology, uDiffuseSlot );
+			pd3dImmediateContext->OMSetRenderTargets( 1, &pRTV, NULL );
+			D3D11_VIEWPORT Viewport = { 0.0f, 0.0f, (float)uBackBufferWidth, (float)uBackBufferHeight, 0.0f, 1.0f };
+			pd3dImmediateContext->RSSetViewports( 1, &Viewport );
+			pd3dImmediateContext->RSSetState( g_pRasterizerStateSolid );
+			pd3dImmediateContext->IASetInputLayout( NULL );
+			pd3dImmediateContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+			pd3dImmediateContext->VSSetShader( g_pFullScreenVS, NULL, 0 );
+			pd3dImmediateContext->HSSetShader( NULL, NULL, 0 );
+			pd3dImmediateContext->DSSetShader( NULL, NULL, 0 );
+			pd3dImmediateContext->PSSetShader( g_pUpscalePS, NULL, 0 );
+			pd3dImmediateContext->PSSetSamplers( 0, 2, ppSamplerStates );
+			pd3dImmediateContext->PSSetShaderResources( 1, 1, &g_pSceneColorSRV );
+			pd3dImmediateContext->Draw( 3, 0 );
+
+			ID3D11ShaderResourceView* pNullSRV = NULL;
+			pd3dImmediateContext->PSSetShaderResources( 1, 1, &pNullSRV );
+			pd3dImmediateContext->OMSetRenderTargets( 1, &pRTV, pDSV );
 		}
 		
 		TIMER_End() // Effect
@@ -874,7 +2531,9 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pd3dDevice, ID3D11DeviceContext*
 
 	DXUT_BeginPerfEvent( DXUT_PERFEVENTCOLOR, L"HUD / Stats" );
 
-    if( g_ShaderCache.ShadersReady() )
+    // The HUD stays up while the permutations of an optional family compile, with the
+    // progress in place of the statistics
+    if( g_bSceneShadersCreated )
     {		
 		
 		// Render the HUD
@@ -883,7 +2542,10 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pd3dDevice, ID3D11DeviceContext*
             g_MagnifyTool.Render();
             g_HUD.OnRender( fElapsedTime );
         }
+    }
 
+    if( bShadersReady )
+    {
         RenderText();
     }
     else
@@ -910,6 +2572,10 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pd3dDevice, ID3D11DeviceContext*
 void CALLBACK OnD3D11ReleasingSwapChain( void* pUserContext )
 {
     g_DialogResourceManager.OnD3D11ReleasingSwapChain();
+
+    SAFE_RELEASE( g_pSceneColorSRV );
+    SAFE_RELEASE( g_pSceneColorRTV );
+    SAFE_RELEASE( g_pSceneColor );
 }
 
 
@@ -925,8 +2591,31 @@ void CALLBACK OnD3D11DestroyDevice( void* pUserContext )
 
 	g_Light.StaticOnD3D11DestroyDevice();
 
+    g_VisibilityStage.Destroy();
+    g_VisibilityItems.clear();
+    g_VisibilityItemRanges.clear();
+    g_OccluderPositions.clear();
+    g_OccluderIndices.clear();
+    g_VisibilityItemFirstIndex.clear();
+    g_iVisibilityMeshType = -1;
+    g_OcclusionBuffer.Destroy();
+    g_uOcclusionBufferHeight = 0;
+
+    for( int i = 0; i < MESH_TYPE_MAX; i++ )
+    {
+        g_WorldSpaceVertices[i].Destroy();
+        g_ProgressiveMesh[i].DestroyBuffers();
+        g_ClusterDAG[i].DestroyBuffers();
+    }
+    g_WorldSpacePool.Destroy();
+
     SAFE_RELEASE( g_pSceneVS );
     SAFE_RELEASE( g_pSceneWithTessellationVS );
+    SAFE_RELEASE( g_pSceneWorldSpaceVS );
+    SAFE_RELEASE( g_pSceneWorldSpaceTessellationVS );
+    SAFE_RELEASE( g_pSceneInstancedVS );
+    SAFE_RELEASE( g_pSceneInstancedTessellationVS );
+    SAFE_RELEASE( g_pSceneSilhouetteClipVS );
 
 	g_SceneMesh[MESH_TYPE_MUSHROOMS].Destroy();
 	g_SceneMesh[MESH_TYPE_TIGER].Destroy();
@@ -944,12 +2633,21 @@ void CALLBACK OnD3D11DestroyDevice( void* pUserContext )
 	{
 		SAFE_RELEASE( it->second );
 	}
+	g_ShaderPermutations.OnDestroyDevice();
 
     SAFE_RELEASE( g_pPNTrianglesDS );
     SAFE_RELEASE( g_pScenePS );
     SAFE_RELEASE( g_pTexturedScenePS );
+    SAFE_RELEASE( g_pFullScreenVS );
+    SAFE_RELEASE( g_pUpscalePS );
+    SAFE_RELEASE( g_pMultiViewGS );
         
     SAFE_RELEASE( g_pcbPNTriangles );
+    SAFE_RELEASE( g_pInstanceWorldSRV );
+    SAFE_RELEASE( g_pInstanceWorldBuffer );
+    g_iInstanceMeshType = -1;
+    SAFE_RELEASE( g_pSilhouetteFanVB );
+    g_uSilhouetteFanVBSize = 0;
 
     SAFE_RELEASE( g_pSceneVertexLayout );
     SAFE_RELEASE( g_pSceneVertexLayoutTess );
@@ -959,10 +2657,14 @@ void CALLBACK OnD3D11DestroyDevice( void* pUserContext )
 
     SAFE_RELEASE( g_pRasterizerStateWireframe );
     SAFE_RELEASE( g_pRasterizerStateSolid );
+    SAFE_RELEASE( g_pDepthStencilStateLessEqual );
+    SAFE_RELEASE( g_pDepthStencilStateSilhouetteFans );
+    SAFE_RELEASE( g_pDepthStencilStateSilhouetteClip );
     SAFE_RELEASE( g_pDiffuseTextureSRV );
 
     // Destroy AMD_SDK resources here
 	g_ShaderCache.OnDestroyDevice();
+	g_bSceneShadersCreated = false;
 	g_HUD.OnDestroyDevice();
     g_MagnifyTool.OnDestroyDevice();
     TIMER_Destroy()
@@ -1025,6 +2727,15 @@ LRESULT CALLBACK MsgProc( HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam, bo
     if( *pbNoFurtherProcessing )
         return 0;
 
+    // Move the fovea to the cursor while F is held, rather than the camera
+    if( WM_MOUSEMOVE == uMsg && ( GetKeyState( 'F' ) & 0x8000 ) )
+    {
+        const DXGI_SURFACE_DESC* pBackBufferSurfaceDesc = DXUTGetDXGIBackBufferSurfaceDesc();
+        g_f2FoveaFocus.x = (float)(short)LOWORD( lParam ) / (float)pBackBufferSurfaceDesc->Width;
+        g_f2FoveaFocus.y = (float)(short)HIWORD( lParam ) / (float)pBackBufferSurfaceDesc->Height;
+        return 0;
+    }
+
     // Pass all remaining windows messages to camera so it can respond to user input
     g_Camera.HandleMessages( hWnd, uMsg, wParam, lParam );
 
@@ -1047,6 +2758,17 @@ void CALLBACK OnKeyboard( UINT nChar, bool bKeyDown, bool bAltDown, void* pUserC
 			case VK_F1:
 				g_bRenderHUD = !g_bRenderHUD;
 				break;
+
+			// Start recording a camera path, or save it to CameraPath.txt
+			case 'R':
+				if( g_bRecordCameraPath && !g_CameraPath.empty() )
+				{
+					SaveCameraPath( L"CameraPath.txt", g_CameraPath );
+				}
+				g_bRecordCameraPath = !g_bRecordCameraPath;
+				g_CameraPath.clear();
+				g_fCameraPathSeconds = 0.0f;
+				break;
 		}
     }
 }
@@ -1123,11 +2845,23 @@ void CALLBACK OnGUIEvent( UINT nEvent, int nControlID, CDXUTControl* pControl, v
 			g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_SCREEN_RESOLUTION_ADAPTIVE )->SetEnabled( bEnable );
 			g_HUD.m_GUI.GetStatic( IDC_STATIC_SCREEN_RESOLUTION_SCALE )->SetEnabled( bEnable );
 			g_HUD.m_GUI.GetSlider( IDC_SLIDER_SCREEN_RESOLUTION_SCALE )->SetEnabled( bEnable );
+			g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_FOVEATED_ADAPTIVE )->SetEnabled( bEnable );
+			g_HUD.m_GUI.GetStatic( IDC_STATIC_FOVEA_INNER_RADIUS )->SetEnabled( bEnable );
+			g_HUD.m_GUI.GetStatic( IDC_STATIC_FOVEA_OUTER_RADIUS )->SetEnabled( bEnable );
+			g_HUD.m_GUI.GetStatic( IDC_STATIC_FOVEA_PERIPHERY_SCALE )->SetEnabled( bEnable );
+			g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_MOTION_ADAPTIVE )->SetEnabled( bEnable );
+			g_HUD.m_GUI.GetStatic( IDC_STATIC_MOTION_THRESHOLD )->SetEnabled( bEnable );
+			g_HUD.m_GUI.GetSlider( IDC_SLIDER_MOTION_THRESHOLD )->SetEnabled( bEnable );
+			g_HUD.m_GUI.GetStatic( IDC_STATIC_MOTION_MIN_SCALE )->SetEnabled( bEnable );
+			g_HUD.m_GUI.GetSlider( IDC_SLIDER_MOTION_MIN_SCALE )->SetEnabled( bEnable );
 			SetShaderFromUI();
 			break;
         case IDC_CHECKBOX_BACK_FACE_CULL:
         case IDC_CHECKBOX_VIEW_FRUSTUM_CULL:        
         case IDC_CHECKBOX_ORIENTATION_ADAPTIVE:
+        case IDC_CHECKBOX_FOVEATED_ADAPTIVE:
+        case IDC_CHECKBOX_MOTION_ADAPTIVE:
+        case IDC_CHECKBOX_PACKED_CONTROL_POINTS:
             SetShaderFromUI();
             break;
 
@@ -1209,6 +2943,51 @@ void CALLBACK OnGUIEvent( UINT nEvent, int nControlID, CDXUTControl* pControl, v
             swprintf_s( szTemp, L"%.2f", g_fViewFrustumCullEpsilon );
             g_HUD.m_GUI.GetStatic( IDC_STATIC_VIEW_FRUSTUM_CULL_EPSILON )->SetText( szTemp );
             break;
+
+        case IDC_SLIDER_FOVEA_INNER_RADIUS:
+            g_fFoveaInnerRadius = (float)((CDXUTSlider*)pControl)->GetValue() / 100.0f;
+            swprintf_s( szTemp, L"Inner %.2f", g_fFoveaInnerRadius );
+            g_HUD.m_GUI.GetStatic( IDC_STATIC_FOVEA_INNER_RADIUS )->SetText( szTemp );
+            break;
+
+        case IDC_SLIDER_FOVEA_OUTER_RADIUS:
+            g_fFoveaOuterRadius = (float)((CDXUTSlider*)pControl)->GetValue() / 100.0f;
+            swprintf_s( szTemp, L"Outer %.2f", g_fFoveaOuterRadius );
+            g_HUD.m_GUI.GetStatic( IDC_STATIC_FOVEA_OUTER_RADIUS )->SetText( szTemp );
+            break;
+
+        case IDC_SLIDER_FOVEA_PERIPHERY_SCALE:
+            g_fFoveaPeripheryScale = (float)((CDXUTSlider*)pControl)->GetValue() / 100.0f;
+            swprintf_s( szTemp, L"Scale %.2f", g_fFoveaPeripheryScale );
+            g_HUD.m_GUI.GetStatic( IDC_STATIC_FOVEA_PERIPHERY_SCALE )->SetText( szTemp );
+            break;
+
+        case IDC_SLIDER_MOTION_THRESHOLD:
+            g_fMotionThreshold = (float)((CDXUTSlider*)pControl)->GetValue();
+            swprintf_s( szTemp, L"From %.0f px", g_fMotionThreshold );
+            g_HUD.m_GUI.GetStatic( IDC_STATIC_MOTION_THRESHOLD )->SetText( szTemp );
+            break;
+
+        case IDC_SLIDER_MOTION_MIN_SCALE:
+            g_fMotionMinScale = (float)((CDXUTSlider*)pControl)->GetValue() / 100.0f;
+            swprintf_s( szTemp, L"Scale %.2f", g_fMotionMinScale );
+            g_HUD.m_GUI.GetStatic( IDC_STATIC_MOTION_MIN_SCALE )->SetText( szTemp );
+            break;
+
+        case IDC_CHECKBOX_DYNAMIC_RESOLUTION:
+            g_DynamicResolution.Reset();
+            break;
+
+        case IDC_SLIDER_DYNAMIC_RESOLUTION_TARGET:
+            g_fDynamicResolutionTargetMs = (float)((CDXUTSlider*)pControl)->GetValue() / 10.0f;
+            g_DynamicResolution.SetTargetMs( g_fDynamicResolutionTargetMs );
+            swprintf_s( szTemp, L"%.1f ms", g_fDynamicResolutionTargetMs );
+            g_HUD.m_GUI.GetStatic( IDC_STATIC_DYNAMIC_RESOLUTION_TARGET )->SetText( szTemp );
+            break;
+
+        case IDC_COMBOBOX_HUD_PAGE:
+            ShowHUDPage( HUD_PAGE_RENDER + ((CDXUTComboBox*)pControl)->GetSelectedIndex() );
+            break;
     }
 
     // Call the MagnifyTool gui event handler
@@ -1317,6 +3096,11 @@ void SetShaderFromUI()
 			g_HUD.m_GUI.GetSlider( IDC_SLIDER_RANGE_SCALE )->SetEnabled( false );
 			g_HUD.m_GUI.GetSlider( IDC_SLIDER_SCREEN_RESOLUTION_SCALE )->SetEnabled( false );
 			g_HUD.m_GUI.GetSlider( IDC_SLIDER_SILHOUTTE_EPSILON )->SetEnabled( false );
+			g_HUD.m_GUI.GetSlider( IDC_SLIDER_FOVEA_INNER_RADIUS )->SetEnabled( false );
+			g_HUD.m_GUI.GetSlider( IDC_SLIDER_FOVEA_OUTER_RADIUS )->SetEnabled( false );
+			g_HUD.m_GUI.GetSlider( IDC_SLIDER_FOVEA_PERIPHERY_SCALE )->SetEnabled( false );
+			g_HUD.m_GUI.GetSlider( IDC_SLIDER_MOTION_THRESHOLD )->SetEnabled( false );
+			g_HUD.m_GUI.GetSlider( IDC_SLIDER_MOTION_MIN_SCALE )->SetEnabled( false );
 			break;
 
 		case TESSELLATION_COMBO_PN_TESSELLATION:
@@ -1325,6 +3109,13 @@ void SetShaderFromUI()
 			HullShaderHash |= PHONG; break;
 	}
 
+	// Packed patch constants only apply to PN triangles
+	bEnable = ( HullShaderHash & PNTRI ) != 0;
+	g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_PACKED_CONTROL_POINTS )->SetEnabled( bEnable );
+	if( bEnable && g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_PACKED_CONTROL_POINTS )->GetChecked() )
+	{
+		HullShaderHash |= PACKED_CP;
+	}
 
 	bEnable = g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_SCREEN_SPACE_ADAPTIVE )->GetChecked();
 	g_HUD.m_GUI.GetSlider( IDC_SLIDER_EDGE_SIZE )->SetEnabled( bEnable );
@@ -1354,6 +3145,23 @@ void SetShaderFromUI()
 		HullShaderHash |= ORIENT_ADAPT;
 	}
 
+	bEnable = g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_FOVEATED_ADAPTIVE )->GetChecked();
+	g_HUD.m_GUI.GetSlider( IDC_SLIDER_FOVEA_INNER_RADIUS )->SetEnabled( bEnable );
+	g_HUD.m_GUI.GetSlider( IDC_SLIDER_FOVEA_OUTER_RADIUS )->SetEnabled( bEnable );
+	g_HUD.m_GUI.GetSlider( IDC_SLIDER_FOVEA_PERIPHERY_SCALE )->SetEnabled( bEnable );
+	if ( bEnable )
+	{
+		HullShaderHash |= FOVEA_ADAPT;
+	}
+
+	bEnable = g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_MOTION_ADAPTIVE )->GetChecked();
+	g_HUD.m_GUI.GetSlider( IDC_SLIDER_MOTION_THRESHOLD )->SetEnabled( bEnable && 0 != ( HullShaderHash & ( PNTRI | PHONG ) ) );
+	g_HUD.m_GUI.GetSlider( IDC_SLIDER_MOTION_MIN_SCALE )->SetEnabled( bEnable && 0 != ( HullShaderHash & ( PNTRI | PHONG ) ) );
+	if ( bEnable )
+	{
+		HullShaderHash |= MOTION_ADAPT;
+	}
+
 	bEnable = g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_BACK_FACE_CULL )->GetChecked();
 	g_HUD.m_GUI.GetSlider( IDC_SLIDER_BACK_FACE_CULL_EPSILON )->SetEnabled( bEnable );
 	if( bEnable )
@@ -1368,15 +3176,130 @@ void SetShaderFromUI()
 		HullShaderHash |= FRUST_CULL;
 	}
 
+	RequestShaderPermutations();
+}
+
+//--------------------------------------------------------------------------------------
+// Returns true if the shaders of a permutation can be set. With lazy shaders a permutation
+// not compiled yet is requested ahead of the prefetches, without it the shader cache
+// creates it along with its family.
+//--------------------------------------------------------------------------------------
+bool IsPermutationReady( DWORD dwFlags )
+{
+	auto it = g_HullShaders.find( dwFlags );
+	if( g_HullShaders.end() == it )
+	{
+		return false;
+	}
+
+	if( NULL != it->second )
+	{
+		return true;
+	}
+
+	if( g_bLazyShaders )
+	{
+		g_ShaderPermutations.Request( dwFlags, SHADER_PERMUTATION_PRIORITY_DRAWN );
+	}
+	return false;
+}
+
+//--------------------------------------------------------------------------------------
+// With lazy shaders requests the permutation selected in the UI, and prefetches those a
+// single change of the UI selects
+//--------------------------------------------------------------------------------------
+void RequestShaderPermutations()
+{
+	if( !g_bLazyShaders || 0 == ( HullShaderHash & ( PNTRI | PHONG ) ) )
+	{
+		return;
+	}
+
+	DWORD dwRequests[16];
+	UINT uNumRequests = 0;
+
+	// The other tessellation, packed patch constants only apply to PN triangles
+	DWORD dwSwapped = HullShaderHash & ~( PNTRI | PHONG | PACKED_CP );
+	if( HullShaderHash & PHONG )
+	{
+		dwSwapped |= PNTRI;
+		if( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_PACKED_CONTROL_POINTS )->GetChecked() )
+		{
+			dwSwapped |= PACKED_CP;
+		}
+	}
+	else
+	{
+		dwSwapped |= PHONG;
+	}
+	dwRequests[uNumRequests++] = dwSwapped;
+
+	// Each check box, the screen space adaptive one excludes the distance and resolution ones
+	const DWORD dwCheckBoxes[] = { PACKED_CP, FRUST_CULL, BF_CULL, MOTION_ADAPT, FOVEA_ADAPT, ORIENT_ADAPT, RES_ADAPT, DIST_ADAPT, SS_ADAPT };
+	for( UINT i = 0; i < ARRAYSIZE( dwCheckBoxes ); i++ )
+	{
+		DWORD dwToggled = HullShaderHash ^ dwCheckBoxes[i];
+		if( dwToggled & dwCheckBoxes[i] & SS_ADAPT )
+		{
+			dwToggled &= ~( DIST_ADAPT | RES_ADAPT );
+		}
+		else if( dwToggled & dwCheckBoxes[i] & ( DIST_ADAPT | RES_ADAPT ) )
+		{
+			dwToggled &= ~SS_ADAPT;
+		}
+		dwRequests[uNumRequests++] = dwToggled;
+	}
+
+	// The newest request of a priority is served first, so the selection is the last. The
+	// permutations that can't be selected are not in the maps.
+	for( UINT i = 0; i < uNumRequests; i++ )
+	{
+		auto it = g_HullShaders.find( dwRequests[i] );
+		if( g_HullShaders.end() != it && NULL == it->second )
+		{
+			g_ShaderPermutations.Request( dwRequests[i], SHADER_PERMUTATION_PRIORITY_PREFETCH );
+		}
+	}
+
+	auto it = g_HullShaders.find( HullShaderHash );
+	if( g_HullShaders.end() != it && NULL == it->second )
+	{
+		g_ShaderPermutations.Request( HullShaderHash, SHADER_PERMUTATION_PRIORITY_SELECTED );
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Creates the permutations compiled since the last frame and, once the shaders of the
+// selection are ready, draws it
+//--------------------------------------------------------------------------------------
+void UpdateDrawnHullShaderHash( ID3D11Device* pd3dDevice )
+{
+	if( g_bLazyShaders )
+	{
+		g_ShaderPermutations.CreateShaders( pd3dDevice, &g_HullShaders, &g_DomainShaders );
+	}
+
+	if( 0 == ( HullShaderHash & ( PNTRI | PHONG ) ) || IsPermutationReady( HullShaderHash ) )
+	{
+		g_dwDrawnHullShaderHash = HullShaderHash;
+	}
 }
 
 //--------------------------------------------------------------------------------------
-// Convert the flags into shader macros and request shader cache to compile the shader
+// Convert the flags into shader macros and request shader cache to compile the shader. With
+// lazy shaders the permutation is only added to the maps, for g_ShaderPermutations.
 //--------------------------------------------------------------------------------------
 void Cache(DWORD flags)
 {
+	if( g_bLazyShaders )
+	{
+		g_HullShaders[flags] = NULL;
+		g_DomainShaders[flags] = NULL;
+		return;
+	}
+
     // PNTriangles HS
-	AMD::ShaderCache::Macro ShaderMacros[] = { {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1} };
+	AMD::ShaderCache::Macro ShaderMacros[] = { {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1}, {L"",1} };
 	int flagCount = 0;
 
     if (flags & SS_ADAPT)
@@ -1391,6 +3314,12 @@ void Cache(DWORD flags)
 	if (flags & ORIENT_ADAPT)
 		wcscpy_s(ShaderMacros[flagCount++].m_wsName, L"ORIENT_ADAPT");
 
+	if (flags & FOVEA_ADAPT)
+		wcscpy_s(ShaderMacros[flagCount++].m_wsName, L"FOVEA_ADAPT");
+
+	if (flags & MOTION_ADAPT)
+		wcscpy_s(ShaderMacros[flagCount++].m_wsName, L"MOTION_ADAPT");
+
 	if (flags & BF_CULL)
 		wcscpy_s(ShaderMacros[flagCount++].m_wsName, L"BF_CULL");
 	
@@ -1403,6 +3332,20 @@ void Cache(DWORD flags)
 	if (flags & PNTRI)
 		wcscpy_s(ShaderMacros[flagCount++].m_wsName, L"PNTRI");		
 
+	if (flags & PACKED_CP)
+		wcscpy_s(ShaderMacros[flagCount++].m_wsName, L"PACKED_CP");
+
+	if (flags & MULTI_VIEW)
+		wcscpy_s(ShaderMacros[flagCount++].m_wsName, L"MULTI_VIEW");
+
+	if (flags & DEPTH_ONLY)
+		wcscpy_s(ShaderMacros[flagCount++].m_wsName, L"DEPTH_ONLY");
+
+	if( g_HullShaders.end() != g_HullShaders.find( flags ) )
+	{
+		return;
+	}
+
 	g_HullShaders[flags] = NULL;
 	g_DomainShaders[flags] = NULL;
 	auto itHull =  g_HullShaders.find(flags);
@@ -1433,28 +3376,27 @@ HRESULT AddShadersToCache()
 	g_ShaderCache.AddShader( (ID3D11DeviceChild**)&g_pSceneWithTessellationVS, AMD::ShaderCache::SHADER_TYPE_VERTEX, L"vs_4_0", L"VS_RenderSceneWithTessellation",
         L"SilhouetteTessellation11.hlsl", 0, NULL, &g_pSceneVertexLayoutTess, (D3D11_INPUT_ELEMENT_DESC*)Layout, ARRAYSIZE( Layout ) );
 
-	DWORD culling[] = {0, BF_CULL, FRUST_CULL, FRUST_CULL|BF_CULL };
-	DWORD tessellation[] = {PNTRI, PHONG};
-	DWORD orientation[] = {0, ORIENT_ADAPT};
+	// Pass through permutations reading the world space vertex buffers, with the same layout
+	AMD::ShaderCache::Macro WorldSpaceMacro = { L"WORLD_SPACE_VB", 1 };
+	g_ShaderCache.AddShader( (ID3D11DeviceChild**)&g_pSceneWorldSpaceVS, AMD::ShaderCache::SHADER_TYPE_VERTEX, L"vs_4_0", L"VS_RenderScene",
+        L"SilhouetteTessellation11.hlsl", 1, &WorldSpaceMacro, NULL, NULL, 0 );
 
-	for(int o=0;o<2;o++)
-	{
-		for(int t=0;t<2;t++)
-		{
-			for(int c=0;c<4;c++)
-			{
-				DWORD common = tessellation[t] | culling[c] | orientation[o];
+	g_ShaderCache.AddShader( (ID3D11DeviceChild**)&g_pSceneWorldSpaceTessellationVS, AMD::ShaderCache::SHADER_TYPE_VERTEX, L"vs_4_0", L"VS_RenderSceneWithTessellation",
+        L"SilhouetteTessellation11.hlsl", 1, &WorldSpaceMacro, NULL, NULL, 0 );
 
-				Cache(common);
+	// Permutations reading the world matrix of each instance, with the same layout
+	AMD::ShaderCache::Macro InstancedMacro = { L"INSTANCED", 1 };
+	g_ShaderCache.AddShader( (ID3D11DeviceChild**)&g_pSceneInstancedVS, AMD::ShaderCache::SHADER_TYPE_VERTEX, L"vs_4_0", L"VS_RenderScene",
+        L"SilhouetteTessellation11.hlsl", 1, &InstancedMacro, NULL, NULL, 0 );
 
-				Cache(common | SS_ADAPT);
+	g_ShaderCache.AddShader( (ID3D11DeviceChild**)&g_pSceneInstancedTessellationVS, AMD::ShaderCache::SHADER_TYPE_VERTEX, L"vs_4_0", L"VS_RenderSceneWithTessellation",
+        L"SilhouetteTessellation11.hlsl", 1, &InstancedMacro, NULL, NULL, 0 );
 
-				Cache(common | DIST_ADAPT);
-				Cache(common | DIST_ADAPT | RES_ADAPT);
-				Cache(common | RES_ADAPT);
-			}	
-		}
-	}
+	AMD::ShaderCache::Macro SilhouetteClipMacro = { L"SILHOUETTE_CLIP", 1 };
+	g_ShaderCache.AddShader( (ID3D11DeviceChild**)&g_pSceneSilhouetteClipVS, AMD::ShaderCache::SHADER_TYPE_VERTEX, L"vs_4_0", L"VS_RenderScene",
+        L"SilhouetteTessellation11.hlsl", 1, &SilhouetteClipMacro, NULL, NULL, 0 );
+
+	CacheHullShaders();
 
     // Main scene PS (no textures)
     g_ShaderCache.AddShader( (ID3D11DeviceChild**)&g_pScenePS, AMD::ShaderCache::SHADER_TYPE_PIXEL, L"ps_4_0", L"PS_RenderScene",
@@ -1464,9 +3406,136 @@ HRESULT AddShadersToCache()
     g_ShaderCache.AddShader( (ID3D11DeviceChild**)&g_pTexturedScenePS, AMD::ShaderCache::SHADER_TYPE_PIXEL, L"ps_4_0", L"PS_RenderSceneTextured",
         L"SilhouetteTessellation11.hlsl", 0, NULL, NULL, NULL, 0 );
 
+    // Dynamic resolution upscale
+    g_ShaderCache.AddShader( (ID3D11DeviceChild**)&g_pFullScreenVS, AMD::ShaderCache::SHADER_TYPE_VERTEX, L"vs_4_0", L"VS_FullScreen",
+        L"SilhouetteTessellation11.hlsl", 0, NULL, NULL, NULL, 0 );
+
+    g_ShaderCache.AddShader( (ID3D11DeviceChild**)&g_pUpscalePS, AMD::ShaderCache::SHADER_TYPE_PIXEL, L"ps_4_0", L"PS_Upscale",
+        L"SilhouetteTessellation11.hlsl", 0, NULL, NULL, NULL, 0 );
+
+	AMD::ShaderCache::Macro MultiViewMacro = { L"MULTI_VIEW", 1 };
+	g_ShaderCache.AddShader( (ID3D11DeviceChild**)&g_pMultiViewGS, AMD::ShaderCache::SHADER_TYPE_GEOMETRY, L"gs_5_0", L"GS_MultiView",
+        L"SilhouetteTessellation11.hlsl", 1, &MultiViewMacro, NULL, NULL, 0 );
+
 	return hr;
 }
 
+//--------------------------------------------------------------------------------------
+// Adds the HS/DS permutations to the shader cache, skipping the optional adaptive terms
+// not compiled yet. Permutations already in the cache are left alone
+//--------------------------------------------------------------------------------------
+void CacheHullShaders()
+{
+	DWORD culling[] = {0, BF_CULL, FRUST_CULL, FRUST_CULL|BF_CULL };
+	DWORD tessellation[] = {PNTRI, PHONG, PNTRI|PACKED_CP};
+	DWORD orientation[] = {0, ORIENT_ADAPT};
+	DWORD fovea[] = {0, FOVEA_ADAPT};
+	DWORD motion[] = {0, MOTION_ADAPT};
+
+	for(int m=0;m<2;m++)
+	{
+		for(int f=0;f<2;f++)
+		{
+			if( ( motion[m] | fovea[f] ) & ~g_dwCachedOptionalFlags )
+			{
+				continue;
+			}
+
+			for(int o=0;o<2;o++)
+			{
+				for(int t=0;t<3;t++)
+				{
+					for(int c=0;c<4;c++)
+					{
+						DWORD common = tessellation[t] | culling[c] | orientation[o] | fovea[f] | motion[m];
+
+						Cache(common);
+
+						Cache(common | SS_ADAPT);
+
+						Cache(common | DIST_ADAPT);
+						Cache(common | DIST_ADAPT | RES_ADAPT);
+						Cache(common | RES_ADAPT);
+
+						// Depth pre-pass permutations, along with the fovea and motion terms
+						// cached, so every policy gets a pre-pass
+						if( DEPTH_ONLY & g_dwCachedOptionalFlags )
+						{
+							DWORD depth = GetTessPassFlags( TESS_PASS_DEPTH, common );
+
+							Cache(depth);
+
+							Cache(depth | SS_ADAPT);
+
+							Cache(depth | DIST_ADAPT);
+							Cache(depth | DIST_ADAPT | RES_ADAPT);
+							Cache(depth | RES_ADAPT);
+						}
+					}	
+				}
+			}
+		}
+	}
+
+	// Multi-view permutations, without the terms evaluated for a single view
+	if( MULTI_VIEW & g_dwCachedOptionalFlags )
+	{
+		for(int o=0;o<2;o++)
+		{
+			for(int t=0;t<3;t++)
+			{
+				for(int c=0;c<4;c++)
+				{
+					DWORD common = GetMultiViewTessFlags( tessellation[t] | culling[c] | orientation[o] );
+
+					Cache(common);
+
+					Cache(common | SS_ADAPT);
+
+					Cache(common | DIST_ADAPT);
+					Cache(common | DIST_ADAPT | RES_ADAPT);
+					Cache(common | RES_ADAPT);
+				}
+			}
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Adds the permutations of the optional adaptive terms used by the UI or the current
+// mesh's tess policies to the shader cache, the first time each is used
+//--------------------------------------------------------------------------------------
+void CacheOptionalPermutations()
+{
+	DWORD dwUsedFlags = HullShaderHash;
+	const CTessPolicyTable* pPolicies = &g_TessPolicies[g_eMeshType];
+	for( UINT uPolicy = 0; uPolicy < pPolicies->GetNumPolicies(); uPolicy++ )
+	{
+		if( pPolicies->IsPolicyUsed( uPolicy ) )
+		{
+			dwUsedFlags |= GetTessPolicyFlags( pPolicies->GetPolicy( uPolicy ), HullShaderHash );
+		}
+	}
+	if( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_STEREO )->GetChecked() )
+	{
+		dwUsedFlags |= MULTI_VIEW;
+	}
+	else if( g_HUD.m_GUI.GetCheckBox( IDC_CHECKBOX_DEPTH_PREPASS )->GetChecked() )
+	{
+		dwUsedFlags |= DEPTH_ONLY;
+	}
+
+	DWORD dwMissingFlags = dwUsedFlags & OPTIONAL_PERMUTATION_FLAGS & ~g_dwCachedOptionalFlags;
+	if( 0 == dwMissingFlags || !g_ShaderCache.ShadersReady() )
+	{
+		return;
+	}
+
+	g_dwCachedOptionalFlags |= dwMissingFlags;
+	CacheHullShaders();
+	g_ShaderCache.GenerateShaders( AMD::ShaderCache::CREATE_TYPE_COMPILE_CHANGES, true );
+}
+
 
 //--------------------------------------------------------------------------------------
 // EOF.
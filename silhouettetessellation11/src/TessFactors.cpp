@@ -0,0 +1,506 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TessFactors.cpp
+//
+// CPU reference of the tess factors HS_PNTrianglesConstant outputs, and their heatmaps.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "TessFactors.h"
+#include "TriTessellator.h"
+
+using namespace DirectX;
+
+// Edge 0 is I[2] - I[0], edge 1 is I[0] - I[1] and edge 2 is I[1] - I[2]
+static const UINT EDGE_CORNERS[3][2] = { { 2, 0 }, { 0, 1 }, { 1, 2 } };
+
+
+//--------------------------------------------------------------------------------------
+// HLSL saturate and lerp
+//--------------------------------------------------------------------------------------
+static inline float Saturate( float fValue )
+{
+    return std::min( std::max( fValue, 0.0f ), 1.0f );
+}
+
+static inline float Lerp( float fA, float fB, float fS )
+{
+    return fA + ( fB - fA ) * fS;
+}
+
+
+//--------------------------------------------------------------------------------------
+// GetScreenSpacePosition. Returns false if the point is not in front of the eye, where
+// the shader would divide by a w <= 0.
+//--------------------------------------------------------------------------------------
+static bool GetScreenSpacePosition( const XMFLOAT3& f3Position, CXMMATRIX mViewProjection, float fScreenWidth, float fScreenHeight,
+                                    XMFLOAT2* pf2ScreenPosition )
+{
+    XMFLOAT4 f4Projected;
+    XMStoreFloat4( &f4Projected, XMVector4Transform( XMVectorSetW( XMLoadFloat3( &f3Position ), 1.0f ), mViewProjection ) );
+
+    pf2ScreenPosition->x = ( f4Projected.x / f4Projected.w + 1.0f ) * 0.5f * fScreenWidth;
+    pf2ScreenPosition->y = ( -f4Projected.y / f4Projected.w + 1.0f ) * 0.5f * fScreenHeight;
+
+    return f4Projected.w > 0.0f;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Sets the camera dependent constants as OnD3D11FrameRender does, and the others to the
+// defaults of the sample's UI
+//--------------------------------------------------------------------------------------
+void InitTessFactorConstants( CXMMATRIX mView, CXMMATRIX mProj, UINT uWidth, UINT uHeight, TESS_FACTOR_CONSTANTS* pConstants )
+{
+    assert( NULL != pConstants );
+
+    XMMATRIX mViewProjection = XMMatrixMultiply( mView, mProj );
+    XMStoreFloat4x4( &pConstants->f4x4ViewProjection, mViewProjection );
+
+    // The rows of the inverse view are the camera basis
+    XMMATRIX mInvView = XMMatrixInverse( NULL, mView );
+    XMStoreFloat3( &pConstants->f3Eye, mInvView.r[3] );
+    XMStoreFloat3( &pConstants->f3ViewVector, XMVector3Normalize( XMVectorNegate( mInvView.r[2] ) ) );
+
+    pConstants->fEdgeTessFactors = 5.0f;
+    pConstants->fMinDistance = 1.0f;
+    pConstants->fTessRange = 10.0f;
+    pConstants->f2ScreenSize = XMFLOAT2( (float)uWidth, (float)uHeight );
+    pConstants->fGUIBackFaceEpsilon = 0.5f;
+    pConstants->fGUISilhouetteEpsilon = 0.25f;
+    pConstants->fGUIRangeScale = 1.0f;
+    pConstants->fGUIEdgeSize = 16.0f;
+    pConstants->fGUIScreenResolutionScale = 1.0f;
+    pConstants->fGUIViewFrustrumEpsilon = 0.0f;
+    pConstants->f2FoveaFocus = XMFLOAT2( 0.5f * (float)uWidth, 0.5f * (float)uHeight );
+    pConstants->fFoveaInnerRadius = TESS_FOVEA_INNER_RADIUS * (float)uHeight;
+    pConstants->fFoveaOuterRadius = TESS_FOVEA_OUTER_RADIUS * (float)uHeight;
+    pConstants->fGUIFoveaPeripheryScale = TESS_FOVEA_PERIPHERY_SCALE;
+    pConstants->f2ResolutionReference = GetResolutionReference( 1.0f );
+    pConstants->f4x4PrevViewProjection = pConstants->f4x4ViewProjection;
+    pConstants->fMotionThreshold = TESS_MOTION_THRESHOLD;
+    pConstants->fMotionFullVelocity = TESS_MOTION_FULL_VELOCITY;
+    pConstants->fGUIMotionMinScale = TESS_MOTION_MIN_SCALE;
+
+    // As ExtractPlanesFromFrustum
+    XMMATRIX mTranspose = XMMatrixTranspose( mViewProjection );
+    XMVECTOR vPlanes[4] =
+    {
+        XMVectorAdd( mTranspose.r[3], mTranspose.r[0] ),
+        XMVectorSubtract( mTranspose.r[3], mTranspose.r[0] ),
+        XMVectorSubtract( mTranspose.r[3], mTranspose.r[1] ),
+        XMVectorAdd( mTranspose.r[3], mTranspose.r[1] ),
+    };
+    for( UINT i = 0; i < 4; i++ )
+    {
+        XMStoreFloat4( &pConstants->f4ViewFrustumPlanes[i], XMPlaneNormalize( vPlanes[i] ) );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the screen size the resolution adaptive term reaches 1 at
+//--------------------------------------------------------------------------------------
+XMFLOAT2 GetResolutionReference( float fTessScale )
+{
+    // The term is the ratio of the areas, so each side takes the square root
+    float fSideScale = 1.0f / sqrtf( std::max( fTessScale, 1e-3f ) );
+
+    return XMFLOAT2( TESS_RESOLUTION_REFERENCE_WIDTH * fSideScale, TESS_RESOLUTION_REFERENCE_HEIGHT * fSideScale );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Computes the tess factors of a patch with world space corners as HS_PNTrianglesConstant
+// does with the dwFlags permutation. Returns false if the patch is culled.
+//--------------------------------------------------------------------------------------
+bool GetPatchTessFactors( const PN_VERTEX* pCorners, DWORD dwFlags, const TESS_FACTOR_CONSTANTS* pConstants,
+                          PATCH_TESS_FACTORS* pFactors )
+{
+    TESS_PATCH_SETUP Setup;
+    SetupTessPatch( pCorners, &Setup );
+
+    return GetViewTessFactors( &Setup, dwFlags, pConstants, pFactors );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Computes the view independent part of the factors of a patch
+//--------------------------------------------------------------------------------------
+void SetupTessPatch( const PN_VERTEX* pCorners, TESS_PATCH_SETUP* pSetup )
+{
+    assert( NULL != pCorners );
+    assert( NULL != pSetup );
+
+    for( UINT uCorner = 0; uCorner < 3; uCorner++ )
+    {
+        pSetup->f3Positions[uCorner] = pCorners[uCorner].f3Position;
+    }
+
+    for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+    {
+        const PN_VERTEX& Corner0 = pCorners[EDGE_CORNERS[uEdge][0]];
+        const PN_VERTEX& Corner1 = pCorners[EDGE_CORNERS[uEdge][1]];
+
+        // GetEdgeDotProduct without the view vector
+        XMStoreFloat3( &pSetup->f3EdgeNormals[uEdge], XMVector3Normalize( XMVectorScale( XMVectorAdd( XMLoadFloat3( &Corner0.f3Normal ),
+                                                                                                      XMLoadFloat3( &Corner1.f3Normal ) ), 0.5f ) ) );
+        XMStoreFloat3( &pSetup->f3EdgeMidPoints[uEdge], XMVectorScale( XMVectorAdd( XMLoadFloat3( &Corner0.f3Position ),
+                                                                                     XMLoadFloat3( &Corner1.f3Position ) ), 0.5f ) );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Computes the tess factors of a set up patch for one view
+//--------------------------------------------------------------------------------------
+bool GetViewTessFactors( const TESS_PATCH_SETUP* pSetup, DWORD dwFlags, const TESS_FACTOR_CONSTANTS* pConstants,
+                         PATCH_TESS_FACTORS* pFactors )
+{
+    assert( NULL != pSetup );
+    assert( NULL != pConstants );
+    assert( NULL != pFactors );
+
+    ZeroMemory( pFactors, sizeof( *pFactors ) );
+
+    XMVECTOR vViewVector = XMLoadFloat3( &pConstants->f3ViewVector );
+    float fEdgeDot[3];
+
+    if( dwFlags & FRUST_CULL )
+    {
+        // TriangleInFrustum
+        for( UINT uPlane = 0; uPlane < 4; uPlane++ )
+        {
+            XMVECTOR vPlane = XMLoadFloat4( &pConstants->f4ViewFrustumPlanes[uPlane] );
+            UINT uNumInside = 0;
+            for( UINT uCorner = 0; uCorner < 3; uCorner++ )
+            {
+                float fDistance = XMVectorGetX( XMPlaneDotCoord( vPlane, XMLoadFloat3( &pSetup->f3Positions[uCorner] ) ) );
+                uNumInside += ( fDistance > -pConstants->fGUIViewFrustrumEpsilon ) ? 1 : 0;
+            }
+            if( 0 == uNumInside )
+            {
+                return false;
+            }
+        }
+    }
+
+    if( dwFlags & ( BF_CULL | ORIENT_ADAPT ) )
+    {
+        for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+        {
+            // GetEdgeDotProduct
+            fEdgeDot[uEdge] = XMVectorGetX( XMVector3Dot( XMLoadFloat3( &pSetup->f3EdgeNormals[uEdge] ), vViewVector ) );
+        }
+    }
+
+    if( dwFlags & BF_CULL )
+    {
+        // BackFaceCull
+        if( fEdgeDot[0] <= -pConstants->fGUIBackFaceEpsilon && fEdgeDot[1] <= -pConstants->fGUIBackFaceEpsilon &&
+            fEdgeDot[2] <= -pConstants->fGUIBackFaceEpsilon )
+        {
+            return false;
+        }
+    }
+
+    float fMaxFactor = pConstants->fEdgeTessFactors;
+    for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+    {
+        pFactors->fEdge[uEdge] = fMaxFactor;
+    }
+
+    if( dwFlags & SS_ADAPT )
+    {
+        XMMATRIX mViewProjection = XMLoadFloat4x4( &pConstants->f4x4ViewProjection );
+        XMFLOAT2 f2ScreenPositions[3];
+        for( UINT uCorner = 0; uCorner < 3; uCorner++ )
+        {
+            GetScreenSpacePosition( pSetup->f3Positions[uCorner], mViewProjection, pConstants->f2ScreenSize.x, pConstants->f2ScreenSize.y,
+                                    &f2ScreenPositions[uCorner] );
+        }
+
+        // GetScreenSpaceAdaptiveScaleFactor
+        for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+        {
+            const XMFLOAT2& f2Position0 = f2ScreenPositions[EDGE_CORNERS[uEdge][0]];
+            const XMFLOAT2& f2Position1 = f2ScreenPositions[EDGE_CORNERS[uEdge][1]];
+            float fEdgeScreenLength = sqrtf( ( f2Position1.x - f2Position0.x ) * ( f2Position1.x - f2Position0.x ) +
+                                             ( f2Position1.y - f2Position0.y ) * ( f2Position1.y - f2Position0.y ) );
+            float fScale = Saturate( fEdgeScreenLength / pConstants->fGUIEdgeSize / fMaxFactor );
+            pFactors->fEdge[uEdge] = Lerp( 1.0f, pFactors->fEdge[uEdge], fScale );
+        }
+    }
+    else
+    {
+        if( dwFlags & DIST_ADAPT )
+        {
+            // GetDistanceAdaptiveScaleFactor
+            XMVECTOR vEye = XMLoadFloat3( &pConstants->f3Eye );
+            for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+            {
+                XMVECTOR vMidPoint = XMLoadFloat3( &pSetup->f3EdgeMidPoints[uEdge] );
+                float fDistance = XMVectorGetX( XMVector3Length( XMVectorSubtract( vMidPoint, vEye ) ) ) - pConstants->fMinDistance;
+                float fScale = 1.0f - Saturate( fDistance / ( pConstants->fTessRange * pConstants->fGUIRangeScale ) );
+                pFactors->fEdge[uEdge] = Lerp( 1.0f, pFactors->fEdge[uEdge], fScale );
+            }
+        }
+
+        if( dwFlags & RES_ADAPT )
+        {
+            // GetScreenResolutionAdaptiveScaleFactor
+            float fMaxArea = pConstants->f2ResolutionReference.x * pConstants->fGUIScreenResolutionScale *
+                             pConstants->f2ResolutionReference.y * pConstants->fGUIScreenResolutionScale;
+            float fScale = Saturate( pConstants->f2ScreenSize.x * pConstants->f2ScreenSize.y / fMaxArea );
+            for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+            {
+                pFactors->fEdge[uEdge] = Lerp( 1.0f, pFactors->fEdge[uEdge], fScale );
+            }
+        }
+    }
+
+    if( dwFlags & ORIENT_ADAPT )
+    {
+        // GetOrientationAdaptiveScaleFactor, averaged with the other adaptive factors
+        bool bAverage = 0 != ( dwFlags & ( SS_ADAPT | DIST_ADAPT | RES_ADAPT ) );
+        for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+        {
+            float fScale = Saturate( ( 1.0f - fabsf( fEdgeDot[uEdge] ) - pConstants->fGUISilhouetteEpsilon ) /
+                                     ( 1.0f - pConstants->fGUISilhouetteEpsilon ) );
+            float fTessFactor = Lerp( 1.0f, fMaxFactor, fScale );
+            pFactors->fEdge[uEdge] = bAverage ? ( pFactors->fEdge[uEdge] + fTessFactor ) / 2.0f : fTessFactor;
+        }
+    }
+
+    if( dwFlags & FOVEA_ADAPT )
+    {
+        // GetFoveatedAdaptiveScaleFactor
+        XMMATRIX mViewProjection = XMLoadFloat4x4( &pConstants->f4x4ViewProjection );
+        float fOuterRadius = std::max( pConstants->fFoveaOuterRadius, pConstants->fFoveaInnerRadius + 1.0f );
+        for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+        {
+            const XMFLOAT3& f3MidPoint = pSetup->f3EdgeMidPoints[uEdge];
+            XMFLOAT2 f2ScreenPosition;
+            if( !GetScreenSpacePosition( f3MidPoint, mViewProjection, pConstants->f2ScreenSize.x, pConstants->f2ScreenSize.y, &f2ScreenPosition ) )
+            {
+                continue;
+            }
+
+            float fDistance = sqrtf( ( f2ScreenPosition.x - pConstants->f2FoveaFocus.x ) * ( f2ScreenPosition.x - pConstants->f2FoveaFocus.x ) +
+                                     ( f2ScreenPosition.y - pConstants->f2FoveaFocus.y ) * ( f2ScreenPosition.y - pConstants->f2FoveaFocus.y ) );
+            float fFalloff = Saturate( ( fDistance - pConstants->fFoveaInnerRadius ) / ( fOuterRadius - pConstants->fFoveaInnerRadius ) );
+            fFalloff = fFalloff * fFalloff * ( 3.0f - 2.0f * fFalloff );
+            float fScale = Lerp( 1.0f, pConstants->fGUIFoveaPeripheryScale, fFalloff );
+            pFactors->fEdge[uEdge] = Lerp( 1.0f, pFactors->fEdge[uEdge], fScale );
+        }
+    }
+
+    if( dwFlags & MOTION_ADAPT )
+    {
+        // GetMotionAdaptiveScaleFactor
+        XMMATRIX mViewProjection = XMLoadFloat4x4( &pConstants->f4x4ViewProjection );
+        XMMATRIX mPrevViewProjection = XMLoadFloat4x4( &pConstants->f4x4PrevViewProjection );
+        float fFullVelocity = std::max( pConstants->fMotionFullVelocity, pConstants->fMotionThreshold + 1.0f );
+        for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+        {
+            const XMFLOAT3& f3MidPoint = pSetup->f3EdgeMidPoints[uEdge];
+            XMFLOAT2 f2ScreenPosition, f2PrevScreenPosition;
+            if( !GetScreenSpacePosition( f3MidPoint, mViewProjection, pConstants->f2ScreenSize.x, pConstants->f2ScreenSize.y, &f2ScreenPosition ) ||
+                !GetScreenSpacePosition( f3MidPoint, mPrevViewProjection, pConstants->f2ScreenSize.x, pConstants->f2ScreenSize.y, &f2PrevScreenPosition ) )
+            {
+                continue;
+            }
+
+            float fVelocity = sqrtf( ( f2ScreenPosition.x - f2PrevScreenPosition.x ) * ( f2ScreenPosition.x - f2PrevScreenPosition.x ) +
+                                     ( f2ScreenPosition.y - f2PrevScreenPosition.y ) * ( f2ScreenPosition.y - f2PrevScreenPosition.y ) );
+            float fFalloff = Saturate( ( fVelocity - pConstants->fMotionThreshold ) / ( fFullVelocity - pConstants->fMotionThreshold ) );
+            fFalloff = fFalloff * fFalloff * ( 3.0f - 2.0f * fFalloff );
+            float fScale = Lerp( 1.0f, pConstants->fGUIMotionMinScale, fFalloff );
+            pFactors->fEdge[uEdge] = Lerp( 1.0f, pFactors->fEdge[uEdge], fScale );
+        }
+    }
+
+    pFactors->fInside = ( pFactors->fEdge[0] + pFactors->fEdge[1] + pFactors->fEdge[2] ) / 3.0f;
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Computes the factors, triangle count and screen area of every patch of the mesh
+//--------------------------------------------------------------------------------------
+void BuildTessHeatmap( const MESH_DATA* pMeshData, DWORD dwFlags, const TESS_FACTOR_CONSTANTS* pConstants,
+                       std::vector<TESS_HEATMAP_PATCH>* pHeatmap )
+{
+    assert( NULL != pMeshData );
+    assert( NULL != pConstants );
+    assert( NULL != pHeatmap );
+
+    UINT uNumPatches = (UINT)pMeshData->Indices.size() / 3;
+    pHeatmap->resize( uNumPatches );
+
+    XMMATRIX mViewProjection = XMLoadFloat4x4( &pConstants->f4x4ViewProjection );
+    TRI_TESSELLATION Tessellation;
+
+    for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+    {
+        TESS_HEATMAP_PATCH* pPatch = &( *pHeatmap )[uPatch];
+
+        PN_VERTEX Corners[3];
+        for( UINT uCorner = 0; uCorner < 3; uCorner++ )
+        {
+            Corners[uCorner] = pMeshData->Vertices[pMeshData->Indices[uPatch * 3 + uCorner]];
+        }
+
+        pPatch->bCulled = !GetPatchTessFactors( Corners, dwFlags, pConstants, &pPatch->Factors );
+        pPatch->uNumTriangles = 0;
+        if( !pPatch->bCulled )
+        {
+            TessellateTri( pPatch->Factors.fEdge, pPatch->Factors.fInside, &Tessellation );
+            pPatch->uNumTriangles = (UINT)Tessellation.Indices.size() / 3;
+        }
+
+        XMFLOAT2 f2ScreenPositions[3];
+        bool bInFront = true;
+        for( UINT uCorner = 0; uCorner < 3; uCorner++ )
+        {
+            bInFront &= GetScreenSpacePosition( Corners[uCorner].f3Position, mViewProjection, pConstants->f2ScreenSize.x,
+                                                pConstants->f2ScreenSize.y, &f2ScreenPositions[uCorner] );
+        }
+        pPatch->fScreenArea = 0.0f;
+        if( bInFront )
+        {
+            float fCross = ( f2ScreenPositions[1].x - f2ScreenPositions[0].x ) * ( f2ScreenPositions[2].y - f2ScreenPositions[0].y ) -
+                           ( f2ScreenPositions[1].y - f2ScreenPositions[0].y ) * ( f2ScreenPositions[2].x - f2ScreenPositions[0].x );
+            pPatch->fScreenArea = 0.5f * fabsf( fCross );
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the pixels per output triangle of a patch, 0 if unknown
+//--------------------------------------------------------------------------------------
+static float GetPixelsPerTriangle( const TESS_HEATMAP_PATCH* pPatch )
+{
+    return ( pPatch->uNumTriangles > 0 ) ? pPatch->fScreenArea / (float)pPatch->uNumTriangles : 0.0f;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Writes the mesh as a PLY with one colour per face, from blue for an inside factor of 1
+// to red for fMaxFactor, and grey for culled patches. The factors, triangle count and
+// pixels per triangle are written as extra face properties.
+//--------------------------------------------------------------------------------------
+HRESULT WriteTessHeatmapPLY( const WCHAR* pszFileName, const MESH_DATA* pMeshData, const TESS_HEATMAP_PATCH* pHeatmap,
+                             float fMaxFactor )
+{
+    assert( NULL != pszFileName );
+    assert( NULL != pMeshData );
+    assert( NULL != pHeatmap );
+
+    FILE* pOutput = NULL;
+    if( 0 != _wfopen_s( &pOutput, pszFileName, L"w" ) || NULL == pOutput )
+    {
+        return E_ACCESSDENIED;
+    }
+
+    UINT uNumPatches = (UINT)pMeshData->Indices.size() / 3;
+    fprintf( pOutput, "ply\nformat ascii 1.0\ncomment tess factors of HS_PNTrianglesConstant\n" );
+    fprintf( pOutput, "element vertex %u\nproperty float x\nproperty float y\nproperty float z\n", (UINT)pMeshData->Vertices.size() );
+    fprintf( pOutput, "element face %u\nproperty list uchar int vertex_indices\n", uNumPatches );
+    fprintf( pOutput, "property uchar red\nproperty uchar green\nproperty uchar blue\n" );
+    fprintf( pOutput, "property float edge0\nproperty float edge1\nproperty float edge2\nproperty float inside\n" );
+    fprintf( pOutput, "property int triangles\nproperty float pixels_per_triangle\nend_header\n" );
+
+    for( UINT i = 0; i < (UINT)pMeshData->Vertices.size(); i++ )
+    {
+        const XMFLOAT3& f3Position = pMeshData->Vertices[i].f3Position;
+        fprintf( pOutput, "%g %g %g\n", f3Position.x, f3Position.y, f3Position.z );
+    }
+
+    for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+    {
+        const TESS_HEATMAP_PATCH* pPatch = &pHeatmap[uPatch];
+
+        // Blue to green to red
+        UINT uRed = 128, uGreen = 128, uBlue = 128;
+        if( !pPatch->bCulled )
+        {
+            float fHeat = Saturate( ( pPatch->Factors.fInside - 1.0f ) / std::max( fMaxFactor - 1.0f, 1.0e-6f ) );
+            uRed = (UINT)( 255.0f * Saturate( 2.0f * fHeat - 1.0f ) + 0.5f );
+            uGreen = (UINT)( 255.0f * ( 1.0f - fabsf( 2.0f * fHeat - 1.0f ) ) + 0.5f );
+            uBlue = (UINT)( 255.0f * Saturate( 1.0f - 2.0f * fHeat ) + 0.5f );
+        }
+
+        fprintf( pOutput, "3 %u %u %u %u %u %u %g %g %g %g %u %g\n", pMeshData->Indices[uPatch * 3], pMeshData->Indices[uPatch * 3 + 1],
+                 pMeshData->Indices[uPatch * 3 + 2], uRed, uGreen, uBlue, pPatch->Factors.fEdge[0], pPatch->Factors.fEdge[1],
+                 pPatch->Factors.fEdge[2], pPatch->Factors.fInside, pPatch->uNumTriangles, GetPixelsPerTriangle( pPatch ) );
+    }
+
+    bool bFailed = 0 != ferror( pOutput );
+    fclose( pOutput );
+
+    return bFailed ? E_FAIL : S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Writes one line per patch to a CSV file
+//--------------------------------------------------------------------------------------
+HRESULT WriteTessHeatmapCSV( const WCHAR* pszFileName, const MESH_DATA* pMeshData, const TESS_HEATMAP_PATCH* pHeatmap )
+{
+    assert( NULL != pszFileName );
+    assert( NULL != pMeshData );
+    assert( NULL != pHeatmap );
+
+    FILE* pOutput = NULL;
+    if( 0 != _wfopen_s( &pOutput, pszFileName, L"w" ) || NULL == pOutput )
+    {
+        return E_ACCESSDENIED;
+    }
+
+    fprintf( pOutput, "patch,mesh,subset,material,culled,edge0,edge1,edge2,inside,triangles,screen_area,pixels_per_triangle\n" );
+
+    for( UINT uSubset = 0; uSubset < (UINT)pMeshData->Subsets.size(); uSubset++ )
+    {
+        const MESH_DATA_SUBSET& Subset = pMeshData->Subsets[uSubset];
+        for( UINT uPatch = Subset.uIndexStart / 3; uPatch < ( Subset.uIndexStart + Subset.uIndexCount ) / 3; uPatch++ )
+        {
+            const TESS_HEATMAP_PATCH* pPatch = &pHeatmap[uPatch];
+            fprintf( pOutput, "%u,%u,%u,%u,%d,%g,%g,%g,%g,%u,%g,%g\n", uPatch, Subset.uMesh, Subset.uSubset, Subset.uMaterialID,
+                     pPatch->bCulled ? 1 : 0, pPatch->Factors.fEdge[0], pPatch->Factors.fEdge[1], pPatch->Factors.fEdge[2],
+                     pPatch->Factors.fInside, pPatch->uNumTriangles, pPatch->fScreenArea, GetPixelsPerTriangle( pPatch ) );
+        }
+    }
+
+    bool bFailed = 0 != ferror( pOutput );
+    fclose( pOutput );
+
+    return bFailed ? E_FAIL : S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,192 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TessFactors.h
+//
+// CPU reference of the tess factors HS_PNTrianglesConstant outputs for each permutation
+// of the hull shader (see AdaptiveTessellation.hlsl), and per patch heatmaps of them for
+// tuning the adaptive settings offline.
+//--------------------------------------------------------------------------------------
+#ifndef TESS_FACTORS_H
+#define TESS_FACTORS_H
+
+#include "MeshData.h"
+
+// Permutation flags of the hull and domain shaders (HullShaderHash)
+typedef enum _TESSELLATION_SETTING_TYPE
+{
+    // enables tessellation factors based on:
+    SS_ADAPT        = 1,    // an ideat primitive size
+	DIST_ADAPT      = 2,    // distance
+	RES_ADAPT       = 4,    // screen resolution
+	ORIENT_ADAPT    = 8,    // orientation with respect to the viewing vector
+	FOVEA_ADAPT     = 16,   // screen distance from a focus point
+	MOTION_ADAPT    = 32,   // screen velocity from the camera motion
+
+    // culling type
+	BF_CULL         = 64,   // use back face culling
+	FRUST_CULL      = 128,  // use view frustum culling
+
+    // select tessellation technique
+	PHONG           = 256,  // use phong 
+	PNTRI           = 512,  // use PN triangles 
+
+    // patch constant storage
+	PACKED_CP       = 1024, // pack the PN triangles control points (see PatchPacking.hlsl)
+
+    // view count
+	MULTI_VIEW      = 2048, // evaluate the factors of several views in one pass (see MultiViewFactors.h)
+
+    // domain shader outputs
+	DEPTH_ONLY      = 4096, // position only, for the depth and shadow passes (see TessPolicy.h)
+}
+TESSELLATION_SETTING_TYPE;
+
+// Defaults of the foveated scale, the radii are fractions of the screen height
+static const float TESS_FOVEA_INNER_RADIUS      = 0.2f;
+static const float TESS_FOVEA_OUTER_RADIUS      = 0.5f;
+static const float TESS_FOVEA_PERIPHERY_SCALE   = 0.25f;
+
+// Defaults of the motion scale, the velocities are pixels per 60Hz frame
+static const float TESS_MOTION_THRESHOLD        = 4.0f;
+static const float TESS_MOTION_FULL_VELOCITY    = 32.0f;
+static const float TESS_MOTION_MIN_SCALE        = 0.25f;
+
+// Screen size the resolution term reaches 1 at, the sample's original max screen size. It
+// does not follow the back buffer, so the term drops with the pixels rendered.
+static const float TESS_RESOLUTION_REFERENCE_WIDTH  = 2560.0f;
+static const float TESS_RESOLUTION_REFERENCE_HEIGHT = 1600.0f;
+
+// The values of cbPNTriangles the factors depend on
+struct TESS_FACTOR_CONSTANTS
+{
+    DirectX::XMFLOAT4X4 f4x4ViewProjection;
+    DirectX::XMFLOAT3   f3Eye;
+    DirectX::XMFLOAT3   f3ViewVector;               // Normalized, from the look at point to the eye
+    float               fEdgeTessFactors;
+    float               fMinDistance;
+    float               fTessRange;
+    DirectX::XMFLOAT2   f2ScreenSize;
+    float               fGUIBackFaceEpsilon;
+    float               fGUISilhouetteEpsilon;
+    float               fGUIRangeScale;
+    float               fGUIEdgeSize;
+    float               fGUIScreenResolutionScale;
+    float               fGUIViewFrustrumEpsilon;
+    DirectX::XMFLOAT4   f4ViewFrustumPlanes[4];     // Left, right, top, bottom
+    DirectX::XMFLOAT2   f2FoveaFocus;               // In pixels
+    float               fFoveaInnerRadius;          // In pixels
+    float               fFoveaOuterRadius;
+    float               fGUIFoveaPeripheryScale;
+    DirectX::XMFLOAT2   f2ResolutionReference;      // Screen size the resolution term reaches 1 at, times fGUIScreenResolutionScale
+    DirectX::XMFLOAT4X4 f4x4PrevViewProjection;     // CCameraMotion::GetPreviousViewProjection
+    float               fMotionThreshold;           // In pixels
+    float               fMotionFullVelocity;        // In pixels
+    float               fGUIMotionMinScale;
+};
+
+// SV_TessFactor and SV_InsideTessFactor of a patch, all 0 if it was culled
+struct PATCH_TESS_FACTORS
+{
+    float fEdge[3];
+    float fInside;
+};
+
+// The view independent part of the factors of a patch, shared by all the views it is
+// evaluated for
+struct TESS_PATCH_SETUP
+{
+    DirectX::XMFLOAT3   f3Positions[3];
+    DirectX::XMFLOAT3   f3EdgeNormals[3];           // Normalized average of the corner normals of each edge
+    DirectX::XMFLOAT3   f3EdgeMidPoints[3];
+};
+
+// A patch of a heatmap
+struct TESS_HEATMAP_PATCH
+{
+    PATCH_TESS_FACTORS  Factors;
+    bool                bCulled;
+    UINT                uNumTriangles;  // Output by the tessellator
+    float               fScreenArea;    // Pixels covered by the flat triangle, 0 if it crosses the eye plane
+};
+
+
+//--------------------------------------------------------------------------------------
+// Sets the camera dependent constants as OnD3D11FrameRender does, and the others to the
+// defaults of the sample's UI
+//--------------------------------------------------------------------------------------
+void InitTessFactorConstants( DirectX::CXMMATRIX mView, DirectX::CXMMATRIX mProj, UINT uWidth, UINT uHeight,
+                              TESS_FACTOR_CONSTANTS* pConstants );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the screen size the resolution adaptive term reaches 1 at: the fixed reference,
+// enlarged so the term is scaled by fTessScale (from the dynamic resolution controller)
+//--------------------------------------------------------------------------------------
+DirectX::XMFLOAT2 GetResolutionReference( float fTessScale );
+
+
+//--------------------------------------------------------------------------------------
+// Computes the tess factors of a patch with world space corners as HS_PNTrianglesConstant
+// does with the dwFlags permutation. Returns false if the patch is culled.
+//--------------------------------------------------------------------------------------
+bool GetPatchTessFactors( const PN_VERTEX* pCorners, DWORD dwFlags, const TESS_FACTOR_CONSTANTS* pConstants,
+                          PATCH_TESS_FACTORS* pFactors );
+
+
+//--------------------------------------------------------------------------------------
+// Computes the view independent part of the factors of a patch with world space corners
+//--------------------------------------------------------------------------------------
+void SetupTessPatch( const PN_VERTEX* pCorners, TESS_PATCH_SETUP* pSetup );
+
+
+//--------------------------------------------------------------------------------------
+// Computes the tess factors of a set up patch for the view of pConstants, as
+// GetPatchTessFactors does. Returns false if the patch is culled in that view.
+//--------------------------------------------------------------------------------------
+bool GetViewTessFactors( const TESS_PATCH_SETUP* pSetup, DWORD dwFlags, const TESS_FACTOR_CONSTANTS* pConstants,
+                         PATCH_TESS_FACTORS* pFactors );
+
+
+//--------------------------------------------------------------------------------------
+// Computes the factors, triangle count and screen area of every patch of the mesh
+//--------------------------------------------------------------------------------------
+void BuildTessHeatmap( const MESH_DATA* pMeshData, DWORD dwFlags, const TESS_FACTOR_CONSTANTS* pConstants,
+                       std::vector<TESS_HEATMAP_PATCH>* pHeatmap );
+
+
+//--------------------------------------------------------------------------------------
+// Writes the mesh as a PLY with one colour per face, from blue for an inside factor of 1
+// to red for fMaxFactor, and grey for culled patches. The factors, triangle count and
+// pixels per triangle are written as extra face properties.
+//--------------------------------------------------------------------------------------
+HRESULT WriteTessHeatmapPLY( const WCHAR* pszFileName, const MESH_DATA* pMeshData, const TESS_HEATMAP_PATCH* pHeatmap,
+                             float fMaxFactor );
+
+
+//--------------------------------------------------------------------------------------
+// Writes one line per patch to a CSV file
+//--------------------------------------------------------------------------------------
+HRESULT WriteTessHeatmapCSV( const WCHAR* pszFileName, const MESH_DATA* pMeshData, const TESS_HEATMAP_PATCH* pHeatmap );
+
+#endif
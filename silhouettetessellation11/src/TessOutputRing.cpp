@@ -0,0 +1,369 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TessOutputRing.cpp
+//
+// Ring buffer output for CPU tessellation.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "TessOutputRing.h"
+#include <emmintrin.h>
+
+using namespace DirectX;
+
+// Alignment of the rings, streaming stores need 16 bytes and a cache line avoids sharing
+static const UINT TESS_RING_ALIGNMENT = 64;
+
+
+//--------------------------------------------------------------------------------------
+// Copies vertices with streaming stores, pDest must be 16 byte aligned
+//--------------------------------------------------------------------------------------
+static void StreamVertices( PN_VERTEX* pDest, const PN_VERTEX* pSource, UINT uNumVertices )
+{
+    assert( 0 == ( (UINT_PTR)pDest & 15 ) );
+    static_assert( 0 == sizeof( PN_VERTEX ) % 16, "PN_VERTEX must be a whole number of 16 byte blocks" );
+
+    const float* pfSource = (const float*)pSource;
+    float* pfDest = (float*)pDest;
+    UINT uNumFloats = uNumVertices * sizeof( PN_VERTEX ) / sizeof( float );
+    for( UINT i = 0; i < uNumFloats; i += 4 )
+    {
+        _mm_stream_ps( pfDest + i, _mm_loadu_ps( pfSource + i ) );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Widens and offsets indices with streaming stores
+//--------------------------------------------------------------------------------------
+static void StreamIndices( TESS_RING_INDEX* pDest, const WORD* pSource, UINT uNumIndices, UINT uBaseVertex )
+{
+    UINT i = 0;
+
+    // Up to 16 byte alignment of the destination
+    for( ; i < uNumIndices && 0 != ( (UINT_PTR)( pDest + i ) & 15 ); i++ )
+    {
+        _mm_stream_si32( (int*)( pDest + i ), (int)( pSource[i] + uBaseVertex ) );
+    }
+
+    __m128i vBaseVertex = _mm_set1_epi32( (int)uBaseVertex );
+    __m128i vZero = _mm_setzero_si128();
+    for( ; i + 4 <= uNumIndices; i += 4 )
+    {
+        __m128i vIndices = _mm_loadl_epi64( (const __m128i*)( pSource + i ) );
+        vIndices = _mm_add_epi32( _mm_unpacklo_epi16( vIndices, vZero ), vBaseVertex );
+        _mm_stream_si128( (__m128i*)( pDest + i ), vIndices );
+    }
+
+    for( ; i < uNumIndices; i++ )
+    {
+        _mm_stream_si32( (int*)( pDest + i ), (int)( pSource[i] + uBaseVertex ) );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CTessOutputRing::CTessOutputRing() :
+    m_bNonTemporal( true ),
+    m_uFrame( 0 ),
+    m_pVertices( NULL ),
+    m_pIndices( NULL ),
+    m_uNumBatches( 0 )
+{
+    memset( &m_VertexRing, 0, sizeof( m_VertexRing ) );
+    memset( &m_IndexRing, 0, sizeof( m_IndexRing ) );
+    memset( &m_CurrentFrame, 0, sizeof( m_CurrentFrame ) );
+    memset( m_Batches, 0, sizeof( m_Batches ) );
+    memset( &m_Stats, 0, sizeof( m_Stats ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CTessOutputRing::~CTessOutputRing()
+{
+}
+
+
+//--------------------------------------------------------------------------------------
+// Sizes the rings, all empty
+//--------------------------------------------------------------------------------------
+void CTessOutputRing::CreateRings( UINT uVertexCapacity, UINT uIndexCapacity, bool bNonTemporal )
+{
+    memset( &m_VertexRing, 0, sizeof( m_VertexRing ) );
+    memset( &m_IndexRing, 0, sizeof( m_IndexRing ) );
+    m_VertexRing.uCapacity = uVertexCapacity;
+    m_IndexRing.uCapacity = uIndexCapacity;
+    m_bNonTemporal = bNonTemporal;
+
+    m_FramesInFlight.clear();
+    m_uFrame = 0;
+    m_uNumBatches = 0;
+    memset( &m_Stats, 0, sizeof( m_Stats ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Forgets the frames in flight
+//--------------------------------------------------------------------------------------
+void CTessOutputRing::Destroy()
+{
+    CreateRings( 0, 0, m_bNonTemporal );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Frees the regions of the completed frames and maps the rings
+//--------------------------------------------------------------------------------------
+HRESULT CTessOutputRing::BeginFrame()
+{
+    HRESULT hr;
+
+    assert( NULL == m_pVertices );
+
+    // Frames complete in order
+    UINT64 uCompletedFrame = GetCompletedFrame();
+    UINT uNumCompleted = 0;
+    while( uNumCompleted < m_FramesInFlight.size() && m_FramesInFlight[uNumCompleted].uFrame <= uCompletedFrame )
+    {
+        m_VertexRing.uUsed -= m_FramesInFlight[uNumCompleted].uVertices;
+        m_IndexRing.uUsed -= m_FramesInFlight[uNumCompleted].uIndices;
+        uNumCompleted++;
+    }
+    m_FramesInFlight.erase( m_FramesInFlight.begin(), m_FramesInFlight.begin() + uNumCompleted );
+
+    // Start from the beginning when nothing is in flight, to avoid wrapping
+    if( m_FramesInFlight.empty() )
+    {
+        m_VertexRing.uHead = 0;
+        m_IndexRing.uHead = 0;
+    }
+
+    m_uFrame++;
+    m_CurrentFrame.uFrame = m_uFrame;
+    m_CurrentFrame.uVertices = 0;
+    m_CurrentFrame.uIndices = 0;
+
+    m_uNumBatches = 0;
+    memset( &m_Stats, 0, sizeof( m_Stats ) );
+
+    V_RETURN( Map( &m_pVertices, &m_pIndices ) );
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Appends a patch to the frame
+//--------------------------------------------------------------------------------------
+bool CTessOutputRing::WritePatch( const PN_VERTEX* pVertices, UINT uNumVertices, const WORD* pIndices, UINT uNumIndices )
+{
+    assert( NULL != m_pVertices );
+
+    m_Stats.uNumPatches++;
+
+    // Both rings wrap together, so a batch's indices never refer to vertices before it
+    bool bWrap = ( m_VertexRing.uHead + uNumVertices > m_VertexRing.uCapacity ) ||
+                 ( m_IndexRing.uHead + uNumIndices > m_IndexRing.uCapacity );
+    UINT uVertexSpace = uNumVertices + ( bWrap ? m_VertexRing.uCapacity - m_VertexRing.uHead : 0 );
+    UINT uIndexSpace = uNumIndices + ( bWrap ? m_IndexRing.uCapacity - m_IndexRing.uHead : 0 );
+    if( uVertexSpace > m_VertexRing.uCapacity - m_VertexRing.uUsed ||
+        uIndexSpace > m_IndexRing.uCapacity - m_IndexRing.uUsed )
+    {
+        m_Stats.uNumDroppedPatches++;
+        return false;
+    }
+
+    if( bWrap )
+    {
+        m_VertexRing.uHead = 0;
+        m_IndexRing.uHead = 0;
+    }
+
+    if( 0 == m_uNumBatches || bWrap )
+    {
+        assert( m_uNumBatches < ARRAYSIZE( m_Batches ) );
+        TESS_RING_BATCH& Batch = m_Batches[m_uNumBatches++];
+        Batch.uFirstVertex = m_VertexRing.uHead;
+        Batch.uNumVertices = 0;
+        Batch.uFirstIndex = m_IndexRing.uHead;
+        Batch.uNumIndices = 0;
+    }
+
+    TESS_RING_BATCH& Batch = m_Batches[m_uNumBatches - 1];
+    PN_VERTEX* pDestVertices = (PN_VERTEX*)m_pVertices + m_VertexRing.uHead;
+    TESS_RING_INDEX* pDestIndices = (TESS_RING_INDEX*)m_pIndices + m_IndexRing.uHead;
+    if( m_bNonTemporal )
+    {
+        StreamVertices( pDestVertices, pVertices, uNumVertices );
+        StreamIndices( pDestIndices, pIndices, uNumIndices, Batch.uNumVertices );
+    }
+    else
+    {
+        memcpy( pDestVertices, pVertices, uNumVertices * sizeof( PN_VERTEX ) );
+        for( UINT i = 0; i < uNumIndices; i++ )
+        {
+            pDestIndices[i] = pIndices[i] + Batch.uNumVertices;
+        }
+    }
+
+    Batch.uNumVertices += uNumVertices;
+    Batch.uNumIndices += uNumIndices;
+
+    m_VertexRing.uHead += uNumVertices;
+    m_VertexRing.uUsed += uVertexSpace;
+    m_IndexRing.uHead += uNumIndices;
+    m_IndexRing.uUsed += uIndexSpace;
+    m_CurrentFrame.uVertices += uVertexSpace;
+    m_CurrentFrame.uIndices += uIndexSpace;
+
+    m_Stats.uBytesWritten += uNumVertices * sizeof( PN_VERTEX ) + uNumIndices * sizeof( TESS_RING_INDEX );
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Unmaps the rings and puts the frame in flight
+//--------------------------------------------------------------------------------------
+void CTessOutputRing::EndFrame()
+{
+    assert( NULL != m_pVertices );
+
+    // Streaming stores are weakly ordered, make them visible before the consumer reads
+    if( m_bNonTemporal )
+    {
+        _mm_sfence();
+    }
+
+    Unmap();
+    m_pVertices = NULL;
+    m_pIndices = NULL;
+
+    m_FramesInFlight.push_back( m_CurrentFrame );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the counters of the current frame
+//--------------------------------------------------------------------------------------
+void CTessOutputRing::GetStats( TESS_RING_STATS* pStats ) const
+{
+    assert( NULL != pStats );
+
+    *pStats = m_Stats;
+    pStats->uNumFramesInFlight = (UINT)m_FramesInFlight.size();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CHeapTessOutputRing::CHeapTessOutputRing() :
+    m_pVertices( NULL ),
+    m_pIndices( NULL ),
+    m_uCompletedFrame( 0 )
+{
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CHeapTessOutputRing::~CHeapTessOutputRing()
+{
+    Destroy();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Allocates rings of the given number of vertices and indices
+//--------------------------------------------------------------------------------------
+HRESULT CHeapTessOutputRing::Create( UINT uVertexCapacity, UINT uIndexCapacity, bool bNonTemporal )
+{
+    Destroy();
+
+    m_pVertices = (BYTE*)_aligned_malloc( std::max( uVertexCapacity * sizeof( PN_VERTEX ), (size_t)1 ), TESS_RING_ALIGNMENT );
+    m_pIndices = (BYTE*)_aligned_malloc( std::max( uIndexCapacity * sizeof( TESS_RING_INDEX ), (size_t)1 ), TESS_RING_ALIGNMENT );
+    if( NULL == m_pVertices || NULL == m_pIndices )
+    {
+        Destroy();
+        return E_OUTOFMEMORY;
+    }
+
+    m_uCompletedFrame = 0;
+    CreateRings( uVertexCapacity, uIndexCapacity, bNonTemporal );
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Frees the rings
+//--------------------------------------------------------------------------------------
+void CHeapTessOutputRing::Destroy()
+{
+    _aligned_free( m_pVertices );
+    _aligned_free( m_pIndices );
+    m_pVertices = NULL;
+    m_pIndices = NULL;
+
+    CTessOutputRing::Destroy();
+}
+
+
+//--------------------------------------------------------------------------------------
+// System memory is always mapped
+//--------------------------------------------------------------------------------------
+HRESULT CHeapTessOutputRing::Map( BYTE** ppVertices, BYTE** ppIndices )
+{
+    *ppVertices = m_pVertices;
+    *ppIndices = m_pIndices;
+
+    return ( NULL != m_pVertices ) ? S_OK : E_FAIL;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Nothing to unmap
+//--------------------------------------------------------------------------------------
+void CHeapTessOutputRing::Unmap()
+{
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the last frame marked as consumed
+//--------------------------------------------------------------------------------------
+UINT64 CHeapTessOutputRing::GetCompletedFrame()
+{
+    return m_uCompletedFrame;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
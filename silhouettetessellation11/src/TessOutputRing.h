@@ -0,0 +1,173 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TessOutputRing.h
+//
+// Ring buffers receiving CPU tessellated patches straight from the tessellator, instead
+// of collecting the frame in system memory vectors and copying them into a buffer mapped
+// with D3D11_MAP_WRITE_DISCARD. Patches are written with non-temporal (streaming) stores
+// by default, so the output goes to memory without being read for ownership or evicting
+// the tessellator's working set. Each frame appends to the rings, and its region is
+// reused once the fence of the frame completed.
+//
+// CHeapTessOutputRing keeps the rings in system memory and lets the caller complete the
+// fences. A GPU backed ring derives from CTessOutputRing and provides the storage and
+// fences, the sample doesn't have one yet.
+//--------------------------------------------------------------------------------------
+#ifndef TESS_OUTPUT_RING_H
+#define TESS_OUTPUT_RING_H
+
+#include "PNTriangles.h"
+
+// Output is DXGI_FORMAT_R32_UINT indices into PN_VERTEX vertices
+typedef UINT TESS_RING_INDEX;
+
+// A contiguous run of the output of a frame, drawn with
+// DrawIndexed( uNumIndices, uFirstIndex, uFirstVertex ). A frame has a second batch if
+// it wrapped round the end of the rings.
+struct TESS_RING_BATCH
+{
+    UINT    uFirstVertex;
+    UINT    uNumVertices;
+    UINT    uFirstIndex;
+    UINT    uNumIndices;
+};
+
+struct TESS_RING_STATS
+{
+    UINT64  uBytesWritten;      // Vertices and indices written to the rings, this frame
+    UINT    uNumPatches;
+    UINT    uNumDroppedPatches; // Didn't fit, the frames in flight hold the rest of the rings
+    UINT    uNumFramesInFlight;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Ring buffer output for CPU tessellation, the storage is provided by the derived class
+//--------------------------------------------------------------------------------------
+class CTessOutputRing
+{
+public:
+
+    CTessOutputRing();
+    virtual ~CTessOutputRing();
+
+    virtual void Destroy();
+
+    // Frees the regions of the completed frames and maps the rings
+    HRESULT BeginFrame();
+
+    // Appends a patch to the frame, its indices relative to its vertices. Returns false
+    // and writes nothing if the patch doesn't fit.
+    bool WritePatch( const PN_VERTEX* pVertices, UINT uNumVertices, const WORD* pIndices, UINT uNumIndices );
+
+    // Unmaps the rings. The frame's batches are valid until the next BeginFrame.
+    void EndFrame();
+
+    UINT GetNumBatches() const { return m_uNumBatches; }
+    const TESS_RING_BATCH* GetBatch( UINT uBatch ) const { assert( uBatch < m_uNumBatches ); return &m_Batches[uBatch]; }
+
+    // Frames are numbered from 1 by BeginFrame
+    UINT64 GetFrame() const { return m_uFrame; }
+
+    void GetStats( TESS_RING_STATS* pStats ) const;
+
+protected:
+
+    // Sizes the rings, the derived class creates the storage first
+    void CreateRings( UINT uVertexCapacity, UINT uIndexCapacity, bool bNonTemporal );
+
+    // Returns the pointers to the start of the rings, valid until Unmap
+    virtual HRESULT Map( BYTE** ppVertices, BYTE** ppIndices ) = 0;
+    virtual void Unmap() = 0;
+
+    // Returns the last frame the consumer is done with
+    virtual UINT64 GetCompletedFrame() = 0;
+
+private:
+
+    struct RING
+    {
+        UINT    uCapacity;
+        UINT    uHead;
+        UINT    uUsed;      // Including the space skipped when wrapping
+    };
+
+    struct FRAME_REGION
+    {
+        UINT64  uFrame;
+        UINT    uVertices;  // Space the frame took in each ring
+        UINT    uIndices;
+    };
+
+    RING                        m_VertexRing;
+    RING                        m_IndexRing;
+    bool                        m_bNonTemporal;
+
+    std::vector<FRAME_REGION>   m_FramesInFlight;
+    UINT64                      m_uFrame;
+    FRAME_REGION                m_CurrentFrame;
+
+    BYTE*                       m_pVertices;    // Mapped during the frame
+    BYTE*                       m_pIndices;
+
+    TESS_RING_BATCH             m_Batches[2];
+    UINT                        m_uNumBatches;
+
+    TESS_RING_STATS             m_Stats;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Rings in system memory, the caller says which frames are complete
+//--------------------------------------------------------------------------------------
+class CHeapTessOutputRing : public CTessOutputRing
+{
+public:
+
+    CHeapTessOutputRing();
+    virtual ~CHeapTessOutputRing();
+
+    HRESULT Create( UINT uVertexCapacity, UINT uIndexCapacity, bool bNonTemporal );
+    virtual void Destroy();
+
+    // Marks the frames up to uFrame as consumed
+    void SetCompletedFrame( UINT64 uFrame ) { m_uCompletedFrame = std::max( m_uCompletedFrame, uFrame ); }
+
+    const PN_VERTEX* GetVertices() const { return (const PN_VERTEX*)m_pVertices; }
+    const TESS_RING_INDEX* GetIndices() const { return (const TESS_RING_INDEX*)m_pIndices; }
+
+protected:
+
+    virtual HRESULT Map( BYTE** ppVertices, BYTE** ppIndices );
+    virtual void Unmap();
+    virtual UINT64 GetCompletedFrame();
+
+private:
+
+    BYTE*   m_pVertices;
+    BYTE*   m_pIndices;
+    UINT64  m_uCompletedFrame;
+};
+
+#endif
@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TessPath.cpp
+//
+// Per object choice between the tessellated and plain paths by projected size.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "TessPath.h"
+#include <algorithm>
+#include <float.h>
+
+using namespace DirectX;
+
+
+//--------------------------------------------------------------------------------------
+// Returns the bounding sphere in world space of an object space box
+//--------------------------------------------------------------------------------------
+void GetWorldBoundingSphere( FXMVECTOR vBoxCenter, FXMVECTOR vBoxExtents, CXMMATRIX mWorld, XMVECTOR* pvCenter, float* pfRadius )
+{
+    assert( NULL != pvCenter );
+    assert( NULL != pfRadius );
+
+    // The radius grows with the largest scale of the world matrix
+    float fScale = std::max( std::max( XMVectorGetX( XMVector3Length( mWorld.r[0] ) ), XMVectorGetX( XMVector3Length( mWorld.r[1] ) ) ),
+                             XMVectorGetX( XMVector3Length( mWorld.r[2] ) ) );
+
+    *pvCenter = XMVector3TransformCoord( vBoxCenter, mWorld );
+    *pfRadius = XMVectorGetX( XMVector3Length( vBoxExtents ) ) * fScale;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the diameter in pixels a world space sphere projects to
+//--------------------------------------------------------------------------------------
+float GetProjectedSphereDiameter( FXMVECTOR vCenter, float fRadius, CXMMATRIX mView, CXMMATRIX mProj, float fScreenHeight )
+{
+    // The vertical scale of the projection, cot( fov / 2 ) for a perspective one
+    float fProjScale = XMVectorGetY( mProj.r[1] );
+
+    // An orthographic projection has no perspective divide
+    if( 0.0f == XMVectorGetW( mProj.r[2] ) )
+    {
+        return fRadius * fProjScale * fScreenHeight;
+    }
+
+    // The sphere spans 2 * asin( r / d ) of the view at distance d, whose tangent over the
+    // tangent of half the field of view is r / sqrt( d^2 - r^2 ) * fProjScale
+    XMVECTOR vViewCenter = XMVector3TransformCoord( vCenter, mView );
+    float fDistanceSq = XMVectorGetX( XMVector3LengthSq( vViewCenter ) );
+    float fRadiusSq = fRadius * fRadius;
+    if( fDistanceSq <= fRadiusSq )
+    {
+        return FLT_MAX;
+    }
+
+    return fRadius * fProjScale * fScreenHeight / sqrtf( fDistanceSq - fRadiusSq );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CTessPathSelector::CTessPathSelector()
+{
+    m_Settings.fMinDiameter = TESS_PATH_MIN_DIAMETER;
+    m_Settings.fHysteresis = TESS_PATH_HYSTERESIS;
+    Reset( 0 );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CTessPathSelector::~CTessPathSelector()
+{
+}
+
+
+//--------------------------------------------------------------------------------------
+// Sets the thresholds, keeping the paths
+//--------------------------------------------------------------------------------------
+void CTessPathSelector::Init( const TESS_PATH_SETTINGS* pSettings )
+{
+    assert( NULL != pSettings );
+
+    m_Settings = *pSettings;
+    m_Settings.fHysteresis = std::max( m_Settings.fHysteresis, 1.0f );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Forgets the paths of all the objects
+//--------------------------------------------------------------------------------------
+void CTessPathSelector::Reset( UINT uNumObjects )
+{
+    m_Paths.assign( uNumObjects, (BYTE)TESS_PATH_UNDECIDED );
+    m_uNumSwitches = 0;
+    BeginFrame();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Clears the counters of the frame
+//--------------------------------------------------------------------------------------
+void CTessPathSelector::BeginFrame()
+{
+    ZeroMemory( &m_FrameStats, sizeof( m_FrameStats ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Chooses the path of an object from its projected diameter
+//--------------------------------------------------------------------------------------
+bool CTessPathSelector::Select( UINT uObject, float fDiameter )
+{
+    if( uObject >= (UINT)m_Paths.size() )
+    {
+        m_Paths.resize( uObject + 1, (BYTE)TESS_PATH_UNDECIDED );
+    }
+
+    // The threshold to cross depends on the side the object is on
+    TESS_PATH Path = (TESS_PATH)m_Paths[uObject];
+    float fThreshold = m_Settings.fMinDiameter;
+    if( TESS_PATH_PLAIN == Path )
+    {
+        fThreshold *= m_Settings.fHysteresis;
+    }
+
+    TESS_PATH NewPath = ( fDiameter >= fThreshold ) ? TESS_PATH_TESSELLATED : TESS_PATH_PLAIN;
+    if( TESS_PATH_UNDECIDED != Path && NewPath != Path )
+    {
+        m_FrameStats.uNumSwitches++;
+        m_uNumSwitches++;
+    }
+    m_Paths[uObject] = (BYTE)NewPath;
+
+    if( TESS_PATH_TESSELLATED == NewPath )
+    {
+        m_FrameStats.uNumTessellated++;
+        return true;
+    }
+
+    m_FrameStats.uNumPlain++;
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,127 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TessPath.h
+//
+// Per object choice between the tessellated path (HS_PNTriangles and DS_PNTriangles) and
+// the plain VS_RenderScene path. An object covering a few dozen pixels gains nothing
+// visible from tessellation, while enabling the HS and DS stages still costs their setup
+// and the patch constants of every triangle, so objects whose bounding sphere projects to
+// less than fMinDiameter pixels are drawn without tessellation.
+//
+// The switch has hysteresis: a tessellated object takes the plain path below
+// fMinDiameter, and a plain one goes back to tessellation only above fMinDiameter *
+// fHysteresis, so an object hovering around the threshold doesn't flicker between the
+// two surfaces. Objects are indexed by the caller, the sample uses the meshes of the
+// sdkmesh, and the selector has no device dependency so it can be driven by a CPU camera.
+//--------------------------------------------------------------------------------------
+#ifndef TESS_PATH_H
+#define TESS_PATH_H
+
+#include <vector>
+
+// Defaults of the selector, in pixels of the screen height
+static const float TESS_PATH_MIN_DIAMETER   = 64.0f;
+static const float TESS_PATH_HYSTERESIS     = 1.25f;
+
+struct TESS_PATH_SETTINGS
+{
+    float   fMinDiameter;       // Objects smaller than this take the plain path
+    float   fHysteresis;        // Plain objects return above fMinDiameter * fHysteresis, at least 1
+};
+
+// Counters of the objects selected since BeginFrame
+struct TESS_PATH_STATS
+{
+    UINT    uNumTessellated;
+    UINT    uNumPlain;
+    UINT    uNumSwitches;       // Objects that changed path, not counting their first selection
+};
+
+
+//--------------------------------------------------------------------------------------
+// Returns the bounding sphere in world space of a box given as center and extents in
+// object space, as CDXUTSDKMesh::GetMeshBBoxCenter and GetMeshBBoxExtents return
+//--------------------------------------------------------------------------------------
+void GetWorldBoundingSphere( DirectX::FXMVECTOR vBoxCenter, DirectX::FXMVECTOR vBoxExtents, DirectX::CXMMATRIX mWorld,
+                             DirectX::XMVECTOR* pvCenter, float* pfRadius );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the diameter in pixels a world space sphere projects to on a screen of
+// fScreenHeight pixels, for a perspective or orthographic projection. Returns FLT_MAX if
+// the eye is inside the sphere.
+//--------------------------------------------------------------------------------------
+float GetProjectedSphereDiameter( DirectX::FXMVECTOR vCenter, float fRadius, DirectX::CXMMATRIX mView, DirectX::CXMMATRIX mProj,
+                                  float fScreenHeight );
+
+
+//--------------------------------------------------------------------------------------
+// The path of each object, updated once per frame from its projected size
+//--------------------------------------------------------------------------------------
+class CTessPathSelector
+{
+public:
+
+    CTessPathSelector();
+    ~CTessPathSelector();
+
+    void Init( const TESS_PATH_SETTINGS* pSettings );
+    const TESS_PATH_SETTINGS* GetSettings() const { return &m_Settings; }
+
+    // Forgets the paths of all the objects, the next selection of each takes no hysteresis
+    void Reset( UINT uNumObjects );
+    UINT GetNumObjects() const { return (UINT)m_Paths.size(); }
+
+    // Clears the counters of the frame
+    void BeginFrame();
+
+    // Chooses the path of an object from its projected diameter. Returns true for the
+    // tessellated path.
+    bool Select( UINT uObject, float fDiameter );
+
+    // The path chosen by the last Select of an object, tessellated if it was never selected
+    bool IsTessellated( UINT uObject ) const
+    {
+        return ( uObject >= (UINT)m_Paths.size() ) || ( TESS_PATH_PLAIN != m_Paths[uObject] );
+    }
+
+    const TESS_PATH_STATS* GetFrameStats() const { return &m_FrameStats; }
+    UINT GetNumSwitches() const { return m_uNumSwitches; }
+
+private:
+
+    enum TESS_PATH
+    {
+        TESS_PATH_UNDECIDED,
+        TESS_PATH_TESSELLATED,
+        TESS_PATH_PLAIN,
+    };
+
+    TESS_PATH_SETTINGS      m_Settings;
+    std::vector<BYTE>       m_Paths;            // TESS_PATH of each object
+    TESS_PATH_STATS         m_FrameStats;
+    UINT                    m_uNumSwitches;     // Since Reset
+};
+
+#endif
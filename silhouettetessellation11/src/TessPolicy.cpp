@@ -0,0 +1,497 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TessPolicy.cpp
+//
+// Per material tessellation policies, loaded from a sidecar next to the sdkmesh.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "..\\..\\DXUT\\Optional\\SDKmesh.h"
+#include "TessPolicy.h"
+#include "TriTessellator.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+// Columns given on a sidecar line, the others come from the default policy
+static const UINT POLICY_COLUMN_TESSELLATE  = 1;
+static const UINT POLICY_COLUMN_FACTOR      = 2;
+static const UINT POLICY_COLUMN_ADAPTIVE    = 4;
+
+// Names of the adaptive modes in a sidecar
+struct ADAPTIVE_MODE_NAME
+{
+    const char* pszName;
+    DWORD       dwFlag;
+};
+
+static const ADAPTIVE_MODE_NAME ADAPTIVE_MODE_NAMES[] =
+{
+    { "ss",     SS_ADAPT },
+    { "dist",   DIST_ADAPT },
+    { "res",    RES_ADAPT },
+    { "orient", ORIENT_ADAPT },
+    { "fovea",  FOVEA_ADAPT },
+    { "motion", MOTION_ADAPT },
+};
+
+// Indexed by TESS_PASS
+static const TESS_PASS_POLICY TESS_PASS_POLICIES[TESS_PASS_MAX] =
+{
+    { 0,                                            0.0f,                   false,  false },    // TESS_PASS_COLOR
+    { 0,                                            0.0f,                   true,   false },    // TESS_PASS_DEPTH
+    { FOVEA_ADAPT | MOTION_ADAPT | RES_ADAPT,       TESS_SHADOW_MAX_FACTOR, true,   true },     // TESS_PASS_SHADOW
+};
+
+
+//--------------------------------------------------------------------------------------
+// Returns the hull shader permutation a policy uses given the UI's
+//--------------------------------------------------------------------------------------
+DWORD GetTessPolicyFlags( const TESS_POLICY* pPolicy, DWORD dwFlags )
+{
+    assert( NULL != pPolicy );
+
+    if( !pPolicy->bTessellate || 0 == dwFlags )
+    {
+        return 0;
+    }
+
+    if( TESS_POLICY_INHERIT_FLAGS != pPolicy->dwAdaptiveFlags )
+    {
+        dwFlags = ( dwFlags & ~TESS_POLICY_ADAPTIVE_FLAGS ) | ( pPolicy->dwAdaptiveFlags & TESS_POLICY_ADAPTIVE_FLAGS );
+    }
+
+    if( dwFlags & SS_ADAPT )
+    {
+        dwFlags &= ~( DIST_ADAPT | RES_ADAPT );
+    }
+
+    return dwFlags;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the max tess factor a policy uses given the UI's, capped by the policy's
+//--------------------------------------------------------------------------------------
+float GetTessPolicyFactor( const TESS_POLICY* pPolicy, float fTessFactor )
+{
+    assert( NULL != pPolicy );
+
+    return ( pPolicy->fMaxTessFactor > 0.0f ) ? std::min( fTessFactor, pPolicy->fMaxTessFactor ) : fTessFactor;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the policy of a pass
+//--------------------------------------------------------------------------------------
+const TESS_PASS_POLICY* GetTessPassPolicy( TESS_PASS ePass )
+{
+    assert( ePass < TESS_PASS_MAX );
+
+    return &TESS_PASS_POLICIES[ePass];
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the hull and domain shader permutation of a pass
+//--------------------------------------------------------------------------------------
+DWORD GetTessPassFlags( TESS_PASS ePass, DWORD dwFlags )
+{
+    const TESS_PASS_POLICY* pPassPolicy = GetTessPassPolicy( ePass );
+
+    if( 0 == dwFlags )
+    {
+        return 0;
+    }
+
+    dwFlags &= ~pPassPolicy->dwDropFlags;
+    if( pPassPolicy->bPositionOnly )
+    {
+        dwFlags |= DEPTH_ONLY;
+    }
+
+    return dwFlags;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the max tess factor of a pass
+//--------------------------------------------------------------------------------------
+float GetTessPassFactor( TESS_PASS ePass, float fTessFactor )
+{
+    const TESS_PASS_POLICY* pPassPolicy = GetTessPassPolicy( ePass );
+
+    return ( pPassPolicy->fMaxTessFactor > 0.0f ) ? std::min( fTessFactor, pPassPolicy->fMaxTessFactor ) : fTessFactor;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Sets the constants of a shadow pass from those of the camera
+//--------------------------------------------------------------------------------------
+void InitShadowTessFactorConstants( const TESS_FACTOR_CONSTANTS* pCameraConstants, CXMMATRIX mLightView, CXMMATRIX mLightProj,
+                                    UINT uShadowMapSize, TESS_FACTOR_CONSTANTS* pConstants )
+{
+    assert( NULL != pCameraConstants );
+    assert( NULL != pConstants );
+
+    // The light view, frustum and shadow map size
+    TESS_FACTOR_CONSTANTS LightConstants;
+    InitTessFactorConstants( mLightView, mLightProj, uShadowMapSize, uShadowMapSize, &LightConstants );
+
+    *pConstants = *pCameraConstants;
+    pConstants->f4x4ViewProjection = LightConstants.f4x4ViewProjection;
+    pConstants->f4x4PrevViewProjection = LightConstants.f4x4ViewProjection;
+    pConstants->f3ViewVector = LightConstants.f3ViewVector;
+    pConstants->f2ScreenSize = LightConstants.f2ScreenSize;
+    pConstants->f2ResolutionReference = LightConstants.f2ResolutionReference;
+    pConstants->f2FoveaFocus = LightConstants.f2FoveaFocus;
+    for( UINT uPlane = 0; uPlane < 4; uPlane++ )
+    {
+        pConstants->f4ViewFrustumPlanes[uPlane] = LightConstants.f4ViewFrustumPlanes[uPlane];
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reads the next token of a sidecar line, quoted if it has spaces. Returns false at the
+// end of the line or at a comment, or if a quote is not closed.
+//--------------------------------------------------------------------------------------
+static bool ReadPolicyToken( const char** ppszLine, std::string* pToken )
+{
+    const char* pszLine = *ppszLine;
+    while( ' ' == *pszLine || '\t' == *pszLine )
+    {
+        pszLine++;
+    }
+
+    pToken->clear();
+    if( 0 == *pszLine || '\n' == *pszLine || '\r' == *pszLine || ( '#' == *pszLine && !isdigit( (unsigned char)pszLine[1] ) ) )
+    {
+        *ppszLine = pszLine;
+        return false;
+    }
+
+    if( '"' == *pszLine )
+    {
+        const char* pszEnd = strchr( pszLine + 1, '"' );
+        if( NULL == pszEnd )
+        {
+            *ppszLine = pszLine;
+            return false;
+        }
+        pToken->assign( pszLine + 1, pszEnd );
+        *ppszLine = pszEnd + 1;
+        return true;
+    }
+
+    const char* pszEnd = pszLine;
+    while( 0 != *pszEnd && ' ' != *pszEnd && '\t' != *pszEnd && '\n' != *pszEnd && '\r' != *pszEnd )
+    {
+        pszEnd++;
+    }
+    pToken->assign( pszLine, pszEnd );
+    *ppszLine = pszEnd;
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Parses the adaptive modes column. Returns false if a mode is unknown.
+//--------------------------------------------------------------------------------------
+static bool ParseAdaptiveModes( const std::string& Modes, DWORD* pdwFlags )
+{
+    if( 0 == _stricmp( Modes.c_str(), "inherit" ) )
+    {
+        *pdwFlags = TESS_POLICY_INHERIT_FLAGS;
+        return true;
+    }
+
+    *pdwFlags = 0;
+    if( 0 == _stricmp( Modes.c_str(), "none" ) )
+    {
+        return true;
+    }
+
+    size_t uStart = 0;
+    while( uStart <= Modes.size() )
+    {
+        size_t uEnd = Modes.find( '|', uStart );
+        if( std::string::npos == uEnd )
+        {
+            uEnd = Modes.size();
+        }
+
+        std::string Mode = Modes.substr( uStart, uEnd - uStart );
+        bool bFound = false;
+        for( UINT i = 0; i < ARRAYSIZE( ADAPTIVE_MODE_NAMES ); i++ )
+        {
+            if( 0 == _stricmp( Mode.c_str(), ADAPTIVE_MODE_NAMES[i].pszName ) )
+            {
+                *pdwFlags |= ADAPTIVE_MODE_NAMES[i].dwFlag;
+                bFound = true;
+            }
+        }
+        if( !bFound )
+        {
+            return false;
+        }
+
+        uStart = uEnd + 1;
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CTessPolicyTable::CTessPolicyTable()
+{
+    Reset();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CTessPolicyTable::~CTessPolicyTable()
+{
+}
+
+
+//--------------------------------------------------------------------------------------
+// Back to the default policy only, which inherits everything from the UI
+//--------------------------------------------------------------------------------------
+void CTessPolicyTable::Reset()
+{
+    TESS_POLICY Default;
+    Default.Material = "*";
+    Default.bTessellate = true;
+    Default.fMaxTessFactor = 0.0f;
+    Default.dwAdaptiveFlags = TESS_POLICY_INHERIT_FLAGS;
+
+    m_Policies.clear();
+    m_Policies.push_back( Default );
+    m_MaterialPolicies.clear();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reads a sidecar, replacing the policies
+//--------------------------------------------------------------------------------------
+HRESULT CTessPolicyTable::Load( const WCHAR* pszFileName, UINT* puErrorLine )
+{
+    assert( NULL != pszFileName );
+
+    Reset();
+    if( NULL != puErrorLine )
+    {
+        *puErrorLine = 0;
+    }
+
+    FILE* pInput = NULL;
+    if( 0 != _wfopen_s( &pInput, pszFileName, L"r" ) || NULL == pInput )
+    {
+        return E_FAIL;
+    }
+
+    std::vector<TESS_POLICY> Policies( 1, m_Policies[0] );
+    std::vector<UINT> Columns( 1, 0 );
+
+    char szLine[512];
+    UINT uLine = 0;
+    HRESULT hr = S_OK;
+    while( SUCCEEDED( hr ) && NULL != fgets( szLine, sizeof( szLine ), pInput ) )
+    {
+        uLine++;
+
+        const char* pszLine = szLine;
+        std::string Token;
+        if( !ReadPolicyToken( &pszLine, &Token ) )
+        {
+            // Blank lines and comments, or a quote not closed
+            hr = ( '"' != *pszLine ) ? S_OK : E_INVALIDARG;
+            continue;
+        }
+
+        TESS_POLICY Policy = Policies[0];
+        Policy.Material = Token;
+        UINT uColumns = 0;
+
+        if( ReadPolicyToken( &pszLine, &Token ) )
+        {
+            uColumns |= POLICY_COLUMN_TESSELLATE;
+            if( 0 == _stricmp( Token.c_str(), "on" ) )
+            {
+                Policy.bTessellate = true;
+            }
+            else if( 0 == _stricmp( Token.c_str(), "off" ) )
+            {
+                Policy.bTessellate = false;
+            }
+            else
+            {
+                hr = E_INVALIDARG;
+            }
+        }
+
+        if( SUCCEEDED( hr ) && ReadPolicyToken( &pszLine, &Token ) )
+        {
+            uColumns |= POLICY_COLUMN_FACTOR;
+            char* pszEnd = NULL;
+            Policy.fMaxTessFactor = (float)strtod( Token.c_str(), &pszEnd );
+            if( 0 != *pszEnd || Policy.fMaxTessFactor < 0.0f )
+            {
+                hr = E_INVALIDARG;
+            }
+            else if( Policy.fMaxTessFactor > 0.0f )
+            {
+                Policy.fMaxTessFactor = std::min( std::max( Policy.fMaxTessFactor, TESS_MIN_FACTOR ), TESS_MAX_FACTOR );
+            }
+        }
+
+        if( SUCCEEDED( hr ) && ReadPolicyToken( &pszLine, &Token ) )
+        {
+            uColumns |= POLICY_COLUMN_ADAPTIVE;
+            if( !ParseAdaptiveModes( Token, &Policy.dwAdaptiveFlags ) )
+            {
+                hr = E_INVALIDARG;
+            }
+        }
+
+        // Nothing but a comment may follow
+        if( SUCCEEDED( hr ) && ReadPolicyToken( &pszLine, &Token ) )
+        {
+            hr = E_INVALIDARG;
+        }
+
+        if( FAILED( hr ) )
+        {
+            continue;
+        }
+
+        // A later line for the same material replaces the earlier one
+        UINT uPolicy = 0;
+        while( uPolicy < (UINT)Policies.size() && Policies[uPolicy].Material != Policy.Material )
+        {
+            uPolicy++;
+        }
+        if( uPolicy == (UINT)Policies.size() )
+        {
+            Policies.push_back( Policy );
+            Columns.push_back( uColumns );
+        }
+        else
+        {
+            Policies[uPolicy] = Policy;
+            Columns[uPolicy] = uColumns;
+        }
+    }
+
+    fclose( pInput );
+
+    if( FAILED( hr ) )
+    {
+        if( NULL != puErrorLine )
+        {
+            *puErrorLine = uLine;
+        }
+        return hr;
+    }
+
+    // The columns a line omitted come from the default, wherever it was in the file
+    for( UINT uPolicy = 1; uPolicy < (UINT)Policies.size(); uPolicy++ )
+    {
+        if( !( Columns[uPolicy] & POLICY_COLUMN_TESSELLATE ) )
+        {
+            Policies[uPolicy].bTessellate = Policies[0].bTessellate;
+        }
+        if( !( Columns[uPolicy] & POLICY_COLUMN_FACTOR ) )
+        {
+            Policies[uPolicy].fMaxTessFactor = Policies[0].fMaxTessFactor;
+        }
+        if( !( Columns[uPolicy] & POLICY_COLUMN_ADAPTIVE ) )
+        {
+            Policies[uPolicy].dwAdaptiveFlags = Policies[0].dwAdaptiveFlags;
+        }
+    }
+
+    m_Policies.swap( Policies );
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Looks up the policy of every material of the sdkmesh, by name then by index
+//--------------------------------------------------------------------------------------
+void CTessPolicyTable::AssignMaterials( CDXUTSDKMesh* pDXUTMesh )
+{
+    assert( NULL != pDXUTMesh );
+
+    m_MaterialPolicies.assign( pDXUTMesh->GetNumMaterials(), 0 );
+
+    for( UINT uMaterial = 0; uMaterial < (UINT)m_MaterialPolicies.size(); uMaterial++ )
+    {
+        char szName[MAX_MATERIAL_NAME + 1];
+        strncpy_s( szName, sizeof( szName ), pDXUTMesh->GetMaterial( uMaterial )->Name, MAX_MATERIAL_NAME );
+
+        char szIndex[16];
+        sprintf_s( szIndex, "#%u", uMaterial );
+
+        // A policy for the name wins over one for the index
+        for( UINT uPolicy = 1; uPolicy < (UINT)m_Policies.size(); uPolicy++ )
+        {
+            if( 0 != szName[0] && m_Policies[uPolicy].Material == szName )
+            {
+                m_MaterialPolicies[uMaterial] = uPolicy;
+                break;
+            }
+            if( m_Policies[uPolicy].Material == szIndex )
+            {
+                m_MaterialPolicies[uMaterial] = uPolicy;
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns true if a material uses the policy, or for the default if none were assigned
+//--------------------------------------------------------------------------------------
+bool CTessPolicyTable::IsPolicyUsed( UINT uPolicy ) const
+{
+    if( m_MaterialPolicies.empty() )
+    {
+        return ( 0 == uPolicy );
+    }
+
+    return ( m_MaterialPolicies.end() != std::find( m_MaterialPolicies.begin(), m_MaterialPolicies.end(), uPolicy ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,175 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TessPolicy.h
+//
+// Per material tessellation policies: whether the subsets of a material are tessellated,
+// their maximum tess factor and adaptive modes. Policies are loaded from a sidecar text
+// file next to the sdkmesh (<mesh>.tesspolicy) with one policy per line:
+//
+//      # material      tessellate  max factor  adaptive modes
+//      *               on          0           inherit
+//      "Rock wall"     off
+//      Hero            on          15          ss|orient
+//      #2              on          3           dist
+//
+// The material is SDKMESH_MATERIAL::Name (quoted if it has spaces), * for the materials
+// without a policy, or #N for material N of meshes with unnamed materials. The max factor
+// caps the UI's factor (0 for no cap), and the adaptive modes are ss, dist, res, orient,
+// fovea and motion joined by |, none, or inherit to keep the UI's. Omitted columns keep
+// those of the * line.
+//
+// On top of the material policy each pass picks its own: the colour pass renders as the
+// policy says, while the depth pre-pass and shadow passes only need positions, and the
+// shadow pass only needs the silhouettes as seen from the light.
+//--------------------------------------------------------------------------------------
+#ifndef TESS_POLICY_H
+#define TESS_POLICY_H
+
+#include "TessFactors.h"
+#include <string>
+#include <vector>
+
+class CDXUTSDKMesh;
+
+// Permutation flags a policy chooses
+static const DWORD TESS_POLICY_ADAPTIVE_FLAGS   = SS_ADAPT | DIST_ADAPT | RES_ADAPT | ORIENT_ADAPT | FOVEA_ADAPT | MOTION_ADAPT;
+static const DWORD TESS_POLICY_INHERIT_FLAGS    = 0xffffffff;
+
+struct TESS_POLICY
+{
+    std::string     Material;           // Key of the sidecar line, * for the default
+    bool            bTessellate;
+    float           fMaxTessFactor;     // Cap of the UI's factor, 0 for none
+    DWORD           dwAdaptiveFlags;    // TESS_POLICY_INHERIT_FLAGS for the UI's
+};
+
+// Passes a tessellated mesh is rendered in
+enum TESS_PASS
+{
+    TESS_PASS_COLOR,
+    TESS_PASS_DEPTH,        // Depth pre-pass from the camera, must match the colour pass depths
+    TESS_PASS_SHADOW,       // Shadow map from a light
+    TESS_PASS_MAX
+};
+
+// Default cap of the shadow pass factors, shadow map texels are larger than pixels and
+// the shadow only shows the outline of the mesh
+static const float TESS_SHADOW_MAX_FACTOR = 6.0f;
+
+// How a pass changes the permutation and factor a material policy chose
+struct TESS_PASS_POLICY
+{
+    DWORD           dwDropFlags;        // Adaptive modes the pass leaves out
+    float           fMaxTessFactor;     // Cap of the factor, 0 for none
+    bool            bPositionOnly;      // DEPTH_ONLY domain shader
+    bool            bLightView;         // Factors are evaluated from the light (InitShadowTessFactorConstants)
+};
+
+
+//--------------------------------------------------------------------------------------
+// Returns the policy of a pass. The depth pass keeps the factors of the colour pass, so
+// both tessellate to the same surface and the colour pass can test depth for equality.
+//--------------------------------------------------------------------------------------
+const TESS_PASS_POLICY* GetTessPassPolicy( TESS_PASS ePass );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the hull and domain shader permutation of a pass given the one of the material
+// policy (GetTessPolicyFlags), 0 if its subsets are not tessellated
+//--------------------------------------------------------------------------------------
+DWORD GetTessPassFlags( TESS_PASS ePass, DWORD dwFlags );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the max tess factor of a pass given the one of the material policy
+//--------------------------------------------------------------------------------------
+float GetTessPassFactor( TESS_PASS ePass, float fTessFactor );
+
+
+//--------------------------------------------------------------------------------------
+// Sets the constants of a shadow pass from those of the camera: the view projection,
+// frustum and screen size are those of the light and the shadow map, the view vector
+// points to the light, so orientation adaptivity refines the silhouettes the light sees,
+// and the eye stays the camera's, so distance adaptivity follows the viewer.
+//--------------------------------------------------------------------------------------
+void InitShadowTessFactorConstants( const TESS_FACTOR_CONSTANTS* pCameraConstants, DirectX::CXMMATRIX mLightView,
+                                    DirectX::CXMMATRIX mLightProj, UINT uShadowMapSize, TESS_FACTOR_CONSTANTS* pConstants );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the hull shader permutation a policy uses given the UI's, 0 if its subsets are
+// not tessellated. SS_ADAPT replaces the distance and resolution factors in the shader, so
+// they are dropped with it to stay within the cached permutations.
+//--------------------------------------------------------------------------------------
+DWORD GetTessPolicyFlags( const TESS_POLICY* pPolicy, DWORD dwFlags );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the max tess factor a policy uses given the UI's (or an instance tier's),
+// capped by the policy's max factor so a policy never raises it
+//--------------------------------------------------------------------------------------
+float GetTessPolicyFactor( const TESS_POLICY* pPolicy, float fTessFactor );
+
+
+//--------------------------------------------------------------------------------------
+// The policies of a mesh, and the policy of each of its materials
+//--------------------------------------------------------------------------------------
+class CTessPolicyTable
+{
+public:
+
+    CTessPolicyTable();
+    ~CTessPolicyTable();
+
+    // Reads a sidecar, replacing the policies. On a syntax error *puErrorLine is set to the
+    // line (from 1) and the default policy is kept.
+    HRESULT Load( const WCHAR* pszFileName, UINT* puErrorLine );
+
+    // Back to the default policy only, which inherits everything from the UI
+    void Reset();
+
+    // Looks up the policy of every material of the sdkmesh
+    void AssignMaterials( CDXUTSDKMesh* pDXUTMesh );
+
+    UINT GetNumPolicies() const { return (UINT)m_Policies.size(); }
+    const TESS_POLICY* GetPolicy( UINT uPolicy ) const { return &m_Policies[uPolicy]; }
+
+    // Index of the policy of a material, the default for materials not assigned
+    UINT GetMaterialPolicy( UINT uMaterial ) const
+    {
+        return ( uMaterial < (UINT)m_MaterialPolicies.size() ) ? m_MaterialPolicies[uMaterial] : 0;
+    }
+    const UINT* GetMaterialPolicies() const { return m_MaterialPolicies.empty() ? NULL : &m_MaterialPolicies[0]; }
+    UINT GetNumMaterials() const { return (UINT)m_MaterialPolicies.size(); }
+
+    // True if any material uses the policy, so its batch has subsets to draw
+    bool IsPolicyUsed( UINT uPolicy ) const;
+
+private:
+
+    std::vector<TESS_POLICY>    m_Policies;         // The default first
+    std::vector<UINT>           m_MaterialPolicies;
+};
+
+#endif
@@ -0,0 +1,352 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+//--------------------------------------------------------------------------------------
+// File: TessellationCache.cpp
+//
+// Cache of CPU tessellated patches across frames.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "TessellationCache.h"
+
+using namespace DirectX;
+
+// Bits per quantized factor in a key, enough for TESS_MAX_FACTOR * TESS_FACTOR_QUANTIZATION
+static const UINT TESS_FACTOR_KEY_BITS = 7;
+
+// When over budget, evict down to this fraction of it so evictions happen in batches
+static const float TESS_CACHE_EVICTION_TARGET = 0.75f;
+
+// The patterns are dropped and rebuilt on demand beyond this many
+static const UINT TESS_CACHE_MAX_PATTERNS = 1024;
+
+
+//--------------------------------------------------------------------------------------
+// Quantizes the factors and returns the key of the quantized tuple
+//--------------------------------------------------------------------------------------
+UINT QuantizeTessFactors( const float* pfEdgeFactors, float fInsideFactor, float* pfQuantizedEdgeFactors, float* pfQuantizedInsideFactor )
+{
+    assert( NULL != pfEdgeFactors );
+    assert( NULL != pfQuantizedEdgeFactors );
+    assert( NULL != pfQuantizedInsideFactor );
+
+    float fFactors[4] = { pfEdgeFactors[0], pfEdgeFactors[1], pfEdgeFactors[2], fInsideFactor };
+    UINT uKey = 0;
+
+    for( UINT i = 0; i < 4; i++ )
+    {
+        // Culled, as the tessellator would
+        if( i < 3 && !( fFactors[i] > 0.0f ) )
+        {
+            return 0;
+        }
+
+        float fFactor = fFactors[i] > TESS_MIN_FACTOR ? std::min( fFactors[i], TESS_MAX_FACTOR ) : TESS_MIN_FACTOR;
+        UINT uSteps = (UINT)( fFactor * (float)TESS_FACTOR_QUANTIZATION + 0.5f );
+        fFactors[i] = (float)uSteps / (float)TESS_FACTOR_QUANTIZATION;
+        uKey |= uSteps << ( i * TESS_FACTOR_KEY_BITS );
+    }
+
+    pfQuantizedEdgeFactors[0] = fFactors[0];
+    pfQuantizedEdgeFactors[1] = fFactors[1];
+    pfQuantizedEdgeFactors[2] = fFactors[2];
+    *pfQuantizedInsideFactor = fFactors[3];
+
+    return uKey;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CTessellationCache::CTessellationCache() :
+    m_Technique( CPU_TESS_PN_TRIANGLES ),
+    m_uByteBudget( 0 ),
+    m_uGeneration( 0 ),
+    m_bNothingToEvict( false )
+{
+    memset( &m_Stats, 0, sizeof( m_Stats ) );
+    m_Uncached.uKey = 0;
+    m_Uncached.uGeneration = 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CTessellationCache::~CTessellationCache()
+{
+    Destroy();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Sizes the cache for the given number of patches, all empty
+//--------------------------------------------------------------------------------------
+void CTessellationCache::Create( CPU_TESS_TECHNIQUE Technique, UINT uNumPatches, SIZE_T uByteBudget )
+{
+    Destroy();
+
+    m_Technique = Technique;
+    m_uByteBudget = uByteBudget;
+
+    ENTRY Empty;
+    Empty.uKey = 0;
+    Empty.uGeneration = 0;
+    m_Entries.assign( uNumPatches, Empty );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Releases all the blocks and patterns
+//--------------------------------------------------------------------------------------
+void CTessellationCache::Destroy()
+{
+    std::vector<ENTRY>().swap( m_Entries );
+    std::vector<PN_VERTEX>().swap( m_Uncached.Vertices );
+    std::vector<WORD>().swap( m_Uncached.Indices );
+    m_Patterns.clear();
+
+    m_uGeneration = 0;
+    m_bNothingToEvict = false;
+    memset( &m_Stats, 0, sizeof( m_Stats ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Starts a new generation and resets the frame counters
+//--------------------------------------------------------------------------------------
+void CTessellationCache::BeginFrame()
+{
+    m_uGeneration++;
+    m_bNothingToEvict = false;
+
+    m_Stats.uHits = 0;
+    m_Stats.uMisses = 0;
+    m_Stats.uUncached = 0;
+    m_Stats.uCulled = 0;
+    m_Stats.uEvictions = 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the tessellation of a patch at the given factors
+//--------------------------------------------------------------------------------------
+bool CTessellationCache::GetPatch( UINT uPatch, const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints,
+                                   const float* pfEdgeFactors, float fInsideFactor, TESS_CACHE_BLOCK* pBlock )
+{
+    assert( uPatch < (UINT)m_Entries.size() );
+    assert( NULL != pCorners );
+    assert( NULL != pBlock );
+
+    memset( pBlock, 0, sizeof( TESS_CACHE_BLOCK ) );
+
+    float fEdgeFactors[3], fInside;
+    UINT uKey = QuantizeTessFactors( pfEdgeFactors, fInsideFactor, fEdgeFactors, &fInside );
+    if( 0 == uKey )
+    {
+        m_Stats.uCulled++;
+        return false;
+    }
+
+    ENTRY* pEntry = &m_Entries[uPatch];
+    bool bHit = ( pEntry->uKey == uKey );
+
+    if( bHit )
+    {
+        m_Stats.uHits++;
+    }
+    else
+    {
+        m_Stats.uMisses++;
+
+        // The stale block's storage is reused for the new one
+        if( 0 != pEntry->uKey )
+        {
+            m_Stats.uResidentBytes -= GetEntryBytes( pEntry );
+            m_Stats.uResidentBlocks--;
+            pEntry->uKey = 0;
+        }
+
+        const TRI_TESSELLATION* pPattern = GetPattern( uKey, fEdgeFactors, fInside );
+        SIZE_T uBytes = std::max( pPattern->DomainPoints.size(), pEntry->Vertices.capacity() ) * sizeof( PN_VERTEX ) +
+                        std::max( pPattern->Indices.size(), pEntry->Indices.capacity() ) * sizeof( WORD );
+
+        if( !MakeRoom( uBytes ) )
+        {
+            m_Stats.uUncached++;
+            std::vector<PN_VERTEX>().swap( pEntry->Vertices );
+            std::vector<WORD>().swap( pEntry->Indices );
+            pEntry = &m_Uncached;
+        }
+
+        pEntry->Vertices.resize( pPattern->DomainPoints.size() );
+        pEntry->Indices.resize( pPattern->Indices.size() );
+        if( !pEntry->Vertices.empty() )
+        {
+            EvaluatePatchVertices( m_Technique, pCorners, pControlPoints, pPattern, &pEntry->Vertices[0] );
+        }
+        for( UINT i = 0; i < (UINT)pPattern->Indices.size(); i++ )
+        {
+            pEntry->Indices[i] = (WORD)pPattern->Indices[i];
+        }
+
+        if( pEntry != &m_Uncached )
+        {
+            pEntry->uKey = uKey;
+            m_Stats.uResidentBytes += GetEntryBytes( pEntry );
+            m_Stats.uResidentBlocks++;
+        }
+    }
+
+    pEntry->uGeneration = m_uGeneration;
+
+    pBlock->uNumVertices = (UINT)pEntry->Vertices.size();
+    pBlock->pVertices = pEntry->Vertices.empty() ? NULL : &pEntry->Vertices[0];
+    pBlock->uNumIndices = (UINT)pEntry->Indices.size();
+    pBlock->pIndices = pEntry->Indices.empty() ? NULL : &pEntry->Indices[0];
+
+    return bHit;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the frame counters and the resident size
+//--------------------------------------------------------------------------------------
+void CTessellationCache::GetStats( TESS_CACHE_STATS* pStats ) const
+{
+    assert( NULL != pStats );
+
+    *pStats = m_Stats;
+
+    pStats->uPatternBytes = 0;
+    for( std::map<UINT, TRI_TESSELLATION>::const_iterator it = m_Patterns.begin(); it != m_Patterns.end(); ++it )
+    {
+        pStats->uPatternBytes += it->second.DomainPoints.size() * sizeof( XMFLOAT3 ) +
+                                 it->second.Indices.size() * sizeof( UINT ) +
+                                 it->second.Rows.size() * sizeof( TESS_ROW );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the tessellation pattern of the quantized factors, shared by all the patches
+//--------------------------------------------------------------------------------------
+const TRI_TESSELLATION* CTessellationCache::GetPattern( UINT uKey, const float* pfEdgeFactors, float fInsideFactor )
+{
+    std::map<UINT, TRI_TESSELLATION>::iterator it = m_Patterns.find( uKey );
+    if( it != m_Patterns.end() )
+    {
+        return &it->second;
+    }
+
+    if( m_Patterns.size() >= TESS_CACHE_MAX_PATTERNS )
+    {
+        m_Patterns.clear();
+    }
+
+    TRI_TESSELLATION* pPattern = &m_Patterns[uKey];
+    TessellateTri( pfEdgeFactors, fInsideFactor, pPattern );
+
+    return pPattern;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Evicts the blocks unused for the longest until uBytes more fit the budget. Blocks used
+// in the current frame are never evicted. Returns false if it doesn't fit.
+//--------------------------------------------------------------------------------------
+bool CTessellationCache::MakeRoom( SIZE_T uBytes )
+{
+    if( m_Stats.uResidentBytes + uBytes <= m_uByteBudget )
+    {
+        return true;
+    }
+
+    if( m_bNothingToEvict )
+    {
+        return false;
+    }
+
+    std::vector< std::pair<UINT, UINT> > Candidates;
+    for( UINT i = 0; i < (UINT)m_Entries.size(); i++ )
+    {
+        if( 0 != m_Entries[i].uKey && m_Entries[i].uGeneration < m_uGeneration )
+        {
+            Candidates.push_back( std::make_pair( m_Entries[i].uGeneration, i ) );
+        }
+    }
+    std::sort( Candidates.begin(), Candidates.end() );
+
+    SIZE_T uTarget = (SIZE_T)( (double)m_uByteBudget * TESS_CACHE_EVICTION_TARGET );
+    UINT uCandidate = 0;
+    while( uCandidate < (UINT)Candidates.size() && m_Stats.uResidentBytes + uBytes > uTarget )
+    {
+        Evict( &m_Entries[Candidates[uCandidate++].second] );
+    }
+
+    if( uCandidate == (UINT)Candidates.size() )
+    {
+        m_bNothingToEvict = true;
+    }
+
+    return m_Stats.uResidentBytes + uBytes <= m_uByteBudget;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Evicts the block of an entry
+//--------------------------------------------------------------------------------------
+void CTessellationCache::Evict( ENTRY* pEntry )
+{
+    Release( pEntry );
+    m_Stats.uEvictions++;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Releases the block of an entry
+//--------------------------------------------------------------------------------------
+void CTessellationCache::Release( ENTRY* pEntry )
+{
+    m_Stats.uResidentBytes -= GetEntryBytes( pEntry );
+    m_Stats.uResidentBlocks--;
+
+    std::vector<PN_VERTEX>().swap( pEntry->Vertices );
+    std::vector<WORD>().swap( pEntry->Indices );
+    pEntry->uKey = 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Bytes held by the block of an entry
+//--------------------------------------------------------------------------------------
+SIZE_T CTessellationCache::GetEntryBytes( const ENTRY* pEntry )
+{
+    return pEntry->Vertices.capacity() * sizeof( PN_VERTEX ) + pEntry->Indices.capacity() * sizeof( WORD );
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
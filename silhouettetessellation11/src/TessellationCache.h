@@ -0,0 +1,128 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+//--------------------------------------------------------------------------------------
+// File: TessellationCache.h
+//
+// Cache of CPU tessellated patches across frames. Each patch keeps its last evaluated
+// vertex and index block, keyed by its quantized tess factors, so only the patches whose
+// factors changed since they were last used are tessellated again. Blocks record the
+// frame (generation) they were last used in, and when the cache exceeds its byte budget
+// the blocks unused for the longest are evicted.
+//--------------------------------------------------------------------------------------
+#ifndef TESSELLATION_CACHE_H
+#define TESSELLATION_CACHE_H
+
+#include "CPUTessellation.h"
+#include <map>
+
+// Tess factors are quantized to steps of 1 / TESS_FACTOR_QUANTIZATION before tessellating,
+// so nearly equal factors share a block
+static const UINT TESS_FACTOR_QUANTIZATION = 8;
+
+// An evaluated patch. Indices are relative to the block's vertices.
+struct TESS_CACHE_BLOCK
+{
+    const PN_VERTEX*    pVertices;
+    UINT                uNumVertices;
+    const WORD*         pIndices;
+    UINT                uNumIndices;
+};
+
+// Counters of the current frame, and the resident size
+struct TESS_CACHE_STATS
+{
+    UINT    uHits;
+    UINT    uMisses;            // Includes uUncached
+    UINT    uUncached;          // Misses that didn't fit the budget
+    UINT    uCulled;
+    UINT    uEvictions;
+    UINT    uResidentBlocks;
+    SIZE_T  uResidentBytes;     // Vertex and index blocks
+    SIZE_T  uPatternBytes;      // Tessellation patterns shared by the blocks
+};
+
+
+//--------------------------------------------------------------------------------------
+// Quantizes the factors and returns the key of the quantized tuple, 0 if the patch is
+// culled (an edge factor <= 0 or NaN)
+//--------------------------------------------------------------------------------------
+UINT QuantizeTessFactors( const float* pfEdgeFactors, float fInsideFactor, float* pfQuantizedEdgeFactors, float* pfQuantizedInsideFactor );
+
+
+//--------------------------------------------------------------------------------------
+// Per-patch tessellation cache
+//--------------------------------------------------------------------------------------
+class CTessellationCache
+{
+public:
+
+    CTessellationCache();
+    ~CTessellationCache();
+
+    void Create( CPU_TESS_TECHNIQUE Technique, UINT uNumPatches, SIZE_T uByteBudget );
+    void Destroy();
+
+    void SetByteBudget( SIZE_T uByteBudget ) { m_uByteBudget = uByteBudget; }
+
+    // Starts a new generation and resets the frame counters
+    void BeginFrame();
+
+    // Returns the tessellation of a patch at the given factors, evaluating it if the cached
+    // block is missing or was built with other factors. pControlPoints may be NULL for
+    // Phong. The block stays valid until the patch is requested again, or until the next
+    // call if the block could not be cached. Returns true on a hit.
+    bool GetPatch( UINT uPatch, const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints,
+                   const float* pfEdgeFactors, float fInsideFactor, TESS_CACHE_BLOCK* pBlock );
+
+    void GetStats( TESS_CACHE_STATS* pStats ) const;
+
+private:
+
+    struct ENTRY
+    {
+        UINT                    uKey;           // Quantized factors, 0 if empty
+        UINT                    uGeneration;    // Last frame the block was used in
+        std::vector<PN_VERTEX>  Vertices;
+        std::vector<WORD>       Indices;
+    };
+
+    const TRI_TESSELLATION* GetPattern( UINT uKey, const float* pfEdgeFactors, float fInsideFactor );
+    bool MakeRoom( SIZE_T uBytes );
+    void Evict( ENTRY* pEntry );
+    void Release( ENTRY* pEntry );
+    static SIZE_T GetEntryBytes( const ENTRY* pEntry );
+
+    CPU_TESS_TECHNIQUE                  m_Technique;
+    std::vector<ENTRY>                  m_Entries;
+    ENTRY                               m_Uncached;
+    std::map<UINT, TRI_TESSELLATION>    m_Patterns;
+
+    SIZE_T                              m_uByteBudget;
+    UINT                                m_uGeneration;
+    bool                                m_bNothingToEvict;  // No older blocks left this frame
+
+    TESS_CACHE_STATS                    m_Stats;
+};
+
+#endif
@@ -0,0 +1,326 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+//--------------------------------------------------------------------------------------
+// File: TriTessellator.cpp
+//
+// CPU approximation of the tri domain fractional_odd tessellation pattern.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "TriTessellator.h"
+
+using namespace DirectX;
+
+// Segments per side of the outer ring at TESS_MAX_FACTOR
+static const UINT TESS_MAX_SEGMENTS = 15;
+
+// Steps closer than this, in fractions of a side, are considered equal when splitting rows
+static const float ROW_STEP_TOLERANCE = 1.0e-6f;
+
+// A ring of the pattern. Its points are consecutive, going round the sides A->B, B->C
+// and C->A, where A is U == 1, B is V == 1 and C is W == 1.
+struct TESS_RING
+{
+    UINT    uFirstPoint;
+    UINT    uNumSegments[3];
+    float   fParams[3][TESS_MAX_SEGMENTS + 1];  // Position of each point along its side, 0 to 1
+};
+
+
+//--------------------------------------------------------------------------------------
+// Clamps a tess factor to the supported range, NaN goes to the minimum
+//--------------------------------------------------------------------------------------
+static float ClampTessFactor( float fFactor )
+{
+    if( !( fFactor > TESS_MIN_FACTOR ) )
+    {
+        return TESS_MIN_FACTOR;
+    }
+
+    return std::min( fFactor, TESS_MAX_FACTOR );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Number of segments fractional_odd partitioning splits a factor into
+//--------------------------------------------------------------------------------------
+static UINT RoundUpToOdd( float fFactor )
+{
+    return (UINT)ceilf( fFactor ) | 1;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Fills pfParams[0] to pfParams[uNumSegments] with the position of the points along a side
+// of the given factor. The fractional part is absorbed by the 2 segments next to the
+// middle one, so the pattern stays symmetric and the points move continuously with the
+// factor.
+//--------------------------------------------------------------------------------------
+static void PartitionSide( float fFactor, UINT uNumSegments, float* pfParams )
+{
+    pfParams[0] = 0.0f;
+    if( uNumSegments < 3 )
+    {
+        pfParams[uNumSegments] = 1.0f;
+        return;
+    }
+
+    float fFull = 1.0f / fFactor;
+    float fPartial = 0.5f * ( fFactor - (float)( uNumSegments - 2 ) ) / fFactor;
+    UINT uMiddle = ( uNumSegments - 1 ) / 2;
+
+    for( UINT s = 0; s < uNumSegments - 1; s++ )
+    {
+        bool bPartial = ( s + 1 == uMiddle ) || ( s == uMiddle + 1 );
+        pfParams[s + 1] = pfParams[s] + ( bPartial ? fPartial : fFull );
+    }
+    pfParams[uNumSegments] = 1.0f;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the index of a point of a ring, uPoint == uNumSegments being the next corner
+//--------------------------------------------------------------------------------------
+static UINT RingPoint( const TESS_RING& Ring, UINT uSide, UINT uPoint )
+{
+    UINT uNumPoints = Ring.uNumSegments[0] + Ring.uNumSegments[1] + Ring.uNumSegments[2];
+    if( 0 == uNumPoints )
+    {
+        return Ring.uFirstPoint;
+    }
+
+    UINT uIndex = uPoint;
+    for( UINT s = 0; s < uSide; s++ )
+    {
+        uIndex += Ring.uNumSegments[s];
+    }
+
+    return Ring.uFirstPoint + uIndex % uNumPoints;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Adds the points of a ring, scaled about the center of the domain. A ring without
+// segments is a single point at the center. With bRows the points are also split into
+// rows of constant step.
+//--------------------------------------------------------------------------------------
+static void AddRing( float fScale, const float* pfFactors, const UINT* puNumSegments, bool bRows,
+                     TRI_TESSELLATION* pTessellation, TESS_RING* pRing )
+{
+    XMVECTOR vCenter = XMVectorReplicate( 1.0f / 3.0f );
+    XMVECTOR vCorners[3] =
+    {
+        XMVectorSet( 1.0f, 0.0f, 0.0f, 0.0f ),
+        XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f ),
+        XMVectorSet( 0.0f, 0.0f, 1.0f, 0.0f ),
+    };
+    for( UINT c = 0; c < 3; c++ )
+    {
+        vCorners[c] = XMVectorLerp( vCenter, vCorners[c], fScale );
+    }
+
+    pRing->uFirstPoint = (UINT)pTessellation->DomainPoints.size();
+
+    if( 0 == puNumSegments[0] + puNumSegments[1] + puNumSegments[2] )
+    {
+        memset( pRing->uNumSegments, 0, sizeof( pRing->uNumSegments ) );
+
+        XMFLOAT3 f3Point;
+        XMStoreFloat3( &f3Point, vCenter );
+        pTessellation->DomainPoints.push_back( f3Point );
+
+        if( bRows )
+        {
+            TESS_ROW Row = { pRing->uFirstPoint, 1, XMFLOAT3( 0.0f, 0.0f, 0.0f ) };
+            pTessellation->Rows.push_back( Row );
+        }
+        return;
+    }
+
+    for( UINT uSide = 0; uSide < 3; uSide++ )
+    {
+        UINT uNumSegments = puNumSegments[uSide];
+        float* pfParams = pRing->fParams[uSide];
+        pRing->uNumSegments[uSide] = uNumSegments;
+        PartitionSide( pfFactors[uSide], uNumSegments, pfParams );
+
+        XMVECTOR vStart = vCorners[uSide];
+        XMVECTOR vEdge = XMVectorSubtract( vCorners[( uSide + 1 ) % 3], vStart );
+
+        UINT uSideStart = (UINT)pTessellation->DomainPoints.size();
+        for( UINT k = 0; k < uNumSegments; k++ )
+        {
+            XMFLOAT3 f3Point;
+            XMStoreFloat3( &f3Point, XMVectorAdd( vStart, XMVectorScale( vEdge, pfParams[k] ) ) );
+            pTessellation->DomainPoints.push_back( f3Point );
+        }
+
+        if( !bRows )
+        {
+            continue;
+        }
+
+        // Split the side into runs of points that are the same distance apart
+        UINT uRunStart = 0;
+        for( UINT k = 1; k <= uNumSegments; k++ )
+        {
+            float fRunStep = pfParams[uRunStart + 1] - pfParams[uRunStart];
+            bool bEndOfRun = ( k == uNumSegments ) ||
+                             ( k - uRunStart >= 2 && fabsf( ( pfParams[k] - pfParams[k - 1] ) - fRunStep ) > ROW_STEP_TOLERANCE );
+            if( !bEndOfRun )
+            {
+                continue;
+            }
+
+            TESS_ROW Row;
+            Row.uFirstPoint = uSideStart + uRunStart;
+            Row.uNumPoints = k - uRunStart;
+            XMStoreFloat3( &Row.f3Step, ( Row.uNumPoints > 1 ) ? XMVectorScale( vEdge, fRunStep ) : XMVectorZero() );
+            pTessellation->Rows.push_back( Row );
+
+            uRunStart = k;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Fills the band between 2 rings with triangles, walking each side of both rings
+// together and always advancing along the ring whose next point comes first
+//--------------------------------------------------------------------------------------
+static void StitchRings( const TESS_RING& Outer, const TESS_RING& Inner, TRI_TESSELLATION* pTessellation )
+{
+    std::vector<UINT>& Indices = pTessellation->Indices;
+
+    for( UINT uSide = 0; uSide < 3; uSide++ )
+    {
+        UINT uNumOuter = Outer.uNumSegments[uSide];
+        UINT uNumInner = Inner.uNumSegments[uSide];
+        UINT i = 0, j = 0;
+
+        while( i < uNumOuter || j < uNumInner )
+        {
+            bool bAdvanceOuter = ( j == uNumInner ) ||
+                                 ( i < uNumOuter && Outer.fParams[uSide][i + 1] <= Inner.fParams[uSide][j + 1] );
+            if( bAdvanceOuter )
+            {
+                Indices.push_back( RingPoint( Outer, uSide, i ) );
+                Indices.push_back( RingPoint( Outer, uSide, i + 1 ) );
+                Indices.push_back( RingPoint( Inner, uSide, j ) );
+                i++;
+            }
+            else
+            {
+                Indices.push_back( RingPoint( Outer, uSide, i ) );
+                Indices.push_back( RingPoint( Inner, uSide, j + 1 ) );
+                Indices.push_back( RingPoint( Inner, uSide, j ) );
+                j++;
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Tessellates a tri domain
+//--------------------------------------------------------------------------------------
+void TessellateTri( const float* pfEdgeFactors, float fInsideFactor, TRI_TESSELLATION* pTessellation )
+{
+    assert( NULL != pfEdgeFactors );
+    assert( NULL != pTessellation );
+
+    pTessellation->DomainPoints.clear();
+    pTessellation->Indices.clear();
+    pTessellation->Rows.clear();
+    pTessellation->uNumTransitionPoints = 0;
+
+    for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+    {
+        if( !( pfEdgeFactors[uEdge] > 0.0f ) )
+        {
+            return;
+        }
+    }
+
+    // Sides of the outer ring, A->B lies on W == 0, B->C on U == 0 and C->A on V == 0
+    float fOuterFactors[3] =
+    {
+        ClampTessFactor( pfEdgeFactors[2] ),
+        ClampTessFactor( pfEdgeFactors[0] ),
+        ClampTessFactor( pfEdgeFactors[1] ),
+    };
+    UINT uOuterSegments[3];
+    for( UINT uSide = 0; uSide < 3; uSide++ )
+    {
+        uOuterSegments[uSide] = RoundUpToOdd( fOuterFactors[uSide] );
+    }
+
+    float fInside = ClampTessFactor( fInsideFactor );
+    UINT uInsideSegments = RoundUpToOdd( fInside );
+
+    TESS_RING Rings[2];
+    TESS_RING* pOuter = &Rings[0];
+    TESS_RING* pInner = &Rings[1];
+
+    AddRing( 1.0f, fOuterFactors, uOuterSegments, false, pTessellation, pOuter );
+    pTessellation->uNumTransitionPoints = (UINT)pTessellation->DomainPoints.size();
+
+    if( 1 == uInsideSegments )
+    {
+        if( 1 == uOuterSegments[0] && 1 == uOuterSegments[1] && 1 == uOuterSegments[2] )
+        {
+            pTessellation->Indices.push_back( 0 );
+            pTessellation->Indices.push_back( 1 );
+            pTessellation->Indices.push_back( 2 );
+            return;
+        }
+
+        // Fan the split edges around the center
+        UINT uNoSegments[3] = { 0, 0, 0 };
+        AddRing( 0.0f, fOuterFactors, uNoSegments, true, pTessellation, pInner );
+        StitchRings( *pOuter, *pInner, pTessellation );
+        return;
+    }
+
+    // Each inner ring has 2 fewer segments per side, down to the center triangle
+    for( UINT uRing = 1; uRing <= ( uInsideSegments - 1 ) / 2; uRing++ )
+    {
+        float fRingFactor = fInside - 2.0f * (float)uRing;
+        float fRingFactors[3] = { fRingFactor, fRingFactor, fRingFactor };
+        UINT uRingSegments = uInsideSegments - 2 * uRing;
+        UINT uRingSegmentsPerSide[3] = { uRingSegments, uRingSegments, uRingSegments };
+
+        AddRing( std::max( fRingFactor, 0.0f ) / fInside, fRingFactors, uRingSegmentsPerSide, true, pTessellation, pInner );
+        StitchRings( *pOuter, *pInner, pTessellation );
+        std::swap( pOuter, pInner );
+    }
+
+    pTessellation->Indices.push_back( RingPoint( *pOuter, 0, 0 ) );
+    pTessellation->Indices.push_back( RingPoint( *pOuter, 1, 0 ) );
+    pTessellation->Indices.push_back( RingPoint( *pOuter, 2, 0 ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,68 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+//--------------------------------------------------------------------------------------
+// File: TriTessellator.h
+//
+// CPU approximation of the fixed function tessellator for the tri domain with
+// fractional_odd partitioning, as used by the hull shaders of the sample. The pattern is
+// made of concentric rings: the outer ring is split by the edge factors and every inner
+// ring by the inside factor, each with 2 fewer segments per side than the ring around it,
+// down to a center triangle. Within a side the points are spaced 1 / factor apart, except
+// for the 2 segments next to the middle one that absorb the fractional part. It does not
+// reproduce the hardware point placement exactly.
+//--------------------------------------------------------------------------------------
+#ifndef TRI_TESSELLATOR_H
+#define TRI_TESSELLATOR_H
+
+#include <vector>
+
+// Range of the tess factors, as [maxtessfactor] in the hull shaders
+static const float TESS_MIN_FACTOR = 1.0f;
+static const float TESS_MAX_FACTOR = 15.0f;
+
+// A run of consecutive domain points that step by a constant amount
+struct TESS_ROW
+{
+    UINT                uFirstPoint;
+    UINT                uNumPoints;
+    DirectX::XMFLOAT3   f3Step;         // Added to a point's (U, V, W) to get the next one
+};
+
+struct TRI_TESSELLATION
+{
+    std::vector<DirectX::XMFLOAT3>  DomainPoints;       // (U, V, W) as SV_DomainLocation
+    std::vector<UINT>               Indices;            // Triangle list, same winding as the patch
+    std::vector<TESS_ROW>           Rows;               // Cover the points of the inner rings
+    UINT                            uNumTransitionPoints; // Points of the outer ring, which come first
+};
+
+
+//--------------------------------------------------------------------------------------
+// Tessellates a tri domain. pfEdgeFactors follow SV_TessFactor: [0] is the U == 0 edge,
+// [1] the V == 0 edge and [2] the W == 0 edge. Factors are clamped to the range above, and
+// as on the hardware the patch is culled (no output) if an edge factor is <= 0 or NaN.
+//--------------------------------------------------------------------------------------
+void TessellateTri( const float* pfEdgeFactors, float fInsideFactor, TRI_TESSELLATION* pTessellation );
+
+#endif
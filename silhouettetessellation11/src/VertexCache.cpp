@@ -0,0 +1,277 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: VertexCache.cpp
+//
+// Post transform vertex cache optimization of triangle lists.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "VertexCache.h"
+#include <float.h>
+
+using namespace DirectX;
+
+// Scoring of the vertices, see Forsyth's paper for the reasoning behind the values
+static const float VERTEX_CACHE_DECAY_POWER     = 1.5f;
+static const float VERTEX_LAST_TRI_SCORE        = 0.75f;
+static const float VERTEX_VALENCE_BOOST_SCALE   = 2.0f;
+static const float VERTEX_VALENCE_BOOST_POWER   = 0.5f;
+
+
+//--------------------------------------------------------------------------------------
+// Score of a vertex given its position in the modelled LRU cache (-1 if not in it) and
+// the number of triangles still to be added that use it
+//--------------------------------------------------------------------------------------
+static float GetVertexScore( int iCachePosition, UINT uNumRemainingTris )
+{
+    if( 0 == uNumRemainingTris )
+    {
+        return -1.0f;
+    }
+
+    float fScore = 0.0f;
+    if( iCachePosition >= 3 )
+    {
+        // The last triangle's vertices get a fixed score so it is not simply repeated
+        const float fScaler = 1.0f / (float)( VERTEX_CACHE_OPTIMIZE_SIZE - 3 );
+        fScore = powf( 1.0f - (float)( iCachePosition - 3 ) * fScaler, VERTEX_CACHE_DECAY_POWER );
+    }
+    else if( iCachePosition >= 0 )
+    {
+        fScore = VERTEX_LAST_TRI_SCORE;
+    }
+
+    // Favour vertices with few triangles left, so they are finished off
+    fScore += VERTEX_VALENCE_BOOST_SCALE * powf( (float)uNumRemainingTris, -VERTEX_VALENCE_BOOST_POWER );
+
+    return fScore;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reorders the triangles of a triangle list to improve post transform vertex cache reuse
+//--------------------------------------------------------------------------------------
+void OptimizeVertexCache( UINT* pIndices, UINT uNumIndices, UINT uNumVertices )
+{
+    assert( NULL != pIndices || 0 == uNumIndices );
+
+    UINT uNumTris = uNumIndices / 3;
+    if( 0 == uNumTris )
+    {
+        return;
+    }
+
+    // Triangles of each vertex. The triangles still to be added come first in each list.
+    std::vector<UINT> TriStart( uNumVertices + 1, 0 );
+    for( UINT i = 0; i < uNumTris * 3; i++ )
+    {
+        assert( pIndices[i] < uNumVertices );
+        TriStart[pIndices[i] + 1]++;
+    }
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        TriStart[v + 1] += TriStart[v];
+    }
+
+    std::vector<UINT> NumRemainingTris( uNumVertices, 0 );
+    std::vector<UINT> VertexTris( uNumTris * 3 );
+    for( UINT i = 0; i < uNumTris * 3; i++ )
+    {
+        UINT uVertex = pIndices[i];
+        VertexTris[TriStart[uVertex] + NumRemainingTris[uVertex]++] = i / 3;
+    }
+
+    std::vector<int> CachePositions( uNumVertices, -1 );
+    std::vector<float> VertexScores( uNumVertices );
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        VertexScores[v] = GetVertexScore( -1, NumRemainingTris[v] );
+    }
+
+    std::vector<float> TriScores( uNumTris );
+    std::vector<BYTE> TriAdded( uNumTris, 0 );
+    UINT uBestTri = 0;
+    for( UINT t = 0; t < uNumTris; t++ )
+    {
+        const UINT* pTri = &pIndices[t * 3];
+        TriScores[t] = VertexScores[pTri[0]] + VertexScores[pTri[1]] + VertexScores[pTri[2]];
+        if( TriScores[t] > TriScores[uBestTri] )
+        {
+            uBestTri = t;
+        }
+    }
+
+    std::vector<UINT> Output;
+    Output.reserve( uNumTris * 3 );
+
+    UINT uCache[VERTEX_CACHE_OPTIMIZE_SIZE + 3];
+    UINT uCacheSize = 0;
+    UINT uNextUnaddedTri = 0;
+
+    for( UINT uNumAdded = 0; uNumAdded < uNumTris; uNumAdded++ )
+    {
+        // Nothing in the cache has triangles left, start again from the next one in order
+        if( UINT_MAX == uBestTri )
+        {
+            while( TriAdded[uNextUnaddedTri] )
+            {
+                uNextUnaddedTri++;
+            }
+            uBestTri = uNextUnaddedTri;
+        }
+
+        const UINT* pTri = &pIndices[uBestTri * 3];
+        TriAdded[uBestTri] = 1;
+        Output.push_back( pTri[0] );
+        Output.push_back( pTri[1] );
+        Output.push_back( pTri[2] );
+
+        for( UINT c = 0; c < 3; c++ )
+        {
+            UINT uVertex = pTri[c];
+            UINT* pVertexTris = &VertexTris[TriStart[uVertex]];
+            UINT uLast = --NumRemainingTris[uVertex];
+            for( UINT i = 0; i <= uLast; i++ )
+            {
+                if( pVertexTris[i] == uBestTri )
+                {
+                    std::swap( pVertexTris[i], pVertexTris[uLast] );
+                    break;
+                }
+            }
+        }
+
+        // The triangle's vertices go to the front of the cache, pushing the others back
+        UINT uNewCache[VERTEX_CACHE_OPTIMIZE_SIZE + 3];
+        UINT uNewCacheSize = 0;
+        for( UINT c = 0; c < 3; c++ )
+        {
+            if( std::find( uNewCache, uNewCache + uNewCacheSize, pTri[c] ) == uNewCache + uNewCacheSize )
+            {
+                uNewCache[uNewCacheSize++] = pTri[c];
+            }
+        }
+        for( UINT i = 0; i < uCacheSize; i++ )
+        {
+            if( uCache[i] != pTri[0] && uCache[i] != pTri[1] && uCache[i] != pTri[2] )
+            {
+                uNewCache[uNewCacheSize++] = uCache[i];
+            }
+        }
+
+        // Rescore the vertices that moved, including the ones that fell out of the cache,
+        // and pick the best triangle among those using the vertices still cached
+        uBestTri = UINT_MAX;
+        float fBestScore = -FLT_MAX;
+        for( UINT i = 0; i < uNewCacheSize; i++ )
+        {
+            UINT uVertex = uNewCache[i];
+            CachePositions[uVertex] = ( i < VERTEX_CACHE_OPTIMIZE_SIZE ) ? (int)i : -1;
+
+            float fScore = GetVertexScore( CachePositions[uVertex], NumRemainingTris[uVertex] );
+            float fDelta = fScore - VertexScores[uVertex];
+            VertexScores[uVertex] = fScore;
+
+            const UINT* pVertexTris = &VertexTris[TriStart[uVertex]];
+            for( UINT j = 0; j < NumRemainingTris[uVertex]; j++ )
+            {
+                UINT uTri = pVertexTris[j];
+                TriScores[uTri] += fDelta;
+                if( i < VERTEX_CACHE_OPTIMIZE_SIZE && TriScores[uTri] > fBestScore )
+                {
+                    fBestScore = TriScores[uTri];
+                    uBestTri = uTri;
+                }
+            }
+        }
+
+        uCacheSize = std::min( uNewCacheSize, VERTEX_CACHE_OPTIMIZE_SIZE );
+        memcpy( uCache, uNewCache, uCacheSize * sizeof( UINT ) );
+    }
+
+    memcpy( pIndices, &Output[0], Output.size() * sizeof( UINT ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Renumbers the vertices so they are fetched in order of first use
+//--------------------------------------------------------------------------------------
+UINT OptimizeVertexFetch( UINT* pIndices, UINT uNumIndices, UINT uNumVertices, UINT* pRemap )
+{
+    assert( NULL != pIndices || 0 == uNumIndices );
+    assert( NULL != pRemap );
+
+    for( UINT v = 0; v < uNumVertices; v++ )
+    {
+        pRemap[v] = UINT_MAX;
+    }
+
+    UINT uNumUsed = 0;
+    for( UINT i = 0; i < uNumIndices; i++ )
+    {
+        assert( pIndices[i] < uNumVertices );
+        UINT& uRemap = pRemap[pIndices[i]];
+        if( UINT_MAX == uRemap )
+        {
+            uRemap = uNumUsed++;
+        }
+        pIndices[i] = uRemap;
+    }
+
+    return uNumUsed;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the ACMR of a triangle list drawn through a FIFO cache
+//--------------------------------------------------------------------------------------
+float ComputeACMR( const UINT* pIndices, UINT uNumIndices, UINT uCacheSize )
+{
+    assert( NULL != pIndices || 0 == uNumIndices );
+
+    UINT uNumTris = uNumIndices / 3;
+    if( 0 == uNumTris || 0 == uCacheSize )
+    {
+        return 0.0f;
+    }
+
+    std::vector<UINT> Cache( uCacheSize, UINT_MAX );
+    UINT uNext = 0;
+    UINT uNumMisses = 0;
+    for( UINT i = 0; i < uNumTris * 3; i++ )
+    {
+        if( std::find( Cache.begin(), Cache.end(), pIndices[i] ) == Cache.end() )
+        {
+            Cache[uNext] = pIndices[i];
+            uNext = ( uNext + 1 ) % uCacheSize;
+            uNumMisses++;
+        }
+    }
+
+    return (float)uNumMisses / (float)uNumTris;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: VertexCache.h
+//
+// Post transform vertex cache optimization of triangle lists, after Tom Forsyth's
+// "Linear-Speed Vertex Cache Optimisation", and the matching vertex fetch reordering.
+//--------------------------------------------------------------------------------------
+#ifndef VERTEX_CACHE_H
+#define VERTEX_CACHE_H
+
+// Size of the LRU cache the optimization models
+static const UINT VERTEX_CACHE_OPTIMIZE_SIZE    = 32;
+
+// Size of the FIFO cache the average cache miss ratio is reported for
+static const UINT VERTEX_CACHE_MEASURE_SIZE     = 16;
+
+
+//--------------------------------------------------------------------------------------
+// Reorders the triangles of a triangle list in place to improve post transform vertex
+// cache reuse. Indices must be less than uNumVertices. Triangle winding is preserved.
+//--------------------------------------------------------------------------------------
+void OptimizeVertexCache( UINT* pIndices, UINT uNumIndices, UINT uNumVertices );
+
+
+//--------------------------------------------------------------------------------------
+// Renumbers the vertices so they are fetched in order of first use. pRemap receives the
+// new index of each of the uNumVertices vertices (UINT_MAX if unused), and the return
+// value is the number of vertices used.
+//--------------------------------------------------------------------------------------
+UINT OptimizeVertexFetch( UINT* pIndices, UINT uNumIndices, UINT uNumVertices, UINT* pRemap );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the average number of vertices transformed per triangle (ACMR) of a triangle
+// list drawn through a FIFO post transform cache of uCacheSize entries
+//--------------------------------------------------------------------------------------
+float ComputeACMR( const UINT* pIndices, UINT uNumIndices, UINT uCacheSize );
+
+#endif
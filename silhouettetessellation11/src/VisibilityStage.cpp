@@ -0,0 +1,541 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: VisibilityStage.cpp
+//
+// Pipelined frustum culling of runs of triangles, computed a frame ahead for a predicted
+// camera.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "VisibilityStage.h"
+
+using namespace DirectX;
+
+// Relative difference of the projection parameters that counts as a change
+static const float VISIBILITY_PROJECTION_EPSILON = 1.0e-5f;
+
+
+//--------------------------------------------------------------------------------------
+// Splits the subsets into runs of triangles and computes their world space bounds
+//--------------------------------------------------------------------------------------
+void BuildVisibilityItems( const MESH_DATA* pMeshData, UINT uTrianglesPerItem, CXMMATRIX mWorld,
+                           std::vector<VISIBILITY_ITEM>* pItems )
+{
+    assert( NULL != pMeshData );
+    assert( NULL != pItems );
+    assert( 0 != uTrianglesPerItem );
+
+    pItems->clear();
+
+    for( UINT uSubset = 0; uSubset < (UINT)pMeshData->Subsets.size(); uSubset++ )
+    {
+        const MESH_DATA_SUBSET& Subset = pMeshData->Subsets[uSubset];
+        UINT uNumTriangles = Subset.uIndexCount / 3;
+
+        for( UINT uFirst = 0; uFirst < uNumTriangles; uFirst += uTrianglesPerItem )
+        {
+            UINT uCount = std::min( uTrianglesPerItem, uNumTriangles - uFirst );
+
+            XMVECTOR vMin = XMVectorReplicate( FLT_MAX );
+            XMVECTOR vMax = XMVectorReplicate( -FLT_MAX );
+            float fMaxEdge = 0.0f;
+            for( UINT uTriangle = uFirst; uTriangle < uFirst + uCount; uTriangle++ )
+            {
+                const UINT* pIndices = &pMeshData->Indices[Subset.uIndexStart + uTriangle * 3];
+                XMVECTOR vCorners[3];
+                for( UINT i = 0; i < 3; i++ )
+                {
+                    vCorners[i] = XMLoadFloat3( &pMeshData->Vertices[pIndices[i]].f3Position );
+                    vMin = XMVectorMin( vMin, vCorners[i] );
+                    vMax = XMVectorMax( vMax, vCorners[i] );
+                }
+
+                for( UINT i = 0; i < 3; i++ )
+                {
+                    fMaxEdge = std::max( fMaxEdge, XMVectorGetX( XMVector3Length( XMVectorSubtract( vCorners[( i + 1 ) % 3], vCorners[i] ) ) ) );
+                }
+            }
+
+            // The PN-Triangles control points and the Phong projections move the surface less
+            // than an edge length from the flat triangle
+            XMVECTOR vGrow = XMVectorReplicate( fMaxEdge );
+            vMin = XMVectorSubtract( vMin, vGrow );
+            vMax = XMVectorAdd( vMax, vGrow );
+
+            VISIBILITY_ITEM Item;
+            Item.uMesh = Subset.uMesh;
+            Item.uSubset = Subset.uSubset;
+            Item.uFirstTriangle = uFirst;
+            Item.uNumTriangles = uCount;
+
+            XMVECTOR vWorldMin = XMVectorReplicate( FLT_MAX );
+            XMVECTOR vWorldMax = XMVectorReplicate( -FLT_MAX );
+            for( UINT uCorner = 0; uCorner < 8; uCorner++ )
+            {
+                XMVECTOR vCorner = XMVectorSelect( vMin, vMax, XMVectorSelectControl( uCorner & 1, ( uCorner >> 1 ) & 1, ( uCorner >> 2 ) & 1, 0 ) );
+                vCorner = XMVector3TransformCoord( vCorner, mWorld );
+                vWorldMin = XMVectorMin( vWorldMin, vCorner );
+                vWorldMax = XMVectorMax( vWorldMax, vCorner );
+            }
+            XMStoreFloat3( &Item.f3BoundsMin, vWorldMin );
+            XMStoreFloat3( &Item.f3BoundsMax, vWorldMax );
+
+            pItems->push_back( Item );
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Loads the basis of the camera as the rows of a matrix
+//--------------------------------------------------------------------------------------
+static XMMATRIX LoadCameraBasis( const VISIBILITY_CAMERA* pCamera )
+{
+    XMMATRIX mBasis;
+    mBasis.r[0] = XMLoadFloat3( &pCamera->f3Right );
+    mBasis.r[1] = XMLoadFloat3( &pCamera->f3Up );
+    mBasis.r[2] = XMLoadFloat3( &pCamera->f3Ahead );
+    mBasis.r[3] = g_XMIdentityR3;
+
+    return mBasis;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the cosine of the angle of the rotation between two camera bases
+//--------------------------------------------------------------------------------------
+static float GetRotationCos( const VISIBILITY_CAMERA* pFrom, const VISIBILITY_CAMERA* pTo )
+{
+    float fTrace = XMVectorGetX( XMVector3Dot( XMLoadFloat3( &pFrom->f3Right ), XMLoadFloat3( &pTo->f3Right ) ) ) +
+                   XMVectorGetX( XMVector3Dot( XMLoadFloat3( &pFrom->f3Up ), XMLoadFloat3( &pTo->f3Up ) ) ) +
+                   XMVectorGetX( XMVector3Dot( XMLoadFloat3( &pFrom->f3Ahead ), XMLoadFloat3( &pTo->f3Ahead ) ) );
+
+    return std::min( std::max( 0.5f * ( fTrace - 1.0f ), -1.0f ), 1.0f );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns true if the projection parameters differ
+//--------------------------------------------------------------------------------------
+static bool IsProjectionChanged( const VISIBILITY_CAMERA* pA, const VISIBILITY_CAMERA* pB )
+{
+    return fabsf( pA->fFOV - pB->fFOV ) > VISIBILITY_PROJECTION_EPSILON * pA->fFOV ||
+           fabsf( pA->fAspect - pB->fAspect ) > VISIBILITY_PROJECTION_EPSILON * pA->fAspect;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CVisibilityStage::CVisibilityStage() :
+    m_uFront( 0 ),
+    m_bPipelined( true ),
+    m_fDilationScale( 1.0f ),
+    m_fMinDilationDistance( 0.0f ),
+    m_fMinDilationAngle( 0.005f ),
+    m_bHaveLastCamera( false ),
+    m_hThread( NULL ),
+    m_hStartEvent( NULL ),
+    m_hDoneEvent( NULL ),
+    m_bQuit( false ),
+    m_bBusy( false ),
+    m_bHavePrediction( false ),
+    m_uNumPredictedVisible( 0 )
+{
+    ZeroMemory( &m_LastCamera, sizeof( m_LastCamera ) );
+    ZeroMemory( &m_Prediction, sizeof( m_Prediction ) );
+    ZeroMemory( &m_Stats, sizeof( m_Stats ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CVisibilityStage::~CVisibilityStage()
+{
+    Destroy();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Copies the item bounds and starts the worker
+//--------------------------------------------------------------------------------------
+HRESULT CVisibilityStage::Create( const VISIBILITY_ITEM* pItems, UINT uNumItems )
+{
+    assert( NULL != pItems || 0 == uNumItems );
+
+    Destroy();
+
+    m_BoundsMin.resize( uNumItems );
+    m_BoundsMax.resize( uNumItems );
+    for( UINT i = 0; i < uNumItems; i++ )
+    {
+        m_BoundsMin[i] = pItems[i].f3BoundsMin;
+        m_BoundsMax[i] = pItems[i].f3BoundsMax;
+    }
+
+    // Never empty so the buffers can be returned
+    m_Visible[0].assign( std::max( uNumItems, 1u ), 0 );
+    m_Visible[1].assign( std::max( uNumItems, 1u ), 0 );
+    m_uFront = 0;
+
+    m_bQuit = false;
+    m_hStartEvent = CreateEvent( NULL, FALSE, FALSE, NULL );
+    m_hDoneEvent = CreateEvent( NULL, FALSE, FALSE, NULL );
+    if( NULL == m_hStartEvent || NULL == m_hDoneEvent )
+    {
+        Destroy();
+        return E_FAIL;
+    }
+
+    m_hThread = CreateThread( NULL, 0, WorkerThread, this, 0, NULL );
+    if( NULL == m_hThread )
+    {
+        Destroy();
+        return E_FAIL;
+    }
+
+    ResetStats();
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Stops the worker
+//--------------------------------------------------------------------------------------
+void CVisibilityStage::Destroy()
+{
+    if( NULL != m_hThread )
+    {
+        WaitForWorker();
+
+        m_bQuit = true;
+        SetEvent( m_hStartEvent );
+        WaitForSingleObject( m_hThread, INFINITE );
+        CloseHandle( m_hThread );
+        m_hThread = NULL;
+    }
+
+    if( NULL != m_hStartEvent )
+    {
+        CloseHandle( m_hStartEvent );
+        m_hStartEvent = NULL;
+    }
+
+    if( NULL != m_hDoneEvent )
+    {
+        CloseHandle( m_hDoneEvent );
+        m_hDoneEvent = NULL;
+    }
+
+    m_BoundsMin.clear();
+    m_BoundsMax.clear();
+    m_Visible[0].clear();
+    m_Visible[1].clear();
+    m_bBusy = false;
+    m_bHavePrediction = false;
+    m_bHaveLastCamera = false;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Sets the dilation of the predicted camera
+//--------------------------------------------------------------------------------------
+void CVisibilityStage::SetDilation( float fScale, float fMinDistance, float fMinAngle )
+{
+    m_fDilationScale = std::max( fScale, 0.0f );
+    m_fMinDilationDistance = std::max( fMinDistance, 0.0f );
+    m_fMinDilationAngle = std::max( fMinAngle, 0.0f );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the visibility for the frame's camera and starts culling for the next frame
+//--------------------------------------------------------------------------------------
+const BYTE* CVisibilityStage::BeginFrame( const VISIBILITY_CAMERA* pCamera )
+{
+    assert( NULL != pCamera );
+    assert( NULL != m_hThread );
+
+    LARGE_INTEGER Start, End, Frequency;
+    QueryPerformanceCounter( &Start );
+
+    WaitForWorker();
+
+    m_Stats.uNumFrames++;
+    if( m_bPipelined && m_bHavePrediction && IsCovered( &m_Prediction, pCamera ) )
+    {
+        m_uFront = 1 - m_uFront;
+        m_Stats.uNumVisible = m_uNumPredictedVisible;
+        m_Stats.uNumPredicted++;
+    }
+    else
+    {
+        if( m_bPipelined && m_bHavePrediction )
+        {
+            m_Stats.uNumCorrected++;
+        }
+        else
+        {
+            m_Stats.uNumSynchronous++;
+        }
+
+        PREDICTION Exact;
+        Exact.Camera = *pCamera;
+        Exact.fRadius = 0.0f;
+        Exact.fAngle = 0.0f;
+        m_Stats.uNumVisible = ComputeVisibility( &Exact, &m_Visible[m_uFront][0] );
+    }
+
+    m_bHavePrediction = false;
+    if( m_bPipelined )
+    {
+        // The worker writes the back buffer while the caller reads the front one
+        Predict( pCamera, &m_Prediction );
+        m_bBusy = true;
+        m_bHavePrediction = true;
+        SetEvent( m_hStartEvent );
+    }
+
+    m_LastCamera = *pCamera;
+    m_bHaveLastCamera = true;
+
+    QueryPerformanceCounter( &End );
+    QueryPerformanceFrequency( &Frequency );
+    m_Stats.fRenderThreadMs += (double)( End.QuadPart - Start.QuadPart ) * 1000.0 / (double)Frequency.QuadPart;
+
+    return &m_Visible[m_uFront][0];
+}
+
+
+//--------------------------------------------------------------------------------------
+// Drops the prediction and the motion
+//--------------------------------------------------------------------------------------
+void CVisibilityStage::Invalidate()
+{
+    WaitForWorker();
+
+    m_bHavePrediction = false;
+    m_bHaveLastCamera = false;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Clears the counters
+//--------------------------------------------------------------------------------------
+void CVisibilityStage::ResetStats()
+{
+    UINT uNumVisible = m_Stats.uNumVisible;
+    ZeroMemory( &m_Stats, sizeof( m_Stats ) );
+    m_Stats.uNumVisible = uNumVisible;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Culls for the prediction into the back buffer each time it is started
+//--------------------------------------------------------------------------------------
+DWORD WINAPI CVisibilityStage::WorkerThread( LPVOID pParam )
+{
+    CVisibilityStage* pStage = (CVisibilityStage*)pParam;
+
+    for( ;; )
+    {
+        WaitForSingleObject( pStage->m_hStartEvent, INFINITE );
+        if( pStage->m_bQuit )
+        {
+            break;
+        }
+
+        pStage->m_uNumPredictedVisible = pStage->ComputeVisibility( &pStage->m_Prediction, &pStage->m_Visible[1 - pStage->m_uFront][0] );
+        SetEvent( pStage->m_hDoneEvent );
+    }
+
+    return 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Waits for the worker to finish the prediction, counting a stall if it is not done
+//--------------------------------------------------------------------------------------
+void CVisibilityStage::WaitForWorker()
+{
+    if( !m_bBusy )
+    {
+        return;
+    }
+
+    if( WAIT_TIMEOUT == WaitForSingleObject( m_hDoneEvent, 0 ) )
+    {
+        m_Stats.uNumStalls++;
+        WaitForSingleObject( m_hDoneEvent, INFINITE );
+    }
+
+    m_bBusy = false;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Culls the items against the frustum of every camera within the prediction's dilation.
+// A rotation by up to fAngle moves a direction at most asin( sin( fAngle ) / cos( gamma ) )
+// across the side planes, where gamma is the angle from the view axis to a frustum corner.
+// Moving the eye by up to fRadius moves the planes by up to fRadius.
+//--------------------------------------------------------------------------------------
+UINT CVisibilityStage::ComputeVisibility( const PREDICTION* pPrediction, BYTE* pVisible ) const
+{
+    const VISIBILITY_CAMERA* pCamera = &pPrediction->Camera;
+    UINT uNumItems = (UINT)m_BoundsMin.size();
+
+    float fTanHalfY = tanf( 0.5f * pCamera->fFOV );
+    float fTanHalfX = fTanHalfY * pCamera->fAspect;
+    float fCornerAngle = atanf( sqrtf( fTanHalfX * fTanHalfX + fTanHalfY * fTanHalfY ) );
+    if( fCornerAngle + pPrediction->fAngle >= XM_PIDIV2 )
+    {
+        memset( pVisible, 1, uNumItems );
+        return uNumItems;
+    }
+
+    float fWiden = asinf( std::min( sinf( pPrediction->fAngle ) / cosf( fCornerAngle ), 1.0f ) );
+    float fHalfX = atanf( fTanHalfX ) + fWiden;
+    float fHalfY = atanf( fTanHalfY ) + fWiden;
+    if( fHalfX >= XM_PIDIV2 || fHalfY >= XM_PIDIV2 )
+    {
+        memset( pVisible, 1, uNumItems );
+        return uNumItems;
+    }
+
+    // Inward normals of the left, right, bottom and top planes through the eye
+    XMVECTOR vRight = XMLoadFloat3( &pCamera->f3Right );
+    XMVECTOR vUp = XMLoadFloat3( &pCamera->f3Up );
+    XMVECTOR vAhead = XMLoadFloat3( &pCamera->f3Ahead );
+    XMVECTOR vEye = XMLoadFloat3( &pCamera->f3Eye );
+
+    float fCosX = cosf( fHalfX ), fSinX = sinf( fHalfX );
+    float fCosY = cosf( fHalfY ), fSinY = sinf( fHalfY );
+    XMVECTOR vNormals[4] =
+    {
+        XMVectorAdd( XMVectorScale( vRight, fCosX ), XMVectorScale( vAhead, fSinX ) ),
+        XMVectorAdd( XMVectorScale( vRight, -fCosX ), XMVectorScale( vAhead, fSinX ) ),
+        XMVectorAdd( XMVectorScale( vUp, fCosY ), XMVectorScale( vAhead, fSinY ) ),
+        XMVectorAdd( XMVectorScale( vUp, -fCosY ), XMVectorScale( vAhead, fSinY ) ),
+    };
+
+    float fPlanes[4][4];
+    for( UINT uPlane = 0; uPlane < 4; uPlane++ )
+    {
+        XMFLOAT3 f3Normal;
+        XMStoreFloat3( &f3Normal, vNormals[uPlane] );
+        fPlanes[uPlane][0] = f3Normal.x;
+        fPlanes[uPlane][1] = f3Normal.y;
+        fPlanes[uPlane][2] = f3Normal.z;
+        fPlanes[uPlane][3] = pPrediction->fRadius - XMVectorGetX( XMVector3Dot( vNormals[uPlane], vEye ) );
+    }
+
+    UINT uNumVisible = 0;
+    for( UINT i = 0; i < uNumItems; i++ )
+    {
+        const XMFLOAT3& f3Min = m_BoundsMin[i];
+        const XMFLOAT3& f3Max = m_BoundsMax[i];
+
+        // Outside if the corner furthest along the inward normal is behind a plane
+        bool bVisible = true;
+        for( UINT uPlane = 0; uPlane < 4 && bVisible; uPlane++ )
+        {
+            const float* pPlane = fPlanes[uPlane];
+            float fDistance = ( pPlane[0] > 0.0f ? pPlane[0] * f3Max.x : pPlane[0] * f3Min.x ) +
+                              ( pPlane[1] > 0.0f ? pPlane[1] * f3Max.y : pPlane[1] * f3Min.y ) +
+                              ( pPlane[2] > 0.0f ? pPlane[2] * f3Max.z : pPlane[2] * f3Min.z ) + pPlane[3];
+            bVisible = ( fDistance >= 0.0f );
+        }
+
+        pVisible[i] = bVisible ? 1 : 0;
+        uNumVisible += bVisible ? 1 : 0;
+    }
+
+    return uNumVisible;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Predicts the camera of the next frame by repeating the motion of the last frame, and
+// sizes the dilation from that motion
+//--------------------------------------------------------------------------------------
+void CVisibilityStage::Predict( const VISIBILITY_CAMERA* pCamera, PREDICTION* pPrediction ) const
+{
+    pPrediction->Camera = *pCamera;
+    pPrediction->fRadius = m_fMinDilationDistance;
+    pPrediction->fAngle = m_fMinDilationAngle;
+
+    if( !m_bHaveLastCamera || IsProjectionChanged( &m_LastCamera, pCamera ) )
+    {
+        return;
+    }
+
+    XMVECTOR vEye = XMLoadFloat3( &pCamera->f3Eye );
+    XMVECTOR vStep = XMVectorSubtract( vEye, XMLoadFloat3( &m_LastCamera.f3Eye ) );
+    XMStoreFloat3( &pPrediction->Camera.f3Eye, XMVectorAdd( vEye, vStep ) );
+
+    // With the bases as rows, mCurrent = mLast * mRotation
+    XMMATRIX mLast = LoadCameraBasis( &m_LastCamera );
+    XMMATRIX mCurrent = LoadCameraBasis( pCamera );
+    XMMATRIX mRotation = XMMatrixMultiply( XMMatrixTranspose( mLast ), mCurrent );
+    XMMATRIX mPredicted = XMMatrixMultiply( mCurrent, mRotation );
+
+    // Keep the basis orthonormal as LookTo builds it
+    XMVECTOR vAhead = XMVector3Normalize( mPredicted.r[2] );
+    XMVECTOR vRight = XMVector3Normalize( XMVector3Cross( mPredicted.r[1], vAhead ) );
+    XMVECTOR vUp = XMVector3Cross( vAhead, vRight );
+    XMStoreFloat3( &pPrediction->Camera.f3Right, vRight );
+    XMStoreFloat3( &pPrediction->Camera.f3Up, vUp );
+    XMStoreFloat3( &pPrediction->Camera.f3Ahead, vAhead );
+
+    float fStepAngle = acosf( GetRotationCos( &m_LastCamera, pCamera ) );
+    pPrediction->fRadius += m_fDilationScale * XMVectorGetX( XMVector3Length( vStep ) );
+    pPrediction->fAngle += m_fDilationScale * fStepAngle;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns true if the camera is within the dilation of the prediction
+//--------------------------------------------------------------------------------------
+bool CVisibilityStage::IsCovered( const PREDICTION* pPrediction, const VISIBILITY_CAMERA* pCamera )
+{
+    if( IsProjectionChanged( &pPrediction->Camera, pCamera ) )
+    {
+        return false;
+    }
+
+    XMVECTOR vOffset = XMVectorSubtract( XMLoadFloat3( &pCamera->f3Eye ), XMLoadFloat3( &pPrediction->Camera.f3Eye ) );
+    if( XMVectorGetX( XMVector3LengthSq( vOffset ) ) > pPrediction->fRadius * pPrediction->fRadius )
+    {
+        return false;
+    }
+
+    // Compare the cosines, acos loses the small angles
+    return pPrediction->fAngle >= XM_PI || GetRotationCos( &pPrediction->Camera, pCamera ) >= cosf( pPrediction->fAngle );
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: VisibilityStage.h
+//
+// CPU visibility of runs of triangles, computed a frame ahead on a worker thread so it
+// adds no latency to the render thread. While frame N is submitted the worker culls for
+// the camera predicted for frame N + 1, extrapolated from the last two frames. The culling
+// is dilated for the motion: bounds are grown by the distance the eye may be off and the
+// frustum is widened by the angle the view may be off. When frame N + 1 starts and its
+// camera is outside the dilation (or the projection changed) the prediction is corrected:
+// the frame is culled again synchronously. The stage can also run synchronously only.
+//--------------------------------------------------------------------------------------
+#ifndef VISIBILITY_STAGE_H
+#define VISIBILITY_STAGE_H
+
+#include "MeshData.h"
+
+// A run of consecutive triangles of an sdkmesh subset, drawn with one DrawIndexed
+struct VISIBILITY_ITEM
+{
+    UINT                uMesh;
+    UINT                uSubset;
+    UINT                uFirstTriangle;     // Within the subset
+    UINT                uNumTriangles;
+    DirectX::XMFLOAT3   f3BoundsMin;        // World space
+    DirectX::XMFLOAT3   f3BoundsMax;
+};
+
+// Camera the visibility is computed for, the basis is orthonormal and left handed
+struct VISIBILITY_CAMERA
+{
+    DirectX::XMFLOAT3   f3Eye;
+    DirectX::XMFLOAT3   f3Right;
+    DirectX::XMFLOAT3   f3Up;
+    DirectX::XMFLOAT3   f3Ahead;
+    float               fFOV;               // Vertical, radians
+    float               fAspect;
+};
+
+// Counters since the last ResetStats
+struct VISIBILITY_STATS
+{
+    UINT    uNumFrames;
+    UINT    uNumPredicted;      // Used the results computed ahead
+    UINT    uNumCorrected;      // The camera left the dilation, culled again
+    UINT    uNumSynchronous;    // Synchronous mode, or no prediction yet
+    UINT    uNumStalls;         // Had to wait for the worker
+    double  fRenderThreadMs;    // Spent in BeginFrame
+    UINT    uNumVisible;        // Last frame
+};
+
+
+//--------------------------------------------------------------------------------------
+// Splits the triangle list subsets into runs of up to uTrianglesPerItem triangles and
+// computes their world space bounds. The bounds are grown by the longest edge of the run,
+// which holds the PN-Triangles control points and the Phong tessellated surface.
+//--------------------------------------------------------------------------------------
+void BuildVisibilityItems( const MESH_DATA* pMeshData, UINT uTrianglesPerItem, DirectX::CXMMATRIX mWorld,
+                           std::vector<VISIBILITY_ITEM>* pItems );
+
+
+//--------------------------------------------------------------------------------------
+// Pipelined frustum culling of visibility items
+//--------------------------------------------------------------------------------------
+class CVisibilityStage
+{
+public:
+
+    CVisibilityStage();
+    ~CVisibilityStage();
+
+    // Copies the item bounds and starts the worker thread
+    HRESULT Create( const VISIBILITY_ITEM* pItems, UINT uNumItems );
+    void Destroy();
+
+    UINT GetNumItems() const { return (UINT)m_BoundsMin.size(); }
+
+    void SetPipelined( bool bPipelined ) { m_bPipelined = bPipelined; }
+    bool IsPipelined() const { return m_bPipelined; }
+
+    // The dilation is fScale times the camera motion of the last frame, plus the minimums
+    void SetDilation( float fScale, float fMinDistance, float fMinAngle );
+
+    // Returns the visibility of each item (non zero if visible) for the frame's camera, and
+    // starts culling for the next frame. Valid until the next call.
+    const BYTE* BeginFrame( const VISIBILITY_CAMERA* pCamera );
+
+    // Drops the prediction and the motion, after a camera cut
+    void Invalidate();
+
+    void GetStats( VISIBILITY_STATS* pStats ) const { *pStats = m_Stats; }
+    void ResetStats();
+
+private:
+
+    struct PREDICTION
+    {
+        VISIBILITY_CAMERA   Camera;
+        float               fRadius;    // Eye distance covered
+        float               fAngle;     // View rotation covered
+    };
+
+    static DWORD WINAPI WorkerThread( LPVOID pParam );
+    UINT ComputeVisibility( const PREDICTION* pPrediction, BYTE* pVisible ) const;
+    void Predict( const VISIBILITY_CAMERA* pCamera, PREDICTION* pPrediction ) const;
+    static bool IsCovered( const PREDICTION* pPrediction, const VISIBILITY_CAMERA* pCamera );
+    void WaitForWorker();
+
+    std::vector<DirectX::XMFLOAT3>  m_BoundsMin;
+    std::vector<DirectX::XMFLOAT3>  m_BoundsMax;
+    std::vector<BYTE>               m_Visible[2];
+    UINT                            m_uFront;
+
+    bool                            m_bPipelined;
+    float                           m_fDilationScale;
+    float                           m_fMinDilationDistance;
+    float                           m_fMinDilationAngle;
+
+    // The camera of the last frame, for the motion
+    VISIBILITY_CAMERA               m_LastCamera;
+    bool                            m_bHaveLastCamera;
+
+    // Worker culling m_Visible[1 - m_uFront] for m_Prediction
+    HANDLE                          m_hThread;
+    HANDLE                          m_hStartEvent;
+    HANDLE                          m_hDoneEvent;
+    volatile bool                   m_bQuit;
+    bool                            m_bBusy;
+    bool                            m_bHavePrediction;
+    PREDICTION                      m_Prediction;
+    UINT                            m_uNumPredictedVisible;
+
+    VISIBILITY_STATS                m_Stats;
+};
+
+#endif
@@ -0,0 +1,380 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: WorldSpaceVertices.cpp
+//
+// World space copies of the vertex streams of a static mesh, transformed on the CPU.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "..\\..\\DXUT\\Optional\\SDKmesh.h"
+#include "WorldSpaceVertices.h"
+#include <emmintrin.h>
+
+using namespace DirectX;
+
+// What each task of a transform works on
+struct WORLD_TRANSFORM_CONTEXT
+{
+    const BYTE*             pSource;
+    BYTE*                   pDest;
+    UINT                    uStride;
+    UINT                    uNumVertices;
+    XMFLOAT4X4              f4x4World;
+    WORLD_TRANSFORM_PATH    Path;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Transforms vertices one at a time
+//--------------------------------------------------------------------------------------
+static void TransformVerticesScalar( const BYTE* pSource, BYTE* pDest, UINT uStride, UINT uNumVertices, CXMMATRIX mWorld )
+{
+    for( UINT i = 0; i < uNumVertices; i++ )
+    {
+        const BYTE* pVertex = pSource + (size_t)i * uStride;
+        BYTE* pOut = pDest + (size_t)i * uStride;
+
+        XMFLOAT3 f3Position, f3Normal;
+        memcpy( &f3Position, pVertex + VERTEX_POSITION_OFFSET, sizeof( XMFLOAT3 ) );
+        memcpy( &f3Normal, pVertex + VERTEX_NORMAL_OFFSET, sizeof( XMFLOAT3 ) );
+
+        XMStoreFloat3( &f3Position, XMVector3TransformNormal( XMLoadFloat3( &f3Position ), mWorld ) );
+        XMStoreFloat3( &f3Normal, XMVector3Normalize( XMVector3TransformNormal( XMLoadFloat3( &f3Normal ), mWorld ) ) );
+
+        memcpy( pOut + VERTEX_POSITION_OFFSET, &f3Position, sizeof( XMFLOAT3 ) );
+        memcpy( pOut + VERTEX_NORMAL_OFFSET, &f3Normal, sizeof( XMFLOAT3 ) );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Stores x, y and z without touching the float after them
+//--------------------------------------------------------------------------------------
+static inline void StoreFloat3( BYTE* pDest, __m128 v )
+{
+    _mm_storel_pi( (__m64*)pDest, v );
+    _mm_store_ss( (float*)( pDest + 8 ), _mm_movehl_ps( v, v ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Transforms 4 vertices at a time. Each position and normal is loaded with the float
+// after it (stride >= VERTEX_MIN_STRIDE), and the 4 are transposed so every lane works on
+// one vertex.
+//--------------------------------------------------------------------------------------
+static void TransformVerticesSSE( const BYTE* pSource, BYTE* pDest, UINT uStride, UINT uNumVertices, CXMMATRIX mWorld )
+{
+    XMFLOAT4X4 f4x4World;
+    XMStoreFloat4x4( &f4x4World, mWorld );
+
+    __m128 vM[3][3];
+    for( UINT r = 0; r < 3; r++ )
+    {
+        for( UINT c = 0; c < 3; c++ )
+        {
+            vM[r][c] = _mm_set1_ps( f4x4World.m[r][c] );
+        }
+    }
+
+    const __m128 vZero = _mm_setzero_ps();
+    const __m128 vOne = _mm_set1_ps( 1.0f );
+
+    UINT uNumBatched = uNumVertices & ~3u;
+    for( UINT i = 0; i < uNumBatched; i += 4 )
+    {
+        const BYTE* pVertex = pSource + (size_t)i * uStride;
+        BYTE* pOut = pDest + (size_t)i * uStride;
+
+        __m128 vX = _mm_loadu_ps( (const float*)( pVertex + VERTEX_POSITION_OFFSET ) );
+        __m128 vY = _mm_loadu_ps( (const float*)( pVertex + uStride + VERTEX_POSITION_OFFSET ) );
+        __m128 vZ = _mm_loadu_ps( (const float*)( pVertex + 2 * uStride + VERTEX_POSITION_OFFSET ) );
+        __m128 vW = _mm_loadu_ps( (const float*)( pVertex + 3 * uStride + VERTEX_POSITION_OFFSET ) );
+        _MM_TRANSPOSE4_PS( vX, vY, vZ, vW );
+
+        __m128 vNX = _mm_loadu_ps( (const float*)( pVertex + VERTEX_NORMAL_OFFSET ) );
+        __m128 vNY = _mm_loadu_ps( (const float*)( pVertex + uStride + VERTEX_NORMAL_OFFSET ) );
+        __m128 vNZ = _mm_loadu_ps( (const float*)( pVertex + 2 * uStride + VERTEX_NORMAL_OFFSET ) );
+        __m128 vNW = _mm_loadu_ps( (const float*)( pVertex + 3 * uStride + VERTEX_NORMAL_OFFSET ) );
+        _MM_TRANSPOSE4_PS( vNX, vNY, vNZ, vNW );
+
+        __m128 vOut[3], vNormal[3];
+        for( UINT c = 0; c < 3; c++ )
+        {
+            vOut[c] = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vZ, vM[2][c] ), _mm_mul_ps( vY, vM[1][c] ) ), _mm_mul_ps( vX, vM[0][c] ) );
+            vNormal[c] = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vNZ, vM[2][c] ), _mm_mul_ps( vNY, vM[1][c] ) ), _mm_mul_ps( vNX, vM[0][c] ) );
+        }
+
+        // Zero length normals stay zero, as XMVector3Normalize leaves them
+        __m128 vLengthSq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( vNormal[0], vNormal[0] ), _mm_mul_ps( vNormal[1], vNormal[1] ) ),
+                                       _mm_mul_ps( vNormal[2], vNormal[2] ) );
+        __m128 vScale = _mm_and_ps( _mm_div_ps( vOne, _mm_sqrt_ps( vLengthSq ) ), _mm_cmpgt_ps( vLengthSq, vZero ) );
+        for( UINT c = 0; c < 3; c++ )
+        {
+            vNormal[c] = _mm_mul_ps( vNormal[c], vScale );
+        }
+
+        vW = vZero;
+        _MM_TRANSPOSE4_PS( vOut[0], vOut[1], vOut[2], vW );
+        vNW = vZero;
+        _MM_TRANSPOSE4_PS( vNormal[0], vNormal[1], vNormal[2], vNW );
+
+        StoreFloat3( pOut + VERTEX_POSITION_OFFSET, vOut[0] );
+        StoreFloat3( pOut + uStride + VERTEX_POSITION_OFFSET, vOut[1] );
+        StoreFloat3( pOut + 2 * uStride + VERTEX_POSITION_OFFSET, vOut[2] );
+        StoreFloat3( pOut + 3 * uStride + VERTEX_POSITION_OFFSET, vW );
+        StoreFloat3( pOut + VERTEX_NORMAL_OFFSET, vNormal[0] );
+        StoreFloat3( pOut + uStride + VERTEX_NORMAL_OFFSET, vNormal[1] );
+        StoreFloat3( pOut + 2 * uStride + VERTEX_NORMAL_OFFSET, vNormal[2] );
+        StoreFloat3( pOut + 3 * uStride + VERTEX_NORMAL_OFFSET, vNW );
+    }
+
+    TransformVerticesScalar( pSource + (size_t)uNumBatched * uStride, pDest + (size_t)uNumBatched * uStride, uStride,
+                             uNumVertices - uNumBatched, mWorld );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Copies and transforms a range of vertices
+//--------------------------------------------------------------------------------------
+static void TransformVertexRange( const WORLD_TRANSFORM_CONTEXT* pContext, UINT uFirst, UINT uCount )
+{
+    const BYTE* pSource = pContext->pSource + (size_t)uFirst * pContext->uStride;
+    BYTE* pDest = pContext->pDest + (size_t)uFirst * pContext->uStride;
+
+    // The other attributes and any bytes after the layout are copied as they are
+    if( pSource != pDest )
+    {
+        memcpy( pDest, pSource, (size_t)uCount * pContext->uStride );
+    }
+
+    XMMATRIX mWorld = XMLoadFloat4x4( &pContext->f4x4World );
+    if( WORLD_TRANSFORM_SSE == pContext->Path )
+    {
+        TransformVerticesSSE( pSource, pDest, pContext->uStride, uCount, mWorld );
+    }
+    else
+    {
+        TransformVerticesScalar( pSource, pDest, pContext->uStride, uCount, mWorld );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Transforms one task's vertices
+//--------------------------------------------------------------------------------------
+static void TransformVerticesTask( void* pContext, UINT uTask, UINT uWorker )
+{
+    UNREFERENCED_PARAMETER( uWorker );
+
+    const WORLD_TRANSFORM_CONTEXT* pTransform = (const WORLD_TRANSFORM_CONTEXT*)pContext;
+    UINT uFirst = uTask * WORLD_SPACE_TASK_VERTICES;
+    TransformVertexRange( pTransform, uFirst, std::min( WORLD_SPACE_TASK_VERTICES, pTransform->uNumVertices - uFirst ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Copies the vertices and transforms them into world space
+//--------------------------------------------------------------------------------------
+void TransformVerticesToWorld( const BYTE* pSource, BYTE* pDest, UINT uStride, UINT uNumVertices, CXMMATRIX mWorld,
+                               WORLD_TRANSFORM_PATH Path, CNumaTaskPool* pPool )
+{
+    assert( NULL != pSource || 0 == uNumVertices );
+    assert( NULL != pDest || 0 == uNumVertices );
+    assert( uStride >= VERTEX_MIN_STRIDE );
+
+    WORLD_TRANSFORM_CONTEXT Context;
+    Context.pSource = pSource;
+    Context.pDest = pDest;
+    Context.uStride = uStride;
+    Context.uNumVertices = uNumVertices;
+    XMStoreFloat4x4( &Context.f4x4World, mWorld );
+    Context.Path = Path;
+
+    UINT uNumTasks = ( uNumVertices + WORLD_SPACE_TASK_VERTICES - 1 ) / WORLD_SPACE_TASK_VERTICES;
+    if( NULL != pPool && uNumTasks > 1 )
+    {
+        pPool->Run( TransformVerticesTask, &Context, uNumTasks, NULL, true );
+    }
+    else
+    {
+        TransformVertexRange( &Context, 0, uNumVertices );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Constructor
+//--------------------------------------------------------------------------------------
+CWorldSpaceVertices::CWorldSpaceVertices() :
+    m_bHaveWorld( false ),
+    m_uNumUpdates( 0 ),
+    m_fLastUpdateMs( 0.0 )
+{
+    XMStoreFloat4x4( &m_f4x4World, XMMatrixIdentity() );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Destructor
+//--------------------------------------------------------------------------------------
+CWorldSpaceVertices::~CWorldSpaceVertices()
+{
+    Destroy();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Creates a buffer per mesh like its first stream, holding the object space vertices
+// until the first update
+//--------------------------------------------------------------------------------------
+HRESULT CWorldSpaceVertices::Create( ID3D11Device* pd3dDevice, CDXUTSDKMesh* pDXUTMesh )
+{
+    assert( NULL != pd3dDevice );
+    assert( NULL != pDXUTMesh );
+
+    Destroy();
+
+    for( UINT uMesh = 0; uMesh < pDXUTMesh->GetNumMeshes(); uMesh++ )
+    {
+        SDKMESH_MESH* pMesh = pDXUTMesh->GetMesh( uMesh );
+
+        MESH_VERTICES Mesh;
+        Mesh.pSource = pDXUTMesh->GetRawVerticesAt( pMesh->VertexBuffers[0] );
+        Mesh.uStride = pDXUTMesh->GetVertexStride( uMesh, 0 );
+        Mesh.uNumVertices = (UINT)pDXUTMesh->GetNumVertices( uMesh, 0 );
+        Mesh.pWorld = NULL;
+        Mesh.pVB = NULL;
+        if( Mesh.uStride < VERTEX_MIN_STRIDE || 0 == Mesh.uNumVertices )
+        {
+            Destroy();
+            return E_INVALIDARG;
+        }
+
+        UINT uBytes = Mesh.uNumVertices * Mesh.uStride;
+        Mesh.pWorld = (BYTE*)_aligned_malloc( uBytes, 16 );
+        if( NULL == Mesh.pWorld )
+        {
+            Destroy();
+            return E_OUTOFMEMORY;
+        }
+        memcpy( Mesh.pWorld, Mesh.pSource, uBytes );
+
+        D3D11_BUFFER_DESC BufferDesc;
+        ZeroMemory( &BufferDesc, sizeof( BufferDesc ) );
+        BufferDesc.ByteWidth = uBytes;
+        BufferDesc.Usage = D3D11_USAGE_DEFAULT;
+        BufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+        D3D11_SUBRESOURCE_DATA InitData;
+        ZeroMemory( &InitData, sizeof( InitData ) );
+        InitData.pSysMem = Mesh.pWorld;
+
+        HRESULT hr = pd3dDevice->CreateBuffer( &BufferDesc, &InitData, &Mesh.pVB );
+        if( FAILED( hr ) )
+        {
+            _aligned_free( Mesh.pWorld );
+            Destroy();
+            return hr;
+        }
+
+        m_Meshes.push_back( Mesh );
+    }
+
+    m_bHaveWorld = false;
+    m_uNumUpdates = 0;
+    m_fLastUpdateMs = 0.0;
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Releases the buffers
+//--------------------------------------------------------------------------------------
+void CWorldSpaceVertices::Destroy()
+{
+    for( UINT i = 0; i < (UINT)m_Meshes.size(); i++ )
+    {
+        SAFE_RELEASE( m_Meshes[i].pVB );
+        _aligned_free( m_Meshes[i].pWorld );
+    }
+    m_Meshes.clear();
+
+    m_bHaveWorld = false;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Transforms the vertices again if the world matrix changed
+//--------------------------------------------------------------------------------------
+HRESULT CWorldSpaceVertices::Update( ID3D11DeviceContext* pd3dImmediateContext, CXMMATRIX mWorld, CNumaTaskPool* pPool )
+{
+    assert( NULL != pd3dImmediateContext );
+
+    XMFLOAT4X4 f4x4World;
+    XMStoreFloat4x4( &f4x4World, mWorld );
+    if( m_bHaveWorld && 0 == memcmp( &f4x4World, &m_f4x4World, sizeof( f4x4World ) ) )
+    {
+        return S_OK;
+    }
+
+    LARGE_INTEGER Start, End, Frequency;
+    QueryPerformanceCounter( &Start );
+
+    for( UINT i = 0; i < (UINT)m_Meshes.size(); i++ )
+    {
+        MESH_VERTICES* pMesh = &m_Meshes[i];
+        TransformVerticesToWorld( pMesh->pSource, pMesh->pWorld, pMesh->uStride, pMesh->uNumVertices, mWorld, WORLD_TRANSFORM_SSE, pPool );
+        pd3dImmediateContext->UpdateSubresource( pMesh->pVB, 0, NULL, pMesh->pWorld, 0, 0 );
+    }
+
+    QueryPerformanceCounter( &End );
+    QueryPerformanceFrequency( &Frequency );
+    m_fLastUpdateMs = (double)( End.QuadPart - Start.QuadPart ) * 1000.0 / (double)Frequency.QuadPart;
+
+    m_f4x4World = f4x4World;
+    m_bHaveWorld = true;
+    m_uNumUpdates++;
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the number of vertices of all the meshes
+//--------------------------------------------------------------------------------------
+UINT CWorldSpaceVertices::GetNumVertices() const
+{
+    UINT uNumVertices = 0;
+    for( UINT i = 0; i < (UINT)m_Meshes.size(); i++ )
+    {
+        uNumVertices += m_Meshes[i].uNumVertices;
+    }
+
+    return uNumVertices;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
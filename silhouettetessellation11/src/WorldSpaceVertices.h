@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: WorldSpaceVertices.h
+//
+// World space copies of the vertex streams of a static mesh. VS_RenderSceneWithTessellation
+// transforms every position and normal by the world matrix and normalizes the normal each
+// frame, although the matrix of a mesh never changes. With WORLD_SPACE_VB the vertex
+// shaders pass the vertices through, and these buffers are transformed again on the CPU
+// only when the world matrix changes.
+//--------------------------------------------------------------------------------------
+#ifndef WORLD_SPACE_VERTICES_H
+#define WORLD_SPACE_VERTICES_H
+
+#include "MeshData.h"
+#include "NumaTaskPool.h"
+
+// Vertex shader ALU instructions the pass through saves per vertex: the 3 dp3 of each
+// float3x3 transform, and the dp3, rsq and mul of the normalize
+static const UINT WORLD_SPACE_VS_ALU_SAVED = 9;
+
+// Vertices transformed per worker task
+static const UINT WORLD_SPACE_TASK_VERTICES = 4096;
+
+enum WORLD_TRANSFORM_PATH
+{
+    WORLD_TRANSFORM_SCALAR,
+    WORLD_TRANSFORM_SSE,        // 4 vertices at a time, transposed to structure of arrays
+};
+
+
+//--------------------------------------------------------------------------------------
+// Copies uNumVertices vertices of uStride bytes and transforms their positions and
+// normals into world space as VS_RenderSceneWithTessellation does: by the upper 3x3 of
+// mWorld (the world matrices of the sample have no translation), then normalizing the
+// normal. pSource and pDest may be the same. With a pool the vertices are split into
+// tasks of WORLD_SPACE_TASK_VERTICES over its workers.
+//--------------------------------------------------------------------------------------
+void TransformVerticesToWorld( const BYTE* pSource, BYTE* pDest, UINT uStride, UINT uNumVertices, DirectX::CXMMATRIX mWorld,
+                               WORLD_TRANSFORM_PATH Path, CNumaTaskPool* pPool );
+
+
+//--------------------------------------------------------------------------------------
+// World space vertex buffers replacing the first stream of each mesh of an sdkmesh
+//--------------------------------------------------------------------------------------
+class CWorldSpaceVertices
+{
+public:
+
+    CWorldSpaceVertices();
+    ~CWorldSpaceVertices();
+
+    // Creates a buffer per mesh like its first stream. The sdkmesh must outlive this.
+    HRESULT Create( ID3D11Device* pd3dDevice, CDXUTSDKMesh* pDXUTMesh );
+    void Destroy();
+
+    bool IsCreated() const { return !m_Meshes.empty(); }
+
+    // Transforms the vertices into the buffers if the world matrix changed since the last
+    // update. pPool may be NULL to transform on the calling thread.
+    HRESULT Update( ID3D11DeviceContext* pd3dImmediateContext, DirectX::CXMMATRIX mWorld, CNumaTaskPool* pPool );
+
+    ID3D11Buffer* GetVB( UINT uMesh ) const { return m_Meshes[uMesh].pVB; }
+    UINT GetNumVertices() const;
+    UINT GetNumUpdates() const { return m_uNumUpdates; }
+    double GetLastUpdateMs() const { return m_fLastUpdateMs; }
+
+private:
+
+    struct MESH_VERTICES
+    {
+        const BYTE*     pSource;        // In the sdkmesh
+        BYTE*           pWorld;
+        UINT            uStride;
+        UINT            uNumVertices;
+        ID3D11Buffer*   pVB;
+    };
+
+    std::vector<MESH_VERTICES>  m_Meshes;
+    DirectX::XMFLOAT4X4         m_f4x4World;
+    bool                        m_bHaveWorld;
+    UINT                        m_uNumUpdates;
+    double                      m_fLastUpdateMs;
+};
+
+#endif
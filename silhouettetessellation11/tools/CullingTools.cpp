@@ -0,0 +1,915 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: CullingTools.cpp
+//
+// Tools of the culling and the task pool: the NUMA aware pool, the occlusion buffer, the
+// visibility stage and the instance grid.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "HeadlessTools.h"
+#include "TessellationCache.h"
+#include "MeshPartition.h"
+#include "OcclusionBuffer.h"
+#include "VisibilityStage.h"
+#include "TessPath.h"
+#include "InstanceSet.h"
+
+using namespace DirectX;
+
+
+//--------------------------------------------------------------------------------------
+// Per worker scratch of the NUMA benchmark
+//--------------------------------------------------------------------------------------
+struct NUMA_BENCH_WORKER
+{
+    std::map<UINT, TRI_TESSELLATION>    Patterns;
+    std::vector<PN_VERTEX>              Vertices;
+};
+
+// Per partition totals, summed in partition order so every configuration gets the same
+struct NUMA_BENCH_RESULT
+{
+    UINT    uNumVisible;
+    UINT    uNumVertices;
+    double  fChecksum;
+};
+
+// What each task of the NUMA benchmark does with its partition
+struct NUMA_BENCH_CONTEXT
+{
+    const CMeshPartitions*          pPartitions;
+    bool                            bTessellate;    // Else only cull
+    XMFLOAT4                        f4Planes[6];
+    XMFLOAT3                        f3Eye;
+    float                           fMinDistance;
+    float                           fRange;
+    NUMA_BENCH_WORKER*              pWorkers;
+    NUMA_BENCH_RESULT*              pResults;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Culls a partition by its bounds and its triangles by facing, then tessellates the front
+// facing triangles with distance adaptive factors
+//--------------------------------------------------------------------------------------
+static void NumaBenchTask( void* pContext, UINT uTask, UINT uWorker )
+{
+    NUMA_BENCH_CONTEXT* pBench = (NUMA_BENCH_CONTEXT*)pContext;
+    const MESH_PARTITION* pPartition = pBench->pPartitions->GetPartition( uTask );
+    NUMA_BENCH_WORKER* pWorker = &pBench->pWorkers[uWorker];
+    NUMA_BENCH_RESULT* pResult = &pBench->pResults[uTask];
+
+    pResult->uNumVisible = 0;
+    pResult->uNumVertices = 0;
+    pResult->fChecksum = 0.0;
+
+    if( IsBoxOutsideFrustum( pBench->f4Planes, pPartition->f3BoundsMin, pPartition->f3BoundsMax ) )
+    {
+        return;
+    }
+
+    XMVECTOR vEye = XMLoadFloat3( &pBench->f3Eye );
+    for( UINT uTriangle = 0; uTriangle < pPartition->uNumIndices / 3; uTriangle++ )
+    {
+        PN_VERTEX Corners[3];
+        for( UINT c = 0; c < 3; c++ )
+        {
+            Corners[c] = pPartition->pVertices[pPartition->pIndices[uTriangle * 3 + c]];
+        }
+
+        XMVECTOR vPosition0 = XMLoadFloat3( &Corners[0].f3Position );
+        XMVECTOR vNormal = XMVector3Cross( XMVectorSubtract( XMLoadFloat3( &Corners[2].f3Position ), vPosition0 ),
+                                           XMVectorSubtract( XMLoadFloat3( &Corners[1].f3Position ), vPosition0 ) );
+        if( XMVectorGetX( XMVector3Dot( vNormal, XMVectorSubtract( vEye, vPosition0 ) ) ) <= 0.0f )
+        {
+            continue;
+        }
+
+        pResult->uNumVisible++;
+        if( !pBench->bTessellate )
+        {
+            pResult->fChecksum += Corners[0].f3Position.x + Corners[1].f3Position.y + Corners[2].f3Position.z;
+            continue;
+        }
+
+        float fEdgeFactors[3], fInsideFactor;
+        GetDistanceAdaptiveFactors( Corners, vEye, TESS_MAX_FACTOR, pBench->fMinDistance, pBench->fRange, fEdgeFactors, &fInsideFactor );
+
+        float fQuantizedEdgeFactors[3], fQuantizedInsideFactor;
+        UINT uKey = QuantizeTessFactors( fEdgeFactors, fInsideFactor, fQuantizedEdgeFactors, &fQuantizedInsideFactor );
+        if( 0 == uKey )
+        {
+            continue;
+        }
+
+        std::map<UINT, TRI_TESSELLATION>::iterator it = pWorker->Patterns.find( uKey );
+        if( it == pWorker->Patterns.end() )
+        {
+            it = pWorker->Patterns.insert( std::make_pair( uKey, TRI_TESSELLATION() ) ).first;
+            TessellateTri( fQuantizedEdgeFactors, fQuantizedInsideFactor, &it->second );
+        }
+
+        const TRI_TESSELLATION* pTessellation = &it->second;
+        UINT uNumVertices = (UINT)pTessellation->DomainPoints.size();
+        if( pWorker->Vertices.size() < uNumVertices )
+        {
+            pWorker->Vertices.resize( uNumVertices );
+        }
+
+        PN_CONTROL_POINTS ControlPoints;
+        ComputePNControlPoints( Corners, &ControlPoints );
+        EvaluatePatchVertices( CPU_TESS_PN_TRIANGLES, Corners, &ControlPoints, pTessellation, &pWorker->Vertices[0] );
+
+        pResult->uNumVertices += uNumVertices;
+        for( UINT i = 0; i < uNumVertices; i++ )
+        {
+            pResult->fChecksum += pWorker->Vertices[i].f3Position.x;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Measures culling and CPU tessellation of a large scene over 1 to N NUMA nodes, with the
+// mesh data on the first node and with the data partitioned over the nodes it is used on.
+// The scene is the largest bundled mesh repeated on a grid. On a single node machine only
+// the 1 node rows are measured.
+// Param: number of frames (default 8)
+//--------------------------------------------------------------------------------------
+HRESULT RunNumaTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT SCENE_TRIANGLES = 1 << 20;
+    static const UINT PARTITION_TRIANGLES = 1024;
+    static const WCHAR* PLACEMENT_NAMES[] = { L"node 0", L"node local" };
+    static const WCHAR* WORKLOAD_NAMES[] = { L"cull", L"tessellate" };
+
+    UINT uNumFrames = ( pszParam[0] != 0 ) ? (UINT)_wtoi( pszParam ) : 8;
+    uNumFrames = std::max( uNumFrames, 1u );
+
+    // Largest bundled mesh
+    MESH_DATA MeshData;
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA Candidate;
+        if( SUCCEEDED( LoadMeshData( g_pszBundledMeshes[uMesh], &Candidate ) ) && Candidate.Indices.size() > MeshData.Indices.size() )
+        {
+            MeshData.Vertices.swap( Candidate.Vertices );
+            MeshData.Indices.swap( Candidate.Indices );
+            MeshData.Subsets.swap( Candidate.Subsets );
+            MeshData.f3BoundsMin = Candidate.f3BoundsMin;
+            MeshData.f3BoundsMax = Candidate.f3BoundsMax;
+        }
+    }
+    if( MeshData.Indices.empty() )
+    {
+        HeadlessReport( L"No mesh could be loaded" );
+        return E_FAIL;
+    }
+
+    // Repeat it on a square grid
+    UINT uMeshTriangles = (UINT)MeshData.Indices.size() / 3;
+    UINT uNumCopies = ( SCENE_TRIANGLES + uMeshTriangles - 1 ) / uMeshTriangles;
+    float fDiagonal = GetMeshDataBoundsDiagonal( &MeshData );
+
+    MESH_DATA Scene;
+    BuildMeshGrid( &MeshData, uNumCopies, 1.25f * fDiagonal, &Scene );
+    XMVECTOR vSceneMin = XMLoadFloat3( &Scene.f3BoundsMin );
+    XMVECTOR vSceneMax = XMLoadFloat3( &Scene.f3BoundsMax );
+    float fSceneDiagonal = GetMeshDataBoundsDiagonal( &Scene );
+    XMVECTOR vSceneCenter = XMVectorScale( XMVectorAdd( vSceneMin, vSceneMax ), 0.5f );
+
+    std::vector<NUMA_NODE_INFO> Nodes;
+    GetNumaNodes( &Nodes );
+
+    HeadlessReport( L"%u frames, %u copies of a %u triangle mesh (%u triangles), %u triangles per partition, %u NUMA node(s)",
+                    uNumFrames, uNumCopies, uMeshTriangles, uNumCopies * uMeshTriangles, PARTITION_TRIANGLES, (UINT)Nodes.size() );
+    for( UINT uNode = 0; uNode < (UINT)Nodes.size(); uNode++ )
+    {
+        HeadlessReport( L"  node %u: %u processors in group %u", (UINT)Nodes[uNode].uNode, Nodes[uNode].uNumProcessors,
+                        (UINT)Nodes[uNode].Affinity.Group );
+    }
+    HeadlessReport( L"%-10s %5s %7s %-10s %10s %10s %8s %7s %7s %12s", L"Workload", L"Nodes", L"Workers", L"Placement",
+                    L"Visible", L"ms/frame", L"Speedup", L"Local%", L"Remote%", L"Vertices" );
+
+    for( UINT uWorkload = 0; uWorkload < ARRAYSIZE( WORKLOAD_NAMES ); uWorkload++ )
+    {
+        double fBaselineMs = 0.0;
+        double fReferenceChecksum = 0.0;
+        UINT64 uReferenceVisible = 0, uReferenceVertices = 0;
+
+        for( UINT uNumNodes = 1; uNumNodes <= (UINT)Nodes.size(); uNumNodes++ )
+        {
+            CNumaTaskPool Pool;
+            if( FAILED( Pool.Create( uNumNodes, 0 ) ) )
+            {
+                HeadlessReport( L"%-10s %5u failed to start the workers", WORKLOAD_NAMES[uWorkload], uNumNodes );
+                hr = E_FAIL;
+                continue;
+            }
+
+            for( UINT uPlacement = 0; uPlacement < ARRAYSIZE( PLACEMENT_NAMES ); uPlacement++ )
+            {
+                MESH_PARTITION_PLACEMENT Placement = ( 0 == uPlacement ) ? MESH_PARTITION_SINGLE_NODE : MESH_PARTITION_NODE_LOCAL;
+
+                CMeshPartitions Partitions;
+                if( FAILED( Partitions.Create( &Scene, PARTITION_TRIANGLES, &Pool, Placement ) ) )
+                {
+                    HeadlessReport( L"%-10s %5u %7u %-10s out of memory", WORKLOAD_NAMES[uWorkload], uNumNodes,
+                                    Pool.GetNumWorkers(), PLACEMENT_NAMES[uPlacement] );
+                    hr = E_FAIL;
+                    continue;
+                }
+
+                std::vector<NUMA_BENCH_WORKER> Workers( Pool.GetNumWorkers() );
+                std::vector<NUMA_BENCH_RESULT> Results( Partitions.GetNumPartitions() );
+
+                NUMA_BENCH_CONTEXT Bench;
+                Bench.pPartitions = &Partitions;
+                Bench.bTessellate = ( 1 == uWorkload );
+                Bench.fMinDistance = fDiagonal;
+                Bench.fRange = 0.5f * fSceneDiagonal;
+                Bench.pWorkers = &Workers[0];
+                Bench.pResults = &Results[0];
+
+                // Placing the data on the first node leaves the partition nodes as they are,
+                // so both placements run the tasks on the same workers
+                std::vector<UINT> TaskNodes( Partitions.GetNumPartitions() );
+                const UINT* puTaskNodes = Partitions.GetPartitionNodes();
+                if( MESH_PARTITION_SINGLE_NODE == Placement && uNumNodes > 1 )
+                {
+                    for( UINT i = 0; i < (UINT)TaskNodes.size(); i++ )
+                    {
+                        TaskNodes[i] = std::min( (UINT)( (UINT64)i * uNumNodes / TaskNodes.size() ), uNumNodes - 1 );
+                    }
+                    puTaskNodes = &TaskNodes[0];
+                }
+
+                UINT64 uVisible = 0, uNumVertices = 0, uLocal = 0, uRemote = 0;
+                double fChecksum = 0.0;
+                double fStart = GetTimeInMs();
+
+                for( UINT uFrame = 0; uFrame < uNumFrames; uFrame++ )
+                {
+                    // Orbit the scene from above
+                    float fAngle = XM_2PI * (float)uFrame / (float)uNumFrames;
+                    XMVECTOR vEye = XMVectorAdd( vSceneCenter, XMVectorSet( 0.4f * fSceneDiagonal * cosf( fAngle ), 0.25f * fSceneDiagonal,
+                                                                            0.4f * fSceneDiagonal * sinf( fAngle ), 0.0f ) );
+                    XMMATRIX mView = XMMatrixLookAtLH( vEye, vSceneCenter, XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f ) );
+                    XMMATRIX mProj = XMMatrixPerspectiveFovLH( XM_PI / 4.0f, 2560.0f / 1600.0f, 0.01f * fDiagonal, 2.0f * fSceneDiagonal );
+                    GetFrustumPlanes( XMMatrixMultiply( mView, mProj ), Bench.f4Planes );
+                    XMStoreFloat3( &Bench.f3Eye, vEye );
+
+                    Pool.Run( NumaBenchTask, &Bench, Partitions.GetNumPartitions(), puTaskNodes, true );
+
+                    NUMA_TASK_STATS Stats;
+                    Pool.GetStats( &Stats );
+                    uLocal += Stats.uNumLocal;
+                    uRemote += Stats.uNumRemote;
+
+                    for( UINT i = 0; i < (UINT)Results.size(); i++ )
+                    {
+                        uVisible += Results[i].uNumVisible;
+                        uNumVertices += Results[i].uNumVertices;
+                        fChecksum += Results[i].fChecksum;
+                    }
+                }
+
+                double fMsPerFrame = ( GetTimeInMs() - fStart ) / uNumFrames;
+                if( 1 == uNumNodes && 0 == uPlacement )
+                {
+                    fBaselineMs = fMsPerFrame;
+                    fReferenceChecksum = fChecksum;
+                    uReferenceVisible = uVisible;
+                    uReferenceVertices = uNumVertices;
+                }
+
+                double fTasks = (double)std::max( uLocal + uRemote, (UINT64)1 );
+                HeadlessReport( L"%-10s %5u %7u %-10s %10.0f %10.3f %7.2fx %6.1f%% %6.1f%% %12.0f", WORKLOAD_NAMES[uWorkload], uNumNodes,
+                                Pool.GetNumWorkers(), PLACEMENT_NAMES[uPlacement], (double)uVisible / uNumFrames, fMsPerFrame,
+                                fBaselineMs / std::max( fMsPerFrame, 1.0e-6 ), 100.0 * (double)uLocal / fTasks,
+                                100.0 * (double)uRemote / fTasks, (double)uNumVertices / uNumFrames );
+
+                // Every configuration must do the same work
+                if( uVisible != uReferenceVisible || uNumVertices != uReferenceVertices || fChecksum != fReferenceChecksum )
+                {
+                    HeadlessReport( L"  results differ from 1 node, node 0" );
+                    hr = E_FAIL;
+                }
+            }
+        }
+    }
+
+    return hr;
+}
+
+// A code path of the occlusion benchmark
+struct OCCLUSION_BENCH_CONFIG
+{
+    OCCLUSION_SIMD      SIMD;
+    bool                bAllWorkers;    // Else on the calling thread
+    COcclusionBuffer    Buffer;
+    double              fRasterMs;
+    double              fTestMs;
+    UINT64              uNumCulled;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Rasterizes the triangles of the given clusters into a buffer on the calling thread
+//--------------------------------------------------------------------------------------
+static void RasterizeClusters( COcclusionBuffer* pBuffer, CXMMATRIX mViewProj, const CMeshPartitions* pClusters,
+                               const std::vector<UINT>& ClusterList )
+{
+    pBuffer->Begin( mViewProj );
+    for( UINT i = 0; i < (UINT)ClusterList.size(); i++ )
+    {
+        const MESH_PARTITION* pCluster = pClusters->GetPartition( ClusterList[i] );
+        pBuffer->AddOccluder( &pCluster->pVertices[0].f3Position, sizeof( PN_VERTEX ), pCluster->pIndices, pCluster->uNumIndices / 3 );
+    }
+    pBuffer->Rasterize( NULL );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Measures occlusion culling of patch clusters with the software depth buffer, on a field
+// of copies of each bundled mesh seen from the side. The clusters closest to the camera
+// relative to their size are the occluders, up to a triangle budget, and every cluster in
+// the frustum is tested against them. The SIMD paths must write the same depths as the
+// scalar path, and no pixel of a culled cluster may be in front of the clusters kept.
+// Param: width of the buffer (default 320), the height is for a 16:10 view
+//--------------------------------------------------------------------------------------
+HRESULT RunOcclusionTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT NUM_FRAMES = 16;
+    static const UINT FIELD_COPIES = 64;
+    static const UINT CLUSTER_TRIANGLES = 64;
+    static const UINT OCCLUDER_TRIANGLES = 16384;
+    static const float IMAGE_ERROR_EPSILON = 1.0e-5f;
+    static const WCHAR* SIMD_NAMES[] = { L"scalar", L"SSE", L"AVX" };
+
+    UINT uWidth = ( pszParam[0] != 0 ) ? (UINT)_wtoi( pszParam ) : 320;
+    uWidth = std::max( uWidth, OCCLUSION_TILE_SIZE );
+    UINT uHeight = std::max( uWidth * 10 / 16, OCCLUSION_TILE_SIZE );
+
+    CNumaTaskPool Pool;
+    if( FAILED( Pool.Create( 0, 0 ) ) )
+    {
+        HeadlessReport( L"Failed to start the workers" );
+        return E_FAIL;
+    }
+
+    // Every path up to the best, and the best on all the workers
+    OCCLUSION_SIMD BestSIMD = GetBestOcclusionSIMD();
+    UINT uNumConfigs = (UINT)BestSIMD + 2;
+    OCCLUSION_BENCH_CONFIG Configs[OCCLUSION_SIMD_AVX + 2];
+    for( UINT uConfig = 0; uConfig < uNumConfigs; uConfig++ )
+    {
+        Configs[uConfig].SIMD = ( uConfig + 1 < uNumConfigs ) ? (OCCLUSION_SIMD)uConfig : BestSIMD;
+        Configs[uConfig].bAllWorkers = ( uConfig + 1 == uNumConfigs );
+        V_RETURN( Configs[uConfig].Buffer.Create( uWidth, uHeight ) );
+        Configs[uConfig].Buffer.SetSIMD( Configs[uConfig].SIMD );
+    }
+
+    COcclusionBuffer KeptBuffer, CulledBuffer;
+    V_RETURN( KeptBuffer.Create( uWidth, uHeight ) );
+    V_RETURN( CulledBuffer.Create( uWidth, uHeight ) );
+
+    HeadlessReport( L"%u frames, %ux%u buffer, %u copies per field, %u triangle clusters, occluders up to %u triangles, %u workers",
+                    NUM_FRAMES, Configs[0].Buffer.GetWidth(), Configs[0].Buffer.GetHeight(), FIELD_COPIES, CLUSTER_TRIANGLES,
+                    OCCLUDER_TRIANGLES, Pool.GetNumWorkers() );
+    HeadlessReport( L"%-32s %-7s %7s %9s %10s %8s %9s %10s %9s %9s %8s", L"Mesh", L"Path", L"Workers", L"Frustum", L"Occluders",
+                    L"Culled%", L"Patches%", L"Raster ms", L"Test ms", L"Total ms", L"Speedup" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        float fDiagonal = GetMeshDataBoundsDiagonal( &MeshData );
+        MESH_DATA Field;
+        BuildMeshGrid( &MeshData, FIELD_COPIES, 1.1f * fDiagonal, &Field );
+
+        CMeshPartitions Clusters;
+        if( FAILED( Clusters.Create( &Field, CLUSTER_TRIANGLES, &Pool, MESH_PARTITION_SINGLE_NODE ) ) )
+        {
+            HeadlessReport( L"%-32s out of memory", g_pszBundledMeshes[uMesh] );
+            hr = E_FAIL;
+            continue;
+        }
+
+        XMVECTOR vFieldMin = XMLoadFloat3( &Field.f3BoundsMin );
+        XMVECTOR vFieldMax = XMLoadFloat3( &Field.f3BoundsMax );
+        XMVECTOR vFieldCenter = XMVectorScale( XMVectorAdd( vFieldMin, vFieldMax ), 0.5f );
+        float fFieldDiagonal = GetMeshDataBoundsDiagonal( &Field );
+
+        for( UINT uConfig = 0; uConfig < uNumConfigs; uConfig++ )
+        {
+            Configs[uConfig].fRasterMs = Configs[uConfig].fTestMs = 0.0;
+            Configs[uConfig].uNumCulled = 0;
+        }
+
+        UINT64 uNumInFrustum = 0, uNumOccluderTriangles = 0, uNumPatches = 0, uNumCulledPatches = 0;
+        UINT uNumMismatches = 0, uNumErrorPixels = 0;
+        std::vector<UINT> InFrustum, Occluders, Kept, Culled;
+        std::vector< std::pair<float, UINT> > Candidates;
+
+        for( UINT uFrame = 0; uFrame < NUM_FRAMES; uFrame++ )
+        {
+            // Circle the field from just above the meshes, looking across it
+            float fAngle = XM_2PI * (float)uFrame / (float)NUM_FRAMES;
+            XMVECTOR vEye = XMVectorAdd( vFieldCenter, XMVectorSet( 0.6f * fFieldDiagonal * cosf( fAngle ), 0.0f,
+                                                                    0.6f * fFieldDiagonal * sinf( fAngle ), 0.0f ) );
+            XMMATRIX mView = XMMatrixLookAtLH( vEye, vFieldCenter, XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f ) );
+            XMMATRIX mProj = XMMatrixPerspectiveFovLH( XM_PI / 4.0f, (float)uWidth / (float)uHeight, 0.01f * fDiagonal, 2.0f * fFieldDiagonal );
+            XMMATRIX mViewProj = XMMatrixMultiply( mView, mProj );
+
+            XMFLOAT4 f4Planes[6];
+            GetFrustumPlanes( mViewProj, f4Planes );
+
+            // Rank the clusters in the frustum by size over distance
+            InFrustum.clear();
+            Candidates.clear();
+            for( UINT uCluster = 0; uCluster < Clusters.GetNumPartitions(); uCluster++ )
+            {
+                const MESH_PARTITION* pCluster = Clusters.GetPartition( uCluster );
+                if( IsBoxOutsideFrustum( f4Planes, pCluster->f3BoundsMin, pCluster->f3BoundsMax ) )
+                {
+                    continue;
+                }
+
+                XMVECTOR vMin = XMLoadFloat3( &pCluster->f3BoundsMin );
+                XMVECTOR vMax = XMLoadFloat3( &pCluster->f3BoundsMax );
+                float fSize = XMVectorGetX( XMVector3Length( XMVectorSubtract( vMax, vMin ) ) );
+                float fDistance = XMVectorGetX( XMVector3Length( XMVectorSubtract( XMVectorScale( XMVectorAdd( vMin, vMax ), 0.5f ), vEye ) ) );
+                Candidates.push_back( std::make_pair( -fSize / std::max( fDistance, 1.0e-6f ), uCluster ) );
+                InFrustum.push_back( uCluster );
+                uNumPatches += pCluster->uNumIndices / 3;
+            }
+            std::sort( Candidates.begin(), Candidates.end() );
+            uNumInFrustum += InFrustum.size();
+
+            for( UINT uConfig = 0; uConfig < uNumConfigs; uConfig++ )
+            {
+                OCCLUSION_BENCH_CONFIG* pConfig = &Configs[uConfig];
+                double fStart = GetTimeInMs();
+
+                // Occluder selection is part of the cost
+                Occluders.clear();
+                UINT uOccluderTriangles = 0;
+                for( UINT i = 0; i < (UINT)Candidates.size() && uOccluderTriangles < OCCLUDER_TRIANGLES; i++ )
+                {
+                    Occluders.push_back( Candidates[i].second );
+                    uOccluderTriangles += Clusters.GetPartition( Candidates[i].second )->uNumIndices / 3;
+                }
+
+                pConfig->Buffer.Begin( mViewProj );
+                for( UINT i = 0; i < (UINT)Occluders.size(); i++ )
+                {
+                    const MESH_PARTITION* pCluster = Clusters.GetPartition( Occluders[i] );
+                    pConfig->Buffer.AddOccluder( &pCluster->pVertices[0].f3Position, sizeof( PN_VERTEX ), pCluster->pIndices,
+                                                 pCluster->uNumIndices / 3 );
+                }
+                pConfig->Buffer.Rasterize( pConfig->bAllWorkers ? &Pool : NULL );
+
+                double fRasterEnd = GetTimeInMs();
+
+                Kept.clear();
+                Culled.clear();
+                for( UINT i = 0; i < (UINT)InFrustum.size(); i++ )
+                {
+                    const MESH_PARTITION* pCluster = Clusters.GetPartition( InFrustum[i] );
+                    if( pConfig->Buffer.IsBoxVisible( pCluster->f3BoundsMin, pCluster->f3BoundsMax ) )
+                    {
+                        Kept.push_back( InFrustum[i] );
+                    }
+                    else
+                    {
+                        Culled.push_back( InFrustum[i] );
+                    }
+                }
+
+                pConfig->fRasterMs += fRasterEnd - fStart;
+                pConfig->fTestMs += GetTimeInMs() - fRasterEnd;
+                pConfig->uNumCulled += Culled.size();
+
+                if( 0 != uConfig )
+                {
+                    // Same depths as the scalar path
+                    const float* pfDepth = pConfig->Buffer.GetDepth();
+                    const float* pfReference = Configs[0].Buffer.GetDepth();
+                    for( UINT i = 0; i < pConfig->Buffer.GetPitch() * pConfig->Buffer.GetHeight(); i++ )
+                    {
+                        if( pfDepth[i] != pfReference[i] )
+                        {
+                            uNumMismatches++;
+                        }
+                    }
+                    continue;
+                }
+
+                uNumOccluderTriangles += uOccluderTriangles;
+                for( UINT i = 0; i < (UINT)Culled.size(); i++ )
+                {
+                    uNumCulledPatches += Clusters.GetPartition( Culled[i] )->uNumIndices / 3;
+                }
+
+                // The culled clusters must be behind the kept ones wherever both cover a pixel
+                RasterizeClusters( &KeptBuffer, mViewProj, &Clusters, Kept );
+                RasterizeClusters( &CulledBuffer, mViewProj, &Clusters, Culled );
+                const float* pfKept = KeptBuffer.GetDepth();
+                const float* pfCulled = CulledBuffer.GetDepth();
+                for( UINT i = 0; i < KeptBuffer.GetPitch() * KeptBuffer.GetHeight(); i++ )
+                {
+                    if( pfCulled[i] < pfKept[i] - IMAGE_ERROR_EPSILON )
+                    {
+                        uNumErrorPixels++;
+                    }
+                }
+            }
+        }
+
+        double fScalarMs = ( Configs[0].fRasterMs + Configs[0].fTestMs ) / NUM_FRAMES;
+        for( UINT uConfig = 0; uConfig < uNumConfigs; uConfig++ )
+        {
+            const OCCLUSION_BENCH_CONFIG* pConfig = &Configs[uConfig];
+            double fTotalMs = ( pConfig->fRasterMs + pConfig->fTestMs ) / NUM_FRAMES;
+            HeadlessReport( L"%-32s %-7s %7u %9.1f %10.0f %7.1f%% %8.1f%% %10.3f %9.3f %9.3f %7.2fx", g_pszBundledMeshes[uMesh],
+                            SIMD_NAMES[pConfig->SIMD], pConfig->bAllWorkers ? Pool.GetNumWorkers() : 1,
+                            (double)uNumInFrustum / NUM_FRAMES, (double)uNumOccluderTriangles / NUM_FRAMES,
+                            100.0 * (double)pConfig->uNumCulled / (double)std::max( uNumInFrustum, (UINT64)1 ),
+                            100.0 * (double)uNumCulledPatches / (double)std::max( uNumPatches, (UINT64)1 ),
+                            pConfig->fRasterMs / NUM_FRAMES, pConfig->fTestMs / NUM_FRAMES, fTotalMs,
+                            fScalarMs / std::max( fTotalMs, 1.0e-6 ) );
+        }
+
+        if( 0 != uNumMismatches || 0 != uNumErrorPixels )
+        {
+            HeadlessReport( L"%-32s %u depths differ from the scalar path, %u pixels of culled clusters in front",
+                            g_pszBundledMeshes[uMesh], uNumMismatches, uNumErrorPixels );
+            hr = E_FAIL;
+        }
+    }
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+// Builds the visibility camera and the view projection of a camera looking along vAhead
+//--------------------------------------------------------------------------------------
+static void GetVisibilityCamera( FXMVECTOR vEye, FXMVECTOR vAhead, float fFOV, float fAspect, float fNearClip, float fFarClip,
+                                 VISIBILITY_CAMERA* pCamera, XMMATRIX* pViewProj )
+{
+    XMVECTOR vRight = XMVector3Normalize( XMVector3Cross( XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f ), vAhead ) );
+    XMVECTOR vUp = XMVector3Cross( vAhead, vRight );
+
+    XMStoreFloat3( &pCamera->f3Eye, vEye );
+    XMStoreFloat3( &pCamera->f3Right, vRight );
+    XMStoreFloat3( &pCamera->f3Up, vUp );
+    XMStoreFloat3( &pCamera->f3Ahead, vAhead );
+    pCamera->fFOV = fFOV;
+    pCamera->fAspect = fAspect;
+
+    *pViewProj = XMMatrixMultiply( XMMatrixLookToLH( vEye, vAhead, vUp ), XMMatrixPerspectiveFovLH( fFOV, fAspect, fNearClip, fFarClip ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// -visibility[:frames]
+// Walks a camera through a field of each mesh, turning and changing speed, with sudden
+// turns now and then. Each frame runs the visibility stage pipelined and synchronously,
+// then spends the submission time. Reports how often the prediction held and had to be
+// corrected, the time the render thread spent on visibility, the extra items drawn for
+// the dilation, and checks that no item in the frustum of the actual camera was culled.
+//--------------------------------------------------------------------------------------
+HRESULT RunVisibilityTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT FIELD_COPIES = 256;
+    static const UINT ITEM_TRIANGLES = 64;
+    static const double SUBMIT_MS = 2.0;
+    static const UINT TURN_INTERVAL = 97;
+    static const float TURN_ANGLE = 0.35f;
+
+    UINT uNumFrames = ( pszParam[0] != 0 ) ? (UINT)_wtoi( pszParam ) : 600;
+    uNumFrames = std::max( uNumFrames, 2u );
+
+    HeadlessReport( L"%u frames, %u copies per field, %u triangle items, %.1f ms submission per frame", uNumFrames, FIELD_COPIES,
+                    ITEM_TRIANGLES, SUBMIT_MS );
+    HeadlessReport( L"%-32s %7s %8s %10s %10s %7s %7s %8s %10s %10s %9s %7s", L"Mesh", L"Items", L"Visible", L"Predicted%",
+                    L"Corrected%", L"Sync%", L"Stalls", L"Dilated%", L"Sync ms", L"Piped ms", L"Saved ms", L"Missed" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        float fDiagonal = GetMeshDataBoundsDiagonal( &MeshData );
+        MESH_DATA Field;
+        BuildMeshGrid( &MeshData, FIELD_COPIES, 1.1f * fDiagonal, &Field );
+
+        std::vector<VISIBILITY_ITEM> Items;
+        BuildVisibilityItems( &Field, ITEM_TRIANGLES, XMMatrixIdentity(), &Items );
+
+        CVisibilityStage Pipelined, Synchronous;
+        if( FAILED( Pipelined.Create( &Items[0], (UINT)Items.size() ) ) || FAILED( Synchronous.Create( &Items[0], (UINT)Items.size() ) ) )
+        {
+            HeadlessReport( L"%-32s failed to start the visibility stage", g_pszBundledMeshes[uMesh] );
+            hr = E_FAIL;
+            continue;
+        }
+        Synchronous.SetPipelined( false );
+
+        XMFLOAT3 f3Min = Field.f3BoundsMin;
+        XMFLOAT3 f3Max = Field.f3BoundsMax;
+        float fFieldDiagonal = GetMeshDataBoundsDiagonal( &Field );
+        float fEyeHeight = f3Max.y + 0.25f * fDiagonal;
+        float fBaseSpeed = 0.02f * fDiagonal;
+        XMFLOAT3 f3Eye( f3Min.x, fEyeHeight, f3Min.z );
+        float fYaw = XM_PIDIV4;
+
+        UINT64 uNumExactVisible = 0, uNumDrawn = 0;
+        UINT uNumMissed = 0;
+        for( UINT uFrame = 0; uFrame < uNumFrames; uFrame++ )
+        {
+            // Smooth turns and speed changes, with a sudden turn every so often, bouncing off
+            // the edges of the field
+            float fSpeed = fBaseSpeed * ( 1.0f + 0.5f * sinf( 0.05f * (float)uFrame ) );
+            fYaw += 0.02f * sinf( 0.013f * (float)uFrame );
+            if( 0 == ( uFrame + 1 ) % TURN_INTERVAL )
+            {
+                fYaw += TURN_ANGLE;
+            }
+
+            f3Eye.x += fSpeed * cosf( fYaw );
+            f3Eye.z += fSpeed * sinf( fYaw );
+            if( f3Eye.x < f3Min.x || f3Eye.x > f3Max.x )
+            {
+                fYaw = XM_PI - fYaw;
+                f3Eye.x = std::min( std::max( f3Eye.x, f3Min.x ), f3Max.x );
+            }
+            if( f3Eye.z < f3Min.z || f3Eye.z > f3Max.z )
+            {
+                fYaw = -fYaw;
+                f3Eye.z = std::min( std::max( f3Eye.z, f3Min.z ), f3Max.z );
+            }
+
+            float fPitch = -0.2f + 0.1f * sinf( 0.021f * (float)uFrame );
+            XMVECTOR vAhead = XMVectorSet( cosf( fYaw ) * cosf( fPitch ), sinf( fPitch ), sinf( fYaw ) * cosf( fPitch ), 0.0f );
+
+            VISIBILITY_CAMERA Camera;
+            XMMATRIX mViewProj;
+            GetVisibilityCamera( XMLoadFloat3( &f3Eye ), vAhead, XM_PI / 4.0f, 16.0f / 10.0f, 0.01f * fDiagonal, 2.0f * fFieldDiagonal,
+                                 &Camera, &mViewProj );
+
+            const BYTE* pVisible = Pipelined.BeginFrame( &Camera );
+            const BYTE* pExact = Synchronous.BeginFrame( &Camera );
+
+            // Every item in the frustum of the actual camera must be drawn
+            XMFLOAT4 f4Planes[6];
+            GetFrustumPlanes( mViewProj, f4Planes );
+            for( UINT i = 0; i < (UINT)Items.size(); i++ )
+            {
+                if( 0 == pVisible[i] && !IsBoxOutsideFrustum( f4Planes, Items[i].f3BoundsMin, Items[i].f3BoundsMax ) )
+                {
+                    uNumMissed++;
+                }
+                uNumDrawn += ( 0 != pVisible[i] ) ? 1 : 0;
+                uNumExactVisible += ( 0 != pExact[i] ) ? 1 : 0;
+            }
+
+            // The worker culls the next frame meanwhile
+            double fSubmitStart = GetTimeInMs();
+            while( GetTimeInMs() - fSubmitStart < SUBMIT_MS )
+            {
+                YieldProcessor();
+            }
+        }
+
+        VISIBILITY_STATS PipelinedStats, SynchronousStats;
+        Pipelined.GetStats( &PipelinedStats );
+        Synchronous.GetStats( &SynchronousStats );
+
+        double fSyncMs = SynchronousStats.fRenderThreadMs / uNumFrames;
+        double fPipedMs = PipelinedStats.fRenderThreadMs / uNumFrames;
+        HeadlessReport( L"%-32s %7u %8.1f %9.1f%% %9.1f%% %6.1f%% %7u %7.1f%% %10.4f %10.4f %9.4f %7u", g_pszBundledMeshes[uMesh],
+                        (UINT)Items.size(), (double)uNumExactVisible / uNumFrames,
+                        100.0 * PipelinedStats.uNumPredicted / uNumFrames, 100.0 * PipelinedStats.uNumCorrected / uNumFrames,
+                        100.0 * PipelinedStats.uNumSynchronous / uNumFrames, PipelinedStats.uNumStalls,
+                        100.0 * ( (double)uNumDrawn / (double)std::max( uNumExactVisible, (UINT64)1 ) - 1.0 ),
+                        fSyncMs, fPipedMs, fSyncMs - fPipedMs, uNumMissed );
+
+        if( 0 != uNumMissed )
+        {
+            HeadlessReport( L"%-32s %u items in the frustum were culled", g_pszBundledMeshes[uMesh], uNumMissed );
+            hr = E_FAIL;
+        }
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Measures CInstanceSet::CullAndBin on fields of 10k to 1M instances, seen from views
+// around the middle of the field, with each code path up to the best. Reports the visible
+// instances of each bin, the time per view and per instance, and the time to write the
+// world matrices of the visible instances in binned order, as the sample uploads them.
+// The SIMD paths must bin every instance as the scalar path does, and no instance with
+// its center on screen may be culled.
+// Param: the most instances (default 1048576)
+//--------------------------------------------------------------------------------------
+HRESULT RunInstancesTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT NUM_VIEWS = 16;
+    static const float EYE_HEIGHT = 4.0f;
+    static const WCHAR* SIMD_NAMES[] = { L"scalar", L"SSE", L"AVX" };
+
+    UINT uMaxInstances = ( 0 != pszParam[0] ) ? (UINT)_wtoi( pszParam ) : 1048576;
+    if( 0 == uMaxInstances )
+    {
+        HeadlessReport( L"Expected a number of instances, got %s", pszParam );
+        return E_INVALIDARG;
+    }
+
+    INSTANCE_BIN_SETTINGS Settings;
+    Settings.fFullDiameter = INSTANCE_FULL_DIAMETER;
+    Settings.fMinDiameter = TESS_PATH_MIN_DIAMETER;
+    Settings.uNumTessTiers = INSTANCE_NUM_TESS_TIERS;
+    Settings.fMaxTessFactor = 16.0f;
+
+    XMMATRIX mProj = XMMatrixPerspectiveFovLH( XM_PI / 4.0f, (float)ORBIT_SCREEN_WIDTH / (float)ORBIT_SCREEN_HEIGHT, 0.1f, 10000.0f );
+    OCCLUSION_SIMD BestSIMD = GetBestOcclusionSIMD();
+
+    HeadlessReport( L"%u views, %ux%u, %u tess tiers from %.0f pixels, no tessellation under %.0f pixels", NUM_VIEWS, ORBIT_SCREEN_WIDTH,
+                    ORBIT_SCREEN_HEIGHT, Settings.uNumTessTiers, Settings.fFullDiameter, Settings.fMinDiameter );
+    HeadlessReport( L"%9s %-7s %9s %-28s %10s %9s %9s %8s %9s", L"Instances", L"Path", L"Visible", L"Per bin", L"ms/view", L"ns/inst",
+                    L"Minst/s", L"Speedup", L"Write ms" );
+
+    for( UINT uNumInstances = 10000; uNumInstances <= uMaxInstances; uNumInstances *= 10 )
+    {
+        // Unit boxes scaled by 0.5 to 2 and turned about y, over a square field with the
+        // spacing of the instance grid on average
+        float fSpacing = INSTANCE_GRID_SPACING * 2.0f * sqrtf( 3.0f );
+        float fFieldSize = sqrtf( (float)uNumInstances ) * fSpacing;
+        CInstanceSet Instances;
+        Instances.Init( XMVectorZero(), XMVectorSplatOne() );
+        std::vector<XMFLOAT3> Centers( uNumInstances );
+        UINT uRandom = 12345;
+        for( UINT uInstance = 0; uInstance < uNumInstances; uInstance++ )
+        {
+            float fRandom[4];
+            for( UINT i = 0; i < 4; i++ )
+            {
+                uRandom = uRandom * 1664525 + 1013904223;
+                fRandom[i] = (float)( uRandom >> 8 ) / 16777216.0f;
+            }
+            float fScale = 0.5f + 1.5f * fRandom[0];
+            Centers[uInstance] = XMFLOAT3( fFieldSize * fRandom[2], 0.0f, fFieldSize * fRandom[3] );
+            Instances.AddInstance( XMMatrixScaling( fScale, fScale, fScale ) * XMMatrixRotationY( XM_2PI * fRandom[1] ) *
+                                   XMMatrixTranslation( Centers[uInstance].x, Centers[uInstance].y, Centers[uInstance].z ) );
+        }
+
+        // Views from the middle of the field, looking down a little
+        XMMATRIX mViews[NUM_VIEWS];
+        for( UINT uView = 0; uView < NUM_VIEWS; uView++ )
+        {
+            float fAngle = XM_2PI * (float)uView / (float)NUM_VIEWS;
+            XMVECTOR vEye = XMVectorSet( 0.5f * fFieldSize, EYE_HEIGHT, 0.5f * fFieldSize, 1.0f );
+            XMVECTOR vAt = XMVectorAdd( vEye, XMVectorSet( cosf( fAngle ), -0.2f, sinf( fAngle ), 0.0f ) );
+            mViews[uView] = XMMatrixLookAtLH( vEye, vAt, XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f ) );
+        }
+
+        std::vector< std::vector<UINT> > ReferenceBinned( NUM_VIEWS );
+        std::vector<INSTANCE_BINS> ReferenceBins( NUM_VIEWS );
+        std::vector<XMFLOAT4X4> WorldMatrices( uNumInstances );
+        double fScalarMs = 0.0;
+        for( UINT uSIMD = 0; uSIMD <= (UINT)BestSIMD; uSIMD++ )
+        {
+            Instances.SetSIMD( (OCCLUSION_SIMD)uSIMD );
+
+            double fCullMs = 0.0, fWriteMs = 0.0;
+            UINT64 uNumVisible = 0;
+            UINT64 uBinCounts[INSTANCE_MAX_BINS] = { 0 };
+            UINT uNumMismatches = 0, uNumOnScreenCulled = 0;
+            INSTANCE_BINS Bins;
+            for( UINT uView = 0; uView < NUM_VIEWS; uView++ )
+            {
+                double fStart = GetTimeInMs();
+                Instances.CullAndBin( mViews[uView], mProj, (float)ORBIT_SCREEN_HEIGHT, 0.0f, &Settings, &Bins );
+                double fCullEnd = GetTimeInMs();
+                Instances.WriteWorldMatrices( WorldMatrices.empty() ? NULL : &WorldMatrices[0] );
+                fWriteMs += GetTimeInMs() - fCullEnd;
+                fCullMs += fCullEnd - fStart;
+
+                uNumVisible += Bins.uNumVisible;
+                for( UINT uBin = 0; uBin < Bins.uNumBins; uBin++ )
+                {
+                    uBinCounts[uBin] += Bins.uCount[uBin];
+                }
+
+                const UINT* puBinned = Instances.GetBinnedInstances();
+                if( 0 == uSIMD )
+                {
+                    ReferenceBins[uView] = Bins;
+                    ReferenceBinned[uView].assign( puBinned, puBinned + Bins.uNumVisible );
+
+                    // Every instance with its center on screen is visible
+                    XMMATRIX mViewProj = XMMatrixMultiply( mViews[uView], mProj );
+                    std::vector<bool> Visible( uNumInstances, false );
+                    for( UINT i = 0; i < Bins.uNumVisible; i++ )
+                    {
+                        Visible[puBinned[i]] = true;
+                    }
+                    for( UINT uInstance = 0; uInstance < uNumInstances; uInstance++ )
+                    {
+                        XMFLOAT4 f4Clip;
+                        XMStoreFloat4( &f4Clip, XMVector3Transform( XMLoadFloat3( &Centers[uInstance] ), mViewProj ) );
+                        bool bOnScreen = f4Clip.w > 0.0f && fabsf( f4Clip.x ) <= f4Clip.w && fabsf( f4Clip.y ) <= f4Clip.w &&
+                                         f4Clip.z >= 0.0f && f4Clip.z <= f4Clip.w;
+                        uNumOnScreenCulled += ( bOnScreen && !Visible[uInstance] ) ? 1 : 0;
+                    }
+                    continue;
+                }
+
+                // The same bins and the same instances in them as the scalar path
+                if( Bins.uNumVisible != ReferenceBins[uView].uNumVisible ||
+                    0 != memcmp( Bins.uCount, ReferenceBins[uView].uCount, sizeof( Bins.uCount ) ) ||
+                    ( 0 != Bins.uNumVisible && 0 != memcmp( puBinned, &ReferenceBinned[uView][0], Bins.uNumVisible * sizeof( UINT ) ) ) )
+                {
+                    uNumMismatches++;
+                }
+            }
+
+            if( 0 == uSIMD )
+            {
+                fScalarMs = fCullMs;
+            }
+
+            WCHAR szBins[64] = L"";
+            for( UINT uBin = 0; uBin < Bins.uNumBins; uBin++ )
+            {
+                WCHAR szBin[16];
+                swprintf_s( szBin, L"%s%.0f", ( 0 != uBin ) ? L"/" : L"", (double)uBinCounts[uBin] / NUM_VIEWS );
+                wcscat_s( szBins, szBin );
+            }
+            HeadlessReport( L"%9u %-7s %9.0f %-28s %10.3f %9.2f %9.1f %7.2fx %9.3f", uNumInstances, SIMD_NAMES[uSIMD], (double)uNumVisible / NUM_VIEWS,
+                            szBins, fCullMs / NUM_VIEWS, 1.0e6 * fCullMs / ( (double)uNumInstances * NUM_VIEWS ),
+                            (double)uNumInstances * NUM_VIEWS / ( 1000.0 * std::max( fCullMs, 1.0e-6 ) ), fScalarMs / std::max( fCullMs, 1.0e-6 ),
+                            fWriteMs / NUM_VIEWS );
+
+            if( 0 != uNumMismatches || 0 != uNumOnScreenCulled )
+            {
+                HeadlessReport( L"%9u %-7s %u views binned differently from the scalar path, %u instances on screen culled", uNumInstances,
+                                SIMD_NAMES[uSIMD], uNumMismatches, uNumOnScreenCulled );
+                hr = E_FAIL;
+            }
+        }
+
+        if( uNumInstances > UINT_MAX / 10 )
+        {
+            break;
+        }
+    }
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,550 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: HeadlessTools.cpp
+//
+// Command line and shared helpers of the headless tools, built to their own console
+// executable (see HeadlessTools.h).
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "..\\..\\DXUT\\Optional\\SDKmesh.h"
+#include "..\\..\\AMD_SDK\\inc\\AMD_SDK.h"
+#include "HeadlessTools.h"
+#include "NumaTaskPool.h"
+#include <float.h>
+#include <stdarg.h>
+
+using namespace DirectX;
+
+// The meshes shipped with the sample
+const WCHAR* const g_pszBundledMeshes[HEADLESS_NUM_BUNDLED_MESHES] =
+{
+    L"mushrooms\\mushrooms.sdkmesh",
+    L"tiger\\tiger.sdkmesh",
+    L"teapot\\teapot.sdkmesh",
+    L"icosphere\\icosphere.sdkmesh",
+};
+
+// Report output
+static FILE* g_pReportFile = NULL;
+
+// Directory the tools write meshes to, with a trailing separator. Empty for the current
+// directory.
+static WCHAR g_szOutputDir[MAX_PATH] = L"";
+
+// A tool takes the text after its ':' (empty if none) and returns S_OK if it passed
+typedef HRESULT (*LPHEADLESSTOOL)( const WCHAR* pszParam );
+
+struct HEADLESS_TOOL
+{
+    const WCHAR*    pszName;
+    LPHEADLESSTOOL  pfnRun;
+};
+
+// Tools selectable from the command line
+static const HEADLESS_TOOL g_HeadlessTools[] =
+{
+    { L"packerror",     RunPackErrorTool },
+    { L"patchupdate",   RunPatchUpdateTool },
+    { L"domaineval",    RunDomainEvalTool },
+    { L"tesscache",     RunTessCacheTool },
+    { L"bakelods",      RunBakeLODsTool },
+    { L"tessring",      RunTessRingTool },
+    { L"numa",          RunNumaTool },
+    { L"occlusion",     RunOcclusionTool },
+    { L"visibility",    RunVisibilityTool },
+    { L"patchorder",    RunPatchOrderTool },
+    { L"worldspace",    RunWorldSpaceTool },
+    { L"tessheatmap",   RunTessHeatmapTool },
+    { L"tesspolicy",    RunTessPolicyTool },
+    { L"fovea",         RunFoveaTool },
+    { L"dynres",        RunDynamicResolutionTool },
+    { L"motion",        RunMotionTool },
+    { L"multiview",     RunMultiViewTool },
+    { L"tesspass",      RunTessPassTool },
+    { L"tesspath",      RunTessPathTool },
+    { L"instances",     RunInstancesTool },
+    { L"silclip",       RunSilhouetteClipTool },
+    { L"progmesh",      RunProgressiveMeshTool },
+    { L"clusterlod",    RunClusterLODTool },
+    { L"simplify",      RunSimplifyTool },
+    { L"permutations",  RunPermutationsTool },
+};
+
+
+//--------------------------------------------------------------------------------------
+// Writes a formatted line to the report
+//--------------------------------------------------------------------------------------
+void HeadlessReport( const WCHAR* pszFormat, ... )
+{
+    WCHAR szLine[1024];
+
+    va_list Args;
+    va_start( Args, pszFormat );
+    _vsnwprintf_s( szLine, _countof( szLine ), _TRUNCATE, pszFormat, Args );
+    va_end( Args );
+
+    wprintf( L"%s\n", szLine );
+    OutputDebugString( szLine );
+    OutputDebugString( L"\n" );
+
+    if( NULL != g_pReportFile )
+    {
+        fwprintf( g_pReportFile, L"%s\n", szLine );
+        fflush( g_pReportFile );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Loads a bundled mesh without a device, reporting a failure
+//--------------------------------------------------------------------------------------
+HRESULT LoadBundledMesh( UINT uMesh, MESH_DATA* pMeshData, CDXUTSDKMesh* pSourceMesh )
+{
+    assert( uMesh < HEADLESS_NUM_BUNDLED_MESHES );
+    assert( NULL != pMeshData );
+
+    HRESULT hr = S_OK;
+    if( NULL != pSourceMesh )
+    {
+        // No GPU resources are created when the device is NULL
+        hr = pSourceMesh->Create( NULL, g_pszBundledMeshes[uMesh] );
+        if( SUCCEEDED( hr ) )
+        {
+            hr = ExtractMeshData( pSourceMesh, pMeshData );
+        }
+        if( FAILED( hr ) )
+        {
+            pSourceMesh->Destroy();
+        }
+    }
+    else
+    {
+        hr = LoadMeshData( g_pszBundledMeshes[uMesh], pMeshData );
+    }
+
+    if( FAILED( hr ) )
+    {
+        HeadlessReport( L"%-32s failed to load", g_pszBundledMeshes[uMesh] );
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the path of a mesh written by a tool, <output dir><source name><suffix>.sdkmesh
+//--------------------------------------------------------------------------------------
+void GetOutputMeshFileName( const WCHAR* pszSourceMesh, const WCHAR* pszSuffix, WCHAR* pszFileName, size_t uMaxChars )
+{
+    WCHAR szName[MAX_PATH];
+    const WCHAR* pszLastSlash = wcsrchr( pszSourceMesh, L'\\' );
+    wcscpy_s( szName, ( NULL != pszLastSlash ) ? pszLastSlash + 1 : pszSourceMesh );
+    WCHAR* pszExtension = wcsrchr( szName, L'.' );
+    if( NULL != pszExtension )
+    {
+        *pszExtension = 0;
+    }
+
+    swprintf_s( pszFileName, uMaxChars, L"%s%s%s.sdkmesh", g_szOutputDir, szName, pszSuffix );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the time in milliseconds, for benchmarks
+//--------------------------------------------------------------------------------------
+double GetTimeInMs()
+{
+    LARGE_INTEGER Frequency, Counter;
+    QueryPerformanceFrequency( &Frequency );
+    QueryPerformanceCounter( &Counter );
+
+    return 1000.0 * (double)Counter.QuadPart / (double)Frequency.QuadPart;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns true if the mesh data read back from a baked sdkmesh matches what was written.
+// The loader renormalizes the normals, so they are compared with a tolerance.
+//--------------------------------------------------------------------------------------
+bool IsSameMeshData( const MESH_DATA* pWritten, const MESH_DATA* pRead )
+{
+    if( pWritten->Vertices.size() != pRead->Vertices.size() || pWritten->Indices != pRead->Indices ||
+        pWritten->Subsets.size() != pRead->Subsets.size() )
+    {
+        return false;
+    }
+
+    for( UINT v = 0; v < pWritten->Vertices.size(); v++ )
+    {
+        const PN_VERTEX& Written = pWritten->Vertices[v];
+        const PN_VERTEX& Read = pRead->Vertices[v];
+        XMVECTOR vNormalError = XMVectorAbs( XMVectorSubtract( XMLoadFloat3( &Written.f3Normal ), XMLoadFloat3( &Read.f3Normal ) ) );
+
+        if( 0 != memcmp( &Written.f3Position, &Read.f3Position, sizeof( XMFLOAT3 ) ) ||
+            0 != memcmp( &Written.f2TexCoord, &Read.f2TexCoord, sizeof( XMFLOAT2 ) ) ||
+            !XMVector3LessOrEqual( vNormalError, XMVectorReplicate( 1.0e-5f ) ) )
+        {
+            return false;
+        }
+    }
+
+    for( UINT s = 0; s < pWritten->Subsets.size(); s++ )
+    {
+        const MESH_DATA_SUBSET& Written = pWritten->Subsets[s];
+        const MESH_DATA_SUBSET& Read = pRead->Subsets[s];
+        if( Written.uMesh != Read.uMesh || Written.uMaterialID != Read.uMaterialID ||
+            Written.uIndexStart != Read.uIndexStart || Written.uIndexCount != Read.uIndexCount )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Repeats the mesh data on a square grid in the XZ plane, fSpacing apart. Each copy gets
+// its own subsets.
+//--------------------------------------------------------------------------------------
+void BuildMeshGrid( const MESH_DATA* pMeshData, UINT uNumCopies, float fSpacing, MESH_DATA* pScene )
+{
+    UINT uGridSize = (UINT)ceilf( sqrtf( (float)uNumCopies ) );
+
+    pScene->Vertices.clear();
+    pScene->Indices.clear();
+    pScene->Subsets.clear();
+    pScene->Vertices.reserve( pMeshData->Vertices.size() * uNumCopies );
+    pScene->Indices.reserve( pMeshData->Indices.size() * uNumCopies );
+
+    for( UINT uCopy = 0; uCopy < uNumCopies; uCopy++ )
+    {
+        XMFLOAT3 f3Offset( fSpacing * (float)( uCopy % uGridSize ), 0.0f, fSpacing * (float)( uCopy / uGridSize ) );
+        UINT uBaseVertex = (UINT)pScene->Vertices.size();
+        UINT uBaseIndex = (UINT)pScene->Indices.size();
+
+        for( UINT i = 0; i < (UINT)pMeshData->Vertices.size(); i++ )
+        {
+            PN_VERTEX Vertex = pMeshData->Vertices[i];
+            Vertex.f3Position.x += f3Offset.x;
+            Vertex.f3Position.z += f3Offset.z;
+            pScene->Vertices.push_back( Vertex );
+        }
+        for( UINT i = 0; i < (UINT)pMeshData->Indices.size(); i++ )
+        {
+            pScene->Indices.push_back( pMeshData->Indices[i] + uBaseVertex );
+        }
+        for( UINT i = 0; i < (UINT)pMeshData->Subsets.size(); i++ )
+        {
+            MESH_DATA_SUBSET Subset = pMeshData->Subsets[i];
+            Subset.uIndexStart += uBaseIndex;
+            pScene->Subsets.push_back( Subset );
+        }
+    }
+
+    UINT uNumRows = ( uNumCopies + uGridSize - 1 ) / uGridSize;
+    pScene->f3BoundsMin = pMeshData->f3BoundsMin;
+    pScene->f3BoundsMax = pMeshData->f3BoundsMax;
+    pScene->f3BoundsMax.x += fSpacing * (float)( std::min( uNumCopies, uGridSize ) - 1 );
+    pScene->f3BoundsMax.z += fSpacing * (float)( uNumRows - 1 );
+}
+
+
+//--------------------------------------------------------------------------------------
+// A unit square of quads raised by a few waves, so the simplification has curvature to
+// keep everywhere
+//--------------------------------------------------------------------------------------
+void BuildSubdividedGrid( UINT uSegments, MESH_DATA* pMeshData )
+{
+    static const float WAVE_HEIGHT = 0.05f;
+
+    assert( uSegments > 0 );
+
+    UINT uRowVertices = uSegments + 1;
+    pMeshData->Vertices.resize( uRowVertices * uRowVertices );
+    pMeshData->Indices.clear();
+    pMeshData->Indices.reserve( uSegments * uSegments * 6 );
+    pMeshData->f3BoundsMin = XMFLOAT3( FLT_MAX, FLT_MAX, FLT_MAX );
+    pMeshData->f3BoundsMax = XMFLOAT3( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+
+    for( UINT z = 0; z < uRowVertices; z++ )
+    {
+        for( UINT x = 0; x < uRowVertices; x++ )
+        {
+            // Height and its slopes along x and z
+            float fU = (float)x / (float)uSegments, fV = (float)z / (float)uSegments;
+            float fA = XM_2PI * 3.0f * fU, fB = XM_2PI * 2.0f * fV, fC = XM_2PI * ( 7.0f * fU + 5.0f * fV );
+            float fHeight = WAVE_HEIGHT * ( sinf( fA ) * cosf( fB ) + 0.4f * sinf( fC ) );
+            float fSlopeX = WAVE_HEIGHT * XM_2PI * ( 3.0f * cosf( fA ) * cosf( fB ) + 0.4f * 7.0f * cosf( fC ) );
+            float fSlopeZ = WAVE_HEIGHT * XM_2PI * ( -2.0f * sinf( fA ) * sinf( fB ) + 0.4f * 5.0f * cosf( fC ) );
+
+            PN_VERTEX& Vertex = pMeshData->Vertices[z * uRowVertices + x];
+            Vertex.f3Position = XMFLOAT3( fU - 0.5f, fHeight, fV - 0.5f );
+            XMStoreFloat3( &Vertex.f3Normal, XMVector3Normalize( XMVectorSet( -fSlopeX, 1.0f, -fSlopeZ, 0.0f ) ) );
+            Vertex.f2TexCoord = XMFLOAT2( fU, fV );
+            XMStoreFloat3( &pMeshData->f3BoundsMin, XMVectorMin( XMLoadFloat3( &pMeshData->f3BoundsMin ), XMLoadFloat3( &Vertex.f3Position ) ) );
+            XMStoreFloat3( &pMeshData->f3BoundsMax, XMVectorMax( XMLoadFloat3( &pMeshData->f3BoundsMax ), XMLoadFloat3( &Vertex.f3Position ) ) );
+        }
+    }
+
+    // Clockwise seen from above, as the sample culls
+    for( UINT z = 0; z < uSegments; z++ )
+    {
+        for( UINT x = 0; x < uSegments; x++ )
+        {
+            UINT uCorner = z * uRowVertices + x;
+            UINT uQuad[6] = { uCorner, uCorner + uRowVertices, uCorner + 1, uCorner + 1, uCorner + uRowVertices, uCorner + uRowVertices + 1 };
+            pMeshData->Indices.insert( pMeshData->Indices.end(), uQuad, uQuad + 6 );
+        }
+    }
+
+    MESH_DATA_SUBSET Subset = { 0, 0, 0, 0, (UINT)pMeshData->Indices.size() };
+    pMeshData->Subsets.assign( 1, Subset );
+}
+
+
+//--------------------------------------------------------------------------------------
+// The pools of a scaling run
+//--------------------------------------------------------------------------------------
+void GetScalingPools( std::vector<SCALING_POOL>* pPools )
+{
+    std::vector<NUMA_NODE_INFO> Nodes;
+    GetNumaNodes( &Nodes );
+
+    pPools->clear();
+    UINT uNodeWorkers = Nodes[0].uNumProcessors;
+    for( UINT uWorkers = 1; ; uWorkers = std::min( uWorkers * 2, uNodeWorkers ) )
+    {
+        SCALING_POOL Pool = { 1, uWorkers };
+        pPools->push_back( Pool );
+        if( uWorkers == uNodeWorkers )
+        {
+            break;
+        }
+    }
+    for( UINT uNodes = 2; uNodes <= (UINT)Nodes.size(); uNodes++ )
+    {
+        SCALING_POOL Pool = { uNodes, 0 };
+        pPools->push_back( Pool );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the planes of the frustum of a view projection matrix, pointing inwards
+//--------------------------------------------------------------------------------------
+void GetFrustumPlanes( CXMMATRIX mViewProj, XMFLOAT4* pPlanes )
+{
+    XMMATRIX mTranspose = XMMatrixTranspose( mViewProj );
+    XMVECTOR vPlanes[6] =
+    {
+        XMVectorAdd( mTranspose.r[3], mTranspose.r[0] ),
+        XMVectorSubtract( mTranspose.r[3], mTranspose.r[0] ),
+        XMVectorAdd( mTranspose.r[3], mTranspose.r[1] ),
+        XMVectorSubtract( mTranspose.r[3], mTranspose.r[1] ),
+        mTranspose.r[2],
+        XMVectorSubtract( mTranspose.r[3], mTranspose.r[2] ),
+    };
+
+    for( UINT i = 0; i < 6; i++ )
+    {
+        XMStoreFloat4( &pPlanes[i], XMPlaneNormalize( vPlanes[i] ) );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns true if the box is entirely outside one of the frustum planes
+//--------------------------------------------------------------------------------------
+bool IsBoxOutsideFrustum( const XMFLOAT4* pPlanes, const XMFLOAT3& f3Min, const XMFLOAT3& f3Max )
+{
+    // The corner of the box furthest along each plane normal
+    XMVECTOR vMin = XMLoadFloat3( &f3Min );
+    XMVECTOR vMax = XMLoadFloat3( &f3Max );
+    for( UINT i = 0; i < 6; i++ )
+    {
+        XMVECTOR vPlane = XMLoadFloat4( &pPlanes[i] );
+        XMVECTOR vCorner = XMVectorSelect( vMin, vMax, XMVectorGreater( vPlane, XMVectorZero() ) );
+        if( XMVectorGetX( XMPlaneDotCoord( vPlane, vCorner ) ) < 0.0f )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Distance adaptive edge factors, as GetDistanceAdaptiveScaleFactor applied by
+// HS_PNTrianglesConstant, and the inside factor as their average
+//--------------------------------------------------------------------------------------
+void GetDistanceAdaptiveFactors( const PN_VERTEX* pCorners, FXMVECTOR vEye, float fMaxFactor, float fMinDistance, float fRange,
+                                 float* pfEdgeFactors, float* pfInsideFactor )
+{
+    // Edge 0 is I[2] - I[0], edge 1 is I[0] - I[1] and edge 2 is I[1] - I[2]
+    static const UINT EDGE_CORNERS[3][2] = { { 2, 0 }, { 0, 1 }, { 1, 2 } };
+
+    for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+    {
+        XMVECTOR vMidPoint = XMVectorScale( XMVectorAdd( XMLoadFloat3( &pCorners[EDGE_CORNERS[uEdge][0]].f3Position ),
+                                                         XMLoadFloat3( &pCorners[EDGE_CORNERS[uEdge][1]].f3Position ) ), 0.5f );
+        float fDistance = XMVectorGetX( XMVector3Length( XMVectorSubtract( vMidPoint, vEye ) ) ) - fMinDistance;
+        float fScale = 1.0f - std::min( std::max( fDistance / fRange, 0.0f ), 1.0f );
+        pfEdgeFactors[uEdge] = 1.0f + ( fMaxFactor - 1.0f ) * fScale;
+    }
+
+    *pfInsideFactor = ( pfEdgeFactors[0] + pfEdgeFactors[1] + pfEdgeFactors[2] ) / 3.0f;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Runs the tools requested on the command line
+//--------------------------------------------------------------------------------------
+static bool RunHeadlessTools( int* piExitCode )
+{
+    assert( NULL != piExitCode );
+
+    WCHAR szReportFile[MAX_PATH] = L"HeadlessReport.txt";
+    WCHAR szParam[MAX_PATH];
+    const HEADLESS_TOOL* pRequested[ARRAYSIZE( g_HeadlessTools )];
+    WCHAR szRequestedParam[ARRAYSIZE( g_HeadlessTools )][MAX_PATH];
+    UINT uNumRequested = 0;
+
+    // Same argument syntax as AMD::ParseCommandLine, e.g. -packerror:8
+    int iNumArgs = 0;
+    WCHAR** ppszArgs = CommandLineToArgvW( GetCommandLine(), &iNumArgs );
+    for( int iArg = 1; iArg < iNumArgs; iArg++ )
+    {
+        WCHAR* pszCmdLine = ppszArgs[iArg];
+        if( *pszCmdLine != L'/' && *pszCmdLine != L'-' )
+        {
+            continue;
+        }
+        pszCmdLine++;
+
+        if( AMD::IsNextArg( pszCmdLine, L"report" ) )
+        {
+            if( AMD::GetCmdParam( pszCmdLine, szParam ) )
+            {
+                wcscpy_s( szReportFile, szParam );
+            }
+            continue;
+        }
+
+        if( AMD::IsNextArg( pszCmdLine, L"outdir" ) )
+        {
+            if( AMD::GetCmdParam( pszCmdLine, szParam ) && 0 != szParam[0] )
+            {
+                wcscpy_s( g_szOutputDir, szParam );
+                size_t uLength = wcslen( g_szOutputDir );
+                if( L'\\' != g_szOutputDir[uLength - 1] && L'/' != g_szOutputDir[uLength - 1] )
+                {
+                    wcscat_s( g_szOutputDir, L"\\" );
+                }
+            }
+            continue;
+        }
+
+        for( UINT uTool = 0; uTool < ARRAYSIZE( g_HeadlessTools ); uTool++ )
+        {
+            if( AMD::IsNextArg( pszCmdLine, (WCHAR*)g_HeadlessTools[uTool].pszName ) )
+            {
+                if( uNumRequested < ARRAYSIZE( g_HeadlessTools ) )
+                {
+                    AMD::GetCmdParam( pszCmdLine, szRequestedParam[uNumRequested] );
+                    pRequested[uNumRequested++] = &g_HeadlessTools[uTool];
+                }
+                break;
+            }
+        }
+    }
+    LocalFree( ppszArgs );
+
+    if( 0 == uNumRequested )
+    {
+        return false;
+    }
+
+    _wfopen_s( &g_pReportFile, szReportFile, L"w" );
+
+    // Fails if it already exists, a missing parent shows up as failed writes
+    if( 0 != g_szOutputDir[0] )
+    {
+        CreateDirectory( g_szOutputDir, NULL );
+    }
+
+    *piExitCode = 0;
+    for( UINT i = 0; i < uNumRequested; i++ )
+    {
+        HeadlessReport( L"== %s ==", pRequested[i]->pszName );
+
+        HRESULT hr = pRequested[i]->pfnRun( szRequestedParam[i] );
+        HeadlessReport( L"%s: %s", pRequested[i]->pszName, SUCCEEDED( hr ) ? L"PASSED" : L"FAILED" );
+        HeadlessReport( L"" );
+        if( FAILED( hr ) )
+        {
+            *piExitCode = 1;
+        }
+    }
+
+    if( NULL != g_pReportFile )
+    {
+        fclose( g_pReportFile );
+        g_pReportFile = NULL;
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Entry point of the tools. Lists them if none was requested.
+//--------------------------------------------------------------------------------------
+int wmain( int, WCHAR** )
+{
+    // Enable run-time memory check for debug builds.
+#if defined(DEBUG) || defined(_DEBUG)
+    _CrtSetDbgFlag( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF );
+#endif
+
+    int iExitCode = 0;
+    if( !RunHeadlessTools( &iExitCode ) )
+    {
+        wprintf( L"Usage: -<tool>[:<param>] ... [-report:<file>] [-outdir:<directory>]\nTools:" );
+        for( UINT uTool = 0; uTool < ARRAYSIZE( g_HeadlessTools ); uTool++ )
+        {
+            wprintf( L" %s", g_HeadlessTools[uTool].pszName );
+        }
+        wprintf( L"\n" );
+        iExitCode = 1;
+    }
+
+    return iExitCode;
+}
+
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
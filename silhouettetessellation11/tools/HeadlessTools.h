@@ -0,0 +1,167 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: HeadlessTools.h
+//
+// Command line tools and benchmarks that run on the CPU references without creating a
+// window or a device (-permutations creates a WARP device). They build to their own
+// console executable, apart from the sample, e.g.
+//
+//      SilhouetteTessellation11Tools.exe -packerror:8 -report:PackError.txt
+//
+// Results are written to the report file (HeadlessReport.txt by default), to the console
+// and to the debugger output. Tools that write meshes put them in -outdir:<directory>
+// (the current directory by default), which is created if missing. Copy the textures of
+// the source mesh next to a written mesh to view it in the sample.
+//
+// HeadlessTools.cpp holds the command line and the helpers the tools share, the tools
+// themselves are grouped by the modules they exercise in PatchTools.cpp, CullingTools.cpp,
+// TessFactorTools.cpp, LODTools.cpp and ShaderTools.cpp.
+//--------------------------------------------------------------------------------------
+#ifndef HEADLESS_TOOLS_H
+#define HEADLESS_TOOLS_H
+
+#include "MeshData.h"
+
+// The meshes shipped with the sample
+static const UINT HEADLESS_NUM_BUNDLED_MESHES = 4;
+extern const WCHAR* const g_pszBundledMeshes[HEADLESS_NUM_BUNDLED_MESHES];
+
+// Default screen the orbit camera of the tess factor tools renders to
+static const UINT ORBIT_SCREEN_WIDTH = 1920;
+static const UINT ORBIT_SCREEN_HEIGHT = 1080;
+
+
+//--------------------------------------------------------------------------------------
+// Writes a formatted line to the report
+//--------------------------------------------------------------------------------------
+void HeadlessReport( const WCHAR* pszFormat, ... );
+
+
+//--------------------------------------------------------------------------------------
+// Loads bundled mesh uMesh without a device, reporting a failure. Tools that write meshes
+// pass pSourceMesh to keep the sdkmesh the data came from, which they destroy.
+//--------------------------------------------------------------------------------------
+HRESULT LoadBundledMesh( UINT uMesh, MESH_DATA* pMeshData, CDXUTSDKMesh* pSourceMesh = NULL );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the path of a mesh written by a tool, <output dir><source name><suffix>.sdkmesh
+//--------------------------------------------------------------------------------------
+void GetOutputMeshFileName( const WCHAR* pszSourceMesh, const WCHAR* pszSuffix, WCHAR* pszFileName, size_t uMaxChars );
+
+
+//--------------------------------------------------------------------------------------
+// Returns true if the mesh data read back from a written sdkmesh matches what was written
+//--------------------------------------------------------------------------------------
+bool IsSameMeshData( const MESH_DATA* pWritten, const MESH_DATA* pRead );
+
+
+//--------------------------------------------------------------------------------------
+// Repeats the mesh data on a square grid in the XZ plane, fSpacing apart
+//--------------------------------------------------------------------------------------
+void BuildMeshGrid( const MESH_DATA* pMeshData, UINT uNumCopies, float fSpacing, MESH_DATA* pScene );
+
+
+//--------------------------------------------------------------------------------------
+// A unit square of uSegments x uSegments quads in the XZ plane, two triangles each,
+// raised by a few waves. Stands in for a dense asset of any size in the scaling runs.
+//--------------------------------------------------------------------------------------
+void BuildSubdividedGrid( UINT uSegments, MESH_DATA* pMeshData );
+
+
+//--------------------------------------------------------------------------------------
+// The pools of a scaling run: 1, 2, 4... workers on the first node up to all of its
+// processors, then all the workers of the first 2, 3... nodes
+//--------------------------------------------------------------------------------------
+struct SCALING_POOL
+{
+    UINT    uMaxNodes;
+    UINT    uMaxWorkersPerNode;
+};
+
+void GetScalingPools( std::vector<SCALING_POOL>* pPools );
+
+
+//--------------------------------------------------------------------------------------
+// Returns the time in milliseconds, for benchmarks
+//--------------------------------------------------------------------------------------
+double GetTimeInMs();
+
+
+//--------------------------------------------------------------------------------------
+// Frustum planes of a view projection matrix, pointing inwards, and the test of a box
+// against them
+//--------------------------------------------------------------------------------------
+void GetFrustumPlanes( DirectX::CXMMATRIX mViewProj, DirectX::XMFLOAT4* pPlanes );
+bool IsBoxOutsideFrustum( const DirectX::XMFLOAT4* pPlanes, const DirectX::XMFLOAT3& f3Min, const DirectX::XMFLOAT3& f3Max );
+
+
+//--------------------------------------------------------------------------------------
+// Distance adaptive edge and inside factors of a patch, as HS_PNTrianglesConstant
+//--------------------------------------------------------------------------------------
+void GetDistanceAdaptiveFactors( const PN_VERTEX* pCorners, DirectX::FXMVECTOR vEye, float fMaxFactor, float fMinDistance, float fRange,
+                                 float* pfEdgeFactors, float* pfInsideFactor );
+
+
+//--------------------------------------------------------------------------------------
+// The tools. Each takes the text after its ':' (empty if none), reports its results and
+// returns S_OK if it passed.
+//--------------------------------------------------------------------------------------
+
+// PatchTools.cpp
+HRESULT RunPackErrorTool( const WCHAR* pszParam );
+HRESULT RunPatchUpdateTool( const WCHAR* pszParam );
+HRESULT RunDomainEvalTool( const WCHAR* pszParam );
+HRESULT RunTessCacheTool( const WCHAR* pszParam );
+HRESULT RunBakeLODsTool( const WCHAR* pszParam );
+HRESULT RunTessRingTool( const WCHAR* pszParam );
+HRESULT RunPatchOrderTool( const WCHAR* pszParam );
+HRESULT RunWorldSpaceTool( const WCHAR* pszParam );
+
+// CullingTools.cpp
+HRESULT RunNumaTool( const WCHAR* pszParam );
+HRESULT RunOcclusionTool( const WCHAR* pszParam );
+HRESULT RunVisibilityTool( const WCHAR* pszParam );
+HRESULT RunInstancesTool( const WCHAR* pszParam );
+
+// TessFactorTools.cpp
+HRESULT RunTessHeatmapTool( const WCHAR* pszParam );
+HRESULT RunTessPolicyTool( const WCHAR* pszParam );
+HRESULT RunFoveaTool( const WCHAR* pszParam );
+HRESULT RunDynamicResolutionTool( const WCHAR* pszParam );
+HRESULT RunMotionTool( const WCHAR* pszParam );
+HRESULT RunMultiViewTool( const WCHAR* pszParam );
+HRESULT RunTessPassTool( const WCHAR* pszParam );
+HRESULT RunTessPathTool( const WCHAR* pszParam );
+HRESULT RunSilhouetteClipTool( const WCHAR* pszParam );
+
+// LODTools.cpp
+HRESULT RunProgressiveMeshTool( const WCHAR* pszParam );
+HRESULT RunClusterLODTool( const WCHAR* pszParam );
+HRESULT RunSimplifyTool( const WCHAR* pszParam );
+
+// ShaderTools.cpp
+HRESULT RunPermutationsTool( const WCHAR* pszParam );
+
+#endif
@@ -0,0 +1,1243 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: LODTools.cpp
+//
+// Tools of the level of detail built on the CPU: the progressive mesh, the cluster LOD DAG
+// and the mesh simplification.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "..\\..\\DXUT\\Optional\\SDKmesh.h"
+#include "HeadlessTools.h"
+#include "MeshBake.h"
+#include "SDKMeshWriter.h"
+#include "ProgressiveMesh.h"
+#include "ClusterDAG.h"
+#include "MeshSimplify.h"
+#include <float.h>
+#include <map>
+
+using namespace DirectX;
+
+
+//--------------------------------------------------------------------------------------
+// A PN-Triangles patch as the progressive mesh tool selects its tess factor: the bounds of
+// the patch, and from uErrorOffset on, the chord error at each integer factor
+//--------------------------------------------------------------------------------------
+struct PM_PN_PATCH
+{
+    XMFLOAT3    f3Center;
+    float       fRadius;
+    XMFLOAT3    f3ConeAxis;
+    float       fConeCosine;    // -1 if unbounded
+    float       fConeSine;
+    UINT        uErrorOffset;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates a PN-Triangles patch on the uniform grid of a factor, (f + 1) x (f + 1) points
+// of which those with i + j <= f are used
+//--------------------------------------------------------------------------------------
+static void GetPNGrid( const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints, UINT uFactor, std::vector<XMFLOAT3>* pGrid,
+                       std::vector<XMFLOAT3>* pNormals )
+{
+    pGrid->resize( ( uFactor + 1 ) * ( uFactor + 1 ) );
+    if( NULL != pNormals )
+    {
+        pNormals->resize( pGrid->size() );
+    }
+    for( UINT i = 0; i <= uFactor; i++ )
+    {
+        for( UINT j = 0; i + j <= uFactor; j++ )
+        {
+            float fU = (float)i / (float)uFactor, fV = (float)j / (float)uFactor;
+            EvaluatePNTriangle( pCorners, pControlPoints, fU, fV, std::max( 1.0f - fU - fV, 0.0f ), &( *pGrid )[i * ( uFactor + 1 ) + j],
+                                ( NULL != pNormals ) ? &( *pNormals )[i * ( uFactor + 1 ) + j] : NULL );
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Bounds each patch of a mesh by its points at uMaxFactor and measures, for each factor up
+// to uMaxFactor, the distance of those points to the flat triangles of the factor
+//--------------------------------------------------------------------------------------
+static void InitPNPatches( const MESH_DATA* pMeshData, UINT uMaxFactor, std::vector<PM_PN_PATCH>* pPatches, std::vector<float>* pErrors )
+{
+    UINT uNumPatches = (UINT)pMeshData->Indices.size() / 3;
+    pPatches->resize( uNumPatches );
+    pErrors->resize( uNumPatches * uMaxFactor );
+
+    std::vector<XMFLOAT3> Fine, FineNormals, Coarse;
+    for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+    {
+        PN_VERTEX Corners[3];
+        for( UINT c = 0; c < 3; c++ )
+        {
+            Corners[c] = pMeshData->Vertices[pMeshData->Indices[uPatch * 3 + c]];
+        }
+        PN_CONTROL_POINTS ControlPoints;
+        ComputePNControlPoints( Corners, &ControlPoints );
+        GetPNGrid( Corners, &ControlPoints, uMaxFactor, &Fine, &FineNormals );
+
+        // Sphere around the centroid and cone around the mean normal of the points
+        XMVECTOR vCenter = XMVectorZero(), vAxis = XMVectorZero();
+        UINT uNumPoints = 0;
+        for( UINT i = 0; i <= uMaxFactor; i++ )
+        {
+            for( UINT j = 0; i + j <= uMaxFactor; j++ )
+            {
+                vCenter = XMVectorAdd( vCenter, XMLoadFloat3( &Fine[i * ( uMaxFactor + 1 ) + j] ) );
+                vAxis = XMVectorAdd( vAxis, XMLoadFloat3( &FineNormals[i * ( uMaxFactor + 1 ) + j] ) );
+                uNumPoints++;
+            }
+        }
+        vCenter = XMVectorScale( vCenter, 1.0f / (float)uNumPoints );
+        vAxis = ( XMVectorGetX( XMVector3LengthSq( vAxis ) ) > 0.0f ) ? XMVector3Normalize( vAxis ) : XMVectorSet( 0.0f, 0.0f, 1.0f, 0.0f );
+        float fRadius = 0.0f, fConeCosine = 1.0f;
+        for( UINT i = 0; i <= uMaxFactor; i++ )
+        {
+            for( UINT j = 0; i + j <= uMaxFactor; j++ )
+            {
+                fRadius = std::max( fRadius, XMVectorGetX( XMVector3Length( XMVectorSubtract( XMLoadFloat3( &Fine[i * ( uMaxFactor + 1 ) + j] ), vCenter ) ) ) );
+                fConeCosine = std::min( fConeCosine, XMVectorGetX( XMVector3Dot( XMLoadFloat3( &FineNormals[i * ( uMaxFactor + 1 ) + j] ), vAxis ) ) );
+            }
+        }
+        PM_PN_PATCH& Patch = ( *pPatches )[uPatch];
+        XMStoreFloat3( &Patch.f3Center, vCenter );
+        Patch.fRadius = fRadius;
+        XMStoreFloat3( &Patch.f3ConeAxis, vAxis );
+        Patch.fConeCosine = ( fConeCosine > 0.0f ) ? fConeCosine : -1.0f;
+        Patch.fConeSine = sqrtf( std::max( 1.0f - Patch.fConeCosine * Patch.fConeCosine, 0.0f ) );
+        Patch.uErrorOffset = uPatch * uMaxFactor;
+
+        // The triangle of the grid of uFactor each point falls in, lower ( i, j ), ( i + 1, j ),
+        // ( i, j + 1 ) or upper ( i + 1, j + 1 ), ( i, j + 1 ), ( i + 1, j )
+        for( UINT uFactor = 1; uFactor <= uMaxFactor; uFactor++ )
+        {
+            GetPNGrid( Corners, &ControlPoints, uFactor, &Coarse, NULL );
+            float fError = 0.0f;
+            for( UINT uI = 0; uI <= uMaxFactor; uI++ )
+            {
+                for( UINT uJ = 0; uI + uJ <= uMaxFactor; uJ++ )
+                {
+                    float fA = (float)( uI * uFactor ) / (float)uMaxFactor, fB = (float)( uJ * uFactor ) / (float)uMaxFactor;
+                    UINT i = std::min( (UINT)fA, uFactor - 1 );
+                    UINT j = std::min( (UINT)fB, uFactor - 1 - i );
+                    float fFracA = fA - (float)i, fFracB = fB - (float)j;
+                    const XMFLOAT3* pGrid = &Coarse[0];
+                    UINT uStride = uFactor + 1;
+                    XMVECTOR vLinear;
+                    if( fFracA + fFracB <= 1.0f )
+                    {
+                        vLinear = XMVectorScale( XMLoadFloat3( &pGrid[i * uStride + j] ), 1.0f - fFracA - fFracB );
+                        vLinear = XMVectorAdd( vLinear, XMVectorScale( XMLoadFloat3( &pGrid[( i + 1 ) * uStride + j] ), fFracA ) );
+                        vLinear = XMVectorAdd( vLinear, XMVectorScale( XMLoadFloat3( &pGrid[i * uStride + j + 1] ), fFracB ) );
+                    }
+                    else
+                    {
+                        vLinear = XMVectorScale( XMLoadFloat3( &pGrid[( i + 1 ) * uStride + j + 1] ), fFracA + fFracB - 1.0f );
+                        vLinear = XMVectorAdd( vLinear, XMVectorScale( XMLoadFloat3( &pGrid[i * uStride + j + 1] ), 1.0f - fFracA ) );
+                        vLinear = XMVectorAdd( vLinear, XMVectorScale( XMLoadFloat3( &pGrid[( i + 1 ) * uStride + j] ), 1.0f - fFracB ) );
+                    }
+                    fError = std::max( fError, XMVectorGetX( XMVector3Length( XMVectorSubtract( XMLoadFloat3( &Fine[uI * ( uMaxFactor + 1 ) + uJ] ), vLinear ) ) ) );
+                }
+            }
+            ( *pErrors )[Patch.uErrorOffset + uFactor - 1] = fError;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the triangles of the patches at the lowest integer factors that meet the
+// screen error of the view, weighted as CProgressiveMesh weights its regions. Patches
+// outside the frustum or facing away are culled.
+//--------------------------------------------------------------------------------------
+static UINT GetPNTrianglesForView( const std::vector<PM_PN_PATCH>& Patches, const std::vector<float>& Errors, UINT uMaxFactor,
+                                   const PM_VIEW* pView )
+{
+    UINT uNumTriangles = 0;
+    for( UINT uPatch = 0; uPatch < (UINT)Patches.size(); uPatch++ )
+    {
+        const PM_PN_PATCH& Patch = Patches[uPatch];
+        bool bOutside = false;
+        for( UINT i = 0; i < 6 && !bOutside; i++ )
+        {
+            const XMFLOAT4& f4Plane = pView->f4FrustumPlanes[i];
+            bOutside = f4Plane.x * Patch.f3Center.x + f4Plane.y * Patch.f3Center.y + f4Plane.z * Patch.f3Center.z + f4Plane.w < -Patch.fRadius;
+        }
+        if( bOutside )
+        {
+            continue;
+        }
+
+        XMVECTOR vToEye = XMVectorSubtract( XMLoadFloat3( &pView->f3Eye ), XMLoadFloat3( &Patch.f3Center ) );
+        float fDistance = XMVectorGetX( XMVector3Length( vToEye ) );
+        if( fDistance <= Patch.fRadius )
+        {
+            uNumTriangles += uMaxFactor * uMaxFactor;
+            continue;
+        }
+
+        float fInvDistance = 1.0f / fDistance;
+        float fSineS = Patch.fRadius * fInvDistance;
+        float fCosineS = sqrtf( 1.0f - fSineS * fSineS );
+        float fCosineSpread = Patch.fConeCosine * fCosineS - Patch.fConeSine * fSineS;
+        float fSineSpread = Patch.fConeSine * fCosineS + Patch.fConeCosine * fSineS;
+        float fCosine = XMVectorGetX( XMVector3Dot( XMLoadFloat3( &Patch.f3ConeAxis ), vToEye ) ) * fInvDistance;
+        float fErrorScale = 1.0f;
+        if( fCosineSpread > 0.0f && fCosine < -fSineSpread )
+        {
+            continue;
+        }
+        if( fCosineSpread > 0.0f && fCosine > fSineSpread )
+        {
+            fErrorScale = 1.0f / PM_INTERIOR_ERROR_SCALE;
+        }
+
+        float fMaxError = pView->fPixelError * ( fDistance - Patch.fRadius ) / ( fErrorScale * pView->fPixelsPerUnit );
+        UINT uFactor = 1;
+        while( uFactor < uMaxFactor && Errors[Patch.uErrorOffset + uFactor - 1] > fMaxError )
+        {
+            uFactor++;
+        }
+        uNumTriangles += uFactor * uFactor;
+    }
+    return uNumTriangles;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Builds the progressive mesh of each bundled mesh from its PN-Triangles surface, stores
+// it next to the mesh, and refines it along a camera path orbiting and moving in and out.
+// Reports the build, the first refinement from the coarsest mesh, and per frame on average
+// the triangles, update time, splits, collapses, collapses refused as they would turn a
+// triangle over, rewritten triangles and uploaded index data, against the PN-Triangles
+// triangles at the integer tess factors that meet the same screen error and the time to
+// select them. The updated indices must match those rebuilt
+// from scratch, and the stored mesh must refine as the built one.
+// Param: the screen error at the silhouette in pixels (default PM_PIXEL_ERROR)
+//--------------------------------------------------------------------------------------
+HRESULT RunProgressiveMeshTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT NUM_FRAMES = 240;
+    static const UINT CHECK_INTERVAL = 16;
+    static const float CAMERA_PITCH = XM_PI / 9.0f;
+    static const float MIN_DISTANCE = 0.6f;     // In diagonals
+    static const float MAX_DISTANCE = 3.0f;
+
+    float fPixelError = ( 0 != pszParam[0] ) ? (float)_wtof( pszParam ) : PM_PIXEL_ERROR;
+    if( !( fPixelError > 0.0f ) )
+    {
+        HeadlessReport( L"Expected a screen error over 0 pixels, got %s", pszParam );
+        return E_INVALIDARG;
+    }
+    UINT uMaxFactor = (UINT)PM_SOURCE_TESS_FACTOR;
+
+    HeadlessReport( L"PN-Triangles detailed mesh at tess factor %.1f, %.2f pixel error at the silhouette, %.1fx inside, %u frames at %ux%u",
+                    PM_SOURCE_TESS_FACTOR, fPixelError, PM_INTERIOR_ERROR_SCALE, NUM_FRAMES, ORBIT_SCREEN_WIDTH, ORBIT_SCREEN_HEIGHT );
+    HeadlessReport( L"%-32s %8s %9s %7s %6s %9s %8s %9s %8s %8s %8s %8s %9s %8s %9s %8s %7s", L"Mesh", L"Vertices", L"Triangles",
+                    L"Roots", L"Depth", L"Build ms", L"First ms", L"PM tris", L"PM ms", L"Splits", L"Collapse", L"Refused", L"Rewritten",
+                    L"Upload KB", L"PN tris", L"PN ms", L"PN/PM" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        CDXUTSDKMesh SourceMesh;
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData, &SourceMesh ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        // The sidecar goes in the directory of the source, where the sample looks for it
+        WCHAR szMeshFileName[MAX_PATH], szFileName[MAX_PATH];
+        const WCHAR* pszLastSlash = wcsrchr( g_pszBundledMeshes[uMesh], L'\\' );
+        swprintf_s( szMeshFileName, L"%s%s", SourceMesh.GetMeshPathW(), ( NULL != pszLastSlash ) ? pszLastSlash + 1 : g_pszBundledMeshes[uMesh] );
+        GetProgressiveMeshFileName( szMeshFileName, szFileName, MAX_PATH );
+        SourceMesh.Destroy();
+
+        MESH_DATA Detailed;
+        MESH_BAKE_STATS BakeStats;
+        CProgressiveMesh Mesh;
+        double fStart = GetTimeInMs();
+        HRESULT hrBuild = BakeTessellatedMeshData( &MeshData, CPU_TESS_PN_TRIANGLES, PM_SOURCE_TESS_FACTOR, &Detailed, &BakeStats );
+        hrBuild = SUCCEEDED( hrBuild ) ? Mesh.Build( &Detailed ) : hrBuild;
+        double fBuildMs = GetTimeInMs() - fStart;
+        if( FAILED( hrBuild ) || FAILED( Mesh.Save( szFileName ) ) )
+        {
+            HeadlessReport( L"%-32s failed to build or write %s", g_pszBundledMeshes[uMesh], szFileName );
+            hr = E_FAIL;
+            continue;
+        }
+
+        std::vector<PM_PN_PATCH> Patches;
+        std::vector<float> Errors;
+        InitPNPatches( &MeshData, uMaxFactor, &Patches, &Errors );
+
+        float fDiagonal = GetMeshDataBoundsDiagonal( &MeshData );
+        XMVECTOR vCenter = XMVectorScale( XMVectorAdd( XMLoadFloat3( &MeshData.f3BoundsMin ), XMLoadFloat3( &MeshData.f3BoundsMax ) ), 0.5f );
+        XMMATRIX mProj = XMMatrixPerspectiveFovLH( XM_PI / 4.0f, (float)ORBIT_SCREEN_WIDTH / (float)ORBIT_SCREEN_HEIGHT, 0.01f * fDiagonal,
+                                                   10.0f * fDiagonal );
+
+        std::vector<UINT> Live, Reference;
+        UINT64 uNumPMTriangles = 0, uNumSplits = 0, uNumCollapses = 0, uNumRefused = 0, uNumRewritten = 0, uNumDirtyBlocks = 0;
+        UINT64 uNumPNTriangles = 0;
+        double fFirstMs = 0.0, fPMMs = 0.0, fPNMs = 0.0;
+        bool bMatched = true;
+        PM_VIEW FirstView;
+        for( UINT uFrame = 0; uFrame < NUM_FRAMES; uFrame++ )
+        {
+            // Once around, in and out twice
+            float fPhase = (float)uFrame / (float)NUM_FRAMES;
+            float fYaw = XM_2PI * fPhase;
+            float fDistance = MIN_DISTANCE + ( MAX_DISTANCE - MIN_DISTANCE ) * ( 0.5f + 0.5f * cosf( 2.0f * XM_2PI * fPhase ) );
+            XMVECTOR vOffset = XMVectorSet( sinf( fYaw ) * cosf( CAMERA_PITCH ), sinf( CAMERA_PITCH ), -cosf( fYaw ) * cosf( CAMERA_PITCH ), 0.0f );
+            XMMATRIX mView = XMMatrixLookAtLH( XMVectorAdd( vCenter, XMVectorScale( vOffset, fDistance * fDiagonal ) ), vCenter,
+                                               XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f ) );
+            PM_VIEW View;
+            InitProgressiveMeshView( XMMatrixIdentity(), mView, mProj, (float)ORBIT_SCREEN_HEIGHT, fPixelError, &View );
+
+            PM_UPDATE_STATS Stats;
+            fStart = GetTimeInMs();
+            Mesh.Update( &View, &Stats );
+            double fUpdateMs = GetTimeInMs() - fStart;
+            if( 0 == uFrame )
+            {
+                // From the coarsest mesh, not frame coherent
+                FirstView = View;
+                fFirstMs = fUpdateMs;
+            }
+            else
+            {
+                fPMMs += fUpdateMs;
+                uNumSplits += Stats.uNumSplits;
+                uNumCollapses += Stats.uNumCollapses;
+                uNumRefused += Stats.uNumRefusedCollapses;
+                uNumRewritten += Stats.uNumRewrittenTriangles;
+                uNumDirtyBlocks += Stats.uNumDirtyBlocks;
+            }
+            uNumPMTriangles += Stats.uNumTriangles;
+            Mesh.ClearDirtyBlocks();
+
+            if( 0 == uFrame % CHECK_INTERVAL )
+            {
+                Mesh.GetLiveTriangles( &Live );
+                Mesh.GetReferenceTriangles( &Reference );
+                bMatched = bMatched && ( Reference == Live );
+            }
+
+            fStart = GetTimeInMs();
+            uNumPNTriangles += GetPNTrianglesForView( Patches, Errors, uMaxFactor, &View );
+            fPNMs += GetTimeInMs() - fStart;
+        }
+
+        // The stored mesh refines as the built one
+        CProgressiveMesh Loaded;
+        Mesh.Reset();
+        Mesh.Update( &FirstView, NULL );
+        Mesh.GetLiveTriangles( &Live );
+        if( SUCCEEDED( Loaded.Load( szFileName ) ) )
+        {
+            Loaded.Update( &FirstView, NULL );
+            Loaded.GetLiveTriangles( &Reference );
+        }
+        if( !Loaded.IsBuilt() || Reference != Live )
+        {
+            HeadlessReport( L"%-32s %s does not match the built mesh", g_pszBundledMeshes[uMesh], szFileName );
+            hr = E_FAIL;
+        }
+        if( !bMatched )
+        {
+            HeadlessReport( L"%-32s the updated indices differ from the rebuilt ones", g_pszBundledMeshes[uMesh] );
+            hr = E_FAIL;
+        }
+
+        UINT uNumFrames = NUM_FRAMES - 1;
+        HeadlessReport( L"%-32s %8u %9u %7u %6u %9.1f %8.3f %9.1f %8.3f %8.1f %8.1f %8.1f %9.1f %9.1f %9.1f %8.3f %7.2f",
+                        g_pszBundledMeshes[uMesh], Mesh.GetNumVertices(), Mesh.GetNumTriangles(), Mesh.GetNumRoots(), Mesh.GetMaxDepth(),
+                        fBuildMs, fFirstMs, (double)uNumPMTriangles / NUM_FRAMES, fPMMs / uNumFrames, (double)uNumSplits / uNumFrames,
+                        (double)uNumCollapses / uNumFrames, (double)uNumRefused / uNumFrames, (double)uNumRewritten / uNumFrames,
+                        (double)uNumDirtyBlocks * PM_BLOCK_TRIANGLES * 3 * sizeof( UINT ) / 1024.0 / uNumFrames,
+                        (double)uNumPNTriangles / NUM_FRAMES, fPNMs / NUM_FRAMES,
+                        (double)uNumPNTriangles / std::max( (double)uNumPMTriangles, 1.0 ) );
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Appends the edges of triangles, as vertex pairs low first, and keeps those used an odd
+// number of times: the open edges of a closed set, sorted
+//--------------------------------------------------------------------------------------
+static void GetOddEdges( const std::vector<UINT>& Indices, std::vector<UINT64>* pEdges )
+{
+    std::vector<UINT64> Edges;
+    Edges.reserve( Indices.size() );
+    for( UINT i = 0; i + 2 < (UINT)Indices.size(); i += 3 )
+    {
+        for( UINT c = 0; c < 3; c++ )
+        {
+            UINT uA = Indices[i + c], uB = Indices[i + ( c + 1 ) % 3];
+            Edges.push_back( ( (UINT64)std::min( uA, uB ) << 32 ) | std::max( uA, uB ) );
+        }
+    }
+    std::sort( Edges.begin(), Edges.end() );
+
+    pEdges->clear();
+    for( UINT i = 0; i < (UINT)Edges.size(); )
+    {
+        UINT uEnd = i + 1;
+        while( uEnd < (UINT)Edges.size() && Edges[uEnd] == Edges[i] )
+        {
+            uEnd++;
+        }
+        if( 0 != ( uEnd - i ) % 2 )
+        {
+            pEdges->push_back( Edges[i] );
+        }
+        i = uEnd;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns true if two cluster DAGs have the same triangles and clusters
+//--------------------------------------------------------------------------------------
+static bool IsSameClusterDAG( const CClusterDAG& A, const CClusterDAG& B )
+{
+    const std::vector<CLUSTER>& ClustersA = A.GetClusters();
+    const std::vector<CLUSTER>& ClustersB = B.GetClusters();
+
+    return A.GetIndices() == B.GetIndices() && ClustersA.size() == ClustersB.size() &&
+           ( ClustersA.empty() || 0 == memcmp( &ClustersA[0], &ClustersB[0], ClustersA.size() * sizeof( CLUSTER ) ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Builds the cluster DAG of each bundled mesh from its PN-Triangles surface at a high tess
+// factor, standing in for a dense asset, on one thread and over the workers, and stores it
+// next to the mesh. Selects the cut along an orbit moving in and out, on one thread and
+// over the workers. Reports the levels, clusters, triangles, build times and memory per
+// input triangle, and on average the clusters and triangles of the cut and the time to
+// select it. Both builds and the stored DAG must match, both selections must match, and
+// the open edges of every cut must be those of the input mesh.
+//
+// Then builds the DAG of a synthetic grid far denser than the bundled meshes with 1, 2,
+// 4... workers (see GetScalingPools) and reports the build time, speedup and efficiency
+// against one thread. Only the simplification of the groups runs on the workers: the weld,
+// the Morton order and the merge of each level run on one thread, and the levels run one
+// after the other with fewer groups each, so the speedup levels off well below the
+// number of workers. Every build must match the one thread build.
+// Param: the tess factor of the surface (default CLUSTER_SOURCE_TESS_FACTOR)
+//--------------------------------------------------------------------------------------
+HRESULT RunClusterLODTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT NUM_VIEWS = 24;
+    static const UINT NUM_SELECT_PASSES = 16;
+    static const UINT SCALING_GRID_SEGMENTS = 512;
+    static const UINT NUM_SCALING_BUILDS = 3;       // The fastest counts
+    static const float CAMERA_PITCH = XM_PI / 9.0f;
+    static const float MIN_DISTANCE = 0.6f;     // In diagonals
+    static const float MAX_DISTANCE = 6.0f;
+
+    float fFactor = ( 0 != pszParam[0] ) ? (float)_wtof( pszParam ) : CLUSTER_SOURCE_TESS_FACTOR;
+    if( !( fFactor >= 1.0f ) )
+    {
+        HeadlessReport( L"Expected a tess factor of at least 1, got %s", pszParam );
+        return E_INVALIDARG;
+    }
+
+    CNumaTaskPool Pool;
+    if( FAILED( Pool.Create( 0, 0 ) ) )
+    {
+        HeadlessReport( L"Failed to start the workers" );
+        return E_FAIL;
+    }
+
+    HeadlessReport( L"PN-Triangles surface at tess factor %.1f, %u triangles per cluster, groups of %u, %.2f pixel error, %u views at %ux%u, %u workers",
+                    fFactor, CLUSTER_MAX_TRIANGLES, CLUSTER_GROUP_SIZE, CLUSTER_PIXEL_ERROR, NUM_VIEWS, ORBIT_SCREEN_WIDTH,
+                    ORBIT_SCREEN_HEIGHT, Pool.GetNumWorkers() );
+    HeadlessReport( L"%-32s %6s %8s %10s %10s %10s %10s %8s %8s %9s %9s %9s %7s", L"Mesh", L"Levels", L"Clusters", L"Input tris",
+                    L"DAG tris", L"Build ms", L"Pool ms", L"B/tri", L"Cut", L"Cut tris", L"Select ms", L"Pool ms", L"Culled" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        CDXUTSDKMesh SourceMesh;
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData, &SourceMesh ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        // The sidecar goes in the directory of the source, where the sample looks for it
+        WCHAR szMeshFileName[MAX_PATH], szFileName[MAX_PATH];
+        const WCHAR* pszLastSlash = wcsrchr( g_pszBundledMeshes[uMesh], L'\\' );
+        swprintf_s( szMeshFileName, L"%s%s", SourceMesh.GetMeshPathW(), ( NULL != pszLastSlash ) ? pszLastSlash + 1 : g_pszBundledMeshes[uMesh] );
+        GetClusterDAGFileName( szMeshFileName, szFileName, MAX_PATH );
+        SourceMesh.Destroy();
+
+        MESH_DATA Detailed;
+        MESH_BAKE_STATS BakeStats;
+        CClusterDAG DAG, PoolDAG, Loaded;
+        HRESULT hrBuild = BakeTessellatedMeshData( &MeshData, CPU_TESS_PN_TRIANGLES, fFactor, &Detailed, &BakeStats );
+        double fStart = GetTimeInMs();
+        hrBuild = SUCCEEDED( hrBuild ) ? DAG.Build( &Detailed, NULL ) : hrBuild;
+        double fBuildMs = GetTimeInMs() - fStart;
+        fStart = GetTimeInMs();
+        hrBuild = SUCCEEDED( hrBuild ) ? PoolDAG.Build( &Detailed, &Pool ) : hrBuild;
+        double fPoolBuildMs = GetTimeInMs() - fStart;
+        if( FAILED( hrBuild ) || FAILED( DAG.Save( szFileName ) ) )
+        {
+            HeadlessReport( L"%-32s failed to build or write %s", g_pszBundledMeshes[uMesh], szFileName );
+            hr = E_FAIL;
+            continue;
+        }
+
+        // The workers and the sidecar give the same DAG
+        const std::vector<CLUSTER>& Clusters = DAG.GetClusters();
+        bool bSameDAG = IsSameClusterDAG( PoolDAG, DAG );
+        bool bSameLoaded = SUCCEEDED( Loaded.Load( szFileName ) ) && IsSameClusterDAG( Loaded, DAG );
+        if( !bSameDAG || !bSameLoaded )
+        {
+            HeadlessReport( L"%-32s %s", g_pszBundledMeshes[uMesh], !bSameDAG ? L"the DAG built over the workers differs" :
+                                                                                  L"the stored DAG does not match the built one" );
+            hr = E_FAIL;
+        }
+
+        // The open edges of the input, which every cut must keep
+        std::vector<UINT> InputIndices( DAG.GetIndices().begin(), DAG.GetIndices().begin() + DAG.GetNumInputTriangles() * 3 );
+        std::vector<UINT64> InputEdges, CutEdges;
+        GetOddEdges( InputIndices, &InputEdges );
+
+        float fDiagonal = GetMeshDataBoundsDiagonal( &MeshData );
+        XMVECTOR vCenter = XMVectorScale( XMVectorAdd( XMLoadFloat3( &MeshData.f3BoundsMin ), XMLoadFloat3( &MeshData.f3BoundsMax ) ), 0.5f );
+        XMMATRIX mProj = XMMatrixPerspectiveFovLH( XM_PI / 4.0f, (float)ORBIT_SCREEN_WIDTH / (float)ORBIT_SCREEN_HEIGHT, 0.01f * fDiagonal,
+                                                   10.0f * fDiagonal );
+
+        std::vector<UINT> Cut, PoolCut, CutIndices;
+        UINT64 uNumCutClusters = 0, uNumCutTriangles = 0, uNumCulled = 0;
+        double fSelectMs = 0.0, fPoolSelectMs = 0.0;
+        bool bSameCut = true, bWatertight = true;
+        for( UINT uView = 0; uView < NUM_VIEWS; uView++ )
+        {
+            // Once around, in and out twice
+            float fPhase = (float)uView / (float)NUM_VIEWS;
+            float fYaw = XM_2PI * fPhase;
+            float fDistance = MIN_DISTANCE + ( MAX_DISTANCE - MIN_DISTANCE ) * ( 0.5f + 0.5f * cosf( 2.0f * XM_2PI * fPhase ) );
+            XMVECTOR vOffset = XMVectorSet( sinf( fYaw ) * cosf( CAMERA_PITCH ), sinf( CAMERA_PITCH ), -cosf( fYaw ) * cosf( CAMERA_PITCH ), 0.0f );
+            XMMATRIX mView = XMMatrixLookAtLH( XMVectorAdd( vCenter, XMVectorScale( vOffset, fDistance * fDiagonal ) ), vCenter,
+                                               XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f ) );
+            PM_VIEW View;
+            InitProgressiveMeshView( XMMatrixIdentity(), mView, mProj, (float)ORBIT_SCREEN_HEIGHT, CLUSTER_PIXEL_ERROR, &View );
+
+            CLUSTER_CUT_STATS Stats;
+            fStart = GetTimeInMs();
+            for( UINT uPass = 0; uPass < NUM_SELECT_PASSES; uPass++ )
+            {
+                DAG.SelectCut( &View, true, NULL, &Cut, &Stats );
+            }
+            fSelectMs += ( GetTimeInMs() - fStart ) / NUM_SELECT_PASSES;
+            fStart = GetTimeInMs();
+            for( UINT uPass = 0; uPass < NUM_SELECT_PASSES; uPass++ )
+            {
+                DAG.SelectCut( &View, true, &Pool, &PoolCut, NULL );
+            }
+            fPoolSelectMs += ( GetTimeInMs() - fStart ) / NUM_SELECT_PASSES;
+            bSameCut = bSameCut && ( Cut == PoolCut );
+            uNumCutClusters += Stats.uNumClusters;
+            uNumCutTriangles += Stats.uNumTriangles;
+            uNumCulled += Stats.uNumCulled;
+
+            // Without culling the cut covers the whole surface with no crack
+            DAG.SelectCut( &View, false, &Pool, &Cut, NULL );
+            CutIndices.clear();
+            for( UINT i = 0; i < (UINT)Cut.size(); i++ )
+            {
+                const CLUSTER& Cluster = Clusters[Cut[i]];
+                CutIndices.insert( CutIndices.end(), DAG.GetIndices().begin() + Cluster.uFirstIndex,
+                                   DAG.GetIndices().begin() + Cluster.uFirstIndex + Cluster.uNumTriangles * 3 );
+            }
+            GetOddEdges( CutIndices, &CutEdges );
+            bWatertight = bWatertight && ( CutEdges == InputEdges );
+        }
+        if( !bSameCut )
+        {
+            HeadlessReport( L"%-32s the cut selected over the workers differs", g_pszBundledMeshes[uMesh] );
+            hr = E_FAIL;
+        }
+        if( !bWatertight )
+        {
+            HeadlessReport( L"%-32s a cut opens edges the input mesh does not have", g_pszBundledMeshes[uMesh] );
+            hr = E_FAIL;
+        }
+
+        double fBytes = (double)DAG.GetNumVertices() * sizeof( PN_VERTEX ) + (double)DAG.GetIndices().size() * sizeof( UINT ) +
+                        (double)Clusters.size() * sizeof( CLUSTER );
+        HeadlessReport( L"%-32s %6u %8u %10u %10u %10.1f %10.1f %8.1f %8.1f %9.1f %9.3f %9.3f %7.1f", g_pszBundledMeshes[uMesh],
+                        DAG.GetNumLevels(), (UINT)Clusters.size(), DAG.GetNumInputTriangles(), DAG.GetNumTriangles(), fBuildMs,
+                        fPoolBuildMs, fBytes / DAG.GetNumInputTriangles(), (double)uNumCutClusters / NUM_VIEWS,
+                        (double)uNumCutTriangles / NUM_VIEWS, fSelectMs / NUM_VIEWS, fPoolSelectMs / NUM_VIEWS,
+                        (double)uNumCulled / NUM_VIEWS );
+    }
+
+    // Build scaling over the workers
+    MESH_DATA Grid;
+    BuildSubdividedGrid( SCALING_GRID_SEGMENTS, &Grid );
+    CClusterDAG SerialDAG;
+    double fSerialMs = DBL_MAX;
+    for( UINT uBuild = 0; uBuild < NUM_SCALING_BUILDS; uBuild++ )
+    {
+        double fStart = GetTimeInMs();
+        if( FAILED( SerialDAG.Build( &Grid, NULL ) ) )
+        {
+            HeadlessReport( L"Failed to build the DAG of the scaling grid" );
+            return E_FAIL;
+        }
+        fSerialMs = std::min( fSerialMs, GetTimeInMs() - fStart );
+    }
+
+    HeadlessReport( L"Build scaling on a %ux%u grid, %u triangles, %u levels, %.1f ms on one thread", SCALING_GRID_SEGMENTS,
+                    SCALING_GRID_SEGMENTS, (UINT)Grid.Indices.size() / 3, SerialDAG.GetNumLevels(), fSerialMs );
+    HeadlessReport( L"%8s %6s %10s %8s %10s", L"Workers", L"Nodes", L"Build ms", L"Speedup", L"Efficiency" );
+
+    std::vector<SCALING_POOL> ScalingPools;
+    GetScalingPools( &ScalingPools );
+    for( UINT i = 0; i < (UINT)ScalingPools.size(); i++ )
+    {
+        CNumaTaskPool ScalingPool;
+        if( FAILED( ScalingPool.Create( ScalingPools[i].uMaxNodes, ScalingPools[i].uMaxWorkersPerNode ) ) )
+        {
+            HeadlessReport( L"Failed to start the workers" );
+            hr = E_FAIL;
+            continue;
+        }
+
+        CClusterDAG ScaledDAG;
+        double fScaledMs = DBL_MAX;
+        bool bSameDAG = true;
+        for( UINT uBuild = 0; uBuild < NUM_SCALING_BUILDS; uBuild++ )
+        {
+            double fStart = GetTimeInMs();
+            HRESULT hrBuild = ScaledDAG.Build( &Grid, &ScalingPool );
+            fScaledMs = std::min( fScaledMs, GetTimeInMs() - fStart );
+            bSameDAG = bSameDAG && SUCCEEDED( hrBuild ) && IsSameClusterDAG( ScaledDAG, SerialDAG );
+        }
+
+        double fSpeedup = fSerialMs / std::max( fScaledMs, 1.0e-3 );
+        HeadlessReport( L"%8u %6u %10.1f %7.2fx %9.0f%%", ScalingPool.GetNumWorkers(), ScalingPool.GetNumNodes(), fScaledMs, fSpeedup,
+                        100.0 * fSpeedup / ScalingPool.GetNumWorkers() );
+        if( !bSameDAG )
+        {
+            HeadlessReport( L"The DAG of the scaling grid built over %u workers differs", ScalingPool.GetNumWorkers() );
+            hr = E_FAIL;
+        }
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Triangles bucketed in a uniform grid, for the distance of points to a surface
+//--------------------------------------------------------------------------------------
+struct SURFACE_GRID
+{
+    const MESH_DATA*                        pSurface;
+    XMFLOAT3                                f3Min;
+    float                                   fCellSize;
+    UINT                                    uNumCells[3];
+    std::vector< std::pair<UINT64, UINT> >  Cells;      // Cell key and triangle, sorted
+};
+
+// What each task of the distance measure does with its points
+struct SURFACE_DISTANCE_CONTEXT
+{
+    const SURFACE_GRID*     pGrid;
+    const PN_VERTEX*        pPoints;
+    UINT                    uNumPoints;
+    double*                 pfTaskMax;
+    double*                 pfTaskSum;
+};
+
+// Points measured per worker task
+static const UINT SURFACE_DISTANCE_TASK_POINTS = 4096;
+
+// An edge by the welded positions of its ends, lowest first
+struct POSITION_EDGE
+{
+    UINT    uA;
+    UINT    uB;
+
+    bool operator<( const POSITION_EDGE& Other ) const
+    {
+        return ( uA != Other.uA ) ? uA < Other.uA : uB < Other.uB;
+    }
+    bool operator==( const POSITION_EDGE& Other ) const
+    {
+        return uA == Other.uA && uB == Other.uB;
+    }
+};
+
+// Orders positions by their bits
+struct POSITION_LESS
+{
+    bool operator()( const XMFLOAT3& f3A, const XMFLOAT3& f3B ) const
+    {
+        return memcmp( &f3A, &f3B, sizeof( XMFLOAT3 ) ) < 0;
+    }
+};
+
+// Orders vertices by all their attributes
+struct PN_VERTEX_LESS
+{
+    bool operator()( const PN_VERTEX& A, const PN_VERTEX& B ) const
+    {
+        return memcmp( &A, &B, sizeof( PN_VERTEX ) ) < 0;
+    }
+};
+
+
+//--------------------------------------------------------------------------------------
+// Returns the key of a grid cell
+//--------------------------------------------------------------------------------------
+static UINT64 GetSurfaceGridKey( const SURFACE_GRID* pGrid, UINT uX, UINT uY, UINT uZ )
+{
+    return ( (UINT64)uZ * pGrid->uNumCells[1] + uY ) * pGrid->uNumCells[0] + uX;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Buckets the triangles of a surface into the cells their boxes overlap, with cells as
+// large as the mean triangle box, so each triangle lands in a handful of cells however
+// long or unevenly sized the triangles are
+//--------------------------------------------------------------------------------------
+static void InitSurfaceGrid( const MESH_DATA* pSurface, SURFACE_GRID* pGrid )
+{
+    UINT uNumTriangles = (UINT)pSurface->Indices.size() / 3;
+    double fExtentSum = 0.0;
+    for( UINT t = 0; t < uNumTriangles; t++ )
+    {
+        XMVECTOR vA = XMLoadFloat3( &pSurface->Vertices[pSurface->Indices[t * 3 + 0]].f3Position );
+        XMVECTOR vB = XMLoadFloat3( &pSurface->Vertices[pSurface->Indices[t * 3 + 1]].f3Position );
+        XMVECTOR vC = XMLoadFloat3( &pSurface->Vertices[pSurface->Indices[t * 3 + 2]].f3Position );
+        XMFLOAT3 f3Extent;
+        XMStoreFloat3( &f3Extent, XMVectorSubtract( XMVectorMax( XMVectorMax( vA, vB ), vC ), XMVectorMin( XMVectorMin( vA, vB ), vC ) ) );
+        fExtentSum += std::max( std::max( f3Extent.x, f3Extent.y ), f3Extent.z );
+    }
+    float fDiagonal = GetMeshDataBoundsDiagonal( pSurface );
+    pGrid->pSurface = pSurface;
+    pGrid->f3Min = pSurface->f3BoundsMin;
+    pGrid->fCellSize = std::max( (float)( fExtentSum / std::max( uNumTriangles, 1u ) ), std::max( fDiagonal / 1024.0f, 1.0e-6f ) );
+    XMFLOAT3 f3Extent;
+    XMStoreFloat3( &f3Extent, XMVectorSubtract( XMLoadFloat3( &pSurface->f3BoundsMax ), XMLoadFloat3( &pSurface->f3BoundsMin ) ) );
+    pGrid->uNumCells[0] = (UINT)( f3Extent.x / pGrid->fCellSize ) + 1;
+    pGrid->uNumCells[1] = (UINT)( f3Extent.y / pGrid->fCellSize ) + 1;
+    pGrid->uNumCells[2] = (UINT)( f3Extent.z / pGrid->fCellSize ) + 1;
+
+    pGrid->Cells.clear();
+    for( UINT t = 0; t < uNumTriangles; t++ )
+    {
+        XMVECTOR vMin = XMVectorReplicate( FLT_MAX );
+        XMVECTOR vMax = XMVectorReplicate( -FLT_MAX );
+        for( UINT c = 0; c < 3; c++ )
+        {
+            XMVECTOR vPosition = XMLoadFloat3( &pSurface->Vertices[pSurface->Indices[t * 3 + c]].f3Position );
+            vMin = XMVectorMin( vMin, vPosition );
+            vMax = XMVectorMax( vMax, vPosition );
+        }
+        XMVECTOR vOrigin = XMLoadFloat3( &pGrid->f3Min );
+        float fScale = 1.0f / pGrid->fCellSize;
+        XMFLOAT3 f3First, f3Last;
+        XMStoreFloat3( &f3First, XMVectorScale( XMVectorSubtract( vMin, vOrigin ), fScale ) );
+        XMStoreFloat3( &f3Last, XMVectorScale( XMVectorSubtract( vMax, vOrigin ), fScale ) );
+        UINT uFirst[3] = { std::min( (UINT)std::max( f3First.x, 0.0f ), pGrid->uNumCells[0] - 1 ),
+                           std::min( (UINT)std::max( f3First.y, 0.0f ), pGrid->uNumCells[1] - 1 ),
+                           std::min( (UINT)std::max( f3First.z, 0.0f ), pGrid->uNumCells[2] - 1 ) };
+        UINT uLast[3] = { std::min( (UINT)std::max( f3Last.x, 0.0f ), pGrid->uNumCells[0] - 1 ),
+                          std::min( (UINT)std::max( f3Last.y, 0.0f ), pGrid->uNumCells[1] - 1 ),
+                          std::min( (UINT)std::max( f3Last.z, 0.0f ), pGrid->uNumCells[2] - 1 ) };
+        for( UINT z = uFirst[2]; z <= uLast[2]; z++ )
+        {
+            for( UINT y = uFirst[1]; y <= uLast[1]; y++ )
+            {
+                for( UINT x = uFirst[0]; x <= uLast[0]; x++ )
+                {
+                    pGrid->Cells.push_back( std::make_pair( GetSurfaceGridKey( pGrid, x, y, z ), t ) );
+                }
+            }
+        }
+    }
+    std::sort( pGrid->Cells.begin(), pGrid->Cells.end() );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the distance of a point to the surface of a grid. The cells are searched in
+// growing shells around the point's, until the nearest triangle found is closer than any
+// triangle of the next shell can be.
+//--------------------------------------------------------------------------------------
+static float GetSurfaceDistance( const SURFACE_GRID* pGrid, FXMVECTOR vPoint )
+{
+    const MESH_DATA* pSurface = pGrid->pSurface;
+    XMFLOAT3 f3Cell;
+    XMStoreFloat3( &f3Cell, XMVectorScale( XMVectorSubtract( vPoint, XMLoadFloat3( &pGrid->f3Min ) ), 1.0f / pGrid->fCellSize ) );
+    int iCell[3] = { (int)floorf( f3Cell.x ), (int)floorf( f3Cell.y ), (int)floorf( f3Cell.z ) };
+    int iMaxShell = (int)std::max( std::max( pGrid->uNumCells[0], pGrid->uNumCells[1] ), pGrid->uNumCells[2] ) +
+                    std::max( std::max( abs( iCell[0] ), abs( iCell[1] ) ), abs( iCell[2] ) );
+
+    float fBestSq = FLT_MAX;
+    for( int iShell = 0; iShell <= iMaxShell; iShell++ )
+    {
+        // Any triangle of a cell of this shell is at least iShell - 1 cells away
+        float fReach = (float)std::max( iShell - 1, 0 ) * pGrid->fCellSize;
+        if( fBestSq <= fReach * fReach )
+        {
+            break;
+        }
+        for( int z = iCell[2] - iShell; z <= iCell[2] + iShell; z++ )
+        {
+            for( int y = iCell[1] - iShell; y <= iCell[1] + iShell; y++ )
+            {
+                for( int x = iCell[0] - iShell; x <= iCell[0] + iShell; x++ )
+                {
+                    bool bOnShell = abs( x - iCell[0] ) == iShell || abs( y - iCell[1] ) == iShell || abs( z - iCell[2] ) == iShell;
+                    if( !bOnShell || x < 0 || y < 0 || z < 0 || x >= (int)pGrid->uNumCells[0] || y >= (int)pGrid->uNumCells[1] ||
+                        z >= (int)pGrid->uNumCells[2] )
+                    {
+                        continue;
+                    }
+                    UINT64 uKey = GetSurfaceGridKey( pGrid, (UINT)x, (UINT)y, (UINT)z );
+                    std::vector< std::pair<UINT64, UINT> >::const_iterator it =
+                        std::lower_bound( pGrid->Cells.begin(), pGrid->Cells.end(), std::make_pair( uKey, 0u ) );
+                    for( ; it != pGrid->Cells.end() && it->first == uKey; ++it )
+                    {
+                        const UINT* pTri = &pSurface->Indices[it->second * 3];
+                        fBestSq = std::min( fBestSq, GetPointTriangleDistanceSq( vPoint, XMLoadFloat3( &pSurface->Vertices[pTri[0]].f3Position ),
+                                                                                 XMLoadFloat3( &pSurface->Vertices[pTri[1]].f3Position ),
+                                                                                 XMLoadFloat3( &pSurface->Vertices[pTri[2]].f3Position ) ) );
+                    }
+                }
+            }
+        }
+    }
+
+    return sqrtf( fBestSq );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Measures the distance of one task's points to the surface
+//--------------------------------------------------------------------------------------
+static void SurfaceDistanceTask( void* pContext, UINT uTask, UINT uWorker )
+{
+    UNREFERENCED_PARAMETER( uWorker );
+
+    const SURFACE_DISTANCE_CONTEXT* pDistance = (const SURFACE_DISTANCE_CONTEXT*)pContext;
+    UINT uFirst = uTask * SURFACE_DISTANCE_TASK_POINTS;
+    UINT uEnd = std::min( uFirst + SURFACE_DISTANCE_TASK_POINTS, pDistance->uNumPoints );
+    double fMax = 0.0, fSum = 0.0;
+    for( UINT p = uFirst; p < uEnd; p++ )
+    {
+        double fDistance = GetSurfaceDistance( pDistance->pGrid, XMLoadFloat3( &pDistance->pPoints[p].f3Position ) );
+        fMax = std::max( fMax, fDistance );
+        fSum += fDistance;
+    }
+    pDistance->pfTaskMax[uTask] = fMax;
+    pDistance->pfTaskSum[uTask] = fSum;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the largest and the mean distance of the vertices of pPoints to the triangles of
+// pSurface, relative to the bounds diagonal of pPoints
+//--------------------------------------------------------------------------------------
+static void MeasureSurfaceDistance( const MESH_DATA* pPoints, const MESH_DATA* pSurface, CNumaTaskPool* pPool, double* pfMax, double* pfMean )
+{
+    SURFACE_GRID Grid;
+    InitSurfaceGrid( pSurface, &Grid );
+
+    UINT uNumPoints = (UINT)pPoints->Vertices.size();
+    UINT uNumTasks = ( uNumPoints + SURFACE_DISTANCE_TASK_POINTS - 1 ) / SURFACE_DISTANCE_TASK_POINTS;
+    std::vector<double> TaskMax( uNumTasks ), TaskSum( uNumTasks );
+    SURFACE_DISTANCE_CONTEXT Context = { &Grid, &pPoints->Vertices[0], uNumPoints, &TaskMax[0], &TaskSum[0] };
+    pPool->Run( SurfaceDistanceTask, &Context, uNumTasks, NULL, true );
+
+    double fDiagonal = GetMeshDataBoundsDiagonal( pPoints );
+    *pfMax = 0.0;
+    *pfMean = 0.0;
+    for( UINT uTask = 0; uTask < uNumTasks; uTask++ )
+    {
+        *pfMax = std::max( *pfMax, TaskMax[uTask] );
+        *pfMean += TaskSum[uTask];
+    }
+    *pfMax /= fDiagonal;
+    *pfMean /= fDiagonal * std::max( uNumPoints, 1u );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Fills pEdges with the edges of a subset used an odd number of times, by the welded
+// positions of its vertices in Welded, so the seams count as closed, sorted. A crack
+// along a seam would add to them.
+//--------------------------------------------------------------------------------------
+static void GetSubsetOpenEdges( const MESH_DATA* pMeshData, UINT uSubset, const std::vector<UINT>& Welded, std::vector<POSITION_EDGE>* pEdges )
+{
+    const MESH_DATA_SUBSET& Subset = pMeshData->Subsets[uSubset];
+    std::vector<POSITION_EDGE> Edges;
+    for( UINT i = Subset.uIndexStart; i + 2 < Subset.uIndexStart + Subset.uIndexCount; i += 3 )
+    {
+        for( UINT c = 0; c < 3; c++ )
+        {
+            UINT uA = Welded[pMeshData->Indices[i + c]];
+            UINT uB = Welded[pMeshData->Indices[i + ( c + 1 ) % 3]];
+            POSITION_EDGE Edge = { std::min( uA, uB ), std::max( uA, uB ) };
+            Edges.push_back( Edge );
+        }
+    }
+    std::sort( Edges.begin(), Edges.end() );
+
+    pEdges->clear();
+    for( UINT i = 0; i < (UINT)Edges.size(); )
+    {
+        UINT uEnd = i + 1;
+        while( uEnd < (UINT)Edges.size() && Edges[uEnd] == Edges[i] )
+        {
+            uEnd++;
+        }
+        if( 0 != ( uEnd - i ) % 2 && Edges[i].uA != Edges[i].uB )
+        {
+            pEdges->push_back( Edges[i] );
+        }
+        i = uEnd;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Welds pairs of positions either side of a corner of a grid of the tolerance, in each of
+// the 13 directions through it, and counts the pairs closer than the tolerance that are
+// joined and those farther that are kept apart. The corners are at whole and at half
+// cells, so the close pairs straddle cell boundaries whether positions are floored to the
+// grid, as the weld's search is, or rounded to it, as the weld did before it searched the
+// neighbouring cells and left such pairs apart.
+//--------------------------------------------------------------------------------------
+static void CheckWeldAcrossCells( UINT* puNumJoined, UINT* puNumApart, UINT* puNumPairs )
+{
+    // A power of two, so the corners of the grid are exact
+    static const float TOLERANCE = 1.0f / 1024.0f;
+    static const float CLOSE_DISTANCE = 0.6f * TOLERANCE;
+    static const float FAR_DISTANCE = 1.2f * TOLERANCE;
+
+    std::vector<XMFLOAT3> Directions;
+    for( int iZ = -1; iZ <= 1; iZ++ )
+    {
+        for( int iY = -1; iY <= 1; iY++ )
+        {
+            for( int iX = -1; iX <= 1; iX++ )
+            {
+                // One of each opposite pair
+                int iFirst = ( 0 != iX ) ? iX : ( ( 0 != iY ) ? iY : iZ );
+                if( iFirst > 0 )
+                {
+                    Directions.push_back( XMFLOAT3( (float)iX, (float)iY, (float)iZ ) );
+                }
+            }
+        }
+    }
+
+    // Each pair around its own corner, corners 8 cells apart and some at negative coords.
+    // The first half of the pairs are close, every other pair is at half cells.
+    MESH_DATA Pairs;
+    ZeroMemory( &Pairs.f3BoundsMin, sizeof( Pairs.f3BoundsMin ) );
+    ZeroMemory( &Pairs.f3BoundsMax, sizeof( Pairs.f3BoundsMax ) );
+    *puNumPairs = 2 * (UINT)Directions.size();
+    for( UINT uPair = 0; uPair < 2 * *puNumPairs; uPair++ )
+    {
+        float fDistance = ( uPair < *puNumPairs ) ? CLOSE_DISTANCE : FAR_DISTANCE;
+        float fCell = 8.0f * uPair + 0.5f * ( uPair % 2 );
+        XMVECTOR vCorner = XMVectorScale( XMVectorSet( fCell - 200.0f, fCell - 8.0f * ( uPair % 7 ), 40.0f - fCell, 0.0f ), TOLERANCE );
+        XMVECTOR vHalf = XMVectorScale( XMVector3Normalize( XMLoadFloat3( &Directions[( uPair / 2 ) % Directions.size()] ) ), 0.5f * fDistance );
+        PN_VERTEX Vertex;
+        ZeroMemory( &Vertex, sizeof( Vertex ) );
+        XMStoreFloat3( &Vertex.f3Position, XMVectorSubtract( vCorner, vHalf ) );
+        Pairs.Vertices.push_back( Vertex );
+        XMStoreFloat3( &Vertex.f3Position, XMVectorAdd( vCorner, vHalf ) );
+        Pairs.Vertices.push_back( Vertex );
+    }
+
+    std::vector<UINT> Welded;
+    std::vector<XMFLOAT3> Positions;
+    WeldPositionsWithinTolerance( &Pairs, TOLERANCE, &Welded, &Positions );
+
+    *puNumJoined = 0;
+    *puNumApart = 0;
+    for( UINT uPair = 0; uPair < 2 * *puNumPairs; uPair++ )
+    {
+        bool bJoined = Welded[uPair * 2] == Welded[uPair * 2 + 1];
+        if( uPair < *puNumPairs )
+        {
+            *puNumJoined += bJoined ? 1 : 0;
+        }
+        else
+        {
+            *puNumApart += bJoined ? 0 : 1;
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Makes a dense mesh of each bundled mesh by baking its PN-Triangles surface, and
+// simplifies it back to a base mesh the size of the bundled one, on one thread and over
+// the workers. The base mesh is written to the output directory as <name>_qem.sdkmesh. Reports
+// the triangles, vertices and times, and how far the dense surface is from the flat base
+// triangles and from their PN-Triangles surface, which is what the sample draws, beside
+// the bundled base mesh's own flat distance. Both runs must match, the written mesh must
+// load back the same, every subset must keep its outline without cracking along its UV
+// seams and creases, and every vertex must be one of the dense mesh. First checks that
+// the weld joins positions within its tolerance across the cells of its grid (see
+// CheckWeldAcrossCells).
+//
+// Then simplifies a synthetic grid far denser than the bundled meshes to 1/64 of its
+// triangles with 1, 2, 4... workers (see GetScalingPools) and reports the time, speedup
+// and efficiency against one thread. The runs of SIMPLIFY_TASK_TRIANGLES go over the
+// workers, but the weld, the Morton order and the last pass over each subset run on one
+// thread each, and the grid is one subset, so the speedup levels off well below the
+// number of workers. Every result must match the one thread one.
+// Param: the triangles of the base mesh, as a share of the bundled mesh's (default 1)
+//--------------------------------------------------------------------------------------
+HRESULT RunSimplifyTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const float DENSE_TESS_FACTOR = 9.0f;
+    static const float RECONSTRUCTION_TESS_FACTOR = 9.0f;
+    static const UINT SCALING_GRID_SEGMENTS = 512;
+    static const float SCALING_RATIO = 1.0f / 64.0f;
+    static const UINT NUM_SCALING_RUNS = 3;         // The fastest counts
+
+    float fShare = ( 0 != pszParam[0] ) ? (float)_wtof( pszParam ) : 1.0f;
+    if( !( fShare > 0.0f ) )
+    {
+        HeadlessReport( L"Expected a share of the triangles over 0, got %s", pszParam );
+        return E_INVALIDARG;
+    }
+
+    CNumaTaskPool Pool;
+    if( FAILED( Pool.Create( 0, 0 ) ) )
+    {
+        HeadlessReport( L"Failed to start the workers" );
+        return E_FAIL;
+    }
+
+    UINT uNumJoined, uNumApart, uNumPairs;
+    CheckWeldAcrossCells( &uNumJoined, &uNumApart, &uNumPairs );
+    HeadlessReport( L"Weld across grid cells: %u of %u close pairs joined, %u of %u far pairs kept apart", uNumJoined, uNumPairs,
+                    uNumApart, uNumPairs );
+    if( uNumJoined != uNumPairs || uNumApart != uNumPairs )
+    {
+        HeadlessReport( L"The weld does not join exactly the positions within its tolerance" );
+        hr = E_FAIL;
+    }
+
+    HeadlessReport( L"Dense mesh baked at tess factor %.1f, simplified to %.2fx the bundled triangles in runs of %u, PN-Triangles rebuilt at %.1f, %u workers",
+                    DENSE_TESS_FACTOR, fShare, SIMPLIFY_TASK_TRIANGLES, RECONSTRUCTION_TESS_FACTOR, Pool.GetNumWorkers() );
+    HeadlessReport( L"Distances from the dense surface in %% of the diagonal, max / mean" );
+    HeadlessReport( L"%-32s %10s %9s %8s %6s %9s %8s %15s %15s %15s", L"Mesh", L"Dense tris", L"Base tris", L"Vertices", L"Tasks",
+                    L"Serial ms", L"Pool ms", L"Flat", L"PN-Triangles", L"Bundled flat" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        CDXUTSDKMesh SourceMesh;
+        MESH_DATA Source;
+        if( FAILED( LoadBundledMesh( uMesh, &Source, &SourceMesh ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        MESH_DATA Dense, Base, PoolBase;
+        MESH_BAKE_STATS BakeStats;
+        MESH_SIMPLIFY_STATS Stats;
+        HRESULT hrSimplify = BakeTessellatedMeshData( &Source, CPU_TESS_PN_TRIANGLES, DENSE_TESS_FACTOR, &Dense, &BakeStats );
+        float fRatio = std::min( fShare * (float)Source.Indices.size() / (float)std::max( Dense.Indices.size(), (size_t)1 ), 1.0f );
+        double fStart = GetTimeInMs();
+        hrSimplify = SUCCEEDED( hrSimplify ) ? SimplifyMeshData( &Dense, fRatio, NULL, &Base, &Stats ) : hrSimplify;
+        double fSerialMs = GetTimeInMs() - fStart;
+        fStart = GetTimeInMs();
+        hrSimplify = SUCCEEDED( hrSimplify ) ? SimplifyMeshData( &Dense, fRatio, &Pool, &PoolBase, NULL ) : hrSimplify;
+        double fPoolMs = GetTimeInMs() - fStart;
+
+        WCHAR szFileName[MAX_PATH];
+        GetOutputMeshFileName( g_pszBundledMeshes[uMesh], L"_qem", szFileName, _countof( szFileName ) );
+
+        MESH_DATA Written;
+        if( FAILED( hrSimplify ) || FAILED( WriteSDKMesh( szFileName, &SourceMesh, &Base ) ) || FAILED( LoadMeshData( szFileName, &Written ) ) ||
+            !IsSameMeshData( &Base, &Written ) )
+        {
+            HeadlessReport( L"%-32s failed to simplify or write %s", g_pszBundledMeshes[uMesh], szFileName );
+            SourceMesh.Destroy();
+            hr = E_FAIL;
+            continue;
+        }
+        SourceMesh.Destroy();
+
+        if( PoolBase.Indices != Base.Indices || PoolBase.Vertices.size() != Base.Vertices.size() ||
+            0 != memcmp( &PoolBase.Vertices[0], &Base.Vertices[0], Base.Vertices.size() * sizeof( PN_VERTEX ) ) )
+        {
+            HeadlessReport( L"%-32s the mesh simplified over the workers differs", g_pszBundledMeshes[uMesh] );
+            hr = E_FAIL;
+        }
+
+        // The dense positions are welded as SimplifyMeshData welds them, and the vertices
+        // kept take the welded position of their copy in the dense mesh
+        std::vector<UINT> DenseWelded, BaseWelded( Base.Vertices.size() );
+        std::vector<XMFLOAT3> WeldedPositions;
+        float fTolerance = std::max( SIMPLIFY_WELD_TOLERANCE * GetMeshDataBoundsDiagonal( &Dense ), FLT_MIN );
+        WeldPositionsWithinTolerance( &Dense, fTolerance, &DenseWelded, &WeldedPositions );
+        std::map<XMFLOAT3, UINT, POSITION_LESS> DenseWeldedByPosition;
+        for( UINT v = 0; v < (UINT)Dense.Vertices.size(); v++ )
+        {
+            DenseWeldedByPosition.insert( std::make_pair( Dense.Vertices[v].f3Position, DenseWelded[v] ) );
+        }
+        for( UINT v = 0; v < (UINT)Base.Vertices.size(); v++ )
+        {
+            std::map<XMFLOAT3, UINT, POSITION_LESS>::const_iterator it = DenseWeldedByPosition.find( Base.Vertices[v].f3Position );
+            BaseWelded[v] = ( it != DenseWeldedByPosition.end() ) ? it->second : (UINT)WeldedPositions.size() + v;
+        }
+
+        std::vector<POSITION_EDGE> DenseEdges, BaseEdges;
+        bool bSameEdges = Dense.Subsets.size() == Base.Subsets.size();
+        for( UINT s = 0; s < (UINT)Dense.Subsets.size() && bSameEdges; s++ )
+        {
+            GetSubsetOpenEdges( &Dense, s, DenseWelded, &DenseEdges );
+            GetSubsetOpenEdges( &Base, s, BaseWelded, &BaseEdges );
+            bSameEdges = ( DenseEdges == BaseEdges );
+        }
+        if( !bSameEdges )
+        {
+            HeadlessReport( L"%-32s a subset changed its outline or cracked along a seam", g_pszBundledMeshes[uMesh] );
+            hr = E_FAIL;
+        }
+
+        // Every vertex kept is one of the dense mesh, normal and texture coords included
+        std::vector<PN_VERTEX> DenseVertices( Dense.Vertices );
+        std::sort( DenseVertices.begin(), DenseVertices.end(), PN_VERTEX_LESS() );
+        bool bKeptVertices = true;
+        for( UINT v = 0; v < (UINT)Base.Vertices.size() && bKeptVertices; v++ )
+        {
+            bKeptVertices = std::binary_search( DenseVertices.begin(), DenseVertices.end(), Base.Vertices[v], PN_VERTEX_LESS() );
+        }
+        if( !bKeptVertices )
+        {
+            HeadlessReport( L"%-32s a vertex is not one of the dense mesh", g_pszBundledMeshes[uMesh] );
+            hr = E_FAIL;
+        }
+
+        MESH_DATA Rebuilt;
+        double fFlatMax = 0.0, fFlatMean = 0.0, fPNMax = 0.0, fPNMean = 0.0, fSourceMax = 0.0, fSourceMean = 0.0;
+        MeasureSurfaceDistance( &Dense, &Base, &Pool, &fFlatMax, &fFlatMean );
+        if( SUCCEEDED( BakeTessellatedMeshData( &Base, CPU_TESS_PN_TRIANGLES, RECONSTRUCTION_TESS_FACTOR, &Rebuilt, &BakeStats ) ) )
+        {
+            MeasureSurfaceDistance( &Dense, &Rebuilt, &Pool, &fPNMax, &fPNMean );
+        }
+        MeasureSurfaceDistance( &Dense, &Source, &Pool, &fSourceMax, &fSourceMean );
+
+        WCHAR szFlat[32], szPN[32], szSource[32];
+        swprintf_s( szFlat, L"%.3f / %.4f", 100.0 * fFlatMax, 100.0 * fFlatMean );
+        swprintf_s( szPN, L"%.3f / %.4f", 100.0 * fPNMax, 100.0 * fPNMean );
+        swprintf_s( szSource, L"%.3f / %.4f", 100.0 * fSourceMax, 100.0 * fSourceMean );
+        HeadlessReport( L"%-32s %10u %9u %8u %6u %9.1f %8.1f %15s %15s %15s", g_pszBundledMeshes[uMesh], (UINT)Dense.Indices.size() / 3,
+                        (UINT)Base.Indices.size() / 3, (UINT)Base.Vertices.size(), Stats.uNumTasks, fSerialMs, fPoolMs, szFlat, szPN,
+                        szSource );
+    }
+
+    // Scaling over the workers
+    MESH_DATA Grid, SerialBase;
+    BuildSubdividedGrid( SCALING_GRID_SEGMENTS, &Grid );
+    double fSerialMs = DBL_MAX;
+    for( UINT uRun = 0; uRun < NUM_SCALING_RUNS; uRun++ )
+    {
+        double fStart = GetTimeInMs();
+        if( FAILED( SimplifyMeshData( &Grid, SCALING_RATIO, NULL, &SerialBase, NULL ) ) )
+        {
+            HeadlessReport( L"Failed to simplify the scaling grid" );
+            return E_FAIL;
+        }
+        fSerialMs = std::min( fSerialMs, GetTimeInMs() - fStart );
+    }
+
+    HeadlessReport( L"Scaling on a %ux%u grid, %u triangles simplified to %u, %.1f ms on one thread", SCALING_GRID_SEGMENTS,
+                    SCALING_GRID_SEGMENTS, (UINT)Grid.Indices.size() / 3, (UINT)SerialBase.Indices.size() / 3, fSerialMs );
+    HeadlessReport( L"%8s %6s %10s %8s %10s", L"Workers", L"Nodes", L"Time ms", L"Speedup", L"Efficiency" );
+
+    std::vector<SCALING_POOL> ScalingPools;
+    GetScalingPools( &ScalingPools );
+    for( UINT i = 0; i < (UINT)ScalingPools.size(); i++ )
+    {
+        CNumaTaskPool ScalingPool;
+        if( FAILED( ScalingPool.Create( ScalingPools[i].uMaxNodes, ScalingPools[i].uMaxWorkersPerNode ) ) )
+        {
+            HeadlessReport( L"Failed to start the workers" );
+            hr = E_FAIL;
+            continue;
+        }
+
+        MESH_DATA ScaledBase;
+        double fScaledMs = DBL_MAX;
+        bool bSameBase = true;
+        for( UINT uRun = 0; uRun < NUM_SCALING_RUNS; uRun++ )
+        {
+            double fStart = GetTimeInMs();
+            HRESULT hrSimplify = SimplifyMeshData( &Grid, SCALING_RATIO, &ScalingPool, &ScaledBase, NULL );
+            fScaledMs = std::min( fScaledMs, GetTimeInMs() - fStart );
+            bSameBase = bSameBase && SUCCEEDED( hrSimplify ) && ScaledBase.Indices == SerialBase.Indices &&
+                        ScaledBase.Vertices.size() == SerialBase.Vertices.size() &&
+                        0 == memcmp( &ScaledBase.Vertices[0], &SerialBase.Vertices[0], SerialBase.Vertices.size() * sizeof( PN_VERTEX ) );
+        }
+
+        double fSpeedup = fSerialMs / std::max( fScaledMs, 1.0e-3 );
+        HeadlessReport( L"%8u %6u %10.1f %7.2fx %9.0f%%", ScalingPool.GetNumWorkers(), ScalingPool.GetNumNodes(), fScaledMs, fSpeedup,
+                        100.0 * fSpeedup / ScalingPool.GetNumWorkers() );
+        if( !bSameBase )
+        {
+            HeadlessReport( L"The scaling grid simplified over %u workers differs", ScalingPool.GetNumWorkers() );
+            hr = E_FAIL;
+        }
+    }
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
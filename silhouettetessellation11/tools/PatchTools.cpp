@@ -0,0 +1,1284 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: PatchTools.cpp
+//
+// Tools of the patch data, its caches and output: packing error, partial updates, domain
+// evaluation, the tessellation cache, baked LODs, the output ring, patch order and world
+// space vertices.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "..\\..\\DXUT\\Optional\\SDKmesh.h"
+#include "HeadlessTools.h"
+#include "PatchPacking.h"
+#include "PatchData.h"
+#include "DomainEvaluator.h"
+#include "TessellationCache.h"
+#include "MeshBake.h"
+#include "SDKMeshWriter.h"
+#include "VertexCache.h"
+#include "TessOutputRing.h"
+#include "PatchOrder.h"
+#include "WorldSpaceVertices.h"
+#include <float.h>
+
+using namespace DirectX;
+
+
+//--------------------------------------------------------------------------------------
+// Measures the position and normal error of the packed patch constants (PACKED_CP) against
+// the full precision control points, over the bundled meshes.
+// Param: number of segments per edge of the evaluation grid (default 8)
+//--------------------------------------------------------------------------------------
+HRESULT RunPackErrorTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    UINT uSegments = ( pszParam[0] != 0 ) ? (UINT)_wtoi( pszParam ) : 8;
+    uSegments = std::max( uSegments, 1u );
+
+    HeadlessReport( L"Patch constants: %u bytes full precision, %u bytes packed (%.1f%%)",
+                    PN_PATCH_CONSTANT_BYTES, PACKED_PN_PATCH_CONSTANT_BYTES,
+                    100.0f * (float)PACKED_PN_PATCH_CONSTANT_BYTES / (float)PN_PATCH_CONSTANT_BYTES );
+    HeadlessReport( L"Bounds: position error <= %g x longest patch edge, normal error <= %g degrees",
+                    PATCH_PACKING_MAX_RELATIVE_POSITION_ERROR, PATCH_PACKING_MAX_NORMAL_ERROR_DEGREES );
+    HeadlessReport( L"%-32s %8s %10s %12s %12s %12s %10s %10s", L"Mesh", L"Patches", L"Samples",
+                    L"MaxPos", L"MeanPos", L"MaxPos/Edge", L"MaxNrm(deg)", L"MeanNrm" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        PATCH_PACKING_ERROR Error;
+        MeasurePatchPackingError( &MeshData, uSegments, &Error );
+
+        HeadlessReport( L"%-32s %8u %10u %12.3e %12.3e %12.3e %10.4f %10.4f", g_pszBundledMeshes[uMesh],
+                        Error.uNumPatches, Error.uNumSamples, Error.fMaxPositionError, Error.fMeanPositionError,
+                        Error.fMaxRelativePositionError, Error.fMaxNormalErrorDegrees, Error.fMeanNormalErrorDegrees );
+        if( Error.uNumDegeneratePatches > 0 )
+        {
+            HeadlessReport( L"%-32s %u degenerate patches skipped", L"", Error.uNumDegeneratePatches );
+        }
+
+        if( Error.fMaxRelativePositionError > PATCH_PACKING_MAX_RELATIVE_POSITION_ERROR ||
+            Error.fMaxNormalErrorDegrees > PATCH_PACKING_MAX_NORMAL_ERROR_DEGREES )
+        {
+            hr = E_FAIL;
+        }
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmarks incremental patch data updates against full rebuilds, for deformations of
+// 0% to 100% of the vertices of the bundled meshes. The deformed vertices are the ones
+// closest to a seed vertex, pushed along their normals by a wave that fades out towards
+// the edge of the region, so part of the region moves less than the dirty epsilon.
+// Param: number of frames per workload (default 100)
+//--------------------------------------------------------------------------------------
+HRESULT RunPatchUpdateTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const float DEFORMED_FRACTIONS[] = { 0.0f, 0.01f, 0.05f, 0.25f, 1.0f };
+    static const float AMPLITUDE = 0.01f;           // Of the bounds diagonal
+    static const float POSITION_EPSILON = 1.0e-4f;  // Of the bounds diagonal
+    static const float NORMAL_EPSILON = 1.0e-3f;
+
+    UINT uNumFrames = ( pszParam[0] != 0 ) ? (UINT)_wtoi( pszParam ) : 100;
+    uNumFrames = std::max( uNumFrames, 1u );
+
+    HeadlessReport( L"%u frames per workload, dirty epsilon %g x bounds diagonal, amplitude %g x bounds diagonal",
+                    uNumFrames, POSITION_EPSILON, AMPLITUDE );
+    HeadlessReport( L"%-32s %9s %9s %11s %11s %10s %10s %8s", L"Mesh", L"Deformed", L"Vertices",
+                    L"DirtyVerts", L"Rebuilt", L"Full(ms)", L"Incr(ms)", L"Speedup" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        UINT uNumVertices = (UINT)MeshData.Vertices.size();
+        float fDiagonal = GetMeshDataBoundsDiagonal( &MeshData );
+
+        // Order the vertices by distance from the seed
+        XMVECTOR vSeed = XMLoadFloat3( &MeshData.Vertices[uNumVertices / 2].f3Position );
+        std::vector< std::pair<float, UINT> > ByDistance( uNumVertices );
+        for( UINT v = 0; v < uNumVertices; v++ )
+        {
+            XMVECTOR vPosition = XMLoadFloat3( &MeshData.Vertices[v].f3Position );
+            ByDistance[v] = std::make_pair( XMVectorGetX( XMVector3Length( XMVectorSubtract( vPosition, vSeed ) ) ), v );
+        }
+        std::sort( ByDistance.begin(), ByDistance.end() );
+
+        for( UINT uWorkload = 0; uWorkload < ARRAYSIZE( DEFORMED_FRACTIONS ); uWorkload++ )
+        {
+            UINT uNumDeformed = (UINT)( DEFORMED_FRACTIONS[uWorkload] * (float)uNumVertices + 0.5f );
+            float fRadius = ( uNumDeformed > 0 ) ? std::max( ByDistance[uNumDeformed - 1].first, FLT_MIN ) : 1.0f;
+
+            CPatchData Incremental, Full;
+            if( FAILED( Incremental.Create( &MeshData, POSITION_EPSILON * fDiagonal, NORMAL_EPSILON ) ) ||
+                FAILED( Full.Create( &MeshData, POSITION_EPSILON * fDiagonal, NORMAL_EPSILON ) ) )
+            {
+                HeadlessReport( L"%-32s failed to create the patch data", g_pszBundledMeshes[uMesh] );
+                hr = E_FAIL;
+                break;
+            }
+
+            std::vector<PN_VERTEX> Deformed( MeshData.Vertices );
+            double fFullMs = 0.0, fIncrementalMs = 0.0;
+            UINT64 uDirtyVertices = 0, uDirtyPatches = 0;
+
+            for( UINT uFrame = 0; uFrame < uNumFrames; uFrame++ )
+            {
+                for( UINT i = 0; i < uNumDeformed; i++ )
+                {
+                    UINT v = ByDistance[i].second;
+                    float fFalloff = 1.0f - ByDistance[i].first / fRadius;
+                    float fOffset = AMPLITUDE * fDiagonal * fFalloff * sinf( 0.2f * (float)uFrame + 4.0f * ByDistance[i].first / fRadius );
+
+                    XMVECTOR vPosition = XMLoadFloat3( &MeshData.Vertices[v].f3Position );
+                    XMVECTOR vNormal = XMLoadFloat3( &MeshData.Vertices[v].f3Normal );
+                    XMStoreFloat3( &Deformed[v].f3Position, XMVectorAdd( vPosition, XMVectorScale( vNormal, fOffset ) ) );
+                }
+
+                double fStart = GetTimeInMs();
+                Full.RebuildAll( &Deformed[0] );
+                fFullMs += GetTimeInMs() - fStart;
+
+                fStart = GetTimeInMs();
+                Incremental.Update( &Deformed[0] );
+                fIncrementalMs += GetTimeInMs() - fStart;
+
+                uDirtyVertices += Incremental.GetNumDirtyVertices();
+                uDirtyPatches += Incremental.GetNumDirtyPatches();
+            }
+
+            // The incremental data must match a full build from the same baked vertices
+            MESH_DATA Baked = MeshData;
+            memcpy( &Baked.Vertices[0], Incremental.GetVertices(), uNumVertices * sizeof( PN_VERTEX ) );
+            CPatchData Reference;
+            Reference.Create( &Baked, 0.0f, 0.0f );
+            bool bMatch = ( Reference.GetNumPatches() == Incremental.GetNumPatches() );
+            for( UINT uPatch = 0; bMatch && uPatch < Incremental.GetNumPatches(); uPatch++ )
+            {
+                bMatch = ( memcmp( Reference.GetPatch( uPatch ), Incremental.GetPatch( uPatch ), sizeof( PATCH_DATA ) ) == 0 );
+            }
+
+            HeadlessReport( L"%-32s %8.1f%% %9u %11.1f %11.1f %10.4f %10.4f %7.1fx%s", g_pszBundledMeshes[uMesh],
+                            100.0f * DEFORMED_FRACTIONS[uWorkload], uNumDeformed,
+                            (double)uDirtyVertices / uNumFrames, (double)uDirtyPatches / uNumFrames,
+                            fFullMs / uNumFrames, fIncrementalMs / uNumFrames,
+                            fFullMs / std::max( fIncrementalMs, 1.0e-6 ), bMatch ? L"" : L"  MISMATCH" );
+            if( !bMatch )
+            {
+                hr = E_FAIL;
+            }
+        }
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmarks forward differenced domain evaluation against direct evaluation, over all the
+// patches of the bundled meshes at uniform tess factors 3 to 15, and checks the forward
+// differenced points stay close to the direct ones.
+// Param: number of timed passes per factor, the fastest is reported (default 4)
+//--------------------------------------------------------------------------------------
+HRESULT RunDomainEvalTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const float MAX_RELATIVE_POSITION_ERROR = 1.0e-4f;   // Of the longest patch edge
+    static const float MAX_NORMAL_ERROR_DEGREES = 0.01f;
+
+    UINT uNumPasses = ( pszParam[0] != 0 ) ? (UINT)_wtoi( pszParam ) : 4;
+    uNumPasses = std::max( uNumPasses, 1u );
+
+    // Gather the patches of all the meshes
+    std::vector<PN_VERTEX> Corners;
+    std::vector<PN_CONTROL_POINTS> ControlPoints;
+    std::vector<float> LongestEdges;
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        for( UINT i = 0; i + 2 < (UINT)MeshData.Indices.size(); i += 3 )
+        {
+            PN_VERTEX Patch[3];
+            float fLongestEdge = 0.0f;
+            for( UINT c = 0; c < 3; c++ )
+            {
+                Patch[c] = MeshData.Vertices[MeshData.Indices[i + c]];
+            }
+            for( UINT c = 0; c < 3; c++ )
+            {
+                XMVECTOR vEdge = XMVectorSubtract( XMLoadFloat3( &Patch[( c + 1 ) % 3].f3Position ), XMLoadFloat3( &Patch[c].f3Position ) );
+                fLongestEdge = std::max( fLongestEdge, XMVectorGetX( XMVector3Length( vEdge ) ) );
+            }
+
+            PN_CONTROL_POINTS PatchControlPoints;
+            ComputePNControlPoints( Patch, &PatchControlPoints );
+
+            // Patches the HS would produce NaNs for are not worth timing
+            if( !( fLongestEdge > 0.0f ) || !_finite( PatchControlPoints.f3N110.x + PatchControlPoints.f3N011.x + PatchControlPoints.f3N101.x ) )
+            {
+                continue;
+            }
+
+            Corners.insert( Corners.end(), Patch, Patch + 3 );
+            ControlPoints.push_back( PatchControlPoints );
+            LongestEdges.push_back( fLongestEdge );
+        }
+    }
+
+    UINT uNumPatches = (UINT)ControlPoints.size();
+    HeadlessReport( L"%u patches, %u passes per factor, reseed every %u points", uNumPatches, uNumPasses, FORWARD_DIFFERENCE_RESEED_INTERVAL );
+    HeadlessReport( L"%6s %8s %8s %12s %12s %8s %12s %11s", L"Factor", L"Points", L"FD%", L"Direct(ns)", L"FD(ns)",
+                    L"Speedup", L"MaxPos/Edge", L"MaxNrm(deg)" );
+    if( 0 == uNumPatches )
+    {
+        return E_FAIL;
+    }
+
+    for( UINT uFactor = 3; uFactor <= 15; uFactor++ )
+    {
+        float fFactors[3] = { (float)uFactor, (float)uFactor, (float)uFactor };
+        TRI_TESSELLATION Tessellation;
+        TessellateTri( fFactors, (float)uFactor, &Tessellation );
+
+        UINT uNumPoints = (UINT)Tessellation.DomainPoints.size();
+        UINT uNumDifferenced = 0;
+        for( UINT uRow = 0; uRow < (UINT)Tessellation.Rows.size(); uRow++ )
+        {
+            if( Tessellation.Rows[uRow].uNumPoints < FORWARD_DIFFERENCE_MIN_ROW_POINTS )
+            {
+                continue;
+            }
+            for( UINT uPoint = 0; uPoint < Tessellation.Rows[uRow].uNumPoints; uPoint++ )
+            {
+                uNumDifferenced += ( uPoint % FORWARD_DIFFERENCE_RESEED_INTERVAL != 0 ) ? 1 : 0;
+            }
+        }
+
+        std::vector<XMFLOAT3> Positions( uNumPoints ), Normals( uNumPoints );
+        std::vector<XMFLOAT3> ReferencePositions( uNumPoints ), ReferenceNormals( uNumPoints );
+
+        // Keep the fastest pass of each, the others are more likely to be disturbed
+        double fDirectMs = DBL_MAX, fForwardDifferenceMs = DBL_MAX;
+        for( UINT uPass = 0; uPass < uNumPasses; uPass++ )
+        {
+            double fStart = GetTimeInMs();
+            for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+            {
+                EvaluatePNTessellation( &Corners[uPatch * 3], &ControlPoints[uPatch], &Tessellation, &Positions[0], &Normals[0] );
+            }
+            fDirectMs = std::min( fDirectMs, GetTimeInMs() - fStart );
+
+            fStart = GetTimeInMs();
+            for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+            {
+                EvaluatePNTessellationForwardDifference( &Corners[uPatch * 3], &ControlPoints[uPatch], &Tessellation, &Positions[0], &Normals[0] );
+            }
+            fForwardDifferenceMs = std::min( fForwardDifferenceMs, GetTimeInMs() - fStart );
+        }
+
+        float fMaxRelativePositionError = 0.0f;
+        float fMaxNormalErrorDegrees = 0.0f;
+        for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+        {
+            EvaluatePNTessellation( &Corners[uPatch * 3], &ControlPoints[uPatch], &Tessellation, &ReferencePositions[0], &ReferenceNormals[0] );
+            EvaluatePNTessellationForwardDifference( &Corners[uPatch * 3], &ControlPoints[uPatch], &Tessellation, &Positions[0], &Normals[0] );
+
+            for( UINT uPoint = 0; uPoint < uNumPoints; uPoint++ )
+            {
+                XMVECTOR vDelta = XMVectorSubtract( XMLoadFloat3( &Positions[uPoint] ), XMLoadFloat3( &ReferencePositions[uPoint] ) );
+                fMaxRelativePositionError = std::max( fMaxRelativePositionError, XMVectorGetX( XMVector3Length( vDelta ) ) / LongestEdges[uPatch] );
+
+                XMVECTOR vNormal = XMLoadFloat3( &Normals[uPoint] );
+                XMVECTOR vReferenceNormal = XMLoadFloat3( &ReferenceNormals[uPoint] );
+                float fSin = XMVectorGetX( XMVector3Length( XMVector3Cross( vNormal, vReferenceNormal ) ) );
+                float fCos = XMVectorGetX( XMVector3Dot( vNormal, vReferenceNormal ) );
+                fMaxNormalErrorDegrees = std::max( fMaxNormalErrorDegrees, XMConvertToDegrees( atan2f( fSin, fCos ) ) );
+            }
+        }
+
+        double fNumEvaluated = (double)uNumPatches * uNumPoints;
+        HeadlessReport( L"%6u %8u %7.1f%% %12.2f %12.2f %7.2fx %12.3e %11.5f", uFactor, uNumPoints,
+                        100.0 * uNumDifferenced / uNumPoints, 1.0e6 * fDirectMs / fNumEvaluated,
+                        1.0e6 * fForwardDifferenceMs / fNumEvaluated, fDirectMs / std::max( fForwardDifferenceMs, 1.0e-6 ),
+                        fMaxRelativePositionError, fMaxNormalErrorDegrees );
+
+        if( fMaxRelativePositionError > MAX_RELATIVE_POSITION_ERROR || fMaxNormalErrorDegrees > MAX_NORMAL_ERROR_DEGREES )
+        {
+            hr = E_FAIL;
+        }
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmarks the tessellation cache on the bundled meshes, with the camera slowly dollying
+// in over the frames and distance adaptive factors. Every mesh is run without a cache (every
+// patch evaluated every frame), with an unlimited budget, and with budgets of 50% and
+// 25% of the peak resident size of the unlimited run.
+// Param: number of frames (default 120)
+//--------------------------------------------------------------------------------------
+HRESULT RunTessCacheTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const float BUDGET_FRACTIONS[] = { 0.0f, -1.0f, 0.5f, 0.25f };   // -1 is unlimited
+    static const float DOLLY_DISTANCE = 0.5f;   // Of the bounds diagonal, over all the frames
+
+    UINT uNumFrames = ( pszParam[0] != 0 ) ? (UINT)_wtoi( pszParam ) : 120;
+    uNumFrames = std::max( uNumFrames, 2u );
+
+    HeadlessReport( L"%u frames, factors quantized to 1/%u", uNumFrames, TESS_FACTOR_QUANTIZATION );
+    HeadlessReport( L"%-32s %10s %8s %11s %11s %12s %10s %8s", L"Mesh", L"Budget(KB)", L"Hit%",
+                    L"Evaluated", L"Evictions", L"Resident(KB)", L"ms/frame", L"Speedup" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        UINT uNumPatches = (UINT)MeshData.Indices.size() / 3;
+        std::vector<PN_VERTEX> Corners( uNumPatches * 3 );
+        std::vector<PN_CONTROL_POINTS> ControlPoints( uNumPatches );
+        for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+        {
+            for( UINT c = 0; c < 3; c++ )
+            {
+                Corners[uPatch * 3 + c] = MeshData.Vertices[MeshData.Indices[uPatch * 3 + c]];
+            }
+            ComputePNControlPoints( &Corners[uPatch * 3], &ControlPoints[uPatch] );
+        }
+
+        float fDiagonal = GetMeshDataBoundsDiagonal( &MeshData );
+        XMVECTOR vCenter = XMVectorScale( XMVectorAdd( XMLoadFloat3( &MeshData.f3BoundsMin ), XMLoadFloat3( &MeshData.f3BoundsMax ) ), 0.5f );
+        XMVECTOR vDirection = XMVector3Normalize( XMVectorSet( 1.0f, 0.5f, 1.0f, 0.0f ) );
+
+        double fBaselineMs = 0.0;
+        SIZE_T uPeakUnlimited = 0;
+
+        for( UINT uBudget = 0; uBudget < ARRAYSIZE( BUDGET_FRACTIONS ); uBudget++ )
+        {
+            SIZE_T uByteBudget = ( BUDGET_FRACTIONS[uBudget] < 0.0f ) ? (SIZE_T)-1 :
+                                 (SIZE_T)( BUDGET_FRACTIONS[uBudget] * (double)uPeakUnlimited );
+
+            CTessellationCache Cache;
+            Cache.Create( CPU_TESS_PN_TRIANGLES, uNumPatches, uByteBudget );
+
+            UINT64 uHits = 0, uMisses = 0, uEvictions = 0, uNumVertices = 0;
+            SIZE_T uPeakResident = 0;
+            double fStart = GetTimeInMs();
+
+            for( UINT uFrame = 0; uFrame < uNumFrames; uFrame++ )
+            {
+                float fT = (float)uFrame / (float)( uNumFrames - 1 );
+                XMVECTOR vEye = XMVectorAdd( vCenter, XMVectorScale( vDirection, fDiagonal * ( 2.0f - DOLLY_DISTANCE * fT ) ) );
+
+                Cache.BeginFrame();
+                for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+                {
+                    float fEdgeFactors[3], fInsideFactor;
+                    GetDistanceAdaptiveFactors( &Corners[uPatch * 3], vEye, TESS_MAX_FACTOR, 0.5f * fDiagonal, 2.0f * fDiagonal,
+                                                fEdgeFactors, &fInsideFactor );
+
+                    TESS_CACHE_BLOCK Block;
+                    Cache.GetPatch( uPatch, &Corners[uPatch * 3], &ControlPoints[uPatch], fEdgeFactors, fInsideFactor, &Block );
+                    uNumVertices += Block.uNumVertices;
+                }
+
+                TESS_CACHE_STATS Stats;
+                Cache.GetStats( &Stats );
+                uHits += Stats.uHits;
+                uMisses += Stats.uMisses;
+                uEvictions += Stats.uEvictions;
+                uPeakResident = std::max( uPeakResident, Stats.uResidentBytes );
+            }
+
+            double fMsPerFrame = ( GetTimeInMs() - fStart ) / uNumFrames;
+            if( 0 == uBudget )
+            {
+                fBaselineMs = fMsPerFrame;
+            }
+            if( BUDGET_FRACTIONS[uBudget] < 0.0f )
+            {
+                uPeakUnlimited = uPeakResident;
+            }
+
+            WCHAR szBudget[32];
+            if( BUDGET_FRACTIONS[uBudget] < 0.0f )
+            {
+                wcscpy_s( szBudget, L"unlimited" );
+            }
+            else
+            {
+                swprintf_s( szBudget, L"%.0f", (double)uByteBudget / 1024.0 );
+            }
+
+            HeadlessReport( L"%-32s %10s %7.1f%% %11.1f %11.1f %12.0f %10.3f %7.2fx", g_pszBundledMeshes[uMesh], szBudget,
+                            100.0 * (double)uHits / (double)std::max( uHits + uMisses, (UINT64)1 ),
+                            (double)uMisses / uNumFrames, (double)uEvictions / uNumFrames,
+                            (double)uPeakResident / 1024.0, fMsPerFrame, fBaselineMs / std::max( fMsPerFrame, 1.0e-6 ) );
+
+            // Every frame must still get all its vertices, cached or not
+            if( 0 == uNumVertices )
+            {
+                hr = E_FAIL;
+            }
+        }
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Bakes the tessellation of the bundled meshes at uniform factors into sdkmesh LODs for
+// targets without hull and domain shaders. LOD n of a mesh is written to the output
+// directory as <name>_<technique>_lod<n>.sdkmesh, LOD 0 being the source mesh itself.
+// Every LOD is loaded back and compared with the baked data.
+// Param: technique, pn or phong (default pn)
+//--------------------------------------------------------------------------------------
+HRESULT RunBakeLODsTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    // Odd factors, so fractional_odd partitioning spaces the points evenly
+    static const float LOD_FACTORS[] = { 3.0f, 5.0f, 9.0f, 15.0f };
+
+    CPU_TESS_TECHNIQUE Technique = CPU_TESS_PN_TRIANGLES;
+    const WCHAR* pszTechnique = L"pn";
+    if( 0 == _wcsicmp( pszParam, L"phong" ) )
+    {
+        Technique = CPU_TESS_PHONG;
+        pszTechnique = L"phong";
+    }
+    else if( pszParam[0] != 0 && 0 != _wcsicmp( pszParam, L"pn" ) )
+    {
+        HeadlessReport( L"Unknown technique %s, expected pn or phong", pszParam );
+        return E_INVALIDARG;
+    }
+
+    HeadlessReport( L"%s tessellation, ACMR for a %u entry FIFO", ( CPU_TESS_PHONG == Technique ) ? L"Phong" : L"PN-Triangles",
+                    VERTEX_CACHE_MEASURE_SIZE );
+    HeadlessReport( L"%-32s %4s %7s %10s %10s %10s %8s %8s %9s", L"Mesh", L"LOD", L"Factor", L"Triangles", L"Vertices",
+                    L"Evaluated", L"ACMR", L"ACMROpt", L"ms" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        CDXUTSDKMesh SourceMesh;
+        MESH_DATA Source;
+        if( FAILED( LoadBundledMesh( uMesh, &Source, &SourceMesh ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        HeadlessReport( L"%-32s %4u %7s %10u %10u %10s %8.3f %8s %9s", g_pszBundledMeshes[uMesh], 0, L"-",
+                        (UINT)Source.Indices.size() / 3, (UINT)Source.Vertices.size(), L"-",
+                        ComputeACMR( &Source.Indices[0], (UINT)Source.Indices.size(), VERTEX_CACHE_MEASURE_SIZE ), L"-", L"-" );
+
+        for( UINT uLOD = 0; uLOD < ARRAYSIZE( LOD_FACTORS ); uLOD++ )
+        {
+            MESH_DATA Baked;
+            MESH_BAKE_STATS Stats;
+            double fStart = GetTimeInMs();
+            HRESULT hrBake = BakeTessellatedMeshData( &Source, Technique, LOD_FACTORS[uLOD], &Baked, &Stats );
+            double fBakeMs = GetTimeInMs() - fStart;
+
+            WCHAR szSuffix[MAX_PATH], szFileName[MAX_PATH];
+            swprintf_s( szSuffix, L"_%s_lod%u", pszTechnique, uLOD + 1 );
+            GetOutputMeshFileName( g_pszBundledMeshes[uMesh], szSuffix, szFileName, _countof( szFileName ) );
+
+            MESH_DATA Written;
+            if( FAILED( hrBake ) || FAILED( WriteSDKMesh( szFileName, &SourceMesh, &Baked ) ) ||
+                FAILED( LoadMeshData( szFileName, &Written ) ) || !IsSameMeshData( &Baked, &Written ) )
+            {
+                HeadlessReport( L"%-32s %4u failed to bake or write %s", g_pszBundledMeshes[uMesh], uLOD + 1, szFileName );
+                hr = E_FAIL;
+                continue;
+            }
+
+            HeadlessReport( L"%-32s %4u %7.1f %10u %10u %10u %8.3f %8.3f %9.1f", g_pszBundledMeshes[uMesh], uLOD + 1,
+                            LOD_FACTORS[uLOD], (UINT)Baked.Indices.size() / 3, (UINT)Baked.Vertices.size(),
+                            Stats.uNumEvaluatedVertices, Stats.fACMRBeforeOptimize, Stats.fACMRAfterOptimize, fBakeMs );
+        }
+
+        SourceMesh.Destroy();
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Benchmarks writing a frame of CPU tessellated patches to the buffer the GPU reads: the
+// patches collected in vectors then copied to the buffer, as a D3D11_MAP_WRITE_DISCARD
+// update does, against writing them straight into a heap backed output ring with regular
+// and streaming stores. The patches come from a tessellation cache that holds the whole
+// frame, so only the output is measured. The ring's frames complete 2 frames later, as
+// with a GPU running behind the CPU.
+// Param: number of frames (default 60)
+//--------------------------------------------------------------------------------------
+HRESULT RunTessRingTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT FRAME_LATENCY = 2;
+    static const WCHAR* MODE_NAMES[] = { L"vector+copy", L"ring", L"ring NT" };
+
+    UINT uNumFrames = ( pszParam[0] != 0 ) ? (UINT)_wtoi( pszParam ) : 60;
+    uNumFrames = std::max( uNumFrames, 1u );
+
+    HeadlessReport( L"%u frames, ring frames complete %u frames late. Moved counts the output bytes the CPU writes and reads.",
+                    uNumFrames, FRAME_LATENCY );
+    HeadlessReport( L"%-32s %-12s %10s %10s %10s %10s %10s %8s", L"Mesh", L"Output", L"MB/frame", L"Bytes/tri",
+                    L"Moved/tri", L"ms/frame", L"GB/s", L"Speedup" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        // Tessellate one frame, close enough for the factors to vary over the mesh
+        UINT uNumPatches = (UINT)MeshData.Indices.size() / 3;
+        float fDiagonal = GetMeshDataBoundsDiagonal( &MeshData );
+        XMVECTOR vCenter = XMVectorScale( XMVectorAdd( XMLoadFloat3( &MeshData.f3BoundsMin ), XMLoadFloat3( &MeshData.f3BoundsMax ) ), 0.5f );
+        XMVECTOR vEye = XMVectorAdd( vCenter, XMVectorScale( XMVector3Normalize( XMVectorSet( 1.0f, 0.5f, 1.0f, 0.0f ) ), fDiagonal ) );
+
+        CTessellationCache Cache;
+        Cache.Create( CPU_TESS_PN_TRIANGLES, uNumPatches, (SIZE_T)-1 );
+        Cache.BeginFrame();
+
+        std::vector<TESS_CACHE_BLOCK> Blocks;
+        UINT uFrameVertices = 0, uFrameIndices = 0;
+        for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+        {
+            PN_VERTEX Corners[3];
+            for( UINT c = 0; c < 3; c++ )
+            {
+                Corners[c] = MeshData.Vertices[MeshData.Indices[uPatch * 3 + c]];
+            }
+            PN_CONTROL_POINTS ControlPoints;
+            ComputePNControlPoints( Corners, &ControlPoints );
+
+            float fEdgeFactors[3], fInsideFactor;
+            GetDistanceAdaptiveFactors( Corners, vEye, TESS_MAX_FACTOR, 0.5f * fDiagonal, 2.0f * fDiagonal, fEdgeFactors, &fInsideFactor );
+
+            TESS_CACHE_BLOCK Block;
+            Cache.GetPatch( uPatch, Corners, &ControlPoints, fEdgeFactors, fInsideFactor, &Block );
+            if( Block.uNumIndices > 0 )
+            {
+                Blocks.push_back( Block );
+                uFrameVertices += Block.uNumVertices;
+                uFrameIndices += Block.uNumIndices;
+            }
+        }
+
+        UINT uFrameTriangles = std::max( uFrameIndices / 3, 1u );
+        double fFrameBytes = (double)uFrameVertices * sizeof( PN_VERTEX ) + (double)uFrameIndices * sizeof( TESS_RING_INDEX );
+
+        // What the old path produces, to check the rings against
+        std::vector<PN_VERTEX> FrameVertices;
+        std::vector<TESS_RING_INDEX> FrameIndices;
+        FrameVertices.reserve( uFrameVertices );
+        FrameIndices.reserve( uFrameIndices );
+
+        double fBaselineMs = 0.0;
+        for( UINT uMode = 0; uMode < ARRAYSIZE( MODE_NAMES ); uMode++ )
+        {
+            bool bPassed = true;
+            double fMovedBytes = fFrameBytes;
+            double fStart = GetTimeInMs();
+
+            if( 0 == uMode )
+            {
+                // Destination of the copy, as the mapped buffer
+                BYTE* pDestination = (BYTE*)_aligned_malloc( (size_t)fFrameBytes, 64 );
+                if( NULL == pDestination )
+                {
+                    return E_OUTOFMEMORY;
+                }
+
+                for( UINT uFrame = 0; uFrame < uNumFrames; uFrame++ )
+                {
+                    FrameVertices.clear();
+                    FrameIndices.clear();
+                    for( UINT b = 0; b < Blocks.size(); b++ )
+                    {
+                        UINT uBaseVertex = (UINT)FrameVertices.size();
+                        FrameVertices.insert( FrameVertices.end(), Blocks[b].pVertices, Blocks[b].pVertices + Blocks[b].uNumVertices );
+                        for( UINT i = 0; i < Blocks[b].uNumIndices; i++ )
+                        {
+                            FrameIndices.push_back( Blocks[b].pIndices[i] + uBaseVertex );
+                        }
+                    }
+
+                    memcpy( pDestination, &FrameVertices[0], FrameVertices.size() * sizeof( PN_VERTEX ) );
+                    memcpy( pDestination + FrameVertices.size() * sizeof( PN_VERTEX ), &FrameIndices[0], FrameIndices.size() * sizeof( TESS_RING_INDEX ) );
+                }
+
+                _aligned_free( pDestination );
+
+                // Written to the vectors, read back and written again
+                fMovedBytes = 3.0 * fFrameBytes;
+            }
+            else
+            {
+                // Room for the frames in flight and the one being written
+                CHeapTessOutputRing Ring;
+                if( FAILED( Ring.Create( uFrameVertices * ( FRAME_LATENCY + 1 ), uFrameIndices * ( FRAME_LATENCY + 1 ), 2 == uMode ) ) )
+                {
+                    return E_OUTOFMEMORY;
+                }
+
+                for( UINT uFrame = 0; uFrame < uNumFrames; uFrame++ )
+                {
+                    Ring.BeginFrame();
+                    for( UINT b = 0; b < Blocks.size(); b++ )
+                    {
+                        Ring.WritePatch( Blocks[b].pVertices, Blocks[b].uNumVertices, Blocks[b].pIndices, Blocks[b].uNumIndices );
+                    }
+                    Ring.EndFrame();
+
+                    TESS_RING_STATS Stats;
+                    Ring.GetStats( &Stats );
+                    bPassed = bPassed && ( 0 == Stats.uNumDroppedPatches );
+
+                    if( Ring.GetFrame() > FRAME_LATENCY )
+                    {
+                        Ring.SetCompletedFrame( Ring.GetFrame() - FRAME_LATENCY );
+                    }
+                }
+
+                // The batches of the last frame must hold the same triangles as the vectors
+                UINT uVertex = 0, uIndex = 0;
+                for( UINT b = 0; b < Ring.GetNumBatches() && bPassed; b++ )
+                {
+                    const TESS_RING_BATCH* pBatch = Ring.GetBatch( b );
+                    bPassed = ( uVertex + pBatch->uNumVertices <= FrameVertices.size() ) && ( uIndex + pBatch->uNumIndices <= FrameIndices.size() ) &&
+                              0 == memcmp( &FrameVertices[uVertex], Ring.GetVertices() + pBatch->uFirstVertex, pBatch->uNumVertices * sizeof( PN_VERTEX ) );
+                    for( UINT i = 0; i < pBatch->uNumIndices && bPassed; i++ )
+                    {
+                        bPassed = ( Ring.GetIndices()[pBatch->uFirstIndex + i] + uVertex == FrameIndices[uIndex + i] );
+                    }
+                    uVertex += pBatch->uNumVertices;
+                    uIndex += pBatch->uNumIndices;
+                }
+                bPassed = bPassed && ( uVertex == FrameVertices.size() ) && ( uIndex == FrameIndices.size() );
+            }
+
+            double fMsPerFrame = ( GetTimeInMs() - fStart ) / uNumFrames;
+            if( 0 == uMode )
+            {
+                fBaselineMs = fMsPerFrame;
+            }
+
+            HeadlessReport( L"%-32s %-12s %10.2f %10.1f %10.1f %10.3f %10.2f %7.2fx%s", g_pszBundledMeshes[uMesh], MODE_NAMES[uMode],
+                            fFrameBytes / ( 1024.0 * 1024.0 ), fFrameBytes / uFrameTriangles, fMovedBytes / uFrameTriangles,
+                            fMsPerFrame, fFrameBytes / ( std::max( fMsPerFrame, 1.0e-6 ) * 1.0e6 ),
+                            fBaselineMs / std::max( fMsPerFrame, 1.0e-6 ), bPassed ? L"" : L"  MISMATCH" );
+
+            if( !bPassed )
+            {
+                hr = E_FAIL;
+            }
+        }
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Orders of the patch order benchmark
+//--------------------------------------------------------------------------------------
+struct PATCH_ORDER_CONFIG
+{
+    const WCHAR*        pszName;
+    bool                bReorder;       // Else the authoring order
+    PATCH_ORDER_CURVE   Curve;
+    float               fNormalWeight;
+};
+
+// A run of consecutive patches culled as one, with its bounds and normal cone
+struct PATCH_ORDER_CLUSTER
+{
+    UINT        uFirstTriangle;
+    UINT        uNumTriangles;
+    XMFLOAT3    f3BoundsMin;
+    XMFLOAT3    f3BoundsMax;
+    XMFLOAT3    f3Center;
+    float       fRadius;
+    XMFLOAT3    f3ConeAxis;
+    float       fConeAngle;     // Half angle, XM_PI if the normals do not fit a cone
+};
+
+
+//--------------------------------------------------------------------------------------
+// Returns the front facing normal of a triangle, as the culling of the CPU paths uses it
+//--------------------------------------------------------------------------------------
+static XMVECTOR GetFacingNormal( const PN_VERTEX* pCorners )
+{
+    XMVECTOR vPosition0 = XMLoadFloat3( &pCorners[0].f3Position );
+    return XMVector3Cross( XMVectorSubtract( XMLoadFloat3( &pCorners[2].f3Position ), vPosition0 ),
+                           XMVectorSubtract( XMLoadFloat3( &pCorners[1].f3Position ), vPosition0 ) );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Splits the triangle list into clusters of uClusterTriangles consecutive triangles
+//--------------------------------------------------------------------------------------
+static void BuildPatchOrderClusters( const MESH_DATA* pMeshData, UINT uClusterTriangles, std::vector<PATCH_ORDER_CLUSTER>* pClusters )
+{
+    pClusters->clear();
+
+    UINT uNumTriangles = (UINT)pMeshData->Indices.size() / 3;
+    for( UINT uFirst = 0; uFirst < uNumTriangles; uFirst += uClusterTriangles )
+    {
+        PATCH_ORDER_CLUSTER Cluster;
+        Cluster.uFirstTriangle = uFirst;
+        Cluster.uNumTriangles = std::min( uClusterTriangles, uNumTriangles - uFirst );
+
+        XMVECTOR vMin = XMVectorReplicate( FLT_MAX );
+        XMVECTOR vMax = XMVectorReplicate( -FLT_MAX );
+        XMVECTOR vNormalSum = XMVectorZero();
+        for( UINT t = uFirst; t < uFirst + Cluster.uNumTriangles; t++ )
+        {
+            PN_VERTEX Corners[3];
+            for( UINT c = 0; c < 3; c++ )
+            {
+                Corners[c] = pMeshData->Vertices[pMeshData->Indices[t * 3 + c]];
+                vMin = XMVectorMin( vMin, XMLoadFloat3( &Corners[c].f3Position ) );
+                vMax = XMVectorMax( vMax, XMLoadFloat3( &Corners[c].f3Position ) );
+            }
+            vNormalSum = XMVectorAdd( vNormalSum, XMVector3Normalize( GetFacingNormal( Corners ) ) );
+        }
+        XMStoreFloat3( &Cluster.f3BoundsMin, vMin );
+        XMStoreFloat3( &Cluster.f3BoundsMax, vMax );
+        XMStoreFloat3( &Cluster.f3Center, XMVectorScale( XMVectorAdd( vMin, vMax ), 0.5f ) );
+        Cluster.fRadius = 0.5f * XMVectorGetX( XMVector3Length( XMVectorSubtract( vMax, vMin ) ) );
+
+        // Degenerate triangles are culled by facing anyway, so they do not widen the cone
+        Cluster.fConeAngle = XM_PI;
+        XMStoreFloat3( &Cluster.f3ConeAxis, XMVectorZero() );
+        if( XMVectorGetX( XMVector3Length( vNormalSum ) ) > 1.0e-6f )
+        {
+            XMVECTOR vAxis = XMVector3Normalize( vNormalSum );
+            float fMinDot = 1.0f;
+            for( UINT t = uFirst; t < uFirst + Cluster.uNumTriangles; t++ )
+            {
+                PN_VERTEX Corners[3];
+                for( UINT c = 0; c < 3; c++ )
+                {
+                    Corners[c] = pMeshData->Vertices[pMeshData->Indices[t * 3 + c]];
+                }
+
+                XMVECTOR vNormal = GetFacingNormal( Corners );
+                if( XMVectorGetX( XMVector3Length( vNormal ) ) > 0.0f )
+                {
+                    fMinDot = std::min( fMinDot, XMVectorGetX( XMVector3Dot( vAxis, XMVector3Normalize( vNormal ) ) ) );
+                }
+            }
+
+            XMStoreFloat3( &Cluster.f3ConeAxis, vAxis );
+            Cluster.fConeAngle = acosf( std::min( std::max( fMinDot, -1.0f ), 1.0f ) );
+        }
+
+        pClusters->push_back( Cluster );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns true if every triangle of the cluster faces away from the eye. The direction
+// from any point of the bounding sphere to the eye is within asin( radius / distance ) of
+// the direction from the center, and every normal is within the cone angle of its axis.
+//--------------------------------------------------------------------------------------
+static bool IsClusterBackFacing( const PATCH_ORDER_CLUSTER* pCluster, FXMVECTOR vEye )
+{
+    if( pCluster->fConeAngle >= XM_PIDIV2 )
+    {
+        return false;
+    }
+
+    XMVECTOR vToEye = XMVectorSubtract( vEye, XMLoadFloat3( &pCluster->f3Center ) );
+    float fDistance = XMVectorGetX( XMVector3Length( vToEye ) );
+    if( fDistance <= pCluster->fRadius )
+    {
+        return false;
+    }
+
+    float fSpread = pCluster->fConeAngle + asinf( pCluster->fRadius / fDistance );
+    if( fSpread >= XM_PIDIV2 )
+    {
+        return false;
+    }
+
+    return XMVectorGetX( XMVector3Dot( XMLoadFloat3( &pCluster->f3ConeAxis ), vToEye ) ) < -sinf( fSpread ) * fDistance;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns true if both hold the same subsets and, within each, the same triangles with
+// the same winding in any order
+//--------------------------------------------------------------------------------------
+static bool IsSamePatchSet( const MESH_DATA* pA, const MESH_DATA* pB )
+{
+    if( pA->Subsets.size() != pB->Subsets.size() || pA->Indices.size() != pB->Indices.size() )
+    {
+        return false;
+    }
+
+    std::vector< std::pair<UINT64, UINT> > TrianglesA, TrianglesB;
+    for( UINT s = 0; s < (UINT)pA->Subsets.size(); s++ )
+    {
+        const MESH_DATA_SUBSET& SubsetA = pA->Subsets[s];
+        const MESH_DATA_SUBSET& SubsetB = pB->Subsets[s];
+        if( SubsetA.uMesh != SubsetB.uMesh || SubsetA.uSubset != SubsetB.uSubset || SubsetA.uMaterialID != SubsetB.uMaterialID ||
+            SubsetA.uIndexStart != SubsetB.uIndexStart || SubsetA.uIndexCount != SubsetB.uIndexCount )
+        {
+            return false;
+        }
+
+        // Each triangle rotated to start at its smallest index, which keeps the winding
+        for( UINT uMesh = 0; uMesh < 2; uMesh++ )
+        {
+            const UINT* pIndices = &( ( 0 == uMesh ) ? pA : pB )->Indices[SubsetA.uIndexStart];
+            std::vector< std::pair<UINT64, UINT> >* pTriangles = ( 0 == uMesh ) ? &TrianglesA : &TrianglesB;
+            pTriangles->clear();
+            for( UINT t = 0; t < SubsetA.uIndexCount / 3; t++ )
+            {
+                const UINT* pTriangle = &pIndices[t * 3];
+                UINT uFirst = ( pTriangle[1] < pTriangle[0] ) ? 1 : 0;
+                uFirst = ( pTriangle[2] < pTriangle[uFirst] ) ? 2 : uFirst;
+                pTriangles->push_back( std::make_pair( ( (UINT64)pTriangle[uFirst] << 32 ) | pTriangle[( uFirst + 1 ) % 3],
+                                                       pTriangle[( uFirst + 2 ) % 3] ) );
+            }
+            std::sort( pTriangles->begin(), pTriangles->end() );
+        }
+
+        if( TrianglesA != TrianglesB )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Measures the effect of reordering the patches of each subset along a space filling
+// curve. The patches are culled in clusters of consecutive patches, by frustum and by
+// normal cone, from close up views that leave parts of the mesh outside. The survivors
+// are tested per patch in batches of 8, as the SIMD paths do, and tessellated with
+// distance adaptive factors. Reports the post transform cache ACMR, the patches culled
+// per cluster, the share of batch lanes that hold a surviving patch, and the time to
+// cull and tessellate a view. Every order must keep the same patches and tessellate the
+// same ones.
+// Param: morton or hilbert, also writes that order of each mesh to the output directory
+// as <name>_<curve>.sdkmesh (default: measure only)
+//--------------------------------------------------------------------------------------
+HRESULT RunPatchOrderTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT NUM_VIEWS = 24;
+    static const UINT CLUSTER_TRIANGLES = 64;
+    static const UINT BATCH_TRIANGLES = 8;
+    static const UINT NUM_PASSES = 3;
+    static const PATCH_ORDER_CONFIG CONFIGS[] =
+    {
+        { L"authoring",         false,  PATCH_ORDER_MORTON,     0.0f },
+        { L"morton",            true,   PATCH_ORDER_MORTON,     0.0f },
+        { L"hilbert",           true,   PATCH_ORDER_HILBERT,    0.0f },
+        { L"morton+normal",     true,   PATCH_ORDER_MORTON,     0.5f },
+        { L"hilbert+normal",    true,   PATCH_ORDER_HILBERT,    0.5f },
+    };
+
+    const PATCH_ORDER_CONFIG* pWriteConfig = NULL;
+    if( 0 == _wcsicmp( pszParam, L"morton" ) )
+    {
+        pWriteConfig = &CONFIGS[1];
+    }
+    else if( 0 == _wcsicmp( pszParam, L"hilbert" ) )
+    {
+        pWriteConfig = &CONFIGS[2];
+    }
+    else if( pszParam[0] != 0 )
+    {
+        HeadlessReport( L"Unknown curve %s, expected morton or hilbert", pszParam );
+        return E_INVALIDARG;
+    }
+
+    HeadlessReport( L"%u views, %u patch clusters, %u patch batches, vertex cache reordered per cluster, ACMR for a %u entry FIFO",
+                    NUM_VIEWS, CLUSTER_TRIANGLES, BATCH_TRIANGLES, VERTEX_CACHE_MEASURE_SIZE );
+    HeadlessReport( L"%-32s %-15s %7s %9s %7s %7s %9s %9s %8s", L"Mesh", L"Order", L"ACMR", L"Frustum%", L"Cone%", L"Lanes%",
+                    L"Patches", L"Tess ms", L"Speedup" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        CDXUTSDKMesh SourceMesh;
+        MESH_DATA Source;
+        if( FAILED( LoadBundledMesh( uMesh, &Source, &SourceMesh ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        float fDiagonal = GetMeshDataBoundsDiagonal( &Source );
+        XMVECTOR vCenter = XMVectorScale( XMVectorAdd( XMLoadFloat3( &Source.f3BoundsMin ), XMLoadFloat3( &Source.f3BoundsMax ) ), 0.5f );
+
+        std::vector<UINT> ReferenceSurvivors( NUM_VIEWS, 0 );
+        double fAuthoringMs = 0.0;
+        for( UINT uConfig = 0; uConfig < ARRAYSIZE( CONFIGS ); uConfig++ )
+        {
+            const PATCH_ORDER_CONFIG* pConfig = &CONFIGS[uConfig];
+            MESH_DATA Ordered = Source;
+            if( pConfig->bReorder )
+            {
+                ReorderPatches( &Ordered, pConfig->Curve, pConfig->fNormalWeight, CLUSTER_TRIANGLES );
+                if( !IsSamePatchSet( &Source, &Ordered ) )
+                {
+                    HeadlessReport( L"%-32s %-15s changed the patches or subsets", g_pszBundledMeshes[uMesh], pConfig->pszName );
+                    hr = E_FAIL;
+                    continue;
+                }
+            }
+
+            std::vector<PATCH_ORDER_CLUSTER> Clusters;
+            BuildPatchOrderClusters( &Ordered, CLUSTER_TRIANGLES, &Clusters );
+
+            std::map<UINT, TRI_TESSELLATION> Patterns;
+            std::vector<PN_VERTEX> Vertices;
+            UINT64 uNumPatches = 0, uNumFrustumCulled = 0, uNumConeCulled = 0, uNumSurvivors = 0, uNumActiveLanes = 0;
+            UINT uNumMismatches = 0;
+            double fTessMs = 0.0, fChecksum = 0.0;
+
+            for( UINT uView = 0; uView < NUM_VIEWS; uView++ )
+            {
+                // Close up views around the mesh, aimed off center
+                float fAngle = XM_2PI * (float)uView / (float)NUM_VIEWS;
+                float fElevation = 0.4f * sinf( 3.0f * fAngle );
+                XMVECTOR vEye = XMVectorAdd( vCenter, XMVectorScale( XMVectorSet( cosf( fAngle ) * cosf( fElevation ), sinf( fElevation ),
+                                                                                  sinf( fAngle ) * cosf( fElevation ), 0.0f ), 0.6f * fDiagonal ) );
+                XMVECTOR vTarget = XMVectorAdd( vCenter, XMVectorScale( XMVectorSet( sinf( 2.0f * fAngle ), 0.5f * cosf( 5.0f * fAngle ),
+                                                                                     -cosf( 2.0f * fAngle ), 0.0f ), 0.25f * fDiagonal ) );
+                XMMATRIX mView = XMMatrixLookAtLH( vEye, vTarget, XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f ) );
+                XMMATRIX mProj = XMMatrixPerspectiveFovLH( XM_PI / 8.0f, 16.0f / 10.0f, 0.01f * fDiagonal, 4.0f * fDiagonal );
+                XMFLOAT4 f4Planes[6];
+                GetFrustumPlanes( XMMatrixMultiply( mView, mProj ), f4Planes );
+
+                // Every pass counts the same, the fastest is timed
+                UINT uViewFrustumCulled = 0, uViewConeCulled = 0, uViewSurvivors = 0, uViewActiveLanes = 0;
+                double fViewMs = DBL_MAX;
+                for( UINT uPass = 0; uPass < NUM_PASSES; uPass++ )
+                {
+                    uViewFrustumCulled = uViewConeCulled = uViewSurvivors = uViewActiveLanes = 0;
+                    double fStart = GetTimeInMs();
+                    for( UINT uCluster = 0; uCluster < (UINT)Clusters.size(); uCluster++ )
+                    {
+                        const PATCH_ORDER_CLUSTER* pCluster = &Clusters[uCluster];
+                        if( IsBoxOutsideFrustum( f4Planes, pCluster->f3BoundsMin, pCluster->f3BoundsMax ) )
+                        {
+                            uViewFrustumCulled += pCluster->uNumTriangles;
+                            continue;
+                        }
+                        if( IsClusterBackFacing( pCluster, vEye ) )
+                        {
+                            uViewConeCulled += pCluster->uNumTriangles;
+                            continue;
+                        }
+
+                        for( UINT uBatch = 0; uBatch < pCluster->uNumTriangles; uBatch += BATCH_TRIANGLES )
+                        {
+                            UINT uBatchSurvivors = 0;
+                            UINT uBatchEnd = std::min( uBatch + BATCH_TRIANGLES, pCluster->uNumTriangles );
+                            for( UINT t = pCluster->uFirstTriangle + uBatch; t < pCluster->uFirstTriangle + uBatchEnd; t++ )
+                            {
+                                PN_VERTEX Corners[3];
+                                XMVECTOR vMin = XMVectorReplicate( FLT_MAX );
+                                XMVECTOR vMax = XMVectorReplicate( -FLT_MAX );
+                                for( UINT c = 0; c < 3; c++ )
+                                {
+                                    Corners[c] = Ordered.Vertices[Ordered.Indices[t * 3 + c]];
+                                    vMin = XMVectorMin( vMin, XMLoadFloat3( &Corners[c].f3Position ) );
+                                    vMax = XMVectorMax( vMax, XMLoadFloat3( &Corners[c].f3Position ) );
+                                }
+
+                                XMVECTOR vToEye = XMVectorSubtract( vEye, XMLoadFloat3( &Corners[0].f3Position ) );
+                                if( XMVectorGetX( XMVector3Dot( GetFacingNormal( Corners ), vToEye ) ) <= 0.0f )
+                                {
+                                    continue;
+                                }
+
+                                XMFLOAT3 f3Min, f3Max;
+                                XMStoreFloat3( &f3Min, vMin );
+                                XMStoreFloat3( &f3Max, vMax );
+                                if( IsBoxOutsideFrustum( f4Planes, f3Min, f3Max ) )
+                                {
+                                    continue;
+                                }
+
+                                uBatchSurvivors++;
+
+                                float fEdgeFactors[3], fInsideFactor;
+                                GetDistanceAdaptiveFactors( Corners, vEye, TESS_MAX_FACTOR, 0.5f * fDiagonal, 2.0f * fDiagonal, fEdgeFactors, &fInsideFactor );
+
+                                float fQuantizedEdgeFactors[3], fQuantizedInsideFactor;
+                                UINT uKey = QuantizeTessFactors( fEdgeFactors, fInsideFactor, fQuantizedEdgeFactors, &fQuantizedInsideFactor );
+                                if( 0 == uKey )
+                                {
+                                    continue;
+                                }
+
+                                std::map<UINT, TRI_TESSELLATION>::iterator it = Patterns.find( uKey );
+                                if( it == Patterns.end() )
+                                {
+                                    it = Patterns.insert( std::make_pair( uKey, TRI_TESSELLATION() ) ).first;
+                                    TessellateTri( fQuantizedEdgeFactors, fQuantizedInsideFactor, &it->second );
+                                }
+
+                                UINT uNumVertices = (UINT)it->second.DomainPoints.size();
+                                if( Vertices.size() < uNumVertices )
+                                {
+                                    Vertices.resize( uNumVertices );
+                                }
+
+                                PN_CONTROL_POINTS ControlPoints;
+                                ComputePNControlPoints( Corners, &ControlPoints );
+                                EvaluatePatchVertices( CPU_TESS_PN_TRIANGLES, Corners, &ControlPoints, &it->second, &Vertices[0] );
+                                fChecksum += Vertices[uNumVertices / 2].f3Position.x;
+                            }
+
+                            uViewSurvivors += uBatchSurvivors;
+                            uViewActiveLanes += ( 0 != uBatchSurvivors ) ? BATCH_TRIANGLES : 0;
+                        }
+                    }
+                    fViewMs = std::min( fViewMs, GetTimeInMs() - fStart );
+                }
+
+                uNumPatches += Ordered.Indices.size() / 3;
+                uNumFrustumCulled += uViewFrustumCulled;
+                uNumConeCulled += uViewConeCulled;
+                uNumActiveLanes += uViewActiveLanes;
+                uNumSurvivors += uViewSurvivors;
+                fTessMs += fViewMs;
+
+                // Cluster culling is conservative, so every order keeps the same patches
+                if( 0 == uConfig )
+                {
+                    ReferenceSurvivors[uView] = uViewSurvivors;
+                }
+                else if( ReferenceSurvivors[uView] != uViewSurvivors )
+                {
+                    uNumMismatches++;
+                }
+            }
+
+            if( 0 == uConfig )
+            {
+                fAuthoringMs = fTessMs;
+            }
+
+            HeadlessReport( L"%-32s %-15s %7.3f %8.1f%% %6.1f%% %6.1f%% %9.1f %9.3f %7.2fx", g_pszBundledMeshes[uMesh], pConfig->pszName,
+                            ComputeACMR( &Ordered.Indices[0], (UINT)Ordered.Indices.size(), VERTEX_CACHE_MEASURE_SIZE ),
+                            100.0 * (double)uNumFrustumCulled / (double)std::max( uNumPatches, (UINT64)1 ),
+                            100.0 * (double)uNumConeCulled / (double)std::max( uNumPatches, (UINT64)1 ),
+                            100.0 * (double)uNumSurvivors / (double)std::max( uNumActiveLanes, (UINT64)1 ),
+                            (double)uNumSurvivors / NUM_VIEWS, fTessMs / NUM_VIEWS, fAuthoringMs / std::max( fTessMs, 1.0e-6 ) );
+
+            if( 0 != uNumMismatches || !_finite( fChecksum ) )
+            {
+                HeadlessReport( L"%-32s %-15s %u views tessellated different patches", g_pszBundledMeshes[uMesh], pConfig->pszName, uNumMismatches );
+                hr = E_FAIL;
+            }
+
+            if( pConfig != pWriteConfig )
+            {
+                continue;
+            }
+
+            WCHAR szSuffix[MAX_PATH], szFileName[MAX_PATH];
+            swprintf_s( szSuffix, L"_%s", pszParam );
+            GetOutputMeshFileName( g_pszBundledMeshes[uMesh], szSuffix, szFileName, _countof( szFileName ) );
+
+            MESH_DATA Written;
+            if( FAILED( WriteSDKMesh( szFileName, &SourceMesh, &Ordered ) ) || FAILED( LoadMeshData( szFileName, &Written ) ) ||
+                !IsSameMeshData( &Ordered, &Written ) )
+            {
+                HeadlessReport( L"%-32s failed to write %s", g_pszBundledMeshes[uMesh], szFileName );
+                hr = E_FAIL;
+            }
+        }
+
+        SourceMesh.Destroy();
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Times the CPU transform of the world space vertex buffers on a field of copies of each
+// bundled mesh, with the scalar and SSE paths on one thread and the SSE path on all the
+// workers, and checks the SSE results against the scalar path. Also reports the vertex
+// shader work the pass through saves each frame: ACMR x triangles vertex shader
+// invocations of WORLD_SPACE_VS_ALU_SAVED instructions each.
+// Param: number of copies in the field (default 16)
+//--------------------------------------------------------------------------------------
+HRESULT RunWorldSpaceTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT NUM_PASSES = 5;
+    static const float MAX_POSITION_ERROR = 1.0e-6f;    // Relative to the bounds diagonal
+    static const float MAX_NORMAL_ERROR = 1.0e-5f;
+    static const UINT STRIDE = (UINT)sizeof( PN_VERTEX );
+
+    UINT uNumCopies = ( pszParam[0] != 0 ) ? (UINT)_wtoi( pszParam ) : 16;
+    uNumCopies = std::max( uNumCopies, 1u );
+
+    CNumaTaskPool Pool;
+    if( FAILED( Pool.Create( 0, 0 ) ) )
+    {
+        HeadlessReport( L"Failed to start the workers" );
+        return E_FAIL;
+    }
+
+    // Rotation and scale, as the mesh matrices of the sample
+    XMMATRIX mWorld = XMMatrixMultiply( XMMatrixScaling( 0.1f, 0.1f, 0.1f ),
+                                       XMMatrixMultiply( XMMatrixRotationX( -XM_PI / 36 ), XMMatrixRotationY( XM_PI / 4 ) ) );
+
+    HeadlessReport( L"%u copies per field, best of %u passes, %u vertices per task, %u workers", uNumCopies, NUM_PASSES,
+                    WORLD_SPACE_TASK_VERTICES, Pool.GetNumWorkers() );
+    HeadlessReport( L"%-32s %10s %10s %10s %10s %10s %10s %10s %7s %10s %12s", L"Mesh", L"Vertices", L"Scalar ms", L"SSE ms",
+                    L"Pool ms", L"Mvert/s", L"Pos err", L"Nrm err", L"ACMR", L"VS invoc", L"ALU saved" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        float fDiagonal = GetMeshDataBoundsDiagonal( &MeshData );
+        MESH_DATA Field;
+        BuildMeshGrid( &MeshData, uNumCopies, 1.1f * fDiagonal, &Field );
+
+        UINT uNumVertices = (UINT)Field.Vertices.size();
+        const BYTE* pSource = (const BYTE*)&Field.Vertices[0];
+        std::vector<PN_VERTEX> Reference( uNumVertices ), Transformed( uNumVertices );
+
+        // Scalar and SSE on this thread, then SSE on the workers
+        double fBestMs[3] = { DBL_MAX, DBL_MAX, DBL_MAX };
+        float fMaxPositionError = 0.0f, fMaxNormalError = 0.0f;
+        for( UINT uPass = 0; uPass < NUM_PASSES; uPass++ )
+        {
+            for( UINT uConfig = 0; uConfig < 3; uConfig++ )
+            {
+                WORLD_TRANSFORM_PATH Path = ( 0 == uConfig ) ? WORLD_TRANSFORM_SCALAR : WORLD_TRANSFORM_SSE;
+                BYTE* pDest = ( 0 == uConfig ) ? (BYTE*)&Reference[0] : (BYTE*)&Transformed[0];
+
+                double fStart = GetTimeInMs();
+                TransformVerticesToWorld( pSource, pDest, STRIDE, uNumVertices, mWorld, Path, ( 2 == uConfig ) ? &Pool : NULL );
+                fBestMs[uConfig] = std::min( fBestMs[uConfig], GetTimeInMs() - fStart );
+
+                if( 0 == uConfig )
+                {
+                    continue;
+                }
+
+                for( UINT i = 0; i < uNumVertices; i++ )
+                {
+                    XMVECTOR vPosition = XMVectorSubtract( XMLoadFloat3( &Transformed[i].f3Position ), XMLoadFloat3( &Reference[i].f3Position ) );
+                    XMVECTOR vNormal = XMVectorSubtract( XMLoadFloat3( &Transformed[i].f3Normal ), XMLoadFloat3( &Reference[i].f3Normal ) );
+                    fMaxPositionError = std::max( fMaxPositionError, XMVectorGetX( XMVector3Length( vPosition ) ) / fDiagonal );
+                    fMaxNormalError = std::max( fMaxNormalError, XMVectorGetX( XMVector3Length( vNormal ) ) );
+                    if( 0 != memcmp( &Transformed[i].f2TexCoord, &Field.Vertices[i].f2TexCoord, sizeof( XMFLOAT2 ) ) )
+                    {
+                        fMaxNormalError = FLT_MAX;
+                    }
+                }
+            }
+        }
+
+        // Work saved on the GPU each frame by the pass through vertex shader
+        UINT uNumTriangles = (UINT)Field.Indices.size() / 3;
+        float fACMR = ComputeACMR( &Field.Indices[0], (UINT)Field.Indices.size(), VERTEX_CACHE_MEASURE_SIZE );
+        double fInvocations = (double)fACMR * (double)uNumTriangles;
+
+        HeadlessReport( L"%-32s %10u %10.3f %10.3f %10.3f %10.1f %10.2e %10.2e %7.3f %10.0f %12.0f", g_pszBundledMeshes[uMesh],
+                        uNumVertices, fBestMs[0], fBestMs[1], fBestMs[2], (double)uNumVertices / ( 1000.0 * fBestMs[2] ),
+                        fMaxPositionError, fMaxNormalError, fACMR, fInvocations, fInvocations * WORLD_SPACE_VS_ALU_SAVED );
+
+        if( fMaxPositionError > MAX_POSITION_ERROR || fMaxNormalError > MAX_NORMAL_ERROR )
+        {
+            HeadlessReport( L"%-32s SSE path differs from the scalar path", g_pszBundledMeshes[uMesh] );
+            hr = E_FAIL;
+        }
+    }
+
+    HeadlessReport( L"ALU saved: vertex shader instructions saved per frame; the transform is paid once per world matrix change" );
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,283 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ShaderTools.cpp
+//
+// Tools of the shaders: the lazily compiled hull and domain shader permutations.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "HeadlessTools.h"
+#include "ShaderPermutations.h"
+
+using namespace DirectX;
+
+
+//--------------------------------------------------------------------------------------
+// Stand in for the shader compiler of the -permutations tool. It records the order the
+// worker compiles the permutations in, fails the compile of one and returns byte code the
+// device rejects for another. The others get a minimal hull and domain shader pair.
+//--------------------------------------------------------------------------------------
+static const DWORD PERMUTATION_COMPILE_FAILS = 6;
+static const DWORD PERMUTATION_CREATE_FAILS = 7;
+
+static const char g_szPermutationStubShaders[] =
+    "struct CONTROL_POINT { float4 f4Position : POSITION; };\n"
+    "struct PATCH_CONSTANTS { float fEdges[3] : SV_TessFactor; float fInside : SV_InsideTessFactor; };\n"
+    "PATCH_CONSTANTS HS_Constants()\n"
+    "{\n"
+    "    PATCH_CONSTANTS Out;\n"
+    "    Out.fEdges[0] = 1.0f; Out.fEdges[1] = 1.0f; Out.fEdges[2] = 1.0f; Out.fInside = 1.0f;\n"
+    "    return Out;\n"
+    "}\n"
+    "[domain(\"tri\")] [partitioning(\"integer\")] [outputtopology(\"triangle_cw\")] [outputcontrolpoints(3)] [patchconstantfunc(\"HS_Constants\")]\n"
+    "CONTROL_POINT HS( InputPatch<CONTROL_POINT, 3> Patch, uint i : SV_OutputControlPointID ) { return Patch[i]; }\n"
+    "[domain(\"tri\")]\n"
+    "float4 DS( PATCH_CONSTANTS Constants, float3 f3UVW : SV_DomainLocation, const OutputPatch<CONTROL_POINT, 3> Patch ) : SV_Position\n"
+    "{\n"
+    "    return Patch[0].f4Position * f3UVW.x + Patch[1].f4Position * f3UVW.y + Patch[2].f4Position * f3UVW.z;\n"
+    "}\n";
+
+static ID3DBlob* g_pPermutationStubHullCode = NULL;
+static ID3DBlob* g_pPermutationStubDomainCode = NULL;
+static std::vector<DWORD> g_PermutationCompileOrder;    // Only written on the worker
+
+static HRESULT CompilePermutationStub( const WCHAR* pszSourceFile, DWORD dwFlags, ID3DBlob** ppHullCode, ID3DBlob** ppDomainCode )
+{
+    g_PermutationCompileOrder.push_back( dwFlags );
+
+    if( PERMUTATION_COMPILE_FAILS == dwFlags )
+    {
+        return E_FAIL;
+    }
+
+    if( PERMUTATION_CREATE_FAILS == dwFlags )
+    {
+        if( FAILED( D3DCreateBlob( 16, ppHullCode ) ) )
+        {
+            return E_OUTOFMEMORY;
+        }
+        if( FAILED( D3DCreateBlob( 16, ppDomainCode ) ) )
+        {
+            SAFE_RELEASE( *ppHullCode );
+            return E_OUTOFMEMORY;
+        }
+        ZeroMemory( ( *ppHullCode )->GetBufferPointer(), 16 );
+        ZeroMemory( ( *ppDomainCode )->GetBufferPointer(), 16 );
+        return S_OK;
+    }
+
+    g_pPermutationStubHullCode->AddRef();
+    g_pPermutationStubDomainCode->AddRef();
+    *ppHullCode = g_pPermutationStubHullCode;
+    *ppDomainCode = g_pPermutationStubDomainCode;
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns the permutations whose shaders are in the maps, as "1 2 3"
+//--------------------------------------------------------------------------------------
+static void GetCreatedPermutations( const HULL_SHADER_MAP* pHullShaders, const DOMAIN_SHADER_MAP* pDomainShaders, WCHAR* pszCreated, size_t uMaxChars )
+{
+    pszCreated[0] = 0;
+    for( HULL_SHADER_MAP::const_iterator it = pHullShaders->begin(); it != pHullShaders->end(); it++ )
+    {
+        DOMAIN_SHADER_MAP::const_iterator itDomain = pDomainShaders->find( it->first );
+        if( NULL != it->second && pDomainShaders->end() != itDomain && NULL != itDomain->second )
+        {
+            WCHAR szFlags[16];
+            swprintf_s( szFlags, L"%s%u", ( 0 != pszCreated[0] ) ? L" " : L"", it->first );
+            wcscat_s( pszCreated, uMaxChars, szFlags );
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Drives CShaderPermutations with a stand in compiler and a WARP device. The requests are
+// made before the worker starts, so it serves them in priority order, a queued request
+// raised or requested again moving ahead. One permutation fails to compile, and one is
+// rejected by the device, which must not keep the others from being created. One is not
+// in the maps at first, and is created once it is added. After OnDestroyDevice all the
+// compiled permutations are created again without compiling. Fails if the order, the
+// failures or the created shaders differ from those expected.
+//--------------------------------------------------------------------------------------
+HRESULT RunPermutationsTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT WAIT_MS = 10000;
+    static const DWORD UNREGISTERED = 4;
+
+    // Flags (any key will do) and priority, in the order requested
+    static const struct { DWORD dwFlags; SHADER_PERMUTATION_PRIORITY ePriority; } REQUESTS[] =
+    {
+        { 1, SHADER_PERMUTATION_PRIORITY_PREFETCH },
+        { 2, SHADER_PERMUTATION_PRIORITY_PREFETCH },
+        { 3, SHADER_PERMUTATION_PRIORITY_DRAWN },
+        { 4, SHADER_PERMUTATION_PRIORITY_PREFETCH },
+        { 5, SHADER_PERMUTATION_PRIORITY_SELECTED },
+        { 6, SHADER_PERMUTATION_PRIORITY_PREFETCH },
+        { 7, SHADER_PERMUTATION_PRIORITY_DRAWN },
+        { 1, SHADER_PERMUTATION_PRIORITY_PREFETCH },    // Ahead of 6 and 4
+        { 2, SHADER_PERMUTATION_PRIORITY_DRAWN },       // Raised, ahead of 7
+        { 3, SHADER_PERMUTATION_PRIORITY_PREFETCH },    // Stays drawn, ahead of 2
+    };
+    static const DWORD EXPECTED_ORDER[] = { 5, 3, 2, 7, 1, 6, 4 };
+    static const UINT NUM_PERMUTATIONS = ARRAYSIZE( EXPECTED_ORDER );
+
+    ID3DBlob* pErrors = NULL;
+    HRESULT hrCompile = D3DCompile( g_szPermutationStubShaders, sizeof( g_szPermutationStubShaders ) - 1, "PermutationStub", NULL, NULL, "HS",
+                                    "hs_5_0", 0, 0, &g_pPermutationStubHullCode, &pErrors );
+    SAFE_RELEASE( pErrors );
+    if( SUCCEEDED( hrCompile ) )
+    {
+        hrCompile = D3DCompile( g_szPermutationStubShaders, sizeof( g_szPermutationStubShaders ) - 1, "PermutationStub", NULL, NULL, "DS",
+                                "ds_5_0", 0, 0, &g_pPermutationStubDomainCode, &pErrors );
+        SAFE_RELEASE( pErrors );
+    }
+
+    ID3D11Device* pDevice = NULL;
+    D3D_FEATURE_LEVEL FeatureLevel = D3D_FEATURE_LEVEL_11_0;
+    if( FAILED( hrCompile ) ||
+        FAILED( D3D11CreateDevice( NULL, D3D_DRIVER_TYPE_WARP, NULL, 0, &FeatureLevel, 1, D3D11_SDK_VERSION, &pDevice, NULL, NULL ) ) )
+    {
+        HeadlessReport( L"Failed to compile the stand in shaders or to create a WARP device" );
+        SAFE_RELEASE( g_pPermutationStubHullCode );
+        SAFE_RELEASE( g_pPermutationStubDomainCode );
+        return E_FAIL;
+    }
+
+    CShaderPermutations Permutations;
+    g_PermutationCompileOrder.clear();
+    for( UINT i = 0; i < ARRAYSIZE( REQUESTS ); i++ )
+    {
+        Permutations.Request( REQUESTS[i].dwFlags, REQUESTS[i].ePriority );
+    }
+
+    // The worker starts with the queue full
+    SHADER_PERMUTATION_STATS Stats;
+    ZeroMemory( &Stats, sizeof( Stats ) );
+    if( SUCCEEDED( Permutations.Create( L"", CompilePermutationStub ) ) )
+    {
+        double fStart = GetTimeInMs();
+        for( ;; )
+        {
+            Permutations.GetStats( &Stats );
+            if( ( 0 == Stats.uNumQueued && Stats.uNumCompiled + Stats.uNumFailed >= NUM_PERMUTATIONS ) || GetTimeInMs() - fStart > WAIT_MS )
+            {
+                break;
+            }
+            Sleep( 1 );
+        }
+    }
+
+    WCHAR szOrder[64] = L"", szExpected[64] = L"";
+    for( UINT i = 0; i < NUM_PERMUTATIONS; i++ )
+    {
+        WCHAR szFlags[16];
+        swprintf_s( szFlags, L"%s%u", ( 0 != i ) ? L" " : L"", EXPECTED_ORDER[i] );
+        wcscat_s( szExpected, szFlags );
+        if( i < (UINT)g_PermutationCompileOrder.size() )
+        {
+            swprintf_s( szFlags, L"%s%u", ( 0 != i ) ? L" " : L"", g_PermutationCompileOrder[i] );
+            wcscat_s( szOrder, szFlags );
+        }
+    }
+    bool bPassed = ( g_PermutationCompileOrder.size() == NUM_PERMUTATIONS ) &&
+                   std::equal( EXPECTED_ORDER, EXPECTED_ORDER + NUM_PERMUTATIONS, g_PermutationCompileOrder.begin() );
+    hr = bPassed ? hr : E_FAIL;
+    HeadlessReport( L"%-42s %-16s expected %-16s %s", L"Compile order", szOrder, szExpected, bPassed ? L"ok" : L"FAILED" );
+
+    // A failed permutation is not queued again
+    Permutations.Request( PERMUTATION_COMPILE_FAILS, SHADER_PERMUTATION_PRIORITY_SELECTED );
+    Permutations.GetStats( &Stats );
+    bPassed = Permutations.IsFailed( PERMUTATION_COMPILE_FAILS ) && 0 == Stats.uNumQueued && 1 == Stats.uNumFailed &&
+              NUM_PERMUTATIONS - 1 == Stats.uNumCompiled;
+    hr = bPassed ? hr : E_FAIL;
+    HeadlessReport( L"%-42s %u compiled, %u failed, %u queued %s", L"Compile failure, requested again", Stats.uNumCompiled, Stats.uNumFailed,
+                    Stats.uNumQueued, bPassed ? L"ok" : L"FAILED" );
+
+    // All but one in the maps, as the sample registers them
+    HULL_SHADER_MAP HullShaders;
+    DOMAIN_SHADER_MAP DomainShaders;
+    for( UINT i = 0; i < NUM_PERMUTATIONS; i++ )
+    {
+        if( UNREGISTERED != EXPECTED_ORDER[i] )
+        {
+            HullShaders[EXPECTED_ORDER[i]] = NULL;
+            DomainShaders[EXPECTED_ORDER[i]] = NULL;
+        }
+    }
+
+    WCHAR szCreated[64];
+    HRESULT hrCreate = Permutations.CreateShaders( pDevice, &HullShaders, &DomainShaders );
+    GetCreatedPermutations( &HullShaders, &DomainShaders, szCreated, _countof( szCreated ) );
+    Permutations.GetStats( &Stats );
+    bPassed = FAILED( hrCreate ) && 0 == wcscmp( szCreated, L"1 2 3 5" ) && Permutations.IsFailed( PERMUTATION_CREATE_FAILS ) && 2 == Stats.uNumFailed;
+    hr = bPassed ? hr : E_FAIL;
+    HeadlessReport( L"%-42s %-16s expected %-16s %s", L"Create, one rejected and one unregistered", szCreated, L"1 2 3 5", bPassed ? L"ok" : L"FAILED" );
+
+    HullShaders[UNREGISTERED] = NULL;
+    DomainShaders[UNREGISTERED] = NULL;
+    hrCreate = Permutations.CreateShaders( pDevice, &HullShaders, &DomainShaders );
+    GetCreatedPermutations( &HullShaders, &DomainShaders, szCreated, _countof( szCreated ) );
+    bPassed = SUCCEEDED( hrCreate ) && 0 == wcscmp( szCreated, L"1 2 3 4 5" );
+    hr = bPassed ? hr : E_FAIL;
+    HeadlessReport( L"%-42s %-16s expected %-16s %s", L"Create, after registering", szCreated, L"1 2 3 4 5", bPassed ? L"ok" : L"FAILED" );
+
+    // A device change releases the shaders, the byte code is kept
+    for( HULL_SHADER_MAP::iterator it = HullShaders.begin(); it != HullShaders.end(); it++ )
+    {
+        SAFE_RELEASE( it->second );
+    }
+    for( DOMAIN_SHADER_MAP::iterator it = DomainShaders.begin(); it != DomainShaders.end(); it++ )
+    {
+        SAFE_RELEASE( it->second );
+    }
+    Permutations.OnDestroyDevice();
+    hrCreate = Permutations.CreateShaders( pDevice, &HullShaders, &DomainShaders );
+    GetCreatedPermutations( &HullShaders, &DomainShaders, szCreated, _countof( szCreated ) );
+    bPassed = SUCCEEDED( hrCreate ) && 0 == wcscmp( szCreated, L"1 2 3 4 5" ) && NUM_PERMUTATIONS == g_PermutationCompileOrder.size();
+    hr = bPassed ? hr : E_FAIL;
+    HeadlessReport( L"%-42s %-16s expected %-16s %s", L"Create again after OnDestroyDevice", szCreated, L"1 2 3 4 5", bPassed ? L"ok" : L"FAILED" );
+
+    for( HULL_SHADER_MAP::iterator it = HullShaders.begin(); it != HullShaders.end(); it++ )
+    {
+        SAFE_RELEASE( it->second );
+    }
+    for( DOMAIN_SHADER_MAP::iterator it = DomainShaders.begin(); it != DomainShaders.end(); it++ )
+    {
+        SAFE_RELEASE( it->second );
+    }
+    Permutations.Destroy();
+    SAFE_RELEASE( pDevice );
+    SAFE_RELEASE( g_pPermutationStubHullCode );
+    SAFE_RELEASE( g_pPermutationStubDomainCode );
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------
@@ -0,0 +1,1628 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TessFactorTools.cpp
+//
+// Tools of the tess factors and the paths that draw them: heatmaps, policies, foveated,
+// dynamic resolution, motion and multi view factors, the tessellation passes and paths,
+// and silhouette clipping.
+//--------------------------------------------------------------------------------------
+#include "..\\..\\DXUT\\Core\\DXUT.h"
+#include "..\\..\\DXUT\\Optional\\SDKmesh.h"
+#include "HeadlessTools.h"
+#include "MeshBake.h"
+#include "TessFactors.h"
+#include "TessPolicy.h"
+#include "DynamicResolution.h"
+#include "CameraMotion.h"
+#include "MultiViewFactors.h"
+#include "TessPath.h"
+#include "SilhouetteClip.h"
+#include <float.h>
+#include <iterator>
+
+using namespace DirectX;
+
+
+//--------------------------------------------------------------------------------------
+// Returns the view and projection of a camera orbiting the center of the mesh, one
+// diagonal away and fDegrees around it
+//--------------------------------------------------------------------------------------
+static void GetOrbitCamera( const MESH_DATA* pMeshData, float fDegrees, UINT uWidth, UINT uHeight, XMMATRIX* pmView, XMMATRIX* pmProj )
+{
+    static const float CAMERA_PITCH = XM_PI / 9.0f;
+
+    float fDiagonal = GetMeshDataBoundsDiagonal( pMeshData );
+    XMVECTOR vCenter = XMVectorScale( XMVectorAdd( XMLoadFloat3( &pMeshData->f3BoundsMin ), XMLoadFloat3( &pMeshData->f3BoundsMax ) ), 0.5f );
+    float fYaw = XMConvertToRadians( fDegrees );
+    XMVECTOR vOffset = XMVectorSet( sinf( fYaw ) * cosf( CAMERA_PITCH ), sinf( CAMERA_PITCH ), -cosf( fYaw ) * cosf( CAMERA_PITCH ), 0.0f );
+    XMVECTOR vEye = XMVectorAdd( vCenter, XMVectorScale( vOffset, fDiagonal ) );
+    *pmView = XMMatrixLookAtLH( vEye, vCenter, XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f ) );
+    *pmProj = XMMatrixPerspectiveFovLH( XM_PI / 4.0f, (float)uWidth / (float)uHeight, 0.01f * fDiagonal, 10.0f * fDiagonal );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Fills the tess factor constants of a view of a mesh, with the distance range scaled to
+// the mesh
+//--------------------------------------------------------------------------------------
+static void InitMeshViewTessFactorConstants( const MESH_DATA* pMeshData, CXMMATRIX mView, CXMMATRIX mProj, float fMaxFactor, UINT uWidth,
+                                             UINT uHeight, TESS_FACTOR_CONSTANTS* pConstants )
+{
+    float fDiagonal = GetMeshDataBoundsDiagonal( pMeshData );
+
+    InitTessFactorConstants( mView, mProj, uWidth, uHeight, pConstants );
+    pConstants->fEdgeTessFactors = fMaxFactor;
+    pConstants->fMinDistance = 0.5f * fDiagonal;
+    pConstants->fTessRange = 2.0f * fDiagonal;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Fills the tess factor constants for a camera orbiting the center of the mesh, one
+// diagonal away and fDegrees around it, with the distance range scaled to the mesh
+//--------------------------------------------------------------------------------------
+static void InitOrbitTessFactorConstants( const MESH_DATA* pMeshData, float fDegrees, float fMaxFactor, UINT uWidth, UINT uHeight,
+                                          TESS_FACTOR_CONSTANTS* pConstants )
+{
+    XMMATRIX mView, mProj;
+    GetOrbitCamera( pMeshData, fDegrees, uWidth, uHeight, &mView, &mProj );
+
+    InitMeshViewTessFactorConstants( pMeshData, mView, mProj, fMaxFactor, uWidth, uHeight, pConstants );
+}
+
+//--------------------------------------------------------------------------------------
+// Computes the tess factors of every patch of a mesh with a CPU reference of
+// HS_PNTrianglesConstant, for a HullShaderHash permutation and a camera orbiting the mesh,
+// and writes them as per face colours to <mesh>_tessfactors.ply and one line per patch to
+// <mesh>_tessfactors.csv in the current directory. The report has histograms of the inside
+// factors and of the pixels per output triangle, where patches below a pixel per triangle
+// are spending triangles that can't be seen.
+// Param: flags[,mesh[,degrees[,factor]]], the HullShaderHash flags (default PNTRI |
+// DIST_ADAPT | ORIENT_ADAPT | BF_CULL | FRUST_CULL), the index of a bundled mesh (default
+// all), the angle of the camera around the mesh (default 30) and the maximum tess factor
+// (default 5, as the UI)
+//--------------------------------------------------------------------------------------
+HRESULT RunTessHeatmapTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT NUM_FACTOR_BINS = 8;      // Odd factors 1 to 15, as fractional_odd rounds up
+    static const float PIXEL_BINS[] = { 0.25f, 1.0f, 4.0f, 16.0f, 64.0f, FLT_MAX };
+    static const UINT NUM_PIXEL_BINS = ARRAYSIZE( PIXEL_BINS );
+
+    DWORD dwFlags = PNTRI | DIST_ADAPT | ORIENT_ADAPT | BF_CULL | FRUST_CULL;
+    UINT uFirstMesh = 0, uLastMesh = ARRAYSIZE( g_pszBundledMeshes ) - 1;
+    float fDegrees = 30.0f;
+    float fMaxFactor = 5.0f;
+
+    // Comma separated, each optional
+    const WCHAR* pszNext = pszParam;
+    WCHAR* pszEnd = NULL;
+    for( UINT uParam = 0; pszNext[0] != 0; uParam++ )
+    {
+        if( pszNext[0] != L',' )
+        {
+            switch( uParam )
+            {
+            case 0: dwFlags = (DWORD)wcstoul( pszNext, &pszEnd, 0 ); break;
+            case 1: uFirstMesh = uLastMesh = (UINT)wcstoul( pszNext, &pszEnd, 0 ); break;
+            case 2: fDegrees = (float)wcstod( pszNext, &pszEnd ); break;
+            case 3: fMaxFactor = (float)wcstod( pszNext, &pszEnd ); break;
+            default: pszEnd = (WCHAR*)pszNext; break;
+            }
+            pszNext = pszEnd;
+        }
+        if( pszNext[0] != 0 && pszNext[0] != L',' )
+        {
+            HeadlessReport( L"Expected flags[,mesh[,degrees[,factor]]], got %s", pszParam );
+            return E_INVALIDARG;
+        }
+        pszNext += ( pszNext[0] == L',' ) ? 1 : 0;
+    }
+    if( uLastMesh >= ARRAYSIZE( g_pszBundledMeshes ) )
+    {
+        HeadlessReport( L"Mesh %u out of range, %u bundled meshes", uLastMesh, (UINT)ARRAYSIZE( g_pszBundledMeshes ) );
+        return E_INVALIDARG;
+    }
+    fMaxFactor = std::min( std::max( fMaxFactor, TESS_MIN_FACTOR ), TESS_MAX_FACTOR );
+
+    HeadlessReport( L"Flags 0x%x%s%s%s%s%s%s%s, max factor %.1f, camera at %.0f degrees, %ux%u", dwFlags,
+                    ( dwFlags & SS_ADAPT ) ? L" SS_ADAPT" : L"", ( dwFlags & DIST_ADAPT ) ? L" DIST_ADAPT" : L"",
+                    ( dwFlags & RES_ADAPT ) ? L" RES_ADAPT" : L"", ( dwFlags & ORIENT_ADAPT ) ? L" ORIENT_ADAPT" : L"",
+                    ( dwFlags & FOVEA_ADAPT ) ? L" FOVEA_ADAPT" : L"",
+                    ( dwFlags & BF_CULL ) ? L" BF_CULL" : L"", ( dwFlags & FRUST_CULL ) ? L" FRUST_CULL" : L"",
+                    fMaxFactor, fDegrees, ORBIT_SCREEN_WIDTH, ORBIT_SCREEN_HEIGHT );
+
+    for( UINT uMesh = uFirstMesh; uMesh <= uLastMesh; uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        TESS_FACTOR_CONSTANTS Constants;
+        InitOrbitTessFactorConstants( &MeshData, fDegrees, fMaxFactor, ORBIT_SCREEN_WIDTH, ORBIT_SCREEN_HEIGHT, &Constants );
+
+        std::vector<TESS_HEATMAP_PATCH> Heatmap;
+        BuildTessHeatmap( &MeshData, dwFlags, &Constants, &Heatmap );
+
+        UINT uNumCulled = 0, uNumBehind = 0;
+        UINT64 uNumTriangles = 0;
+        double fInsideSum = 0.0;
+        UINT uFactorPatches[NUM_FACTOR_BINS] = { 0 };
+        UINT64 uFactorTriangles[NUM_FACTOR_BINS] = { 0 };
+        UINT uPixelPatches[NUM_PIXEL_BINS] = { 0 };
+        UINT64 uPixelTriangles[NUM_PIXEL_BINS] = { 0 };
+        for( UINT uPatch = 0; uPatch < (UINT)Heatmap.size(); uPatch++ )
+        {
+            const TESS_HEATMAP_PATCH& Patch = Heatmap[uPatch];
+            if( Patch.bCulled )
+            {
+                uNumCulled++;
+                continue;
+            }
+
+            uNumTriangles += Patch.uNumTriangles;
+            fInsideSum += Patch.Factors.fInside;
+
+            float fInside = std::min( std::max( Patch.Factors.fInside, TESS_MIN_FACTOR ), TESS_MAX_FACTOR );
+            UINT uFactorBin = std::min( (UINT)ceilf( ( fInside - 1.0f ) / 2.0f ), NUM_FACTOR_BINS - 1 );
+            uFactorPatches[uFactorBin]++;
+            uFactorTriangles[uFactorBin] += Patch.uNumTriangles;
+
+            if( Patch.fScreenArea <= 0.0f )
+            {
+                uNumBehind++;
+                continue;
+            }
+            float fPixels = Patch.fScreenArea / (float)Patch.uNumTriangles;
+            UINT uPixelBin = 0;
+            while( fPixels >= PIXEL_BINS[uPixelBin] )
+            {
+                uPixelBin++;
+            }
+            uPixelPatches[uPixelBin]++;
+            uPixelTriangles[uPixelBin] += Patch.uNumTriangles;
+        }
+
+        UINT uNumPatches = (UINT)Heatmap.size();
+        UINT uNumKept = uNumPatches - uNumCulled;
+        double fTriangles = std::max( (double)uNumTriangles, 1.0 );
+        HeadlessReport( L"" );
+        HeadlessReport( L"%s: %u patches, %.1f%% culled, %llu triangles output, mean inside factor %.2f, %u patches cross the eye plane",
+                        g_pszBundledMeshes[uMesh], uNumPatches, 100.0 * uNumCulled / std::max( uNumPatches, 1u ), uNumTriangles,
+                        fInsideSum / std::max( uNumKept, 1u ), uNumBehind );
+
+        HeadlessReport( L"  %-14s %9s %9s %11s %9s", L"Inside factor", L"Patches", L"Patches%", L"Triangles", L"Tris%" );
+        for( UINT uBin = 0; uBin < NUM_FACTOR_BINS; uBin++ )
+        {
+            WCHAR szBin[32];
+            if( 0 == uBin )
+            {
+                swprintf_s( szBin, L"1" );
+            }
+            else
+            {
+                swprintf_s( szBin, L"(%u, %u]", 2 * uBin - 1, 2 * uBin + 1 );
+            }
+            HeadlessReport( L"  %-14s %9u %8.1f%% %11llu %8.1f%%", szBin, uFactorPatches[uBin], 100.0 * uFactorPatches[uBin] / std::max( uNumKept, 1u ),
+                            uFactorTriangles[uBin], 100.0 * uFactorTriangles[uBin] / fTriangles );
+        }
+
+        UINT64 uNumWasted = 0;
+        HeadlessReport( L"  %-14s %9s %9s %11s %9s", L"Pixels / tri", L"Patches", L"Patches%", L"Triangles", L"Tris%" );
+        for( UINT uBin = 0; uBin < NUM_PIXEL_BINS; uBin++ )
+        {
+            WCHAR szBin[32];
+            if( 0 == uBin )
+            {
+                swprintf_s( szBin, L"< %g", PIXEL_BINS[uBin] );
+            }
+            else if( uBin + 1 == NUM_PIXEL_BINS )
+            {
+                swprintf_s( szBin, L">= %g", PIXEL_BINS[uBin - 1] );
+            }
+            else
+            {
+                swprintf_s( szBin, L"[%g, %g)", PIXEL_BINS[uBin - 1], PIXEL_BINS[uBin] );
+            }
+            HeadlessReport( L"  %-14s %9u %8.1f%% %11llu %8.1f%%", szBin, uPixelPatches[uBin], 100.0 * uPixelPatches[uBin] / std::max( uNumKept, 1u ),
+                            uPixelTriangles[uBin], 100.0 * uPixelTriangles[uBin] / fTriangles );
+            if( PIXEL_BINS[uBin] <= 1.0f )
+            {
+                uNumWasted += uPixelTriangles[uBin];
+            }
+        }
+        HeadlessReport( L"  %.1f%% of the triangles are in patches below a pixel per triangle", 100.0 * uNumWasted / fTriangles );
+
+        // Written to the current directory
+        WCHAR szName[MAX_PATH];
+        const WCHAR* pszLastSlash = wcsrchr( g_pszBundledMeshes[uMesh], L'\\' );
+        wcscpy_s( szName, ( NULL != pszLastSlash ) ? pszLastSlash + 1 : g_pszBundledMeshes[uMesh] );
+        WCHAR* pszExtension = wcsrchr( szName, L'.' );
+        if( NULL != pszExtension )
+        {
+            *pszExtension = 0;
+        }
+
+        WCHAR szPLYFileName[MAX_PATH], szCSVFileName[MAX_PATH];
+        swprintf_s( szPLYFileName, L"%s_tessfactors.ply", szName );
+        swprintf_s( szCSVFileName, L"%s_tessfactors.csv", szName );
+        if( FAILED( WriteTessHeatmapPLY( szPLYFileName, &MeshData, &Heatmap[0], fMaxFactor ) ) ||
+            FAILED( WriteTessHeatmapCSV( szCSVFileName, &MeshData, &Heatmap[0] ) ) )
+        {
+            HeadlessReport( L"  failed to write %s and %s", szPLYFileName, szCSVFileName );
+            hr = E_FAIL;
+            continue;
+        }
+        HeadlessReport( L"  wrote %s and %s", szPLYFileName, szCSVFileName );
+    }
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+// Compares the patches tessellated and triangles output with and without the per material
+// tessellation policies of each bundled mesh, for the tessheatmap tool's default camera
+// and flags. Subsets of a policy that doesn't tessellate draw their triangles as they are.
+// The app draws each policy as one batch, so the report also has the number of batches
+// (shader binds) against the number of subsets.
+// Param: a .tesspolicy file used for every mesh, <mesh>.tesspolicy next to each mesh if
+// none (meshes without one are skipped)
+//--------------------------------------------------------------------------------------
+HRESULT RunTessPolicyTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const DWORD UI_FLAGS = PNTRI | DIST_ADAPT | ORIENT_ADAPT | BF_CULL | FRUST_CULL;
+    static const float UI_TESS_FACTOR = 5.0f;
+    static const float CAMERA_DEGREES = 30.0f;
+
+    HeadlessReport( L"Flags 0x%x, max factor %.1f, camera at %.0f degrees, %ux%u", UI_FLAGS, UI_TESS_FACTOR, CAMERA_DEGREES,
+                    ORBIT_SCREEN_WIDTH, ORBIT_SCREEN_HEIGHT );
+
+    UINT uNumCompared = 0;
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        CDXUTSDKMesh SourceMesh;
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData, &SourceMesh ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        WCHAR szPolicyFileName[MAX_PATH];
+        if( 0 != pszParam[0] )
+        {
+            wcscpy_s( szPolicyFileName, pszParam );
+        }
+        else
+        {
+            const WCHAR* pszLastSlash = wcsrchr( g_pszBundledMeshes[uMesh], L'\\' );
+            swprintf_s( szPolicyFileName, L"%s%s", SourceMesh.GetMeshPathW(), ( NULL != pszLastSlash ) ? pszLastSlash + 1 : g_pszBundledMeshes[uMesh] );
+            WCHAR* pszExtension = wcsrchr( szPolicyFileName, L'.' );
+            if( NULL != pszExtension )
+            {
+                *pszExtension = 0;
+            }
+            wcscat_s( szPolicyFileName, L".tesspolicy" );
+        }
+
+        CTessPolicyTable Policies;
+        UINT uErrorLine = 0;
+        if( FAILED( Policies.Load( szPolicyFileName, &uErrorLine ) ) )
+        {
+            if( 0 != uErrorLine )
+            {
+                HeadlessReport( L"%s(%u): invalid tessellation policy", szPolicyFileName, uErrorLine );
+                hr = E_FAIL;
+            }
+            else
+            {
+                HeadlessReport( L"%-32s no %s, skipped", g_pszBundledMeshes[uMesh], szPolicyFileName );
+            }
+            SourceMesh.Destroy();
+            continue;
+        }
+        Policies.AssignMaterials( &SourceMesh );
+        uNumCompared++;
+
+        HeadlessReport( L"" );
+        HeadlessReport( L"%s: %u materials, %u subsets, policies from %s", g_pszBundledMeshes[uMesh], SourceMesh.GetNumMaterials(),
+                        (UINT)MeshData.Subsets.size(), szPolicyFileName );
+        for( UINT uMaterial = 0; uMaterial < Policies.GetNumMaterials(); uMaterial++ )
+        {
+            char szName[MAX_MATERIAL_NAME + 1];
+            strncpy_s( szName, sizeof( szName ), SourceMesh.GetMaterial( uMaterial )->Name, MAX_MATERIAL_NAME );
+            HeadlessReport( L"  material %2u %-24S -> %S", uMaterial, szName,
+                            Policies.GetPolicy( Policies.GetMaterialPolicy( uMaterial ) )->Material.c_str() );
+        }
+        SourceMesh.Destroy();
+
+        TESS_FACTOR_CONSTANTS Constants;
+        InitOrbitTessFactorConstants( &MeshData, CAMERA_DEGREES, UI_TESS_FACTOR, ORBIT_SCREEN_WIDTH, ORBIT_SCREEN_HEIGHT, &Constants );
+
+        // Without policies, every subset as the UI has it
+        std::vector<TESS_HEATMAP_PATCH> Heatmap;
+        BuildTessHeatmap( &MeshData, UI_FLAGS, &Constants, &Heatmap );
+        UINT uNumPatches = (UINT)Heatmap.size();
+        UINT uUIPatches = 0;
+        UINT64 uUITriangles = 0;
+        for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+        {
+            if( !Heatmap[uPatch].bCulled )
+            {
+                uUIPatches++;
+                uUITriangles += Heatmap[uPatch].uNumTriangles;
+            }
+        }
+
+        // With policies, the subsets of each policy with its flags and factor
+        HeadlessReport( L"  %-24s %-4s %6s %10s %9s %9s %11s", L"Policy", L"Tess", L"Factor", L"Flags", L"Subsets", L"Patches", L"Triangles" );
+        UINT uPolicyPatches = 0, uNumBatches = 0;
+        UINT64 uPolicyTriangles = 0;
+        for( UINT uPolicy = 0; uPolicy < Policies.GetNumPolicies(); uPolicy++ )
+        {
+            if( !Policies.IsPolicyUsed( uPolicy ) )
+            {
+                continue;
+            }
+            uNumBatches++;
+
+            const TESS_POLICY* pPolicy = Policies.GetPolicy( uPolicy );
+            DWORD dwFlags = GetTessPolicyFlags( pPolicy, UI_FLAGS );
+            float fFactor = GetTessPolicyFactor( pPolicy, UI_TESS_FACTOR );
+            if( 0 != dwFlags )
+            {
+                Constants.fEdgeTessFactors = fFactor;
+                BuildTessHeatmap( &MeshData, dwFlags, &Constants, &Heatmap );
+            }
+
+            UINT uNumSubsets = 0, uNumKept = 0;
+            UINT64 uNumTriangles = 0;
+            for( UINT uSubset = 0; uSubset < (UINT)MeshData.Subsets.size(); uSubset++ )
+            {
+                const MESH_DATA_SUBSET& Subset = MeshData.Subsets[uSubset];
+                if( Policies.GetMaterialPolicy( Subset.uMaterialID ) != uPolicy )
+                {
+                    continue;
+                }
+                uNumSubsets++;
+
+                UINT uFirstPatch = Subset.uIndexStart / 3;
+                UINT uLastPatch = std::min( ( Subset.uIndexStart + Subset.uIndexCount ) / 3, uNumPatches );
+                if( 0 == dwFlags )
+                {
+                    uNumTriangles += uLastPatch - uFirstPatch;
+                    continue;
+                }
+                for( UINT uPatch = uFirstPatch; uPatch < uLastPatch; uPatch++ )
+                {
+                    if( !Heatmap[uPatch].bCulled )
+                    {
+                        uNumKept++;
+                        uNumTriangles += Heatmap[uPatch].uNumTriangles;
+                    }
+                }
+            }
+            uPolicyPatches += uNumKept;
+            uPolicyTriangles += uNumTriangles;
+
+            HeadlessReport( L"  %-24S %-4s %6.1f %#10x %9u %9u %11llu", pPolicy->Material.c_str(), pPolicy->bTessellate ? L"on" : L"off",
+                            fFactor, dwFlags, uNumSubsets, uNumKept, uNumTriangles );
+        }
+
+        HeadlessReport( L"  %-24s %-4s %6.1f %#10x %9u %9u %11llu", L"UI only", L"on", UI_TESS_FACTOR, UI_FLAGS,
+                        (UINT)MeshData.Subsets.size(), uUIPatches, uUITriangles );
+        HeadlessReport( L"  Policies tessellate %.1f%% of the patches and output %.1f%% of the triangles of the UI only, in %u shader batches for %u subsets",
+                        100.0 * uPolicyPatches / std::max( uUIPatches, 1u ), 100.0 * uPolicyTriangles / std::max( (double)uUITriangles, 1.0 ),
+                        uNumBatches, (UINT)MeshData.Subsets.size() );
+    }
+
+    if( 0 == uNumCompared && SUCCEEDED( hr ) )
+    {
+        HeadlessReport( L"No tessellation policies found" );
+    }
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+// Reports the triangles the foveated factor scale (FOVEA_ADAPT) saves over the same flags
+// without it, with the focus at the center of a 1080p and a 4K screen and typical inner
+// radii. The outer radius is the inner one plus TESS_FOVEA_OUTER_RADIUS -
+// TESS_FOVEA_INNER_RADIUS and the periphery scale is TESS_FOVEA_PERIPHERY_SCALE. Checks
+// that a periphery scale of 1 leaves the factors of the CPU reference unchanged.
+// Param: flags, the HullShaderHash flags FOVEA_ADAPT is added to (default PNTRI |
+// DIST_ADAPT | ORIENT_ADAPT | BF_CULL | FRUST_CULL)
+//--------------------------------------------------------------------------------------
+HRESULT RunFoveaTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT SCREEN_SIZES[][2] = { { 1920, 1080 }, { 3840, 2160 } };
+    static const float INNER_RADII[] = { 0.1f, 0.2f, 0.3f, 0.5f };
+    static const float CAMERA_DEGREES = 30.0f;
+    static const float MAX_FACTOR = 15.0f;
+
+    DWORD dwFlags = PNTRI | DIST_ADAPT | ORIENT_ADAPT | BF_CULL | FRUST_CULL;
+    if( 0 != pszParam[0] )
+    {
+        WCHAR* pszEnd = NULL;
+        dwFlags = (DWORD)wcstoul( pszParam, &pszEnd, 0 );
+        if( 0 != pszEnd[0] )
+        {
+            HeadlessReport( L"Expected flags, got %s", pszParam );
+            return E_INVALIDARG;
+        }
+    }
+    dwFlags &= ~FOVEA_ADAPT;
+
+    float fFalloff = TESS_FOVEA_OUTER_RADIUS - TESS_FOVEA_INNER_RADIUS;
+    HeadlessReport( L"Flags 0x%x, max factor %.1f, camera at %.0f degrees, focus at the center, outer radius = inner + %.2f, periphery scale %.2f",
+                    dwFlags, MAX_FACTOR, CAMERA_DEGREES, fFalloff, TESS_FOVEA_PERIPHERY_SCALE );
+    HeadlessReport( L"Radii are fractions of the screen height" );
+    HeadlessReport( L"%-32s %-10s %7s %11s %11s %8s", L"Mesh", L"Screen", L"Inner", L"Triangles", L"Foveated", L"Saved%" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        for( UINT uScreen = 0; uScreen < ARRAYSIZE( SCREEN_SIZES ); uScreen++ )
+        {
+            UINT uWidth = SCREEN_SIZES[uScreen][0], uHeight = SCREEN_SIZES[uScreen][1];
+            TESS_FACTOR_CONSTANTS Constants;
+            InitOrbitTessFactorConstants( &MeshData, CAMERA_DEGREES, MAX_FACTOR, uWidth, uHeight, &Constants );
+
+            std::vector<TESS_HEATMAP_PATCH> Reference, Foveated;
+            BuildTessHeatmap( &MeshData, dwFlags, &Constants, &Reference );
+            UINT64 uReferenceTriangles = 0;
+            for( UINT uPatch = 0; uPatch < (UINT)Reference.size(); uPatch++ )
+            {
+                uReferenceTriangles += Reference[uPatch].uNumTriangles;
+            }
+
+            // Without scaling at the periphery the factors must not change
+            Constants.fGUIFoveaPeripheryScale = 1.0f;
+            BuildTessHeatmap( &MeshData, dwFlags | FOVEA_ADAPT, &Constants, &Foveated );
+            float fMaxDifference = 0.0f;
+            for( UINT uPatch = 0; uPatch < (UINT)Reference.size(); uPatch++ )
+            {
+                for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+                {
+                    fMaxDifference = std::max( fMaxDifference, fabsf( Foveated[uPatch].Factors.fEdge[uEdge] - Reference[uPatch].Factors.fEdge[uEdge] ) );
+                }
+            }
+            if( fMaxDifference > 1e-5f )
+            {
+                HeadlessReport( L"%-32s a periphery scale of 1 changes the factors by %g", g_pszBundledMeshes[uMesh], fMaxDifference );
+                hr = E_FAIL;
+            }
+            Constants.fGUIFoveaPeripheryScale = TESS_FOVEA_PERIPHERY_SCALE;
+
+            WCHAR szScreen[32];
+            swprintf_s( szScreen, L"%ux%u", uWidth, uHeight );
+            for( UINT uRadius = 0; uRadius < ARRAYSIZE( INNER_RADII ); uRadius++ )
+            {
+                Constants.fFoveaInnerRadius = INNER_RADII[uRadius] * (float)uHeight;
+                Constants.fFoveaOuterRadius = ( INNER_RADII[uRadius] + fFalloff ) * (float)uHeight;
+                BuildTessHeatmap( &MeshData, dwFlags | FOVEA_ADAPT, &Constants, &Foveated );
+
+                UINT64 uFoveatedTriangles = 0;
+                for( UINT uPatch = 0; uPatch < (UINT)Foveated.size(); uPatch++ )
+                {
+                    uFoveatedTriangles += Foveated[uPatch].uNumTriangles;
+                }
+                HeadlessReport( L"%-32s %-10s %7.2f %11llu %11llu %7.1f%%", g_pszBundledMeshes[uMesh], szScreen, INNER_RADII[uRadius],
+                                uReferenceTriangles, uFoveatedTriangles,
+                                100.0 * ( 1.0 - (double)uFoveatedTriangles / std::max( (double)uReferenceTriangles, 1.0 ) ) );
+            }
+        }
+    }
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+// A synthetic GPU frame time trace for the dynamic resolution controller. The scene
+// costs fFixedMs + ( fPixelMs + fTessMs * tess scale ) * render scale^2 times the load,
+// which is fLoadBefore up to uStepFrame and fLoadAfter from it, with fNoise relative
+// noise and a fSpikeMs frame every uSpikePeriod frames. Without bResAdapt the tess
+// factors have no resolution term and the tess scale must stay at 1.
+//--------------------------------------------------------------------------------------
+struct DYNAMIC_RESOLUTION_TRACE
+{
+    const WCHAR*    pszName;
+    UINT            uNumFrames;
+    float           fFixedMs;
+    float           fPixelMs;
+    float           fTessMs;
+    UINT            uStepFrame;
+    float           fLoadBefore;
+    float           fLoadAfter;
+    UINT            uSpikePeriod;       // 0 for none
+    float           fSpikeMs;
+    float           fNoise;
+    bool            bResAdapt;
+
+    // Expectations
+    UINT            uMaxChanges;
+    UINT            uMaxReversals;      // Changes in the opposite direction of the one before
+    bool            bWithinBudget;      // Over the last frames
+    bool            bFullQuality;       // At the end
+};
+
+
+//--------------------------------------------------------------------------------------
+// Runs the dynamic resolution controller on synthetic GPU frame time traces: a steady
+// scene, a step in load with and without RES_ADAPT, single spikes, noise near the target
+// and a heavy load followed by a light one. The times reach the controller DYNAMIC_RESOLUTION_LATENCY frames late,
+// as from the GPU timer. Fails if a trace changes the scales more often or reverses more
+// than expected, ends over the budget or doesn't get back to full quality.
+// Param: target ms (default 16.7)
+//--------------------------------------------------------------------------------------
+HRESULT RunDynamicResolutionTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT DYNAMIC_RESOLUTION_LATENCY = 2;
+    static const UINT LAST_FRAMES = 100;
+    static const DYNAMIC_RESOLUTION_TRACE TRACES[] =
+    {
+        // Name                 Frames  Fixed  Pixel  Tess  Step  Before  After  Spikes  Spike  Noise  Res    Changes  Rev  Budget  Full
+        { L"steady",            600,    2.0f,  8.0f,  4.0f, 0,    1.0f,   1.0f,  0,      0.0f,  0.01f, true,  0,       0,   true,   true },
+        { L"step",              600,    2.0f,  8.0f,  4.0f, 100,  1.0f,   1.6f,  0,      0.0f,  0.01f, true,  12,      0,   true,   false },
+        { L"step, no RES",      600,    2.0f,  8.0f,  4.0f, 100,  1.0f,   1.6f,  0,      0.0f,  0.01f, false, 12,      0,   true,   false },
+        { L"spikes",            600,    2.0f,  7.0f,  3.0f, 0,    1.0f,   1.0f,  30,     35.0f, 0.01f, true,  0,       0,   true,   true },
+        { L"noisy",             1200,   2.0f,  9.5f,  5.2f, 0,    1.0f,   1.0f,  0,      0.0f,  0.08f, true,  6,       2,   true,   false },
+        { L"heavy then light",  1500,   2.0f,  8.0f,  4.0f, 300,  2.0f,   0.5f,  0,      0.0f,  0.01f, true,  40,      1,   true,   true },
+    };
+
+    float fTargetMs = 16.7f;
+    if( 0 != pszParam[0] )
+    {
+        WCHAR* pszEnd = NULL;
+        fTargetMs = (float)wcstod( pszParam, &pszEnd );
+        if( 0 != pszEnd[0] || fTargetMs <= 0.0f )
+        {
+            HeadlessReport( L"Expected a target in ms, got %s", pszParam );
+            return E_INVALIDARG;
+        }
+    }
+
+    DYNAMIC_RESOLUTION_SETTINGS Settings;
+    InitDynamicResolutionSettings( fTargetMs, &Settings );
+    HeadlessReport( L"Target %.2f ms, band %.2f - %.2f, %u frames to decrease, %u to increase, %u cooldown, %u frames latency",
+                    fTargetMs, Settings.fLowerBand, Settings.fUpperBand, Settings.uFramesToDecrease, Settings.uFramesToIncrease,
+                    Settings.uCooldownFrames, DYNAMIC_RESOLUTION_LATENCY );
+    HeadlessReport( L"%-18s %7s %8s %10s %8s %7s %6s %9s  %s", L"Trace", L"Frames", L"Changes", L"Reversals", L"Settled",
+                    L"Render", L"Tess", L"Last ms", L"Result" );
+
+    for( UINT uTrace = 0; uTrace < ARRAYSIZE( TRACES ); uTrace++ )
+    {
+        const DYNAMIC_RESOLUTION_TRACE* pTrace = &TRACES[uTrace];
+
+        CDynamicResolutionController Controller;
+        Controller.Init( &Settings );
+        Controller.SetTessScaleEnabled( pTrace->bResAdapt );
+
+        float fPendingMs[DYNAMIC_RESOLUTION_LATENCY + 1] = { 0 };
+        UINT uRandom = 12345;
+        UINT uNumReversals = 0, uLastChangeFrame = 0;
+        int iLastDirection = 0;
+        double fLastFramesMs = 0.0;
+        for( UINT uFrame = 0; uFrame < pTrace->uNumFrames; uFrame++ )
+        {
+            float fRenderScale = Controller.GetRenderScale();
+            float fTessScale = Controller.GetTessScale();
+            float fLoad = ( uFrame < pTrace->uStepFrame ) ? pTrace->fLoadBefore : pTrace->fLoadAfter;
+
+            uRandom = uRandom * 1664525 + 1013904223;
+            float fNoise = 1.0f + pTrace->fNoise * ( (float)( uRandom >> 8 ) / 8388608.0f - 1.0f );
+            float fFrameMs = ( pTrace->fFixedMs + ( pTrace->fPixelMs + pTrace->fTessMs * fTessScale ) * fRenderScale * fRenderScale ) * fLoad * fNoise;
+            if( 0 != pTrace->uSpikePeriod && 0 == ( uFrame + 1 ) % pTrace->uSpikePeriod )
+            {
+                fFrameMs = pTrace->fSpikeMs;
+            }
+            if( uFrame + LAST_FRAMES >= pTrace->uNumFrames )
+            {
+                fLastFramesMs += fFrameMs;
+            }
+
+            // The time of this frame is read DYNAMIC_RESOLUTION_LATENCY frames later
+            fPendingMs[uFrame % ( DYNAMIC_RESOLUTION_LATENCY + 1 )] = fFrameMs;
+            if( uFrame < DYNAMIC_RESOLUTION_LATENCY )
+            {
+                continue;
+            }
+            if( Controller.Update( fPendingMs[( uFrame - DYNAMIC_RESOLUTION_LATENCY ) % ( DYNAMIC_RESOLUTION_LATENCY + 1 )] ) )
+            {
+                int iDirection = ( Controller.GetRenderScale() + Controller.GetTessScale() > fRenderScale + fTessScale ) ? 1 : -1;
+                uNumReversals += ( 0 != iLastDirection && iDirection != iLastDirection ) ? 1 : 0;
+                iLastDirection = iDirection;
+                uLastChangeFrame = uFrame;
+            }
+        }
+        fLastFramesMs /= (double)LAST_FRAMES;
+
+        // Frames from the step in load (or the start) to the last change
+        UINT uNumChanges = Controller.GetNumChanges();
+        UINT uSettled = ( 0 == uNumChanges ) ? 0 : uLastChangeFrame - std::min( uLastChangeFrame, pTrace->uStepFrame );
+
+        bool bPassed = uNumChanges <= pTrace->uMaxChanges && uNumReversals <= pTrace->uMaxReversals;
+        if( pTrace->bWithinBudget && fLastFramesMs > fTargetMs * Settings.fUpperBand )
+        {
+            bPassed = false;
+        }
+        if( pTrace->bFullQuality && ( Controller.GetRenderScale() < 1.0f || Controller.GetTessScale() < 1.0f ) )
+        {
+            bPassed = false;
+        }
+        if( !pTrace->bResAdapt && Controller.GetTessScale() < 1.0f )
+        {
+            bPassed = false;
+        }
+        if( !bPassed )
+        {
+            hr = E_FAIL;
+        }
+
+        HeadlessReport( L"%-18s %7u %8u %10u %8u %7.2f %6.2f %9.3f  %s", pTrace->pszName, pTrace->uNumFrames, uNumChanges, uNumReversals,
+                        uSettled, Controller.GetRenderScale(), Controller.GetTessScale(), (float)fLastFramesMs,
+                        bPassed ? L"ok" : L"FAILED" );
+    }
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+// Builds a camera path of the -motion tool at 60Hz, in the units of CAMERA_PATH_FRAME:
+// standing still, a slow orbit, a fast orbit that stops, and a dolly towards the mesh
+//--------------------------------------------------------------------------------------
+static const WCHAR* g_pszMotionPaths[] = { L"still", L"slow orbit", L"fast orbit, stop", L"dolly" };
+
+static void BuildMotionPath( UINT uPath, std::vector<CAMERA_PATH_FRAME>* pPath )
+{
+    static const UINT NUM_FRAMES = 240;
+    static const float CAMERA_PITCH = XM_PI / 9.0f;
+
+    pPath->resize( NUM_FRAMES );
+    for( UINT uFrame = 0; uFrame < NUM_FRAMES; uFrame++ )
+    {
+        float fSeconds = (float)uFrame / 60.0f;
+        float fDegrees = 30.0f, fDistance = 1.0f;
+        switch( uPath )
+        {
+        case 1: fDegrees += 20.0f * fSeconds; break;
+        case 2: fDegrees += 240.0f * std::min( fSeconds, 1.5f ); break;
+        case 3: fDistance = 2.0f - 1.2f * std::min( fSeconds / 3.0f, 1.0f ); break;
+        }
+
+        float fYaw = XMConvertToRadians( fDegrees );
+        CAMERA_PATH_FRAME* pFrame = &( *pPath )[uFrame];
+        pFrame->fSeconds = fSeconds;
+        pFrame->f3Eye = XMFLOAT3( sinf( fYaw ) * cosf( CAMERA_PITCH ) * fDistance, sinf( CAMERA_PITCH ) * fDistance, -cosf( fYaw ) * cosf( CAMERA_PITCH ) * fDistance );
+        pFrame->f3LookAt = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reports the triangles the motion scale (MOTION_ADAPT) saves over the same flags without
+// it along camera paths at 1080p, with the camera motion tracked by CCameraMotion as the
+// sample does, over the whole path and over the frames the camera moves. Recovery is the most frames after the camera stops until the triangles are
+// back within 1% of those without the scale. Fails if a path standing still saves any, or
+// one doesn't recover by its end.
+// Param: a camera path recorded by the sample (R), instead of the synthetic ones
+//--------------------------------------------------------------------------------------
+HRESULT RunMotionTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT SCREEN_WIDTH = 1920, SCREEN_HEIGHT = 1080;
+    static const float MAX_FACTOR = 15.0f;
+    static const DWORD FLAGS = PNTRI | DIST_ADAPT | ORIENT_ADAPT | BF_CULL | FRUST_CULL;
+
+    std::vector< std::vector<CAMERA_PATH_FRAME> > Paths;
+    std::vector<const WCHAR*> PathNames;
+    if( 0 != pszParam[0] )
+    {
+        Paths.resize( 1 );
+        if( FAILED( LoadCameraPath( pszParam, &Paths[0] ) ) )
+        {
+            HeadlessReport( L"Can't load the camera path %s", pszParam );
+            return E_INVALIDARG;
+        }
+        PathNames.push_back( pszParam );
+    }
+    else
+    {
+        Paths.resize( ARRAYSIZE( g_pszMotionPaths ) );
+        for( UINT uPath = 0; uPath < ARRAYSIZE( g_pszMotionPaths ); uPath++ )
+        {
+            BuildMotionPath( uPath, &Paths[uPath] );
+            PathNames.push_back( g_pszMotionPaths[uPath] );
+        }
+    }
+
+    HeadlessReport( L"Flags 0x%x, max factor %.1f, %ux%u, motion from %.0f to %.0f pixels per 60Hz frame, min scale %.2f, release %.2f s",
+                    FLAGS, MAX_FACTOR, SCREEN_WIDTH, SCREEN_HEIGHT, TESS_MOTION_THRESHOLD, TESS_MOTION_FULL_VELOCITY,
+                    TESS_MOTION_MIN_SCALE, TESS_MOTION_RELEASE_SECONDS );
+    HeadlessReport( L"%-32s %-24s %7s %13s %13s %8s %8s %9s", L"Mesh", L"Path", L"Frames", L"Triangles", L"Motion", L"Saved%", L"Moving%", L"Recovery" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        float fDiagonal = GetMeshDataBoundsDiagonal( &MeshData );
+        XMVECTOR vCenter = XMVectorScale( XMVectorAdd( XMLoadFloat3( &MeshData.f3BoundsMin ), XMLoadFloat3( &MeshData.f3BoundsMax ) ), 0.5f );
+        XMMATRIX mProj = XMMatrixPerspectiveFovLH( XM_PI / 4.0f, (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.01f * fDiagonal, 10.0f * fDiagonal );
+
+        for( UINT uPath = 0; uPath < (UINT)Paths.size(); uPath++ )
+        {
+            const std::vector<CAMERA_PATH_FRAME>& Path = Paths[uPath];
+            CCameraMotion Motion;
+            UINT64 uReferenceTriangles = 0, uMotionTriangles = 0;
+            UINT64 uMovingReferenceTriangles = 0, uMovingMotionTriangles = 0;
+            UINT uStoppedFrames = 0, uRecovery = 0;
+            bool bRecovered = true;
+            std::vector<TESS_HEATMAP_PATCH> Reference, Scaled;
+            for( UINT uFrame = 0; uFrame < (UINT)Path.size(); uFrame++ )
+            {
+                const CAMERA_PATH_FRAME& Frame = Path[uFrame];
+                XMVECTOR vEye = XMVectorAdd( vCenter, XMVectorScale( XMLoadFloat3( &Frame.f3Eye ), fDiagonal ) );
+                XMVECTOR vLookAt = XMVectorAdd( vCenter, XMVectorScale( XMLoadFloat3( &Frame.f3LookAt ), fDiagonal ) );
+                XMMATRIX mView = XMMatrixLookAtLH( vEye, vLookAt, XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f ) );
+
+                TESS_FACTOR_CONSTANTS Constants;
+                InitTessFactorConstants( mView, mProj, SCREEN_WIDTH, SCREEN_HEIGHT, &Constants );
+                Constants.fEdgeTessFactors = MAX_FACTOR;
+                Constants.fMinDistance = 0.5f * fDiagonal;
+                Constants.fTessRange = 2.0f * fDiagonal;
+
+                float fElapsedSeconds = ( 0 == uFrame ) ? 0.0f : Frame.fSeconds - Path[uFrame - 1].fSeconds;
+                Motion.Update( XMMatrixMultiply( mView, mProj ), fElapsedSeconds );
+                XMStoreFloat4x4( &Constants.f4x4PrevViewProjection, Motion.GetPreviousViewProjection() );
+
+                BuildTessHeatmap( &MeshData, FLAGS, &Constants, &Reference );
+                BuildTessHeatmap( &MeshData, FLAGS | MOTION_ADAPT, &Constants, &Scaled );
+                UINT64 uFrameReference = 0, uFrameMotion = 0;
+                for( UINT uPatch = 0; uPatch < (UINT)Reference.size(); uPatch++ )
+                {
+                    uFrameReference += Reference[uPatch].uNumTriangles;
+                    uFrameMotion += Scaled[uPatch].uNumTriangles;
+                }
+                uReferenceTriangles += uFrameReference;
+                uMotionTriangles += uFrameMotion;
+
+                // Frames since the camera stopped until the triangles are back
+                bool bMoved = 0 != uFrame && ( 0 != memcmp( &Frame.f3Eye, &Path[uFrame - 1].f3Eye, sizeof( XMFLOAT3 ) ) ||
+                                               0 != memcmp( &Frame.f3LookAt, &Path[uFrame - 1].f3LookAt, sizeof( XMFLOAT3 ) ) );
+                uStoppedFrames = bMoved ? 0 : uStoppedFrames + 1;
+                if( bMoved )
+                {
+                    uMovingReferenceTriangles += uFrameReference;
+                    uMovingMotionTriangles += uFrameMotion;
+                }
+                bRecovered = (double)uFrameMotion >= 0.99 * (double)uFrameReference;
+                if( !bMoved && !bRecovered )
+                {
+                    uRecovery = std::max( uRecovery, uStoppedFrames );
+                }
+            }
+
+            double fSaved = 100.0 * ( 1.0 - (double)uMotionTriangles / std::max( (double)uReferenceTriangles, 1.0 ) );
+            double fMovingSaved = ( 0 == uMovingReferenceTriangles ) ? 0.0 : 100.0 * ( 1.0 - (double)uMovingMotionTriangles / (double)uMovingReferenceTriangles );
+            bool bStill = 0 == uRecovery && uStoppedFrames + 1 >= (UINT)Path.size();
+            if( !bRecovered || ( bStill && uMotionTriangles != uReferenceTriangles ) )
+            {
+                HeadlessReport( L"%-32s %-24s doesn't recover the triangles of the still camera", g_pszBundledMeshes[uMesh], PathNames[uPath] );
+                hr = E_FAIL;
+            }
+
+            HeadlessReport( L"%-32s %-24s %7u %13llu %13llu %7.1f%% %7.1f%% %9u", g_pszBundledMeshes[uMesh], PathNames[uPath], (UINT)Path.size(),
+                            uReferenceTriangles, uMotionTriangles, fSaved, fMovingSaved, uRecovery );
+        }
+    }
+
+    return hr;
+}
+
+
+// View sets of the multi-view tool
+enum MULTI_VIEW_SET
+{
+    MULTI_VIEW_SET_ORBIT,       // 1 to TESS_MAX_VIEWS cameras around the mesh
+    MULTI_VIEW_SET_STEREO,      // The eyes of the orbit camera
+    MULTI_VIEW_SET_CASCADES,    // 4 cascades of a directional shadow map
+    MULTI_VIEW_SET_CUBE,        // 6 faces of a point light shadow map
+};
+
+
+//--------------------------------------------------------------------------------------
+// Fills the views of a set for a mesh, returns the number of views
+//--------------------------------------------------------------------------------------
+static UINT InitMultiViewSet( const MESH_DATA* pMeshData, MULTI_VIEW_SET eSet, UINT uNumOrbitViews, float fMaxFactor,
+                              TESS_FACTOR_CONSTANTS* pViews )
+{
+    static const float CAMERA_DEGREES = 30.0f;
+    static const UINT SHADOW_MAP_SIZE = 2048;
+    static const UINT CUBE_MAP_SIZE = 1024;
+
+    float fDiagonal = GetMeshDataBoundsDiagonal( pMeshData );
+    XMVECTOR vCenter = XMVectorScale( XMVectorAdd( XMLoadFloat3( &pMeshData->f3BoundsMin ), XMLoadFloat3( &pMeshData->f3BoundsMax ) ), 0.5f );
+    XMVECTOR vUp = XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f );
+
+    switch( eSet )
+    {
+    case MULTI_VIEW_SET_ORBIT:
+        for( UINT uView = 0; uView < uNumOrbitViews; uView++ )
+        {
+            InitOrbitTessFactorConstants( pMeshData, CAMERA_DEGREES + 45.0f * (float)uView, fMaxFactor, ORBIT_SCREEN_WIDTH, ORBIT_SCREEN_HEIGHT,
+                                          &pViews[uView] );
+        }
+        return uNumOrbitViews;
+
+    case MULTI_VIEW_SET_STEREO:
+        {
+            // As the sample, each eye to half the screen
+            XMMATRIX mView, mProj, mEyeViews[2];
+            GetOrbitCamera( pMeshData, CAMERA_DEGREES, ORBIT_SCREEN_WIDTH, ORBIT_SCREEN_HEIGHT, &mView, &mProj );
+            GetStereoViews( mView, 0.05f * fDiagonal, &mEyeViews[0], &mEyeViews[1] );
+            for( UINT uView = 0; uView < 2; uView++ )
+            {
+                InitMeshViewTessFactorConstants( pMeshData, mEyeViews[uView], GetStereoProjection( mProj ), fMaxFactor, ORBIT_SCREEN_WIDTH / 2,
+                                                 ORBIT_SCREEN_HEIGHT, &pViews[uView] );
+            }
+        }
+        return 2;
+
+    case MULTI_VIEW_SET_CASCADES:
+        {
+            // Each cascade twice the size of the one before, the last covering the mesh
+            XMVECTOR vLightDirection = XMVector3Normalize( XMVectorSet( -1.0f, -2.0f, 1.0f, 0.0f ) );
+            XMMATRIX mView = XMMatrixLookAtLH( XMVectorSubtract( vCenter, XMVectorScale( vLightDirection, 2.0f * fDiagonal ) ), vCenter, vUp );
+            for( UINT uView = 0; uView < 4; uView++ )
+            {
+                float fSize = fDiagonal / (float)( 1 << ( 3 - uView ) );
+                XMMATRIX mProj = XMMatrixOrthographicLH( fSize, fSize, 0.01f * fDiagonal, 4.0f * fDiagonal );
+                InitMeshViewTessFactorConstants( pMeshData, mView, mProj, fMaxFactor, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, &pViews[uView] );
+            }
+        }
+        return 4;
+
+    case MULTI_VIEW_SET_CUBE:
+        {
+            // A point light above the mesh
+            static const float FACE_DIRECTIONS[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+            static const float FACE_UPS[6][3] = { { 0, 1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 }, { 0, 1, 0 }, { 0, 1, 0 } };
+            XMVECTOR vLight = XMVectorAdd( vCenter, XMVectorSet( 0.0f, 0.75f * fDiagonal, 0.0f, 0.0f ) );
+            XMMATRIX mProj = XMMatrixPerspectiveFovLH( XM_PIDIV2, 1.0f, 0.01f * fDiagonal, 4.0f * fDiagonal );
+            for( UINT uView = 0; uView < 6; uView++ )
+            {
+                XMVECTOR vDirection = XMVectorSet( FACE_DIRECTIONS[uView][0], FACE_DIRECTIONS[uView][1], FACE_DIRECTIONS[uView][2], 0.0f );
+                XMVECTOR vFaceUp = XMVectorSet( FACE_UPS[uView][0], FACE_UPS[uView][1], FACE_UPS[uView][2], 0.0f );
+                XMMATRIX mView = XMMatrixLookToLH( vLight, vDirection, vFaceUp );
+                InitMeshViewTessFactorConstants( pMeshData, mView, mProj, fMaxFactor, CUBE_MAP_SIZE, CUBE_MAP_SIZE, &pViews[uView] );
+            }
+        }
+        return 6;
+    }
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------
+// Compares evaluating the culling and tess factors of every patch of a mesh for several
+// views one view at a time, as drawing each view does, with evaluating all the views of a
+// patch at once sharing the control points and the edge setup, as the MULTI_VIEW hull
+// shader does. Reported for 1 to TESS_MAX_VIEWS orbit cameras, a stereo pair, shadow
+// cascades and cube faces, with the share of patches visible in any view and the views a
+// visible patch is copied to. Fails if the shared factors of a view differ from its own.
+// Param: flags, the HullShaderHash flags (default PNTRI | DIST_ADAPT | ORIENT_ADAPT |
+// BF_CULL | FRUST_CULL)
+//--------------------------------------------------------------------------------------
+HRESULT RunMultiViewTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT NUM_REPEATS = 5;
+    static const float MAX_FACTOR = 15.0f;
+    static const WCHAR* SET_NAMES[] = { L"orbit", L"stereo", L"cascades", L"cube" };
+
+    DWORD dwFlags = PNTRI | DIST_ADAPT | ORIENT_ADAPT | BF_CULL | FRUST_CULL;
+    if( 0 != pszParam[0] )
+    {
+        WCHAR* pszEnd = NULL;
+        dwFlags = (DWORD)wcstoul( pszParam, &pszEnd, 0 );
+        if( 0 != pszEnd[0] )
+        {
+            HeadlessReport( L"Expected flags, got %s", pszParam );
+            return E_INVALIDARG;
+        }
+    }
+    dwFlags = GetMultiViewTessFlags( dwFlags );
+
+    HeadlessReport( L"Flags 0x%x, max factor %.1f, best of %u runs", dwFlags, MAX_FACTOR, NUM_REPEATS );
+    HeadlessReport( L"%-32s %-9s %5s %10s %10s %8s %8s %10s %10s", L"Mesh", L"Set", L"Views", L"PerView", L"Shared", L"Speedup",
+                    L"Scaling", L"Visible%", L"Views/vis" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        UINT uNumPatches = (UINT)MeshData.Indices.size() / 3;
+        std::vector<PN_VERTEX> Corners( uNumPatches * 3 );
+        for( UINT uIndex = 0; uIndex < uNumPatches * 3; uIndex++ )
+        {
+            Corners[uIndex] = MeshData.Vertices[MeshData.Indices[uIndex]];
+        }
+
+        double fSharedOneView = 0.0;
+        for( UINT uSet = MULTI_VIEW_SET_ORBIT; uSet <= MULTI_VIEW_SET_CUBE; uSet++ )
+        {
+            UINT uFirstOrbitViews = ( MULTI_VIEW_SET_ORBIT == uSet ) ? 1 : 0;
+            UINT uLastOrbitViews = ( MULTI_VIEW_SET_ORBIT == uSet ) ? TESS_MAX_VIEWS : 0;
+            for( UINT uNumOrbitViews = uFirstOrbitViews; uNumOrbitViews <= uLastOrbitViews; uNumOrbitViews++ )
+            {
+                TESS_FACTOR_CONSTANTS Views[TESS_MAX_VIEWS];
+                UINT uNumViews = InitMultiViewSet( &MeshData, (MULTI_VIEW_SET)uSet, uNumOrbitViews, MAX_FACTOR, Views );
+
+                // One view at a time, repeating the control points per view
+                std::vector<PATCH_TESS_FACTORS> PerView( uNumPatches * uNumViews );
+                std::vector<BYTE> PerViewVisible( uNumPatches * uNumViews );
+                float fChecksum = 0.0f;
+                double fPerViewMs = DBL_MAX;
+                for( UINT uRepeat = 0; uRepeat < NUM_REPEATS; uRepeat++ )
+                {
+                    double fStart = GetTimeInMs();
+                    for( UINT uView = 0; uView < uNumViews; uView++ )
+                    {
+                        for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+                        {
+                            if( dwFlags & PNTRI )
+                            {
+                                PN_CONTROL_POINTS ControlPoints;
+                                ComputePNControlPoints( &Corners[uPatch * 3], &ControlPoints );
+                                fChecksum += ControlPoints.f3B111.x;
+                            }
+                            PerViewVisible[uView * uNumPatches + uPatch] = GetPatchTessFactors( &Corners[uPatch * 3], dwFlags, &Views[uView],
+                                                                                                &PerView[uView * uNumPatches + uPatch] ) ? 1 : 0;
+                        }
+                    }
+                    fPerViewMs = std::min( fPerViewMs, GetTimeInMs() - fStart );
+                }
+
+                // All the views of a patch at once
+                std::vector<MULTI_VIEW_PATCH> Shared( uNumPatches );
+                double fSharedMs = DBL_MAX;
+                for( UINT uRepeat = 0; uRepeat < NUM_REPEATS; uRepeat++ )
+                {
+                    double fStart = GetTimeInMs();
+                    for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+                    {
+                        EvaluateMultiViewPatch( &Corners[uPatch * 3], dwFlags, Views, uNumViews, &Shared[uPatch] );
+                        fChecksum += Shared[uPatch].ControlPoints.f3B111.x;
+                    }
+                    fSharedMs = std::min( fSharedMs, GetTimeInMs() - fStart );
+                }
+                if( 1 == uNumViews && MULTI_VIEW_SET_ORBIT == uSet )
+                {
+                    fSharedOneView = fSharedMs;
+                }
+
+                UINT uNumMismatches = 0, uNumVisible = 0;
+                UINT64 uNumPatchViews = 0;
+                for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+                {
+                    const MULTI_VIEW_PATCH* pPatch = &Shared[uPatch];
+                    for( UINT uView = 0; uView < uNumViews; uView++ )
+                    {
+                        bool bVisible = 0 != ( pPatch->uViewMask & ( 1 << uView ) );
+                        const PATCH_TESS_FACTORS& Factors = PerView[uView * uNumPatches + uPatch];
+                        if( bVisible != ( 0 != PerViewVisible[uView * uNumPatches + uPatch] ) ||
+                            0 != memcmp( &Factors, &pPatch->ViewFactors[uView], sizeof( Factors ) ) )
+                        {
+                            uNumMismatches++;
+                        }
+                        uNumPatchViews += bVisible ? 1 : 0;
+                    }
+                    uNumVisible += ( 0 != pPatch->uViewMask ) ? 1 : 0;
+                }
+                if( uNumMismatches > 0 )
+                {
+                    HeadlessReport( L"%-32s %-9s %u views: %u patch views differ from evaluating the view alone (checksum %g)",
+                                    g_pszBundledMeshes[uMesh], SET_NAMES[uSet], uNumViews, uNumMismatches, fChecksum );
+                    hr = E_FAIL;
+                }
+
+                HeadlessReport( L"%-32s %-9s %5u %8.2fms %8.2fms %7.2fx %7.2fx %9.1f%% %10.2f", g_pszBundledMeshes[uMesh], SET_NAMES[uSet], uNumViews,
+                                fPerViewMs, fSharedMs, fPerViewMs / std::max( fSharedMs, 1e-6 ), fSharedMs / std::max( fSharedOneView, 1e-6 ),
+                                100.0 * (double)uNumVisible / (double)std::max( uNumPatches, 1U ),
+                                (double)uNumPatchViews / (double)std::max( uNumVisible, 1U ) );
+            }
+        }
+    }
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+// Floats HS_PNTrianglesConstant outputs per patch with a HullShaderHash permutation: the
+// factors, and the control points of PN triangles
+//--------------------------------------------------------------------------------------
+static UINT GetPatchConstantFloats( DWORD dwFlags )
+{
+    UINT uNumFloats = 4;
+    if( dwFlags & PNTRI )
+    {
+        uNumFloats += ( dwFlags & PACKED_CP ) ? 14 : ( ( dwFlags & DEPTH_ONLY ) ? 21 : 30 );
+    }
+
+    return uNumFloats;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Floats DS_PNTriangles outputs per domain point with a HullShaderHash permutation
+//--------------------------------------------------------------------------------------
+static UINT GetDomainOutputFloats( DWORD dwFlags )
+{
+    return ( dwFlags & DEPTH_ONLY ) ? 4 : 10;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Evaluates the domain points of a patch as DS_PNTriangles does with the dwFlags
+// permutation, writing GetDomainOutputFloats floats per point
+//--------------------------------------------------------------------------------------
+static void EvaluatePassDomainPoints( const PN_VERTEX* pCorners, const PN_CONTROL_POINTS* pControlPoints, DWORD dwFlags,
+                                      const TRI_TESSELLATION* pTessellation, CXMMATRIX mViewProjection, FXMVECTOR vToLight,
+                                      float* pOutputs )
+{
+    bool bDepthOnly = 0 != ( dwFlags & DEPTH_ONLY );
+    UINT uStride = GetDomainOutputFloats( dwFlags );
+
+    for( UINT uPoint = 0; uPoint < (UINT)pTessellation->DomainPoints.size(); uPoint++ )
+    {
+        const XMFLOAT3& f3Domain = pTessellation->DomainPoints[uPoint];
+        XMFLOAT3 f3Position, f3Normal;
+        XMFLOAT3* pNormal = bDepthOnly ? NULL : &f3Normal;
+        if( dwFlags & PNTRI )
+        {
+            EvaluatePNTriangle( pCorners, pControlPoints, f3Domain.x, f3Domain.y, f3Domain.z, &f3Position, pNormal );
+        }
+        else
+        {
+            EvaluatePhongTriangle( pCorners, f3Domain.x, f3Domain.y, f3Domain.z, &f3Position, pNormal );
+        }
+
+        float* pOutput = &pOutputs[uPoint * uStride];
+        XMStoreFloat4( (XMFLOAT4*)pOutput, XMVector4Transform( XMVectorSetW( XMLoadFloat3( &f3Position ), 1.0f ), mViewProjection ) );
+        if( bDepthOnly )
+        {
+            continue;
+        }
+
+        // The texcoords, and the diffuse colour of the sample's material and light
+        pOutput[4] = pCorners[0].f2TexCoord.x * f3Domain.z + pCorners[1].f2TexCoord.x * f3Domain.x + pCorners[2].f2TexCoord.x * f3Domain.y;
+        pOutput[5] = pCorners[0].f2TexCoord.y * f3Domain.z + pCorners[1].f2TexCoord.y * f3Domain.x + pCorners[2].f2TexCoord.y * f3Domain.y;
+        float fDiffuse = std::max( XMVectorGetX( XMVector3Dot( XMLoadFloat3( &f3Normal ), vToLight ) ), 0.0f ) + 0.2f;
+        pOutput[6] = fDiffuse;
+        pOutput[7] = fDiffuse;
+        pOutput[8] = fDiffuse;
+        pOutput[9] = 1.0f;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Compares the passes of TessPolicy.h on the bundled meshes seen by an orbit camera, with a
+// directional light fitted to the mesh for the shadow pass: the patches each pass draws,
+// the domain points they are tessellated to and the time of a CPU reference of
+// DS_PNTriangles over them, with the floats the hull and domain shaders output. The
+// depth and shadow passes use the position only DEPTH_ONLY permutation, and the shadow
+// pass evaluates the factors from the light (InitShadowTessFactorConstants) with its own
+// cap. Fails if the depth pass factors differ from the colour pass ones, as the colour pass
+// then can't test against the pre-pass depths, or if a shadow factor exceeds the cap.
+// Param: flags, the HullShaderHash flags (default PNTRI | DIST_ADAPT | ORIENT_ADAPT |
+// BF_CULL | FRUST_CULL)
+//--------------------------------------------------------------------------------------
+HRESULT RunTessPassTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT NUM_REPEATS = 3;
+    static const float MAX_FACTOR = 15.0f;
+    static const float CAMERA_DEGREES = 30.0f;
+    static const UINT SHADOW_MAP_SIZE = 2048;
+    static const WCHAR* PASS_NAMES[TESS_PASS_MAX] = { L"color", L"depth", L"shadow" };
+
+    DWORD dwFlags = PNTRI | DIST_ADAPT | ORIENT_ADAPT | BF_CULL | FRUST_CULL;
+    if( 0 != pszParam[0] )
+    {
+        WCHAR* pszEnd = NULL;
+        dwFlags = (DWORD)wcstoul( pszParam, &pszEnd, 0 );
+        if( 0 != pszEnd[0] || 0 == ( dwFlags & ( PNTRI | PHONG ) ) )
+        {
+            HeadlessReport( L"Expected flags with PNTRI or PHONG, got %s", pszParam );
+            return E_INVALIDARG;
+        }
+    }
+    dwFlags &= ~( MULTI_VIEW | DEPTH_ONLY );
+
+    HeadlessReport( L"Flags 0x%x, max factor %.1f, shadow map %u, best of %u runs", dwFlags, MAX_FACTOR, SHADOW_MAP_SIZE, NUM_REPEATS );
+    HeadlessReport( L"%-32s %-6s %6s %8s %8s %10s %9s %8s %9s %10s %10s", L"Mesh", L"Pass", L"Flags", L"Patches", L"Factor",
+                    L"Points", L"DS", L"HS/patch", L"DS/point", L"Output", L"vs color" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        UINT uNumPatches = (UINT)MeshData.Indices.size() / 3;
+        std::vector<PN_VERTEX> Corners( uNumPatches * 3 );
+        std::vector<PN_CONTROL_POINTS> ControlPoints( uNumPatches );
+        for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+        {
+            for( UINT uCorner = 0; uCorner < 3; uCorner++ )
+            {
+                Corners[uPatch * 3 + uCorner] = MeshData.Vertices[MeshData.Indices[uPatch * 3 + uCorner]];
+            }
+            ComputePNControlPoints( &Corners[uPatch * 3], &ControlPoints[uPatch] );
+        }
+
+        // The camera, and a directional light looking at the center of the mesh with its
+        // shadow map covering the bounds
+        float fDiagonal = GetMeshDataBoundsDiagonal( &MeshData );
+        XMVECTOR vCenter = XMVectorScale( XMVectorAdd( XMLoadFloat3( &MeshData.f3BoundsMin ), XMLoadFloat3( &MeshData.f3BoundsMax ) ), 0.5f );
+        XMVECTOR vLightDirection = XMVector3Normalize( XMVectorSet( -1.0f, -2.0f, 1.0f, 0.0f ) );
+        XMMATRIX mLightView = XMMatrixLookAtLH( XMVectorSubtract( vCenter, XMVectorScale( vLightDirection, 2.0f * fDiagonal ) ), vCenter,
+                                                XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f ) );
+        XMMATRIX mLightProj = XMMatrixOrthographicLH( fDiagonal, fDiagonal, 0.01f * fDiagonal, 4.0f * fDiagonal );
+
+        TESS_FACTOR_CONSTANTS CameraConstants;
+        InitOrbitTessFactorConstants( &MeshData, CAMERA_DEGREES, MAX_FACTOR, ORBIT_SCREEN_WIDTH, ORBIT_SCREEN_HEIGHT, &CameraConstants );
+
+        std::vector<PATCH_TESS_FACTORS> ColorFactors( uNumPatches );
+        std::vector<BYTE> ColorVisible( uNumPatches );
+        double fColorMs = 0.0;
+        UINT64 uColorOutputFloats = 0;
+        for( UINT uPass = TESS_PASS_COLOR; uPass < TESS_PASS_MAX; uPass++ )
+        {
+            TESS_PASS ePass = (TESS_PASS)uPass;
+            DWORD dwPassFlags = GetTessPassFlags( ePass, dwFlags );
+            TESS_FACTOR_CONSTANTS Constants = CameraConstants;
+            if( GetTessPassPolicy( ePass )->bLightView )
+            {
+                InitShadowTessFactorConstants( &CameraConstants, mLightView, mLightProj, SHADOW_MAP_SIZE, &Constants );
+            }
+            Constants.fEdgeTessFactors = GetTessPassFactor( ePass, CameraConstants.fEdgeTessFactors );
+
+            // The factors and tessellation of every patch the pass draws
+            std::vector<UINT> Drawn;
+            std::vector<TRI_TESSELLATION> Tessellations( uNumPatches );
+            UINT uNumMismatches = 0, uNumOverCap = 0, uMaxPoints = 0;
+            UINT64 uNumPoints = 0;
+            float fFactorSum = 0.0f;
+            for( UINT uPatch = 0; uPatch < uNumPatches; uPatch++ )
+            {
+                PATCH_TESS_FACTORS Factors;
+                bool bVisible = GetPatchTessFactors( &Corners[uPatch * 3], dwPassFlags, &Constants, &Factors );
+                if( TESS_PASS_COLOR == ePass )
+                {
+                    ColorFactors[uPatch] = Factors;
+                    ColorVisible[uPatch] = bVisible ? 1 : 0;
+                }
+                else if( TESS_PASS_DEPTH == ePass &&
+                         ( bVisible != ( 0 != ColorVisible[uPatch] ) || 0 != memcmp( &Factors, &ColorFactors[uPatch], sizeof( Factors ) ) ) )
+                {
+                    uNumMismatches++;
+                }
+                if( !bVisible )
+                {
+                    continue;
+                }
+
+                for( UINT uEdge = 0; uEdge < 3; uEdge++ )
+                {
+                    uNumOverCap += ( Factors.fEdge[uEdge] > Constants.fEdgeTessFactors ) ? 1 : 0;
+                }
+                TessellateTri( Factors.fEdge, Factors.fInside, &Tessellations[uPatch] );
+                Drawn.push_back( uPatch );
+                uNumPoints += Tessellations[uPatch].DomainPoints.size();
+                uMaxPoints = std::max( uMaxPoints, (UINT)Tessellations[uPatch].DomainPoints.size() );
+                fFactorSum += Factors.fInside;
+            }
+
+            // The domain shader over the drawn patches
+            XMMATRIX mViewProjection = XMLoadFloat4x4( &Constants.f4x4ViewProjection );
+            UINT uStride = GetDomainOutputFloats( dwPassFlags );
+            std::vector<float> Outputs( std::max( uMaxPoints, 1U ) * uStride );
+            float fChecksum = 0.0f;
+            double fPassMs = DBL_MAX;
+            for( UINT uRepeat = 0; uRepeat < NUM_REPEATS; uRepeat++ )
+            {
+                double fStart = GetTimeInMs();
+                for( UINT uDrawn = 0; uDrawn < (UINT)Drawn.size(); uDrawn++ )
+                {
+                    UINT uPatch = Drawn[uDrawn];
+                    EvaluatePassDomainPoints( &Corners[uPatch * 3], &ControlPoints[uPatch], dwPassFlags, &Tessellations[uPatch], mViewProjection,
+                                              XMVectorNegate( vLightDirection ), &Outputs[0] );
+                    fChecksum += Outputs[0];
+                }
+                fPassMs = std::min( fPassMs, GetTimeInMs() - fStart );
+            }
+
+            UINT64 uOutputFloats = uNumPoints * uStride + (UINT64)Drawn.size() * GetPatchConstantFloats( dwPassFlags );
+            if( TESS_PASS_COLOR == ePass )
+            {
+                fColorMs = fPassMs;
+                uColorOutputFloats = uOutputFloats;
+            }
+
+            if( uNumMismatches > 0 )
+            {
+                HeadlessReport( L"%-32s %-6s %u patches differ from the colour pass (checksum %g)", g_pszBundledMeshes[uMesh], PASS_NAMES[uPass],
+                                uNumMismatches, fChecksum );
+                hr = E_FAIL;
+            }
+            if( uNumOverCap > 0 )
+            {
+                HeadlessReport( L"%-32s %-6s %u edge factors exceed the cap of %.1f", g_pszBundledMeshes[uMesh], PASS_NAMES[uPass], uNumOverCap,
+                                Constants.fEdgeTessFactors );
+                hr = E_FAIL;
+            }
+
+            HeadlessReport( L"%-32s %-6s %6x %8u %8.2f %10llu %7.2fms %8u %9u %8.1fMB %6.1f%%/%.1f%%", g_pszBundledMeshes[uMesh], PASS_NAMES[uPass],
+                            dwPassFlags, (UINT)Drawn.size(), fFactorSum / (float)std::max( (UINT)Drawn.size(), 1U ), uNumPoints, fPassMs,
+                            GetPatchConstantFloats( dwPassFlags ), uStride, (double)uOutputFloats * sizeof( float ) / ( 1024.0 * 1024.0 ),
+                            100.0 * fPassMs / std::max( fColorMs, 1e-6 ), 100.0 * (double)uOutputFloats / (double)std::max( uColorOutputFloats, (UINT64)1 ) );
+        }
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Checks GetProjectedSphereDiameter against the projection of the silhouette of spheres on
+// the view axis, then drives CTessPathSelector with a camera dollying away from a grid of
+// copies of each bundled mesh and back, jittering along the way, with and without
+// hysteresis. Reported are the instances per frame on each path, the share of patches
+// that skip the HS and DS, and the path switches. Fails if the diameter is off, or if an
+// instance switches more than out and back with hysteresis.
+// Param: the min diameter in pixels (default TESS_PATH_MIN_DIAMETER)
+//--------------------------------------------------------------------------------------
+HRESULT RunTessPathTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT GRID_SIZE = 8;
+    static const UINT NUM_FRAMES = 480;
+    static const float MAX_DISTANCE = 40.0f;    // In diagonals
+    static const float JITTER = 0.03f;          // Of the distance
+    static const float MAX_DIAMETER_ERROR = 1e-3f;
+
+    TESS_PATH_SETTINGS Settings;
+    Settings.fMinDiameter = ( 0 != pszParam[0] ) ? (float)_wtof( pszParam ) : TESS_PATH_MIN_DIAMETER;
+    Settings.fHysteresis = TESS_PATH_HYSTERESIS;
+    if( !( Settings.fMinDiameter > 0.0f ) )
+    {
+        HeadlessReport( L"Expected a diameter in pixels, got %s", pszParam );
+        return E_INVALIDARG;
+    }
+
+    // The diameter of spheres centered on the view axis, from their tangent points
+    XMMATRIX mProj = XMMatrixPerspectiveFovLH( XM_PI / 4.0f, (float)ORBIT_SCREEN_WIDTH / (float)ORBIT_SCREEN_HEIGHT, 0.01f, 1000.0f );
+    float fMaxDiameterError = 0.0f;
+    for( UINT uDistance = 2; uDistance <= 64; uDistance *= 2 )
+    {
+        float fDistance = (float)uDistance;
+        float fAngle = asinf( 1.0f / fDistance );
+        XMVECTOR vTop = XMVector3TransformCoord( XMVectorSet( 0.0f, fDistance * sinf( fAngle ) * cosf( fAngle ), fDistance * cosf( fAngle ) * cosf( fAngle ), 1.0f ), mProj );
+        float fExpected = XMVectorGetY( vTop ) * (float)ORBIT_SCREEN_HEIGHT;
+        float fDiameter = GetProjectedSphereDiameter( XMVectorSet( 0.0f, 0.0f, fDistance, 1.0f ), 1.0f, XMMatrixIdentity(), mProj,
+                                                      (float)ORBIT_SCREEN_HEIGHT );
+        fMaxDiameterError = std::max( fMaxDiameterError, fabsf( fDiameter - fExpected ) / fExpected );
+    }
+    HeadlessReport( L"Projected diameter max relative error %.2e", fMaxDiameterError );
+    if( fMaxDiameterError > MAX_DIAMETER_ERROR )
+    {
+        hr = E_FAIL;
+    }
+
+    HeadlessReport( L"Min diameter %.1f pixels, %ux%u instances, %u frames", Settings.fMinDiameter, GRID_SIZE, GRID_SIZE, NUM_FRAMES );
+    HeadlessReport( L"%-32s %-10s %8s %8s %8s %10s %9s %11s", L"Mesh", L"Hysteresis", L"Tess", L"Plain", L"MinTess", L"NoHSDS%",
+                    L"Switches", L"MaxPerInst" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        // The copies of the mesh on a grid in the xz plane
+        float fDiagonal = GetMeshDataBoundsDiagonal( &MeshData );
+        XMVECTOR vBoxCenter = XMVectorScale( XMVectorAdd( XMLoadFloat3( &MeshData.f3BoundsMin ), XMLoadFloat3( &MeshData.f3BoundsMax ) ), 0.5f );
+        XMVECTOR vBoxExtents = XMVectorScale( XMVectorSubtract( XMLoadFloat3( &MeshData.f3BoundsMax ), XMLoadFloat3( &MeshData.f3BoundsMin ) ), 0.5f );
+        std::vector<XMVECTOR> Centers( GRID_SIZE * GRID_SIZE );
+        float fRadius = 0.0f;
+        for( UINT uInstance = 0; uInstance < GRID_SIZE * GRID_SIZE; uInstance++ )
+        {
+            XMMATRIX mWorld = XMMatrixTranslation( 1.5f * fDiagonal * (float)( uInstance % GRID_SIZE ), 0.0f,
+                                                   1.5f * fDiagonal * (float)( uInstance / GRID_SIZE ) );
+            GetWorldBoundingSphere( vBoxCenter, vBoxExtents, mWorld, &Centers[uInstance], &fRadius );
+        }
+        XMVECTOR vGridCenter = XMVectorAdd( vBoxCenter, XMVectorSet( 0.75f * fDiagonal * (float)( GRID_SIZE - 1 ), 0.0f,
+                                                                     0.75f * fDiagonal * (float)( GRID_SIZE - 1 ), 0.0f ) );
+
+        for( UINT uHysteresis = 0; uHysteresis < 2; uHysteresis++ )
+        {
+            TESS_PATH_SETTINGS RunSettings = Settings;
+            RunSettings.fHysteresis = ( 0 != uHysteresis ) ? Settings.fHysteresis : 1.0f;
+            CTessPathSelector Selector;
+            Selector.Init( &RunSettings );
+            Selector.Reset( GRID_SIZE * GRID_SIZE );
+
+            std::vector<UINT> InstanceSwitches( GRID_SIZE * GRID_SIZE, 0 );
+            UINT64 uNumTessellated = 0, uNumPlain = 0;
+            UINT uMinTessellated = UINT_MAX;
+            for( UINT uFrame = 0; uFrame < NUM_FRAMES; uFrame++ )
+            {
+                // Out to MAX_DISTANCE diagonals from the grid center and back
+                float fT = (float)uFrame / (float)( NUM_FRAMES - 1 );
+                float fDolly = 1.0f - fabsf( 2.0f * fT - 1.0f );
+                float fDistance = fDiagonal * ( 2.0f + ( MAX_DISTANCE - 2.0f ) * fDolly ) * ( 1.0f + JITTER * sinf( 1.7f * (float)uFrame ) );
+                XMVECTOR vEye = XMVectorAdd( vGridCenter, XMVectorScale( XMVector3Normalize( XMVectorSet( -1.0f, 0.5f, -1.0f, 0.0f ) ), fDistance ) );
+                XMMATRIX mView = XMMatrixLookAtLH( vEye, vGridCenter, XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f ) );
+
+                Selector.BeginFrame();
+                for( UINT uInstance = 0; uInstance < GRID_SIZE * GRID_SIZE; uInstance++ )
+                {
+                    bool bWasTessellated = Selector.IsTessellated( uInstance );
+                    bool bTessellated = Selector.Select( uInstance, GetProjectedSphereDiameter( Centers[uInstance], fRadius, mView, mProj,
+                                                                                                (float)ORBIT_SCREEN_HEIGHT ) );
+                    InstanceSwitches[uInstance] += ( 0 != uFrame && bWasTessellated != bTessellated ) ? 1 : 0;
+                }
+
+                const TESS_PATH_STATS* pStats = Selector.GetFrameStats();
+                uNumTessellated += pStats->uNumTessellated;
+                uNumPlain += pStats->uNumPlain;
+                uMinTessellated = std::min( uMinTessellated, pStats->uNumTessellated );
+            }
+
+            UINT uMaxInstanceSwitches = *std::max_element( InstanceSwitches.begin(), InstanceSwitches.end() );
+            if( 0 != uHysteresis && uMaxInstanceSwitches > 2 )
+            {
+                HeadlessReport( L"%-32s an instance switched %u times with hysteresis", g_pszBundledMeshes[uMesh], uMaxInstanceSwitches );
+                hr = E_FAIL;
+            }
+
+            HeadlessReport( L"%-32s %-10.2f %8.1f %8.1f %8u %9.1f%% %9u %11u", g_pszBundledMeshes[uMesh], RunSettings.fHysteresis,
+                            (double)uNumTessellated / NUM_FRAMES, (double)uNumPlain / NUM_FRAMES, uMinTessellated,
+                            100.0 * (double)uNumPlain / (double)( uNumTessellated + uNumPlain ),
+                            Selector.GetNumSwitches(), uMaxInstanceSwitches );
+        }
+    }
+
+    return hr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// A silhouette segment of the silhouette clipping tool, ordered by its coordinates
+//--------------------------------------------------------------------------------------
+struct SILHOUETTE_SEGMENT
+{
+    float   fCoords[6];
+
+    bool operator<( const SILHOUETTE_SEGMENT& Other ) const
+    {
+        return std::lexicographical_compare( fCoords, fCoords + 6, Other.fCoords, Other.fCoords + 6 );
+    }
+
+    bool operator==( const SILHOUETTE_SEGMENT& Other ) const
+    {
+        return std::equal( fCoords, fCoords + 6, Other.fCoords );
+    }
+};
+
+
+//--------------------------------------------------------------------------------------
+// Returns the silhouette segments sorted by their coordinates
+//--------------------------------------------------------------------------------------
+static void SortSilhouetteSegments( const std::vector<XMFLOAT3>& Segments, std::vector<SILHOUETTE_SEGMENT>* pSorted )
+{
+    pSorted->resize( Segments.size() / 2 );
+    for( UINT i = 0; i < (UINT)pSorted->size(); i++ )
+    {
+        memcpy( ( *pSorted )[i].fCoords, &Segments[i * 2], 6 * sizeof( float ) );
+    }
+    std::sort( pSorted->begin(), pSorted->end() );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Returns how many segment ends do not start another segment. The silhouette of a closed
+// mesh is closed loops, so only the boundary and non-manifold edges leave ends open.
+//--------------------------------------------------------------------------------------
+static UINT GetNumOpenSilhouetteEnds( const std::vector<XMFLOAT3>& Segments )
+{
+    std::vector<SILHOUETTE_SEGMENT> Starts( Segments.size() / 2 ), Ends( Segments.size() / 2 );
+    for( UINT i = 0; i < (UINT)Starts.size(); i++ )
+    {
+        ZeroMemory( &Starts[i], sizeof( Starts[i] ) );
+        ZeroMemory( &Ends[i], sizeof( Ends[i] ) );
+        memcpy( Starts[i].fCoords, &Segments[i * 2], sizeof( XMFLOAT3 ) );
+        memcpy( Ends[i].fCoords, &Segments[i * 2 + 1], sizeof( XMFLOAT3 ) );
+    }
+    std::sort( Starts.begin(), Starts.end() );
+    std::sort( Ends.begin(), Ends.end() );
+
+    std::vector<SILHOUETTE_SEGMENT> Open;
+    std::set_difference( Ends.begin(), Ends.end(), Starts.begin(), Starts.end(), std::back_inserter( Open ) );
+    return (UINT)Open.size();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Bakes the detailed mesh of silhouette clipping from each bundled mesh, builds its edge
+// hierarchy and measures the silhouette extraction from the orbit views against testing
+// every edge. Reports the bake and build times, the bulge the coarse mesh is pushed out
+// by, and per view on average the silhouette edges, the nodes visited and edges tested,
+// the extraction time and the speedup. Both must find the same silhouette.
+// Param: the tess factor of the detailed mesh (default SILHOUETTE_TESS_FACTOR)
+//--------------------------------------------------------------------------------------
+HRESULT RunSilhouetteClipTool( const WCHAR* pszParam )
+{
+    HRESULT hr = S_OK;
+
+    static const UINT NUM_VIEWS = 24;
+    static const UINT NUM_REPEATS = 8;
+
+    float fTessFactor = ( 0 != pszParam[0] ) ? (float)_wtof( pszParam ) : SILHOUETTE_TESS_FACTOR;
+    if( !( fTessFactor >= 1.0f ) )
+    {
+        HeadlessReport( L"Expected a tess factor of at least 1, got %s", pszParam );
+        return E_INVALIDARG;
+    }
+
+    HeadlessReport( L"PN-Triangles detailed mesh at tess factor %.1f, %u orbit views, leaves of %u edges", fTessFactor, NUM_VIEWS,
+                    SILHOUETTE_LEAF_EDGES );
+    HeadlessReport( L"%-32s %9s %8s %8s %8s %8s %9s %8s %8s %8s %8s %9s %9s %8s %6s", L"Mesh", L"Edges", L"Boundary", L"NonMan",
+                    L"Nodes", L"Bake ms", L"Build ms", L"Bulge%", L"SilEdges", L"Visited", L"Tested", L"Tree ms", L"All ms",
+                    L"Speedup", L"Open" );
+
+    for( UINT uMesh = 0; uMesh < ARRAYSIZE( g_pszBundledMeshes ); uMesh++ )
+    {
+        MESH_DATA MeshData;
+        if( FAILED( LoadBundledMesh( uMesh, &MeshData ) ) )
+        {
+            hr = E_FAIL;
+            continue;
+        }
+
+        MESH_DATA Detailed;
+        MESH_BAKE_STATS BakeStats;
+        double fStart = GetTimeInMs();
+        HRESULT hrBake = BakeTessellatedMeshData( &MeshData, CPU_TESS_PN_TRIANGLES, fTessFactor, &Detailed, &BakeStats );
+        double fBakeMs = GetTimeInMs() - fStart;
+
+        CSilhouetteEdgeTree Tree;
+        fStart = GetTimeInMs();
+        HRESULT hrBuild = SUCCEEDED( hrBake ) ? Tree.Build( &Detailed ) : hrBake;
+        double fBuildMs = GetTimeInMs() - fStart;
+        if( FAILED( hrBuild ) )
+        {
+            HeadlessReport( L"%-32s failed to bake or build the edge hierarchy", g_pszBundledMeshes[uMesh] );
+            hr = E_FAIL;
+            continue;
+        }
+
+        float fBulge = GetMaxPatchBulge( &MeshData, CPU_TESS_PN_TRIANGLES, fTessFactor );
+
+        std::vector<XMFLOAT3> Segments, AllSegments;
+        std::vector<SILHOUETTE_SEGMENT> Sorted, AllSorted;
+        UINT64 uNumSilhouetteEdges = 0, uNumNodesVisited = 0, uNumEdgesTested = 0, uNumOpenEnds = 0;
+        double fTreeMs = 0.0, fAllMs = 0.0;
+        bool bMatched = true;
+        for( UINT uView = 0; uView < NUM_VIEWS; uView++ )
+        {
+            XMMATRIX mView, mProj;
+            GetOrbitCamera( &MeshData, 360.0f * (float)uView / (float)NUM_VIEWS, ORBIT_SCREEN_WIDTH, ORBIT_SCREEN_HEIGHT, &mView, &mProj );
+            XMVECTOR vEye = XMMatrixInverse( NULL, mView ).r[3];
+
+            SILHOUETTE_STATS Stats;
+            fStart = GetTimeInMs();
+            for( UINT uRepeat = 0; uRepeat < NUM_REPEATS; uRepeat++ )
+            {
+                Segments.clear();
+                Tree.Extract( vEye, &Segments, &Stats );
+            }
+            fTreeMs += ( GetTimeInMs() - fStart ) / NUM_REPEATS;
+
+            SILHOUETTE_STATS AllStats;
+            fStart = GetTimeInMs();
+            for( UINT uRepeat = 0; uRepeat < NUM_REPEATS; uRepeat++ )
+            {
+                AllSegments.clear();
+                Tree.ExtractAll( vEye, &AllSegments, &AllStats );
+            }
+            fAllMs += ( GetTimeInMs() - fStart ) / NUM_REPEATS;
+
+            SortSilhouetteSegments( Segments, &Sorted );
+            SortSilhouetteSegments( AllSegments, &AllSorted );
+            bMatched = bMatched && ( Sorted == AllSorted );
+
+            uNumSilhouetteEdges += Stats.uNumSilhouetteEdges;
+            uNumNodesVisited += Stats.uNumNodesVisited;
+            uNumEdgesTested += Stats.uNumEdgesTested;
+            uNumOpenEnds += GetNumOpenSilhouetteEnds( Segments );
+        }
+
+        if( !bMatched )
+        {
+            HeadlessReport( L"%-32s the hierarchy missed or added silhouette edges", g_pszBundledMeshes[uMesh] );
+            hr = E_FAIL;
+        }
+
+        HeadlessReport( L"%-32s %9u %8u %8u %8u %8.1f %9.1f %8.3f %8.1f %8.1f %8.1f %9.3f %9.3f %8.2f %6.1f", g_pszBundledMeshes[uMesh],
+                        Tree.GetNumEdges(), Tree.GetNumBoundaryEdges(), Tree.GetNumNonManifoldEdges(), Tree.GetNumNodes(), fBakeMs,
+                        fBuildMs, 100.0f * fBulge / GetMeshDataBoundsDiagonal( &MeshData ), (double)uNumSilhouetteEdges / NUM_VIEWS,
+                        (double)uNumNodesVisited / NUM_VIEWS, (double)uNumEdgesTested / NUM_VIEWS, fTreeMs / NUM_VIEWS,
+                        fAllMs / NUM_VIEWS, fAllMs / std::max( fTreeMs, 1e-6 ), (double)uNumOpenEnds / NUM_VIEWS );
+    }
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+// EOF
+//--------------------------------------------------------------------------------------